@@ -0,0 +1,310 @@
+/*
+ *  FOTOMATON. Detector de rostros de la plataforma SWAD
+ *
+ *  Copyright (C) 2018  Daniel J. Calandria Hernández,
+ *                      Antonio Cañas Vargas &
+ *			Jesús Mesa González.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Mide la velocidad de los filtros de realce y comprueba que dan el mismo
+// resultado que los filtros originales, que calculaban cada pixel por separado.
+//
+// bench_filters <n> <input_file>...
+//    Aplica <n> veces cada filtro a la imagen de cada fichero,
+//    reducida al tamaño de las caras extraídas (150x200).
+
+#include "filters.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+using namespace std;
+using namespace cv;
+
+static void enhance_contrast_ref (IplImage *img,  float t);
+static void enhance_saturation_ref (IplImage *img, float t);
+static void enhance_light_ref (IplImage *img, int r, int c, float f);
+static void stretch_contrast_ref (IplImage *m, int channel, int *h, int max, int f);
+static void contraer_ref (IplImage *mat, int channel, int orig, int dest, int f);
+
+static void contrast (IplImage *img)          { enhance_contrast (img, 0.0009); }
+static void contrast_ref (IplImage *img)      { enhance_contrast_ref (img, 0.0009); }
+static void saturation (IplImage *img)        { enhance_saturation (img, 0.0001); }
+static void saturation_ref (IplImage *img)    { enhance_saturation_ref (img, 0.0001); }
+static void light (IplImage *img)             { enhance_light (img, int(0.07*img->height), int(0.1*img->width), 20.0); }
+static void light_ref (IplImage *img)         { enhance_light_ref (img, int(0.07*img->height), int(0.1*img->width), 20.0); }
+
+struct Filter
+{
+  const char *name;
+  void (*filter) (IplImage *img);
+  void (*filter_ref) (IplImage *img);
+};
+
+static const Filter filters[] =
+{
+  {"contrast",   contrast,   contrast_ref},
+  {"saturation", saturation, saturation_ref},
+  {"light",      light,      light_ref},
+};
+
+// Segundos empleados en aplicar n veces el filtro a copias de src.
+static double time_filter (void (*filter) (IplImage *img), IplImage *src, IplImage *work, int n)
+{
+  int64 ticks = 0;
+
+  for (int i = 0; i < n; i++)
+  {
+    cvCopy (src, work);
+    int64 start = getTickCount ();
+    filter (work);
+    ticks += getTickCount () - start;
+  }
+  return ticks / getTickFrequency ();
+}
+
+static bool equal_images (const IplImage *a, const IplImage *b)
+{
+  for (int i = 0; i < a->height; i++)
+    if (memcmp (a->imageData + i * a->widthStep,
+                b->imageData + i * b->widthStep, a->width * a->nChannels))
+      return false;
+  return true;
+}
+
+int main (int argc, char **argv)
+{
+  int n;
+  bool ok = true;
+
+  if (argc < 3 || (n = atoi (argv[1])) <= 0)
+  {
+    cout << "bench_filters <n> <input_file>..." << endl;
+    return 2;
+  }
+
+  IplImage *src  = cvCreateImage (cvSize(150, 200), 8, 3);
+  IplImage *work = cvCreateImage (cvSize(150, 200), 8, 3);
+  IplImage *ref  = cvCreateImage (cvSize(150, 200), 8, 3);
+
+  for (int f = 2; f < argc; f++)
+  {
+    IplImage *img = cvLoadImage (argv[f]);
+    if (!img)
+    {
+      cerr << "Error: Image cannot be read: " << argv[f] << endl;
+      ok = false;
+      continue;
+    }
+    cvResize (img, src);
+    cvReleaseImage (&img);
+
+    for (unsigned i = 0; i < sizeof (filters) / sizeof (filters[0]); i++)
+    {
+      // Comprobar que el resultado es el mismo.
+      cvCopy (src, work);
+      filters[i].filter (work);
+      cvCopy (src, ref);
+      filters[i].filter_ref (ref);
+      bool same = equal_images (work, ref);
+      if (!same)
+        ok = false;
+
+      // Medir.
+      double seconds_ref = time_filter (filters[i].filter_ref, src, ref, n);
+      double seconds     = time_filter (filters[i].filter,     src, work, n);
+      printf ("%s\t%-10s\tper pixel: %8.1f us\tLUT: %8.1f us\tx%.1f\t%s\n",
+              argv[f], filters[i].name,
+              1e6 * seconds_ref / n, 1e6 * seconds / n, seconds_ref / seconds,
+              same ? "identical" : "DIFFERENT");
+    }
+  }
+
+  cvReleaseImage (&ref);
+  cvReleaseImage (&work);
+  cvReleaseImage (&src);
+
+  return ok ? 0 : 1;
+}
+
+/*************************************************************/
+/* FILTROS ORIGINALES, PIXEL A PIXEL                         */
+/*************************************************************/
+
+//Mejora de contraste.
+
+static void enhance_contrast_ref (IplImage *img,  float t)
+{
+  int *hist[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    hist[i] = new int[256];
+    memset (hist[i], 0, sizeof(int)*256);
+  }
+  int count = 0;
+  
+  //Calcular histogramas
+  for (int i = 0; i < img->height; ++i)
+    for (int j = 0; j < img->width; ++j)      
+      for (int k = 0; k < 3; ++k)
+      {
+        ++hist[k][((uchar*) (img->imageData + i * img->widthStep))[j * img->nChannels + k]];
+      }
+     
+  count = img->height * img->width;
+
+  //Estirar el contraste teniendo en cuenta los pixels de piel.  
+  for (int i = 0; i < 3; ++i)
+    stretch_contrast_ref (img, i, hist[i], int(t * count), 255 );
+
+  for (int i = 0; i < 3; ++i)
+    delete[] hist[i];
+}
+// Mejora de saturacion.
+static void enhance_saturation_ref (IplImage *img, float t)
+{
+  cvCvtColor(img,img, CV_RGB2HSV);
+  
+  int hist[256];
+  int count = 0;
+
+  memset (hist, 0, sizeof(hist));
+    
+  // Calcular histogramas.
+  for (int i = 0; i < img->height; ++i)
+    for (int j = 0; j < img->width; ++j)      
+      {     
+        ++hist[((uchar*) (img->imageData + i*img->widthStep))[j * img->nChannels + 2]];
+        ++count;
+      }                           
+
+  count = img->height *img->width;
+  
+  // Estirar el contraste teniendo en cuenta los pixels de piel  
+  stretch_contrast_ref (img, 2, hist, int(t * count), 255 );
+
+  cvCvtColor(img,img, CV_HSV2RGB);
+}
+
+// Realce de blancos.
+static void enhance_light_ref (IplImage *img, int r, int c, float f)
+{
+  int avg[3] = {0,0,0};
+  int nuevo_valor, savg, total = 0;
+
+  // Obtener el color medio de la imagen, tomando las esquinas como referencia
+    
+  // Esquina izquierda.
+  for (int i = 0; i <= r; ++i)  
+    for (int j = c - (c * i) / r; j >= 0; --j)      
+      { 
+        ++total;
+        for (int n = 0; n < 3; ++n)           
+          avg[n] += ((uchar*)(img->imageData + i * img->widthStep))[j * img->nChannels + n];
+      }         
+  // Esquina derecha.
+  for (int i = 0; i <= r; ++i)
+    for (int j = (c * i) / r; j <= c; ++j)      
+      {
+        ++total;
+        for (int n = 0; n < 3; ++n)
+          avg[n] += ((uchar*)(img->imageData + i * img->widthStep))[img->width -1 - c + j];          
+      }
+  
+  for (int i = 0; i < 3; ++i)
+    avg[i] /= total;
+      
+  // Obtener el nuevo valor de blanco.
+  savg = (avg[0] + avg[1] + avg[2])/3;
+  nuevo_valor = int(savg + (255 - savg) / f);
+  
+  //Desplazar hacia el nuevo blanco
+  for (int i = 0; i < 3; ++i)
+    contraer_ref (img, i, avg[i], nuevo_valor, 255);
+}
+
+// Estira el histograma h asociado a m.
+static void stretch_contrast_ref (IplImage *m, int channel, int *h, int max, int f)
+{
+  int /*max = int(t * m.rows() * m.cols()),*/ sum = 0; 
+  int inf = 0, sup = 0, w;
+
+ // Limite inferior.
+ for (unsigned i = 0; i < 256; ++i)
+  {
+    sum += h[i];
+    
+    if (sum > max)
+    {     inf = i;      break;    }
+  }
+
+  // Limite superior.
+  sum = 0;
+  for (int i = 256-1; i >= 0; --i)
+  {
+    sum += h[i];
+    
+    if (sum > max)
+    {     sup = i;      break;    }
+  }  
+  
+  
+  // Estirar histograma entre [inf,sup].
+  w = sup - inf;
+  
+  //cout << "inf = " << inf << ", sup = " << sup << ", w = " << w << endl;
+  
+  for (int i = 0; i < m->height; ++i)
+    for (int j = 0; j < m->width; ++j)
+    {
+      if (((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] < inf)
+        ((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel]  = 0; 
+      else if (((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] > sup)
+        ((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] = f;
+      else ((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] = int(rint( (((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] - inf) * f /  w));
+    }
+}
+
+/*
+* Reimplementación de la rutina contraer del proyecto de Alvarez y Rodrigo.
+*/
+static void contraer_ref (IplImage *mat, int channel, int orig, int dest, int f)
+{
+  float k = dest / float(orig);
+  
+  if (f > orig)
+  {
+    for (int i = 0; i < mat->height; ++i)
+      for (int j = 0; j < mat->width; ++j)
+      {
+        float val;
+        
+        if (((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] < orig)
+          val = ((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel]  * k;
+        else
+          val = ((((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] - orig) * (f - dest) / float(f - orig)) + dest;
+        
+        // Se comprueba que este dentro del rango [0,f]
+        if (val < 0)
+          ((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] = 0;
+        else if (val > f)
+          ((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] = f;
+        else
+          ((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] = int(rint(val));
+      }   
+  }
+  
+}
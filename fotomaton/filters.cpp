@@ -0,0 +1,279 @@
+/*
+ *  FOTOMATON. Detector de rostros de la plataforma SWAD
+ *
+ *  Copyright (C) 2018  Daniel J. Calandria Hernández,
+ *                      Antonio Cañas Vargas &
+ *			Jesús Mesa González.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filters.h"
+#include <cstring>
+#include <cmath>
+
+using namespace cv;
+
+/*
+ * Los filtros recorren la imagen por filas, como un cv::Mat que comparte
+ * los datos del IplImage. Cada filtro calcula primero una tabla (LUT) de
+ * 256 valores por canal y la aplica después en una sola pasada con cv::LUT,
+ * que usa instrucciones SIMD. El resultado es idéntico, bit a bit, al de
+ * los filtros que calculaban cada pixel por separado.
+ */
+
+static void histogram (const Mat &m, int channel, int *h);
+static void histogram_3 (const Mat &m, int h[3][256]);
+static void stretch_contrast (const int *h, int max, int f, uchar *lut, int step);
+static void contraer (int orig, int dest, int f, uchar *lut, int step);
+static void identity (uchar *lut, int step);
+
+
+/*************************************************************/
+/* FILTROS DE REALCE                                         */
+/*************************************************************/
+
+//Mejora de contraste.
+
+void enhance_contrast (IplImage *img,  float t)
+{
+  Mat m = cvarrToMat (img);
+  Mat lut (1, 256, CV_8UC3);
+  int hist[3][256];
+  int count;
+
+  //Calcular histogramas
+  histogram_3 (m, hist);
+
+  count = img->height * img->width;
+
+  //Estirar el contraste teniendo en cuenta los pixels de piel.
+  for (int i = 0; i < 3; ++i)
+    stretch_contrast (hist[i], int(t * count), 255, lut.ptr() + i, 3);
+  LUT (m, lut, m);
+}
+
+// Mejora de saturacion.
+void enhance_saturation (IplImage *img, float t)
+{
+  Mat m = cvarrToMat (img);
+  Mat lut (1, 256, CV_8UC3);
+  int hist[256];
+  int count;
+
+  cvtColor (m, m, CV_RGB2HSV);
+
+  // Calcular histogramas.
+  histogram (m, 2, hist);
+
+  count = img->height *img->width;
+
+  // Estirar el contraste teniendo en cuenta los pixels de piel
+  identity (lut.ptr(), 3);
+  identity (lut.ptr() + 1, 3);
+  stretch_contrast (hist, int(t * count), 255, lut.ptr() + 2, 3);
+  LUT (m, lut, m);
+
+  cvtColor (m, m, CV_HSV2RGB);
+}
+
+// Realce de blancos.
+void enhance_light (IplImage *img, int r, int c, float f)
+{
+  Mat m = cvarrToMat (img);
+  Mat lut (1, 256, CV_8UC3);
+  int avg[3] = {0,0,0};
+  int nuevo_valor, savg, total = 0;
+
+  // Obtener el color medio de la imagen, tomando las esquinas como referencia
+
+  // Esquina izquierda.
+  for (int i = 0; i <= r; ++i)
+  {
+    const uchar *row = m.ptr(i);
+    for (int j = c - (c * i) / r; j >= 0; --j)
+      {
+        ++total;
+        for (int n = 0; n < 3; ++n)
+          avg[n] += row[j * 3 + n];
+      }
+  }
+  // Esquina derecha.
+  // Se suma el mismo byte a los tres canales, como se ha hecho siempre,
+  // para que el blanco obtenido no cambie.
+  for (int i = 0; i <= r; ++i)
+  {
+    const uchar *row = m.ptr(i);
+    for (int j = (c * i) / r; j <= c; ++j)
+      {
+        ++total;
+        for (int n = 0; n < 3; ++n)
+          avg[n] += row[m.cols - 1 - c + j];
+      }
+  }
+
+  for (int i = 0; i < 3; ++i)
+    avg[i] /= total;
+
+  // Obtener el nuevo valor de blanco.
+  savg = (avg[0] + avg[1] + avg[2])/3;
+  nuevo_valor = int(savg + (255 - savg) / f);
+
+  //Desplazar hacia el nuevo blanco
+  for (int i = 0; i < 3; ++i)
+    contraer (avg[i], nuevo_valor, 255, lut.ptr() + i, 3);
+  LUT (m, lut, m);
+}
+
+/*************************************************************/
+/* HISTOGRAMAS Y TABLAS                                      */
+/*************************************************************/
+
+// Histograma de un canal de una imagen de 3 canales.
+// Se usan dos histogramas, para pixels pares e impares, para que los
+// incrementos consecutivos no dependan unos de otros.
+static void histogram (const Mat &m, int channel, int *h)
+{
+  int h2[2][256];
+
+  memset (h2, 0, sizeof(h2));
+  for (int i = 0; i < m.rows; ++i)
+  {
+    const uchar *p = m.ptr(i) + channel;
+    int j = 0;
+
+    for (; j + 1 < m.cols; j += 2, p += 6)
+    {
+      ++h2[0][p[0]];
+      ++h2[1][p[3]];
+    }
+    if (j < m.cols)
+      ++h2[0][p[0]];
+  }
+  for (int v = 0; v < 256; ++v)
+    h[v] = h2[0][v] + h2[1][v];
+}
+
+// Histogramas de los tres canales de una imagen, en una sola pasada.
+static void histogram_3 (const Mat &m, int h[3][256])
+{
+  int h2[2][3][256];
+
+  memset (h2, 0, sizeof(h2));
+  for (int i = 0; i < m.rows; ++i)
+  {
+    const uchar *p = m.ptr(i);
+    int j = 0;
+
+    for (; j + 1 < m.cols; j += 2, p += 6)
+    {
+      ++h2[0][0][p[0]];
+      ++h2[0][1][p[1]];
+      ++h2[0][2][p[2]];
+      ++h2[1][0][p[3]];
+      ++h2[1][1][p[4]];
+      ++h2[1][2][p[5]];
+    }
+    if (j < m.cols)
+    {
+      ++h2[0][0][p[0]];
+      ++h2[0][1][p[1]];
+      ++h2[0][2][p[2]];
+    }
+  }
+  for (int k = 0; k < 3; ++k)
+    for (int v = 0; v < 256; ++v)
+      h[k][v] = h2[0][k][v] + h2[1][k][v];
+}
+
+// Tabla que estira el histograma h.
+// lut[v * step] es el nuevo valor de v.
+static void stretch_contrast (const int *h, int max, int f, uchar *lut, int step)
+{
+  int sum = 0;
+  int inf = 0, sup = 0, w;
+
+ // Limite inferior.
+ for (unsigned i = 0; i < 256; ++i)
+  {
+    sum += h[i];
+
+    if (sum > max)
+    {     inf = i;      break;    }
+  }
+
+  // Limite superior.
+  sum = 0;
+  for (int i = 256-1; i >= 0; --i)
+  {
+    sum += h[i];
+
+    if (sum > max)
+    {     sup = i;      break;    }
+  }
+
+  // Estirar histograma entre [inf,sup].
+  // Si inf == sup (canal casi constante) no se puede estirar y se deja a 0.
+  w = sup - inf;
+
+  for (int v = 0; v < 256; ++v)
+  {
+    if (v < inf)
+      lut[v * step] = 0;
+    else if (v > sup)
+      lut[v * step] = f;
+    else
+      lut[v * step] = w ? int(rint( (v - inf) * f /  w)) : 0;
+  }
+}
+
+/*
+* Reimplementación de la rutina contraer del proyecto de Alvarez y Rodrigo.
+* lut[v * step] es el nuevo valor de v.
+*/
+static void contraer (int orig, int dest, int f, uchar *lut, int step)
+{
+  float k = dest / float(orig);
+
+  for (int v = 0; v < 256; ++v)
+  {
+    float val;
+
+    if (f <= orig)
+    {
+      lut[v * step] = v;
+      continue;
+    }
+
+    if (v < orig)
+      val = v * k;
+    else
+      val = ((v - orig) * (f - dest) / float(f - orig)) + dest;
+
+    // Se comprueba que este dentro del rango [0,f]
+    if (val < 0)
+      lut[v * step] = 0;
+    else if (val > f)
+      lut[v * step] = f;
+    else
+      lut[v * step] = int(rint(val));
+  }
+}
+
+// Tabla que no cambia los valores.
+static void identity (uchar *lut, int step)
+{
+  for (int v = 0; v < 256; ++v)
+    lut[v * step] = v;
+}
@@ -0,0 +1,33 @@
+/*
+ *  FOTOMATON. Detector de rostros de la plataforma SWAD
+ *
+ *  Copyright (C) 2018  Daniel J. Calandria Hernández,
+ *                      Antonio Cañas Vargas &
+ *			Jesús Mesa González.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef filters_h
+#define filters_h
+
+// Filtros de realce de las caras detectadas
+
+#include "common.h"
+
+void enhance_contrast (IplImage *img,  float t);
+void enhance_saturation (IplImage *img, float t);
+void enhance_light (IplImage *img, int r, int c, float f);
+
+#endif
@@ -20,9 +20,18 @@
 */
 
 #include "util.h"
+#include "filters.h"
 #include <iostream>
 #include <vector>
 #include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 
 using namespace std;
 using namespace cv;
@@ -32,67 +41,156 @@ bool operator < ( const pair<REAL, Rect> &a, const pair<REAL, Rect> &b )
   return a.first < b.first;
 }
 
+// Cara detectada. Es una línea del mapa de la imagen.
+struct Face
+{
+  int x, y, radius;  // Círculo en la imagen del mapa
+  int res;           // 1 si el fondo es blanco (cara válida), 0 si no
+  string name;       // Nombre de los ficheros de la cara, sin ruta ni extensión
+};
+
+// Códigos devueltos al procesar una imagen.
+#define FOTOMATON_FACES     0   // Se han detectado caras
+#define FOTOMATON_NO_FACES  1   // No se han detectado caras
+#define FOTOMATON_ERROR     2   // Error
 
 ///////////////////////////////////////////////////////////
 
-void stretch_contrast (IplImage *m, int channel, int *h, int max, int f);
-void enhance_contrast (IplImage *img,  float t);
-void enhance_saturation (IplImage *img, float t);
-void enhance_light (IplImage *img, int r, int c, float f);
-void contraer (IplImage *mat, int channel, int orig, int dest, int f);
+int process_photo (CascadeClassifier &cascade, const char *input_file, int width,
+                   vector<Face> &faces);
+void write_faces (FILE *f, const vector<Face> &faces);
+int serve (CascadeClassifier &cascade, const char *socket_path, int width);
+int benchmark (const char *program, CascadeClassifier &cascade, const char *classifier,
+               const char *input_file, int width, int n);
+double now ();
+
 bool check_background (IplImage *img, int r, int c, int t);
 void ExtractObjectImage ( IplImage *src, const Rect &r, float ratio, IplImage *dst );
 
 ///////////////////////////////////////////////////////////
 
+/*
+ * Modos de uso:
+ *
+ * fotomaton <classifier> <input_file> <width>
+ *    Procesa una imagen y termina. Escribe <input_file>_map.txt
+ *    con las caras detectadas.
+ *
+ * fotomaton -s <socket> <classifier> <width>
+ *    Servicio residente. Carga el clasificador una sola vez y atiende
+ *    peticiones por un socket Unix. Cada petición es una línea con la ruta
+ *    de la imagen. La respuesta es una línea con el código devuelto
+ *    seguida de las líneas del mapa, como en <input_file>_map.txt.
+ *
+ * fotomaton -b <n> <classifier> <input_file> <width>
+ *    Mide imágenes por segundo procesando <n> veces la misma imagen,
+ *    lanzando un proceso por imagen y con el clasificador ya cargado.
+ */
+
 int main (int argc, char **argv)
 {
+  const char *program = argv[0];
+  const char *socket_path = NULL;
+  int n_benchmark = 0;
+  int opt;
 
-  char file_name[512];
-  
-  if (argc < 4)
+  while ((opt = getopt (argc, argv, "s:b:")) != -1)
+    switch (opt)
+    {
+      case 's':
+        socket_path = optarg;
+        break;
+      case 'b':
+        n_benchmark = atoi (optarg);
+        break;
+      default:
+        return FOTOMATON_ERROR;
+    }
+  argc -= optind;
+  argv += optind;
+
+  if (argc < (socket_path ? 2 : 3))
   {
-     cout << "fotomaton <classifier> <input_file> <width>" << endl;
-     return 2;      
+     cout << "fotomaton <classifier> <input_file> <width>" << endl
+          << "fotomaton -s <socket> <classifier> <width>" << endl
+          << "fotomaton -b <n> <classifier> <input_file> <width>" << endl;
+     return FOTOMATON_ERROR;
   }
-  
+
   // Obtener la anchura de la imagen.
-  int width = atoi ( argv[3] );
-  
+  int width = atoi ( argv[socket_path ? 1 : 2] );
+
   if ( width <= 0)
   {
     cout << "Error: Width must be positive!" << endl;
-    return 2;
+    return FOTOMATON_ERROR;
   }
- 
+
   // Cargar el clasificador en cascada proporcionado como argumento.
   CascadeClassifier cascade;
-  string ruta_classifier(argv[1]); // Convertir en string la ruta donde se encuentra el clasificador.
+  string ruta_classifier(argv[0]); // Convertir en string la ruta donde se encuentra el clasificador.
 
   if (!cascade.load (ruta_classifier)){
 
     cout << "Error: Classifier not found!" << endl;
-    return 2;
+    return FOTOMATON_ERROR;
   }
-      
+
+  // Servicio residente.
+  if (socket_path)
+    return serve (cascade, socket_path, width);
+
+  // Medir velocidad.
+  if (n_benchmark > 0)
+    return benchmark (program, cascade, argv[0], argv[1], width, n_benchmark);
+
+  // Procesar una imagen y escribir el mapa en un fichero de texto.
+  vector<Face> faces;
+  int res = process_photo (cascade, argv[1], width, faces);
+  if (res == FOTOMATON_FACES)
+  {
+    string base (argv[1]);
+    size_t dot = base.rfind ('.');
+    if (dot != string::npos)
+      base.erase (dot);
+    FILE *map_file = fopen ((base + "_map.txt").c_str (), "w");
+    if (!map_file)
+      return FOTOMATON_ERROR;
+    write_faces (map_file, faces);
+    fclose (map_file);
+  }
+
+  return res;
+}
+
+// Detecta las caras de una imagen y genera el mapa de la imagen (_map.jpg)
+// y los pasos de la mejora de cada cara (_NNN_paso1.jpg ... _NNN_paso3.jpg).
+// Devuelve FOTOMATON_FACES, FOTOMATON_NO_FACES o FOTOMATON_ERROR.
+
+int process_photo (CascadeClassifier &cascade, const char *input_file, int width,
+                   vector<Face> &faces)
+{
+  char file_name[512];
+
+  faces.clear ();
+
   // Cargar imagen.
-  IplImage *img = cvLoadImage(argv[2]);
+  IplImage *img = cvLoadImage(input_file);
   if (!img)
   {
-    cout << "Error: Image cannot be read!" << endl;
-    return 2;
+    cerr << "Error: Image cannot be read!" << endl;
+    return FOTOMATON_ERROR;
   }
-  
+
   string str_name;
-  PartPath ( argv[2], 0, &str_name, 0 );
-        
-  for (int i = strlen(argv[2])-1; i>= 0; i--)
-    if (argv[2][i] == '.') 
-    {
-      argv[2][i] = '\0';
-      break;
-    }
-  
+  PartPath ( input_file, 0, &str_name, 0 );
+
+  // Ruta de la imagen sin extensión.
+  string base (input_file);
+  size_t dot = base.rfind ('.');
+  if (dot != string::npos)
+    base.erase (dot);
+
   // Detectar objetos.
 
   Mat gray_img; // Crear una matriz donde almacenar en escala de grises la imagen leída.
@@ -106,81 +204,201 @@ int main (int argc, char **argv)
   // sin enmascarar.
   if (objects.empty())
   {
-    IplImage *img_map = cvCreateImage (cvSize(width, (width*img->height)/img->width), 8, 3);  
+    IplImage *img_map = cvCreateImage (cvSize(width, (width*img->height)/img->width), 8, 3);
     cvResize (img, img_map);
-    sprintf (file_name, "%s_map.jpg", argv[2]);    
-    cvSaveImage (file_name, img_map);    
-    return 1;
+    sprintf (file_name, "%s_map.jpg", base.c_str());
+    cvSaveImage (file_name, img_map);
+    cvReleaseImage (&img_map);
+    cvReleaseImage (&img);
+    return FOTOMATON_NO_FACES;
   }
 
-  // Enmascarar la imagen y generar mapa.    
+  // Enmascarar la imagen y generar mapa.
   if(img->width < width)
-    width = img->width;  
+    width = img->width;
 
   IplImage *img_map = cvCreateImage (cvSize(width, (width*img->height)/img->width), 8, 3);
   cvResize (img, img_map);
   CvMat *mask = cvCreateMat (img_map->height, img_map->width, CV_8UC1);
   cvSet (mask, cvRealScalar(1));
-  
-  sprintf (file_name, "%s_map.txt", argv[2]);
-  ofstream map_file ( file_name );
-  
-  
+
   // Extaer cada una de las imágenes y aplicar los diferentes filtros.
-  IplImage *img_object = cvCreateImage ( cvSize(150, 200), 8, 3 );       
+  IplImage *img_object = cvCreateImage ( cvSize(150, 200), 8, 3 );
   for (int i = objects.size()-1; i >= 0; i--)
   {
     int res = 1; // fondo blanco?
-    
+
     Rect r;
     r.x = (objects[i].x * width) / img->width;
     r.y = (objects[i].y * width) / img->width;
     r.width = (objects[i].width  * width) / img->width;
-    r.height = (objects[i].height * width) / img->width;                        
-    cvCircle ( mask, cvPoint(r.x + r.width/2, r.y + r.height/2), r.width*0.75+1, CV_RGB(0,0,0), -1, CV_AA );    
+    r.height = (objects[i].height * width) / img->width;
+    cvCircle ( mask, cvPoint(r.x + r.width/2, r.y + r.height/2), r.width*0.75+1, CV_RGB(0,0,0), -1, CV_AA );
 
     // Extraer y mejorar imagen.
-    ////////////////////////////////////////////////////////        
-    ExtractObjectImage ( img, objects[i], 0.75, img_object );    
-    sprintf (file_name, "%s_%03d_paso1.jpg", argv[2], i);
-    cvSaveImage (file_name, img_object);    
-       
+    ////////////////////////////////////////////////////////
+    ExtractObjectImage ( img, objects[i], 0.75, img_object );
+    sprintf (file_name, "%s_%03d_paso1.jpg", base.c_str(), i);
+    cvSaveImage (file_name, img_object);
+
     enhance_contrast (img_object,  0.0009);
     enhance_saturation ( img_object, 0.0001);
-    
+
     if (!check_background( img_object, int(0.07*img_object->height), int(0.1*img_object->width), 150 ) )
-    { 
-      cvCircle ( img_map, cvPoint(r.x + r.width/2, r.y + r.height/2), r.width*0.75+1, CV_RGB(255,0,0), 2, CV_AA );    
-      res = 0; 
+    {
+      cvCircle ( img_map, cvPoint(r.x + r.width/2, r.y + r.height/2), r.width*0.75+1, CV_RGB(255,0,0), 2, CV_AA );
+      res = 0;
     }
     else
     {
-      cvCircle ( img_map, cvPoint(r.x + r.width/2, r.y + r.height/2), r.width*0.75+1, CV_RGB(0,255,0), 2, CV_AA );    
-      sprintf (file_name, "%s_%03d_paso2.jpg", argv[2], i);
-      cvSaveImage (file_name, img_object);    
+      cvCircle ( img_map, cvPoint(r.x + r.width/2, r.y + r.height/2), r.width*0.75+1, CV_RGB(0,255,0), 2, CV_AA );
+      sprintf (file_name, "%s_%03d_paso2.jpg", base.c_str(), i);
+      cvSaveImage (file_name, img_object);
       enhance_light (img_object, int(0.07*img_object->height),
                     int(0.1*img_object->width), 20.0);
-      sprintf (file_name, "%s_%03d_paso3.jpg", argv[2], i);
+      sprintf (file_name, "%s_%03d_paso3.jpg", base.c_str(), i);
       cvSaveImage (file_name, img_object);
-    }  
+    }
     ////////////////////////////////////////////////////////
 
-    sprintf (file_name, "%s_%03d", str_name.c_str(), i);                
-    map_file << int(r.x + r.width/2) << " " << int(r.y + r.height/2) << " " << int(r.width*0.75+1) << " " << res << " " << file_name << '\n';
-  }  
-  map_file.close();       
+    Face face;
+    face.x = int(r.x + r.width/2);
+    face.y = int(r.y + r.height/2);
+    face.radius = int(r.width*0.75+1);
+    face.res = res;
+    sprintf (file_name, "%s_%03d", str_name.c_str(), i);
+    face.name = file_name;
+    faces.push_back (face);
+  }
   cvSubS ( img_map, cvScalar(80,120,120,0), img_map, mask );
-  sprintf (file_name, "%s_map.jpg", argv[2]);
+  sprintf (file_name, "%s_map.jpg", base.c_str());
   cvSaveImage (file_name, img_map);
-  
-  
-  cvReleaseImage (&img_map);  
-  cvReleaseImage (&img_object);  
-  cvReleaseImage (&img);  
-  
-  return 0;  
+
+
+  cvReleaseMat (&mask);
+  cvReleaseImage (&img_map);
+  cvReleaseImage (&img_object);
+  cvReleaseImage (&img);
+
+  return FOTOMATON_FACES;
 }
 
+// Escribe las caras con el formato del mapa de la imagen.
+
+void write_faces (FILE *f, const vector<Face> &faces)
+{
+  for (unsigned i = 0; i < faces.size(); i++)
+    fprintf (f, "%d %d %d %d %s\n",
+             faces[i].x, faces[i].y, faces[i].radius, faces[i].res, faces[i].name.c_str());
+}
+
+// Servicio residente: atiende peticiones de SWAD por un socket Unix,
+// de una en una, con el clasificador cargado una sola vez.
+
+int serve (CascadeClassifier &cascade, const char *socket_path, int width)
+{
+  struct sockaddr_un addr;
+  struct timeval timeout = {10, 0};  // Tiempo máximo de espera de la petición
+  char input_file[4096];
+  vector<Face> faces;
+  int fd_listen, fd;
+
+  if (strlen (socket_path) >= sizeof (addr.sun_path))
+  {
+    cerr << "Error: Socket path too long!" << endl;
+    return FOTOMATON_ERROR;
+  }
+
+  // Si un cliente cierra la conexión, no terminar.
+  signal (SIGPIPE, SIG_IGN);
+
+  // Crear el socket.
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, socket_path);
+  unlink (socket_path);
+  if ((fd_listen = socket (AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+      bind (fd_listen, (struct sockaddr *) &addr, sizeof (addr)) < 0 ||
+      chmod (socket_path, 0660) < 0 ||
+      listen (fd_listen, 16) < 0)
+  {
+    perror ("fotomaton");
+    return FOTOMATON_ERROR;
+  }
+
+  for (;;)
+  {
+    if ((fd = accept (fd_listen, NULL, NULL)) < 0)
+      continue;
+    setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+
+    // Un flujo para leer la petición y otro para escribir la respuesta.
+    FILE *f_in = fdopen (fd, "r");
+    FILE *f_out = f_in ? fdopen (dup (fd), "w") : NULL;
+    if (!f_out)
+    {
+      if (f_in)
+        fclose (f_in);
+      else
+        close (fd);
+      continue;
+    }
+
+    // Leer la ruta de la imagen y responder con el código y las caras.
+    if (fgets (input_file, sizeof (input_file), f_in))
+    {
+      input_file[strcspn (input_file, "\r\n")] = '\0';
+      int res = process_photo (cascade, input_file, width, faces);
+      fprintf (f_out, "%d\n", res);
+      if (res == FOTOMATON_FACES)
+        write_faces (f_out, faces);
+    }
+    fclose (f_out);
+    fclose (f_in);
+  }
+
+  return FOTOMATON_ERROR;  // No se llega aquí
+}
+
+// Compara la velocidad de un proceso por imagen con la del servicio residente.
+
+int benchmark (const char *program, CascadeClassifier &cascade, const char *classifier,
+               const char *input_file, int width, int n)
+{
+  char command[8192];
+  vector<Face> faces;
+  double start, seconds;
+
+  // Un proceso por imagen, cargando el clasificador cada vez.
+  snprintf (command, sizeof (command), "'%s' '%s' '%s' %d > /dev/null",
+            program, classifier, input_file, width);
+  start = now ();
+  for (int i = 0; i < n; i++)
+    if (WEXITSTATUS (system (command)) == FOTOMATON_ERROR)
+      return FOTOMATON_ERROR;
+  seconds = now () - start;
+  printf ("One process per image:\t%d images in %.3f s\t%.2f images/s\n",
+          n, seconds, n / seconds);
+
+  // Clasificador ya cargado, como en el servicio residente.
+  start = now ();
+  for (int i = 0; i < n; i++)
+    if (process_photo (cascade, input_file, width, faces) == FOTOMATON_ERROR)
+      return FOTOMATON_ERROR;
+  seconds = now () - start;
+  printf ("Resident service:\t%d images in %.3f s\t%.2f images/s\n",
+          n, seconds, n / seconds);
+
+  return 0;
+}
+
+double now ()
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
 
 void ExtractObjectImage ( IplImage *src, const Rect &r, float ratio, IplImage *dst )
 {
@@ -233,172 +451,6 @@ void ExtractObjectImage ( IplImage *src, const Rect &r, float ratio, IplImage *d
 
 
 
-/*************************************************************/
-/* FILTROS DE REALCE                                         */
-/*************************************************************/
-
-//Mejora de contraste.
-
-void enhance_contrast (IplImage *img,  float t)
-{
-  int *hist[3];
-  for (int i = 0; i < 3; ++i)
-  {
-    hist[i] = new int[256];
-    memset (hist[i], 0, sizeof(int)*256);
-  }
-  int count = 0;
-  
-  //Calcular histogramas
-  for (int i = 0; i < img->height; ++i)
-    for (int j = 0; j < img->width; ++j)      
-      for (int k = 0; k < 3; ++k)
-      {
-        ++hist[k][((uchar*) (img->imageData + i * img->widthStep))[j * img->nChannels + k]];
-      }
-     
-  count = img->height * img->width;
-
-  //Estirar el contraste teniendo en cuenta los pixels de piel.  
-  for (int i = 0; i < 3; ++i)
-    stretch_contrast (img, i, hist[i], int(t * count), 255 );
-    
-}
-// Mejora de saturacion.
-void enhance_saturation (IplImage *img, float t)
-{
-  cvCvtColor(img,img, CV_RGB2HSV);
-  
-  int hist[256];
-  int count = 0;
-    
-  // Calcular histogramas.
-  for (int i = 0; i < img->height; ++i)
-    for (int j = 0; j < img->width; ++j)      
-      {     
-        ++hist[((uchar*) (img->imageData + i*img->widthStep))[j * img->nChannels + 2]];
-        ++count;
-      }                           
-
-  count = img->height *img->width;
-  
-  // Estirar el contraste teniendo en cuenta los pixels de piel  
-  stretch_contrast (img, 2, hist, int(t * count), 255 );
-
-  cvCvtColor(img,img, CV_HSV2RGB);
-}
-
-// Realce de blancos.
-void enhance_light (IplImage *img, int r, int c, float f)
-{
-  int avg[3] = {0,0,0};
-  int nuevo_valor, savg, total = 0;
-
-  // Obtener el color medio de la imagen, tomando las esquinas como referencia
-    
-  // Esquina izquierda.
-  for (int i = 0; i <= r; ++i)  
-    for (int j = c - (c * i) / r; j >= 0; --j)      
-      { 
-        ++total;
-        for (int n = 0; n < 3; ++n)           
-          avg[n] += ((uchar*)(img->imageData + i * img->widthStep))[j * img->nChannels + n];
-      }         
-  // Esquina derecha.
-  for (int i = 0; i <= r; ++i)
-    for (int j = (c * i) / r; j <= c; ++j)      
-      {
-        ++total;
-        for (int n = 0; n < 3; ++n)
-          avg[n] += ((uchar*)(img->imageData + i * img->widthStep))[img->width -1 - c + j];          
-      }
-  
-  for (int i = 0; i < 3; ++i)
-    avg[i] /= total;
-      
-  // Obtener el nuevo valor de blanco.
-  savg = (avg[0] + avg[1] + avg[2])/3;
-  nuevo_valor = int(savg + (255 - savg) / f);
-  
-  //Desplazar hacia el nuevo blanco
-  for (int i = 0; i < 3; ++i)
-    contraer (img, i, avg[i], nuevo_valor, 255);
-}
-
-// Estira el histograma h asociado a m.
-void stretch_contrast (IplImage *m, int channel, int *h, int max, int f)
-{
-  int /*max = int(t * m.rows() * m.cols()),*/ sum = 0; 
-  int inf = 0, sup = 0, w;
-
- // Limite inferior.
- for (unsigned i = 0; i < 256; ++i)
-  {
-    sum += h[i];
-    
-    if (sum > max)
-    {     inf = i;      break;    }
-  }
-
-  // Limite superior.
-  sum = 0;
-  for (int i = 256-1; i >= 0; --i)
-  {
-    sum += h[i];
-    
-    if (sum > max)
-    {     sup = i;      break;    }
-  }  
-  
-  
-  // Estirar histograma entre [inf,sup].
-  w = sup - inf;
-  
-  //cout << "inf = " << inf << ", sup = " << sup << ", w = " << w << endl;
-  
-  for (int i = 0; i < m->height; ++i)
-    for (int j = 0; j < m->width; ++j)
-    {
-      if (((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] < inf)
-        ((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel]  = 0; 
-      else if (((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] > sup)
-        ((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] = f;
-      else ((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] = int(rint( (((uchar*) (m->imageData + i * m->widthStep))[j * m->nChannels +  channel] - inf) * f /  w));
-    }
-}
-
-/*
-* Reimplementación de la rutina contraer del proyecto de Alvarez y Rodrigo.
-*/
-void contraer (IplImage *mat, int channel, int orig, int dest, int f)
-{
-  float k = dest / float(orig);
-  
-  if (f > orig)
-  {
-    for (int i = 0; i < mat->height; ++i)
-      for (int j = 0; j < mat->width; ++j)
-      {
-        float val;
-        
-        if (((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] < orig)
-          val = ((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel]  * k;
-        else
-          val = ((((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] - orig) * (f - dest) / float(f - orig)) + dest;
-        
-        // Se comprueba que este dentro del rango [0,f]
-        if (val < 0)
-          ((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] = 0;
-        else if (val > f)
-          ((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] = f;
-        else
-          ((uchar*) (mat->imageData + i * mat->widthStep))[j * mat->nChannels +  channel] = int(rint(val));
-      }   
-  }
-  
-}
-
-
 bool check_background (IplImage *img, int r, int c, int t)
 {
   // Comprueba los dos triangulos de las esquinas superiores.
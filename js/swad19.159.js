@@ -553,7 +553,18 @@ function readConnUsrsData () {
 
 //  This function must be called from time to time
 var objXMLHttpReqMchStd = false;
+var timerMatchStd = null;
+var pendingMatchStd = false;
 function refreshMatchStd () {
+	if (timerMatchStd) {
+		clearTimeout(timerMatchStd);
+		timerMatchStd = null;
+	}
+	if (objXMLHttpReqMchStd && objXMLHttpReqMchStd.readyState != 4) {	// A refresh is in progress
+		pendingMatchStd = true;		// Refresh again when it ends
+		return;
+	}
+
 	objXMLHttpReqMchStd = AJAXCreateObject();
 	if (objXMLHttpReqMchStd) {
 		var RefreshParams = RefreshParamNxtActMch + '&' +
@@ -575,12 +586,52 @@ function readMatchStdData () {
 			var div = document.getElementById('match');	// Access to refreshable DIV
 			if (div)
 				div.innerHTML = htmlMatch;				// Update DIV content
-			// Global delay variable is set initially in swad-core
-			setTimeout('refreshMatchStd()',delayMatch);
 		}
+		if (pendingMatchStd) {	// Status changed during refresh
+			pendingMatchStd = false;
+			refreshMatchStd();
+		}
+		else
+			// Global delay variable is set initially in swad-core
+			timerMatchStd = setTimeout('refreshMatchStd()',delayMatch);
 	}
 }
 
+/*****************************************************************************/
+/************* Subscribe to changes in current match status ******************/
+/*****************************************************************************/
+
+// Status of match is pushed by the server (Server-Sent Events).
+// Match is refreshed only when status changes, and every delayMatch
+// to keep on being a player.
+// While the connection to the server is broken, match is polled every delayMatchPoll
+function subscribeMatchStd () {
+	var delayMatchPush = delayMatch;
+
+	if (typeof EventSource === 'undefined') {	// Server-Sent Events not supported
+		delayMatch = delayMatchPoll;
+		timerMatchStd = setTimeout('refreshMatchStd()',delayMatch);
+		return;
+	}
+
+	var source = new EventSource(PushURLMatch + '?' + RefreshParamMchCod);
+	source.onopen = function() {
+		delayMatch = delayMatchPush;
+	};
+	source.onerror = function() {	// Browser will try to connect again
+		delayMatch = delayMatchPoll;
+		if (timerMatchStd) {	// Waiting for next refresh ==> refresh sooner
+			clearTimeout(timerMatchStd);
+			timerMatchStd = setTimeout('refreshMatchStd()',delayMatch);
+		}
+	};
+	source.onmessage = function() {	// Status has changed
+		refreshMatchStd();
+	};
+
+	timerMatchStd = setTimeout('refreshMatchStd()',delayMatch);
+}
+
 /*****************************************************************************/
 /**** Automatic refresh of left part of current match question using AJAX ****/
 /*****************************************************************************/
@@ -543,6 +543,16 @@ CREATE TABLE IF NOT EXISTS firewall_log (
 	INDEX(ClickTime),
 	INDEX(IP));
 --
+-- Table forum_counters: stores the number of threads and posts, and the time of the last post, in each forum
+--
+CREATE TABLE IF NOT EXISTS forum_counters (
+	ForumType TINYINT NOT NULL,
+	Location INT NOT NULL DEFAULT -1,
+	NumThrs INT NOT NULL DEFAULT 0,
+	NumPsts INT NOT NULL DEFAULT 0,
+	LastPstTime DATETIME NOT NULL,
+	UNIQUE INDEX(ForumType,Location));
+--
 -- Table forum_disabled_post: stores the forum post that have been disabled
 --
 CREATE TABLE IF NOT EXISTS forum_disabled_post (
@@ -595,6 +605,7 @@ CREATE TABLE IF NOT EXISTS forum_thread (
 	Location INT NOT NULL DEFAULT -1,
 	FirstPstCod INT NOT NULL,
 	LastPstCod INT NOT NULL,
+	NumPsts INT NOT NULL DEFAULT 0,
 	UNIQUE INDEX(ThrCod),
 	INDEX(ForumType),
 	INDEX(Location),
@@ -686,6 +697,23 @@ CREATE TABLE IF NOT EXISTS mch_results (
 	Score DOUBLE PRECISION NOT NULL DEFAULT 0,
 	UNIQUE INDEX(MchCod,UsrCod));
 --
+-- Table mch_scores: stores the number of users with each score (multiplied by 2520) in every match
+--
+CREATE TABLE IF NOT EXISTS mch_scores (
+	MchCod INT NOT NULL,
+	ScaledScore INT NOT NULL,
+	NumUsrs INT NOT NULL DEFAULT 0,
+	UNIQUE INDEX(MchCod,ScaledScore));
+--
+-- Table mch_tally: stores the number of users who have chosen each answer in every match question
+--
+CREATE TABLE IF NOT EXISTS mch_tally (
+	MchCod INT NOT NULL,
+	QstInd INT NOT NULL,
+	AnsInd TINYINT NOT NULL,
+	NumUsrs INT NOT NULL DEFAULT 0,
+	UNIQUE INDEX(MchCod,QstInd,AnsInd));
+--
 -- Table gam_questions: stores the questions in the games
 --
 CREATE TABLE IF NOT EXISTS gam_questions (
@@ -711,6 +739,17 @@ CREATE TABLE IF NOT EXISTS hidden_params (
 	ParamValue LONGTEXT NOT NULL,
 	INDEX(SessionId));
 --
+-- Table hkp_jobs: stores when each housekeeping job was last run by swad_maintenance and how long it took
+--
+CREATE TABLE IF NOT EXISTS hkp_jobs (
+	Job VARCHAR(32) NOT NULL,
+	LastRun DATETIME NOT NULL,
+	NumRuns INT NOT NULL DEFAULT 0,
+	LastTimeUs BIGINT NOT NULL DEFAULT 0,
+	MaxTimeUs BIGINT NOT NULL DEFAULT 0,
+	TotalTimeUs BIGINT NOT NULL DEFAULT 0,
+	UNIQUE INDEX(Job));
+--
 -- Table holidays: stores the holidays in each institution
 --
 CREATE TABLE IF NOT EXISTS holidays (
@@ -777,6 +816,8 @@ CREATE TABLE IF NOT EXISTS log_full (
 	ClickTime DATETIME NOT NULL,
 	TimeToGenerate INT NOT NULL,
 	TimeToSend INT NOT NULL,
+	BytesGenerated INT NOT NULL DEFAULT 0,
+	BytesSent INT NOT NULL DEFAULT 0,
 	IP CHAR(15) NOT NULL,
 	UNIQUE INDEX(LogCod),
 	INDEX(ActCod),
@@ -803,6 +844,8 @@ CREATE TABLE IF NOT EXISTS log_recent (
 	ClickTime DATETIME NOT NULL,
 	TimeToGenerate INT NOT NULL,
 	TimeToSend INT NOT NULL,
+	BytesGenerated INT NOT NULL DEFAULT 0,
+	BytesSent INT NOT NULL DEFAULT 0,
 	IP CHAR(15) NOT NULL,
 	UNIQUE INDEX(LogCod),
 	INDEX(ActCod),
@@ -821,6 +864,13 @@ CREATE TABLE IF NOT EXISTS log_search (
 	SearchStr VARCHAR(2047) NOT NULL,
 	UNIQUE INDEX(LogCod));
 --
+-- Table log_spool: stores how much of the spool file being loaded has been inserted into log
+--
+CREATE TABLE IF NOT EXISTS log_spool (
+	Inode BIGINT NOT NULL,
+	CTime BIGINT NOT NULL,
+	Offset BIGINT NOT NULL);
+--
 -- Table log_ws: stores the log of calls to web service from plugins
 --
 CREATE TABLE IF NOT EXISTS log_ws (
@@ -840,6 +890,20 @@ CREATE TABLE IF NOT EXISTS mail_domains (
 	UNIQUE INDEX(MaiCod),
 	UNIQUE INDEX(Domain));
 --
+-- Table mail_queue: stores automatic e-mails waiting to be sent by swad_mailer
+--
+CREATE TABLE IF NOT EXISTS mail_queue (
+	QueCod INT NOT NULL AUTO_INCREMENT,
+	E_mail VARCHAR(255) NOT NULL,
+	Subject VARCHAR(1023) NOT NULL,
+	Content LONGTEXT NOT NULL,
+	CreatTime DATETIME NOT NULL,
+	NextTry DATETIME NOT NULL,
+	NumTries INT NOT NULL DEFAULT 0,
+	LastReply VARCHAR(511) NOT NULL DEFAULT '',
+	UNIQUE INDEX(QueCod),
+	INDEX(NextTry));
+--
 -- Table marks_properties: stores information about files of marks
 --
 CREATE TABLE IF NOT EXISTS marks_properties (
@@ -1080,6 +1144,15 @@ CREATE TABLE IF NOT EXISTS projects (
 	INDEX(CrsCod,ModifTime),
 	INDEX(CrsCod,DptCod));
 --
+-- Table sch_words: stores the inverted index of words used by the search tab
+--
+CREATE TABLE IF NOT EXISTS sch_words (
+	Type TINYINT NOT NULL,
+	Word VARCHAR(64) NOT NULL,
+	Cod INT NOT NULL,
+	UNIQUE INDEX(Type,Word,Cod),
+	INDEX(Type,Cod));
+--
 -- Table sessions: stores the information of open sessions
 --
 CREATE TABLE IF NOT EXISTS sessions (
@@ -1094,6 +1167,7 @@ CREATE TABLE IF NOT EXISTS sessions (
 	CrsCod INT NOT NULL DEFAULT -1,
 	LastTime DATETIME NOT NULL,
 	LastRefresh DATETIME NOT NULL,
+	Expire DATETIME NOT NULL,
 	FirstPubCod BIGINT NOT NULL DEFAULT 0,
 	LastPubCod BIGINT NOT NULL DEFAULT 0,
 	LastPageMsgRcv INT NOT NULL DEFAULT 1,
@@ -1102,7 +1176,15 @@ CREATE TABLE IF NOT EXISTS sessions (
 	SearchStr VARCHAR(2047) NOT NULL DEFAULT '',
 	SideCols TINYINT NOT NULL DEFAULT 3,
 	UNIQUE INDEX(SessionId),
-	INDEX(UsrCod));
+	INDEX(UsrCod),
+	INDEX(Expire));
+--
+-- Table sessions_count: stores the number of open sessions, counted periodically
+--
+CREATE TABLE IF NOT EXISTS sessions_count (
+	Id TINYINT NOT NULL DEFAULT 0,
+	NumSessions INT NOT NULL DEFAULT 0,
+	UNIQUE INDEX(Id));
 --
 -- Table sta_degrees: stores statistics about degrees
 --
@@ -1115,6 +1197,28 @@ CREATE TABLE IF NOT EXISTS sta_degrees (
 	TimeToComputeAvgPhoto INT NOT NULL DEFAULT -1,
 	UNIQUE INDEX(DegCod,Sex));
 --
+-- Table sta_hits: stores the number of hits per hour, action, place in the hierarchy and role, got from log
+--
+CREATE TABLE IF NOT EXISTS sta_hits (
+	HitHour DATETIME NOT NULL,
+	ActCod INT NOT NULL,
+	CtyCod INT NOT NULL,
+	InsCod INT NOT NULL,
+	CtrCod INT NOT NULL,
+	DegCod INT NOT NULL,
+	CrsCod INT NOT NULL,
+	Role TINYINT NOT NULL,
+	NumHits INT NOT NULL,
+	TimeToGenerate BIGINT NOT NULL,
+	TimeToSend BIGINT NOT NULL,
+	UNIQUE INDEX(HitHour,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role));
+--
+-- Table sta_hits_range: stores the range of hours [FirstHour,EndHour) already stored in sta_hits
+--
+CREATE TABLE IF NOT EXISTS sta_hits_range (
+	FirstHour DATETIME NOT NULL,
+	EndHour DATETIME NOT NULL);
+--
 -- Table sta_notif: stores statistics about notifications: number of notified events and number of e-mails sent
 --
 CREATE TABLE IF NOT EXISTS sta_notif (
@@ -1220,6 +1324,14 @@ CREATE TABLE IF NOT EXISTS tl_comments_fav (
 	UNIQUE INDEX(PubCod,UsrCod),
 	INDEX(UsrCod));
 --
+-- Table tl_inboxes: stores publications pushed to the timeline of every user
+--
+CREATE TABLE IF NOT EXISTS tl_inboxes (
+	UsrCod INT NOT NULL,
+	PubCod BIGINT NOT NULL,
+	NotCod BIGINT NOT NULL,
+	UNIQUE INDEX(UsrCod,PubCod));
+--
 -- Table tl_notes: stores timeline notes
 --
 CREATE TABLE IF NOT EXISTS tl_notes (
@@ -1270,6 +1382,12 @@ CREATE TABLE IF NOT EXISTS tl_pubs (
 	INDEX(PubType),
 	INDEX(TimePublish));
 --
+-- Table tl_pull_publishers: stores users with too many followers, whose publications are not pushed to inboxes
+--
+CREATE TABLE IF NOT EXISTS tl_pull_publishers (
+	UsrCod INT NOT NULL,
+	UNIQUE INDEX(UsrCod));
+--
 -- Table tl_timelines: stores notes published in timeline for every active session
 --
 CREATE TABLE IF NOT EXISTS tl_timelines (
@@ -1878,9 +1878,7 @@ int swad__findUsers (struct soap *soap,
      {
       Gbl.Scope.Current = (Gbl.Hierarchy.Level == Hie_CRS) ? Hie_CRS :
 							     Hie_SYS;
-      if (Sch_BuildSearchQuery (SearchQuery,
-				"CONCAT_WS(' ',FirstName,Surname1,Surname2)",
-				NULL,NULL))
+      if (Sch_BuildSearchQueryInIndex (SearchQuery,Sch_INDEX_USERS))
 	{
 	 /***** Create temporary table with candidate users *****/
 	 // Search is faster (aproximately x2) using temporary tables
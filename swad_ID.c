@@ -146,6 +146,7 @@ void ID_ReallocateListIDs (struct UsrData *UsrDat,unsigned NumIDs)
    /***** Allocate space for the list *****/
    if ((UsrDat->IDs.List = (struct ListIDs *) malloc (NumIDs * sizeof (struct ListIDs))) == NULL)
       Lay_NotEnoughMemoryExit ();
+   Usr_AddMemOfUsrData (UsrDat->IDs.List);
   }
 
 /*****************************************************************************/
@@ -156,7 +157,10 @@ void ID_FreeListIDs (struct UsrData *UsrDat)
   {
    /***** Free list *****/
    if (UsrDat->IDs.Num && UsrDat->IDs.List)
+     {
+      Usr_RemoveMemOfUsrData (UsrDat->IDs.List);
       free (UsrDat->IDs.List);
+     }
 
    /***** Reset list *****/
    UsrDat->IDs.List = NULL;
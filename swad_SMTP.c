@@ -0,0 +1,685 @@
+// swad_SMTP.c: send mails to an SMTP server
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <netdb.h>		// For getaddrinfo
+#include <openssl/evp.h>	// For EVP_EncodeBlock
+#include <openssl/ssl.h>	// For SSL functions
+#include <stdarg.h>		// For va_start, va_end
+#include <stdbool.h>		// For boolean type
+#include <stdio.h>		// For snprintf
+#include <string.h>		// For string functions
+#include <strings.h>		// For strncasecmp
+#include <sys/socket.h>		// For socket, connect, send, recv
+#include <sys/time.h>		// For struct timeval
+#include <time.h>		// For time, gmtime_r
+#include <unistd.h>		// For close, gethostname
+
+#include "swad_SMTP.h"
+
+/*****************************************************************************/
+/***************************** Private constants *****************************/
+/*****************************************************************************/
+
+#define SMTP_SECONDS_TIMEOUT		60	// Maximum time waiting for the server
+#define SMTP_MAX_BYTES_COMMAND		1023	// Maximum length of a command sent to server
+#define SMTP_MAX_BYTES_HOSTNAME		255	// Maximum length of host name sent in EHLO
+#define SMTP_MAX_BYTES_AUTH_PLAIN	1023	// Maximum length of user and password in AUTH PLAIN
+#define SMTP_MAX_BYTES_BODY_CHUNK	4096	// Body is sent in chunks of this size
+#define SMTP_MAX_BYTES_SUBJECT		2047	// Maximum length of encoded subject
+
+// RFC 2047: an encoded word can not be longer than 75 characters,
+// so a long subject is split in several encoded words.
+// 42 bytes encoded in base64 are 56 characters,
+// plus 17 characters of "=?ISO-8859-1?B?" and "?="
+#define SMTP_BYTES_PER_ENCODED_WORD	42
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static SMTP_Result_t SMTP_StartTLS (struct SMTP_Connection *Conn,const char *Server);
+static SMTP_Result_t SMTP_SayHello (struct SMTP_Connection *Conn);
+static SMTP_Result_t SMTP_Authenticate (struct SMTP_Connection *Conn,
+                                        const char *User,const char *Password);
+static void SMTP_Reset (struct SMTP_Connection *Conn);
+
+static bool SMTP_WriteHeaders (struct SMTP_Connection *Conn,
+                               const char *From,const char *To,
+                               const char *Subject);
+static void SMTP_EncodeSubject (const char *Subject,
+                                char EncodedSubject[SMTP_MAX_BYTES_SUBJECT + 1]);
+static bool SMTP_WriteBody (struct SMTP_Connection *Conn,const char *Content);
+
+static SMTP_Result_t SMTP_GetReply (struct SMTP_Connection *Conn,char ExpectedClass);
+static bool SMTP_ReadLine (struct SMTP_Connection *Conn);
+static bool SMTP_WriteCommand (struct SMTP_Connection *Conn,const char *fmt,...);
+static bool SMTP_Write (struct SMTP_Connection *Conn,const char *Data,size_t Length);
+static void SMTP_Close (struct SMTP_Connection *Conn);
+
+/*****************************************************************************/
+/******* Open a connection to an SMTP server and authenticate in it **********/
+/*****************************************************************************/
+// The same connection can be used to send many mails
+
+SMTP_Result_t SMTP_Connect (struct SMTP_Connection *Conn,
+                            const char *Server,const char *Port,
+                            SMTP_Security_t Security,
+                            const char *User,const char *Password)
+  {
+   struct addrinfo Hints;
+   struct addrinfo *AddrInfo;
+   struct addrinfo *Addr;
+   struct timeval Timeout;
+   SMTP_Result_t Result;
+
+   /***** Reset connection *****/
+   Conn->Socket = -1;
+   Conn->Ctx = NULL;
+   Conn->SSL = NULL;
+   Conn->Pipelining = false;
+   Conn->Start = Conn->End = 0;
+   Conn->Reply[0] = '\0';
+
+   /***** Get addresses of server *****/
+   memset (&Hints,0,sizeof (Hints));
+   Hints.ai_family   = AF_UNSPEC;
+   Hints.ai_socktype = SOCK_STREAM;
+   if (getaddrinfo (Server,Port,&Hints,&AddrInfo))
+     {
+      snprintf (Conn->Reply,sizeof (Conn->Reply),
+                "Can not resolve %s",Server);
+      return SMTP_TEMPORARY_ERROR;
+     }
+
+   /***** Connect to the first address that answers *****/
+   Timeout.tv_sec  = SMTP_SECONDS_TIMEOUT;
+   Timeout.tv_usec = 0;
+   for (Addr = AddrInfo;
+	Addr != NULL && Conn->Socket < 0;
+	Addr = Addr->ai_next)
+      if ((Conn->Socket = socket (Addr->ai_family,Addr->ai_socktype,Addr->ai_protocol)) >= 0)
+	{
+	 setsockopt (Conn->Socket,SOL_SOCKET,SO_RCVTIMEO,&Timeout,sizeof (Timeout));
+	 setsockopt (Conn->Socket,SOL_SOCKET,SO_SNDTIMEO,&Timeout,sizeof (Timeout));
+	 if (connect (Conn->Socket,Addr->ai_addr,Addr->ai_addrlen))
+	   {
+	    close (Conn->Socket);
+	    Conn->Socket = -1;
+	   }
+	}
+   freeaddrinfo (AddrInfo);
+   if (Conn->Socket < 0)
+     {
+      snprintf (Conn->Reply,sizeof (Conn->Reply),
+                "Can not connect to %s:%s",Server,Port);
+      return SMTP_TEMPORARY_ERROR;
+     }
+
+   /***** TLS from the beginning *****/
+   if (Security == SMTP_TLS)
+      if ((Result = SMTP_StartTLS (Conn,Server)) != SMTP_OK)
+	 return Result;
+
+   /***** Get greeting and say hello *****/
+   if ((Result = SMTP_GetReply (Conn,'2')) != SMTP_OK ||
+       (Result = SMTP_SayHello (Conn)) != SMTP_OK)
+     {
+      SMTP_Close (Conn);
+      return Result;
+     }
+
+   /***** Upgrade plain connection to TLS and say hello again *****/
+   if (Security == SMTP_STARTTLS)
+     {
+      if (!SMTP_WriteCommand (Conn,"STARTTLS\r\n") ||
+	  (Result = SMTP_GetReply (Conn,'2')) != SMTP_OK)
+	{
+	 SMTP_Close (Conn);
+	 return Result == SMTP_OK ? SMTP_TEMPORARY_ERROR :
+				    Result;
+	}
+      if ((Result = SMTP_StartTLS (Conn,Server)) != SMTP_OK)
+	 return Result;
+      if ((Result = SMTP_SayHello (Conn)) != SMTP_OK)
+	{
+	 SMTP_Close (Conn);
+	 return Result;
+	}
+     }
+
+   /***** Log in *****/
+   if (Password && Password[0])
+      if ((Result = SMTP_Authenticate (Conn,User,Password)) != SMTP_OK)
+	{
+	 SMTP_Close (Conn);
+	 return Result;
+	}
+
+   return SMTP_OK;
+  }
+
+/*****************************************************************************/
+/************************ Start TLS in the connection ************************/
+/*****************************************************************************/
+// The certificate of the server is checked
+
+static SMTP_Result_t SMTP_StartTLS (struct SMTP_Connection *Conn,const char *Server)
+  {
+   if ((Conn->Ctx = SSL_CTX_new (TLS_client_method ())) == NULL ||
+       (Conn->SSL = SSL_new (Conn->Ctx)) == NULL)
+     {
+      snprintf (Conn->Reply,sizeof (Conn->Reply),
+                "Can not create TLS context");
+      SMTP_Close (Conn);
+      return SMTP_TEMPORARY_ERROR;
+     }
+
+   SSL_CTX_set_default_verify_paths (Conn->Ctx);
+   SSL_set_verify (Conn->SSL,SSL_VERIFY_PEER,NULL);
+   SSL_set_tlsext_host_name (Conn->SSL,Server);
+   SSL_set1_host (Conn->SSL,Server);
+   SSL_set_fd (Conn->SSL,Conn->Socket);
+   if (SSL_connect (Conn->SSL) != 1)
+     {
+      snprintf (Conn->Reply,sizeof (Conn->Reply),
+                "TLS handshake with %s failed",Server);
+      SSL_free (Conn->SSL);	// Don't try to send TLS close notify
+      Conn->SSL = NULL;
+      SMTP_Close (Conn);
+      return SMTP_TEMPORARY_ERROR;
+     }
+
+   /***** Data received before TLS must be ignored *****/
+   Conn->Start = Conn->End = 0;
+
+   return SMTP_OK;
+  }
+
+/*****************************************************************************/
+/********** Say hello to server and get the extensions it supports ***********/
+/*****************************************************************************/
+
+static SMTP_Result_t SMTP_SayHello (struct SMTP_Connection *Conn)
+  {
+   char HostName[SMTP_MAX_BYTES_HOSTNAME + 1];
+
+   if (gethostname (HostName,sizeof (HostName)))
+      strcpy (HostName,"localhost");
+   HostName[SMTP_MAX_BYTES_HOSTNAME] = '\0';
+
+   if (!SMTP_WriteCommand (Conn,"EHLO %s\r\n",HostName))
+      return SMTP_TEMPORARY_ERROR;
+
+   /***** SMTP_GetReply checks if server supports pipelining
+          in every line of the reply to EHLO *****/
+   Conn->Pipelining = false;
+   return SMTP_GetReply (Conn,'2');
+  }
+
+/*****************************************************************************/
+/************************** Log in using AUTH PLAIN **************************/
+/*****************************************************************************/
+
+static SMTP_Result_t SMTP_Authenticate (struct SMTP_Connection *Conn,
+                                        const char *User,const char *Password)
+  {
+   unsigned char Plain[SMTP_MAX_BYTES_AUTH_PLAIN + 1];
+   unsigned char Encoded[4 * ((SMTP_MAX_BYTES_AUTH_PLAIN + 2) / 3) + 1];
+   size_t LengthUser = strlen (User);
+   size_t LengthPassword = strlen (Password);
+
+   /***** Build "\0user\0password" *****/
+   if (2 + LengthUser + LengthPassword > SMTP_MAX_BYTES_AUTH_PLAIN)
+     {
+      snprintf (Conn->Reply,sizeof (Conn->Reply),
+                "User or password too long");
+      return SMTP_PERMANENT_ERROR;
+     }
+   Plain[0] = '\0';
+   memcpy (&Plain[1],User,LengthUser);
+   Plain[1 + LengthUser] = '\0';
+   memcpy (&Plain[2 + LengthUser],Password,LengthPassword);
+
+   /***** Send it encoded in base64 *****/
+   EVP_EncodeBlock (Encoded,Plain,(int) (2 + LengthUser + LengthPassword));
+   if (!SMTP_WriteCommand (Conn,"AUTH PLAIN %s\r\n",(const char *) Encoded))
+      return SMTP_TEMPORARY_ERROR;
+
+   return SMTP_GetReply (Conn,'2');
+  }
+
+/*****************************************************************************/
+/**************** Send a mail using an open SMTP connection ******************/
+/*****************************************************************************/
+// If the server supports pipelining, MAIL, RCPT and DATA are sent together,
+// so only one round trip is needed before sending the message
+
+SMTP_Result_t SMTP_SendMail (struct SMTP_Connection *Conn,
+                             const char *From,const char *To,
+                             const char *Subject,const char *Content)
+  {
+   SMTP_Result_t ResultMail;
+   SMTP_Result_t ResultRcpt;
+   SMTP_Result_t ResultData;
+
+   if (Conn->Socket < 0)
+      return SMTP_TEMPORARY_ERROR;
+
+   /***** Send envelope *****/
+   if (Conn->Pipelining)
+     {
+      if (!SMTP_WriteCommand (Conn,"MAIL FROM:<%s>\r\n"
+				   "RCPT TO:<%s>\r\n"
+				   "DATA\r\n",
+			      From,To))
+	 return SMTP_TEMPORARY_ERROR;
+      ResultMail = SMTP_GetReply (Conn,'2');
+      ResultRcpt = SMTP_GetReply (Conn,'2');
+      ResultData = SMTP_GetReply (Conn,'3');
+     }
+   else
+     {
+      ResultRcpt = ResultData = SMTP_TEMPORARY_ERROR;
+      if (!SMTP_WriteCommand (Conn,"MAIL FROM:<%s>\r\n",From))
+	 return SMTP_TEMPORARY_ERROR;
+      if ((ResultMail = SMTP_GetReply (Conn,'2')) == SMTP_OK)
+	{
+	 if (!SMTP_WriteCommand (Conn,"RCPT TO:<%s>\r\n",To))
+	    return SMTP_TEMPORARY_ERROR;
+	 if ((ResultRcpt = SMTP_GetReply (Conn,'2')) == SMTP_OK)
+	   {
+	    if (!SMTP_WriteCommand (Conn,"DATA\r\n"))
+	       return SMTP_TEMPORARY_ERROR;
+	    ResultData = SMTP_GetReply (Conn,'3');
+	   }
+	}
+     }
+   if (Conn->Socket < 0)	// Connection lost
+      return SMTP_TEMPORARY_ERROR;
+
+   /***** Envelope rejected *****/
+   if (ResultMail != SMTP_OK ||
+       ResultRcpt != SMTP_OK ||
+       ResultData != SMTP_OK)
+     {
+      if (ResultData == SMTP_OK)	// Server is waiting for the message
+	{
+	 SMTP_WriteCommand (Conn,".\r\n");
+	 SMTP_GetReply (Conn,'2');
+	}
+      SMTP_Reset (Conn);
+      return ResultMail != SMTP_OK ? ResultMail :
+	    (ResultRcpt != SMTP_OK ? ResultRcpt :
+				     ResultData);
+     }
+
+   /***** Send message *****/
+   if (!SMTP_WriteHeaders (Conn,From,To,Subject) ||
+       !SMTP_WriteBody (Conn,Content) ||
+       !SMTP_WriteCommand (Conn,".\r\n"))
+      return SMTP_TEMPORARY_ERROR;
+
+   return SMTP_GetReply (Conn,'2');
+  }
+
+/*****************************************************************************/
+/************ Abort current mail transaction after an error ******************/
+/*****************************************************************************/
+
+static void SMTP_Reset (struct SMTP_Connection *Conn)
+  {
+   char Reply[SMTP_MAX_BYTES_REPLY + 1];
+
+   /***** Keep the reply that explains the error *****/
+   strcpy (Reply,Conn->Reply);
+   if (SMTP_WriteCommand (Conn,"RSET\r\n"))
+      SMTP_GetReply (Conn,'2');
+   strcpy (Conn->Reply,Reply);
+  }
+
+/*****************************************************************************/
+/*************************** Write message headers ***************************/
+/*****************************************************************************/
+// Content written by swad is in ISO-8859-1
+
+static bool SMTP_WriteHeaders (struct SMTP_Connection *Conn,
+                               const char *From,const char *To,
+                               const char *Subject)
+  {
+   static const char *Days[7] =
+     {
+      "Sun","Mon","Tue","Wed","Thu","Fri","Sat",
+     };
+   static const char *Months[12] =
+     {
+      "Jan","Feb","Mar","Apr","May","Jun",
+      "Jul","Aug","Sep","Oct","Nov","Dec",
+     };
+   time_t Now = time (NULL);
+   struct tm TmUTC;
+   char EncodedSubject[SMTP_MAX_BYTES_SUBJECT + 1];
+
+   /***** Subject with non-ASCII characters must be encoded *****/
+   SMTP_EncodeSubject (Subject,EncodedSubject);
+
+   /***** Date in RFC 5322 format, independent of locale *****/
+   gmtime_r (&Now,&TmUTC);
+
+   return SMTP_WriteCommand (Conn,"From: %s\r\n"
+				  "To: %s\r\n"
+				  "Subject: %s\r\n"
+				  "Date: %s, %02d %s %04d %02d:%02d:%02d +0000\r\n"
+				  "MIME-Version: 1.0\r\n"
+				  "Content-Type: text/plain; charset=iso-8859-1\r\n"
+				  "Content-Transfer-Encoding: 8bit\r\n"
+				  "\r\n",
+			     From,To,EncodedSubject,
+			     Days[TmUTC.tm_wday],TmUTC.tm_mday,
+			     Months[TmUTC.tm_mon],TmUTC.tm_year + 1900,
+			     TmUTC.tm_hour,TmUTC.tm_min,TmUTC.tm_sec);
+  }
+
+/*****************************************************************************/
+/********************** Encode subject as in RFC 2047 ************************/
+/*****************************************************************************/
+// Subjects are in ISO-8859-1 and headers can contain only ASCII characters.
+// A subject with only printable ASCII characters is copied as is.
+// Other subjects are encoded in base64 in one or more encoded words,
+// "=?ISO-8859-1?B?...?=", separated by folding white space
+
+static void SMTP_EncodeSubject (const char *Subject,
+                                char EncodedSubject[SMTP_MAX_BYTES_SUBJECT + 1])
+  {
+   const unsigned char *Ptr;
+   size_t LengthSubject = strlen (Subject);
+   size_t LengthEncoded = 0;
+   size_t NumBytesInWord;
+   bool OnlyASCII = true;
+
+   /***** Check if subject has only printable ASCII characters *****/
+   for (Ptr = (const unsigned char *) Subject;
+	*Ptr;
+	Ptr++)
+      if (*Ptr < 0x20 || *Ptr > 0x7E)
+	{
+	 OnlyASCII = false;
+	 break;
+	}
+
+   if (OnlyASCII && LengthSubject <= SMTP_MAX_BYTES_SUBJECT)
+     {
+      strcpy (EncodedSubject,Subject);
+      return;
+     }
+
+   /***** Encode subject in encoded words *****/
+   for (Ptr = (const unsigned char *) Subject;
+	LengthSubject;
+	Ptr += NumBytesInWord, LengthSubject -= NumBytesInWord)
+     {
+      NumBytesInWord = LengthSubject < SMTP_BYTES_PER_ENCODED_WORD ? LengthSubject :
+								     SMTP_BYTES_PER_ENCODED_WORD;
+
+      /* Check if there is room for separator, encoded word and ending */
+      if (LengthEncoded + 3 + 15 + 4 * ((NumBytesInWord + 2) / 3) + 2 > SMTP_MAX_BYTES_SUBJECT)
+	 break;
+
+      /* Folding white space between encoded words */
+      if (LengthEncoded)
+	{
+	 memcpy (&EncodedSubject[LengthEncoded],"\r\n ",3);
+	 LengthEncoded += 3;
+	}
+
+      /* Encoded word */
+      memcpy (&EncodedSubject[LengthEncoded],"=?ISO-8859-1?B?",15);
+      LengthEncoded += 15;
+      LengthEncoded += (size_t) EVP_EncodeBlock ((unsigned char *) &EncodedSubject[LengthEncoded],
+						 Ptr,(int) NumBytesInWord);
+      memcpy (&EncodedSubject[LengthEncoded],"?=",2);
+      LengthEncoded += 2;
+     }
+   EncodedSubject[LengthEncoded] = '\0';
+  }
+
+/*****************************************************************************/
+/***************************** Write message body ****************************/
+/*****************************************************************************/
+// Line ends are converted to CRLF
+// and a dot is added to lines starting with a dot
+
+static bool SMTP_WriteBody (struct SMTP_Connection *Conn,const char *Content)
+  {
+   char Chunk[SMTP_MAX_BYTES_BODY_CHUNK + 2];
+   size_t Length = 0;
+   bool StartOfLine = true;
+   const char *Ptr;
+
+   for (Ptr = Content;
+	*Ptr;
+	Ptr++)
+     {
+      if (*Ptr == '\r')	// CR is added before every LF
+	 continue;
+
+      if (StartOfLine && *Ptr == '.')
+	 Chunk[Length++] = '.';
+      if (*Ptr == '\n')
+	 Chunk[Length++] = '\r';
+      Chunk[Length++] = *Ptr;
+      StartOfLine = (*Ptr == '\n');
+
+      /***** Send chunk when full *****/
+      if (Length >= SMTP_MAX_BYTES_BODY_CHUNK)
+	{
+	 if (!SMTP_Write (Conn,Chunk,Length))
+	    return false;
+	 Length = 0;
+	}
+     }
+
+   /***** Message must end with a line end *****/
+   if (!StartOfLine)
+     {
+      Chunk[Length++] = '\r';
+      Chunk[Length++] = '\n';
+     }
+
+   return SMTP_Write (Conn,Chunk,Length);
+  }
+
+/*****************************************************************************/
+/********************** Check if connection is still open ********************/
+/*****************************************************************************/
+
+bool SMTP_CheckIfConnected (const struct SMTP_Connection *Conn)
+  {
+   return Conn->Socket >= 0;
+  }
+
+/*****************************************************************************/
+/********************** Say goodbye and close connection *********************/
+/*****************************************************************************/
+
+void SMTP_Disconnect (struct SMTP_Connection *Conn)
+  {
+   if (Conn->Socket >= 0)
+      if (SMTP_WriteCommand (Conn,"QUIT\r\n"))
+	 SMTP_GetReply (Conn,'2');
+
+   SMTP_Close (Conn);
+  }
+
+/*****************************************************************************/
+/************************ Get reply from SMTP server *************************/
+/*****************************************************************************/
+// ExpectedClass is the first digit of the expected reply code ('2' or '3')
+// The last line of the reply is stored in Conn->Reply
+// On error reading from server, connection is closed
+
+static SMTP_Result_t SMTP_GetReply (struct SMTP_Connection *Conn,char ExpectedClass)
+  {
+   /***** Read lines until the last one (with a space after the code) *****/
+   do
+     {
+      if (!SMTP_ReadLine (Conn))
+	{
+	 SMTP_Close (Conn);
+	 return SMTP_TEMPORARY_ERROR;
+	}
+
+      /* Check if server supports pipelining (reply to EHLO) */
+      if (strlen (Conn->Reply) >= 14 &&
+	  !strncasecmp (&Conn->Reply[4],"PIPELINING",10) &&
+	  (Conn->Reply[14] == '\0' || Conn->Reply[14] == ' '))
+	 Conn->Pipelining = true;
+     }
+   while (Conn->Reply[0] && Conn->Reply[1] && Conn->Reply[2] &&
+	  Conn->Reply[3] == '-');
+
+   /***** Check reply code *****/
+   if (Conn->Reply[0] == ExpectedClass)
+      return SMTP_OK;
+   if (Conn->Reply[0] == '4')
+      return SMTP_TEMPORARY_ERROR;
+   return SMTP_PERMANENT_ERROR;
+  }
+
+/*****************************************************************************/
+/******************* Read a line from server into Conn->Reply ****************/
+/*****************************************************************************/
+// Too long lines are truncated
+
+static bool SMTP_ReadLine (struct SMTP_Connection *Conn)
+  {
+   size_t Length = 0;
+   int NumBytes;
+   char Ch;
+
+   for (;;)
+     {
+      /***** Fill buffer if empty *****/
+      if (Conn->Start >= Conn->End)
+	{
+	 if (Conn->SSL)
+	    NumBytes = SSL_read (Conn->SSL,Conn->Buffer,(int) sizeof (Conn->Buffer));
+	 else
+	    NumBytes = (int) recv (Conn->Socket,Conn->Buffer,sizeof (Conn->Buffer),0);
+	 if (NumBytes <= 0)
+	    return false;
+	 Conn->Start = 0;
+	 Conn->End = (size_t) NumBytes;
+	}
+
+      /***** Copy characters until end of line *****/
+      Ch = Conn->Buffer[Conn->Start++];
+      if (Ch == '\n')
+	{
+	 Conn->Reply[Length] = '\0';
+	 return true;
+	}
+      if (Ch != '\r' && Length < SMTP_MAX_BYTES_REPLY)
+	 Conn->Reply[Length++] = Ch;
+     }
+  }
+
+/*****************************************************************************/
+/************************ Write a command to server **************************/
+/*****************************************************************************/
+
+static bool SMTP_WriteCommand (struct SMTP_Connection *Conn,const char *fmt,...)
+  {
+   va_list ap;
+   char Command[SMTP_MAX_BYTES_COMMAND + 1];
+   int Length;
+
+   va_start (ap,fmt);
+   Length = vsnprintf (Command,sizeof (Command),fmt,ap);
+   va_end (ap);
+   if (Length < 0 || Length > SMTP_MAX_BYTES_COMMAND)
+     {
+      snprintf (Conn->Reply,sizeof (Conn->Reply),
+                "Command too long");
+      return false;
+     }
+
+   return SMTP_Write (Conn,Command,(size_t) Length);
+  }
+
+/*****************************************************************************/
+/******************************* Write to server *****************************/
+/*****************************************************************************/
+// On error, connection is closed
+
+static bool SMTP_Write (struct SMTP_Connection *Conn,const char *Data,size_t Length)
+  {
+   int NumBytes;
+
+   if (Conn->Socket < 0)
+      return false;
+
+   while (Length)
+     {
+      if (Conn->SSL)
+	 NumBytes = SSL_write (Conn->SSL,Data,(int) Length);
+      else
+	 NumBytes = (int) send (Conn->Socket,Data,Length,MSG_NOSIGNAL);
+      if (NumBytes <= 0)
+	{
+	 SMTP_Close (Conn);
+	 return false;
+	}
+      Data += NumBytes;
+      Length -= (size_t) NumBytes;
+     }
+
+   return true;
+  }
+
+/*****************************************************************************/
+/******************* Close connection without saying goodbye *****************/
+/*****************************************************************************/
+
+static void SMTP_Close (struct SMTP_Connection *Conn)
+  {
+   if (Conn->SSL)
+     {
+      SSL_shutdown (Conn->SSL);
+      SSL_free (Conn->SSL);
+      Conn->SSL = NULL;
+     }
+   if (Conn->Ctx)
+     {
+      SSL_CTX_free (Conn->Ctx);
+      Conn->Ctx = NULL;
+     }
+   if (Conn->Socket >= 0)
+     {
+      close (Conn->Socket);
+      Conn->Socket = -1;
+     }
+  }
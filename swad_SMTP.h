@@ -0,0 +1,84 @@
+// swad_SMTP.h: send mails to an SMTP server
+
+#ifndef _SWAD_SMTP
+#define _SWAD_SMTP
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************** Headers **********************************/
+/*****************************************************************************/
+
+#include <openssl/ssl.h>	// For SSL
+#include <stdbool.h>		// For boolean type
+#include <stddef.h>		// For size_t
+
+/*****************************************************************************/
+/****************************** Public constants *****************************/
+/*****************************************************************************/
+
+#define SMTP_MAX_BYTES_REPLY 511	// Maximum length of a reply line from SMTP server
+
+/*****************************************************************************/
+/******************************** Public types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   SMTP_PLAIN,		// No encryption. Only for testing against a local server
+   SMTP_STARTTLS,	// Plain connection upgraded to TLS with STARTTLS (usually port 587)
+   SMTP_TLS,		// TLS from the beginning (usually port 465)
+  } SMTP_Security_t;
+
+typedef enum
+  {
+   SMTP_OK,		// Mail accepted by server
+   SMTP_TEMPORARY_ERROR,	// Mail not accepted now, but it can be tried again later
+   SMTP_PERMANENT_ERROR,	// Mail rejected by server, it must not be tried again
+  } SMTP_Result_t;
+
+struct SMTP_Connection
+  {
+   int Socket;			// < 0 ==> not connected
+   SSL_CTX *Ctx;
+   SSL *SSL;			// NULL ==> not encrypted
+   bool Pipelining;		// Server supports pipelining of commands
+   size_t Start;		// Start of pending data in buffer
+   size_t End;			// End of pending data in buffer
+   char Buffer[SMTP_MAX_BYTES_REPLY + 1];
+   char Reply[SMTP_MAX_BYTES_REPLY + 1];	// Last reply line from server
+  };
+
+/*****************************************************************************/
+/****************************** Public prototypes ****************************/
+/*****************************************************************************/
+
+SMTP_Result_t SMTP_Connect (struct SMTP_Connection *Conn,
+                            const char *Server,const char *Port,
+                            SMTP_Security_t Security,
+                            const char *User,const char *Password);
+SMTP_Result_t SMTP_SendMail (struct SMTP_Connection *Conn,
+                             const char *From,const char *To,
+                             const char *Subject,const char *Content);
+bool SMTP_CheckIfConnected (const struct SMTP_Connection *Conn);
+void SMTP_Disconnect (struct SMTP_Connection *Conn);
+
+#endif
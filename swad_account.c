@@ -45,6 +45,7 @@
 #include "swad_parameter.h"
 #include "swad_profile.h"
 #include "swad_report.h"
+#include "swad_search.h"
 #include "swad_timeline.h"
 
 /*****************************************************************************/
@@ -784,6 +785,10 @@ void Acc_CreateNewUsr (struct UsrData *UsrDat,bool CreatingMyOwnAccount)
 				(unsigned) Mnu_MENU_DEFAULT,
 				(unsigned) Cfg_DEFAULT_COLUMNS);
 
+   /* Add user's name to index of words used in searches */
+   Sch_UpdateIndexOfUsr (UsrDat->UsrCod,
+			 UsrDat->FirstName,UsrDat->Surname1,UsrDat->Surname2);
+
    /* Insert user's IDs as confirmed */
    for (NumID = 0;
 	NumID < UsrDat->IDs.Num;
@@ -1182,6 +1187,9 @@ static void Acc_RemoveUsr (struct UsrData *UsrDat)
    DB_QueryDELETE ("can not remove user's data",
 		   "DELETE FROM usr_data WHERE UsrCod=%ld",
 		   UsrDat->UsrCod);
+
+   /***** Remove user from index of words used in searches *****/
+   Sch_RemoveFromIndex (Sch_INDEX_USERS,UsrDat->UsrCod);
   }
 
 /*****************************************************************************/
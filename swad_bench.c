@@ -0,0 +1,202 @@
+// swad_bench.c: common functions of database benchmarks
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+   Benchmarks use a scratch database given in the command line.
+   They create their own tables in it (with prefix bench_) and drop them
+   at the end, so they must never be run against the database of SWAD.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#define _GNU_SOURCE 		// For vasprintf
+#include <stdarg.h>		// For va_start, va_end
+#include <stdio.h>		// For fprintf, printf, vasprintf
+#include <stdlib.h>		// For exit, free
+#include <sys/time.h>		// For gettimeofday
+
+#include "swad_bench.h"
+
+/*****************************************************************************/
+/************************* Private global variables **************************/
+/*****************************************************************************/
+
+static MYSQL Bch_mysql;
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void Bch_QueryStr (char *Query);
+static void Bch_ExitOnMySQLError (void);
+
+/*****************************************************************************/
+/************************ Connect to scratch database ************************/
+/*****************************************************************************/
+
+void Bch_ConnectToDB (char *Args[Bch_NUM_ARGS_DB])
+  {
+   if (mysql_init (&Bch_mysql) == NULL)
+     {
+      fprintf (stderr,"Can not init MySQL.\n");
+      exit (1);
+     }
+   if (mysql_real_connect (&Bch_mysql,Args[0],Args[1],Args[2],Args[3],
+                           0,NULL,0) == NULL)
+      Bch_ExitOnMySQLError ();
+  }
+
+/*****************************************************************************/
+/********************** Disconnect from scratch database *********************/
+/*****************************************************************************/
+
+void Bch_DisconnectFromDB (void)
+  {
+   mysql_close (&Bch_mysql);
+  }
+
+/*****************************************************************************/
+/********************* Get connection to scratch database ********************/
+/*****************************************************************************/
+
+MYSQL *Bch_GetDB (void)
+  {
+   return &Bch_mysql;
+  }
+
+/*****************************************************************************/
+/******************** Make a query which returns no rows *********************/
+/*****************************************************************************/
+
+void Bch_Query (const char *fmt,...)
+  {
+   va_list ap;
+   char *Query;
+
+   va_start (ap,fmt);
+   if (vasprintf (&Query,fmt,ap) < 0)
+      exit (1);
+   va_end (ap);
+
+   Bch_QueryStr (Query);
+  }
+
+/*****************************************************************************/
+/*************************** Make a SELECT query *****************************/
+/*****************************************************************************/
+// Return the number of rows
+
+unsigned long Bch_QuerySELECT (MYSQL_RES **mysql_res,const char *fmt,...)
+  {
+   va_list ap;
+   char *Query;
+
+   va_start (ap,fmt);
+   if (vasprintf (&Query,fmt,ap) < 0)
+      exit (1);
+   va_end (ap);
+
+   Bch_QueryStr (Query);
+   if ((*mysql_res = mysql_store_result (&Bch_mysql)) == NULL)
+      Bch_ExitOnMySQLError ();
+
+   return (unsigned long) mysql_num_rows (*mysql_res);
+  }
+
+/*****************************************************************************/
+/*************** Make a SELECT query which returns a number ******************/
+/*****************************************************************************/
+
+unsigned long Bch_QueryCOUNT (const char *fmt,...)
+  {
+   va_list ap;
+   char *Query;
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long Num = 0;
+
+   va_start (ap,fmt);
+   if (vasprintf (&Query,fmt,ap) < 0)
+      exit (1);
+   va_end (ap);
+
+   Bch_QueryStr (Query);
+   if ((mysql_res = mysql_store_result (&Bch_mysql)) == NULL)
+      Bch_ExitOnMySQLError ();
+   if ((row = mysql_fetch_row (mysql_res)))
+      if (row[0])
+	 if (sscanf (row[0],"%lu",&Num) != 1)
+	    Num = 0;
+   mysql_free_result (mysql_res);
+
+   return Num;
+  }
+
+/*****************************************************************************/
+/********************* Send a query and free query string ********************/
+/*****************************************************************************/
+
+static void Bch_QueryStr (char *Query)
+  {
+   int Result;
+
+   Result = mysql_query (&Bch_mysql,Query);
+   free (Query);
+   if (Result)
+      Bch_ExitOnMySQLError ();
+  }
+
+/*****************************************************************************/
+/************************ Write error and exit *******************************/
+/*****************************************************************************/
+
+static void Bch_ExitOnMySQLError (void)
+  {
+   fprintf (stderr,"Database error: %s.\n",mysql_error (&Bch_mysql));
+   exit (1);
+  }
+
+/*****************************************************************************/
+/************************ Get current time in seconds ************************/
+/*****************************************************************************/
+
+double Bch_GetSeconds (void)
+  {
+   struct timeval Now;
+
+   gettimeofday (&Now,NULL);
+   return (double) Now.tv_sec + (double) Now.tv_usec / 1E6;
+  }
+
+/*****************************************************************************/
+/********************* Write total time and time per unit ********************/
+/*****************************************************************************/
+
+void Bch_WriteTime (const char *What,unsigned long NumTimes,double Seconds)
+  {
+   printf ("%-48s %10.3f s %12.1f us each\n",
+	   What,Seconds,
+	   NumTimes ? Seconds * 1E6 / (double) NumTimes :
+		      0.0);
+  }
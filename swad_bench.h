@@ -0,0 +1,54 @@
+// swad_bench.h: common functions of database benchmarks
+
+#ifndef _SWAD_BCH
+#define _SWAD_BCH
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************** Headers **********************************/
+/*****************************************************************************/
+
+#include <mysql/mysql.h>	// To access MySQL databases
+
+/*****************************************************************************/
+/****************************** Public constants *****************************/
+/*****************************************************************************/
+
+#define Bch_NUM_ARGS_DB	4	// <host> <user> <password> <database>
+#define Bch_USAGE_DB	"<host> <user> <password> <database>"
+
+/*****************************************************************************/
+/***************************** Public prototypes *****************************/
+/*****************************************************************************/
+
+void Bch_ConnectToDB (char *Args[Bch_NUM_ARGS_DB]);
+void Bch_DisconnectFromDB (void);
+MYSQL *Bch_GetDB (void);
+
+void Bch_Query (const char *fmt,...);
+unsigned long Bch_QuerySELECT (MYSQL_RES **mysql_res,const char *fmt,...);
+unsigned long Bch_QueryCOUNT (const char *fmt,...);
+
+double Bch_GetSeconds (void);
+void Bch_WriteTime (const char *What,unsigned long NumTimes,double Seconds);
+
+#endif
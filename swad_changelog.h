@@ -497,9 +497,9 @@ enscript -2 --landscape --color --file-align=2 --highlight --line-numbers -o - *
 En OpenSWAD:
 ps2pdf source.ps destination.pdf
 */
-#define Log_PLATFORM_VERSION	"SWAD 19.146 (2020-03-12)"
+#define Log_PLATFORM_VERSION	"SWAD 19.202 (2020-04-04)"
 #define CSS_FILE		"swad19.146.css"
-#define JS_FILE			"swad19.91.1.js"
+#define JS_FILE			"swad19.159.js"
 /*
  *
 // TODO: Geolocalizacin:
@@ -525,6 +525,153 @@ Param
 // TODO: Oresti Baos: cambiar ojos por candados en descriptores para prohibir/permitir y dejar los ojos para poder elegir descriptores
 // TODO: Instalar la ltima versin de MathJax de https://www.jsdelivr.com/package/npm/mathjax y comprobar que funciona bien con pandoc
 
+	Version 19.202:   Apr 4, 2020	Benchmark swad_timeline_bench also gets the timeline of followed users from inboxes (fan-out on write), to compare with fan-out on read. (295739 lines)
+	Version 19.201:   Apr 4, 2020	New benchmark swad_timeline_bench to get publications in timeline from a table with millions of publications, one by one as before and in batches as now. (295650 lines)
+	Version 19.200:   Apr 4, 2020	Fix: changes of the answers of a student in a match, and of tallies, result and scores, are serialized with a named lock, also with MyISAM tables. (295087 lines)
+	Version 19.199:   Apr 4, 2020	Fix: hours are rolled up into sta_hits only when no access in them is waiting in spool, and rolling up an hour again replaces its rows. (295051 lines)
+					1 change necessary in database:
+ALTER TABLE sta_hits DROP INDEX HitHour,ADD UNIQUE INDEX(HitHour,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role);
+
+	Version 19.198:   Apr 4, 2020	Log spool is loaded into database by a housekeeping job, not inside requests. (294992 lines)
+					1 change in installation:
+Accesses in the log spool are loaded into database only by swad_maintenance, which must run as the web server user, because it renames files in Cfg_PATH_LOG_PRIVATE. Run it as a daemon to load them every Cfg_TIME_TO_LOAD_LOG_SPOOL seconds; from cron they are loaded once a minute:
+cd /var/www/cgi-bin && ./swad_maintenance -d
+
+	Version 19.197:   Apr 4, 2020	Fix: swad_push closes connections which have not sent their request after a few seconds. (295007 lines)
+	Version 19.196:   Apr 4, 2020	Benchmark swad_users_bench writes system calls saved per class photo building links to photos. (294982 lines)
+	Version 19.195:   Apr 4, 2020	Removed function Str_GetNextStrFromFileConvertingToLower. (294954 lines)
+	Version 19.194:   Apr 4, 2020	New benchmark swad_output_bench, time to generate and send HTML output in a temporary file and in memory. (294977 lines)
+	Version 19.193:   Apr 4, 2020	Fix: slots of IPs active in the firewall shared table are not reused. New stress test swad_firewall_bench. (294719 lines)
+	Version 19.192:   Apr 4, 2020	Fix: memory is freed when a job of a resident program ends with an error. (294316 lines)
+	Version 19.191:   Apr 3, 2020	Data of senders and recipients of messages got with one query. Fixed bug in received messages deleted by their authors. New benchmark swad_messages_bench. (294310 lines)
+	Version 19.190:   Apr 3, 2020	New benchmark swad_forums_bench with queries to show forums with thousands of threads. (293595 lines)
+	Version 19.189:   Apr 3, 2020	Fix: number of system calls saved is not written in pages. Missing public links to photos are created when upgrading. (293069 lines)
+					1 change necessary in database:
+DELETE FROM hkp_jobs WHERE Job='photo_links';
+					Run swad_maintenance once to create missing public links to users' photos:
+cd /var/www/cgi-bin && ./swad_maintenance -v
+
+	Version 19.188:   Apr 3, 2020	New benchmark swad_users_bench with queries to show a class photo. (293086 lines)
+	Version 19.187:   Apr 3, 2020	Multipart data without final boundary are rejected. Limit of memory for parameters in multipart data. (292737 lines)
+	Version 19.186:   Apr 3, 2020	Fallback to external program when images can not be decoded in-process. Lower limit of pixels. (292701 lines)
+	Version 19.185:   Apr 3, 2020	Fix: ZIP file with assignments and works is not created if it exceeds the limits of size and number of files. (292657 lines)
+	Version 19.184:   Apr 3, 2020	Fix: index of words used in searches is updated when courses, users and files are created, renamed or removed. Full rebuild is now a daily repair job. (292638 lines)
+					2 changes necessary in database:
+ALTER TABLE sch_words ADD INDEX(Type,Cod);
+DROP TABLE IF EXISTS sch_words_new;
+
+	Version 19.183:   Apr 3, 2020	Fix: mails with new passwords are sent at once, not stored in mail queue. Subjects of queued mails are encoded as in RFC 2047. Users are told when a mail is queued, not sent. (292510 lines)
+	Version 19.182:   Apr 3, 2020	Fix: a student's answer to a match question is applied once to tallies and result, even if received twice at the same time. Scores in mch_scores are exact integers. (292359 lines)
+					3 changes necessary in database:
+DROP TABLE IF EXISTS mch_scores;
+CREATE TABLE IF NOT EXISTS mch_scores (MchCod INT NOT NULL,ScaledScore INT NOT NULL,NumUsrs INT NOT NULL DEFAULT 0,UNIQUE INDEX(MchCod,ScaledScore));
+INSERT INTO mch_scores (MchCod,ScaledScore,NumUsrs) SELECT MchCod,ROUND(Score*2520) AS ScaledScore,COUNT(*) FROM mch_results GROUP BY MchCod,ScaledScore;
+
+	Version 19.181:   Apr 3, 2020	Fix: timeout to remove match players does not depend on students' refresh period. New program swad_push_bench. (292260 lines)
+	Version 19.180:   Apr 3, 2020	Fix: number of sessions is updated when a session is created or closed. New program swad_sessions_bench. (291996 lines)
+	Version 19.179:   Apr 3, 2020	Fix: database errors in swad_maintenance and swad_mailer daemons are written to standard error, and daemons reconnect and go on. (291639 lines)
+	Version 19.178:   Apr 3, 2020	Fix: statements are prepared only in persistent workers. New program swad_prepared_bench. (291539 lines)
+	Version 19.177:   Apr 3, 2020	Fix: named locks got with GET_LOCK are released when a request ends with an error. (290997 lines)
+	Version 19.176:   Apr 3, 2020	Fix: filling of timeline inboxes with existing publications in version 19.153 is required. (290960 lines)
+	Version 19.175:   Apr 3, 2020	Fix: end of page is written in the same compressed stream as the rest of the page. (290959 lines)
+	Version 19.174:   Apr 3, 2020	Fix: an interrupted load of log spool goes on from the last batch inserted, and the loader is released on errors. (290937 lines)
+					1 change necessary in database:
+CREATE TABLE IF NOT EXISTS log_spool (Inode BIGINT NOT NULL,CTime BIGINT NOT NULL,Offset BIGINT NOT NULL);
+
+	Version 19.173:   Apr 3, 2020	Fix: slots of banned IPs are never reused in firewall shared table. (290769 lines)
+	Version 19.172:   Apr 3, 2020	Fix: persistent worker frees users' data not freed when a request ends abruptly. New program swad_worker_bench. (290747 lines)
+	Version 19.171:   Apr 2, 2020	Data of messages in a page of received/sent messages are got in one query. (290495 lines)
+	Version 19.170:   Apr 2, 2020	Forum list and thread list get counters and thread data in a few set-based queries. (290413 lines)
+					4 changes necessary in database:
+ALTER TABLE forum_thread ADD COLUMN NumPsts INT NOT NULL DEFAULT 0 AFTER LastPstCod;
+UPDATE forum_thread SET NumPsts=(SELECT COUNT(*) FROM forum_post WHERE forum_post.ThrCod=forum_thread.ThrCod);
+CREATE TABLE IF NOT EXISTS forum_counters (ForumType TINYINT NOT NULL,Location INT NOT NULL DEFAULT -1,NumThrs INT NOT NULL DEFAULT 0,NumPsts INT NOT NULL DEFAULT 0,LastPstTime DATETIME NOT NULL,UNIQUE INDEX(ForumType,Location));
+INSERT INTO forum_counters (ForumType,Location,NumThrs,NumPsts,LastPstTime) SELECT forum_thread.ForumType,IF(forum_thread.ForumType>=8,-1,forum_thread.Location),COUNT(*),SUM(forum_thread.NumPsts),MAX(forum_post.ModifTime) FROM forum_thread,forum_post WHERE forum_thread.LastPstCod=forum_post.PstCod GROUP BY forum_thread.ForumType,IF(forum_thread.ForumType>=8,-1,forum_thread.Location);
+
+	Version 19.169:   Apr 2, 2020	Public links to users' photos are created when photos are received, not when shown. New housekeeping job to repair missing links. (290082 lines)
+	Version 19.168:   Apr 2, 2020	IDs and relations with me of all users in class photos and lists are got at once, in a few queries for the whole list. (290016 lines)
+	Version 19.167:   Apr 1, 2020	Uploaded forms are parsed in large blocks as they arrive and files are moved to their destination. (289685 lines)
+	Version 19.166:   Mar 31, 2020	Images uploaded to timeline, forums and messages are processed in-process with libjpeg, libpng and giflib. (289058 lines)
+	Version 19.165:   Mar 30, 2020	Enhancement filters of fotomaton use lookup tables applied with cv::LUT. (288176 lines)
+	Version 19.164:   Mar 29, 2020	Faces in photos are detected by a resident fotomaton service, with the classifier loaded only once. (288175 lines)
+	Version 19.163:   Mar 28, 2020	ZIP files of folders and works are written by swad, reading files directly, instead of cloning folders and running zip. (288045 lines)
+	Version 19.162:   Mar 27, 2020	Searches of courses, users and documents use an index of folded words rebuilt by swad_housekeeping. (287717 lines)
+					1 change necessary in database:
+CREATE TABLE IF NOT EXISTS sch_words (Type TINYINT NOT NULL,Word VARCHAR(64) NOT NULL,Cod INT NOT NULL,UNIQUE INDEX(Type,Word,Cod));
+
+	Version 19.161:   Mar 26, 2020	Automatic emails stored in a queue and sent by a resident program swad_mailer reusing SMTP connections. (287230 lines)
+					1 change necessary in database:
+CREATE TABLE IF NOT EXISTS mail_queue (QueCod INT NOT NULL AUTO_INCREMENT,E_mail VARCHAR(255) NOT NULL,Subject VARCHAR(1023) NOT NULL,Content LONGTEXT NOT NULL,CreatTime DATETIME NOT NULL,NextTry DATETIME NOT NULL,NumTries INT NOT NULL DEFAULT 0,LastReply VARCHAR(511) NOT NULL DEFAULT '',UNIQUE INDEX(QueCod),INDEX(NextTry));
+					Run swad_mailer as a resident process:
+cd /var/www/cgi-bin && ./swad_mailer -d
+
+	Version 19.160:   Mar 25, 2020	Live tally of answers and scores in matches updated incrementally when a student answers. (286228 lines)
+					4 changes necessary in database:
+CREATE TABLE IF NOT EXISTS mch_tally (MchCod INT NOT NULL,QstInd INT NOT NULL,AnsInd TINYINT NOT NULL,NumUsrs INT NOT NULL DEFAULT 0,UNIQUE INDEX(MchCod,QstInd,AnsInd));
+CREATE TABLE IF NOT EXISTS mch_scores (MchCod INT NOT NULL,Score DOUBLE PRECISION NOT NULL,NumUsrs INT NOT NULL DEFAULT 0,UNIQUE INDEX(MchCod,Score));
+INSERT INTO mch_tally (MchCod,QstInd,AnsInd,NumUsrs) SELECT MchCod,QstInd,AnsInd,COUNT(*) FROM mch_answers GROUP BY MchCod,QstInd,AnsInd;
+INSERT INTO mch_scores (MchCod,Score,NumUsrs) SELECT MchCod,Score,COUNT(*) FROM mch_results GROUP BY MchCod,Score;
+
+	Version 19.159:   Mar 24, 2020	Status of matches pushed to students from a resident server swad_push (Server-Sent Events). (285993 lines)
+					Run swad_push as a resident process and add to Apache configuration:
+ProxyPass /swad-push http://127.0.0.1:8081/ flushpackets=on
+
+	Version 19.158:   Mar 23, 2020	Expired sessions and old connected users are removed by swad_maintenance, not in every request. (285382 lines)
+					3 changes necessary in database:
+ALTER TABLE sessions ADD COLUMN Expire DATETIME NOT NULL AFTER LastRefresh,ADD INDEX(Expire);
+UPDATE sessions SET Expire=LastTime+INTERVAL 8 HOUR;
+CREATE TABLE IF NOT EXISTS sessions_count (Id TINYINT NOT NULL DEFAULT 0,NumSessions INT NOT NULL DEFAULT 0,UNIQUE INDEX(Id));
+
+	Version 19.157:   Mar 22, 2020	Housekeeping jobs are run by a new program swad_maintenance, not by users' requests. (285303 lines)
+					1 change necessary in database:
+CREATE TABLE IF NOT EXISTS hkp_jobs (Job VARCHAR(32) NOT NULL,LastRun DATETIME NOT NULL,NumRuns INT NOT NULL DEFAULT 0,LastTimeUs BIGINT NOT NULL DEFAULT 0,MaxTimeUs BIGINT NOT NULL DEFAULT 0,TotalTimeUs BIGINT NOT NULL DEFAULT 0,UNIQUE INDEX(Job));
+					1 change necessary in crontab:
+* * * * * cd /var/www/cgi-bin && ./swad_maintenance
+
+	Version 19.156:   Mar 21, 2020	Prepared statements for the most frequent queries. (284990 lines)
+	Version 19.155:   Mar 20, 2020	Detailed list of clicks paginated using log codes, without getting all the clicks. (284666 lines)
+	Version 19.154:   Mar 19, 2020	Statistics of hits got from a table with hits per hour, when possible. (284517 lines)
+					2 changes necessary in database:
+CREATE TABLE IF NOT EXISTS sta_hits (HitHour DATETIME NOT NULL,ActCod INT NOT NULL,CtyCod INT NOT NULL,InsCod INT NOT NULL,CtrCod INT NOT NULL,DegCod INT NOT NULL,CrsCod INT NOT NULL,Role TINYINT NOT NULL,NumHits INT NOT NULL,TimeToGenerate BIGINT NOT NULL,TimeToSend BIGINT NOT NULL,INDEX(HitHour));
+CREATE TABLE IF NOT EXISTS sta_hits_range (FirstHour DATETIME NOT NULL,EndHour DATETIME NOT NULL);
+					Optional, after the first roll up, to add historical hits (slow):
+INSERT INTO sta_hits (HitHour,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role,NumHits,TimeToGenerate,TimeToSend) SELECT DATE_FORMAT(ClickTime,'%Y-%m-%d %H:00:00') AS Hour,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role,COUNT(*),SUM(TimeToGenerate),SUM(TimeToSend) FROM log_full WHERE ClickTime<(SELECT FirstHour FROM sta_hits_range) GROUP BY Hour,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role;
+UPDATE sta_hits_range SET FirstHour=(SELECT DATE_FORMAT(MIN(ClickTime),'%Y-%m-%d %H:00:00') FROM log_full);
+
+	Version 19.153:   Mar 18, 2020	Publications of followed users are pushed to timeline inboxes when published. (284138 lines)
+					4 changes necessary in database:
+CREATE TABLE IF NOT EXISTS tl_inboxes (UsrCod INT NOT NULL,PubCod BIGINT NOT NULL,NotCod BIGINT NOT NULL,UNIQUE INDEX(UsrCod,PubCod));
+CREATE TABLE IF NOT EXISTS tl_pull_publishers (UsrCod INT NOT NULL,UNIQUE INDEX(UsrCod));
+					Required, to fill inboxes with existing publications (users would not see them in timeline):
+INSERT IGNORE INTO tl_inboxes (UsrCod,PubCod,NotCod) SELECT PublisherCod,PubCod,NotCod FROM tl_pubs;
+INSERT IGNORE INTO tl_inboxes (UsrCod,PubCod,NotCod) SELECT usr_follow.FollowerCod,tl_pubs.PubCod,tl_pubs.NotCod FROM usr_follow,tl_pubs WHERE tl_pubs.PublisherCod=usr_follow.FollowedCod;
+
+	Version 19.152:   Mar 17, 2020	Publications in timeline are got in batches, without temporary tables. (283933 lines)
+	Version 19.151:   Mar 16, 2020	Pages are sent compressed with gzip to browsers accepting it. Size of pages is logged. (283963 lines)
+					2 changes necessary in database (may spend many minutes depending on the size of log tables):
+ALTER TABLE log_full ADD COLUMN BytesGenerated INT NOT NULL DEFAULT 0 AFTER TimeToSend,ADD COLUMN BytesSent INT NOT NULL DEFAULT 0 AFTER BytesGenerated;
+ALTER TABLE log_recent ADD COLUMN BytesGenerated INT NOT NULL DEFAULT 0 AFTER TimeToSend,ADD COLUMN BytesSent INT NOT NULL DEFAULT 0 AFTER BytesGenerated;
+
+	Version 19.150:   Mar 15, 2020	HTML output is written in a buffer in memory instead of a temporary file. Large pages are sent in pieces. (283779 lines)
+	Version 19.149:   Mar 14, 2020	Accesses are appended to a spool file and inserted into database in batches. (283679 lines)
+					1 change in installation:
+The folder Cfg_PATH_LOG_PRIVATE (by default /var/www/swad/log) is created automatically and must be writable by the web server user.
+Accesses appear in statistics and in "last clicks" with a delay of a few seconds (Cfg_TIME_TO_LOAD_LOG_SPOOL).
+
+	Version 19.148:   Mar 13, 2020	Clicks per IP counted in shared memory instead of table firewall_log. (283121 lines)
+					1 change in installation:
+The shared memory object /dev/shm/swad_firewall is created automatically by the first request. If it can not be created, table firewall_log is used as before.
+
+	Version 19.147:   Mar 13, 2020	Persistent FastCGI worker mode, serving many requests per process. (282785 lines)
+					1 change in installation:
+It's necessary to install libfcgi (sudo apt install libfcgi-dev) to compile SWAD.
+SWAD still works as a classic CGI. To run it as a persistent FastCGI worker, use for example Apache mod_fcgid with:
+<Directory /usr/lib/cgi-bin/swad>
+	SetHandler fcgid-script
+	Options +ExecCGI
+</Directory>
+Web service requests (plugins, mobile app) must continue to be sent to the classic CGI.
+
 	Version 19.146:   Mar 12, 2020	Background and changes in layout of matches. (282484 lines)
 					Copy the following background image to icon public directory:
 sudo cp icon/bg.jpg /var/www/html/swad/icon/
@@ -267,6 +267,14 @@
 /* Courses */
 #define Cfg_MIN_NUM_COURSES_TO_CONFIRM_SHOW_BIG_LIST     500	// If the number of courses in a list is greater than this, ask me for confirmation before showing the list
 
+/* Persistent FastCGI worker */
+#define Cfg_MAX_REQUESTS_PER_WORKER			10000	// A worker exits after serving these requests, to limit effects of memory leaks
+
+/* HTML output */
+#define Cfg_BYTES_TO_FLUSH_HTML_OUTPUT		(64UL * 1024UL)	// Once the head of a page is sent, the output is sent when the buffer is larger than this. 0 ==> the page is sent at the end
+#define Cfg_HTML_OUTPUT_COMPRESSION_LEVEL	6	// Compression level of pages sent with gzip to browsers accepting it. 1 (fastest) to 9 (best). 0 ==> no compression
+#define Cfg_ZIP_COMPRESSION_LEVEL		5	// Compression level of files in ZIP files created when downloading folders. 1 (fastest) to 9 (best)
+
 /*****************************************************************************/
 /*********************** Directories, folder and files ***********************/
 /*****************************************************************************/
@@ -368,10 +376,18 @@
 #define Cfg_FOLDER_MARK				"mark"			// Created automatically the first time it is accessed
 #define Cfg_PATH_MARK_PRIVATE			Cfg_PATH_SWAD_PRIVATE "/" Cfg_FOLDER_MARK
 
+/* Folder for files being uploaded, before moving them to their destination, inside private swad directory */
+#define Cfg_FOLDER_UPLOAD			"upload"		// Created automatically the first time it is accessed
+#define Cfg_PATH_UPLOAD_PRIVATE			Cfg_PATH_SWAD_PRIVATE "/" Cfg_FOLDER_UPLOAD
+
 /* Folder for temporary XML files received to import test questions, inside private swad directory */
 #define Cfg_FOLDER_TEST				"test"			// Created automatically the first time it is accessed
 #define Cfg_PATH_TEST_PRIVATE			Cfg_PATH_SWAD_PRIVATE "/" Cfg_FOLDER_TEST
 
+/* Folder for the spool of accesses pending to be inserted into database log, inside private swad directory */
+#define Cfg_FOLDER_LOG				"log"			// Created automatically the first time it is accessed
+#define Cfg_PATH_LOG_PRIVATE			Cfg_PATH_SWAD_PRIVATE "/" Cfg_FOLDER_LOG
+
 /* Folder for compression of assignments and works into a zip files, inside private swad directory */
 #define Cfg_FOLDER_ZIP				"zip"			// Created automatically the first time it is accessed
 #define Cfg_PATH_ZIP_PRIVATE			Cfg_PATH_SWAD_PRIVATE "/" Cfg_FOLDER_ZIP
@@ -459,6 +475,39 @@
 /* Comment the following line if you do not want a local copy of MathJax */
 #define Cfg_MATHJAX_LOCAL
 
+/*****************************************************************************/
+/********************* Push of match status to students **********************/
+/*****************************************************************************/
+
+/* Comment the following line if you do not want to push status of matches to students.
+   In that case, students' browsers will poll the server every few seconds.
+   swad_push must be running,
+   and the web server must forward Cfg_URL_MATCH_PUSH to it, for example in Apache:
+   ProxyPass /swad-push http://127.0.0.1:8081/ flushpackets=on */
+#define Cfg_MATCH_PUSH
+
+#define Cfg_URL_MATCH_PUSH				"/swad-push"	// URL where browsers subscribe to changes in a match
+#define Cfg_PORT_MATCH_PUSH_HTTP			8081		// TCP port in localhost where swad_push receives connections from browsers
+#define Cfg_PORT_MATCH_PUSH_NOTIFY			8082		// UDP port in localhost where swad_push receives changes in matches
+#define Cfg_MAX_MATCH_PUSH_CLIENTS			4096		// Maximum number of browsers connected simultaneously to swad_push
+#define Cfg_MAX_MATCH_PUSH_MATCHES			256		// Maximum number of matches whose status is remembered by swad_push
+
+/*****************************************************************************/
+/******************************* Queue of mails ******************************/
+/*****************************************************************************/
+
+/* Comment the following line if you want this CGI to call Cfg_COMMAND_SEND_AUTOMATIC_EMAIL
+   for every automatic email, instead of storing emails in a queue in database.
+   If not commented, swad_mailer must be running as a resident process:
+   cd /var/www/cgi-bin && ./swad_mailer -d */
+#define Cfg_MAIL_QUEUE
+
+#define Cfg_MAIL_QUEUE_DAEMON_SLEEP			((time_t)(                      5UL))	// swad_mailer checks the queue every these seconds
+#define Cfg_MAIL_QUEUE_MAILS_PER_BATCH			 100	// Mails got from database each time
+#define Cfg_MAIL_QUEUE_MAILS_PER_CONNECTION		 500	// A new connection to SMTP server is opened after sending these mails
+#define Cfg_MAIL_QUEUE_MAX_TRIES			   8	// A mail is discarded after these failed tries
+#define Cfg_MAIL_QUEUE_FIRST_RETRY			((time_t)(                     60UL))	// After first failed try, a mail is tried again after these seconds, doubled after each try
+
 /*****************************************************************************/
 /************************ Commands called by this CGI ************************/
 /*****************************************************************************/
@@ -470,6 +519,14 @@
 // %s must be substituted by temporary file with the image received:
 #define Cfg_COMMAND_FACE_DETECTION			"./fotomaton cascade.xml %s 540"
 
+/* Unix socket of resident face detection service.
+   It should be launched once, from the CGI directory, as:
+   ./fotomaton -s fotomaton.sock cascade.xml 540
+   The classifier is loaded only once, instead of once per photo.
+   When the service is not running, Cfg_COMMAND_FACE_DETECTION is called.
+   Comment this line if you don't want to use the service */
+#define Cfg_FACE_DETECTION_SOCKET			"./fotomaton.sock"
+
 /* Commands to compute the average photo of a degree */
 #define Cfg_COMMAND_DEGREE_PHOTO_MEDIAN			"./foto_mediana"
 #define Cfg_COMMAND_DEGREE_PHOTO_AVERAGE		"./foto_promedio"
@@ -486,6 +543,11 @@
 
 #define Cfg_DAYS_IN_RECENT_LOG				 15	// Only accesses in these last days + 1 are stored in recent log.
 								// Important!!! Must be 1 <= Cfg_DAYS_IN_RECENT_LOG <= 29
+#define Cfg_TIME_TO_LOAD_LOG_SPOOL			((time_t)(                      5UL))	// Accesses in spool are inserted into database log after these seconds
+#define Cfg_TIME_TO_WAIT_TO_ROLL_UP_HITS		((time_t)(              5UL * 60UL))	// Hits in an hour are added to statistics table these seconds after the end of the hour
+#define Cfg_MAX_HOURS_TO_ROLL_UP_HITS			 24	// Maximum number of hours added to statistics table in each roll up
+#define Cfg_MAX_ROWS_TO_DELETE_IN_A_BATCH		1000	// Old rows are deleted in batches of this size to avoid long locks
+#define Cfg_HOUSEKEEPING_DAEMON_SLEEP			Cfg_TIME_TO_LOAD_LOG_SPOOL		// When swad_maintenance runs as a daemon, it checks pending jobs every these seconds. Not longer than the shortest interval of a job
 #define Cfg_TIMES_PER_SECOND_REFRESH_CONNECTED		  2	// Execute this CGI to refresh connected users about these times per second
 #define Cfg_MIN_TIME_TO_REFRESH_CONNECTED		((time_t)(                     60UL))	// Refresh period of connected users in seconds
 #define Cfg_MAX_TIME_TO_REFRESH_CONNECTED		((time_t)(              15UL * 60UL))	// Refresh period of connected users in seconds
@@ -494,11 +556,24 @@
 
 #define Cfg_TIME_TO_REFRESH_TIMELINE			((time_t)(             2UL * 1000UL))	// Initial refresh period of social timeline in miliseconds
 												// This delay is increased 1 second on each refresh
+#define Cfg_TIMELINE_FAN_OUT_ON_WRITE			true	// true  ==> each new publication is pushed to the inboxes of followers
+								// false ==> timeline of followed users is got from all publications when reading
+#define Cfg_TIMELINE_MAX_FOLLOWERS_TO_FAN_OUT		1000	// Publications of users with more followers are not pushed to inboxes, but got when reading
 
 #define Cfg_SECONDS_TO_REFRESH_MATCH_TCH		1					// Refresh period of match being played in seconds (for teachers)
-#define Cfg_SECONDS_TO_REFRESH_MATCH_STD		3					// Refresh period of match being played in seconds (for students)
+#define Cfg_SECONDS_TO_POLL_MATCH_STD			3					// Refresh period of match being played in seconds (for students), when status is not pushed
+#ifdef Cfg_MATCH_PUSH
+#define Cfg_SECONDS_TO_REFRESH_MATCH_STD		10					// Status is pushed to students, so they refresh only to keep on being players
+#else
+#define Cfg_SECONDS_TO_REFRESH_MATCH_STD		Cfg_SECONDS_TO_POLL_MATCH_STD		// Refresh period of match being played in seconds (for students)
+#endif
+#define Cfg_SECONDS_TO_REMOVE_MATCH_PLAYER		15					// A student who has not refreshed a match in these seconds is no longer a player
+#if Cfg_SECONDS_TO_REMOVE_MATCH_PLAYER <= Cfg_SECONDS_TO_REFRESH_MATCH_STD
+#error "Students would be removed from match before refreshing it"
+#endif
 #define Cfg_TIME_TO_REFRESH_MATCH_TCH			((time_t)(Cfg_SECONDS_TO_REFRESH_MATCH_TCH * 1000UL))	// Refresh period of match being played in miliseconds (for teachers)
 #define Cfg_TIME_TO_REFRESH_MATCH_STD			((time_t)(Cfg_SECONDS_TO_REFRESH_MATCH_STD * 1000UL))	// Refresh period of match being played in miliseconds (for students)
+#define Cfg_TIME_TO_POLL_MATCH_STD			((time_t)(Cfg_SECONDS_TO_POLL_MATCH_STD    * 1000UL))	// Refresh period of match being played in miliseconds (for students), when status is not pushed
 
 #define Cfg_TIME_TO_REFRESH_LAST_CLICKS			((time_t)(             1UL * 1000UL))	// Refresh period of last clicks in miliseconds
 
@@ -510,6 +585,7 @@
 #define Cfg_TIME_TO_DELETE_HTML_OUTPUT			((time_t)(              30UL * 60UL))	// Remove the HTML output files older than these seconds
 
 #define Cfg_TIME_TO_ABORT_FILE_UPLOAD			((time_t)(              55UL * 60UL))	// After these seconds uploading data, abort upload.
+#define Cfg_TIME_TO_DELETE_UPLOAD_TMP_FILES		((time_t)(        2UL * 60UL * 60UL))  	// Files being uploaded not moved to their destination are deleted after these seconds
 
 #define Cfg_TIME_TO_DELETE_BROWSER_TMP_FILES		((time_t)(        2UL * 60UL * 60UL))  	// Temporary files are deleted after these seconds
 #define Cfg_TIME_TO_DELETE_BROWSER_EXPANDED_FOLDERS	((time_t)( 7UL * 24UL * 60UL * 60UL))	// Past these seconds, remove expired expanded folders
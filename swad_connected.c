@@ -429,14 +429,14 @@ void Con_UpdateMeInConnectedList (void)
   {
    /***** Update my entry in connected list.
           The role which is stored is the role of the last click *****/
-   DB_QueryREPLACE ("can not update list of connected users",
-		    "REPLACE INTO connected"
-		    " (UsrCod,RoleInLastCrs,LastCrsCod,LastTime)"
-		    " VALUES"
-		    " (%ld,%u,%ld,NOW())",
-                    Gbl.Usrs.Me.UsrDat.UsrCod,
-                    (unsigned) Gbl.Usrs.Me.Role.Logged,
-                    Gbl.Hierarchy.Crs.CrsCod);
+   DB_QueryREPLACEprepared ("can not update list of connected users",
+			    "REPLACE INTO connected"
+			    " (UsrCod,RoleInLastCrs,LastCrsCod,LastTime)"
+			    " VALUES"
+			    " (%ld,%u,%ld,NOW())",
+			    Gbl.Usrs.Me.UsrDat.UsrCod,
+			    (unsigned) Gbl.Usrs.Me.Role.Logged,
+			    Gbl.Hierarchy.Crs.CrsCod);
   }
 
 /*****************************************************************************/
@@ -451,6 +451,22 @@ void Con_RemoveOldConnected (void)
 		   " (SELECT DISTINCT(UsrCod) FROM sessions)");
   }
 
+/*****************************************************************************/
+/********** Remove a user from connected list if user has no sessions ********/
+/*****************************************************************************/
+
+void Con_RemoveUsrIfNoSessions (long UsrCod)
+  {
+   /***** Remove user from connected list *****/
+   DB_QueryDELETEprepared ("can not remove a user from list of connected users",
+			   "DELETE FROM connected"
+			   " WHERE UsrCod=%ld"
+			   " AND UsrCod NOT IN"
+			   " (SELECT UsrCod FROM sessions WHERE UsrCod=%ld)",
+			   UsrCod,
+			   UsrCod);
+  }
+
 /*****************************************************************************/
 /********************* Get connected users with a role ***********************/
 /*****************************************************************************/
@@ -462,10 +478,10 @@ static unsigned Con_GetConnectedUsrsTotal (Rol_Role_t Role)
 
    /***** Get number of connected users with a role from database *****/
    return
-   (unsigned) DB_QueryCOUNT ("can not get number of connected users",
-			     "SELECT COUNT(*) FROM connected"
-			     " WHERE RoleInLastCrs=%u",
-			     (unsigned) Role);
+   (unsigned) DB_QueryCOUNTprepared ("can not get number of connected users",
+				     "SELECT COUNT(*) FROM connected"
+				     " WHERE RoleInLastCrs=%u",
+				     (unsigned) Role);
   }
 
 /*****************************************************************************/
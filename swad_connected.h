@@ -56,6 +56,7 @@ void Con_ComputeConnectedUsrsBelongingToCurrentCrs (void);
 void Con_ShowConnectedUsrsBelongingToCurrentCrs (void);
 void Con_UpdateMeInConnectedList (void);
 void Con_RemoveOldConnected (void);
+void Con_RemoveUsrIfNoSessions (long UsrCod);
 
 void Con_WriteScriptClockConnected (void);
 
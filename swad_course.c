@@ -40,6 +40,7 @@
 #include "swad_HTML.h"
 #include "swad_info.h"
 #include "swad_logo.h"
+#include "swad_search.h"
 
 /*****************************************************************************/
 /************** External global variables from others modules ****************/
@@ -1591,6 +1592,9 @@ static void Crs_CreateCourse (unsigned Status)
 				Gbl.Usrs.Me.UsrDat.UsrCod,
 				Crs_EditingCrs->ShrtName,
 				Crs_EditingCrs->FullName);
+
+   /***** Add course to index of words used in searches *****/
+   Sch_UpdateIndexOfCrs (Crs_EditingCrs->CrsCod,Crs_EditingCrs->FullName);
   }
 
 /*****************************************************************************/
@@ -1778,6 +1782,9 @@ void Crs_RemoveCourseCompletely (long CrsCod)
       DB_QueryDELETE ("can not remove a course",
 		      "DELETE FROM courses WHERE CrsCod=%ld",
 		      CrsCod);
+
+      /***** Remove course from index of words used in searches *****/
+      Sch_RemoveFromIndex (Sch_INDEX_COURSES,CrsCod);
      }
   }
 
@@ -2199,6 +2206,10 @@ static void Crs_UpdateCrsNameDB (long CrsCod,const char *FieldName,const char *N
    DB_QueryUPDATE ("can not update the name of a course",
 		   "UPDATE courses SET %s='%s' WHERE CrsCod=%ld",
 	           FieldName,NewCrsName,CrsCod);
+
+   /***** Update index of words used in searches *****/
+   if (!strcmp (FieldName,"FullName"))
+      Sch_UpdateIndexOfCrs (CrsCod,NewCrsName);
   }
 
 /*****************************************************************************/
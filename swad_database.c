@@ -30,14 +30,16 @@
 #include <mysql/mysql.h>	// To access MySQL databases
 #include <stdarg.h>		// For va_start, va_end
 #include <stddef.h>		// For NULL
-#include <stdio.h>		// For FILE, vasprintf
+#include <stdio.h>		// For FILE, open_memstream, vasprintf
 #include <stdlib.h>		// For free
+#include <string.h>		// For strlen
 
 #include "swad_config.h"
 #include "swad_database.h"
 #include "swad_global.h"
 #include "swad_HTML.h"
 #include "swad_language.h"
+#include "swad_worker.h"
 
 /*****************************************************************************/
 /************** External global variables from others modules ****************/
@@ -45,10 +47,49 @@
 
 extern struct Globals Gbl;
 
+/*****************************************************************************/
+/***************************** Private constants *****************************/
+/*****************************************************************************/
+
+#define DB_MAX_PREPARED_STMTS	64	// Maximum number of prepared statements kept by a process
+#define DB_MAX_PARAMS_IN_STMT	32	// Maximum number of parameters in a prepared statement
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   DB_PARAM_LONG,		// %ld
+   DB_PARAM_UNSIGNED_LONG,	// %lu
+   DB_PARAM_INT,		// %d
+   DB_PARAM_UNSIGNED,		// %u
+   DB_PARAM_STRING,		// %s or '%s'
+  } DB_ParamType_t;
+
+struct DB_PreparedStmt
+  {
+   const char *Format;		// Format string used as key
+   MYSQL_STMT *Stmt;
+   unsigned NumParams;
+   DB_ParamType_t ParamTypes[DB_MAX_PARAMS_IN_STMT];
+  };
+
 /*****************************************************************************/
 /************************* Private global variables **************************/
 /*****************************************************************************/
 
+/* Cache of prepared statements.
+   A persistent worker prepares each statement only once */
+static struct
+  {
+   unsigned Num;
+   struct DB_PreparedStmt Lst[DB_MAX_PREPARED_STMTS];
+  } DB_PreparedStmts =
+  {
+   .Num = 0,
+  };
+
 /*****************************************************************************/
 /***************************** Private prototypes ****************************/
 /*****************************************************************************/
@@ -58,6 +99,17 @@ static unsigned long DB_QuerySELECTusingQueryStr (char *Query,
 					          MYSQL_RES **mysql_res,
 						  const char *MsgError);
 
+static char *DB_BuildQueryFromStmtFormat (const char *fmt,va_list ap);
+static struct DB_PreparedStmt *DB_ExecutePreparedStmt (const char *MsgError,
+                                                       const char *fmt,va_list ap);
+static struct DB_PreparedStmt *DB_GetPreparedStmt (const char *MsgError,
+                                                   const char *fmt);
+static void DB_PrepareStmt (struct DB_PreparedStmt *PreparedStmt,
+                            const char *MsgError,const char *fmt);
+static void DB_FreePreparedStmt (struct DB_PreparedStmt *PreparedStmt);
+static void DB_ClosePreparedStmts (void);
+static void DB_ExitOnStmtError (const char *Message,MYSQL_STMT *Stmt);
+
 /*****************************************************************************/
 /***************************** Database tables *******************************/
 /*****************************************************************************/
@@ -1193,6 +1245,28 @@ mysql> DESCRIBE firewall_log;
 		   "INDEX(ClickTime),"
 		   "INDEX(IP))");
 
+   /***** Table forum_counters *****/
+/*
+mysql> DESCRIBE forum_counters;
++-------------+------------+------+-----+---------+-------+
+| Field       | Type       | Null | Key | Default | Extra |
++-------------+------------+------+-----+---------+-------+
+| ForumType   | tinyint(4) | NO   | PRI | NULL    |       |
+| Location    | int(11)    | NO   | PRI | -1      |       |
+| NumThrs     | int(11)    | NO   |     | 0       |       |
+| NumPsts     | int(11)    | NO   |     | 0       |       |
+| LastPstTime | datetime   | NO   |     | NULL    |       |
++-------------+------------+------+-----+---------+-------+
+5 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS forum_counters ("
+			"ForumType TINYINT NOT NULL,"
+			"Location INT NOT NULL DEFAULT -1,"
+			"NumThrs INT NOT NULL DEFAULT 0,"
+			"NumPsts INT NOT NULL DEFAULT 0,"
+			"LastPstTime DATETIME NOT NULL,"
+		   "UNIQUE INDEX(ForumType,Location))");
+
    /***** Table forum_disabled_post *****/
 /*
 mysql> DESCRIBE forum_disabled_post;
@@ -1294,8 +1368,9 @@ mysql> DESCRIBE forum_thread;
 | Location    | int(11)    | NO   | MUL | -1      |                |
 | FirstPstCod | int(11)    | NO   | UNI | NULL    |                |
 | LastPstCod  | int(11)    | NO   | UNI | NULL    |                |
+| NumPsts     | int(11)    | NO   |     | 0       |                |
 +-------------+------------+------+-----+---------+----------------+
-5 rows in set (0.00 sec)
+6 rows in set (0.00 sec)
 */
    DB_CreateTable ("CREATE TABLE IF NOT EXISTS forum_thread ("
 			"ThrCod INT NOT NULL AUTO_INCREMENT,"
@@ -1303,6 +1378,7 @@ mysql> DESCRIBE forum_thread;
 			"Location INT NOT NULL DEFAULT -1,"
 			"FirstPstCod INT NOT NULL,"
 			"LastPstCod INT NOT NULL,"
+			"NumPsts INT NOT NULL DEFAULT 0,"
 		   "UNIQUE INDEX(ThrCod),"
 		   "INDEX(ForumType),"
 		   "INDEX(Location),"
@@ -1494,6 +1570,44 @@ mysql> DESCRIBE mch_results;
 			"Score DOUBLE PRECISION NOT NULL DEFAULT 0,"
 		   "UNIQUE INDEX(MchCod,UsrCod))");
 
+   /***** Table mch_scores *****/
+/*
+mysql> DESCRIBE mch_scores;
++-------------+---------+------+-----+---------+-------+
+| Field       | Type    | Null | Key | Default | Extra |
++-------------+---------+------+-----+---------+-------+
+| MchCod      | int(11) | NO   | PRI | NULL    |       |
+| ScaledScore | int(11) | NO   | PRI | NULL    |       |
+| NumUsrs     | int(11) | NO   |     | 0       |       |
++-------------+---------+------+-----+---------+-------+
+3 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS mch_scores ("
+			"MchCod INT NOT NULL,"
+			"ScaledScore INT NOT NULL,"	// Score * 2520
+			"NumUsrs INT NOT NULL DEFAULT 0,"
+		   "UNIQUE INDEX(MchCod,ScaledScore))");
+
+   /***** Table mch_tally *****/
+/*
+mysql> DESCRIBE mch_tally;
++---------+------------+------+-----+---------+-------+
+| Field   | Type       | Null | Key | Default | Extra |
++---------+------------+------+-----+---------+-------+
+| MchCod  | int(11)    | NO   | PRI | NULL    |       |
+| QstInd  | int(11)    | NO   | PRI | NULL    |       |
+| AnsInd  | tinyint(4) | NO   | PRI | NULL    |       |
+| NumUsrs | int(11)    | NO   |     | 0       |       |
++---------+------------+------+-----+---------+-------+
+4 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS mch_tally ("
+			"MchCod INT NOT NULL,"
+			"QstInd INT NOT NULL,"
+			"AnsInd TINYINT NOT NULL,"
+			"NumUsrs INT NOT NULL DEFAULT 0,"
+		   "UNIQUE INDEX(MchCod,QstInd,AnsInd))");
+
    /***** Table gam_questions *****/
 /*
 mysql> DESCRIBE gam_questions;
@@ -1549,6 +1663,30 @@ mysql> DESCRIBE hidden_params;
 			"ParamValue LONGTEXT NOT NULL,"
 		   "INDEX(SessionId))");
 
+   /***** Table hkp_jobs *****/
+/*
+mysql> DESCRIBE hkp_jobs;
++-------------+-------------+------+-----+---------+-------+
+| Field       | Type        | Null | Key | Default | Extra |
++-------------+-------------+------+-----+---------+-------+
+| Job         | varchar(32) | NO   | PRI | NULL    |       |
+| LastRun     | datetime    | NO   |     | NULL    |       |
+| NumRuns     | int(11)     | NO   |     | 0       |       |
+| LastTimeUs  | bigint(20)  | NO   |     | 0       |       |
+| MaxTimeUs   | bigint(20)  | NO   |     | 0       |       |
+| TotalTimeUs | bigint(20)  | NO   |     | 0       |       |
++-------------+-------------+------+-----+---------+-------+
+6 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS hkp_jobs ("
+			"Job VARCHAR(32) NOT NULL,"
+			"LastRun DATETIME NOT NULL,"
+			"NumRuns INT NOT NULL DEFAULT 0,"
+			"LastTimeUs BIGINT NOT NULL DEFAULT 0,"
+			"MaxTimeUs BIGINT NOT NULL DEFAULT 0,"
+			"TotalTimeUs BIGINT NOT NULL DEFAULT 0,"
+		   "UNIQUE INDEX(Job))");
+
    /***** Table holidays *****/
 /*
 mysql> DESCRIBE holidays;
@@ -1677,9 +1815,11 @@ mysql> DESCRIBE log_full;
 | ClickTime      | datetime   | NO   | MUL | NULL    |                |
 | TimeToGenerate | int(11)    | NO   |     | NULL    |                |
 | TimeToSend     | int(11)    | NO   |     | NULL    |                |
+| BytesGenerated | int(11)    | NO   |     | 0       |                |
+| BytesSent      | int(11)    | NO   |     | 0       |                |
 | IP             | char(15)   | NO   |     | NULL    |                |
 +----------------+------------+------+-----+---------+----------------+
-13 rows in set (0.01 sec)
+15 rows in set (0.01 sec)
 */
 // TODO: Change NtfCod and LogCod from INT to BIGINT in database tables.
    DB_CreateTable ("CREATE TABLE IF NOT EXISTS log ("
@@ -1695,6 +1835,8 @@ mysql> DESCRIBE log_full;
 			"ClickTime DATETIME NOT NULL,"
 			"TimeToGenerate INT NOT NULL,"
 			"TimeToSend INT NOT NULL,"
+			"BytesGenerated INT NOT NULL DEFAULT 0,"
+			"BytesSent INT NOT NULL DEFAULT 0,"
 			"IP CHAR(15) NOT NULL,"	// Cns_MAX_BYTES_IP
 		   "UNIQUE INDEX(LogCod),"
 		   "INDEX(ActCod),"
@@ -1724,9 +1866,11 @@ mysql> DESCRIBE log_recent;
 | ClickTime      | datetime   | NO   | MUL | NULL    |       |
 | TimeToGenerate | int(11)    | NO   |     | NULL    |       |
 | TimeToSend     | int(11)    | NO   |     | NULL    |       |
+| BytesGenerated | int(11)    | NO   |     | 0       |       |
+| BytesSent      | int(11)    | NO   |     | 0       |       |
 | IP             | char(15)   | NO   |     | NULL    |       |
 +----------------+------------+------+-----+---------+-------+
-13 rows in set (0.01 sec)
+15 rows in set (0.01 sec)
 */
 // TODO: Change NtfCod and LogCod from INT to BIGINT in database tables.
    DB_CreateTable ("CREATE TABLE IF NOT EXISTS log_recent ("
@@ -1742,6 +1886,8 @@ mysql> DESCRIBE log_recent;
 			"ClickTime DATETIME NOT NULL,"
 			"TimeToGenerate INT NOT NULL,"
 			"TimeToSend INT NOT NULL,"
+			"BytesGenerated INT NOT NULL DEFAULT 0,"
+			"BytesSent INT NOT NULL DEFAULT 0,"
 			"IP CHAR(15) NOT NULL,"	// Cns_MAX_BYTES_IP
 		   "UNIQUE INDEX(LogCod),"
 		   "INDEX(ActCod),"
@@ -1769,6 +1915,23 @@ mysql> DESCRIBE log_search;
 			"SearchStr VARCHAR(2047) NOT NULL,"	// Sch_MAX_BYTES_STRING_TO_FIND
 		   "UNIQUE INDEX(LogCod))");
 
+   /***** Table log_spool *****/
+/*
+mysql> DESCRIBE log_spool;
++--------+------------+------+-----+---------+-------+
+| Field  | Type       | Null | Key | Default | Extra |
++--------+------------+------+-----+---------+-------+
+| Inode  | bigint(20) | NO   |     | NULL    |       |
+| CTime  | bigint(20) | NO   |     | NULL    |       |
+| Offset | bigint(20) | NO   |     | NULL    |       |
++--------+------------+------+-----+---------+-------+
+3 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS log_spool ("
+			"Inode BIGINT NOT NULL,"
+			"CTime BIGINT NOT NULL,"
+			"Offset BIGINT NOT NULL)");
+
    /***** Table log_ws *****/
 /*
 mysql> DESCRIBE log_ws;
@@ -1809,6 +1972,35 @@ mysql> DESCRIBE mail_domains;
 		   "UNIQUE INDEX(MaiCod),"
 		   "UNIQUE INDEX(Domain))");
 
+   /***** Table mail_queue *****/
+/*
+mysql> DESCRIBE mail_queue;
++-----------+---------------+------+-----+---------+----------------+
+| Field     | Type          | Null | Key | Default | Extra          |
++-----------+---------------+------+-----+---------+----------------+
+| QueCod    | int(11)       | NO   | PRI | NULL    | auto_increment |
+| E_mail    | varchar(255)  | NO   |     | NULL    |                |
+| Subject   | varchar(1023) | NO   |     | NULL    |                |
+| Content   | longtext      | NO   |     | NULL    |                |
+| CreatTime | datetime      | NO   |     | NULL    |                |
+| NextTry   | datetime      | NO   | MUL | NULL    |                |
+| NumTries  | int(11)       | NO   |     | 0       |                |
+| LastReply | varchar(511)  | NO   |     |         |                |
++-----------+---------------+------+-----+---------+----------------+
+8 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS mail_queue ("
+			"QueCod INT NOT NULL AUTO_INCREMENT,"
+			"E_mail VARCHAR(255) NOT NULL,"		// Cns_MAX_BYTES_EMAIL_ADDRESS
+			"Subject VARCHAR(1023) NOT NULL,"	// Mai_MAX_BYTES_SUBJECT
+			"Content LONGTEXT NOT NULL,"
+			"CreatTime DATETIME NOT NULL,"
+			"NextTry DATETIME NOT NULL,"
+			"NumTries INT NOT NULL DEFAULT 0,"
+			"LastReply VARCHAR(511) NOT NULL DEFAULT '',"	// SMTP_MAX_BYTES_REPLY
+		   "UNIQUE INDEX(QueCod),"
+		   "INDEX(NextTry))");
+
    /***** Table marks_properties *****/
 /*
 mysql> DESCRIBE marks_properties;
@@ -2301,6 +2493,25 @@ mysql> DESCRIBE projects;
 		   "INDEX(CrsCod,ModifTime),"
 		   "INDEX(CrsCod,DptCod))");
 
+   /***** Table sch_words *****/
+/*
+mysql> DESCRIBE sch_words;
++-------+-------------+------+-----+---------+-------+
+| Field | Type        | Null | Key | Default | Extra |
++-------+-------------+------+-----+---------+-------+
+| Type  | tinyint(4)  | NO   | PRI | NULL    |       |
+| Word  | varchar(64) | NO   | PRI | NULL    |       |
+| Cod   | int(11)     | NO   | PRI | NULL    |       |
++-------+-------------+------+-----+---------+-------+
+3 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS sch_words ("
+			"Type TINYINT NOT NULL,"
+			"Word VARCHAR(64) NOT NULL,"	// Sch_MAX_BYTES_INDEX_WORD
+			"Cod INT NOT NULL,"
+		   "UNIQUE INDEX(Type,Word,Cod),"
+		   "INDEX(Type,Cod))");
+
    /***** Table sessions *****/
 /*
 mysql> DESCRIBE sessions;
@@ -2318,6 +2529,7 @@ mysql> DESCRIBE sessions;
 | CrsCod         | int(11)       | NO   |     | -1      |       |
 | LastTime       | datetime      | NO   |     | NULL    |       |
 | LastRefresh    | datetime      | NO   |     | NULL    |       |
+| Expire         | datetime      | NO   | MUL | NULL    |       |
 | FirstPubCod    | bigint(20)    | NO   |     | 0       |       |
 | LastPubCod     | bigint(20)    | NO   |     | 0       |       |
 | LastPageMsgRcv | int(11)       | NO   |     | 1       |       |
@@ -2326,7 +2538,7 @@ mysql> DESCRIBE sessions;
 | SearchStr      | varchar(2047) | NO   |     |         |       |
 | SideCols       | tinyint(4)    | NO   |     | 3       |       |
 +----------------+---------------+------+-----+---------+-------+
-18 rows in set (0,00 sec)
+19 rows in set (0,00 sec)
 */
    DB_CreateTable ("CREATE TABLE IF NOT EXISTS sessions ("
 			"SessionId CHAR(43) NOT NULL,"				// Cns_BYTES_SESSION_ID
@@ -2340,6 +2552,7 @@ mysql> DESCRIBE sessions;
 			"CrsCod INT NOT NULL DEFAULT -1,"
 			"LastTime DATETIME NOT NULL,"
 			"LastRefresh DATETIME NOT NULL,"
+			"Expire DATETIME NOT NULL,"
 			"FirstPubCod BIGINT NOT NULL DEFAULT 0,"
 			"LastPubCod BIGINT NOT NULL DEFAULT 0,"
 			"LastPageMsgRcv INT NOT NULL DEFAULT 1,"
@@ -2348,7 +2561,24 @@ mysql> DESCRIBE sessions;
 			"SearchStr VARCHAR(2047) NOT NULL DEFAULT '',"		// Sch_MAX_BYTES_STRING_TO_FIND
 			"SideCols TINYINT NOT NULL DEFAULT 3,"
 		   "UNIQUE INDEX(SessionId),"
-		   "INDEX(UsrCod))");
+		   "INDEX(UsrCod),"
+		   "INDEX(Expire))");
+
+   /***** Table sessions_count *****/
+/*
+mysql> DESCRIBE sessions_count;
++-------------+------------+------+-----+---------+-------+
+| Field       | Type       | Null | Key | Default | Extra |
++-------------+------------+------+-----+---------+-------+
+| Id          | tinyint(4) | NO   | PRI | 0       |       |
+| NumSessions | int(11)    | NO   |     | 0       |       |
++-------------+------------+------+-----+---------+-------+
+2 rows in set (0,00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS sessions_count ("
+			"Id TINYINT NOT NULL DEFAULT 0,"	// Only one row, with Id = 0
+			"NumSessions INT NOT NULL DEFAULT 0,"
+		   "UNIQUE INDEX(Id))");
 
    /***** Table sta_degrees *****/
 /*
@@ -2374,6 +2604,55 @@ mysql> DESCRIBE sta_degrees;
 			"TimeToComputeAvgPhoto INT NOT NULL DEFAULT -1,"
 		   "UNIQUE INDEX(DegCod,Sex))");
 
+   /***** Table sta_hits *****/
+/*
+mysql> DESCRIBE sta_hits;
++----------------+------------+------+-----+---------+-------+
+| Field          | Type       | Null | Key | Default | Extra |
++----------------+------------+------+-----+---------+-------+
+| HitHour        | datetime   | NO   | PRI | NULL    |       |
+| ActCod         | int(11)    | NO   | PRI | NULL    |       |
+| CtyCod         | int(11)    | NO   | PRI | NULL    |       |
+| InsCod         | int(11)    | NO   | PRI | NULL    |       |
+| CtrCod         | int(11)    | NO   | PRI | NULL    |       |
+| DegCod         | int(11)    | NO   | PRI | NULL    |       |
+| CrsCod         | int(11)    | NO   | PRI | NULL    |       |
+| Role           | tinyint(4) | NO   | PRI | NULL    |       |
+| NumHits        | int(11)    | NO   |     | NULL    |       |
+| TimeToGenerate | bigint(20) | NO   |     | NULL    |       |
+| TimeToSend     | bigint(20) | NO   |     | NULL    |       |
++----------------+------------+------+-----+---------+-------+
+11 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS sta_hits ("
+			"HitHour DATETIME NOT NULL,"
+			"ActCod INT NOT NULL,"
+			"CtyCod INT NOT NULL,"
+			"InsCod INT NOT NULL,"
+			"CtrCod INT NOT NULL,"
+			"DegCod INT NOT NULL,"
+			"CrsCod INT NOT NULL,"
+			"Role TINYINT NOT NULL,"
+			"NumHits INT NOT NULL,"
+			"TimeToGenerate BIGINT NOT NULL,"
+			"TimeToSend BIGINT NOT NULL,"
+		   "UNIQUE INDEX(HitHour,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role))");
+
+   /***** Table sta_hits_range *****/
+/*
+mysql> DESCRIBE sta_hits_range;
++-----------+----------+------+-----+---------+-------+
+| Field     | Type     | Null | Key | Default | Extra |
++-----------+----------+------+-----+---------+-------+
+| FirstHour | datetime | NO   |     | NULL    |       |
+| EndHour   | datetime | NO   |     | NULL    |       |
++-----------+----------+------+-----+---------+-------+
+2 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS sta_hits_range ("
+			"FirstHour DATETIME NOT NULL,"
+			"EndHour DATETIME NOT NULL)");
+
    /***** Table sta_notif *****/
 /*
 mysql> DESCRIBE sta_notif;
@@ -2598,6 +2877,24 @@ mysql> DESCRIBE tl_comments_fav;
 		   "UNIQUE INDEX(PubCod,UsrCod),"
 		   "INDEX(UsrCod))");
 
+   /***** Table tl_inboxes *****/
+/*
+mysql> DESCRIBE tl_inboxes;
++--------+------------+------+-----+---------+-------+
+| Field  | Type       | Null | Key | Default | Extra |
++--------+------------+------+-----+---------+-------+
+| UsrCod | int(11)    | NO   | PRI | NULL    |       |
+| PubCod | bigint(20) | NO   | PRI | NULL    |       |
+| NotCod | bigint(20) | NO   |     | NULL    |       |
++--------+------------+------+-----+---------+-------+
+3 rows in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS tl_inboxes ("
+			"UsrCod INT NOT NULL,"
+			"PubCod BIGINT NOT NULL,"
+			"NotCod BIGINT NOT NULL,"
+		   "UNIQUE INDEX(UsrCod,PubCod))");
+
    /***** Table tl_notes *****/
 /*
 mysql> DESCRIBE tl_notes;
@@ -2695,6 +2992,20 @@ mysql> DESCRIBE tl_pubs;
 		   "INDEX(PubType),"
 		   "INDEX(TimePublish))");
 
+   /***** Table tl_pull_publishers *****/
+/*
+mysql> DESCRIBE tl_pull_publishers;
++--------+---------+------+-----+---------+-------+
+| Field  | Type    | Null | Key | Default | Extra |
++--------+---------+------+-----+---------+-------+
+| UsrCod | int(11) | NO   | PRI | NULL    |       |
++--------+---------+------+-----+---------+-------+
+1 row in set (0.00 sec)
+*/
+   DB_CreateTable ("CREATE TABLE IF NOT EXISTS tl_pull_publishers ("
+			"UsrCod INT NOT NULL,"
+		   "UNIQUE INDEX(UsrCod))");
+
    /***** Table tl_timelines *****/
 /*
 mysql> DESCRIBE tl_timelines;
@@ -3294,6 +3605,15 @@ static void DB_CreateTable (const char *Query)
 
 void DB_OpenDBConnection (void)
   {
+   /***** A persistent worker reuses the connection opened in a previous request,
+          except if it has been closed by the server (wait_timeout...) *****/
+   if (Gbl.DB.DatabaseIsOpen)
+     {
+      if (!mysql_ping (&Gbl.mysql))	// Returns 0 if the connection is alive
+	 return;
+      DB_CloseDBConnection ();
+     }
+
    if (mysql_init (&Gbl.mysql) == NULL)
       Lay_ShowErrorAndExit ("Can not init MySQL.");
 
@@ -3313,6 +3633,7 @@ void DB_CloseDBConnection (void)
   {
    if (Gbl.DB.DatabaseIsOpen)
      {
+      DB_ClosePreparedStmts ();	// Prepared statements belong to the connection
       mysql_close (&Gbl.mysql);	// Close the connection to the database
       Gbl.DB.DatabaseIsOpen = false;
      }
@@ -3382,6 +3703,40 @@ static unsigned long DB_QuerySELECTusingQueryStr (char *Query,
    return (unsigned long) mysql_num_rows (*mysql_res);
   }
 
+/*****************************************************************************/
+/********* Make a SELECT query whose result is read row by row ***************/
+/*****************************************************************************/
+/*
+   The result is not stored in memory by the client library.
+   Rows are read with mysql_fetch_row until it returns NULL,
+   and the result must be freed with DB_FreeMySQLResult.
+   No other query can be made until the result is freed.
+*/
+void DB_QuerySELECTstreaming (MYSQL_RES **mysql_res,const char *MsgError,
+                              const char *fmt,...)
+  {
+   va_list ap;
+   int NumBytesPrinted;
+   char *Query;
+   int Result;
+
+   va_start (ap,fmt);
+   NumBytesPrinted = vasprintf (&Query,fmt,ap);
+   va_end (ap);
+   if (NumBytesPrinted < 0)	// -1 if no memory or any other error
+      Lay_NotEnoughMemoryExit ();
+
+   /***** Query database and free query string pointer *****/
+   Result = mysql_query (&Gbl.mysql,Query);	// Returns 0 on success
+   free (Query);
+   if (Result)
+      DB_ExitOnMySQLError (MsgError);
+
+   /***** Start reading query result *****/
+   if ((*mysql_res = mysql_use_result (&Gbl.mysql)) == NULL)
+      DB_ExitOnMySQLError (MsgError);
+  }
+
 /*****************************************************************************/
 /**************** Make a SELECT COUNT query from database ********************/
 /*****************************************************************************/
@@ -3546,6 +3901,54 @@ void DB_QueryDELETE (const char *MsgError,const char *fmt,...)
       DB_ExitOnMySQLError (MsgError);
   }
 
+/*****************************************************************************/
+/************ Make a DELETE query from database in small batches *************/
+/*****************************************************************************/
+// A huge DELETE locks the table for a long time,
+// so rows are removed in batches of Cfg_MAX_ROWS_TO_DELETE_IN_A_BATCH rows
+// Return the total number of rows removed
+
+unsigned long DB_QueryDELETEinBatches (const char *MsgError,const char *fmt,...)
+  {
+   va_list ap;
+   int NumBytesPrinted;
+   char *SubQuery;
+   char *Query;
+   int Result;
+   my_ulonglong NumRowsInBatch;
+   unsigned long NumRows = 0;
+
+   va_start (ap,fmt);
+   NumBytesPrinted = vasprintf (&SubQuery,fmt,ap);
+   va_end (ap);
+   if (NumBytesPrinted < 0)	// -1 if no memory or any other error
+      Lay_NotEnoughMemoryExit ();
+
+   if (asprintf (&Query,"%s LIMIT %u",
+		 SubQuery,(unsigned) Cfg_MAX_ROWS_TO_DELETE_IN_A_BATCH) < 0)
+      Lay_NotEnoughMemoryExit ();
+   free (SubQuery);
+
+   /***** Query database until a batch is not full *****/
+   do
+     {
+      Result = mysql_query (&Gbl.mysql,Query);	// Returns 0 on success
+      if (Result)
+	{
+	 free (Query);
+	 DB_ExitOnMySQLError (MsgError);
+	}
+      NumRowsInBatch = mysql_affected_rows (&Gbl.mysql);
+      NumRows += (unsigned long) NumRowsInBatch;
+     }
+   while (NumRowsInBatch == (my_ulonglong) Cfg_MAX_ROWS_TO_DELETE_IN_A_BATCH);
+
+   /***** Free query string pointer *****/
+   free (Query);
+
+   return NumRows;
+  }
+
 /*****************************************************************************/
 /**************** Make other kind of query from database *********************/
 /*****************************************************************************/
@@ -3570,6 +3973,91 @@ void DB_Query (const char *MsgError,const char *fmt,...)
       DB_ExitOnMySQLError (MsgError);
   }
 
+/*****************************************************************************/
+/***************** Get a named lock without waiting for it *******************/
+/*****************************************************************************/
+// Return true if lock is got, false if other connection has it
+
+bool DB_GetLock (const char *Name)
+  {
+   return DB_WaitForLock (Name,0);
+  }
+
+/*****************************************************************************/
+/****** Get a named lock waiting, at most some seconds, until it is free *****/
+/*****************************************************************************/
+// Return true if lock is got, false if other connection still has it
+
+bool DB_WaitForLock (const char *Name,unsigned Seconds)
+  {
+   if (!DB_QueryCOUNT ("can not get lock",
+		       "SELECT COALESCE(GET_LOCK('%s',%u),0)",Name,Seconds))
+      return false;
+
+   Gbl.DB.NumNamedLocks++;
+   return true;
+  }
+
+/*****************************************************************************/
+/************************** Release a named lock *****************************/
+/*****************************************************************************/
+
+void DB_ReleaseLock (const char *Name)
+  {
+   if (Gbl.DB.NumNamedLocks)
+      Gbl.DB.NumNamedLocks--;	// Decrement before the following release...
+				// ...to not retry the release if error in releasing
+   DB_QueryCOUNT ("can not release lock",
+		  "SELECT COALESCE(RELEASE_LOCK('%s'),0)",Name);
+  }
+
+/*****************************************************************************/
+/***************** Release all named locks got in this connection ************/
+/*****************************************************************************/
+// Called on error, because the connection may be reused by next request
+
+void DB_ReleaseAllLocks (void)
+  {
+   if (Gbl.DB.NumNamedLocks)
+     {
+      Gbl.DB.NumNamedLocks = 0;
+      mysql_query (&Gbl.mysql,"DO RELEASE_ALL_LOCKS()");
+     }
+  }
+
+/*****************************************************************************/
+/************************** Begin/end a transaction **************************/
+/*****************************************************************************/
+
+void DB_BeginTransaction (void)
+  {
+   DB_Query ("can not begin transaction",
+	     "START TRANSACTION");
+   Gbl.DB.InTransaction = true;
+  }
+
+void DB_CommitTransaction (void)
+  {
+   Gbl.DB.InTransaction = false;	// Set to false before the following commit...
+					// ...to not retry the commit if error in committing
+   DB_Query ("can not commit transaction",
+	     "COMMIT");
+  }
+
+/*****************************************************************************/
+/******************** Undo the transaction begun, if any *********************/
+/*****************************************************************************/
+// Called on error, because the connection may be reused by next request
+
+void DB_RollbackTransaction (void)
+  {
+   if (Gbl.DB.InTransaction)
+     {
+      Gbl.DB.InTransaction = false;
+      mysql_query (&Gbl.mysql,"ROLLBACK");
+     }
+  }
+
 /*****************************************************************************/
 /********** Free structure that stores the result of a SELECT query **********/
 /*****************************************************************************/
@@ -3584,6 +4072,455 @@ void DB_FreeMySQLResult (MYSQL_RES **mysql_res)
 	}
   }
 
+/*****************************************************************************/
+/******************* Queries made using prepared statements ******************/
+/*****************************************************************************/
+/*
+   Format strings are the same used in the rest of queries,
+   but only %ld, %lu, %d, %u, %s and '%s' are allowed.
+   Each of them is replaced by a parameter (?) when preparing the statement,
+   and the values are sent using the binary protocol,
+   so strings must not be escaped.
+   Statements are prepared the first time they are used
+   and kept until the connection is closed.
+   The format string must be a string literal,
+   because its address is used to find the statement.
+   A process serving only one request does not prepare statements,
+   because preparing and closing a statement used once
+   costs two round trips more than a plain query.
+   In that case the query is built escaping the strings.
+*/
+
+unsigned long DB_QueryCOUNTprepared (const char *MsgError,const char *fmt,...)
+  {
+   va_list ap;
+   struct DB_PreparedStmt *PreparedStmt;
+   MYSQL_BIND Result;
+   unsigned long long Count = 0;
+   my_bool IsNull = 0;
+   int ResultFetch;
+   char *Query;
+
+   /***** Not persistent ==> plain query *****/
+   if (!Wrk_IsPersistent ())
+     {
+      va_start (ap,fmt);
+      Query = DB_BuildQueryFromStmtFormat (fmt,ap);
+      va_end (ap);
+      Count = (unsigned long long) DB_QueryCOUNT (MsgError,"%s",Query);
+      free (Query);
+      return (unsigned long) Count;
+     }
+
+   va_start (ap,fmt);
+   PreparedStmt = DB_ExecutePreparedStmt (MsgError,fmt,ap);
+   va_end (ap);
+
+   /***** Get the only column of the only row *****/
+   memset (&Result,0,sizeof (Result));
+   Result.buffer_type = MYSQL_TYPE_LONGLONG;
+   Result.buffer      = &Count;
+   Result.is_unsigned = 1;
+   Result.is_null     = &IsNull;
+   if (mysql_stmt_bind_result (PreparedStmt->Stmt,&Result))
+      DB_ExitOnStmtError (MsgError,PreparedStmt->Stmt);
+   ResultFetch = mysql_stmt_fetch (PreparedStmt->Stmt);
+   if (ResultFetch != 0 &&
+       ResultFetch != MYSQL_NO_DATA)
+      DB_ExitOnStmtError (MsgError,PreparedStmt->Stmt);
+   mysql_stmt_free_result (PreparedStmt->Stmt);
+   if (ResultFetch == MYSQL_NO_DATA || IsNull)
+      Count = 0;
+
+   DB_FreePreparedStmt (PreparedStmt);
+
+   return (unsigned long) Count;
+  }
+
+void DB_QueryINSERTprepared (const char *MsgError,const char *fmt,...)
+  {
+   va_list ap;
+   char *Query;
+
+   va_start (ap,fmt);
+   if (Wrk_IsPersistent ())
+      DB_FreePreparedStmt (DB_ExecutePreparedStmt (MsgError,fmt,ap));
+   else
+     {
+      Query = DB_BuildQueryFromStmtFormat (fmt,ap);
+      DB_QueryINSERT (MsgError,"%s",Query);
+      free (Query);
+     }
+   va_end (ap);
+  }
+
+long DB_QueryINSERTandReturnCodePrepared (const char *MsgError,const char *fmt,...)
+  {
+   va_list ap;
+   struct DB_PreparedStmt *PreparedStmt;
+   long Cod;
+   char *Query;
+
+   /***** Not persistent ==> plain query *****/
+   if (!Wrk_IsPersistent ())
+     {
+      va_start (ap,fmt);
+      Query = DB_BuildQueryFromStmtFormat (fmt,ap);
+      va_end (ap);
+      Cod = DB_QueryINSERTandReturnCode (MsgError,"%s",Query);
+      free (Query);
+      return Cod;
+     }
+
+   va_start (ap,fmt);
+   PreparedStmt = DB_ExecutePreparedStmt (MsgError,fmt,ap);
+   va_end (ap);
+
+   Cod = (long) mysql_stmt_insert_id (PreparedStmt->Stmt);
+
+   DB_FreePreparedStmt (PreparedStmt);
+
+   return Cod;
+  }
+
+void DB_QueryREPLACEprepared (const char *MsgError,const char *fmt,...)
+  {
+   va_list ap;
+   char *Query;
+
+   va_start (ap,fmt);
+   if (Wrk_IsPersistent ())
+      DB_FreePreparedStmt (DB_ExecutePreparedStmt (MsgError,fmt,ap));
+   else
+     {
+      Query = DB_BuildQueryFromStmtFormat (fmt,ap);
+      DB_QueryREPLACE (MsgError,"%s",Query);
+      free (Query);
+     }
+   va_end (ap);
+  }
+
+void DB_QueryUPDATEprepared (const char *MsgError,const char *fmt,...)
+  {
+   va_list ap;
+   char *Query;
+
+   va_start (ap,fmt);
+   if (Wrk_IsPersistent ())
+      DB_FreePreparedStmt (DB_ExecutePreparedStmt (MsgError,fmt,ap));
+   else
+     {
+      Query = DB_BuildQueryFromStmtFormat (fmt,ap);
+      DB_QueryUPDATE (MsgError,"%s",Query);
+      free (Query);
+     }
+   va_end (ap);
+  }
+
+void DB_QueryDELETEprepared (const char *MsgError,const char *fmt,...)
+  {
+   va_list ap;
+   char *Query;
+
+   va_start (ap,fmt);
+   if (Wrk_IsPersistent ())
+      DB_FreePreparedStmt (DB_ExecutePreparedStmt (MsgError,fmt,ap));
+   else
+     {
+      Query = DB_BuildQueryFromStmtFormat (fmt,ap);
+      DB_QueryDELETE (MsgError,"%s",Query);
+      free (Query);
+     }
+   va_end (ap);
+  }
+
+/*****************************************************************************/
+/********* Build a plain query from the format of a prepared statement *******/
+/*****************************************************************************/
+// Strings are escaped and quoted. Returned query must be freed by the caller
+
+static char *DB_BuildQueryFromStmtFormat (const char *fmt,va_list ap)
+  {
+   char *Query;
+   size_t Size;
+   FILE *FileQuery;
+   const char *Src;
+   const char *Str;
+   size_t Length;
+   char *Escaped;
+
+   if ((FileQuery = open_memstream (&Query,&Size)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+
+   for (Src = fmt;
+	*Src;)
+     {
+      if (!strncmp (Src,"'%s'",4) ||
+          !strncmp (Src,"%s",2))
+	{
+	 Str = va_arg (ap,const char *);
+	 Length = strlen (Str);
+	 if ((Escaped = (char *) malloc (Length * 2 + 1)) == NULL)
+	    Lay_NotEnoughMemoryExit ();
+	 mysql_real_escape_string (&Gbl.mysql,Escaped,Str,(unsigned long) Length);
+	 fprintf (FileQuery,"'%s'",Escaped);
+	 free (Escaped);
+	 Src += (*Src == '\'') ? 4 :
+				 2;
+	}
+      else if (*Src != '%')
+	 fputc (*Src++,FileQuery);
+      else if (!strncmp (Src,"%%",2))
+	{
+	 fputc ('%',FileQuery);
+	 Src += 2;
+	}
+      else if (!strncmp (Src,"%ld",3))
+	{
+	 fprintf (FileQuery,"%ld",va_arg (ap,long));
+	 Src += 3;
+	}
+      else if (!strncmp (Src,"%lu",3))
+	{
+	 fprintf (FileQuery,"%lu",va_arg (ap,unsigned long));
+	 Src += 3;
+	}
+      else if (!strncmp (Src,"%d",2))
+	{
+	 fprintf (FileQuery,"%d",va_arg (ap,int));
+	 Src += 2;
+	}
+      else if (!strncmp (Src,"%u",2))
+	{
+	 fprintf (FileQuery,"%u",va_arg (ap,unsigned));
+	 Src += 2;
+	}
+      else
+	 Lay_ShowErrorAndExit ("Wrong format in prepared statement.");
+     }
+
+   if (fclose (FileQuery))
+      Lay_NotEnoughMemoryExit ();
+
+   return Query;
+  }
+
+/*****************************************************************************/
+/******* Bind parameters to a prepared statement and execute it **************/
+/*****************************************************************************/
+
+static struct DB_PreparedStmt *DB_ExecutePreparedStmt (const char *MsgError,
+                                                       const char *fmt,va_list ap)
+  {
+   struct DB_PreparedStmt *PreparedStmt;
+   MYSQL_BIND Params[DB_MAX_PARAMS_IN_STMT];
+   long long Values[DB_MAX_PARAMS_IN_STMT];
+   unsigned long Lengths[DB_MAX_PARAMS_IN_STMT];
+   unsigned NumParam;
+   char *Str;
+
+   /***** Get prepared statement for this format *****/
+   PreparedStmt = DB_GetPreparedStmt (MsgError,fmt);
+
+   /***** Bind parameters *****/
+   if (PreparedStmt->NumParams)
+     {
+      memset (Params,0,PreparedStmt->NumParams * sizeof (MYSQL_BIND));
+      for (NumParam = 0;
+	   NumParam < PreparedStmt->NumParams;
+	   NumParam++)
+	{
+	 switch (PreparedStmt->ParamTypes[NumParam])
+	   {
+	    case DB_PARAM_LONG:
+	       Values[NumParam] = (long long) va_arg (ap,long);
+	       break;
+	    case DB_PARAM_UNSIGNED_LONG:
+	       Values[NumParam] = (long long) va_arg (ap,unsigned long);
+	       Params[NumParam].is_unsigned = 1;
+	       break;
+	    case DB_PARAM_INT:
+	       Values[NumParam] = (long long) va_arg (ap,int);
+	       break;
+	    case DB_PARAM_UNSIGNED:
+	       Values[NumParam] = (long long) va_arg (ap,unsigned);
+	       Params[NumParam].is_unsigned = 1;
+	       break;
+	    case DB_PARAM_STRING:
+	       Str = va_arg (ap,char *);
+	       Lengths[NumParam] = (unsigned long) strlen (Str);
+	       Params[NumParam].buffer_type   = MYSQL_TYPE_STRING;
+	       Params[NumParam].buffer        = Str;
+	       Params[NumParam].buffer_length = Lengths[NumParam];
+	       Params[NumParam].length        = &Lengths[NumParam];
+	       continue;
+	   }
+	 Params[NumParam].buffer_type = MYSQL_TYPE_LONGLONG;
+	 Params[NumParam].buffer      = &Values[NumParam];
+	}
+      if (mysql_stmt_bind_param (PreparedStmt->Stmt,Params))
+	 DB_ExitOnStmtError (MsgError,PreparedStmt->Stmt);
+     }
+
+   /***** Execute statement *****/
+   if (mysql_stmt_execute (PreparedStmt->Stmt))
+      DB_ExitOnStmtError (MsgError,PreparedStmt->Stmt);
+
+   return PreparedStmt;
+  }
+
+/*****************************************************************************/
+/*************** Get the prepared statement for a format string **************/
+/*****************************************************************************/
+// If the cache is full, a statement only for this query is returned
+
+static struct DB_PreparedStmt *DB_GetPreparedStmt (const char *MsgError,
+                                                   const char *fmt)
+  {
+   static struct DB_PreparedStmt NotCachedStmt;
+   unsigned NumStmt;
+
+   /***** Search the format string in cache *****/
+   for (NumStmt = 0;
+	NumStmt < DB_PreparedStmts.Num;
+	NumStmt++)
+      if (DB_PreparedStmts.Lst[NumStmt].Format == fmt)
+	 return &DB_PreparedStmts.Lst[NumStmt];
+
+   /***** Not found ==> prepare statement *****/
+   if (DB_PreparedStmts.Num < DB_MAX_PREPARED_STMTS)
+     {
+      DB_PrepareStmt (&DB_PreparedStmts.Lst[DB_PreparedStmts.Num],MsgError,fmt);
+      return &DB_PreparedStmts.Lst[DB_PreparedStmts.Num++];
+     }
+
+   DB_PrepareStmt (&NotCachedStmt,MsgError,fmt);
+   NotCachedStmt.Format = NULL;	// Not in cache
+   return &NotCachedStmt;
+  }
+
+/*****************************************************************************/
+/******** Prepare a statement replacing format specifiers by parameters ******/
+/*****************************************************************************/
+
+static void DB_PrepareStmt (struct DB_PreparedStmt *PreparedStmt,
+                            const char *MsgError,const char *fmt)
+  {
+   char *Query;
+   char *Dst;
+   const char *Src;
+
+   /***** Allocate memory for query (never longer than format) *****/
+   if ((Query = (char *) malloc (strlen (fmt) + 1)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+
+   /***** Build query and get types of parameters *****/
+   PreparedStmt->Format = fmt;
+   PreparedStmt->NumParams = 0;
+   for (Src = fmt, Dst = Query;
+	*Src;)
+     {
+      if (PreparedStmt->NumParams == DB_MAX_PARAMS_IN_STMT)
+	 Lay_ShowErrorAndExit ("Too many parameters in prepared statement.");
+
+      if (!strncmp (Src,"'%s'",4))
+	{
+	 PreparedStmt->ParamTypes[PreparedStmt->NumParams++] = DB_PARAM_STRING;
+	 Src += 4;
+	}
+      else if (*Src != '%')
+	{
+	 *Dst++ = *Src++;
+	 continue;
+	}
+      else if (!strncmp (Src,"%%",2))
+	{
+	 *Dst++ = '%';
+	 Src += 2;
+	 continue;
+	}
+      else if (!strncmp (Src,"%ld",3))
+	{
+	 PreparedStmt->ParamTypes[PreparedStmt->NumParams++] = DB_PARAM_LONG;
+	 Src += 3;
+	}
+      else if (!strncmp (Src,"%lu",3))
+	{
+	 PreparedStmt->ParamTypes[PreparedStmt->NumParams++] = DB_PARAM_UNSIGNED_LONG;
+	 Src += 3;
+	}
+      else if (!strncmp (Src,"%d",2))
+	{
+	 PreparedStmt->ParamTypes[PreparedStmt->NumParams++] = DB_PARAM_INT;
+	 Src += 2;
+	}
+      else if (!strncmp (Src,"%u",2))
+	{
+	 PreparedStmt->ParamTypes[PreparedStmt->NumParams++] = DB_PARAM_UNSIGNED;
+	 Src += 2;
+	}
+      else if (!strncmp (Src,"%s",2))
+	{
+	 PreparedStmt->ParamTypes[PreparedStmt->NumParams++] = DB_PARAM_STRING;
+	 Src += 2;
+	}
+      else
+	 Lay_ShowErrorAndExit ("Wrong format in prepared statement.");
+
+      *Dst++ = '?';
+     }
+   *Dst = '\0';
+
+   /***** Prepare statement *****/
+   if ((PreparedStmt->Stmt = mysql_stmt_init (&Gbl.mysql)) == NULL)
+      DB_ExitOnMySQLError (MsgError);
+   if (mysql_stmt_prepare (PreparedStmt->Stmt,Query,(unsigned long) strlen (Query)))
+      DB_ExitOnStmtError (MsgError,PreparedStmt->Stmt);
+   free (Query);
+  }
+
+/*****************************************************************************/
+/************ Free a prepared statement if it's not in cache *****************/
+/*****************************************************************************/
+
+static void DB_FreePreparedStmt (struct DB_PreparedStmt *PreparedStmt)
+  {
+   if (PreparedStmt->Format == NULL)	// Not in cache
+     {
+      mysql_stmt_close (PreparedStmt->Stmt);
+      PreparedStmt->Stmt = NULL;
+     }
+  }
+
+/*****************************************************************************/
+/*********************** Close all prepared statements ***********************/
+/*****************************************************************************/
+
+static void DB_ClosePreparedStmts (void)
+  {
+   unsigned NumStmt;
+
+   for (NumStmt = 0;
+	NumStmt < DB_PreparedStmts.Num;
+	NumStmt++)
+      mysql_stmt_close (DB_PreparedStmts.Lst[NumStmt].Stmt);
+   DB_PreparedStmts.Num = 0;
+  }
+
+/*****************************************************************************/
+/******** Abort program due to an error in a prepared statement **************/
+/*****************************************************************************/
+
+static void DB_ExitOnStmtError (const char *Message,MYSQL_STMT *Stmt)
+  {
+   char BigErrorMsg[64 * 1024];
+
+   snprintf (BigErrorMsg,sizeof (BigErrorMsg),
+	     "Database error: %s (%s).",
+             Message,mysql_stmt_error (Stmt));
+   Lay_ShowErrorAndExit (BigErrorMsg);
+  }
+
 /*****************************************************************************/
 /*********** Abort program due to an error in the MySQL database *************/
 /*****************************************************************************/
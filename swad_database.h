@@ -28,6 +28,7 @@
 /*****************************************************************************/
 
 #include <mysql/mysql.h>	// To access MySQL databases
+#include <stdbool.h>		// For boolean type
 
 /*****************************************************************************/
 /***************************** Public prototypes *****************************/
@@ -41,6 +42,8 @@ void DB_BuildQuery (char **Query,const char *fmt,...);
 
 unsigned long DB_QuerySELECT (MYSQL_RES **mysql_res,const char *MsgError,
                               const char *fmt,...);
+void DB_QuerySELECTstreaming (MYSQL_RES **mysql_res,const char *MsgError,
+                              const char *fmt,...);
 unsigned long DB_GetNumRowsTable (const char *Table);
 unsigned long DB_QueryCOUNT (const char *MsgError,const char *fmt,...);
 
@@ -53,9 +56,26 @@ void DB_QueryREPLACE (const char *MsgError,const char *fmt,...);
 void DB_QueryUPDATE (const char *MsgError,const char *fmt,...);
 
 void DB_QueryDELETE (const char *MsgError,const char *fmt,...);
+unsigned long DB_QueryDELETEinBatches (const char *MsgError,const char *fmt,...);
 
 void DB_Query (const char *MsgError,const char *fmt,...);
 
+bool DB_GetLock (const char *Name);
+bool DB_WaitForLock (const char *Name,unsigned Seconds);
+void DB_ReleaseLock (const char *Name);
+void DB_ReleaseAllLocks (void);
+
+void DB_BeginTransaction (void);
+void DB_CommitTransaction (void);
+void DB_RollbackTransaction (void);
+
+unsigned long DB_QueryCOUNTprepared (const char *MsgError,const char *fmt,...);
+void DB_QueryINSERTprepared (const char *MsgError,const char *fmt,...);
+long DB_QueryINSERTandReturnCodePrepared (const char *MsgError,const char *fmt,...);
+void DB_QueryREPLACEprepared (const char *MsgError,const char *fmt,...);
+void DB_QueryUPDATEprepared (const char *MsgError,const char *fmt,...);
+void DB_QueryDELETEprepared (const char *MsgError,const char *fmt,...);
+
 void DB_FreeMySQLResult (MYSQL_RES **mysql_res);
 void DB_ExitOnMySQLError (const char *Message);
 
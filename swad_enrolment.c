@@ -44,6 +44,7 @@
 #include "swad_notification.h"
 #include "swad_parameter.h"
 #include "swad_role.h"
+#include "swad_search.h"
 #include "swad_user.h"
 
 /*****************************************************************************/
@@ -560,6 +561,10 @@ void Enr_UpdateUsrData (struct UsrData *UsrDat)
 	           UsrDat->Comments ? UsrDat->Comments :
 				      "",
 	           UsrDat->UsrCod);
+
+   /***** Update index of words used in searches *****/
+   Sch_UpdateIndexOfUsr (UsrDat->UsrCod,
+			 UsrDat->FirstName,UsrDat->Surname1,UsrDat->Surname2);
   }
 
 /*****************************************************************************/
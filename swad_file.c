@@ -25,9 +25,11 @@
 /********************************* Headers ***********************************/
 /*****************************************************************************/
 
+#define _GNU_SOURCE 		// For fopencookie
 #include <ctype.h>		// For isprint, isspace, etc.
 #include <dirent.h>		// For scandir, etc.
 #include <errno.h>		// For errno
+#include <fcntl.h>		// For open
 #include <linux/limits.h>	// For PATH_MAX
 #include <stddef.h>		// For NULL
 #include <stdio.h>		// For FILE,fprintf
@@ -36,6 +38,7 @@
 #include <sys/stat.h>		// For mkdir
 #include <sys/types.h>		// For mkdir
 #include <unistd.h>		// For unlink
+#include <zlib.h>		// For deflate
 
 #include "swad_config.h"
 #include "swad_database.h"
@@ -59,107 +62,350 @@ extern struct Globals Gbl;
 /******************************* Private types *******************************/
 /*****************************************************************************/
 
+struct Fil_OutputBuffer
+  {
+   char *Buffer;	// HTML output not yet sent to standard output
+   size_t Length;	// Number of bytes in buffer
+   size_t Size;		// Number of bytes allocated for buffer
+   bool EarlyFlush;	// true ==> send buffer when it is large
+   bool Compress;	// true ==> output is sent compressed with gzip
+   z_stream Stream;	// Used to compress output
+   unsigned long BytesGenerated;	// Total bytes of HTML output
+   unsigned long BytesSent;		// Total bytes sent (compressed or not)
+  };
+
 /*****************************************************************************/
 /***************************** Private variables *****************************/
 /*****************************************************************************/
 
+static struct Fil_OutputBuffer Fil_HTMLOutput =
+  {
+   .Buffer     = NULL,
+   .Length     = 0,
+   .Size       = 0,
+   .EarlyFlush = false,
+   .Compress   = false,
+  };
+
 /*****************************************************************************/
 /***************************** Private prototypes ****************************/
 /*****************************************************************************/
 
+static bool Fil_CheckIfBrowserAcceptsGzip (void);
+static ssize_t Fil_WriteToHTMLOutput (void *Cookie,const char *Buf,size_t Size);
+static void Fil_SendBufferOfHTMLOutput (struct Fil_OutputBuffer *Output,int Flush);
+static void Fil_EndCompressionOfHTMLOutput (struct Fil_OutputBuffer *Output);
+
+/*****************************************************************************/
+/************ Create buffer in memory for the HTML output *******************/
+/*****************************************************************************/
+// All HTML output is written in Gbl.F.Out, that grows in memory
+// and is sent to standard output at the end of the request,
+// or before when early flush is enabled
+
+void Fil_CreateBufferForHTMLOutput (void)
+  {
+   cookie_io_functions_t OutFunctions =
+     {
+      .read  = NULL,
+      .write = Fil_WriteToHTMLOutput,
+      .seek  = NULL,
+      .close = NULL,
+     };
+
+   /***** Reset buffer (a previous request in this process may have been aborted) *****/
+   Fil_EndCompressionOfHTMLOutput (&Fil_HTMLOutput);
+   Fil_HTMLOutput.Length = 0;
+   Fil_HTMLOutput.EarlyFlush = false;
+   Fil_HTMLOutput.BytesGenerated =
+   Fil_HTMLOutput.BytesSent      = 0;
+
+   if ((Gbl.F.Out = fopencookie (&Fil_HTMLOutput,"w",OutFunctions)) == NULL)
+     {
+      Gbl.F.Out = stdout;
+      Lay_ShowErrorAndExit ("Can not create output buffer.");
+     }
+  }
+
+/*****************************************************************************/
+/************* Start compression of HTML output if browser accepts it ********/
+/*****************************************************************************/
+// It must be called when the HTTP header is being written and nothing has been sent
+// Return true if output will be compressed,
+// so header "Content-Encoding: gzip" must be written
+
+bool Fil_StartCompressionOfHTMLOutput (void)
+  {
+   if (Cfg_HTML_OUTPUT_COMPRESSION_LEVEL <= 0 ||
+       Gbl.F.Out == stdout ||
+       Fil_HTMLOutput.Compress ||
+       Fil_HTMLOutput.BytesSent)
+      return Fil_HTMLOutput.Compress;
+
+   if (Fil_CheckIfBrowserAcceptsGzip ())
+     {
+      Fil_HTMLOutput.Stream.zalloc = Z_NULL;
+      Fil_HTMLOutput.Stream.zfree  = Z_NULL;
+      Fil_HTMLOutput.Stream.opaque = Z_NULL;
+      if (deflateInit2 (&Fil_HTMLOutput.Stream,
+			Cfg_HTML_OUTPUT_COMPRESSION_LEVEL,Z_DEFLATED,
+			15 + 16,	// 2^15 bytes window, gzip header
+			8,Z_DEFAULT_STRATEGY) == Z_OK)
+	 Fil_HTMLOutput.Compress = true;
+     }
+
+   return Fil_HTMLOutput.Compress;
+  }
+
+/*****************************************************************************/
+/******** Check if browser accepts gzip content encoding in request **********/
+/*****************************************************************************/
+// Example: "Accept-Encoding: gzip, deflate;q=0.5, br"
+
+static bool Fil_CheckIfBrowserAcceptsGzip (void)
+  {
+   const char *Ptr;
+   const char *Coding;
+   size_t Length;
+   bool QualityIsZero;
+
+   if ((Ptr = getenv ("HTTP_ACCEPT_ENCODING")) == NULL)
+      return false;
+
+   while (*Ptr)
+     {
+      /***** Skip separators *****/
+      while (*Ptr == ',' || isspace ((unsigned char) *Ptr))
+	 Ptr++;
+
+      /***** Get content coding *****/
+      Coding = Ptr;
+      while (*Ptr && *Ptr != ',' && *Ptr != ';' && !isspace ((unsigned char) *Ptr))
+	 Ptr++;
+      Length = (size_t) (Ptr - Coding);
+
+      /***** Get parameters. Only quality "q=0" is relevant *****/
+      QualityIsZero = false;
+      while (*Ptr && *Ptr != ',')
+	 if (Ptr[0] == 'q' && Ptr[1] == '=')
+	   {
+	    // Quality is zero if there is no digit 1-9 in it ("q=0", "q=0.000")
+	    QualityIsZero = true;
+	    for (Ptr += 2;
+		 *Ptr && *Ptr != ',' && *Ptr != ';';
+		 Ptr++)
+	       if (*Ptr >= '1' && *Ptr <= '9')
+		  QualityIsZero = false;
+	   }
+	 else
+	    Ptr++;
+
+      if ((Length == 4 && !strncasecmp (Coding,"gzip"  ,4)) ||
+	  (Length == 6 && !strncasecmp (Coding,"x-gzip",6)))
+	 return !QualityIsZero;
+     }
+
+   return false;
+  }
+
+/*****************************************************************************/
+/************* Enable sending of HTML output before the end ******************/
+/*****************************************************************************/
+// It must be called only when the HTTP header has been written,
+// so the rest of the output can be sent in pieces
+
+void Fil_EnableEarlyFlushOfHTMLOutput (void)
+  {
+   if (Cfg_BYTES_TO_FLUSH_HTML_OUTPUT && Gbl.F.Out != stdout)
+      Fil_HTMLOutput.EarlyFlush = true;
+  }
+
 /*****************************************************************************/
-/******** Create HTML output file for the web page sent by this CGI **********/
+/**************** Send to standard output HTML written until now *************/
 /*****************************************************************************/
+// Used to let the browser load CSS, JavaScript and images
+// while the rest of the page is being generated
 
-void Fil_CreateFileForHTMLOutput (void)
+void Fil_FlushHTMLOutput (void)
   {
-   /***** Check if exists the directory for HTML output. If not exists, create it *****/
-   Fil_CreateDirIfNotExists (Cfg_PATH_OUT_PRIVATE);
+   if (Fil_HTMLOutput.EarlyFlush)
+     {
+      fflush (Gbl.F.Out);
+      Fil_SendBufferOfHTMLOutput (&Fil_HTMLOutput,Z_SYNC_FLUSH);
+      fflush (stdout);
+     }
+  }
+
+/*****************************************************************************/
+/******* Send HTML output pending to standard output, keeping it open ********/
+/*****************************************************************************/
+// Used when the page is complete except its end,
+// which is written later to the same output
 
-   /***** Create a unique name for the file *****/
-   snprintf (Gbl.HTMLOutput.FileName,sizeof (Gbl.HTMLOutput.FileName),
-	     "%s/%s.html",
-             Cfg_PATH_OUT_PRIVATE,Gbl.UniqueNameEncrypted);
+void Fil_SendHTMLOutput (void)
+  {
+   if (Gbl.F.Out != stdout)
+     {
+      fflush (Gbl.F.Out);	// Pending data is written to buffer
+      Fil_SendBufferOfHTMLOutput (&Fil_HTMLOutput,Z_SYNC_FLUSH);
+      fflush (stdout);
 
-   /***** Open file for writing and reading *****/
-   if ((Gbl.F.Out = fopen (Gbl.HTMLOutput.FileName,"w+t")) == NULL)
+      /***** Size of the page until now, to be logged *****/
+      Gbl.BytesGenerated = (long) Fil_HTMLOutput.BytesGenerated;
+      Gbl.BytesSent      = (long) Fil_HTMLOutput.BytesSent;
+     }
+  }
+
+/*****************************************************************************/
+/******* Send HTML output pending to standard output and free buffer *********/
+/*****************************************************************************/
+
+void Fil_SendAndCloseHTMLOutput (void)
+  {
+   if (Gbl.F.Out != stdout)
      {
+      fclose (Gbl.F.Out);	// Pending data is written to buffer
       Gbl.F.Out = stdout;
-      Lay_ShowErrorAndExit ("Can not create output file.");
+      Fil_SendBufferOfHTMLOutput (&Fil_HTMLOutput,Z_FINISH);
+      Fil_EndCompressionOfHTMLOutput (&Fil_HTMLOutput);
+
+      /***** Size of the page, to be logged *****/
+      Gbl.BytesGenerated = (long) Fil_HTMLOutput.BytesGenerated;
+      Gbl.BytesSent      = (long) Fil_HTMLOutput.BytesSent;
+     }
+
+   /***** Free buffer *****/
+   if (Fil_HTMLOutput.Buffer)
+     {
+      free (Fil_HTMLOutput.Buffer);
+      Fil_HTMLOutput.Buffer = NULL;
      }
+   Fil_HTMLOutput.Length = 0;
+   Fil_HTMLOutput.Size = 0;
+   Fil_HTMLOutput.EarlyFlush = false;
   }
 
 /*****************************************************************************/
-/****************** Close and remove the HTML output file ********************/
+/*********************** Write to HTML output buffer *************************/
 /*****************************************************************************/
 
-void Fil_CloseAndRemoveFileForHTMLOutput (void)
+static ssize_t Fil_WriteToHTMLOutput (void *Cookie,const char *Buf,size_t Size)
   {
-   if (Gbl.F.Out)
+   struct Fil_OutputBuffer *Output = (struct Fil_OutputBuffer *) Cookie;
+   size_t NewSize;
+   char *NewBuffer;
+
+   /***** Enlarge buffer if necessary *****/
+   if (Output->Length + Size > Output->Size)
      {
-      fclose (Gbl.F.Out);
-      unlink (Gbl.HTMLOutput.FileName);
+      NewSize = Output->Size ? Output->Size :
+			       NUM_BYTES_PER_CHUNK * 16;
+      while (Output->Length + Size > NewSize)
+	 NewSize *= 2;
+      if ((NewBuffer = realloc (Output->Buffer,NewSize)) == NULL)
+	 return 0;	// Error
+      Output->Buffer = NewBuffer;
+      Output->Size = NewSize;
      }
-   Gbl.F.Out = stdout;
+
+   /***** Append data to buffer *****/
+   memcpy (&Output->Buffer[Output->Length],Buf,Size);
+   Output->Length += Size;
+
+   /***** If buffer is large, send it *****/
+   if (Output->EarlyFlush &&
+       Output->Length >= Cfg_BYTES_TO_FLUSH_HTML_OUTPUT)
+      Fil_SendBufferOfHTMLOutput (Output,Z_NO_FLUSH);
+
+   return (ssize_t) Size;
   }
 
 /*****************************************************************************/
-/********** Open temporary file and write on it reading from stdin ***********/
+/**************** Send HTML output buffer to standard output *****************/
 /*****************************************************************************/
-// On error, Gbl.Alert.Txt will contain feedback
+// Flush is used only when compressing:
+// Z_NO_FLUSH   ==> compressor may keep data to compress better
+// Z_SYNC_FLUSH ==> send all data compressed until now
+// Z_FINISH     ==> end of compressed stream
 
-bool Fil_ReadStdinIntoTmpFile (void)
+static void Fil_SendBufferOfHTMLOutput (struct Fil_OutputBuffer *Output,int Flush)
   {
-   extern const char *Txt_UPLOAD_FILE_File_too_large_maximum_X_MiB_NO_HTML;
-   extern const char *Txt_UPLOAD_FILE_Upload_time_too_long_maximum_X_minutes_NO_HTML;
-   unsigned long long TmpFileSize;
-   bool FileIsTooBig = false;
-   bool TimeExceeded = false;
+   unsigned char Compressed[NUM_BYTES_PER_CHUNK * 4];
+   size_t NumBytesCompressed;
+   int Result;
 
-   if ((Gbl.F.Tmp = tmpfile ()) == NULL)
+   Output->BytesGenerated += Output->Length;
+
+   if (Output->Compress)
      {
-      Fil_EndOfReadingStdin ();
-      Lay_ShowErrorAndExit ("Can not create temporary file.");
+      Output->Stream.next_in  = (unsigned char *) Output->Buffer;
+      Output->Stream.avail_in = (uInt) Output->Length;
+      do
+	{
+	 Output->Stream.next_out  = Compressed;
+	 Output->Stream.avail_out = (uInt) sizeof (Compressed);
+	 Result = deflate (&Output->Stream,Flush);
+	 NumBytesCompressed = sizeof (Compressed) - Output->Stream.avail_out;
+	 if (NumBytesCompressed)
+	   {
+	    fwrite (Compressed,sizeof (unsigned char),NumBytesCompressed,stdout);
+	    Output->BytesSent += NumBytesCompressed;
+	   }
+	}
+      while (Result == Z_OK &&
+	     (Output->Stream.avail_out == 0 ||	// Output may be pending
+	      Flush == Z_FINISH));		// Until Z_STREAM_END
      }
-   for (TmpFileSize = 0;
-	!feof (stdin) && !FileIsTooBig && !TimeExceeded;
-	TmpFileSize++)
-      if (TmpFileSize < Fil_MAX_FILE_SIZE)
-        {
-         if (!(TmpFileSize % (64ULL * 1024ULL)))	// Check timeout from time to time
-            if (time (NULL) - Gbl.StartExecutionTimeUTC >= Cfg_TIME_TO_ABORT_FILE_UPLOAD)
-               TimeExceeded = true;
-         fputc (fgetc (stdin),Gbl.F.Tmp);
-        }
-      else
-         FileIsTooBig = true;
-   if (FileIsTooBig || TimeExceeded)
+   else if (Output->Length)
      {
-      Fil_EndOfReadingStdin ();  // If stdin were not fully read, there will be problems with buffers
-
-      /* Start HTTP response */
-      fprintf (stdout,"Content-type: text/plain; charset=windows-1252\n");
-
-      /* Status code and message */
-      fprintf (stdout,"Status: 501 Not Implemented\r\n\r\n");
-      if (FileIsTooBig)
-         fprintf (stdout,Txt_UPLOAD_FILE_File_too_large_maximum_X_MiB_NO_HTML,
-                  (unsigned long) (Fil_MAX_FILE_SIZE / (1024ULL * 1024ULL)));
-      else
-         fprintf (stdout,Txt_UPLOAD_FILE_Upload_time_too_long_maximum_X_minutes_NO_HTML,
-                  (unsigned long) (Cfg_TIME_TO_ABORT_FILE_UPLOAD / 60UL));
-      fprintf (stdout,"\n");
-
-      /* Don't write HTML at all */
-      Gbl.Layout.HTMLStartWritten =
-      Gbl.Layout.DivsEndWritten   =
-      Gbl.Layout.HTMLEndWritten   = true;
+      fwrite (Output->Buffer,sizeof (char),Output->Length,stdout);
+      Output->BytesSent += Output->Length;
+     }
 
-      return false;
+   Output->Length = 0;
+  }
+
+/*****************************************************************************/
+/************************ Free compressor of HTML output *********************/
+/*****************************************************************************/
+
+static void Fil_EndCompressionOfHTMLOutput (struct Fil_OutputBuffer *Output)
+  {
+   if (Output->Compress)
+     {
+      deflateEnd (&Output->Stream);
+      Output->Compress = false;
      }
-   rewind (Gbl.F.Tmp);
+  }
 
-   return true;
+/*****************************************************************************/
+/******** Write HTTP response when reading of stdin has been aborted *********/
+/*****************************************************************************/
+
+void Fil_WriteErrorUploadAborted (bool FileIsTooBig)
+  {
+   extern const char *Txt_UPLOAD_FILE_File_too_large_maximum_X_MiB_NO_HTML;
+   extern const char *Txt_UPLOAD_FILE_Upload_time_too_long_maximum_X_minutes_NO_HTML;
+
+   Fil_EndOfReadingStdin ();  // If stdin were not fully read, there will be problems with buffers
+
+   /* Start HTTP response */
+   fprintf (stdout,"Content-type: text/plain; charset=windows-1252\n");
+
+   /* Status code and message */
+   fprintf (stdout,"Status: 501 Not Implemented\r\n\r\n");
+   if (FileIsTooBig)
+      fprintf (stdout,Txt_UPLOAD_FILE_File_too_large_maximum_X_MiB_NO_HTML,
+	       (unsigned long) (Fil_MAX_FILE_SIZE / (1024ULL * 1024ULL)));
+   else
+      fprintf (stdout,Txt_UPLOAD_FILE_Upload_time_too_long_maximum_X_minutes_NO_HTML,
+	       (unsigned long) (Cfg_TIME_TO_ABORT_FILE_UPLOAD / 60UL));
+   fprintf (stdout,"\n");
+
+   /* Don't write HTML at all */
+   Gbl.Layout.HTMLStartWritten =
+   Gbl.Layout.DivsEndWritten   =
+   Gbl.Layout.HTMLEndWritten   = true;
   }
 
 /*****************************************************************************/
@@ -168,8 +414,51 @@ bool Fil_ReadStdinIntoTmpFile (void)
 
 void Fil_EndOfReadingStdin (void)
   {
-   while (!feof (stdin))
-      fgetc (stdin);
+   char Bytes[NUM_BYTES_PER_CHUNK];
+
+   while (fread (Bytes,1,sizeof (Bytes),stdin) == sizeof (Bytes));
+  }
+
+/*****************************************************************************/
+/************ Create a temporary file for a file being uploaded **************/
+/*****************************************************************************/
+// It's created in the same filesystem as file browsers,
+// so it can be moved to its destination instead of copied.
+// On success, *PathTmpFile is allocated and must be freed by the caller
+
+FILE *Fil_CreateTmpFileForUpload (char **PathTmpFile)
+  {
+   static unsigned long NumFile = 0;	// Several files can be uploaded in a request,
+					// and several requests can be served by a process
+   char Path[PATH_MAX + 1];
+   int FileDescriptor;
+   FILE *FileTmp;
+
+   /***** Create directory for temporary files if it does not exist *****/
+   Fil_CreateDirIfNotExists (Cfg_PATH_UPLOAD_PRIVATE);
+
+   /***** Create a new file with a unique name *****/
+   snprintf (Path,sizeof (Path),
+	     "%s/%ld_%d_%lu",
+	     Cfg_PATH_UPLOAD_PRIVATE,
+	     (long) Gbl.StartExecutionTimeUTC,(int) Gbl.PID,NumFile++);
+   if ((FileDescriptor = open (Path,O_WRONLY | O_CREAT | O_EXCL,0666)) < 0)
+      return NULL;
+   if ((FileTmp = fdopen (FileDescriptor,"wb")) == NULL)
+     {
+      close (FileDescriptor);
+      unlink (Path);
+      return NULL;
+     }
+
+   /***** Return path to temporary file *****/
+   if ((*PathTmpFile = strdup (Path)) == NULL)
+     {
+      fclose (FileTmp);
+      unlink (Path);
+      return NULL;
+     }
+   return FileTmp;
   }
 
 /*****************************************************************************/
@@ -227,7 +516,7 @@ struct Param *Fil_StartReceptionOfFile (const char *ParamFile,
 
    /***** Get filename *****/
    /* Check if filename exists */
-   if (Param->FileName.Start == 0 ||
+   if (Param->PathTmpFile == NULL ||
        Param->FileName.Length == 0)
      {
       FileName[0] = MIMEType[0] = '\0';
@@ -237,24 +526,19 @@ struct Param *Fil_StartReceptionOfFile (const char *ParamFile,
       Lay_ShowErrorAndExit ("Error while getting filename.");
 
    /* Copy filename */
-   fseek (Gbl.F.Tmp,Param->FileName.Start,SEEK_SET);
-   if (fread (FileName,sizeof (char),Param->FileName.Length,Gbl.F.Tmp) !=
-       Param->FileName.Length)
-      Lay_ShowErrorAndExit ("Error while getting filename.");
+   memcpy (FileName,&Gbl.Params.QueryString[Param->FileName.Start],
+	   Param->FileName.Length);
    FileName[Param->FileName.Length] = '\0';
 
    /***** Get MIME type *****/
    /* Check if MIME type exists */
-   if (Param->ContentType.Start == 0 ||
-       Param->ContentType.Length == 0 ||
+   if (Param->ContentType.Length == 0 ||
        Param->ContentType.Length > Brw_MAX_BYTES_MIME_TYPE)
       Lay_ShowErrorAndExit ("Error while getting content type.");
 
    /* Copy MIME type */
-   fseek (Gbl.F.Tmp,Param->ContentType.Start,SEEK_SET);
-   if (fread (MIMEType,sizeof (char),Param->ContentType.Length,Gbl.F.Tmp) !=
-       Param->ContentType.Length)
-      Lay_ShowErrorAndExit ("Error while getting content type.");
+   memcpy (MIMEType,&Gbl.Params.QueryString[Param->ContentType.Start],
+	   Param->ContentType.Length);
    MIMEType[Param->ContentType.Length] = '\0';
 
    return Param;
@@ -266,42 +550,21 @@ struct Param *Fil_StartReceptionOfFile (const char *ParamFile,
 
 bool Fil_EndReceptionOfFile (char *FileNameDataTmp,struct Param *Param)
   {
-   FILE *FileDataTmp;
-   unsigned char Bytes[NUM_BYTES_PER_CHUNK];
-   size_t RemainingBytesToCopy;
-   size_t BytesToCopy;
-
-   /***** Open destination file *****/
-   if ((FileDataTmp = fopen (FileNameDataTmp,"wb")) == NULL)
-      Lay_ShowErrorAndExit ("Can not open temporary file.");
-
-   /***** Copy file *****/
-   /* Go to start of source */
-   if (Param->Value.Start == 0)
+   /***** Check that file content has been received *****/
+   if (Param->PathTmpFile == NULL ||
+       Param->PathTmpFile[0] == '\0')	// Already moved
       Lay_ShowErrorAndExit ("Error while copying file.");
-   fseek (Gbl.F.Tmp,Param->Value.Start,SEEK_SET);
 
-   /* Copy part of Gbl.F.Tmp to FileDataTmp */
-   for (RemainingBytesToCopy = Param->Value.Length;
-	RemainingBytesToCopy != 0;
-	RemainingBytesToCopy -= BytesToCopy)
+   /***** Move temporary file to destination *****/
+   if (rename (Param->PathTmpFile,FileNameDataTmp))
      {
-      BytesToCopy = (RemainingBytesToCopy >= NUM_BYTES_PER_CHUNK) ? NUM_BYTES_PER_CHUNK :
-	                                                            RemainingBytesToCopy;
-      if (fread (Bytes,1,BytesToCopy,Gbl.F.Tmp) != BytesToCopy)
-	{
-         fclose (FileDataTmp);
+      /* Destination is in another filesystem ==> copy and remove */
+      if (errno != EXDEV)
 	 return false;
-	}
-      if (fwrite (Bytes,sizeof (Bytes[0]),BytesToCopy,FileDataTmp) != BytesToCopy)
-	{
-         fclose (FileDataTmp);
-	 return false;
-	}
+      Fil_FastCopyOfFiles (Param->PathTmpFile,FileNameDataTmp);
+      unlink (Param->PathTmpFile);
      }
-
-   /***** Close destination file *****/
-   fclose (FileDataTmp);
+   Param->PathTmpFile[0] = '\0';	// Temporary file no longer exists
 
    return true;
   }
@@ -48,7 +48,6 @@
 struct Files
   {
    FILE *Out;		// File with the HTML output of this CGI
-   FILE *Tmp;		// Temporary file to save stdin
    FILE *XML;		// XML file for syllabus, for directory tree
    FILE *Rep;		// Temporary file to save report
   };
@@ -59,10 +58,15 @@ struct Files
 /***************************** Public prototypes *****************************/
 /*****************************************************************************/
 
-void Fil_CreateFileForHTMLOutput (void);
-void Fil_CloseAndRemoveFileForHTMLOutput (void);
-bool Fil_ReadStdinIntoTmpFile (void);
+void Fil_CreateBufferForHTMLOutput (void);
+bool Fil_StartCompressionOfHTMLOutput (void);
+void Fil_EnableEarlyFlushOfHTMLOutput (void);
+void Fil_FlushHTMLOutput (void);
+void Fil_SendHTMLOutput (void);
+void Fil_SendAndCloseHTMLOutput (void);
+void Fil_WriteErrorUploadAborted (bool FileIsTooBig);
 void Fil_EndOfReadingStdin (void);
+FILE *Fil_CreateTmpFileForUpload (char **PathTmpFile);
 struct Param *Fil_StartReceptionOfFile (const char *ParamFile,
                                         char *FileName,char *MIMEType);
 bool Fil_EndReceptionOfFile (char *FileNameDataTmp,struct Param *Param);
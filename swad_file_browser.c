@@ -55,6 +55,7 @@
 #include "swad_photo.h"
 #include "swad_profile.h"
 #include "swad_role.h"
+#include "swad_search.h"
 #include "swad_string.h"
 #include "swad_timeline.h"
 #include "swad_zip.h"
@@ -7655,11 +7656,11 @@ static long Brw_GetWorksUsrCodForExpandedFolders (void)
 
 void Brw_RemoveExpiredExpandedFolders (void)
   {
-   /***** Remove all expired clipboards *****/
-   DB_QueryDELETE ("can not remove old expanded folders",
-		   "DELETE LOW_PRIORITY FROM expanded_folders"
-		   " WHERE ClickTime<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
-                   Cfg_TIME_TO_DELETE_BROWSER_EXPANDED_FOLDERS);
+   /***** Remove all expired expanded folders in small batches *****/
+   DB_QueryDELETEinBatches ("can not remove old expanded folders",
+			    "DELETE LOW_PRIORITY FROM expanded_folders"
+			    " WHERE ClickTime<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
+			    Cfg_TIME_TO_DELETE_BROWSER_EXPANDED_FOLDERS);
   }
 
 /*****************************************************************************/
@@ -8866,7 +8867,7 @@ static bool Brw_RcvFileInFileBrw (Brw_UploadType_t UploadType)
    /***** Check if creating a new file is allowed *****/
    if (Brw_CheckIfICanCreateIntoFolder (Gbl.FileBrowser.Level))
      {
-      /***** First, we save in disk the file from stdin (really from Gbl.F.Tmp) *****/
+      /***** First, we save in disk the file from stdin (really from a temporary file) *****/
       Param = Fil_StartReceptionOfFile (Fil_NAME_OF_PARAM_FILENAME_ORG,
                                         SrcFileName,MIMEType);
 
@@ -11124,9 +11125,10 @@ long Brw_AddPathToDB (long PublisherUsrCod,Brw_FileType_t FileType,
   {
    long Cod = Brw_GetCodForFiles ();
    long ZoneUsrCod = Brw_GetZoneUsrCodForFiles ();
+   long FilCod;
 
    /***** Add path to the database *****/
-   return
+   FilCod =
    DB_QueryINSERTandReturnCode ("can not add path to database",
 				"INSERT INTO files"
 				" (FileBrowser,Cod,ZoneUsrCod,"
@@ -11142,6 +11144,11 @@ long Brw_AddPathToDB (long PublisherUsrCod,Brw_FileType_t FileType,
 				IsPublic ? 'Y' :
 					   'N',
 				(unsigned) License);
+
+   /***** Add file name to index of words used in searches *****/
+   Sch_UpdateIndexOfFile (FilCod,FullPathInTree);
+
+   return FilCod;
   }
 
 /*****************************************************************************/
@@ -11180,6 +11187,16 @@ static void Brw_RemoveOneFileOrFolderFromDB (const char Path[PATH_MAX + 1])
 		  " AND files.FilCod=file_view.FilCod",
 	          (unsigned) FileBrowser,Cod,ZoneUsrCod,Path);
 
+   /***** Remove from index of words used in searches *****/
+   DB_QueryDELETE ("can not remove file from index",
+		  "DELETE FROM sch_words USING files,sch_words"
+		  " WHERE files.FileBrowser=%u AND files.Cod=%ld"
+		  " AND files.ZoneUsrCod=%ld"
+		  " AND files.Path='%s'"
+		  " AND sch_words.Type=%u AND sch_words.Cod=files.FilCod",
+	          (unsigned) FileBrowser,Cod,ZoneUsrCod,Path,
+	          (unsigned) Sch_INDEX_FILES);
+
    /***** Remove from database the entry that stores the data of a file *****/
    DB_QueryDELETE ("can not remove path from database",
 		   "DELETE FROM files"
@@ -11224,6 +11241,16 @@ static void Brw_RemoveChildrenOfFolderFromDB (const char Path[PATH_MAX + 1])
 		  " AND files.FilCod=file_view.FilCod",
                   (unsigned) FileBrowser,Cod,ZoneUsrCod,Path);
 
+   /***** Remove from index of words used in searches *****/
+   DB_QueryDELETE ("can not remove files from index",
+		  "DELETE FROM sch_words USING files,sch_words"
+		  " WHERE files.FileBrowser=%u AND files.Cod=%ld"
+		  " AND files.ZoneUsrCod=%ld"
+		  " AND files.Path LIKE '%s/%%'"
+		  " AND sch_words.Type=%u AND sch_words.Cod=files.FilCod",
+                  (unsigned) FileBrowser,Cod,ZoneUsrCod,Path,
+	          (unsigned) Sch_INDEX_FILES);
+
    /***** Remove from database the entries that store the data of files *****/
    DB_QueryDELETE ("can not remove paths from database",
 		   "DELETE FROM files"
@@ -11250,6 +11277,11 @@ static void Brw_RenameOneFolderInDB (const char OldPath[PATH_MAX + 1],
 		   (unsigned) Brw_FileBrowserForDB_files[Gbl.FileBrowser.Type],
 		   Cod,ZoneUsrCod,
 		   OldPath);
+
+   /***** Update index of words used in searches.
+          Only the name of this file or folder is changed,
+          names of its children are the same *****/
+   Sch_UpdateIndexOfFile (Brw_GetFilCodByPath (NewPath,false),NewPath);
   }
 
 /*****************************************************************************/
@@ -25,10 +25,12 @@
 /********************************* Headers ***********************************/
 /*****************************************************************************/
 
-#include <stdlib.h>	// For exit
+#include <time.h>		// For time
 
 #include "swad_database.h"
+#include "swad_firewall_table.h"
 #include "swad_global.h"
+#include "swad_worker.h"
 
 /*****************************************************************************/
 /************** External global variables from others modules ****************/
@@ -40,24 +42,17 @@ extern struct Globals Gbl;
 /***************************** Private constants *****************************/
 /*****************************************************************************/
 
-/* The maximum number of clicks in the interval
-   should be large enough to prevent an IP from being banned
-   due to automatic refresh when the user is viewing the last clicks. */
-#define Fw_CHECK_INTERVAL		((time_t)(10UL))	// Check clicks in the last 10 seconds
-#define Fw_MAX_CLICKS_IN_INTERVAL	100			// Maximum of 100 clicks allowed in 10 seconds
-
 #define Fw_TIME_BANNED			((time_t)(60UL*60UL))	// Ban IP for 1 hour
 
 #define Fw_TIME_TO_DELETE_OLD_CLICKS	Fw_CHECK_INTERVAL	// Remove clicks older than these seconds
 
-/*****************************************************************************/
-/******************************* Private types *******************************/
-/*****************************************************************************/
-
 /*****************************************************************************/
 /****************************** Private prototypes ***************************/
 /*****************************************************************************/
 
+static bool FW_AttachSharedTable (void);
+static void FW_LoadBannedIPsIntoSharedTable (void);
+
 static void FW_BanIP (void);
 
 static void FW_WriteHTML (const char *Title,const char *H1);
@@ -68,7 +63,21 @@ static void FW_WriteHTML (const char *Title,const char *H1);
 
 void FW_LogAccess (void)
   {
+   bool Counted;
+
+   /***** Count click in shared table *****/
+   if (FW_AttachSharedTable ())
+     {
+      FwT_LockSharedTable ();
+      Counted = FwT_CountClick (Gbl.IP,time (NULL));
+      FwT_UnlockSharedTable ();
+      if (Counted)
+	 return;
+      // No slot available for this IP ==> count click in database
+     }
+
    /***** Log access in firewall recent log *****/
+   DB_OpenDBConnection ();
    DB_QueryINSERT ("can not log access into firewall_log",
 		   "INSERT INTO firewall_log"
 		   " (ClickTime,IP)"
@@ -84,10 +93,10 @@ void FW_LogAccess (void)
 void FW_PurgeFirewall (void)
   {
    /***** Remove old clicks *****/
-   DB_QueryDELETE ("can not purge firewall log",
-		   "DELETE LOW_PRIORITY FROM firewall_log"
-		   " WHERE ClickTime<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
-                   (unsigned long) Fw_TIME_TO_DELETE_OLD_CLICKS);
+   DB_QueryDELETEinBatches ("can not purge firewall log",
+			    "DELETE LOW_PRIORITY FROM firewall_log"
+			    " WHERE ClickTime<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
+			    (unsigned long) Fw_TIME_TO_DELETE_OLD_CLICKS);
   }
 
 /*****************************************************************************/
@@ -96,13 +105,34 @@ void FW_PurgeFirewall (void)
 
 void FW_CheckFirewallAndExitIfBanned (void)
   {
-   unsigned long NumCurrentBans;
+   unsigned long NumCurrentBans = 0;
+   FwT_Ban_t Ban = FwT_CHECK_IN_DB;
 
-   /***** Get number of current bans from database *****/
-   NumCurrentBans = DB_QueryCOUNT ("can not check firewall log",
-		                   "SELECT COUNT(*) FROM firewall_banned"
-			           " WHERE IP='%s' AND UnbanTime>NOW()",
-			           Gbl.IP);
+   if (FW_AttachSharedTable ())
+     {
+      /***** Check ban in shared table *****/
+      FwT_LockSharedTable ();
+      Ban = FwT_CheckBan (Gbl.IP,time (NULL));
+      FwT_UnlockSharedTable ();
+     }
+
+   switch (Ban)
+     {
+      case FwT_NOT_BANNED:
+	 NumCurrentBans = 0;
+	 break;
+      case FwT_BANNED:
+	 NumCurrentBans = 1;
+	 break;
+      case FwT_CHECK_IN_DB:
+	 /***** Get number of current bans from database *****/
+	 DB_OpenDBConnection ();
+	 NumCurrentBans = DB_QueryCOUNT ("can not check firewall log",
+					 "SELECT COUNT(*) FROM firewall_banned"
+					 " WHERE IP='%s' AND UnbanTime>NOW()",
+					 Gbl.IP);
+	 break;
+     }
 
    /***** Exit with status 403 if banned *****/
    /* RFC 6585 suggests "403 Forbidden", according to
@@ -116,8 +146,7 @@ void FW_CheckFirewallAndExitIfBanned (void)
       FW_WriteHTML ("Forbidden","You are temporarily banned");
 
       /* Close database connection and exit */
-      DB_CloseDBConnection ();
-      exit (0);
+      Wrk_EndRequest ();
      }
   }
 
@@ -127,15 +156,31 @@ void FW_CheckFirewallAndExitIfBanned (void)
 
 void FW_CheckFirewallAndExitIfTooManyRequests (void)
   {
-   unsigned long NumClicks;
+   unsigned long NumClicks = 0;
+   unsigned NumClicksInTable;
+   bool InTable = false;
+
+   if (FW_AttachSharedTable ())
+     {
+      /***** Get number of clicks from shared table *****/
+      FwT_LockSharedTable ();
+      if ((InTable = FwT_GetNumClicks (Gbl.IP,time (NULL),&NumClicksInTable)))
+	 NumClicks = (unsigned long) NumClicksInTable;
+      FwT_UnlockSharedTable ();
+     }
 
-   /***** Get number of clicks from database *****/
-   NumClicks = DB_QueryCOUNT ("can not check firewall log",
-		              "SELECT COUNT(*) FROM firewall_log"
-			      " WHERE IP='%s'"
-			      " AND ClickTime>FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
-			      Gbl.IP,
-                              Fw_CHECK_INTERVAL);
+   // If there is no slot for this IP, its clicks are counted in database
+   if (!InTable)
+     {
+      /***** Get number of clicks from database *****/
+      DB_OpenDBConnection ();
+      NumClicks = DB_QueryCOUNT ("can not check firewall log",
+				 "SELECT COUNT(*) FROM firewall_log"
+				 " WHERE IP='%s'"
+				 " AND ClickTime>FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
+				 Gbl.IP,
+				 Fw_CHECK_INTERVAL);
+     }
 
    /***** Exit with status 429 if too many connections *****/
    /* RFC 6585 suggests "429 Too Many Requests", according to
@@ -154,8 +199,7 @@ void FW_CheckFirewallAndExitIfTooManyRequests (void)
       FW_WriteHTML ("Too Many Requests","Please stop that");
 
       /* Close database connection and exit */
-      DB_CloseDBConnection ();
-      exit (0);
+      Wrk_EndRequest ();
      }
   }
 
@@ -165,7 +209,16 @@ void FW_CheckFirewallAndExitIfTooManyRequests (void)
 
 static void FW_BanIP (void)
   {
+   /***** Ban IP in shared table *****/
+   if (FW_AttachSharedTable ())
+     {
+      FwT_LockSharedTable ();
+      FwT_BanIP (Gbl.IP,time (NULL) + Fw_TIME_BANNED);
+      FwT_UnlockSharedTable ();
+     }
+
    /***** Insert IP into table of banned IPs *****/
+   DB_OpenDBConnection ();
    DB_QueryINSERT ("can not ban IP",
 		   "INSERT INTO firewall_banned"
 		   " (IP,BanTime,UnbanTime)"
@@ -175,7 +228,7 @@ static void FW_BanIP (void)
   }
 
 /*****************************************************************************/
-/********************************* Ban an IP *********************************/
+/******************* Write simple HTML page for firewall *********************/
 /*****************************************************************************/
 
 static void FW_WriteHTML (const char *Title,const char *H1)
@@ -190,3 +243,58 @@ static void FW_WriteHTML (const char *Title,const char *H1)
 		   "</html>\n",
 	    Title,H1);
   }
+
+/*****************************************************************************/
+/*************** Attach shared table used to count clicks ********************/
+/*****************************************************************************/
+// Return true if shared table is available
+
+static bool FW_AttachSharedTable (void)
+  {
+   bool MustLoadBans;
+
+   if (!FwT_AttachSharedTable (FwT_SHM_NAME,&MustLoadBans))
+      return false;
+
+   /***** Load bans stored in database into a just created table *****/
+   if (MustLoadBans)
+      FW_LoadBannedIPsIntoSharedTable ();
+
+   return true;
+  }
+
+/*****************************************************************************/
+/************* Load current bans from database into shared table *************/
+/*****************************************************************************/
+
+static void FW_LoadBannedIPsIntoSharedTable (void)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows;
+   unsigned long NumRow;
+   time_t UnbanTime;
+
+   /***** Get current bans from database *****/
+   DB_OpenDBConnection ();
+   NumRows = DB_QuerySELECT (&mysql_res,"can not get banned IPs",
+			     "SELECT IP,"				// row[0]
+				    "UNIX_TIMESTAMP(UnbanTime)"		// row[1]
+			     " FROM firewall_banned"
+			     " WHERE UnbanTime>NOW()");
+
+   /***** Copy bans into shared table *****/
+   FwT_LockSharedTable ();
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      if (sscanf (row[1],"%ld",&UnbanTime) == 1)
+	 FwT_BanIP (row[0],UnbanTime);
+     }
+   FwT_UnlockSharedTable ();
+
+   /***** Free structure that stores the query result *****/
+   DB_FreeMySQLResult (&mysql_res);
+  }
@@ -0,0 +1,308 @@
+// swad_firewall_bench_main.c: main of swad_firewall_bench, stress test of the firewall shared table
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <stdbool.h>		// For boolean type
+#include <stdio.h>		// For fprintf, printf, snprintf
+#include <stdlib.h>		// For atoi, calloc, exit
+#include <sys/time.h>		// For gettimeofday
+#include <sys/wait.h>		// For wait
+#include <time.h>		// For time
+#include <unistd.h>		// For fork, pipe, read, write, close, usleep
+
+#include "swad_firewall_table.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define FwB_SHM_NAME	"/swad_firewall_bench"	// Not the table used by swad
+#define FwB_MAX_BYTES_IP 15
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+struct FwB_Result
+  {
+   unsigned long NumRequests;		// Requests made
+   unsigned long NumRejected;		// Requests rejected because IP was banned
+   unsigned long NumClicksInDB;		// Clicks which would be counted in database
+   unsigned long NumIPsBanned;		// IPs banned by shared table
+   unsigned long NumIPsNeverInTable;	// IPs whose clicks were always counted in database
+  };
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void FwB_RunProcesses (unsigned NumProcesses,unsigned NumIPsPerProcess,
+                              unsigned ClicksPerSecond,unsigned NumSeconds);
+static void FwB_RunOneProcess (unsigned NumProcess,unsigned NumIPs,
+                               unsigned ClicksPerSecond,unsigned NumSeconds,
+                               struct FwB_Result *Result);
+static double FwB_GetSeconds (void);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_firewall_bench <processes> <IPs per process>
+                              <clicks per second per IP> <seconds>
+   The given number of processes (as many as web server processes)
+   make requests during the given number of seconds,
+   each one from its own set of IPs, in turn,
+   with the given rate of clicks from each IP (0 = as fast as possible).
+   Each request does the same as swad with the firewall shared table:
+   check ban, count click, get number of clicks and ban if too many.
+   With more IPs than slots in the table (for example a botnet),
+   the IPs which get a slot must be banned,
+   and the rest must be counted in database.
+   For example, 8 processes x 1000 IPs, each one a bit above the limit
+   of clicks allowed, during 30 seconds:
+      swad_firewall_bench 8 1000 20 30
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumProcesses;
+   int NumIPsPerProcess;
+   int ClicksPerSecond;
+   int NumSeconds;
+
+   if (argc != 5 ||
+       (NumProcesses     = atoi (argv[1])) <= 0 ||
+       (NumIPsPerProcess = atoi (argv[2])) <= 0 ||
+       (ClicksPerSecond  = atoi (argv[3])) <  0 ||
+       (NumSeconds       = atoi (argv[4])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s <processes> <IPs per process>"
+		      " <clicks per second per IP> <seconds>\n",
+	       argv[0]);
+      return 1;
+     }
+
+   FwT_RemoveSharedTable (FwB_SHM_NAME);	// Start with an empty table
+   FwB_RunProcesses ((unsigned) NumProcesses,(unsigned) NumIPsPerProcess,
+		     (unsigned) ClicksPerSecond,(unsigned) NumSeconds);
+   FwT_RemoveSharedTable (FwB_SHM_NAME);
+   return 0;
+  }
+
+/*****************************************************************************/
+/************* Run several processes at the same time and write results ******/
+/*****************************************************************************/
+
+static void FwB_RunProcesses (unsigned NumProcesses,unsigned NumIPsPerProcess,
+                              unsigned ClicksPerSecond,unsigned NumSeconds)
+  {
+   unsigned NumProcess;
+   int Pipe[2];
+   struct FwB_Result ResultInProcess;
+   struct FwB_Result Result = {0,0,0,0,0};
+   double Start;
+   double Seconds;
+
+   /***** Each process writes its results in this pipe *****/
+   if (pipe (Pipe))
+     {
+      fprintf (stderr,"Can not create pipe.\n");
+      exit (1);
+     }
+
+   Start = FwB_GetSeconds ();
+
+   /***** Launch processes *****/
+   for (NumProcess = 0;
+	NumProcess < NumProcesses;
+	NumProcess++)
+      switch (fork ())
+	{
+	 case -1:
+	    fprintf (stderr,"Can not create process.\n");
+	    exit (1);
+	 case 0:	// Child
+	    close (Pipe[0]);
+	    FwB_RunOneProcess (NumProcess,NumIPsPerProcess,
+			       ClicksPerSecond,NumSeconds,
+			       &ResultInProcess);
+	    if (write (Pipe[1],&ResultInProcess,sizeof (ResultInProcess)) !=
+		(ssize_t) sizeof (ResultInProcess))
+	       exit (1);
+	    exit (0);
+	 default:	// Parent
+	    break;
+	}
+
+   /***** Wait for all processes *****/
+   close (Pipe[1]);
+   while (read (Pipe[0],&ResultInProcess,sizeof (ResultInProcess)) ==
+	  (ssize_t) sizeof (ResultInProcess))
+     {
+      Result.NumRequests        += ResultInProcess.NumRequests;
+      Result.NumRejected        += ResultInProcess.NumRejected;
+      Result.NumClicksInDB      += ResultInProcess.NumClicksInDB;
+      Result.NumIPsBanned       += ResultInProcess.NumIPsBanned;
+      Result.NumIPsNeverInTable += ResultInProcess.NumIPsNeverInTable;
+     }
+   close (Pipe[0]);
+   while (wait (NULL) > 0);
+
+   Seconds = FwB_GetSeconds () - Start;
+
+   /***** Write results *****/
+   printf ("%u processes x %u IPs, %u slots in table\n",
+	   NumProcesses,NumIPsPerProcess,FwT_NUM_SLOTS);
+   printf ("%lu requests in %.2f s, %.1f requests/s\n",
+	   Result.NumRequests,Seconds,
+	   Seconds > 0.0 ? (double) Result.NumRequests / Seconds :
+			   0.0);
+   printf ("%lu requests rejected, %lu clicks counted in database\n",
+	   Result.NumRejected,Result.NumClicksInDB);
+   printf ("%lu IPs banned by shared table, %lu IPs always counted in database\n",
+	   Result.NumIPsBanned,Result.NumIPsNeverInTable);
+  }
+
+/*****************************************************************************/
+/********* Make requests from several IPs, in turn, and get results **********/
+/*****************************************************************************/
+
+static void FwB_RunOneProcess (unsigned NumProcess,unsigned NumIPs,
+                               unsigned ClicksPerSecond,unsigned NumSeconds,
+                               struct FwB_Result *Result)
+  {
+   char (*IPs)[FwB_MAX_BYTES_IP + 1];
+   bool *Banned;
+   bool *InTable;
+   bool MustLoadBans;
+   unsigned NumIP;
+   unsigned NumClicks;
+   time_t Now;
+   time_t End = time (NULL) + (time_t) NumSeconds;
+   double StartOfTurn;
+   double Wait;
+
+   Result->NumRequests        = 0;
+   Result->NumRejected        = 0;
+   Result->NumClicksInDB      = 0;
+   Result->NumIPsBanned       = 0;
+   Result->NumIPsNeverInTable = 0;
+
+   if (!FwT_AttachSharedTable (FwB_SHM_NAME,&MustLoadBans))
+     {
+      fprintf (stderr,"Can not attach shared table.\n");
+      exit (1);
+     }
+
+   /***** IPs of this process *****/
+   if ((IPs     = calloc (NumIPs,sizeof (*IPs    ))) == NULL ||
+       (Banned  = calloc (NumIPs,sizeof (*Banned ))) == NULL ||
+       (InTable = calloc (NumIPs,sizeof (*InTable))) == NULL)
+     {
+      fprintf (stderr,"Not enough memory.\n");
+      exit (1);
+     }
+   for (NumIP = 0;
+	NumIP < NumIPs;
+	NumIP++)
+      snprintf (IPs[NumIP],sizeof (IPs[NumIP]),"10.%u.%u.%u",
+		NumProcess & 255,(NumIP >> 8) & 255,NumIP & 255);
+
+   /***** Make requests *****/
+   while (time (NULL) < End)
+     {
+      /***** A turn: one click from each IP *****/
+      StartOfTurn = FwB_GetSeconds ();
+      for (NumIP = 0;
+	   NumIP < NumIPs;
+	   NumIP++)
+	{
+	 Now = time (NULL);
+	 Result->NumRequests++;
+	 FwT_LockSharedTable ();
+
+	 /* Check ban */
+	 if (FwT_CheckBan (IPs[NumIP],Now) == FwT_BANNED)
+	   {
+	    FwT_UnlockSharedTable ();
+	    Result->NumRejected++;
+	    continue;
+	   }
+
+	 /* Count click */
+	 if (FwT_CountClick (IPs[NumIP],Now))
+	   {
+	    InTable[NumIP] = true;
+
+	    /* Ban if too many clicks */
+	    if (FwT_GetNumClicks (IPs[NumIP],Now,&NumClicks))
+	       if (NumClicks > Fw_MAX_CLICKS_IN_INTERVAL)
+		 {
+		  FwT_BanIP (IPs[NumIP],Now + 60 * 60);
+		  if (!Banned[NumIP])
+		    {
+		     Banned[NumIP] = true;
+		     Result->NumIPsBanned++;
+		    }
+		 }
+	   }
+	 else
+	    Result->NumClicksInDB++;
+
+	 FwT_UnlockSharedTable ();
+	}
+
+      /***** Wait until next turn *****/
+      if (ClicksPerSecond)
+	{
+	 Wait = 1.0 / (double) ClicksPerSecond - (FwB_GetSeconds () - StartOfTurn);
+	 if (Wait > 0.0)
+	    usleep ((useconds_t) (Wait * 1E6));
+	}
+     }
+
+   for (NumIP = 0;
+	NumIP < NumIPs;
+	NumIP++)
+      if (!InTable[NumIP])
+	 Result->NumIPsNeverInTable++;
+
+   free (InTable);
+   free (Banned);
+   free (IPs);
+  }
+
+/*****************************************************************************/
+/************************ Get current time in seconds ************************/
+/*****************************************************************************/
+
+static double FwB_GetSeconds (void)
+  {
+   struct timeval Now;
+
+   gettimeofday (&Now,NULL);
+   return (double) Now.tv_sec + (double) Now.tv_usec / 1E6;
+  }
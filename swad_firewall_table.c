@@ -0,0 +1,405 @@
+// swad_firewall_table.c: table in shared memory to count clicks per IP
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************* Headers ***********************************/
+/*****************************************************************************/
+
+#include <errno.h>		// For errno
+#include <fcntl.h>		// For O_* constants
+#include <pthread.h>		// For process-shared mutex
+#include <string.h>		// For string functions
+#include <sys/mman.h>		// For shm_open, mmap
+#include <sys/stat.h>		// For fstat
+#include <unistd.h>		// For ftruncate, usleep
+
+#include "swad_constant.h"
+#include "swad_firewall_table.h"
+
+/*****************************************************************************/
+/***************************** Private constants *****************************/
+/*****************************************************************************/
+
+/* Clicks are counted in a table in shared memory,
+   shared by all the processes running this CGI,
+   so no database query is necessary in most requests.
+   This module does not use the database,
+   so it can be linked in a stress test */
+#define FwT_MAX_PROBES			16	// Maximum number of slots checked for each IP
+#define FwT_MAX_WAITS_FOR_INIT		100	// Wait at most 100 x 10 ms for another process initializing table
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+struct FwT_Slot
+  {
+   char IP[Cns_MAX_BYTES_IP + 1];
+   time_t LastClick;				// Time of last click from this IP
+   time_t UnbanTime;				// If > now ==> IP is banned
+   time_t Seconds[Fw_CHECK_INTERVAL];		// Second corresponding to each counter
+   unsigned Clicks[Fw_CHECK_INTERVAL];		// Number of clicks in each second
+  };
+
+struct FwT_SharedTable
+  {
+   int Initialized;				// Set when table is ready to be used
+   pthread_mutex_t Mutex;			// Process-shared mutex protecting slots
+   time_t UnbanTimeNotInTable;			// If > now ==> some ban could not be stored
+						// in table and must be checked in database
+   struct FwT_Slot Slots[FwT_NUM_SLOTS];
+  };
+
+/*****************************************************************************/
+/***************************** Private variables *****************************/
+/*****************************************************************************/
+
+static struct
+  {
+   bool Tried;					// Have I tried to attach shared table?
+   struct FwT_SharedTable *Table;		// NULL if shared table is not available
+  } FwT_Shm =
+  {
+   .Tried = false,
+   .Table = NULL,
+  };
+
+/*****************************************************************************/
+/****************************** Private prototypes ***************************/
+/*****************************************************************************/
+
+static bool FwT_CreateSharedTable (const char *Name,int fd);
+static bool FwT_WaitForSharedTable (const char *Name,int fd);
+static struct FwT_Slot *FwT_GetSlot (const char *IP,time_t Now,bool Create);
+static unsigned FwT_GetNumClicksInSlot (const struct FwT_Slot *Slot,time_t Now);
+
+/*****************************************************************************/
+/*************** Attach shared table used to count clicks ********************/
+/*****************************************************************************/
+// Return true if shared table is available.
+// MustLoadBans is set to true only in the process
+// that must load the bans stored in database into a just created table
+
+bool FwT_AttachSharedTable (const char *Name,bool *MustLoadBans)
+  {
+   int fd;
+   bool Attached;
+
+   *MustLoadBans = false;
+
+   /***** Try only once per process *****/
+   if (FwT_Shm.Tried)
+      return (FwT_Shm.Table != NULL);
+   FwT_Shm.Tried = true;
+
+   /***** Create shared table, or open it if it already exists *****/
+   if ((fd = shm_open (Name,O_RDWR | O_CREAT | O_EXCL,0600)) >= 0)
+      Attached = FwT_CreateSharedTable (Name,fd);
+   else if (errno == EEXIST &&
+	    (fd = shm_open (Name,O_RDWR,0600)) >= 0)
+      Attached = FwT_WaitForSharedTable (Name,fd);
+   else
+      return false;
+   close (fd);	// Mapping remains valid after closing file descriptor
+
+   if (!Attached)
+      return false;
+
+   /***** Bans stored in database must be loaded into a just created table *****/
+   if (FwT_Shm.Table->Initialized == 1)
+     {
+      FwT_LockSharedTable ();
+      if (FwT_Shm.Table->Initialized == 1)	// Nobody has loaded bans yet
+	{
+	 FwT_Shm.Table->Initialized = 2;
+	 *MustLoadBans = true;
+	}
+      FwT_UnlockSharedTable ();
+     }
+
+   return true;
+  }
+
+/*****************************************************************************/
+/************** Create shared table and initialize its mutex *****************/
+/*****************************************************************************/
+
+static bool FwT_CreateSharedTable (const char *Name,int fd)
+  {
+   pthread_mutexattr_t MutexAttr;
+   void *Ptr;
+
+   if (ftruncate (fd,(off_t) sizeof (struct FwT_SharedTable)))
+     {
+      shm_unlink (Name);
+      return false;
+     }
+   if ((Ptr = mmap (NULL,sizeof (struct FwT_SharedTable),
+		    PROT_READ | PROT_WRITE,MAP_SHARED,fd,0)) == MAP_FAILED)
+     {
+      shm_unlink (Name);
+      return false;
+     }
+   FwT_Shm.Table = (struct FwT_SharedTable *) Ptr;	// Zero-filled by ftruncate
+
+   /***** Initialize mutex shared between processes.
+	  If a process dies holding the mutex,
+	  robustness allows the next process to recover it *****/
+   pthread_mutexattr_init (&MutexAttr);
+   pthread_mutexattr_setpshared (&MutexAttr,PTHREAD_PROCESS_SHARED);
+   pthread_mutexattr_setrobust (&MutexAttr,PTHREAD_MUTEX_ROBUST);
+   pthread_mutex_init (&FwT_Shm.Table->Mutex,&MutexAttr);
+   pthread_mutexattr_destroy (&MutexAttr);
+
+   /***** Table is ready *****/
+   __atomic_store_n (&FwT_Shm.Table->Initialized,1,__ATOMIC_RELEASE);
+
+   return true;
+  }
+
+/*****************************************************************************/
+/*********** Wait for shared table being initialized by other process ********/
+/*****************************************************************************/
+
+static bool FwT_WaitForSharedTable (const char *Name,int fd)
+  {
+   struct stat FileStatus;
+   void *Ptr;
+   unsigned NumWaits;
+
+   for (NumWaits = 0;
+	NumWaits < FwT_MAX_WAITS_FOR_INIT;
+	NumWaits++)
+     {
+      /***** Map table when it has its final size *****/
+      if (!FwT_Shm.Table)
+	{
+	 if (fstat (fd,&FileStatus))
+	    return false;
+	 if ((size_t) FileStatus.st_size == sizeof (struct FwT_SharedTable))
+	   {
+	    if ((Ptr = mmap (NULL,sizeof (struct FwT_SharedTable),
+			     PROT_READ | PROT_WRITE,MAP_SHARED,fd,0)) == MAP_FAILED)
+	       return false;
+	    FwT_Shm.Table = (struct FwT_SharedTable *) Ptr;
+	   }
+	}
+
+      /***** Check if table is initialized *****/
+      if (FwT_Shm.Table)
+	 if (__atomic_load_n (&FwT_Shm.Table->Initialized,__ATOMIC_ACQUIRE))
+	    return true;
+
+      usleep (10000);	// 10 ms
+     }
+
+   /***** The process that created the table probably died
+	  before initializing it ==> remove it to be created again *****/
+   if (FwT_Shm.Table)
+     {
+      munmap (FwT_Shm.Table,sizeof (struct FwT_SharedTable));
+      FwT_Shm.Table = NULL;
+     }
+   shm_unlink (Name);
+   return false;
+  }
+
+/*****************************************************************************/
+/*************************** Remove shared table *****************************/
+/*****************************************************************************/
+// Processes which have it attached can go on using it
+
+void FwT_RemoveSharedTable (const char *Name)
+  {
+   shm_unlink (Name);
+  }
+
+/*****************************************************************************/
+/********************** Lock/unlock shared table *****************************/
+/*****************************************************************************/
+
+void FwT_LockSharedTable (void)
+  {
+   /***** If the owner of the mutex died, recover it.
+	  Counters may be a bit inconsistent, but it doesn't matter *****/
+   if (pthread_mutex_lock (&FwT_Shm.Table->Mutex) == EOWNERDEAD)
+      pthread_mutex_consistent (&FwT_Shm.Table->Mutex);
+  }
+
+void FwT_UnlockSharedTable (void)
+  {
+   pthread_mutex_unlock (&FwT_Shm.Table->Mutex);
+  }
+
+/*****************************************************************************/
+/************************ Count a click from an IP ***************************/
+/*****************************************************************************/
+// Shared table must be locked
+// Return false if there is no slot for this IP
+// (click must be counted in database)
+
+bool FwT_CountClick (const char *IP,time_t Now)
+  {
+   struct FwT_Slot *Slot;
+   unsigned Index = (unsigned) (Now % Fw_CHECK_INTERVAL);
+
+   if ((Slot = FwT_GetSlot (IP,Now,true)) == NULL)
+      return false;
+
+   if (Slot->Seconds[Index] != Now)	// Counter belongs to an old second
+     {
+      Slot->Seconds[Index] = Now;
+      Slot->Clicks[Index] = 0;
+     }
+   Slot->Clicks[Index]++;
+   Slot->LastClick = Now;
+   return true;
+  }
+
+/*****************************************************************************/
+/************ Get number of clicks of an IP in the checking interval *********/
+/*****************************************************************************/
+// Shared table must be locked
+// Return false if IP is not in table
+// (its clicks are counted in database)
+
+bool FwT_GetNumClicks (const char *IP,time_t Now,unsigned *NumClicks)
+  {
+   struct FwT_Slot *Slot;
+
+   if ((Slot = FwT_GetSlot (IP,Now,false)) == NULL)
+      return false;
+
+   *NumClicks = FwT_GetNumClicksInSlot (Slot,Now);
+   return true;
+  }
+
+/*****************************************************************************/
+/************************ Check if an IP is banned ***************************/
+/*****************************************************************************/
+// Shared table must be locked
+
+FwT_Ban_t FwT_CheckBan (const char *IP,time_t Now)
+  {
+   struct FwT_Slot *Slot;
+
+   if ((Slot = FwT_GetSlot (IP,Now,false)))
+      return Slot->UnbanTime > Now ? FwT_BANNED :
+				     FwT_NOT_BANNED;
+
+   /***** If IP is not in table, it may be banned
+          only if some ban could not be stored in table *****/
+   return FwT_Shm.Table->UnbanTimeNotInTable > Now ? FwT_CHECK_IN_DB :
+						     FwT_NOT_BANNED;
+  }
+
+/*****************************************************************************/
+/************************* Ban an IP in shared table *************************/
+/*****************************************************************************/
+// Shared table must be locked
+
+void FwT_BanIP (const char *IP,time_t UnbanTime)
+  {
+   struct FwT_Slot *Slot;
+
+   if ((Slot = FwT_GetSlot (IP,time (NULL),true)))
+     {
+      if (UnbanTime > Slot->UnbanTime)
+	 Slot->UnbanTime = UnbanTime;
+     }
+   else if (UnbanTime > FwT_Shm.Table->UnbanTimeNotInTable)
+      // All the slots for this IP are in use ==>
+      // this ban will be checked in database
+      FwT_Shm.Table->UnbanTimeNotInTable = UnbanTime;
+  }
+
+/*****************************************************************************/
+/****************** Get slot of an IP in shared table ************************/
+/*****************************************************************************/
+// Shared table must be locked
+// If Create is false and IP is not found, return NULL
+// If Create is true and IP is not found, a free or the oldest idle slot
+// is reused. A slot is idle when its IP is not banned and it has not clicked
+// in the checking interval, so the counters of active IPs are never reset,
+// even when there are more active IPs than slots (for example a botnet).
+// If all the slots where the IP could be are in use, return NULL
+
+static struct FwT_Slot *FwT_GetSlot (const char *IP,time_t Now,bool Create)
+  {
+   unsigned long Hash = 5381;
+   const char *Ptr;
+   unsigned NumProbe;
+   struct FwT_Slot *Slot;
+   struct FwT_Slot *OldestSlot = NULL;
+
+   /***** Hash IP (djb2) *****/
+   for (Ptr = IP;
+	*Ptr;
+	Ptr++)
+      Hash = Hash * 33 + (unsigned char) *Ptr;
+
+   /***** Linear probing *****/
+   for (NumProbe = 0;
+	NumProbe < FwT_MAX_PROBES;
+	NumProbe++)
+     {
+      Slot = &FwT_Shm.Table->Slots[(Hash + NumProbe) & (FwT_NUM_SLOTS - 1)];
+      if (!strcmp (Slot->IP,IP))
+	 return Slot;
+
+      /* Free slots and idle slots can be reused,
+	 but banned and active IPs are kept */
+      if (Slot->UnbanTime <= Now &&
+	  Slot->LastClick <= Now - Fw_CHECK_INTERVAL)
+	 if (!OldestSlot ||
+	     Slot->LastClick < OldestSlot->LastClick)
+	    OldestSlot = Slot;
+     }
+
+   if (!Create || !OldestSlot)
+      return NULL;
+
+   /***** Reuse oldest idle slot *****/
+   memset (OldestSlot,0,sizeof (*OldestSlot));
+   strncpy (OldestSlot->IP,IP,Cns_MAX_BYTES_IP);
+   OldestSlot->IP[Cns_MAX_BYTES_IP] = '\0';
+   return OldestSlot;
+  }
+
+/*****************************************************************************/
+/************ Get number of clicks of an IP in the checking interval *********/
+/*****************************************************************************/
+
+static unsigned FwT_GetNumClicksInSlot (const struct FwT_Slot *Slot,time_t Now)
+  {
+   unsigned Index;
+   unsigned NumClicks = 0;
+
+   for (Index = 0;
+	Index < Fw_CHECK_INTERVAL;
+	Index++)
+      if (Slot->Seconds[Index] > Now - Fw_CHECK_INTERVAL)
+	 NumClicks += Slot->Clicks[Index];
+
+   return NumClicks;
+  }
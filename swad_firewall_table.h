@@ -0,0 +1,68 @@
+// swad_firewall_table.h: table in shared memory to count clicks per IP
+
+#ifndef _SWAD_FWT
+#define _SWAD_FWT
+/*
+    SWAD (Shared Workspace At a Distance in Spanish),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************* Headers ***********************************/
+/*****************************************************************************/
+
+#include <stdbool.h>		// For boolean type
+#include <time.h>		// For time_t
+
+/*****************************************************************************/
+/************************** Public types and constants ***********************/
+/*****************************************************************************/
+
+/* The maximum number of clicks in the interval
+   should be large enough to prevent an IP from being banned
+   due to automatic refresh when the user is viewing the last clicks. */
+#define Fw_CHECK_INTERVAL		((time_t)(10UL))	// Check clicks in the last 10 seconds
+#define Fw_MAX_CLICKS_IN_INTERVAL	100			// Maximum of 100 clicks allowed in 10 seconds
+
+#define FwT_SHM_NAME			"/swad_firewall"
+#define FwT_NUM_SLOTS			4096	// Number of IPs in table. Must be a power of 2
+
+typedef enum
+  {
+   FwT_NOT_BANNED,	// IP is in table and it's not banned
+   FwT_BANNED,		// IP is in table and it's banned
+   FwT_CHECK_IN_DB,	// IP is not in table ==> check in database
+  } FwT_Ban_t;
+
+/*****************************************************************************/
+/***************************** Public prototypes *****************************/
+/*****************************************************************************/
+
+bool FwT_AttachSharedTable (const char *Name,bool *MustLoadBans);
+void FwT_RemoveSharedTable (const char *Name);
+
+void FwT_LockSharedTable (void);
+void FwT_UnlockSharedTable (void);
+
+bool FwT_CountClick (const char *IP,time_t Now);
+bool FwT_GetNumClicks (const char *IP,time_t Now,unsigned *NumClicks);
+FwT_Ban_t FwT_CheckBan (const char *IP,time_t Now);
+void FwT_BanIP (const char *IP,time_t UnbanTime);
+
+#endif
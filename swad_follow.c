@@ -37,6 +37,7 @@
 #include "swad_notification.h"
 #include "swad_privacy.h"
 #include "swad_profile.h"
+#include "swad_timeline.h"
 #include "swad_user.h"
 
 /*****************************************************************************/
@@ -1311,6 +1312,9 @@ static void Fol_FollowUsr (struct UsrData *UsrDat)
 		    Gbl.Usrs.Me.UsrDat.UsrCod,
 		    UsrDat->UsrCod);
 
+   /***** Add publications of followed user to my timeline inbox *****/
+   TL_AddPubsOfFollowedToInbox (Gbl.Usrs.Me.UsrDat.UsrCod,UsrDat->UsrCod);
+
    /***** Flush cache *****/
    Fol_FlushCacheFollow ();
 
@@ -1347,6 +1351,9 @@ static void Fol_UnfollowUsr (struct UsrData *UsrDat)
 		   Gbl.Usrs.Me.UsrDat.UsrCod,
 		   UsrDat->UsrCod);
 
+   /***** Remove publications of unfollowed user from my timeline inbox *****/
+   TL_RemovePubsOfFollowedFromInbox (Gbl.Usrs.Me.UsrDat.UsrCod,UsrDat->UsrCod);
+
    /***** Flush cache *****/
    Fol_FlushCacheFollow ();
   }
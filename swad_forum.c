@@ -284,6 +284,33 @@ static const unsigned PermissionThreadDeletion[For_NUM_TYPES_FORUM] =
 #define For_IMAGE_SAVED_MAX_HEIGHT	768
 #define For_IMAGE_SAVED_QUALITY		 90	// 1 to 100
 
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+struct For_ForumCounters
+  {
+   For_ForumType_t Type;
+   long Location;		// -1 for global forums and forums about the platform
+   unsigned NumThrs;
+   time_t LastPstTime;		// Time of the most recent post in forum
+   time_t MyReadTime;		// Time of the most recent post read by me in forum
+  };
+
+/*****************************************************************************/
+/***************************** Private variables *****************************/
+/*****************************************************************************/
+
+static struct
+  {
+   unsigned Num;
+   struct For_ForumCounters *Lst;
+  } For_CountersOfMyForums =	// Got at once for all the forums in the list of forums
+  {
+   .Num = 0,
+   .Lst = NULL,
+  };
+
 /*****************************************************************************/
 /***************************** Private prototypes ***************************/
 /*****************************************************************************/
@@ -305,16 +332,17 @@ static void For_RemoveThreadOnly (long ThrCod);
 static void For_RemoveThreadAndItsPsts (long ThrCod);
 static void For_GetThrSubject (long ThrCod,char Subject[Cns_MAX_BYTES_SUBJECT + 1]);
 
+static void For_GetForumTypeAndLocationOfAThread (long ThrCod,struct Forum *Forum);
+static long For_GetLocationInCounters (const struct Forum *Forum);
+static void For_IncrementForumCounters (const struct Forum *Forum,
+                                        unsigned NumThrs,unsigned NumPsts);
+static void For_UpdateForumCounters (const struct Forum *Forum);
 static void For_UpdateThrFirstAndLastPst (long ThrCod,long FirstPstCod,long LastPstCod);
 static void For_UpdateThrLastPst (long ThrCod,long LastPstCod);
 static long For_GetLastPstCod (long ThrCod);
 
 static void For_UpdateThrReadTime (long ThrCod,
                                    time_t CreatTimeUTCOfTheMostRecentPostRead);
-static unsigned For_GetNumOfReadersOfThr (long ThrCod);
-static unsigned For_GetNumOfWritersInThr (long ThrCod);
-static unsigned For_GetNumPstsInThr (long ThrCod);
-static unsigned For_GetNumMyPstInThr (long ThrCod);
 static time_t For_GetThrReadTime (long ThrCod);
 static void For_DeleteThrFromReadThrs (long ThrCod);
 static void For_ShowPostsOfAThread (Ale_AlertType_t AlertType,const char *Message);
@@ -355,23 +383,24 @@ static void For_WriteLinkToForum (struct Forum *Forum,
                                   bool Highlight,
                                   unsigned Level,
                                   bool IsLastItemInLevel[1 + For_FORUM_MAX_LEVELS]);
-static unsigned For_GetNumThrsWithNewPstsInForum (struct Forum *Forum,
-                                                  unsigned NumThreads);
-static unsigned For_GetNumOfThreadsInForumNewerThan (struct Forum *Forum,
-                                                     const char *Time);
-static unsigned For_GetNumOfUnreadPostsInThr (long ThrCod,unsigned NumPostsInThr);
-static unsigned For_GetNumOfPostsInThrNewerThan (long ThrCod,const char *Time);
+static void For_GetCountersOfMyForums (void);
+static void For_AddLocationToStr (char **Ptr,long Location);
+static void For_GetCountersOfForum (const struct Forum *Forum,
+                                    unsigned *NumThrs,bool *NewPosts);
+static void For_FreeCountersOfMyForums (void);
 
 static void For_WriteNumberOfThrs (unsigned NumThrs);
 static void For_ShowForumThreadsHighlightingOneThread (long ThrCodHighlighted,
                                                        Ale_AlertType_t AlertType,const char *Message);
 static void For_PutIconNewThread (void);
 static void For_PutAllHiddenParamsNewThread (void);
-static unsigned For_GetNumThrsInForum (struct Forum *Forum);
 static void For_ListForumThrs (long ThrCods[Pag_ITEMS_PER_PAGE],
                                long ThrCodHighlighted,
                                struct Pagination *PaginationThrs);
 static void For_GetThrData (struct ForumThread *Thr);
+static void For_GetThrsData (struct ForumThread Thrs[],unsigned NumThrs);
+static struct ForumThread *For_GetThrInList (struct ForumThread Thrs[],unsigned NumThrs,
+                                             long ThrCod);
 
 static void For_GetParamsForum (void);
 static void For_SetForumType (void);
@@ -527,6 +556,13 @@ static long For_InsertForumPst (long ThrCod,long UsrCod,
 				ThrCod,UsrCod,
 				Subject,Content,Media->MedCod);
 
+   /***** Update number of posts in thread and forum *****/
+   DB_QueryUPDATE ("can not update number of posts in a thread of a forum",
+		   "UPDATE forum_thread SET NumPsts=NumPsts+1"
+		   " WHERE ThrCod=%ld",
+		   ThrCod);
+   For_IncrementForumCounters (&Gbl.Forum.ForumSelected,0,1);
+
    return PstCod;
   }
 
@@ -539,6 +575,7 @@ static bool For_RemoveForumPst (long PstCod,long MedCod)
   {
    long ThrCod;
    bool ThreadDeleted = false;
+   struct Forum Forum;
 
    /***** Remove media file attached to forum post *****/
    Med_RemoveMedia (MedCod);
@@ -558,9 +595,18 @@ static bool For_RemoveForumPst (long PstCod,long MedCod)
    /***** Delete the post from the table of disabled forum posts *****/
    For_DeletePstFromDisabledPstTable (PstCod);
 
-   /***** Update the last post of the thread *****/
+   /***** Update the last post and the number of posts of the thread
+          and the counters of the forum *****/
    if (!ThreadDeleted)
+     {
       For_UpdateThrLastPst (ThrCod,For_GetLastPstCod (ThrCod));
+      DB_QueryUPDATE ("can not update number of posts in a thread of a forum",
+		      "UPDATE forum_thread SET NumPsts=NumPsts-1"
+		      " WHERE ThrCod=%ld AND NumPsts>0",
+		      ThrCod);
+      For_GetForumTypeAndLocationOfAThread (ThrCod,&Forum);
+      For_UpdateForumCounters (&Forum);
+     }
 
    return ThreadDeleted;
   }
@@ -601,16 +647,23 @@ static unsigned For_NumPstsInThrWithPstCod (long PstCod,long *ThrCod)
 
 static long For_InsertForumThread (long FirstPstCod)
   {
+   long ThrCod;
+
    /***** Insert new thread in the database *****/
-   return
+   ThrCod =
    DB_QueryINSERTandReturnCode ("can not create a new thread in a forum",
 				"INSERT INTO forum_thread"
-				" (ForumType,Location,FirstPstCod,LastPstCod)"
+				" (ForumType,Location,FirstPstCod,LastPstCod,NumPsts)"
 				" VALUES"
-				" (%u,%ld,%ld,%ld)",
+				" (%u,%ld,%ld,%ld,0)",
 				(unsigned) Gbl.Forum.ForumSelected.Type,
 				Gbl.Forum.ForumSelected.Location,
 				FirstPstCod,FirstPstCod);
+
+   /***** Update number of threads in forum *****/
+   For_IncrementForumCounters (&Gbl.Forum.ForumSelected,1,0);
+
+   return ThrCod;
   }
 
 /*****************************************************************************/
@@ -619,6 +672,11 @@ static long For_InsertForumThread (long FirstPstCod)
 
 static void For_RemoveThreadOnly (long ThrCod)
   {
+   struct Forum Forum;
+
+   /***** Get the forum of this thread, before removing it *****/
+   For_GetForumTypeAndLocationOfAThread (ThrCod,&Forum);
+
    /***** Indicate that this thread has not been read by anyone *****/
    For_DeleteThrFromReadThrs (ThrCod);
 
@@ -629,6 +687,9 @@ static void For_RemoveThreadOnly (long ThrCod)
    DB_QueryDELETE ("can not remove a thread from a forum",
 		   "DELETE FROM forum_thread WHERE ThrCod=%ld",
 		   ThrCod);
+
+   /***** Update the counters of the forum *****/
+   For_UpdateForumCounters (&Forum);
   }
 
 /*****************************************************************************/
@@ -719,6 +780,114 @@ void For_GetForumTypeAndLocationOfAPost (long PstCod,struct Forum *Forum)
    DB_FreeMySQLResult (&mysql_res);
   }
 
+/*****************************************************************************/
+/************** Get the forum type and location of a thread ******************/
+/*****************************************************************************/
+
+static void For_GetForumTypeAndLocationOfAThread (long ThrCod,struct Forum *Forum)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned UnsignedNum;
+   long LongNum;
+
+   /***** Set default forum type and location *****/
+   Forum->Type = For_FORUM_UNKNOWN;
+   Forum->Location = -1L;
+
+   /***** Check if there is a row with forum type *****/
+   if (DB_QuerySELECT (&mysql_res,"can not get forum type and location",
+		       "SELECT ForumType,Location FROM forum_thread"
+		       " WHERE ThrCod=%ld",
+		       ThrCod))
+     {
+      row = mysql_fetch_row (mysql_res);
+
+      /* Get forum type (row[0]) */
+      if (sscanf (row[0],"%u",&UnsignedNum) == 1)
+	 if (UnsignedNum < For_NUM_TYPES_FORUM)
+	    Forum->Type = (For_ForumType_t) UnsignedNum;
+
+      /* Get forum location (row[1]) */
+      if (sscanf (row[1],"%ld",&LongNum) == 1)
+         Forum->Location = LongNum;
+     }
+
+   /***** Free structure that stores the query result *****/
+   DB_FreeMySQLResult (&mysql_res);
+  }
+
+/*****************************************************************************/
+/************ Get the location of a forum in table of counters ***************/
+/*****************************************************************************/
+// Global forums and forums about the platform have no location
+
+static long For_GetLocationInCounters (const struct Forum *Forum)
+  {
+   switch (Forum->Type)
+     {
+      case For_FORUM_GLOBAL_USRS:
+      case For_FORUM_GLOBAL_TCHS:
+      case For_FORUM__SWAD__USRS:
+      case For_FORUM__SWAD__TCHS:
+	 return -1L;
+      default:
+	 return Forum->Location;
+     }
+  }
+
+/*****************************************************************************/
+/********* Increment the number of threads and posts in a forum **************/
+/*****************************************************************************/
+// Called each time a thread or a post is created,
+// so the list of forums does not need to count threads and posts
+
+static void For_IncrementForumCounters (const struct Forum *Forum,
+                                        unsigned NumThrs,unsigned NumPsts)
+  {
+   DB_QueryINSERT ("can not update counters of a forum",
+		   "INSERT INTO forum_counters"
+		   " (ForumType,Location,NumThrs,NumPsts,LastPstTime)"
+		   " VALUES"
+		   " (%u,%ld,%u,%u,NOW())"
+		   " ON DUPLICATE KEY UPDATE"
+		   " NumThrs=NumThrs+%u,"
+		   "NumPsts=NumPsts+%u,"
+		   "LastPstTime=IF(%u,NOW(),LastPstTime)",
+		   (unsigned) Forum->Type,For_GetLocationInCounters (Forum),
+		   NumThrs,NumPsts,
+		   NumThrs,NumPsts,NumPsts);
+  }
+
+/*****************************************************************************/
+/************ Compute again the counters of a forum from threads *************/
+/*****************************************************************************/
+// Called when posts or threads are removed or moved (rare operations)
+
+static void For_UpdateForumCounters (const struct Forum *Forum)
+  {
+   char SubQuery[256];
+
+   if (Forum->Type == For_FORUM_UNKNOWN)
+      return;
+
+   if (For_GetLocationInCounters (Forum) > 0)
+      sprintf (SubQuery," AND forum_thread.Location=%ld",Forum->Location);
+   else
+      SubQuery[0] = '\0';
+   DB_QueryREPLACE ("can not update counters of a forum",
+		    "REPLACE INTO forum_counters"
+		    " (ForumType,Location,NumThrs,NumPsts,LastPstTime)"
+		    " SELECT %u,%ld,COUNT(*),"
+		    "COALESCE(SUM(forum_thread.NumPsts),0),"
+		    "COALESCE(MAX(forum_post.ModifTime),FROM_UNIXTIME(0))"
+		    " FROM forum_thread,forum_post"
+		    " WHERE forum_thread.ForumType=%u%s"
+		    " AND forum_thread.LastPstCod=forum_post.PstCod",
+		    (unsigned) Forum->Type,For_GetLocationInCounters (Forum),
+		    (unsigned) Forum->Type,SubQuery);
+  }
+
 /*****************************************************************************/
 /********* Modify the codes of the first and last posts of a thread **********/
 /*****************************************************************************/
@@ -793,81 +962,6 @@ static void For_UpdateThrReadTime (long ThrCod,
 	            (long) CreatTimeUTCOfTheMostRecentPostRead);
   }
 
-/*****************************************************************************/
-/**************** Get number of users that have read a thread ****************/
-/*****************************************************************************/
-
-static unsigned For_GetNumOfReadersOfThr (long ThrCod)
-  {
-   /***** Get number of distinct readers of a thread from database *****/
-   return
-   (unsigned) DB_QueryCOUNT ("can not get the number of readers"
-	                     " of a thread of a forum",
-			     "SELECT COUNT(*) FROM forum_thr_read"
-			     " WHERE ThrCod=%ld",
-			     ThrCod);
-  }
-
-/*****************************************************************************/
-/********** Get number of users that have write posts in a thread ************/
-/*****************************************************************************/
-
-static unsigned For_GetNumOfWritersInThr (long ThrCod)
-  {
-   MYSQL_RES *mysql_res;
-   MYSQL_ROW row;
-   unsigned NumWriters;
-
-   /***** Get number of distinct writers in a thread from database *****/
-   DB_QuerySELECT (&mysql_res,"can not get the number of writers"
-	                      " in a thread of a forum",
-		   "SELECT COUNT(DISTINCT UsrCod) FROM forum_post"
-		   " WHERE ThrCod=%ld",
-                   ThrCod);
-
-   /* Get row with number of writers */
-   row = mysql_fetch_row (mysql_res);
-
-   /* Get number of writers (row[0]) */
-   if (sscanf (row[0],"%u",&NumWriters) != 1)
-      Lay_ShowErrorAndExit ("Error when getting the number of writers in a thread of a forum.");
-
-   /***** Free structure that stores the query result *****/
-   DB_FreeMySQLResult (&mysql_res);
-
-   return NumWriters;
-  }
-
-/*****************************************************************************/
-/********************** Get number of posts in a thread **********************/
-/*****************************************************************************/
-
-static unsigned For_GetNumPstsInThr (long ThrCod)
-  {
-   /***** Get number of posts in a thread from database *****/
-   return
-   (unsigned) DB_QueryCOUNT ("can not get the number of posts"
-	                     " in a thread of a forum",
-			     "SELECT COUNT(*) FROM forum_post"
-			     " WHERE ThrCod=%ld",
-			     ThrCod);
-  }
-
-/*****************************************************************************/
-/************** Get whether there are posts of mine in a thread **************/
-/*****************************************************************************/
-
-static unsigned For_GetNumMyPstInThr (long ThrCod)
-  {
-   /***** Get if I have write posts in a thread from database *****/
-   return
-   (unsigned) DB_QueryCOUNT ("can not check if you have written"
-	                     " posts in a thead of a forum",
-			     "SELECT COUNT(*) FROM forum_post"
-			     " WHERE ThrCod=%ld AND UsrCod=%ld",
-			     ThrCod,Gbl.Usrs.Me.UsrDat.UsrCod);
-  }
-
 /*****************************************************************************/
 /*********************** Get number of posts from a user *********************/
 /*****************************************************************************/
@@ -1556,6 +1650,10 @@ static void For_ShowForumList (void)
    /***** Fill the list with the institutions I belong to *****/
    Usr_GetMyInstits ();
 
+   /***** Get number of threads and time of last post
+          of all my forums at once *****/
+   For_GetCountersOfMyForums ();
+
    /***** Begin box *****/
    Box_BoxBegin (NULL,Txt_Forums,For_PutIconsForums,
                  Hlp_MESSAGES_Forums,Box_NOT_CLOSABLE);
@@ -1711,6 +1809,9 @@ static void For_ShowForumList (void)
 
    /***** End box *****/
    Box_BoxEnd ();
+
+   /***** Free counters of forums *****/
+   For_FreeCountersOfMyForums ();
   }
 
 /*****************************************************************************/
@@ -2011,15 +2112,14 @@ static void For_WriteLinkToForum (struct Forum *Forum,
    extern const char *The_ClassFormLinkInBoxBold[The_NUM_THEMES];
    extern const char *Txt_Copy_not_allowed;
    unsigned NumThrs;
-   unsigned NumThrsWithNewPosts;
+   bool NewPosts;
    const char *Class;
    char ForumName[For_MAX_BYTES_FORUM_NAME + 1];
 
-   /***** Get number of threads and number of posts *****/
-   NumThrs = For_GetNumThrsInForum (Forum);
-   NumThrsWithNewPosts = For_GetNumThrsWithNewPstsInForum (Forum,NumThrs);
-   Class = (NumThrsWithNewPosts ? The_ClassFormLinkInBoxBold[Gbl.Prefs.Theme] :
-	                          The_ClassFormLinkInBox[Gbl.Prefs.Theme]);
+   /***** Get number of threads and if there are new posts *****/
+   For_GetCountersOfForum (Forum,&NumThrs,&NewPosts);
+   Class = (NewPosts ? The_ClassFormLinkInBoxBold[Gbl.Prefs.Theme] :
+	               The_ClassFormLinkInBox[Gbl.Prefs.Theme]);
 
    /***** Start row *****/
    HTM_LI_Begin (Highlight ? "class=\"LIGHT_BLUE\"" :
@@ -2224,114 +2324,204 @@ void For_SetForumName (struct Forum *Forum,
   }
 
 /*****************************************************************************/
-/***** Get number of threads with new posts since my last read of a forum ****/
+/********* Get number of threads and time of last post of my forums **********/
 /*****************************************************************************/
+// Only two queries for the whole list of forums,
+// instead of several queries for each forum
 
-static unsigned For_GetNumThrsWithNewPstsInForum (struct Forum *Forum,
-                                                  unsigned NumThreads)
+static void For_GetCountersOfMyForums (void)
   {
-   char SubQuery[256];
+   char *Locations;
+   char *Ptr;
+   unsigned NumLocations;
+   unsigned NumLoc;
    MYSQL_RES *mysql_res;
    MYSQL_ROW row;
    unsigned long NumRows;
-   unsigned NumThrsWithNewPosts = NumThreads;	// By default, all the threads are new to me
+   unsigned long NumRow;
+   struct Forum Forum;
+   struct For_ForumCounters *Counters;
+   long Location;
+   time_t MyReadTime;
+
+   /***** Free previous counters *****/
+   For_FreeCountersOfMyForums ();
+
+   /***** Fill the lists with the centres, degrees and courses I belong to
+          (institutions are already filled) *****/
+   Usr_GetMyCentres ();
+   Usr_GetMyDegrees ();
+   Usr_GetMyCourses ();
+
+   /***** Build the list of locations of the forums that can be listed:
+          my institutions, centres, degrees and courses,
+          and the current ones *****/
+   NumLocations = 1 +
+		  Gbl.Usrs.Me.MyInss.Num +
+		  Gbl.Usrs.Me.MyCtrs.Num +
+		  Gbl.Usrs.Me.MyDegs.Num +
+		  Gbl.Usrs.Me.MyCrss.Num +
+		  4;
+   if ((Locations = (char *) malloc (NumLocations * (Cns_MAX_DECIMAL_DIGITS_LONG + 1) + 1)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   Ptr = Locations;
+   Ptr += sprintf (Ptr,"-1");	// Global forums and forums about the platform
+   for (NumLoc = 0;
+	NumLoc < Gbl.Usrs.Me.MyInss.Num;
+	NumLoc++)
+      For_AddLocationToStr (&Ptr,Gbl.Usrs.Me.MyInss.Inss[NumLoc].InsCod);
+   for (NumLoc = 0;
+	NumLoc < Gbl.Usrs.Me.MyCtrs.Num;
+	NumLoc++)
+      For_AddLocationToStr (&Ptr,Gbl.Usrs.Me.MyCtrs.Ctrs[NumLoc].CtrCod);
+   for (NumLoc = 0;
+	NumLoc < Gbl.Usrs.Me.MyDegs.Num;
+	NumLoc++)
+      For_AddLocationToStr (&Ptr,Gbl.Usrs.Me.MyDegs.Degs[NumLoc].DegCod);
+   for (NumLoc = 0;
+	NumLoc < Gbl.Usrs.Me.MyCrss.Num;
+	NumLoc++)
+      For_AddLocationToStr (&Ptr,Gbl.Usrs.Me.MyCrss.Crss[NumLoc].CrsCod);
+   For_AddLocationToStr (&Ptr,Gbl.Hierarchy.Ins.InsCod);
+   For_AddLocationToStr (&Ptr,Gbl.Hierarchy.Ctr.CtrCod);
+   For_AddLocationToStr (&Ptr,Gbl.Hierarchy.Deg.DegCod);
+   For_AddLocationToStr (&Ptr,Gbl.Hierarchy.Crs.CrsCod);
+
+   /***** Get counters of forums from database *****/
+   // Locations of different types of forum may coincide,
+   // so a few more forums than necessary may be got
+   NumRows = DB_QuerySELECT (&mysql_res,"can not get number of threads in forums",
+			     "SELECT ForumType,Location,NumThrs,"
+			     "UNIX_TIMESTAMP(LastPstTime)"
+			     " FROM forum_counters"
+			     " WHERE Location IN (%s) AND NumThrs>0",
+			     Locations);
+   free (Locations);
 
-   /***** Get last time I read this forum from database *****/
-   if (Forum->Location > 0)
-      sprintf (SubQuery," AND forum_thread.Location=%ld",Forum->Location);
-   else
-      SubQuery[0] = '\0';
-   NumRows = DB_QuerySELECT (&mysql_res,"can not get the date of reading of a forum",
-			     "SELECT MAX(forum_thr_read.ReadTime)"
+   if (NumRows)
+     {
+      if ((For_CountersOfMyForums.Lst = (struct For_ForumCounters *) malloc (NumRows * sizeof (struct For_ForumCounters))) == NULL)
+	 Lay_NotEnoughMemoryExit ();
+
+      for (NumRow = 0;
+	   NumRow < NumRows;
+	   NumRow++)
+	{
+	 row = mysql_fetch_row (mysql_res);
+	 Counters = &For_CountersOfMyForums.Lst[NumRow];
+
+	 /* Get forum type (row[0]) and location (row[1]) */
+	 Counters->Type = (For_ForumType_t) Str_ConvertStrToUnsigned (row[0]);
+	 Counters->Location = Str_ConvertStrCodToLongCod (row[1]);
+
+	 /* Get number of threads (row[2]) */
+	 if (sscanf (row[2],"%u",&Counters->NumThrs) != 1)
+	    Counters->NumThrs = 0;
+
+	 /* Get time of last post (row[3]) */
+	 Counters->LastPstTime = Dat_GetUNIXTimeFromStr (row[3]);
+
+	 /* Time of last post read by me will be got below */
+	 Counters->MyReadTime = (time_t) 0;
+	}
+      For_CountersOfMyForums.Num = (unsigned) NumRows;
+     }
+
+   /***** Free structure that stores the query result *****/
+   DB_FreeMySQLResult (&mysql_res);
+
+   if (!For_CountersOfMyForums.Num)
+      return;
+
+   /***** Get last time I read each forum from database *****/
+   NumRows = DB_QuerySELECT (&mysql_res,"can not get the date of reading of forums",
+			     "SELECT forum_thread.ForumType,forum_thread.Location,"
+			     "UNIX_TIMESTAMP(MAX(forum_thr_read.ReadTime))"
 			     " FROM forum_thr_read,forum_thread"
 			     " WHERE forum_thr_read.UsrCod=%ld"
 			     " AND forum_thr_read.ThrCod=forum_thread.ThrCod"
-			     " AND forum_thread.ForumType=%u%s",
-			     Gbl.Usrs.Me.UsrDat.UsrCod,
-			     (unsigned) Forum->Type,SubQuery);
-
-   if (NumRows)
+			     " GROUP BY forum_thread.ForumType,forum_thread.Location",
+			     Gbl.Usrs.Me.UsrDat.UsrCod);
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
      {
-      /***** Get number of threads with a last message modify time > newest read time (row[0]) *****/
       row = mysql_fetch_row (mysql_res);
-      NumThrsWithNewPosts = For_GetNumOfThreadsInForumNewerThan (Forum,row[0]);
+
+      /* Get forum type (row[0]) and location (row[1]) */
+      Forum.Type = (For_ForumType_t) Str_ConvertStrToUnsigned (row[0]);
+      Forum.Location = Str_ConvertStrCodToLongCod (row[1]);
+      Location = For_GetLocationInCounters (&Forum);
+
+      /* Get last time I read this forum (row[2]) */
+      MyReadTime = Dat_GetUNIXTimeFromStr (row[2]);
+
+      /* Store it in counters of this forum */
+      for (NumLoc = 0;
+	   NumLoc < For_CountersOfMyForums.Num;
+	   NumLoc++)
+	{
+	 Counters = &For_CountersOfMyForums.Lst[NumLoc];
+	 if (Counters->Type == Forum.Type &&
+	     Counters->Location == Location)
+	   {
+	    if (MyReadTime > Counters->MyReadTime)
+	       Counters->MyReadTime = MyReadTime;
+	    break;
+	   }
+	}
      }
 
    /***** Free structure that stores the query result *****/
    DB_FreeMySQLResult (&mysql_res);
-
-   return NumThrsWithNewPosts;
   }
 
-/*****************************************************************************/
-/**** Get number of threads in forum with a modify time > a specified time ***/
-/*****************************************************************************/
-
-static unsigned For_GetNumOfThreadsInForumNewerThan (struct Forum *Forum,
-                                                     const char *Time)
+static void For_AddLocationToStr (char **Ptr,long Location)
   {
-   char SubQuery[256];
-
-   /***** Get number of threads with a last message modify time
-          > specified time from database *****/
-   if (Forum->Location > 0)
-      sprintf (SubQuery," AND forum_thread.Location=%ld",Forum->Location);
-   else
-      SubQuery[0] = '\0';
-   return
-   (unsigned) DB_QueryCOUNT ("can not check if there are new posts in a forum",
-			     "SELECT COUNT(*) FROM forum_thread,forum_post"
-			     " WHERE forum_thread.ForumType=%u%s"
-			     " AND forum_thread.LastPstCod=forum_post.PstCod"
-			     " AND forum_post.ModifTime>'%s'",
-			     (unsigned) Forum->Type,SubQuery,Time);
+   if (Location > 0)
+      *Ptr += sprintf (*Ptr,",%ld",Location);
   }
 
 /*****************************************************************************/
-/** Get number of unread posts in a thread since my last read of that thread */
+/********* Get number of threads and if there are new posts in a forum *******/
 /*****************************************************************************/
+// There are new posts if any post is newer than the newest post read by me
 
-static unsigned For_GetNumOfUnreadPostsInThr (long ThrCod,unsigned NumPostsInThr)
+static void For_GetCountersOfForum (const struct Forum *Forum,
+                                    unsigned *NumThrs,bool *NewPosts)
   {
-   MYSQL_RES *mysql_res;
-   MYSQL_ROW row;
-   unsigned long NumRows;
-   unsigned NumUnreadPosts = NumPostsInThr;	// By default, all the posts are unread by me
-
-   /***** Get last time I read this thread from database *****/
-   NumRows = DB_QuerySELECT (&mysql_res,"can not get the date of reading"
-					" of a thread",
-			     "SELECT ReadTime FROM forum_thr_read"
-			     " WHERE ThrCod=%ld AND UsrCod=%ld",
-			     ThrCod,Gbl.Usrs.Me.UsrDat.UsrCod);
-
-   /***** Get if last time I read this thread exists in database *****/
-   if (NumRows)
-     {
-      /***** Get the number of posts in thread with a modify time > newest read time for me (row[0]) *****/
-      row = mysql_fetch_row (mysql_res);
-      NumUnreadPosts = For_GetNumOfPostsInThrNewerThan (ThrCod,row[0]);
-     }
-
-   /***** Free structure that stores the query result *****/
-   DB_FreeMySQLResult (&mysql_res);
+   long Location = For_GetLocationInCounters (Forum);
+   unsigned NumForum;
+
+   for (NumForum = 0;
+	NumForum < For_CountersOfMyForums.Num;
+	NumForum++)
+      if (For_CountersOfMyForums.Lst[NumForum].Type     == Forum->Type &&
+	  For_CountersOfMyForums.Lst[NumForum].Location == Location)
+	{
+	 *NumThrs  = For_CountersOfMyForums.Lst[NumForum].NumThrs;
+	 *NewPosts = For_CountersOfMyForums.Lst[NumForum].LastPstTime >
+		     For_CountersOfMyForums.Lst[NumForum].MyReadTime;
+	 return;
+	}
 
-   return NumUnreadPosts;
+   /***** Not found ==> forum without threads *****/
+   *NumThrs  = 0;
+   *NewPosts = false;
   }
 
 /*****************************************************************************/
-/**** Get number of posts in thread with a modify time > a specified time ****/
+/********************** Free counters of my forums ***************************/
 /*****************************************************************************/
 
-static unsigned For_GetNumOfPostsInThrNewerThan (long ThrCod,const char *Time)
+static void For_FreeCountersOfMyForums (void)
   {
-   /***** Get the number of posts in thread with a modify time > a specified time from database *****/
-   return
-   (unsigned) DB_QueryCOUNT ("can not check if there are new posts"
-			     " in a thread of a forum",
-			     "SELECT COUNT(*) FROM forum_post"
-			     " WHERE ThrCod=%ld AND ModifTime>'%s'",
-			     ThrCod,Time);
+   if (For_CountersOfMyForums.Lst)
+     {
+      free (For_CountersOfMyForums.Lst);
+      For_CountersOfMyForums.Lst = NULL;
+     }
+   For_CountersOfMyForums.Num = 0;
   }
 
 /*****************************************************************************/
@@ -2972,26 +3162,6 @@ unsigned For_GetNumTotalThrsInForumsOfType (For_ForumType_t ForumType,
    return NumThrs;
   }
 
-/*****************************************************************************/
-/******************* Get number of threads in a forum ************************/
-/*****************************************************************************/
-
-static unsigned For_GetNumThrsInForum (struct Forum *Forum)
-  {
-   char SubQuery[256];
-
-   /***** Get number of threads in a forum from database *****/
-   if (Forum->Location > 0)
-      sprintf (SubQuery," AND Location=%ld",Forum->Location);
-   else
-      SubQuery[0] = '\0';
-   return
-   (unsigned) DB_QueryCOUNT ("can not get number of threads in a forum",
-			     "SELECT COUNT(*) FROM forum_thread"
-			     " WHERE ForumType=%u%s",
-			     (unsigned) Forum->Type,SubQuery);
-  }
-
 /*****************************************************************************/
 /************** Get total number of posts in forums of a type ****************/
 /*****************************************************************************/
@@ -3252,6 +3422,7 @@ static void For_ListForumThrs (long ThrCods[Pag_ITEMS_PER_PAGE],
    unsigned NumThrInScreen;	// From 0 to Pag_ITEMS_PER_PAGE-1
    unsigned UniqueId;
    char *Id;
+   struct ForumThread Thrs[Pag_ITEMS_PER_PAGE];
    struct ForumThread Thr;
    struct UsrData UsrDat;
    For_Order_t Order;
@@ -3267,6 +3438,13 @@ static void For_ListForumThrs (long ThrCods[Pag_ITEMS_PER_PAGE],
    if ((ICanMoveThreads = For_CheckIfICanMoveThreads ()))
       ThreadInMyClipboard = For_GetThrInMyClipboard ();
 
+   /***** Get the data of all the threads in this page *****/
+   for (NumThr = PaginationThrs->FirstItemVisible, NumThrInScreen = 0;
+        NumThr <= PaginationThrs->LastItemVisible;
+        NumThr++, NumThrInScreen++)
+      Thrs[NumThrInScreen].ThrCod = ThrCods[NumThrInScreen];
+   For_GetThrsData (Thrs,NumThrInScreen);
+
    /***** Initialize structure with user's data *****/
    Usr_UsrDataConstructor (&UsrDat);
 
@@ -3275,8 +3453,7 @@ static void For_ListForumThrs (long ThrCods[Pag_ITEMS_PER_PAGE],
         NumThr++, NumThrInScreen++, Gbl.RowEvenOdd = 1 - Gbl.RowEvenOdd)
      {
       /***** Get the data of this thread *****/
-      Thr.ThrCod = ThrCods[NumThrInScreen];
-      For_GetThrData (&Thr);
+      Thr = Thrs[NumThrInScreen];
       Style = (Thr.NumUnreadPosts ? "AUTHOR_TXT_NEW" :
 	                            "AUTHOR_TXT");
       BgColor =  (Thr.ThrCod == ThreadInMyClipboard) ? "LIGHT_GREEN" :
@@ -3425,89 +3602,216 @@ static void For_ListForumThrs (long ThrCods[Pag_ITEMS_PER_PAGE],
 /*****************************************************************************/
 
 static void For_GetThrData (struct ForumThread *Thr)
+  {
+   For_GetThrsData (Thr,1);
+  }
+
+/*****************************************************************************/
+/************************* Get data of several threads ***********************/
+/*****************************************************************************/
+// Thrs[NumThr].ThrCod must be filled.
+// Only four queries for all the threads,
+// instead of several queries for each thread
+
+static void For_GetThrsData (struct ForumThread Thrs[],unsigned NumThrs)
   {
    extern const char *Txt_no_subject;
+   char *ThrCods;
+   char *Ptr;
    MYSQL_RES *mysql_res;
    MYSQL_ROW row;
    unsigned long NumRows;
-   For_Order_t Order;
+   unsigned long NumRow;
+   unsigned NumThr;
+   struct ForumThread *Thr;
+
+   if (!NumThrs)
+      return;
+
+   /***** Build the list of thread codes
+          and reset numbers not got from database for all threads *****/
+   if ((ThrCods = (char *) malloc (NumThrs * (Cns_MAX_DECIMAL_DIGITS_LONG + 1) + 1)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   for (NumThr = 0, Ptr = ThrCods;
+	NumThr < NumThrs;
+	NumThr++)
+     {
+      Ptr += sprintf (Ptr,NumThr ? ",%ld" :
+				   "%ld",
+		      Thrs[NumThr].ThrCod);
+      Thrs[NumThr].NumUnreadPosts = 0;
+      Thrs[NumThr].NumMyPosts     = 0;
+      Thrs[NumThr].NumWriters     = 0;
+      Thrs[NumThr].NumReaders     = 0;
+     }
 
-   /***** Get data of a thread from database *****/
+   /***** Get data of threads from database *****/
    NumRows = DB_QuerySELECT (&mysql_res,"can not get data"
-					" of a thread of a forum",
-			     "SELECT m0.PstCod,m1.PstCod,m0.UsrCod,m1.UsrCod,"
+					" of threads of a forum",
+			     "SELECT forum_thread.ThrCod,"
+			     "m0.PstCod,m1.PstCod,m0.UsrCod,m1.UsrCod,"
 			     "UNIX_TIMESTAMP(m0.CreatTime),"
 			     "UNIX_TIMESTAMP(m1.CreatTime),"
-			     "m0.Subject"
-			     " FROM forum_thread,forum_post AS m0,forum_post AS m1"
-			     " WHERE forum_thread.ThrCod=%ld"
-			     " AND forum_thread.FirstPstCod=m0.PstCod"
-			     " AND forum_thread.LastPstCod=m1.PstCod",
-			     Thr->ThrCod);
-
-   /***** The result of the query should have one row *****/
-   if (NumRows != 1)
+			     "m0.Subject,"
+			     "forum_thread.NumPsts,"
+			     "d0.PstCod IS NULL,"
+			     "d1.PstCod IS NULL"
+			     " FROM forum_thread"
+			     " JOIN forum_post AS m0"
+			     " ON forum_thread.FirstPstCod=m0.PstCod"
+			     " JOIN forum_post AS m1"
+			     " ON forum_thread.LastPstCod=m1.PstCod"
+			     " LEFT JOIN forum_disabled_post AS d0"
+			     " ON m0.PstCod=d0.PstCod"
+			     " LEFT JOIN forum_disabled_post AS d1"
+			     " ON m1.PstCod=d1.PstCod"
+			     " WHERE forum_thread.ThrCod IN (%s)",
+			     ThrCods);
+
+   /***** The result of the query should have one row for each thread *****/
+   if (NumRows != (unsigned long) NumThrs)
       Lay_ShowErrorAndExit ("Error when getting data of a thread of a forum.");
-   row = mysql_fetch_row (mysql_res);
 
-   /***** Get the code of the first post in this thread (row[0]) *****/
-   Thr->PstCod[For_FIRST_MSG] = Str_ConvertStrCodToLongCod (row[0]);
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
 
-   /***** Get the code of the last  post in this thread (row[1]) *****/
-   Thr->PstCod[For_LAST_MSG ] = Str_ConvertStrCodToLongCod (row[1]);
+      /***** Get the thread code (row[0]) *****/
+      if ((Thr = For_GetThrInList (Thrs,NumThrs,Str_ConvertStrCodToLongCod (row[0]))) == NULL)
+	 Lay_ShowErrorAndExit ("Error when getting data of a thread of a forum.");
 
-   /***** Get the code of the first message in this thread (row[0]) *****/
-   if (sscanf (row[0],"%ld",&(Thr->PstCod[For_FIRST_MSG])) != 1)
-      Lay_ShowErrorAndExit ("Wrong code of post.");
+      /***** Get the code of the first message in this thread (row[1]) *****/
+      if (sscanf (row[1],"%ld",&(Thr->PstCod[For_FIRST_MSG])) != 1)
+	 Lay_ShowErrorAndExit ("Wrong code of post.");
 
-   /***** Get the code of the last message in this thread (row[1]) *****/
-   if (sscanf (row[1],"%ld",&(Thr->PstCod[For_LAST_MSG])) != 1)
-      Lay_ShowErrorAndExit ("Wrong code of post.");
+      /***** Get the code of the last message in this thread (row[2]) *****/
+      if (sscanf (row[2],"%ld",&(Thr->PstCod[For_LAST_MSG])) != 1)
+	 Lay_ShowErrorAndExit ("Wrong code of post.");
 
-   /***** Get the author of the first post in this thread (row[2]) *****/
-   Thr->UsrCod[For_FIRST_MSG] = Str_ConvertStrCodToLongCod (row[2]);
+      /***** Get the author of the first post in this thread (row[3]) *****/
+      Thr->UsrCod[For_FIRST_MSG] = Str_ConvertStrCodToLongCod (row[3]);
 
-   /***** Get the author of the last  post in this thread (row[3]) *****/
-   Thr->UsrCod[For_LAST_MSG ] = Str_ConvertStrCodToLongCod (row[3]);
+      /***** Get the author of the last  post in this thread (row[4]) *****/
+      Thr->UsrCod[For_LAST_MSG ] = Str_ConvertStrCodToLongCod (row[4]);
 
-   /***** Get the date of the first post in this thread (row[4]) *****/
-   Thr->WriteTime[For_FIRST_MSG] = Dat_GetUNIXTimeFromStr (row[4]);
+      /***** Get the date of the first post in this thread (row[5]) *****/
+      Thr->WriteTime[For_FIRST_MSG] = Dat_GetUNIXTimeFromStr (row[5]);
 
-   /***** Get the date of the last  post in this thread (row[5]) *****/
-   Thr->WriteTime[For_LAST_MSG ] = Dat_GetUNIXTimeFromStr (row[5]);
+      /***** Get the date of the last  post in this thread (row[6]) *****/
+      Thr->WriteTime[For_LAST_MSG ] = Dat_GetUNIXTimeFromStr (row[6]);
 
-   /***** Get the subject of this thread (row[6]) *****/
-   Str_Copy (Thr->Subject,row[6],
-             Cns_MAX_BYTES_SUBJECT);
-   if (!Thr->Subject[0])
-      snprintf (Thr->Subject,sizeof (Thr->Subject),
-	        "[%s]",
-		Txt_no_subject);
+      /***** Get the subject of this thread (row[7]) *****/
+      Str_Copy (Thr->Subject,row[7],
+		Cns_MAX_BYTES_SUBJECT);
+      if (!Thr->Subject[0])
+	 snprintf (Thr->Subject,sizeof (Thr->Subject),
+		   "[%s]",
+		   Txt_no_subject);
+
+      /***** Get number of posts in this thread (row[8]) *****/
+      if (sscanf (row[8],"%u",&Thr->NumPosts) != 1)
+	 Thr->NumPosts = 0;
+
+      /***** Get if first or last message are enabled (row[9], row[10]) *****/
+      // A post is enabled if it does not appear in table of disabled posts
+      Thr->Enabled[For_FIRST_MSG] = (row[ 9][0] == '1');
+      Thr->Enabled[For_LAST_MSG ] = (row[10][0] == '1');
+     }
 
    /***** Free structure that stores the query result *****/
    DB_FreeMySQLResult (&mysql_res);
 
-   /***** Get if first or last message are enabled *****/
-   for (Order = For_FIRST_MSG;
-	Order <= For_LAST_MSG;
-	Order++)
-      Thr->Enabled[Order] = For_GetIfPstIsEnabled (Thr->PstCod[Order]);
-      // Thr->Enabled[Order] = true;
+   /***** Get number of unread (by me) posts in each thread *****/
+   // If I have not read a thread, all its posts are unread
+   NumRows = DB_QuerySELECT (&mysql_res,"can not get number of unread posts"
+					" in threads of a forum",
+			     "SELECT forum_post.ThrCod,COUNT(*)"
+			     " FROM forum_post"
+			     " LEFT JOIN forum_thr_read"
+			     " ON forum_thr_read.ThrCod=forum_post.ThrCod"
+			     " AND forum_thr_read.UsrCod=%ld"
+			     " WHERE forum_post.ThrCod IN (%s)"
+			     " AND (forum_thr_read.ReadTime IS NULL"
+			     " OR forum_post.ModifTime>forum_thr_read.ReadTime)"
+			     " GROUP BY forum_post.ThrCod",
+			     Gbl.Usrs.Me.UsrDat.UsrCod,ThrCods);
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      if ((Thr = For_GetThrInList (Thrs,NumThrs,Str_ConvertStrCodToLongCod (row[0]))))
+	 if (sscanf (row[1],"%u",&Thr->NumUnreadPosts) != 1)
+	    Thr->NumUnreadPosts = 0;
+     }
+   DB_FreeMySQLResult (&mysql_res);
+
+   /***** Get number of posts that I have written in each thread
+          and number of users who have written posts in each thread *****/
+   NumRows = DB_QuerySELECT (&mysql_res,"can not get the number of writers"
+					" in threads of a forum",
+			     "SELECT ThrCod,SUM(UsrCod=%ld),COUNT(DISTINCT UsrCod)"
+			     " FROM forum_post"
+			     " WHERE ThrCod IN (%s)"
+			     " GROUP BY ThrCod",
+			     Gbl.Usrs.Me.UsrDat.UsrCod,ThrCods);
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      if ((Thr = For_GetThrInList (Thrs,NumThrs,Str_ConvertStrCodToLongCod (row[0]))))
+	{
+	 if (sscanf (row[1],"%u",&Thr->NumMyPosts) != 1)
+	    Thr->NumMyPosts = 0;
+	 if (sscanf (row[2],"%u",&Thr->NumWriters) != 1)
+	    Thr->NumWriters = 0;
+	}
+     }
+   DB_FreeMySQLResult (&mysql_res);
+
+   /***** Get number of users who have read each thread *****/
+   NumRows = DB_QuerySELECT (&mysql_res,"can not get the number of readers"
+					" of threads of a forum",
+			     "SELECT ThrCod,COUNT(*)"
+			     " FROM forum_thr_read"
+			     " WHERE ThrCod IN (%s)"
+			     " GROUP BY ThrCod",
+			     ThrCods);
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      if ((Thr = For_GetThrInList (Thrs,NumThrs,Str_ConvertStrCodToLongCod (row[0]))))
+	 if (sscanf (row[1],"%u",&Thr->NumReaders) != 1)
+	    Thr->NumReaders = 0;
+     }
+   DB_FreeMySQLResult (&mysql_res);
 
-   /***** Get number of posts in this thread *****/
-   Thr->NumPosts = For_GetNumPstsInThr (Thr->ThrCod);
+   /***** Free list of thread codes *****/
+   free (ThrCods);
+  }
 
-   /***** Get number of unread (by me) posts in this thread *****/
-   Thr->NumUnreadPosts = For_GetNumOfUnreadPostsInThr (Thr->ThrCod,Thr->NumPosts);
+/*****************************************************************************/
+/********************* Find a thread in a list of threads ********************/
+/*****************************************************************************/
+// Return NULL if not found
 
-   /***** Get number of posts that I have written in this thread *****/
-   Thr->NumMyPosts = For_GetNumMyPstInThr (Thr->ThrCod);
+static struct ForumThread *For_GetThrInList (struct ForumThread Thrs[],unsigned NumThrs,
+                                             long ThrCod)
+  {
+   unsigned NumThr;
 
-   /***** Get number of users who have write posts in this thread *****/
-   Thr->NumWriters = For_GetNumOfWritersInThr (Thr->ThrCod);
+   for (NumThr = 0;
+	NumThr < NumThrs;
+	NumThr++)
+      if (Thrs[NumThr].ThrCod == ThrCod)
+	 return &Thrs[NumThr];
 
-   /***** Get number of users who have read this thread *****/
-   Thr->NumReaders = For_GetNumOfReadersOfThr (Thr->ThrCod);
+   return NULL;
   }
 
 /*****************************************************************************/
@@ -4329,6 +4633,11 @@ static bool For_CheckIfThrBelongsToForum (long ThrCod,struct Forum *Forum)
 
 static void For_MoveThrToCurrentForum (long ThrCod)
   {
+   struct Forum OldForum;
+
+   /***** Get the forum where the thread is, before moving it *****/
+   For_GetForumTypeAndLocationOfAThread (ThrCod,&OldForum);
+
    /***** Move a thread to current forum *****/
    switch (Gbl.Forum.ForumSelected.Type)
      {
@@ -4387,6 +4696,10 @@ static void For_MoveThrToCurrentForum (long ThrCod)
 	 Lay_ShowErrorAndExit ("Wrong forum.");
 	 break;
      }
+
+   /***** Update the counters of both forums *****/
+   For_UpdateForumCounters (&OldForum);
+   For_UpdateForumCounters (&Gbl.Forum.ForumSelected);
   }
 
 /*****************************************************************************/
@@ -4519,4 +4832,16 @@ void For_RemoveForums (Hie_Level_t Scope,long ForumLocation)
 	           ForumType[Scope].Usrs,
 	           ForumType[Scope].Tchs,
 	           ForumLocation);
+
+   /***** Remove counters of forums *****/
+   DB_QueryDELETE ("can not remove counters of forums",
+		   "DELETE FROM forum_counters"
+		   " WHERE"
+		   " (ForumType=%u"
+		   " OR"
+		   " ForumType=%u)"
+		   " AND Location=%ld",
+	           ForumType[Scope].Usrs,
+	           ForumType[Scope].Tchs,
+	           ForumLocation);
   }
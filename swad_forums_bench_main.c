@@ -0,0 +1,587 @@
+// swad_forums_bench_main.c: main of swad_forums_bench, queries to show forums with many threads
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <stdio.h>		// For fprintf, sprintf
+#include <stdlib.h>		// For atoi, exit, malloc, free, strtol
+
+#include "swad_bench.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define FoB_FORUM_COURSE_USRS	0	// As For_FORUM_COURSE_USRS
+#define FoB_THRS_PER_PAGE	10	// As Pag_ITEMS_PER_PAGE
+#define FoB_PSTS_PER_THR	4
+#define FoB_NUM_USRS		20	// Users who write posts. I am user 1
+#define FoB_MY_USR_COD		1
+
+#define FoB_MAX_BYTES_CODS(Num) ((Num) * (10 + 1) + 1)
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   FoB_BEFORE,	// Counting queries for each forum and for each thread
+   FoB_NOW,	// Counters and a few set-based queries for all forums or threads
+  } FoB_Version_t;
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void FoB_CreateTables (unsigned NumForums,unsigned NumThrsPerForum);
+static double FoB_ShowForumTrees (FoB_Version_t Version,unsigned NumForums,
+                                  unsigned NumTimes);
+static double FoB_ShowThrPages (FoB_Version_t Version,unsigned NumForums,
+                                unsigned NumThrsPerForum,unsigned NumTimes);
+static unsigned FoB_GetThrCodsInPage (unsigned Location,unsigned NumPage,
+                                      long ThrCods[FoB_THRS_PER_PAGE]);
+static void FoB_GetDataOfOneThr (long ThrCod);
+static void FoB_GetDataOfAllThrs (const char *ThrCods);
+static void FoB_FetchAllRows (MYSQL_RES *mysql_res);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_forums_bench <host> <user> <password> <database>
+                            <forums> <threads per forum> <times>
+   Course forums with the given number of threads are created,
+   and the tree of forums and pages of threads are shown the given number
+   of times, getting the number of threads, posts, unread posts,
+   my posts, writers and readers:
+   1. as before: counting queries for each forum and for each thread,
+   2. now: counters of forums and threads, and a few set-based queries
+      for all the forums in the tree or all the threads in a page.
+   For example, 10000 threads:
+      swad_forums_bench localhost swad_bench password swad_bench 20 500 100
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumForums;
+   int NumThrsPerForum;
+   int NumTimes;
+   FoB_Version_t Version;
+   static const char *TxtTree[] =
+     {
+      [FoB_BEFORE] = "Forum tree, queries for each forum",
+      [FoB_NOW   ] = "Forum tree, counters for all forums",
+     };
+   static const char *TxtThrs[] =
+     {
+      [FoB_BEFORE] = "Page of threads, queries for each thread",
+      [FoB_NOW   ] = "Page of threads, queries for whole page",
+     };
+
+   if (argc != 1 + Bch_NUM_ARGS_DB + 3 ||
+       (NumForums       = atoi (argv[1 + Bch_NUM_ARGS_DB    ])) <= 0 ||
+       (NumThrsPerForum = atoi (argv[1 + Bch_NUM_ARGS_DB + 1])) <= 0 ||
+       (NumTimes        = atoi (argv[1 + Bch_NUM_ARGS_DB + 2])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s " Bch_USAGE_DB
+		      " <forums> <threads per forum> <times>\n",
+	       argv[0]);
+      return 1;
+     }
+
+   Bch_ConnectToDB (&argv[1]);
+   FoB_CreateTables ((unsigned) NumForums,(unsigned) NumThrsPerForum);
+
+   for (Version  = FoB_BEFORE;
+	Version <= FoB_NOW;
+	Version++)
+     {
+      Bch_WriteTime (TxtTree[Version],
+		     (unsigned long) NumTimes,
+		     FoB_ShowForumTrees (Version,(unsigned) NumForums,
+					 (unsigned) NumTimes));
+      Bch_WriteTime (TxtThrs[Version],
+		     (unsigned long) NumTimes,
+		     FoB_ShowThrPages (Version,(unsigned) NumForums,
+				       (unsigned) NumThrsPerForum,
+				       (unsigned) NumTimes));
+     }
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_forum_thread,bench_forum_post,"
+	      "bench_forum_thr_read,bench_forum_disabled_post,bench_forum_counters");
+   Bch_DisconnectFromDB ();
+   return 0;
+  }
+
+/*****************************************************************************/
+/************************ Create tables similar to forums ********************/
+/*****************************************************************************/
+// Forums are course forums with locations 1...NumForums.
+// Every thread has the same number of posts, one minute between them.
+// I have read two out of three threads, until its second post,
+// and others have read some threads.
+// The first post of one out of ten threads is disabled.
+
+static void FoB_CreateTables (unsigned NumForums,unsigned NumThrsPerForum)
+  {
+   unsigned NumThrs = NumForums * NumThrsPerForum;
+   unsigned ThrCod;
+   unsigned Location;
+   unsigned long PstCod;
+   unsigned long Minutes;
+   unsigned NumPst;
+   unsigned UsrCod;
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_forum_thread,bench_forum_post,"
+	      "bench_forum_thr_read,bench_forum_disabled_post,bench_forum_counters");
+   Bch_Query ("CREATE TABLE bench_forum_thread ("
+		 "ThrCod INT NOT NULL AUTO_INCREMENT,"
+		 "ForumType TINYINT NOT NULL,"
+		 "Location INT NOT NULL DEFAULT -1,"
+		 "FirstPstCod INT NOT NULL,"
+		 "LastPstCod INT NOT NULL,"
+		 "NumPsts INT NOT NULL DEFAULT 0,"
+	      "UNIQUE INDEX(ThrCod),"
+	      "INDEX(ForumType),"
+	      "INDEX(Location),"
+	      "UNIQUE INDEX(FirstPstCod),"
+	      "UNIQUE INDEX(LastPstCod))");
+   Bch_Query ("CREATE TABLE bench_forum_post ("
+		 "PstCod INT NOT NULL AUTO_INCREMENT,"
+		 "ThrCod INT NOT NULL,"
+		 "UsrCod INT NOT NULL,"
+		 "CreatTime DATETIME NOT NULL,"
+		 "ModifTime DATETIME NOT NULL,"
+		 "Subject TEXT NOT NULL,"
+		 "Content LONGTEXT NOT NULL,"
+	      "UNIQUE INDEX(PstCod),"
+	      "INDEX(ThrCod),"
+	      "INDEX(UsrCod),"
+	      "INDEX(CreatTime),"
+	      "INDEX(ModifTime))");
+   Bch_Query ("CREATE TABLE bench_forum_thr_read ("
+		 "ThrCod INT NOT NULL,"
+		 "UsrCod INT NOT NULL,"
+		 "ReadTime DATETIME NOT NULL,"
+	      "UNIQUE INDEX(ThrCod,UsrCod))");
+   Bch_Query ("CREATE TABLE bench_forum_disabled_post ("
+		 "PstCod INT NOT NULL,"
+		 "UsrCod INT NOT NULL,"
+		 "DisableTime DATETIME NOT NULL,"
+	      "UNIQUE INDEX(PstCod))");
+   Bch_Query ("CREATE TABLE bench_forum_counters ("
+		 "ForumType TINYINT NOT NULL,"
+		 "Location INT NOT NULL DEFAULT -1,"
+		 "NumThrs INT NOT NULL DEFAULT 0,"
+		 "NumPsts INT NOT NULL DEFAULT 0,"
+		 "LastPstTime DATETIME NOT NULL,"
+	      "UNIQUE INDEX(ForumType,Location))");
+
+   for (ThrCod  = 1;
+	ThrCod <= NumThrs;
+	ThrCod++)
+     {
+      Location = (ThrCod - 1) % NumForums + 1;
+      PstCod = (unsigned long) (ThrCod - 1) * FoB_PSTS_PER_THR + 1;
+      Minutes = (unsigned long) (NumThrs - ThrCod + 1) * FoB_PSTS_PER_THR;
+
+      /***** Thread *****/
+      Bch_Query ("INSERT INTO bench_forum_thread"
+		 " (ThrCod,ForumType,Location,FirstPstCod,LastPstCod,NumPsts)"
+		 " VALUES"
+		 " (%u,%u,%u,%lu,%lu,%u)",
+		 ThrCod,FoB_FORUM_COURSE_USRS,Location,
+		 PstCod,PstCod + FoB_PSTS_PER_THR - 1,FoB_PSTS_PER_THR);
+
+      /***** Posts *****/
+      for (NumPst = 0;
+	   NumPst < FoB_PSTS_PER_THR;
+	   NumPst++)
+	 Bch_Query ("INSERT INTO bench_forum_post"
+		    " (PstCod,ThrCod,UsrCod,CreatTime,ModifTime,Subject,Content)"
+		    " VALUES"
+		    " (%lu,%u,%u,"
+		    "NOW()-INTERVAL %lu MINUTE,NOW()-INTERVAL %lu MINUTE,"
+		    "'Subject of thread %u','Content of post %lu')",
+		    PstCod + NumPst,ThrCod,(ThrCod + NumPst) % FoB_NUM_USRS + 1,
+		    Minutes - NumPst,Minutes - NumPst,
+		    ThrCod,PstCod + NumPst);
+
+      /***** Readers *****/
+      if (ThrCod % 3)
+	 Bch_Query ("INSERT INTO bench_forum_thr_read (ThrCod,UsrCod,ReadTime)"
+		    " VALUES (%u,%u,NOW()-INTERVAL %lu MINUTE)",
+		    ThrCod,FoB_MY_USR_COD,Minutes - 1);
+      for (UsrCod  = 2;
+	   UsrCod <= FoB_NUM_USRS;
+	   UsrCod++)
+	 if ((ThrCod + UsrCod) % 4 == 0)
+	    Bch_Query ("INSERT INTO bench_forum_thr_read (ThrCod,UsrCod,ReadTime)"
+		       " VALUES (%u,%u,NOW())",
+		       ThrCod,UsrCod);
+
+      /***** Disabled posts *****/
+      if (ThrCod % 10 == 0)
+	 Bch_Query ("INSERT INTO bench_forum_disabled_post (PstCod,UsrCod,DisableTime)"
+		    " VALUES (%lu,%u,NOW())",
+		    PstCod,FoB_MY_USR_COD);
+     }
+
+   /***** Counters of forums *****/
+   Bch_Query ("INSERT INTO bench_forum_counters"
+	      " (ForumType,Location,NumThrs,NumPsts,LastPstTime)"
+	      " SELECT bench_forum_thread.ForumType,bench_forum_thread.Location,"
+	      "COUNT(*),SUM(bench_forum_thread.NumPsts),"
+	      "MAX(bench_forum_post.ModifTime)"
+	      " FROM bench_forum_thread,bench_forum_post"
+	      " WHERE bench_forum_thread.LastPstCod=bench_forum_post.PstCod"
+	      " GROUP BY bench_forum_thread.ForumType,bench_forum_thread.Location");
+  }
+
+/*****************************************************************************/
+/*********** Show the tree of forums several times and return time ***********/
+/*****************************************************************************/
+
+static double FoB_ShowForumTrees (FoB_Version_t Version,unsigned NumForums,
+                                  unsigned NumTimes)
+  {
+   unsigned NumTime;
+   unsigned Location;
+   char *Locations;
+   char *Ptr;
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   double Start = Bch_GetSeconds ();
+
+   for (NumTime = 0;
+	NumTime < NumTimes;
+	NumTime++)
+      switch (Version)
+	{
+	 case FoB_BEFORE:
+	    for (Location  = 1;
+		 Location <= NumForums;
+		 Location++)
+	      {
+	       /* Number of threads in forum */
+	       Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_forum_thread"
+			       " WHERE ForumType=%u AND Location=%u",
+			       FoB_FORUM_COURSE_USRS,Location);
+
+	       /* Last time I read this forum */
+	       Bch_QuerySELECT (&mysql_res,
+				"SELECT MAX(bench_forum_thr_read.ReadTime)"
+				" FROM bench_forum_thr_read,bench_forum_thread"
+				" WHERE bench_forum_thr_read.UsrCod=%u"
+				" AND bench_forum_thr_read.ThrCod=bench_forum_thread.ThrCod"
+				" AND bench_forum_thread.ForumType=%u"
+				" AND bench_forum_thread.Location=%u",
+				FoB_MY_USR_COD,
+				FoB_FORUM_COURSE_USRS,Location);
+
+	       /* Number of threads with new posts */
+	       if ((row = mysql_fetch_row (mysql_res)) && row[0])
+		  Bch_QueryCOUNT ("SELECT COUNT(*)"
+				  " FROM bench_forum_thread,bench_forum_post"
+				  " WHERE bench_forum_thread.ForumType=%u"
+				  " AND bench_forum_thread.Location=%u"
+				  " AND bench_forum_thread.LastPstCod=bench_forum_post.PstCod"
+				  " AND bench_forum_post.ModifTime>'%s'",
+				  FoB_FORUM_COURSE_USRS,Location,row[0]);
+	       mysql_free_result (mysql_res);
+	      }
+	    break;
+	 case FoB_NOW:
+	    /* Counters of all forums */
+	    if ((Locations = (char *) malloc (FoB_MAX_BYTES_CODS (NumForums))) == NULL)
+	      {
+	       fprintf (stderr,"Not enough memory.\n");
+	       exit (1);
+	      }
+	    for (Location = 1, Ptr = Locations;
+		 Location <= NumForums;
+		 Location++)
+	       Ptr += sprintf (Ptr,Location == 1 ? "%u" :
+						   ",%u",
+			       Location);
+	    Bch_QuerySELECT (&mysql_res,
+			     "SELECT ForumType,Location,NumThrs,"
+			     "UNIX_TIMESTAMP(LastPstTime)"
+			     " FROM bench_forum_counters"
+			     " WHERE Location IN (%s) AND NumThrs>0",
+			     Locations);
+	    FoB_FetchAllRows (mysql_res);
+	    free (Locations);
+
+	    /* Last time I read each forum */
+	    Bch_QuerySELECT (&mysql_res,
+			     "SELECT bench_forum_thread.ForumType,"
+			     "bench_forum_thread.Location,"
+			     "UNIX_TIMESTAMP(MAX(bench_forum_thr_read.ReadTime))"
+			     " FROM bench_forum_thr_read,bench_forum_thread"
+			     " WHERE bench_forum_thr_read.UsrCod=%u"
+			     " AND bench_forum_thr_read.ThrCod=bench_forum_thread.ThrCod"
+			     " GROUP BY bench_forum_thread.ForumType,"
+			     "bench_forum_thread.Location",
+			     FoB_MY_USR_COD);
+	    FoB_FetchAllRows (mysql_res);
+	    break;
+	}
+
+   return Bch_GetSeconds () - Start;
+  }
+
+/*****************************************************************************/
+/********** Show pages of threads several times and return time **************/
+/*****************************************************************************/
+// Each time, a different page of a different forum
+
+static double FoB_ShowThrPages (FoB_Version_t Version,unsigned NumForums,
+                                unsigned NumThrsPerForum,unsigned NumTimes)
+  {
+   unsigned NumPages = (NumThrsPerForum + FoB_THRS_PER_PAGE - 1) / FoB_THRS_PER_PAGE;
+   unsigned NumTime;
+   long ThrCods[FoB_THRS_PER_PAGE];
+   unsigned NumThrs;
+   unsigned NumThr;
+   char StrThrCods[FoB_MAX_BYTES_CODS (FoB_THRS_PER_PAGE)];
+   char *Ptr;
+   double Start = Bch_GetSeconds ();
+
+   for (NumTime = 0;
+	NumTime < NumTimes;
+	NumTime++)
+     {
+      /***** Get threads in page *****/
+      NumThrs = FoB_GetThrCodsInPage (NumTime % NumForums + 1,
+				      NumTime % NumPages,ThrCods);
+
+      /***** Get data of threads *****/
+      switch (Version)
+	{
+	 case FoB_BEFORE:
+	    for (NumThr = 0;
+		 NumThr < NumThrs;
+		 NumThr++)
+	       FoB_GetDataOfOneThr (ThrCods[NumThr]);
+	    break;
+	 case FoB_NOW:
+	    if (NumThrs)
+	      {
+	       for (NumThr = 0, Ptr = StrThrCods;
+		    NumThr < NumThrs;
+		    NumThr++)
+		  Ptr += sprintf (Ptr,NumThr ? ",%ld" :
+					       "%ld",
+				  ThrCods[NumThr]);
+	       FoB_GetDataOfAllThrs (StrThrCods);
+	      }
+	    break;
+	}
+     }
+
+   return Bch_GetSeconds () - Start;
+  }
+
+/*****************************************************************************/
+/**************** Get codes of the threads in a page of a forum **************/
+/*****************************************************************************/
+// As in the forum, all the threads are got and then the page is selected
+
+static unsigned FoB_GetThrCodsInPage (unsigned Location,unsigned NumPage,
+                                      long ThrCods[FoB_THRS_PER_PAGE])
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows;
+   unsigned long NumRow;
+   unsigned NumThrs = 0;
+
+   NumRows = Bch_QuerySELECT (&mysql_res,
+			      "SELECT bench_forum_thread.ThrCod"
+			      " FROM bench_forum_thread,bench_forum_post"
+			      " WHERE bench_forum_thread.ForumType=%u"
+			      " AND bench_forum_thread.Location=%u"
+			      " AND bench_forum_thread.LastPstCod=bench_forum_post.PstCod"
+			      " ORDER BY bench_forum_post.CreatTime DESC",
+			      FoB_FORUM_COURSE_USRS,Location);
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      if (NumRow / FoB_THRS_PER_PAGE == NumPage)
+	 ThrCods[NumThrs++] = strtol (row[0],NULL,10);
+     }
+   mysql_free_result (mysql_res);
+
+   return NumThrs;
+  }
+
+/*****************************************************************************/
+/*********** Get data of one thread, with several counting queries ***********/
+/*****************************************************************************/
+
+static void FoB_GetDataOfOneThr (long ThrCod)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   long PstCods[2] = {-1L,-1L};
+   unsigned NumPst;
+
+   /***** Data of thread *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT m0.PstCod,m1.PstCod,m0.UsrCod,m1.UsrCod,"
+		    "UNIX_TIMESTAMP(m0.CreatTime),"
+		    "UNIX_TIMESTAMP(m1.CreatTime),"
+		    "m0.Subject"
+		    " FROM bench_forum_thread,"
+		    "bench_forum_post AS m0,bench_forum_post AS m1"
+		    " WHERE bench_forum_thread.ThrCod=%ld"
+		    " AND bench_forum_thread.FirstPstCod=m0.PstCod"
+		    " AND bench_forum_thread.LastPstCod=m1.PstCod",
+		    ThrCod);
+   if ((row = mysql_fetch_row (mysql_res)))
+     {
+      PstCods[0] = strtol (row[0],NULL,10);
+      PstCods[1] = strtol (row[1],NULL,10);
+     }
+   mysql_free_result (mysql_res);
+
+   /***** Are first and last posts enabled? *****/
+   for (NumPst = 0;
+	NumPst < 2;
+	NumPst++)
+      Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_forum_disabled_post"
+		      " WHERE PstCod=%ld",
+		      PstCods[NumPst]);
+
+   /***** Number of posts *****/
+   Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_forum_post"
+		   " WHERE ThrCod=%ld",
+		   ThrCod);
+
+   /***** Number of unread posts *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT ReadTime FROM bench_forum_thr_read"
+		    " WHERE ThrCod=%ld AND UsrCod=%u",
+		    ThrCod,FoB_MY_USR_COD);
+   if ((row = mysql_fetch_row (mysql_res)))
+      Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_forum_post"
+		      " WHERE ThrCod=%ld AND ModifTime>'%s'",
+		      ThrCod,row[0]);
+   mysql_free_result (mysql_res);
+
+   /***** Number of my posts *****/
+   Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_forum_post"
+		   " WHERE ThrCod=%ld AND UsrCod=%u",
+		   ThrCod,FoB_MY_USR_COD);
+
+   /***** Number of writers *****/
+   Bch_QueryCOUNT ("SELECT COUNT(DISTINCT UsrCod) FROM bench_forum_post"
+		   " WHERE ThrCod=%ld",
+		   ThrCod);
+
+   /***** Number of readers *****/
+   Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_forum_thr_read"
+		   " WHERE ThrCod=%ld",
+		   ThrCod);
+  }
+
+/*****************************************************************************/
+/************ Get data of all threads in a page, with four queries ***********/
+/*****************************************************************************/
+
+static void FoB_GetDataOfAllThrs (const char *ThrCods)
+  {
+   MYSQL_RES *mysql_res;
+
+   /***** Data of threads, including number of posts
+          and if first and last posts are enabled *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT bench_forum_thread.ThrCod,"
+		    "m0.PstCod,m1.PstCod,m0.UsrCod,m1.UsrCod,"
+		    "UNIX_TIMESTAMP(m0.CreatTime),"
+		    "UNIX_TIMESTAMP(m1.CreatTime),"
+		    "m0.Subject,"
+		    "bench_forum_thread.NumPsts,"
+		    "d0.PstCod IS NULL,"
+		    "d1.PstCod IS NULL"
+		    " FROM bench_forum_thread"
+		    " JOIN bench_forum_post AS m0"
+		    " ON bench_forum_thread.FirstPstCod=m0.PstCod"
+		    " JOIN bench_forum_post AS m1"
+		    " ON bench_forum_thread.LastPstCod=m1.PstCod"
+		    " LEFT JOIN bench_forum_disabled_post AS d0"
+		    " ON m0.PstCod=d0.PstCod"
+		    " LEFT JOIN bench_forum_disabled_post AS d1"
+		    " ON m1.PstCod=d1.PstCod"
+		    " WHERE bench_forum_thread.ThrCod IN (%s)",
+		    ThrCods);
+   FoB_FetchAllRows (mysql_res);
+
+   /***** Number of unread posts in each thread *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT bench_forum_post.ThrCod,COUNT(*)"
+		    " FROM bench_forum_post"
+		    " LEFT JOIN bench_forum_thr_read"
+		    " ON bench_forum_thr_read.ThrCod=bench_forum_post.ThrCod"
+		    " AND bench_forum_thr_read.UsrCod=%u"
+		    " WHERE bench_forum_post.ThrCod IN (%s)"
+		    " AND (bench_forum_thr_read.ReadTime IS NULL"
+		    " OR bench_forum_post.ModifTime>bench_forum_thr_read.ReadTime)"
+		    " GROUP BY bench_forum_post.ThrCod",
+		    FoB_MY_USR_COD,ThrCods);
+   FoB_FetchAllRows (mysql_res);
+
+   /***** Number of my posts and number of writers in each thread *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT ThrCod,SUM(UsrCod=%u),COUNT(DISTINCT UsrCod)"
+		    " FROM bench_forum_post"
+		    " WHERE ThrCod IN (%s)"
+		    " GROUP BY ThrCod",
+		    FoB_MY_USR_COD,ThrCods);
+   FoB_FetchAllRows (mysql_res);
+
+   /***** Number of readers of each thread *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT ThrCod,COUNT(*)"
+		    " FROM bench_forum_thr_read"
+		    " WHERE ThrCod IN (%s)"
+		    " GROUP BY ThrCod",
+		    ThrCods);
+   FoB_FetchAllRows (mysql_res);
+  }
+
+/*****************************************************************************/
+/********************* Fetch all rows and free result ************************/
+/*****************************************************************************/
+
+static void FoB_FetchAllRows (MYSQL_RES *mysql_res)
+  {
+   while (mysql_fetch_row (mysql_res));
+   mysql_free_result (mysql_res);
+  }
@@ -1681,6 +1681,13 @@ static void Gam_RemAnswersOfAQuestion (long GamCod,unsigned QstInd)
 		   " AND mch_matches.MchCod=mch_answers.MchCod"
 		   " AND mch_answers.QstInd=%u",	// ...remove only answers to this question
 		   GamCod,QstInd);
+   DB_QueryDELETE ("can not remove the tally of answers of a question",
+		   "DELETE FROM mch_tally"
+		   " USING mch_matches,mch_tally"
+		   " WHERE mch_matches.GamCod=%ld"	// From all matches of this game...
+		   " AND mch_matches.MchCod=mch_tally.MchCod"
+		   " AND mch_tally.QstInd=%u",		// ...remove only tally of this question
+		   GamCod,QstInd);
   }
 
 /*****************************************************************************/
@@ -2302,6 +2309,13 @@ void Gam_RemoveQst (void)
 		      " AND mch_matches.MchCod=mch_answers.MchCod"
 		      " AND mch_answers.QstInd>%u",
 		      Game.GamCod,QstInd);
+      DB_QueryUPDATE ("can not update indexes of questions in tally of answers",
+		      "UPDATE mch_tally,mch_matches"
+		      " SET mch_tally.QstInd=mch_tally.QstInd-1"
+		      " WHERE mch_matches.GamCod=%ld"
+		      " AND mch_matches.MchCod=mch_tally.MchCod"
+		      " AND mch_tally.QstInd>%u",
+		      Game.GamCod,QstInd);
       DB_QueryUPDATE ("can not update indexes of questions",
 		      "UPDATE gam_questions SET QstInd=QstInd-1"
 		      " WHERE GamCod=%ld AND QstInd>%u",
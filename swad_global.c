@@ -100,10 +100,11 @@ void Gbl_InitializeGlobals (void)
    Dat_GetStartExecutionTimeUTC ();
    Dat_GetAndConvertCurrentDateTime ();
 
-   Gbl.Config.DatabasePassword[0] = '\0';
-   Gbl.Config.SMTPPassword[0] = '\0';
+   // Gbl.Config is not reset here
+   // because a persistent worker reads the config file only once
 
    Gbl.TimeGenerationInMicroseconds = Gbl.TimeSendInMicroseconds = 0L;
+   Gbl.BytesGenerated = Gbl.BytesSent = 0L;
    Gbl.PID = getpid ();
    Sta_GetRemoteAddr ();
 
@@ -119,7 +120,6 @@ void Gbl_InitializeGlobals (void)
    Gbl.Params.GetMethod = false;
 
    Gbl.F.Out = stdout;
-   Gbl.F.Tmp = NULL;
    Gbl.F.XML = NULL;
    Gbl.F.Rep = NULL;	// Report
 
@@ -130,8 +130,11 @@ void Gbl_InitializeGlobals (void)
 
    Gbl.Alerts.Num = 0;	// No pending alerts to be shown
 
-   Gbl.DB.DatabaseIsOpen = false;
+   // Gbl.DB.DatabaseIsOpen is not reset here
+   // because a persistent worker reuses the connection between requests
    Gbl.DB.LockedTables = false;
+   Gbl.DB.NumNamedLocks = 0;
+   Gbl.DB.InTransaction = false;
 
    Gbl.HiddenParamsInsertedIntoDB = false;
 
@@ -494,8 +497,6 @@ void Gbl_Cleanup (void)
    Tst_FreeTagsList ();
    Exa_FreeMemExamAnnouncement ();
    Exa_FreeListExamAnnouncements ();
-   if (Gbl.F.Tmp)
-      fclose (Gbl.F.Tmp);
    Fil_CloseXMLFile ();
    Fil_CloseReportFile ();
    Par_FreeParams ();
@@ -151,6 +151,8 @@ struct Globals
      {
       bool DatabaseIsOpen;
       bool LockedTables;
+      unsigned NumNamedLocks;	// Locks got with GET_LOCK and not released
+      bool InTransaction;	// Transaction begun and not committed
      } DB;
 
    bool HiddenParamsInsertedIntoDB;	// If parameters are inserted in the database in this execution
@@ -162,6 +164,8 @@ struct Globals
    struct timezone tz;
    long TimeGenerationInMicroseconds;
    long TimeSendInMicroseconds;
+   long BytesGenerated;	// Size of HTML output
+   long BytesSent;	// Size of HTML output sent (compressed or not)
 
    char IP[Cns_MAX_BYTES_IP + 1];
    char UniqueNameEncrypted[Cry_BYTES_ENCRYPTED_STR_SHA256_BASE64 + 1];	// Used for session id, temporary directory names, etc.
@@ -202,10 +206,6 @@ struct Globals
    unsigned RowEvenOdd;	// To alternate row colors in listings
    char *ColorRows[2];
    const char *XMLPtr;
-   struct
-     {
-      char FileName[PATH_MAX + 1];
-     } HTMLOutput;
    struct
      {
       Hie_Level_t Level;	// Current level in the hierarchy: system, country, institution, centre, degree or course
@@ -535,7 +535,6 @@ struct Globals
       struct
         {
 	 bool CreateZIP;
-         char TmpDir[NAME_MAX + 1];
         } ZIP;
      } FileBrowser;	// Struct used for a file browser
    struct
@@ -733,8 +732,8 @@ struct Globals
       Sta_Role_t Role;
       Sta_CountType_t CountType;
       Act_Action_t NumAction;
-      unsigned long FirstRow;
-      unsigned long LastRow;
+      long OlderThanLogCod;	// Show a page of detailed clicks older than this click
+      long NewerThanLogCod;	// Show a page of detailed clicks newer than this click
       unsigned RowsPerPage;
       long DegTypCod;
       long DptCod;
@@ -0,0 +1,192 @@
+// swad_housekeeping.c: housekeeping jobs run outside users' requests
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************* Headers ***********************************/
+/*****************************************************************************/
+
+#include <stddef.h>		// For NULL
+#include <stdio.h>		// For printf
+#include <sys/time.h>		// For gettimeofday
+
+#include "swad_config.h"
+#include "swad_database.h"
+#include "swad_file.h"
+#include "swad_file_browser.h"
+#include "swad_firewall.h"
+#include "swad_housekeeping.h"
+#include "swad_log.h"
+#include "swad_notification.h"
+#include "swad_photo.h"
+#include "swad_search.h"
+#include "swad_session.h"
+#include "swad_setting.h"
+#include "swad_statistic.h"
+
+/*****************************************************************************/
+/************** External global variables from others modules ****************/
+/*****************************************************************************/
+
+/*****************************************************************************/
+/***************************** Private constants *****************************/
+/*****************************************************************************/
+
+#define Hkp_LOCK "swad_housekeeping"	// Name of database lock to avoid two simultaneous runs
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+struct Hkp_Job
+  {
+   const char *Name;		// Name of the job stored in database
+   time_t Interval;		// The job is run when these seconds have passed since its last run
+   void (*Function) (void);	// Function to run, or...
+   const char *Path;		// ...temporary directory to clean
+   time_t TimeToRemove;		// Files in temporary directory older than these seconds are removed
+  };
+
+/*****************************************************************************/
+/***************************** Private variables *****************************/
+/*****************************************************************************/
+
+static const struct Hkp_Job Hkp_Jobs[] =
+  {
+   {"load_log_spool"	,Cfg_TIME_TO_LOAD_LOG_SPOOL   ,Log_LoadSpoolIntoDB			,NULL,0},	// Insert accesses pending in spool into database log
+   {"expired_sessions"	,(time_t)(       60UL),Ses_RemoveExpiredSessions		,NULL,0},	// Remove expired sessions and users without sessions from connected list
+   {"send_notifs"	,(time_t)(       60UL),Ntf_SendPendingNotifByEMailToAllUsrs	,NULL,0},	// Send pending notifications by email
+   {"purge_firewall"	,(time_t)( 5UL * 60UL),FW_PurgeFirewall			,NULL,0},	// Remove old clicks from firewall
+   {"roll_up_hits"	,(time_t)( 5UL * 60UL),Sta_RollUpHits			,NULL,0},	// Add last hours in recent log to statistics table
+   {"expanded_folders"	,(time_t)(60UL * 60UL),Brw_RemoveExpiredExpandedFolders	,NULL,0},	// Remove old expanded folders (from all users)
+   {"IP_settings"	,(time_t)(60UL * 60UL),Set_RemoveOldSettingsFromIP		,NULL,0},	// Remove old settings from IP
+   {"recent_log"	,(time_t)(60UL * 60UL),Log_RemoveOldEntriesRecentLog		,NULL,0},	// Remove old entries in recent log table
+   {"search_index"	,(time_t)(24UL * 60UL * 60UL),Sch_RepairSearchIndex	,NULL,0},	// Repair index of words used in searches
+   {"photo_links"	,(time_t)(24UL * 60UL * 60UL),Pho_RepairPublicLinksToPhotos	,NULL,0},	// Create missing public links to users' photos
+   {"tmp_browser"	,(time_t)(15UL * 60UL),NULL,Cfg_PATH_FILE_BROWSER_TMP_PUBLIC	,Cfg_TIME_TO_DELETE_BROWSER_TMP_FILES	},	// Remove the oldest temporary public directories used for downloading
+   {"tmp_out"		,(time_t)(15UL * 60UL),NULL,Cfg_PATH_OUT_PRIVATE		,Cfg_TIME_TO_DELETE_HTML_OUTPUT		},
+   {"tmp_photo_public"	,(time_t)(15UL * 60UL),NULL,Cfg_PATH_PHOTO_TMP_PUBLIC		,Cfg_TIME_TO_DELETE_PHOTOS_TMP_FILES	},
+   {"tmp_photo_private"	,(time_t)(15UL * 60UL),NULL,Cfg_PATH_PHOTO_TMP_PRIVATE		,Cfg_TIME_TO_DELETE_PHOTOS_TMP_FILES	},
+   {"tmp_media"		,(time_t)(15UL * 60UL),NULL,Cfg_PATH_MEDIA_TMP_PRIVATE		,Cfg_TIME_TO_DELETE_MEDIA_TMP_FILES	},
+   {"tmp_zip"		,(time_t)(15UL * 60UL),NULL,Cfg_PATH_ZIP_PRIVATE		,Cfg_TIME_TO_DELETE_BROWSER_ZIP_FILES	},
+   {"tmp_marks"		,(time_t)(15UL * 60UL),NULL,Cfg_PATH_MARK_PRIVATE		,Cfg_TIME_TO_DELETE_MARKS_TMP_FILES	},
+   {"tmp_test"		,(time_t)(15UL * 60UL),NULL,Cfg_PATH_TEST_PRIVATE		,Cfg_TIME_TO_DELETE_TEST_TMP_FILES	},
+   {"tmp_upload"	,(time_t)(15UL * 60UL),NULL,Cfg_PATH_UPLOAD_PRIVATE		,Cfg_TIME_TO_DELETE_UPLOAD_TMP_FILES	},
+  };
+#define Hkp_NUM_JOBS (sizeof (Hkp_Jobs) / sizeof (Hkp_Jobs[0]))
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static bool Hkp_CheckIfJobIsPending (const struct Hkp_Job *Job);
+static long long Hkp_RunJob (const struct Hkp_Job *Job);
+static void Hkp_StoreJobTime (const struct Hkp_Job *Job,long long TimeUs);
+
+/*****************************************************************************/
+/******************* Run the jobs whose interval has passed ******************/
+/*****************************************************************************/
+// Called periodically by swad_maintenance (from cron or as a daemon),
+// so users' requests never do housekeeping
+
+void Hkp_RunPendingJobs (bool Verbose)
+  {
+   unsigned NumJob;
+   long long TimeUs;
+
+   /***** Only one process at a time can run the jobs *****/
+   if (!DB_GetLock (Hkp_LOCK))
+      return;
+
+   /***** Run pending jobs *****/
+   for (NumJob = 0;
+	NumJob < Hkp_NUM_JOBS;
+	NumJob++)
+      if (Hkp_CheckIfJobIsPending (&Hkp_Jobs[NumJob]))
+	{
+	 TimeUs = Hkp_RunJob (&Hkp_Jobs[NumJob]);
+	 Hkp_StoreJobTime (&Hkp_Jobs[NumJob],TimeUs);
+	 if (Verbose)
+	    printf ("%s\t%lld us\n",Hkp_Jobs[NumJob].Name,TimeUs);
+	}
+
+   /***** Release lock *****/
+   DB_ReleaseLock (Hkp_LOCK);
+  }
+
+/*****************************************************************************/
+/************** Check if the interval of a job has passed ********************/
+/*****************************************************************************/
+
+static bool Hkp_CheckIfJobIsPending (const struct Hkp_Job *Job)
+  {
+   return (DB_QueryCOUNT ("can not check if housekeeping job is pending",
+			  "SELECT COUNT(*) FROM hkp_jobs"
+			  " WHERE Job='%s'"
+			  " AND LastRun>FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
+			  Job->Name,
+			  (unsigned long) Job->Interval) == 0);
+  }
+
+/*****************************************************************************/
+/************** Run a job and return the time it took in us ******************/
+/*****************************************************************************/
+
+static long long Hkp_RunJob (const struct Hkp_Job *Job)
+  {
+   struct timeval tvStart;
+   struct timeval tvEnd;
+
+   gettimeofday (&tvStart,NULL);
+
+   if (Job->Function)
+      Job->Function ();
+   else
+      Fil_RemoveOldTmpFiles (Job->Path,Job->TimeToRemove,false);
+
+   gettimeofday (&tvEnd,NULL);
+
+   return (long long) (tvEnd.tv_sec  - tvStart.tv_sec) * 1000000LL +
+	  (long long) (tvEnd.tv_usec - tvStart.tv_usec);
+  }
+
+/*****************************************************************************/
+/************** Store time of last run and duration of a job *****************/
+/*****************************************************************************/
+
+static void Hkp_StoreJobTime (const struct Hkp_Job *Job,long long TimeUs)
+  {
+   DB_QueryINSERT ("can not store housekeeping job",
+		   "INSERT INTO hkp_jobs"
+		   " (Job,LastRun,NumRuns,LastTimeUs,MaxTimeUs,TotalTimeUs)"
+		   " VALUES"
+		   " ('%s',NOW(),1,%lld,%lld,%lld)"
+		   " ON DUPLICATE KEY UPDATE"
+		   " LastRun=NOW(),"
+		   "NumRuns=NumRuns+1,"
+		   "LastTimeUs=%lld,"
+		   "MaxTimeUs=GREATEST(MaxTimeUs,%lld),"
+		   "TotalTimeUs=TotalTimeUs+%lld",
+		   Job->Name,
+		   TimeUs,TimeUs,TimeUs,
+		   TimeUs,TimeUs,TimeUs);
+  }
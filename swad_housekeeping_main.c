@@ -0,0 +1,127 @@
+// swad_housekeeping_main.c: main of swad_maintenance, program to run housekeeping jobs
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <stdbool.h>		// For boolean type
+#include <stdio.h>		// For fprintf
+#include <string.h>		// For strcmp
+#include <unistd.h>		// For sleep
+
+#include "swad_config.h"
+#include "swad_database.h"
+#include "swad_date.h"
+#include "swad_global.h"
+#include "swad_housekeeping.h"
+#include "swad_worker.h"
+
+/*****************************************************************************/
+/************** External global variables from others modules ****************/
+/*****************************************************************************/
+
+extern struct Globals Gbl;
+
+/*****************************************************************************/
+/************************* Private global variables **************************/
+/*****************************************************************************/
+
+static bool HkM_Verbose = false;
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void HkM_RunPendingJobs (void);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   It must be run from the CGI directory, where swad.cfg is, for example:
+   * * * * * cd /var/www/cgi-bin && ./swad_maintenance	(from cron, every minute)
+   cd /var/www/cgi-bin && ./swad_maintenance -d		(as a daemon)
+   Option -v writes the time taken by each job
+   The daemon loads the log spool every few seconds (Cfg_TIME_TO_LOAD_LOG_SPOOL);
+   from cron, accesses appear in statistics and last clicks once a minute
+   Database errors are written to standard error.
+   The daemon goes on, and it reconnects to database in the next loop
+*/
+
+int main (int argc,char *argv[])
+  {
+   bool Daemon = false;
+   bool OK;
+   int NumArg;
+
+   /***** Get options *****/
+   for (NumArg = 1;
+	NumArg < argc;
+	NumArg++)
+      if (!strcmp (argv[NumArg],"-d"))
+	 Daemon = true;
+      else if (!strcmp (argv[NumArg],"-v"))
+	 HkM_Verbose = true;
+
+   /***** Initialize global variables and read config *****/
+   Gbl_InitializeGlobals ();
+   Cfg_GetConfigFromFile ();
+
+   /***** Run pending jobs once (cron) or forever (daemon) *****/
+   for (;;)
+     {
+      if (!(OK = Wrk_RunJob (HkM_RunPendingJobs)))
+	{
+	 /* Error (already written) ==> reconnect in next loop */
+	 DB_CloseDBConnection ();
+	 if (HkM_Verbose)
+	    fprintf (stderr,"Jobs aborted. Database connection closed.\n");
+	}
+      if (!Daemon)
+	 break;
+
+      sleep ((unsigned) Cfg_HOUSEKEEPING_DAEMON_SLEEP);
+      Dat_GetStartExecutionTimeUTC ();	// Some jobs use the current time
+     }
+
+   /***** Close database connection *****/
+   DB_CloseDBConnection ();
+
+   return OK ? 0 :
+	       1;
+  }
+
+/*****************************************************************************/
+/***************** Connect to database and run pending jobs ******************/
+/*****************************************************************************/
+
+static void HkM_RunPendingJobs (void)
+  {
+   /***** Open database connection,
+          or check if it is still alive and reconnect if not *****/
+   DB_OpenDBConnection ();
+
+   /***** Run pending jobs *****/
+   Hkp_RunPendingJobs (HkM_Verbose);
+  }
@@ -0,0 +1,862 @@
+// swad_image.c: decode, resize and encode images in-process
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************* Headers ***********************************/
+/*****************************************************************************/
+
+#include <setjmp.h>		// For setjmp, longjmp
+#include <stdbool.h>		// For boolean type
+#include <stdio.h>		// For FILE (needed before jpeglib.h)
+#include <stdlib.h>		// For malloc, calloc, free
+#include <string.h>		// For memcmp, memset
+
+#include <gif_lib.h>		// For GIF decoding
+#include <jpeglib.h>		// For JPEG decoding and encoding
+#include <png.h>		// For PNG decoding and encoding
+
+#include "swad_image.h"
+
+/*****************************************************************************/
+/***************************** Private constants *****************************/
+/*****************************************************************************/
+
+// Maximum number of pixels of a decoded image, to reject decompression bombs.
+// A decoded image uses up to 4 bytes per pixel (64 MiB)
+#define Img_MAX_PIXELS (16UL * 1024UL * 1024UL)
+
+// JPEG images from cameras can be bigger,
+// because they are scaled down by libjpeg while decoding
+#define Img_MAX_PIXELS_JPEG (48UL * 1024UL * 1024UL)
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   Img_FORMAT_UNKNOWN,
+   Img_FORMAT_JPEG,
+   Img_FORMAT_PNG,
+   Img_FORMAT_GIF,
+  } Img_Format_t;
+
+struct Img_Image
+  {
+   unsigned Width;
+   unsigned Height;
+   unsigned NumComponents;	// 3 ==> RGB, 4 ==> RGBA
+   unsigned char *Pixels;	// Row by row, Width * NumComponents bytes per row
+  };
+
+struct Img_JPEGError
+  {
+   struct jpeg_error_mgr Mgr;	// Must be the first field
+   jmp_buf JmpBuf;		// Where to go back on a libjpeg error
+  };
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static Img_Format_t Img_GetFormat (const char *Path);
+static void Img_ComputeSizeToFit (unsigned Width,unsigned Height,
+                                  unsigned MaxWidth,unsigned MaxHeight,
+                                  unsigned *NewWidth,unsigned *NewHeight);
+
+static Img_Result_t Img_ReadJPEG (const char *Path,
+                                  unsigned MaxWidth,unsigned MaxHeight,
+                                  struct Img_Image *Image);
+static Img_Result_t Img_WriteJPEG (const char *Path,const struct Img_Image *Image,
+                                   unsigned Quality);
+static void Img_JPEGErrorExit (j_common_ptr Cinfo);
+static void Img_JPEGOutputMessage (j_common_ptr Cinfo);
+
+static Img_Result_t Img_ReadPNG (const char *Path,struct Img_Image *Image);
+static Img_Result_t Img_WritePNG (const char *Path,const struct Img_Image *Image);
+
+static Img_Result_t Img_ReadGIF (const char *Path,struct Img_Image *Image);
+static bool Img_ReadGIFExtension (GifFileType *Gif,int *Transparent);
+static Img_Result_t Img_ReadGIFFrame (GifFileType *Gif,int Transparent,
+                                      struct Img_Image *Image);
+static void Img_PutGIFLine (const GifFileType *Gif,const ColorMapObject *ColorMap,
+                            int Transparent,const GifPixelType *Line,int Row,
+                            struct Img_Image *Image);
+static bool Img_SkipGIFSubBlocks (FILE *File);
+
+static void Img_FlattenOnWhite (struct Img_Image *Image);
+static Img_Result_t Img_Shrink (struct Img_Image *Image,
+                                unsigned NewWidth,unsigned NewHeight);
+
+/*****************************************************************************/
+/****** Convert an image to JPEG, shrinking it to fit into a maximum size ****/
+/*****************************************************************************/
+// Same result as convert Src -resize 'MaxWidthxMaxHeight>' -quality Quality JPG
+// JPEG, PNG and GIF (first frame) are decoded in-process.
+// Img_UNSUPPORTED_FORMAT is returned for other formats,
+// so the caller can use an external program.
+
+Img_Result_t Img_ResizeToJPEG (const char *PathSrc,const char *PathJPG,
+                               unsigned MaxWidth,unsigned MaxHeight,
+                               unsigned Quality)
+  {
+   struct Img_Image Image;
+   unsigned NewWidth;
+   unsigned NewHeight;
+   Img_Result_t Result;
+
+   /***** Decode source image depending on its format *****/
+   switch (Img_GetFormat (PathSrc))
+     {
+      case Img_FORMAT_JPEG:
+	 Result = Img_ReadJPEG (PathSrc,MaxWidth,MaxHeight,&Image);
+	 break;
+      case Img_FORMAT_PNG:
+	 Result = Img_ReadPNG (PathSrc,&Image);
+	 break;
+      case Img_FORMAT_GIF:
+	 Result = Img_ReadGIF (PathSrc,&Image);
+	 break;
+      default:
+	 return Img_UNSUPPORTED_FORMAT;
+     }
+   if (Result != Img_OK)
+      return Result;
+
+   /***** Remove transparency *****/
+   Img_FlattenOnWhite (&Image);
+
+   /***** Shrink image if it's bigger than maximum size,
+          keeping aspect ratio *****/
+   Img_ComputeSizeToFit (Image.Width,Image.Height,MaxWidth,MaxHeight,
+                         &NewWidth,&NewHeight);
+   if (NewWidth != Image.Width ||
+       NewHeight != Image.Height)
+      Result = Img_Shrink (&Image,NewWidth,NewHeight);
+
+   /***** Encode image as JPEG *****/
+   if (Result == Img_OK)
+      Result = Img_WriteJPEG (PathJPG,&Image,Quality);
+
+   free (Image.Pixels);
+   return Result;
+  }
+
+/*****************************************************************************/
+/************** Save the first frame of a GIF image as a PNG file ************/
+/*****************************************************************************/
+
+Img_Result_t Img_GetFirstFrameOfGIF (const char *PathGIF,const char *PathPNG)
+  {
+   struct Img_Image Image;
+   Img_Result_t Result;
+
+   if (Img_GetFormat (PathGIF) != Img_FORMAT_GIF)
+      return Img_UNSUPPORTED_FORMAT;
+
+   if ((Result = Img_ReadGIF (PathGIF,&Image)) != Img_OK)
+      return Result;
+   Result = Img_WritePNG (PathPNG,&Image);
+   free (Image.Pixels);
+   return Result;
+  }
+
+/*****************************************************************************/
+/*********************** Get number of frames of a GIF ***********************/
+/*****************************************************************************/
+// Blocks are skipped without decoding images
+// Return -1 on error
+
+int Img_GetNumFramesOfGIF (const char *PathGIF)
+  {
+   FILE *File;
+   unsigned char Header[13];	// Header and logical screen descriptor
+   unsigned char Descriptor[9];	// Image descriptor
+   bool End = false;
+   bool Error = false;
+   int NumFrames = 0;
+
+   /***** Open file *****/
+   if ((File = fopen (PathGIF,"rb")) == NULL)
+      return -1;
+
+   /***** Check header and skip global color table *****/
+   if (fread (Header,1,sizeof (Header),File) != sizeof (Header) ||
+       memcmp (Header,"GIF8",4))
+      Error = true;
+   else if (Header[10] & 0x80)
+      Error = (fseek (File,3L << ((Header[10] & 0x07) + 1),SEEK_CUR) != 0);
+
+   /***** Count image descriptors *****/
+   while (!End && !Error)
+      switch (fgetc (File))
+        {
+	 case 0x21:	// Extension: label and data sub-blocks
+	    Error = (fgetc (File) == EOF ||
+		     !Img_SkipGIFSubBlocks (File));
+	    break;
+	 case 0x2C:	// Image descriptor: one more frame
+	    if (fread (Descriptor,1,sizeof (Descriptor),File) != sizeof (Descriptor))
+	       Error = true;
+	    else
+	      {
+	       /* Skip local color table, LZW minimum code size and data */
+	       if (Descriptor[8] & 0x80)
+		  Error = (fseek (File,3L << ((Descriptor[8] & 0x07) + 1),SEEK_CUR) != 0);
+	       if (!Error)
+		  Error = (fgetc (File) == EOF ||
+			   !Img_SkipGIFSubBlocks (File));
+	       if (!Error)
+		  NumFrames++;
+	      }
+	    break;
+	 case 0x3B:	// Trailer
+	 case EOF:	// Some encoders don't write trailer
+	    End = true;
+	    break;
+	 default:
+	    Error = true;
+	    break;
+        }
+
+   /***** Close file *****/
+   fclose (File);
+
+   return Error ? -1 :
+	          NumFrames;
+  }
+
+/*****************************************************************************/
+/******************* Get format of an image from its content *****************/
+/*****************************************************************************/
+
+static Img_Format_t Img_GetFormat (const char *Path)
+  {
+   FILE *File;
+   unsigned char Magic[4];
+   size_t NumBytes;
+
+   if ((File = fopen (Path,"rb")) == NULL)
+      return Img_FORMAT_UNKNOWN;
+   NumBytes = fread (Magic,1,sizeof (Magic),File);
+   fclose (File);
+   if (NumBytes != sizeof (Magic))
+      return Img_FORMAT_UNKNOWN;
+
+   if (Magic[0] == 0xFF && Magic[1] == 0xD8 && Magic[2] == 0xFF)
+      return Img_FORMAT_JPEG;
+   if (!memcmp (Magic,"\x89PNG",4))
+      return Img_FORMAT_PNG;
+   if (!memcmp (Magic,"GIF8",4))
+      return Img_FORMAT_GIF;
+   return Img_FORMAT_UNKNOWN;
+  }
+
+/*****************************************************************************/
+/********** Compute size of an image to fit into a maximum size **************/
+/*****************************************************************************/
+// Images are never enlarged
+
+static void Img_ComputeSizeToFit (unsigned Width,unsigned Height,
+                                  unsigned MaxWidth,unsigned MaxHeight,
+                                  unsigned *NewWidth,unsigned *NewHeight)
+  {
+   double Scale;
+
+   *NewWidth  = Width;
+   *NewHeight = Height;
+   if (Width <= MaxWidth && Height <= MaxHeight)
+      return;
+
+   Scale = (double) MaxWidth / (double) Width;
+   if ((double) MaxHeight / (double) Height < Scale)
+      Scale = (double) MaxHeight / (double) Height;
+
+   if ((*NewWidth  = (unsigned) (Width  * Scale + 0.5)) == 0)
+      *NewWidth  = 1;
+   if ((*NewHeight = (unsigned) (Height * Scale + 0.5)) == 0)
+      *NewHeight = 1;
+  }
+
+/*****************************************************************************/
+/******************************** Read a JPEG ********************************/
+/*****************************************************************************/
+// libjpeg scales down by 1/2, 1/4 or 1/8 while decoding
+// when the image is much bigger than the maximum size
+
+static Img_Result_t Img_ReadJPEG (const char *Path,
+                                  unsigned MaxWidth,unsigned MaxHeight,
+                                  struct Img_Image *Image)
+  {
+   struct jpeg_decompress_struct Cinfo;
+   struct Img_JPEGError Err;
+   FILE *File;
+   JSAMPROW Row;
+   unsigned NewWidth;
+   unsigned NewHeight;
+   unsigned Denom;
+
+   Image->Pixels = NULL;
+
+   /***** Open file *****/
+   if ((File = fopen (Path,"rb")) == NULL)
+      return Img_ERROR;
+
+   /***** libjpeg jumps here on error *****/
+   Cinfo.err = jpeg_std_error (&Err.Mgr);
+   Err.Mgr.error_exit     = Img_JPEGErrorExit;
+   Err.Mgr.output_message = Img_JPEGOutputMessage;
+   if (setjmp (Err.JmpBuf))
+     {
+      jpeg_destroy_decompress (&Cinfo);
+      fclose (File);
+      free (Image->Pixels);
+      Image->Pixels = NULL;
+      return Img_ERROR;
+     }
+
+   /***** Read header *****/
+   jpeg_create_decompress (&Cinfo);
+   jpeg_stdio_src (&Cinfo,File);
+   jpeg_read_header (&Cinfo,TRUE);
+
+   /* libjpeg can not convert CMYK to RGB */
+   if (Cinfo.jpeg_color_space == JCS_CMYK ||
+       Cinfo.jpeg_color_space == JCS_YCCK)
+     {
+      jpeg_destroy_decompress (&Cinfo);
+      fclose (File);
+      return Img_UNSUPPORTED_FORMAT;
+     }
+   if ((unsigned long) Cinfo.image_width *
+       (unsigned long) Cinfo.image_height > Img_MAX_PIXELS_JPEG)
+     {
+      jpeg_destroy_decompress (&Cinfo);
+      fclose (File);
+      return Img_TOO_BIG;
+     }
+
+   /***** Scale down while decoding,
+          but never below the size to fit *****/
+   Img_ComputeSizeToFit (Cinfo.image_width,Cinfo.image_height,
+                         MaxWidth,MaxHeight,
+                         &NewWidth,&NewHeight);
+   for (Denom = 8;
+	Denom > 1;
+	Denom /= 2)
+      if ((Cinfo.image_width  + Denom - 1) / Denom >= NewWidth &&
+	  (Cinfo.image_height + Denom - 1) / Denom >= NewHeight)
+	 break;
+   Cinfo.scale_num   = 1;
+   Cinfo.scale_denom = Denom;
+   Cinfo.out_color_space = JCS_RGB;
+   jpeg_calc_output_dimensions (&Cinfo);
+   if ((unsigned long) Cinfo.output_width *
+       (unsigned long) Cinfo.output_height > Img_MAX_PIXELS)
+     {
+      jpeg_destroy_decompress (&Cinfo);
+      fclose (File);
+      return Img_TOO_BIG;
+     }
+
+   /***** Decode *****/
+   jpeg_start_decompress (&Cinfo);
+   Image->Width         = Cinfo.output_width;
+   Image->Height        = Cinfo.output_height;
+   Image->NumComponents = 3;
+   if ((Image->Pixels = malloc ((size_t) Image->Width *
+	                        (size_t) Image->Height * 3)) == NULL)
+      Img_JPEGErrorExit ((j_common_ptr) &Cinfo);
+   while (Cinfo.output_scanline < Cinfo.output_height)
+     {
+      Row = Image->Pixels + (size_t) Cinfo.output_scanline * Image->Width * 3;
+      jpeg_read_scanlines (&Cinfo,&Row,1);
+     }
+   jpeg_finish_decompress (&Cinfo);
+
+   /***** Free resources *****/
+   jpeg_destroy_decompress (&Cinfo);
+   fclose (File);
+
+   return Img_OK;
+  }
+
+/*****************************************************************************/
+/******************************* Write a JPEG ********************************/
+/*****************************************************************************/
+
+static Img_Result_t Img_WriteJPEG (const char *Path,const struct Img_Image *Image,
+                                   unsigned Quality)
+  {
+   struct jpeg_compress_struct Cinfo;
+   struct Img_JPEGError Err;
+   FILE *File;
+   JSAMPROW Row;
+
+   /***** Create file *****/
+   if ((File = fopen (Path,"wb")) == NULL)
+      return Img_ERROR;
+
+   /***** libjpeg jumps here on error *****/
+   Cinfo.err = jpeg_std_error (&Err.Mgr);
+   Err.Mgr.error_exit     = Img_JPEGErrorExit;
+   Err.Mgr.output_message = Img_JPEGOutputMessage;
+   if (setjmp (Err.JmpBuf))
+     {
+      jpeg_destroy_compress (&Cinfo);
+      fclose (File);
+      return Img_ERROR;
+     }
+
+   /***** Encode *****/
+   jpeg_create_compress (&Cinfo);
+   jpeg_stdio_dest (&Cinfo,File);
+   Cinfo.image_width      = Image->Width;
+   Cinfo.image_height     = Image->Height;
+   Cinfo.input_components = 3;
+   Cinfo.in_color_space   = JCS_RGB;
+   jpeg_set_defaults (&Cinfo);
+   jpeg_set_quality (&Cinfo,(int) Quality,TRUE);
+   jpeg_start_compress (&Cinfo,TRUE);
+   while (Cinfo.next_scanline < Cinfo.image_height)
+     {
+      Row = Image->Pixels + (size_t) Cinfo.next_scanline * Image->Width * 3;
+      jpeg_write_scanlines (&Cinfo,&Row,1);
+     }
+   jpeg_finish_compress (&Cinfo);
+
+   /***** Free resources *****/
+   jpeg_destroy_compress (&Cinfo);
+   if (fclose (File))
+      return Img_ERROR;
+
+   return Img_OK;
+  }
+
+/*****************************************************************************/
+/************** Handle libjpeg errors without exiting program ****************/
+/*****************************************************************************/
+
+static void Img_JPEGErrorExit (j_common_ptr Cinfo)
+  {
+   longjmp (((struct Img_JPEGError *) Cinfo->err)->JmpBuf,1);
+  }
+
+static void Img_JPEGOutputMessage (j_common_ptr Cinfo)
+  {
+   /* Don't write warnings about corrupt data to stderr */
+   (void) Cinfo;
+  }
+
+/*****************************************************************************/
+/******************************** Read a PNG *********************************/
+/*****************************************************************************/
+
+static Img_Result_t Img_ReadPNG (const char *Path,struct Img_Image *Image)
+  {
+   png_image Png;
+
+   Image->Pixels = NULL;
+
+   /***** Read header *****/
+   memset (&Png,0,sizeof (Png));
+   Png.version = PNG_IMAGE_VERSION;
+   if (!png_image_begin_read_from_file (&Png,Path))
+      return Img_ERROR;
+   if ((unsigned long) Png.width *
+       (unsigned long) Png.height > Img_MAX_PIXELS)
+     {
+      png_image_free (&Png);
+      return Img_TOO_BIG;
+     }
+
+   /***** Decode as 8-bit RGBA *****/
+   Png.format = PNG_FORMAT_RGBA;
+   Image->Width         = Png.width;
+   Image->Height        = Png.height;
+   Image->NumComponents = 4;
+   if ((Image->Pixels = malloc (PNG_IMAGE_SIZE (Png))) == NULL)
+     {
+      png_image_free (&Png);
+      return Img_ERROR;
+     }
+   if (!png_image_finish_read (&Png,NULL,Image->Pixels,0,NULL))
+     {
+      free (Image->Pixels);
+      Image->Pixels = NULL;
+      return Img_ERROR;
+     }
+
+   return Img_OK;
+  }
+
+/*****************************************************************************/
+/******************************** Write a PNG ********************************/
+/*****************************************************************************/
+
+static Img_Result_t Img_WritePNG (const char *Path,const struct Img_Image *Image)
+  {
+   png_image Png;
+
+   memset (&Png,0,sizeof (Png));
+   Png.version = PNG_IMAGE_VERSION;
+   Png.width   = Image->Width;
+   Png.height  = Image->Height;
+   Png.format  = Image->NumComponents == 4 ? PNG_FORMAT_RGBA :
+	                                     PNG_FORMAT_RGB;
+   if (!png_image_write_to_file (&Png,Path,0,Image->Pixels,0,NULL))
+      return Img_ERROR;
+
+   return Img_OK;
+  }
+
+/*****************************************************************************/
+/****************** Read the first frame of a GIF as RGBA ********************/
+/*****************************************************************************/
+// The frame is placed on a transparent canvas of the size of the GIF
+
+static Img_Result_t Img_ReadGIF (const char *Path,struct Img_Image *Image)
+  {
+   GifFileType *Gif;
+   GifRecordType RecordType;
+   int Transparent = NO_TRANSPARENT_COLOR;
+   int Error;
+   Img_Result_t Result = Img_ERROR;
+
+   Image->Pixels = NULL;
+
+   /***** Open file *****/
+   if ((Gif = DGifOpenFileName (Path,&Error)) == NULL)
+      return Img_ERROR;
+
+   /***** Read records until first image *****/
+   do
+     {
+      if (DGifGetRecordType (Gif,&RecordType) == GIF_ERROR)
+	 break;
+      switch (RecordType)
+        {
+	 case EXTENSION_RECORD_TYPE:
+	    if (!Img_ReadGIFExtension (Gif,&Transparent))
+	       RecordType = TERMINATE_RECORD_TYPE;
+	    break;
+	 case IMAGE_DESC_RECORD_TYPE:
+	    Result = Img_ReadGIFFrame (Gif,Transparent,Image);
+	    RecordType = TERMINATE_RECORD_TYPE;	// Only first frame
+	    break;
+	 default:
+	    break;
+        }
+     }
+   while (RecordType != TERMINATE_RECORD_TYPE);
+
+   /***** Close file *****/
+   DGifCloseFile (Gif,&Error);
+
+   return Result;
+  }
+
+/*****************************************************************************/
+/*********** Read a GIF extension, getting the transparent color *************/
+/*****************************************************************************/
+
+static bool Img_ReadGIFExtension (GifFileType *Gif,int *Transparent)
+  {
+   GifByteType *Extension;
+   GraphicsControlBlock GCB;
+   int ExtCode;
+
+   if (DGifGetExtension (Gif,&ExtCode,&Extension) == GIF_ERROR)
+      return false;
+
+   if (ExtCode == GRAPHICS_EXT_FUNC_CODE && Extension != NULL)
+      if (DGifExtensionToGCB (Extension[0],Extension + 1,&GCB) == GIF_OK)
+	 *Transparent = GCB.TransparentColor;
+
+   while (Extension != NULL)
+      if (DGifGetExtensionNext (Gif,&Extension) == GIF_ERROR)
+	 return false;
+
+   return true;
+  }
+
+/*****************************************************************************/
+/************************** Read a GIF image record **************************/
+/*****************************************************************************/
+
+static Img_Result_t Img_ReadGIFFrame (GifFileType *Gif,int Transparent,
+                                      struct Img_Image *Image)
+  {
+   static const int InterlacedOffset[4] = {0,4,2,1};
+   static const int InterlacedJump  [4] = {8,8,4,2};
+   const GifImageDesc *Desc;
+   const ColorMapObject *ColorMap;
+   GifPixelType *Line;
+   int Pass;
+   int Row;
+
+   /***** Get image descriptor *****/
+   if (DGifGetImageDesc (Gif) == GIF_ERROR)
+      return Img_ERROR;
+   Desc = &Gif->Image;
+   if ((ColorMap = Desc->ColorMap ? Desc->ColorMap :
+	                            Gif->SColorMap) == NULL)
+      return Img_ERROR;
+   if (Desc->Left < 0 || Desc->Top < 0 ||
+       Desc->Width <= 0 || Desc->Height <= 0)
+      return Img_ERROR;
+
+   /***** Create transparent canvas big enough for the frame *****/
+   Image->Width  = (unsigned) Gif->SWidth;
+   if (Image->Width < (unsigned) (Desc->Left + Desc->Width))
+      Image->Width = (unsigned) (Desc->Left + Desc->Width);
+   Image->Height = (unsigned) Gif->SHeight;
+   if (Image->Height < (unsigned) (Desc->Top + Desc->Height))
+      Image->Height = (unsigned) (Desc->Top + Desc->Height);
+   Image->NumComponents = 4;
+   if ((unsigned long) Image->Width *
+       (unsigned long) Image->Height > Img_MAX_PIXELS)
+      return Img_TOO_BIG;
+   if ((Image->Pixels = calloc ((size_t) Image->Width * (size_t) Image->Height,4)) == NULL)
+      return Img_ERROR;
+   if ((Line = malloc ((size_t) Desc->Width)) == NULL)
+     {
+      free (Image->Pixels);
+      Image->Pixels = NULL;
+      return Img_ERROR;
+     }
+
+   /***** Decode rows, in 4 passes if interlaced *****/
+   for (Pass = Desc->Interlace ? 0 : 3;
+	Pass < 4;
+	Pass++)
+      for (Row = Desc->Interlace ? InterlacedOffset[Pass] : 0;
+	   Row < Desc->Height;
+	   Row += Desc->Interlace ? InterlacedJump[Pass] : 1)
+	{
+	 if (DGifGetLine (Gif,Line,Desc->Width) == GIF_ERROR)
+	   {
+	    free (Line);
+	    free (Image->Pixels);
+	    Image->Pixels = NULL;
+	    return Img_ERROR;
+	   }
+	 Img_PutGIFLine (Gif,ColorMap,Transparent,Line,Row,Image);
+	}
+
+   free (Line);
+   return Img_OK;
+  }
+
+/*****************************************************************************/
+/******************* Put a row of a GIF frame in the canvas ******************/
+/*****************************************************************************/
+
+static void Img_PutGIFLine (const GifFileType *Gif,const ColorMapObject *ColorMap,
+                            int Transparent,const GifPixelType *Line,int Row,
+                            struct Img_Image *Image)
+  {
+   const GifImageDesc *Desc = &Gif->Image;
+   unsigned char *Pixel;
+   const GifColorType *Color;
+   int Col;
+
+   Pixel = Image->Pixels + ((size_t) (Desc->Top + Row) * Image->Width +
+	                    (size_t)  Desc->Left) * 4;
+   for (Col = 0;
+	Col < Desc->Width;
+	Col++, Pixel += 4)
+      if ((int) Line[Col] != Transparent &&
+	  (int) Line[Col] < ColorMap->ColorCount)
+	{
+	 Color = &ColorMap->Colors[Line[Col]];
+	 Pixel[0] = Color->Red;
+	 Pixel[1] = Color->Green;
+	 Pixel[2] = Color->Blue;
+	 Pixel[3] = 255;
+	}
+  }
+
+/*****************************************************************************/
+/************************** Skip GIF data sub-blocks *************************/
+/*****************************************************************************/
+
+static bool Img_SkipGIFSubBlocks (FILE *File)
+  {
+   int Size;
+
+   while ((Size = fgetc (File)) != 0)
+      if (Size == EOF ||
+	  fseek (File,(long) Size,SEEK_CUR))
+	 return false;
+
+   return true;
+  }
+
+/*****************************************************************************/
+/******************* Remove transparency on white background *****************/
+/*****************************************************************************/
+
+static void Img_FlattenOnWhite (struct Img_Image *Image)
+  {
+   const unsigned char *Src;
+   unsigned char *Dst;
+   size_t NumPixels;
+   size_t NumPixel;
+   unsigned Alpha;
+   unsigned Comp;
+
+   if (Image->NumComponents != 4)
+      return;
+
+   /***** RGBA to RGB in the same buffer *****/
+   NumPixels = (size_t) Image->Width * (size_t) Image->Height;
+   for (NumPixel = 0, Src = Dst = Image->Pixels;
+	NumPixel < NumPixels;
+	NumPixel++, Src += 4, Dst += 3)
+     {
+      Alpha = Src[3];
+      for (Comp = 0;
+	   Comp < 3;
+	   Comp++)
+	 Dst[Comp] = (unsigned char) ((Src[Comp] * Alpha + 255 * (255 - Alpha) + 127) / 255);
+     }
+   Image->NumComponents = 3;
+  }
+
+/*****************************************************************************/
+/************************* Shrink an image to a new size *********************/
+/*****************************************************************************/
+// Each new pixel is the average of the source area it covers (box filter),
+// computed first by rows and then by columns
+
+static Img_Result_t Img_Shrink (struct Img_Image *Image,
+                                unsigned NewWidth,unsigned NewHeight)
+  {
+   unsigned NumComps = Image->NumComponents;
+   size_t NewRowSize = (size_t) NewWidth * NumComps;
+   float *Tmp;		// NewWidth x Height, after shrinking rows
+   float *Acc;		// One row of new image, while adding source rows
+   unsigned char *NewPixels;
+   const unsigned char *Src;
+   const float *TmpRow;
+   float Scale;
+   float Start;
+   float End;
+   float Weight;
+   unsigned X;
+   unsigned Y;
+   unsigned SrcX;
+   unsigned SrcY;
+   unsigned Comp;
+   size_t i;
+
+   /***** Allocate memory *****/
+   Tmp = malloc ((size_t) Image->Height * NewRowSize * sizeof (float));
+   Acc = malloc (NewRowSize * sizeof (float));
+   NewPixels = malloc ((size_t) NewHeight * NewRowSize);
+   if (Tmp == NULL || Acc == NULL || NewPixels == NULL)
+     {
+      free (Tmp);
+      free (Acc);
+      free (NewPixels);
+      return Img_ERROR;
+     }
+
+   /***** Shrink rows *****/
+   Scale = (float) Image->Width / (float) NewWidth;
+   for (Y = 0;
+	Y < Image->Height;
+	Y++)
+     {
+      Src = Image->Pixels + (size_t) Y * Image->Width * NumComps;
+      for (X = 0;
+	   X < NewWidth;
+	   X++)
+	{
+	 Start = X * Scale;
+	 End   = Start + Scale;
+	 for (Comp = 0;
+	      Comp < NumComps;
+	      Comp++)
+	    Acc[Comp] = 0.0f;
+	 for (SrcX = (unsigned) Start;
+	      SrcX < Image->Width && (float) SrcX < End;
+	      SrcX++)
+	   {
+	    Weight = ((float) (SrcX + 1) < End ? (float) (SrcX + 1) : End) -
+		     ((float)  SrcX      > Start ? (float)  SrcX      : Start);
+	    for (Comp = 0;
+		 Comp < NumComps;
+		 Comp++)
+	       Acc[Comp] += Weight * Src[SrcX * NumComps + Comp];
+	   }
+	 for (Comp = 0;
+	      Comp < NumComps;
+	      Comp++)
+	    Tmp[(size_t) Y * NewRowSize + X * NumComps + Comp] = Acc[Comp] / Scale;
+	}
+     }
+
+   /***** Shrink columns *****/
+   Scale = (float) Image->Height / (float) NewHeight;
+   for (Y = 0;
+	Y < NewHeight;
+	Y++)
+     {
+      Start = Y * Scale;
+      End   = Start + Scale;
+      for (i = 0;
+	   i < NewRowSize;
+	   i++)
+	 Acc[i] = 0.0f;
+      for (SrcY = (unsigned) Start;
+	   SrcY < Image->Height && (float) SrcY < End;
+	   SrcY++)
+	{
+	 Weight = ((float) (SrcY + 1) < End ? (float) (SrcY + 1) : End) -
+		  ((float)  SrcY      > Start ? (float)  SrcY      : Start);
+	 TmpRow = Tmp + (size_t) SrcY * NewRowSize;
+	 for (i = 0;
+	      i < NewRowSize;
+	      i++)
+	    Acc[i] += Weight * TmpRow[i];
+	}
+      for (i = 0;
+	   i < NewRowSize;
+	   i++)
+	 NewPixels[(size_t) Y * NewRowSize + i] =
+	    (unsigned char) (Acc[i] / Scale > 254.5f ? 255 :
+		                                   Acc[i] / Scale + 0.5f);
+     }
+
+   /***** Replace pixels *****/
+   free (Tmp);
+   free (Acc);
+   free (Image->Pixels);
+   Image->Pixels = NewPixels;
+   Image->Width  = NewWidth;
+   Image->Height = NewHeight;
+
+   return Img_OK;
+  }
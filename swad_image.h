@@ -0,0 +1,56 @@
+// swad_image.h: decode, resize and encode images in-process
+
+#ifndef _SWAD_IMA
+#define _SWAD_IMA
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************** Headers **********************************/
+/*****************************************************************************/
+
+/*****************************************************************************/
+/****************************** Public constants *****************************/
+/*****************************************************************************/
+
+/*****************************************************************************/
+/******************************** Public types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   Img_OK,			// Success
+   Img_UNSUPPORTED_FORMAT,	// Format not decoded in-process (TIFF, BMP, CMYK JPEG...)
+   Img_TOO_BIG,			// Image with too many pixels, rejected
+   Img_ERROR,			// Corrupt image, not supported by library, I/O error...
+  } Img_Result_t;
+
+/*****************************************************************************/
+/****************************** Public prototypes ****************************/
+/*****************************************************************************/
+
+Img_Result_t Img_ResizeToJPEG (const char *PathSrc,const char *PathJPG,
+                               unsigned MaxWidth,unsigned MaxHeight,
+                               unsigned Quality);
+Img_Result_t Img_GetFirstFrameOfGIF (const char *PathGIF,const char *PathPNG);
+int Img_GetNumFramesOfGIF (const char *PathGIF);
+
+#endif
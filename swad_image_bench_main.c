@@ -0,0 +1,150 @@
+// swad_image_bench_main.c: main of swad_image_bench, throughput of image processing
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <linux/limits.h>	// For PATH_MAX
+#include <stdio.h>		// For printf, snprintf
+#include <stdlib.h>		// For atoi, system
+#include <sys/time.h>		// For gettimeofday
+#include <sys/wait.h>		// For the macro WEXITSTATUS
+#include <unistd.h>		// For unlink
+
+#include "swad_image.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+// Same size and quality as images in timeline and forums
+#define ImB_MAX_WIDTH	768
+#define ImB_MAX_HEIGHT	768
+#define ImB_QUALITY	 90
+
+#define ImB_PATH_OUTPUT "/tmp/swad_image_bench.jpg"
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static double ImB_GetSeconds (void);
+static void ImB_WriteThroughput (const char *Path,const char *How,
+                                 unsigned NumImages,double Seconds);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_image_bench <number of repetitions> <image>...
+   Each image is resized and encoded as JPEG the given number of times,
+   first in-process and then calling convert (ImageMagick),
+   as done for media uploaded to timeline, forums and messages.
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumArg;
+   int NumRepetitions;
+   int i;
+   double Start;
+   char Command[256 + PATH_MAX * 2];
+   int ReturnCode;
+
+   if (argc < 3 || (NumRepetitions = atoi (argv[1])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s <number of repetitions> <image>...\n",argv[0]);
+      return 1;
+     }
+
+   for (NumArg = 2;
+	NumArg < argc;
+	NumArg++)
+     {
+      /***** In-process *****/
+      Start = ImB_GetSeconds ();
+      for (i = 0;
+	   i < NumRepetitions;
+	   i++)
+	 if (Img_ResizeToJPEG (argv[NumArg],ImB_PATH_OUTPUT,
+			       ImB_MAX_WIDTH,ImB_MAX_HEIGHT,ImB_QUALITY) != Img_OK)
+	   {
+	    fprintf (stderr,"%s can not be processed in-process.\n",argv[NumArg]);
+	    break;
+	   }
+      if (i == NumRepetitions)
+	 ImB_WriteThroughput (argv[NumArg],"in-process",
+			      (unsigned) NumRepetitions,ImB_GetSeconds () - Start);
+
+      /***** Calling external program *****/
+      snprintf (Command,sizeof (Command),
+		"convert %s -resize '%ux%u>' -quality %u %s",
+		argv[NumArg],
+		ImB_MAX_WIDTH,ImB_MAX_HEIGHT,ImB_QUALITY,
+		ImB_PATH_OUTPUT);
+      Start = ImB_GetSeconds ();
+      for (i = 0;
+	   i < NumRepetitions;
+	   i++)
+	{
+	 ReturnCode = system (Command);
+	 if (ReturnCode == -1 || WEXITSTATUS (ReturnCode) != 0)
+	   {
+	    fprintf (stderr,"%s can not be processed by convert.\n",argv[NumArg]);
+	    break;
+	   }
+	}
+      if (i == NumRepetitions)
+	 ImB_WriteThroughput (argv[NumArg],"convert",
+			      (unsigned) NumRepetitions,ImB_GetSeconds () - Start);
+     }
+
+   unlink (ImB_PATH_OUTPUT);
+   return 0;
+  }
+
+/*****************************************************************************/
+/************************ Get current time in seconds ************************/
+/*****************************************************************************/
+
+static double ImB_GetSeconds (void)
+  {
+   struct timeval Now;
+
+   gettimeofday (&Now,NULL);
+   return (double) Now.tv_sec + (double) Now.tv_usec / 1E6;
+  }
+
+/*****************************************************************************/
+/**************************** Write images per second ************************/
+/*****************************************************************************/
+
+static void ImB_WriteThroughput (const char *Path,const char *How,
+                                 unsigned NumImages,double Seconds)
+  {
+   printf ("%s\t%-10s\t%u images in %.3f s\t%.1f images/s\n",
+	   Path,How,NumImages,Seconds,
+	   Seconds > 0.0 ? (double) NumImages / Seconds :
+			   0.0);
+  }
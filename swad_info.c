@@ -2095,7 +2095,7 @@ void Inf_ReceivePagInfo (void)
    /***** Set info type *****/
    Gbl.Crs.Info.Type  = Inf_AsignInfoType ();
 
-   /***** First of all, store in disk the file from stdin (really from Gbl.F.Tmp) *****/
+   /***** First of all, store in disk the file from stdin (really from a temporary file) *****/
    Param = Fil_StartReceptionOfFile (Fil_NAME_OF_PARAM_FILENAME_ORG,
                                      SourceFileName,MIMEType);
 
@@ -26,6 +26,7 @@
 /*****************************************************************************/
 
 #include <stddef.h>		// For NULL
+#include <stdio.h>		// For fprintf
 #include <stdlib.h>		// For exit
 #include <string.h>		// For string functions
 
@@ -38,6 +39,7 @@
 #include "swad_connected.h"
 #include "swad_database.h"
 #include "swad_exam.h"
+#include "swad_file.h"
 #include "swad_firewall.h"
 #include "swad_follow.h"
 #include "swad_form.h"
@@ -53,9 +55,11 @@
 #include "swad_notification.h"
 #include "swad_parameter.h"
 #include "swad_setting.h"
+#include "swad_statistic.h"
 #include "swad_tab.h"
 #include "swad_theme.h"
 #include "swad_timeline.h"
+#include "swad_worker.h"
 
 /*****************************************************************************/
 /************** External global variables from others modules ****************/
@@ -79,6 +83,7 @@ extern struct Globals Gbl;
 /***************************** Private prototypes ****************************/
 /*****************************************************************************/
 
+static void Lay_WriteHTTPHeaderForHTML (void);
 static void Lay_WriteEndOfPage (void);
 
 static void Lay_WritePageTitle (void);
@@ -134,7 +139,7 @@ void Lay_WriteStartOfPage (void)
    if (Gbl.Action.UsesAJAX)
      // Don't generate a full HTML page, only the content of a DIV or similar
      {
-      HTM_Txt ("Content-Type: text/html; charset=windows-1252\r\n\r\n");
+      Lay_WriteHTTPHeaderForHTML ();
       Gbl.Layout.WritingHTMLStart = false;
       Gbl.Layout.HTMLStartWritten = Gbl.Layout.DivsEndWritten = true;
       return;
@@ -151,9 +156,11 @@ void Lay_WriteStartOfPage (void)
    Gbl.Layout.WritingHTMLStart = true;
 
    /***** Write header to standard output to avoid timeout *****/
-   // Two \r\n are necessary
-   fprintf (stdout,"Content-type: text/html; charset=windows-1252\r\n\r\n"
-                   "<!DOCTYPE html>\n");
+   Lay_WriteHTTPHeaderForHTML ();
+   HTM_Txt ("<!DOCTYPE html>\n");
+
+   /***** From now on, a large page can be sent in pieces *****/
+   Fil_EnableEarlyFlushOfHTMLOutput ();
 
    /***** Write start of HTML code *****/
    // WARNING: It is necessary to comment the line 'AddDefaultCharset UTF8'
@@ -375,10 +382,28 @@ void Lay_WriteStartOfPage (void)
    Gbl.Layout.WritingHTMLStart = false;
    Gbl.Layout.HTMLStartWritten = true;
 
+   /***** Send the start of the page, so the browser can load
+          style sheets, scripts and icons while the rest is generated *****/
+   Fil_FlushHTMLOutput ();
+
    /* Write message indicating number of clicks allowed before sending my photo */
    Usr_InformAboutNumClicksBeforePhoto ();
   }
 
+/*****************************************************************************/
+/****************** Write HTTP header for HTML content ***********************/
+/*****************************************************************************/
+// If browser accepts it, content is sent compressed
+
+static void Lay_WriteHTTPHeaderForHTML (void)
+  {
+   fprintf (stdout,"Content-Type: text/html; charset=windows-1252\r\n");
+   if (Fil_StartCompressionOfHTMLOutput ())
+      fprintf (stdout,"Content-Encoding: gzip\r\n");
+   fprintf (stdout,"Vary: Accept-Encoding\r\n"
+		   "\r\n");	// Two \r\n are necessary
+  }
+
 /*****************************************************************************/
 /*********************** Write status 204 No Content *************************/
 /*****************************************************************************/
@@ -724,7 +749,13 @@ static void Lay_WriteScriptInit (void)
    if (RefreshNewTimeline)	// Refresh new timeline via AJAX
       HTM_TxtF ("\tvar delayNewTL = %lu;\n",Cfg_TIME_TO_REFRESH_TIMELINE);
    else if (RefreshMatchStd)	// Refresh match via AJAX
+     {
       HTM_TxtF ("\tvar delayMatch = %lu;\n",Cfg_TIME_TO_REFRESH_MATCH_STD);
+#ifdef Cfg_MATCH_PUSH
+      HTM_TxtF ("\tvar delayMatchPoll = %lu;\n",Cfg_TIME_TO_POLL_MATCH_STD);
+      HTM_TxtF ("\tvar PushURLMatch = \"%s\";\n",Cfg_URL_MATCH_PUSH);
+#endif
+     }
    else if (RefreshMatchTch)	// Refresh match via AJAX
       HTM_TxtF ("\tvar delayMatch = %lu;\n",Cfg_TIME_TO_REFRESH_MATCH_TCH);
 
@@ -744,7 +775,11 @@ static void Lay_WriteScriptInit (void)
       HTM_TxtF ("\tsetTimeout(\"refreshLastClicks()\",%lu);\n",
                 Cfg_TIME_TO_REFRESH_LAST_CLICKS);
    else if (RefreshMatchStd)	// Refresh match for a student via AJAX
+#ifdef Cfg_MATCH_PUSH
+      HTM_Txt ("\tsubscribeMatchStd();\n");	// Refresh when status is pushed
+#else
       HTM_Txt ("\tsetTimeout(\"refreshMatchStd()\",delayMatch);\n");
+#endif
    else if (RefreshMatchTch)	// Refresh match for a teacher via AJAX
       HTM_Txt ("\tsetTimeout(\"refreshMatchTch()\",delayMatch);\n");
    else if (RefreshNewTimeline)	// Refresh timeline via AJAX
@@ -1332,6 +1367,10 @@ void Lay_WrongOrderExit (void)
 
 void Lay_ShowErrorAndExit (const char *Txt)
   {
+   /***** If the error happened while loading log spool,
+          undo the current batch and release the loader *****/
+   Log_AbortLoadingSpool ();
+
    /***** Unlock tables if locked *****/
    if (Gbl.DB.LockedTables)
      {
@@ -1339,6 +1378,22 @@ void Lay_ShowErrorAndExit (const char *Txt)
       mysql_query (&Gbl.mysql,"UNLOCK TABLES");
      }
 
+   /***** Undo transaction if begun *****/
+   DB_RollbackTransaction ();
+
+   /***** Release named locks if got *****/
+   DB_ReleaseAllLocks ();
+
+   /***** In a resident program without HTML output,
+          write error, free memory and go on with the next job *****/
+   if (Wrk_IsDaemon ())
+     {
+      if (Txt)
+	 fprintf (stderr,"%s\n",Txt);
+      Gbl_Cleanup ();
+      Wrk_EndRequest ();
+     }
+
    if (!Gbl.WebService.IsWebService)
      {
       /****** If start of page is not written yet, do it now ******/
@@ -1370,11 +1425,11 @@ void Lay_ShowErrorAndExit (const char *Txt)
    else
      {
       /***** Send page.
-             The HTML output is now in Gbl.F.Out file ==>
-             ==> copy it to standard output *****/
-      rewind (Gbl.F.Out);
-      Fil_FastCopyOfOpenFiles (Gbl.F.Out,stdout);
-      Fil_CloseAndRemoveFileForHTMLOutput ();
+             The HTML output not yet sent is now in Gbl.F.Out buffer ==>
+             ==> send it to standard output.
+             Output is not closed, because the end of page
+             must go in the same (maybe compressed) stream *****/
+      Fil_SendHTMLOutput ();
 
       if (!Gbl.Action.IsAJAXAutoRefresh)
 	{
@@ -1394,7 +1449,6 @@ void Lay_ShowErrorAndExit (const char *Txt)
 	 /***** End the output *****/
 	 if (!Gbl.Layout.HTMLEndWritten)
 	   {
-	    // Here Gbl.F.Out is stdout
 	    if (Act_GetBrowserTab (Gbl.Action.Act) == Act_BRW_1ST_TAB)
 	       Lay_WriteAboutZone ();
 
@@ -1403,15 +1457,19 @@ void Lay_ShowErrorAndExit (const char *Txt)
 	    Gbl.Layout.HTMLEndWritten = true;
 	   }
 	}
-     }
 
-   /***** Close database connection *****/
-   DB_CloseDBConnection ();
+      /***** Send end of page and close output *****/
+      Fil_SendAndCloseHTMLOutput ();
+     }
 
    /***** Exit *****/
    if (Gbl.WebService.IsWebService)
+     {
+      DB_CloseDBConnection ();
       API_Exit (Txt);
-   exit (0);
+     }
+   Wrk_EndRequest ();	// Close database connection and exit,
+			// or go on with next request in a persistent worker
   }
 
 /*****************************************************************************/
@@ -1477,36 +1535,6 @@ void Lay_RefreshNotifsAndConnected (void)
    bool ShowConnected = (Gbl.Prefs.SideCols & Lay_SHOW_RIGHT_COLUMN) &&
                         Gbl.Hierarchy.Level == Hie_CRS;	// Right column visible && There is a course selected
 
-   /***** Sometimes, someone must do this work,
-          so who best than processes that refresh via AJAX? *****/
-   // We use (PID % prime-number) to do only one action as much
-   if      (!(Gbl.PID %  11))
-      Ntf_SendPendingNotifByEMailToAllUsrs ();	// Send pending notifications by email
-   else if (!(Gbl.PID %  19))
-      FW_PurgeFirewall ();			// Remove old clicks from firewall
-   else if (!(Gbl.PID %  23))
-      Fil_RemoveOldTmpFiles (Cfg_PATH_FILE_BROWSER_TMP_PUBLIC	,Cfg_TIME_TO_DELETE_BROWSER_TMP_FILES	,false);	// Remove the oldest temporary public directories used for downloading
-   else if (!(Gbl.PID % 101))
-      Brw_RemoveExpiredExpandedFolders ();	// Remove old expanded folders (from all users)
-   else if (!(Gbl.PID % 103))
-      Set_RemoveOldSettingsFromIP ();		// Remove old settings from IP
-   else if (!(Gbl.PID % 107))
-      Log_RemoveOldEntriesRecentLog ();		// Remove old entries in recent log table, it's a slow query
-   else if (!(Gbl.PID % 109))
-      Fil_RemoveOldTmpFiles (Cfg_PATH_OUT_PRIVATE		,Cfg_TIME_TO_DELETE_HTML_OUTPUT		,false);
-   else if (!(Gbl.PID % 113))
-      Fil_RemoveOldTmpFiles (Cfg_PATH_PHOTO_TMP_PUBLIC		,Cfg_TIME_TO_DELETE_PHOTOS_TMP_FILES	,false);
-   else if (!(Gbl.PID % 127))
-      Fil_RemoveOldTmpFiles (Cfg_PATH_PHOTO_TMP_PRIVATE		,Cfg_TIME_TO_DELETE_PHOTOS_TMP_FILES	,false);
-   else if (!(Gbl.PID % 131))
-      Fil_RemoveOldTmpFiles (Cfg_PATH_MEDIA_TMP_PRIVATE		,Cfg_TIME_TO_DELETE_MEDIA_TMP_FILES	,false);
-   else if (!(Gbl.PID % 137))
-      Fil_RemoveOldTmpFiles (Cfg_PATH_ZIP_PRIVATE		,Cfg_TIME_TO_DELETE_BROWSER_ZIP_FILES	,false);
-   else if (!(Gbl.PID % 139))
-      Fil_RemoveOldTmpFiles (Cfg_PATH_MARK_PRIVATE		,Cfg_TIME_TO_DELETE_MARKS_TMP_FILES	,false);
-   else if (!(Gbl.PID % 149))
-      Fil_RemoveOldTmpFiles (Cfg_PATH_TEST_PRIVATE		,Cfg_TIME_TO_DELETE_TEST_TMP_FILES	,false);
-
    /***** Send, before the HTML, the refresh time *****/
    HTM_TxtF ("%lu|",Gbl.Usrs.Connected.TimeToRefreshInMs);
    if (Gbl.Usrs.Me.Logged)
@@ -25,12 +25,21 @@
 /*********************************** Headers *********************************/
 /*****************************************************************************/
 
+#define _GNU_SOURCE 		// For asprintf, getline, vasprintf
+#include <errno.h>		// For errno
+#include <fcntl.h>		// For open
+#include <stdarg.h>		// For va_start, va_end
+#include <stdio.h>		// For asprintf, getline
 #include <stdlib.h>		// For free
 #include <string.h>		// For strlen
+#include <sys/file.h>		// For flock
+#include <sys/stat.h>		// For mkdir, stat
+#include <unistd.h>		// For write, close, rename, unlink
 
 #include "swad_action.h"
 #include "swad_config.h"
 #include "swad_database.h"
+#include "swad_file.h"
 #include "swad_global.h"
 #include "swad_HTML.h"
 #include "swad_log.h"
@@ -48,10 +57,72 @@
 
 #define Log_SECONDS_IN_RECENT_LOG ((time_t) (Cfg_DAYS_IN_RECENT_LOG * 24UL * 60UL * 60UL))	// Remove entries in recent log oldest than this time
 
+/* Accesses are appended to a spool file by each request
+   and inserted into database in batches by a loader,
+   run by housekeeping (swad_maintenance) every Cfg_TIME_TO_LOAD_LOG_SPOOL */
+#define Log_SPOOL_FILE			Cfg_PATH_LOG_PRIVATE "/access.spool"	// Accesses pending to be loaded
+#define Log_LOADING_FILE		Cfg_PATH_LOG_PRIVATE "/access.loading"	// Accesses being loaded
+#define Log_LOADER_LOCK_FILE		Cfg_PATH_LOG_PRIVATE "/loader.lock"	// Locked while loading
+/* Each batch of accesses is inserted in a transaction
+   which also stores in table log_spool the offset in file
+   after the batch, so an interrupted load goes on from there */
+
+#define Log_MAX_TRIES_TO_OPEN_SPOOL	3
+#define Log_MAX_ACCESSES_PER_BATCH	500		// Accesses inserted into database with the same multi-row INSERTs
+#define Log_MAX_BYTES_QUERY		(512UL * 1024UL)	// Send a multi-row INSERT when it is longer than this
+
+#define Log_NUM_FIELDS_IN_SPOOL		21	// The last 2 fields (sizes of page) may be missing
+#define Log_MIN_FIELDS_IN_SPOOL		19
+
 /*****************************************************************************/
 /****************************** Private types ********************************/
 /*****************************************************************************/
 
+struct Log_Access
+  {
+   long ClickTime;	// UTC time of click (seconds since the Epoch)
+   long ActCod;
+   long CtyCod;
+   long InsCod;
+   long CtrCod;
+   long DegCod;
+   long CrsCod;
+   long UsrCod;
+   unsigned Role;
+   long TimeToGenerate;
+   long TimeToSend;
+   long BytesGenerated;
+   long BytesSent;
+   const char *IP;
+   bool Logged;
+   bool IsWebService;
+   long PlgCod;
+   unsigned FunCod;
+   long BanCod;
+   const char *Comments;	// NULL if no comments
+   const char *SearchStr;	// NULL if no search string
+  };
+
+struct Log_Query
+  {
+   const char *Head;	// Query until VALUES, used in multi-row INSERTs
+   char *Str;
+   size_t Length;
+   size_t Size;
+  };
+
+struct Log_UsrClicks
+  {
+   long UsrCod;
+   unsigned NumClicks;
+  };
+
+struct Log_LoadingFile
+  {
+   unsigned long long Inode;	// Inode and change time identify the file...
+   long CTime;			// ...being loaded
+  };
+
 /*****************************************************************************/
 /************** External global variables from others modules ****************/
 /*****************************************************************************/
@@ -62,10 +133,45 @@ extern struct Globals Gbl;
 /************************* Private global variables **************************/
 /*****************************************************************************/
 
+static struct
+  {
+   int fdLock;			// -1 if not loading
+   FILE *FileLoading;
+   bool InTransaction;
+  } Log_Loader =
+  {
+   .fdLock        = -1,
+   .FileLoading   = NULL,
+   .InTransaction = false,
+  };
+
 /*****************************************************************************/
 /***************************** Private prototypes ****************************/
 /*****************************************************************************/
 
+static bool Log_AppendAccessToSpool (const char *Comments,Rol_Role_t RoleToStore);
+static int Log_OpenSpool (void);
+static char *Log_BuildCommentsForDB (const char *Comments);
+static void Log_RemoveTabsAndNewLines (char *Str);
+
+static void Log_GetLoadingFile (FILE *FileLoading,
+                                struct Log_LoadingFile *LoadingFile);
+static void Log_SkipAccessesAlreadyLoaded (FILE *FileLoading,
+                                           const struct Log_LoadingFile *LoadingFile);
+static void Log_InsertAccessesFromFile (FILE *FileLoading,
+                                        const struct Log_LoadingFile *LoadingFile);
+static void Log_CloseLoader (void);
+static bool Log_GetTimeOfFirstAccessInFile (const char *Path,time_t *ClickTime);
+static bool Log_GetAccessFromSpoolLine (char *Line,struct Log_Access *Access);
+static void Log_InsertBatchOfAccesses (const struct Log_Access *Accesses,
+                                       unsigned NumAccesses,
+                                       const struct Log_LoadingFile *LoadingFile,
+                                       long long Offset);
+
+static void Log_AppendToQuery (struct Log_Query *Query,const char *fmt,...);
+static void Log_AddRowToMultiInsert (struct Log_Query *Query,const char *fmt,...);
+static void Log_SendMultiInsert (struct Log_Query *Query);
+
 /*****************************************************************************/
 /**************************** Log access in database *************************/
 /*****************************************************************************/
@@ -74,63 +180,69 @@ void Log_LogAccess (const char *Comments)
   {
    long LogCod;
    long ActCod = Act_GetActCod (Gbl.Action.Act);
-   size_t MaxLength;
    char *CommentsDB;
    Rol_Role_t RoleToStore = (Gbl.Action.Act == ActLogOut) ? Gbl.Usrs.Me.Role.LoggedBeforeCloseSession :
                                                             Gbl.Usrs.Me.Role.Logged;
 
-   /***** Insert access into database *****/
+   /***** Append access to spool, to be inserted later into database *****/
+   if (Log_AppendAccessToSpool (Comments,RoleToStore))
+      return;
+
+   /***** Spool is not available ==> insert access into database now *****/
    /* Log access in historical log (log_full) */
    LogCod =
-   DB_QueryINSERTandReturnCode ("can not log access (full)",
-				"INSERT INTO log_full "
-				"(ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,UsrCod,"
-				"Role,ClickTime,TimeToGenerate,TimeToSend,IP)"
-				" VALUES "
-				"(%ld,%ld,%ld,%ld,%ld,%ld,%ld,"
-				"%u,NOW(),%ld,%ld,'%s')",
-				ActCod,
-				Gbl.Hierarchy.Cty.CtyCod,
-				Gbl.Hierarchy.Ins.InsCod,
-				Gbl.Hierarchy.Ctr.CtrCod,
-				Gbl.Hierarchy.Deg.DegCod,
-				Gbl.Hierarchy.Crs.CrsCod,
-				Gbl.Usrs.Me.UsrDat.UsrCod,
-				(unsigned) RoleToStore,
-				Gbl.TimeGenerationInMicroseconds,
-				Gbl.TimeSendInMicroseconds,
-				Gbl.IP);
+   DB_QueryINSERTandReturnCodePrepared ("can not log access (full)",
+					"INSERT INTO log_full "
+					"(ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,UsrCod,"
+					"Role,ClickTime,TimeToGenerate,TimeToSend,"
+					"BytesGenerated,BytesSent,IP)"
+					" VALUES "
+					"(%ld,%ld,%ld,%ld,%ld,%ld,%ld,"
+					"%u,NOW(),%ld,%ld,"
+					"%ld,%ld,'%s')",
+					ActCod,
+					Gbl.Hierarchy.Cty.CtyCod,
+					Gbl.Hierarchy.Ins.InsCod,
+					Gbl.Hierarchy.Ctr.CtrCod,
+					Gbl.Hierarchy.Deg.DegCod,
+					Gbl.Hierarchy.Crs.CrsCod,
+					Gbl.Usrs.Me.UsrDat.UsrCod,
+					(unsigned) RoleToStore,
+					Gbl.TimeGenerationInMicroseconds,
+					Gbl.TimeSendInMicroseconds,
+					Gbl.BytesGenerated,
+					Gbl.BytesSent,
+					Gbl.IP);
 
    /* Log access in recent log (log_recent) */
-   DB_QueryINSERT ("can not log access (recent)",
-		   "INSERT INTO log_recent "
-	           "(LogCod,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,UsrCod,"
-	           "Role,ClickTime,TimeToGenerate,TimeToSend,IP)"
-                   " VALUES "
-                   "(%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,"
-                   "%u,NOW(),%ld,%ld,'%s')",
-		   LogCod,ActCod,
-		   Gbl.Hierarchy.Cty.CtyCod,
-		   Gbl.Hierarchy.Ins.InsCod,
-		   Gbl.Hierarchy.Ctr.CtrCod,
-		   Gbl.Hierarchy.Deg.DegCod,
-		   Gbl.Hierarchy.Crs.CrsCod,
-		   Gbl.Usrs.Me.UsrDat.UsrCod,
-		   (unsigned) RoleToStore,
-		   Gbl.TimeGenerationInMicroseconds,
-		   Gbl.TimeSendInMicroseconds,
-		   Gbl.IP);
+   DB_QueryINSERTprepared ("can not log access (recent)",
+			   "INSERT INTO log_recent "
+			   "(LogCod,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,UsrCod,"
+			   "Role,ClickTime,TimeToGenerate,TimeToSend,"
+			   "BytesGenerated,BytesSent,IP)"
+			   " VALUES "
+			   "(%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,"
+			   "%u,NOW(),%ld,%ld,"
+			   "%ld,%ld,'%s')",
+			   LogCod,ActCod,
+			   Gbl.Hierarchy.Cty.CtyCod,
+			   Gbl.Hierarchy.Ins.InsCod,
+			   Gbl.Hierarchy.Ctr.CtrCod,
+			   Gbl.Hierarchy.Deg.DegCod,
+			   Gbl.Hierarchy.Crs.CrsCod,
+			   Gbl.Usrs.Me.UsrDat.UsrCod,
+			   (unsigned) RoleToStore,
+			   Gbl.TimeGenerationInMicroseconds,
+			   Gbl.TimeSendInMicroseconds,
+			   Gbl.BytesGenerated,
+			   Gbl.BytesSent,
+			   Gbl.IP);
 
    /* Log comments */
    if (Comments)
      {
-      MaxLength = strlen (Comments) * Str_MAX_BYTES_PER_CHAR;
-      if ((CommentsDB = (char *) malloc (MaxLength + 1)) != NULL)
+      if ((CommentsDB = Log_BuildCommentsForDB (Comments)) != NULL)
 	{
-	 Str_Copy (CommentsDB,Comments,
-	           MaxLength);
-	 Str_ChangeFormat (Str_FROM_TEXT,Str_TO_TEXT,
-			   CommentsDB,MaxLength,true);	// Avoid SQL injection
 	 DB_QueryINSERT ("can not log access (comments)",
 			 "INSERT INTO log_comments"
 			 " (LogCod,Comments)"
@@ -152,38 +264,745 @@ void Log_LogAccess (const char *Comments)
 
    if (Gbl.WebService.IsWebService)
       /* Log web service plugin and function */
-      DB_QueryINSERT ("can not log access (comments)",
-		      "INSERT INTO log_ws"
-	              " (LogCod,PlgCod,FunCod)"
-                      " VALUES"
-                      " (%ld,%ld,%u)",
-	              LogCod,Gbl.WebService.PlgCod,
-		      (unsigned) Gbl.WebService.Function);
+      DB_QueryINSERTprepared ("can not log access (comments)",
+			      "INSERT INTO log_ws"
+			      " (LogCod,PlgCod,FunCod)"
+			      " VALUES"
+			      " (%ld,%ld,%u)",
+			      LogCod,Gbl.WebService.PlgCod,
+			      (unsigned) Gbl.WebService.Function);
    else if (Gbl.Banners.BanCodClicked > 0)
       /* Log banner clicked */
-      DB_QueryINSERT ("can not log banner clicked",
-		      "INSERT INTO log_banners"
-	              " (LogCod,BanCod)"
-                      " VALUES"
-                      " (%ld,%ld)",
-	              LogCod,Gbl.Banners.BanCodClicked);
+      DB_QueryINSERTprepared ("can not log banner clicked",
+			      "INSERT INTO log_banners"
+			      " (LogCod,BanCod)"
+			      " VALUES"
+			      " (%ld,%ld)",
+			      LogCod,Gbl.Banners.BanCodClicked);
 
    /***** Increment my number of clicks *****/
    if (Gbl.Usrs.Me.Logged)
       Prf_IncrementNumClicksUsr (Gbl.Usrs.Me.UsrDat.UsrCod);
   }
 
+/*****************************************************************************/
+/******************** Append an access to the spool file *********************/
+/*****************************************************************************/
+// Return true if the access has been appended to spool
+
+static bool Log_AppendAccessToSpool (const char *Comments,Rol_Role_t RoleToStore)
+  {
+   char *CommentsDB = NULL;
+   char *SearchStr = NULL;
+   char *Line;
+   int LineLength;
+   int fd;
+   struct stat StatFd;
+   struct stat StatPath;
+   unsigned NumTry;
+   bool Appended = false;
+
+   /***** Build comments and search string.
+	  Tabs and new lines are removed because they are used as separators *****/
+   if (Comments)
+     {
+      if ((CommentsDB = Log_BuildCommentsForDB (Comments)) == NULL)
+	 return false;
+      Log_RemoveTabsAndNewLines (CommentsDB);
+     }
+   if (Gbl.Search.LogSearch && Gbl.Search.Str[0])
+     {
+      if ((SearchStr = strdup (Gbl.Search.Str)) == NULL)
+	{
+	 if (CommentsDB)
+	    free (CommentsDB);
+	 return false;
+	}
+      Log_RemoveTabsAndNewLines (SearchStr);
+     }
+
+   /***** Build line with all the fields separated by tabs *****/
+   LineLength = asprintf (&Line,"%ld\t%ld\t"
+				"%ld\t%ld\t%ld\t%ld\t%ld\t"
+				"%ld\t%u\t%ld\t%ld\t%s\t"
+				"%c\t%c\t%ld\t%u\t%ld\t"
+				"%c%s\t%c%s\t"
+				"%ld\t%ld\n",
+			  (long) Gbl.StartExecutionTimeUTC,
+			  Act_GetActCod (Gbl.Action.Act),
+			  Gbl.Hierarchy.Cty.CtyCod,
+			  Gbl.Hierarchy.Ins.InsCod,
+			  Gbl.Hierarchy.Ctr.CtrCod,
+			  Gbl.Hierarchy.Deg.DegCod,
+			  Gbl.Hierarchy.Crs.CrsCod,
+			  Gbl.Usrs.Me.UsrDat.UsrCod,
+			  (unsigned) RoleToStore,
+			  Gbl.TimeGenerationInMicroseconds,
+			  Gbl.TimeSendInMicroseconds,
+			  Gbl.IP,
+			  Gbl.Usrs.Me.Logged ? 'Y' :
+					       'N',
+			  Gbl.WebService.IsWebService ? 'Y' :
+							'N',
+			  Gbl.WebService.PlgCod,
+			  (unsigned) Gbl.WebService.Function,
+			  Gbl.Banners.BanCodClicked,
+			  CommentsDB ? '+' :	// '+' ==> there are comments
+				       '-',	// '-' ==> no comments
+			  CommentsDB ? CommentsDB :
+				       "",
+			  SearchStr ? '+' :
+				      '-',
+			  SearchStr ? SearchStr :
+				      "",
+			  Gbl.BytesGenerated,
+			  Gbl.BytesSent);
+   if (CommentsDB)
+      free (CommentsDB);
+   if (SearchStr)
+      free (SearchStr);
+   if (LineLength < 0)
+      return false;
+
+   /***** Append line to spool.
+	  The spool may be renamed by the loader between open and lock,
+	  so after locking, check it is still the spool *****/
+   for (NumTry = 0;
+	NumTry < Log_MAX_TRIES_TO_OPEN_SPOOL && !Appended;
+	NumTry++)
+     {
+      if ((fd = Log_OpenSpool ()) < 0)
+	 break;
+      if (!flock (fd,LOCK_EX))
+	 if (!fstat (fd,&StatFd) &&
+	     !stat (Log_SPOOL_FILE,&StatPath) &&
+	     StatFd.st_dev == StatPath.st_dev &&
+	     StatFd.st_ino == StatPath.st_ino)
+	    Appended = (write (fd,Line,(size_t) LineLength) == (ssize_t) LineLength);
+      close (fd);	// Unlock
+     }
+   free (Line);
+
+   return Appended;
+  }
+
+/*****************************************************************************/
+/************** Open spool file, creating its folder if necessary ************/
+/*****************************************************************************/
+// Return file descriptor or -1 on error
+
+static int Log_OpenSpool (void)
+  {
+   int fd;
+
+   if ((fd = open (Log_SPOOL_FILE,O_WRONLY | O_APPEND | O_CREAT,0600)) < 0)
+      if (errno == ENOENT)
+	 if (!mkdir (Cfg_PATH_LOG_PRIVATE,0700) || errno == EEXIST)
+	    fd = open (Log_SPOOL_FILE,O_WRONLY | O_APPEND | O_CREAT,0600);
+
+   return fd;
+  }
+
+/*****************************************************************************/
+/*********** Allocate comments changed to be stored in database **************/
+/*****************************************************************************/
+// Return NULL if no memory. The string returned must be freed by the caller
+
+static char *Log_BuildCommentsForDB (const char *Comments)
+  {
+   size_t MaxLength;
+   char *CommentsDB;
+
+   MaxLength = strlen (Comments) * Str_MAX_BYTES_PER_CHAR;
+   if ((CommentsDB = (char *) malloc (MaxLength + 1)) != NULL)
+     {
+      Str_Copy (CommentsDB,Comments,
+		MaxLength);
+      Str_ChangeFormat (Str_FROM_TEXT,Str_TO_TEXT,
+			CommentsDB,MaxLength,true);	// Avoid SQL injection
+     }
+
+   return CommentsDB;
+  }
+
+/*****************************************************************************/
+/************** Change tabs and new lines in a string to spaces **************/
+/*****************************************************************************/
+
+static void Log_RemoveTabsAndNewLines (char *Str)
+  {
+   for (;
+	*Str;
+	Str++)
+      if (*Str == '\t' || *Str == '\n' || *Str == '\r')
+	 *Str = ' ';
+  }
+
+/*****************************************************************************/
+/********** Insert accesses pending in spool into database log ***************/
+/*****************************************************************************/
+// Called periodically by housekeeping.
+// Accesses are inserted in batches, using multi-row INSERTs
+
+void Log_LoadSpoolIntoDB (void)
+  {
+   struct Log_LoadingFile LoadingFile;
+
+   /***** Do nothing if this process is already loading *****/
+   if (Log_Loader.fdLock >= 0)
+      return;
+
+   /***** Only one loader at a time. If other is loading, do nothing *****/
+   if ((Log_Loader.fdLock = open (Log_LOADER_LOCK_FILE,O_RDWR | O_CREAT,0600)) < 0)
+      return;
+   if (flock (Log_Loader.fdLock,LOCK_EX | LOCK_NB))
+     {
+      close (Log_Loader.fdLock);
+      Log_Loader.fdLock = -1;
+      return;
+     }
+
+   /***** Move spool to file to be loaded.
+	  If a previous load was interrupted, that file is loaded again
+	  from the first access not yet inserted *****/
+   if (Fil_CheckIfPathExists (Log_LOADING_FILE) ||
+       !rename (Log_SPOOL_FILE,Log_LOADING_FILE))
+      if ((Log_Loader.FileLoading = fopen (Log_LOADING_FILE,"rb")) != NULL)
+	{
+	 /***** Wait for processes which are still appending to file *****/
+	 flock (fileno (Log_Loader.FileLoading),LOCK_EX);
+	 flock (fileno (Log_Loader.FileLoading),LOCK_UN);
+
+	 /***** Insert accesses into database *****/
+	 Log_GetLoadingFile (Log_Loader.FileLoading,&LoadingFile);
+	 Log_SkipAccessesAlreadyLoaded (Log_Loader.FileLoading,&LoadingFile);
+	 Log_InsertAccessesFromFile (Log_Loader.FileLoading,&LoadingFile);
+
+	 /***** Remove file *****/
+	 unlink (Log_LOADING_FILE);
+	}
+
+   /***** Close file and unlock *****/
+   Log_CloseLoader ();
+  }
+
+/*****************************************************************************/
+/******** Abort load of spool after an error while loading (if any) **********/
+/*****************************************************************************/
+// Called when a request or a housekeeping job ends with an error, before unlocking tables
+
+void Log_AbortLoadingSpool (void)
+  {
+   if (Log_Loader.fdLock < 0)	// Not loading
+      return;
+
+   /***** Undo the batch being inserted.
+          Must be done before unlocking tables,
+          because UNLOCK TABLES commits the transaction *****/
+   if (Log_Loader.InTransaction)
+     {
+      Log_Loader.InTransaction = false;
+      mysql_query (&Gbl.mysql,"ROLLBACK");
+      mysql_query (&Gbl.mysql,"SET autocommit=1");
+     }
+
+   /***** Close file and unlock,
+          so other processes can load the spool *****/
+   Log_CloseLoader ();
+  }
+
+/*****************************************************************************/
+/*************************** Close file and unlock ***************************/
+/*****************************************************************************/
+
+static void Log_CloseLoader (void)
+  {
+   if (Log_Loader.FileLoading)
+     {
+      fclose (Log_Loader.FileLoading);
+      Log_Loader.FileLoading = NULL;
+     }
+   close (Log_Loader.fdLock);
+   Log_Loader.fdLock = -1;
+  }
+
+/*****************************************************************************/
+/********************* Get identifier of file being loaded *******************/
+/*****************************************************************************/
+
+static void Log_GetLoadingFile (FILE *FileLoading,
+                                struct Log_LoadingFile *LoadingFile)
+  {
+   struct stat StatLoading;
+
+   if (fstat (fileno (FileLoading),&StatLoading))
+     {
+      LoadingFile->Inode = 0;
+      LoadingFile->CTime = 0;
+     }
+   else
+     {
+      LoadingFile->Inode = (unsigned long long) StatLoading.st_ino;
+      LoadingFile->CTime = (long) StatLoading.st_ctime;
+     }
+  }
+
+/*****************************************************************************/
+/****** Go to the first access not yet inserted in an interrupted load *******/
+/*****************************************************************************/
+
+static void Log_SkipAccessesAlreadyLoaded (FILE *FileLoading,
+                                           const struct Log_LoadingFile *LoadingFile)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   long long Offset;
+
+   /***** Get offset after the last batch inserted from this file *****/
+   if (DB_QuerySELECT (&mysql_res,"can not get offset in spool",
+		       "SELECT Offset FROM log_spool"
+		       " WHERE Inode=%llu AND CTime=%ld",
+		       LoadingFile->Inode,LoadingFile->CTime))
+     {
+      row = mysql_fetch_row (mysql_res);
+      if (sscanf (row[0],"%lld",&Offset) == 1)
+	 if (Offset > 0)
+	    fseeko (FileLoading,(off_t) Offset,SEEK_SET);
+     }
+   DB_FreeMySQLResult (&mysql_res);
+  }
+
+/*****************************************************************************/
+/**************** Insert all accesses in a file into database ****************/
+/*****************************************************************************/
+
+static void Log_InsertAccessesFromFile (FILE *FileLoading,
+                                        const struct Log_LoadingFile *LoadingFile)
+  {
+   struct Log_Access Accesses[Log_MAX_ACCESSES_PER_BATCH];
+   char *Lines[Log_MAX_ACCESSES_PER_BATCH];
+   unsigned NumAccesses = 0;
+   unsigned NumAcc;
+   char *Line = NULL;
+   size_t LineSize = 0;
+
+   /***** Read accesses and insert them in batches *****/
+   while (getline (&Line,&LineSize,FileLoading) > 0)
+     {
+      if (Log_GetAccessFromSpoolLine (Line,&Accesses[NumAccesses]))
+	{
+	 /* Keep line, because access fields point to it */
+	 Lines[NumAccesses++] = Line;
+	 Line = NULL;
+	 LineSize = 0;
+	}
+
+      if (NumAccesses == Log_MAX_ACCESSES_PER_BATCH)
+	{
+	 Log_InsertBatchOfAccesses (Accesses,NumAccesses,
+	                            LoadingFile,(long long) ftello (FileLoading));
+	 for (NumAcc = 0;
+	      NumAcc < NumAccesses;
+	      NumAcc++)
+	    free (Lines[NumAcc]);
+	 NumAccesses = 0;
+	}
+     }
+   if (Line)
+      free (Line);
+
+   /***** Insert last batch *****/
+   if (NumAccesses)
+     {
+      Log_InsertBatchOfAccesses (Accesses,NumAccesses,
+                                 LoadingFile,(long long) ftello (FileLoading));
+      for (NumAcc = 0;
+	   NumAcc < NumAccesses;
+	   NumAcc++)
+	 free (Lines[NumAcc]);
+     }
+  }
+
+/*****************************************************************************/
+/********************* Get the fields of a line of spool *********************/
+/*****************************************************************************/
+// Line is modified, and access fields will point to it
+// Return false if line is wrong
+
+static bool Log_GetAccessFromSpoolLine (char *Line,struct Log_Access *Access)
+  {
+   char *Fields[Log_NUM_FIELDS_IN_SPOOL];
+   unsigned NumField;
+   char *Ptr = Line;
+   size_t Length;
+
+   /***** Remove ending new line *****/
+   Length = strlen (Line);
+   if (Length == 0 || Line[Length - 1] != '\n')	// Incomplete line
+      return false;
+   Line[Length - 1] = '\0';
+
+   /***** Split line in fields separated by tabs *****/
+   for (NumField = 0;
+	NumField < Log_NUM_FIELDS_IN_SPOOL;
+	NumField++)
+      if ((Fields[NumField] = strsep (&Ptr,"\t")) == NULL)
+	{
+	 if (NumField < Log_MIN_FIELDS_IN_SPOOL)
+	    return false;
+	 Fields[NumField] = "0";	// Missing in lines written by older versions
+	}
+
+   /***** Get fields *****/
+   if (sscanf (Fields[ 0],"%ld",&Access->ClickTime     ) != 1 ||
+       sscanf (Fields[ 1],"%ld",&Access->ActCod        ) != 1 ||
+       sscanf (Fields[ 2],"%ld",&Access->CtyCod        ) != 1 ||
+       sscanf (Fields[ 3],"%ld",&Access->InsCod        ) != 1 ||
+       sscanf (Fields[ 4],"%ld",&Access->CtrCod        ) != 1 ||
+       sscanf (Fields[ 5],"%ld",&Access->DegCod        ) != 1 ||
+       sscanf (Fields[ 6],"%ld",&Access->CrsCod        ) != 1 ||
+       sscanf (Fields[ 7],"%ld",&Access->UsrCod        ) != 1 ||
+       sscanf (Fields[ 8],"%u" ,&Access->Role          ) != 1 ||
+       sscanf (Fields[ 9],"%ld",&Access->TimeToGenerate) != 1 ||
+       sscanf (Fields[10],"%ld",&Access->TimeToSend    ) != 1 ||
+       sscanf (Fields[14],"%ld",&Access->PlgCod        ) != 1 ||
+       sscanf (Fields[15],"%u" ,&Access->FunCod        ) != 1 ||
+       sscanf (Fields[16],"%ld",&Access->BanCod        ) != 1 ||
+       sscanf (Fields[19],"%ld",&Access->BytesGenerated) != 1 ||
+       sscanf (Fields[20],"%ld",&Access->BytesSent     ) != 1)
+      return false;
+   Access->IP = Fields[11];
+   Access->Logged       = (Fields[12][0] == 'Y');
+   Access->IsWebService = (Fields[13][0] == 'Y');
+   Access->Comments  = (Fields[17][0] == '+') ? &Fields[17][1] :
+						NULL;
+   Access->SearchStr = (Fields[18][0] == '+') ? &Fields[18][1] :
+						NULL;
+
+   return true;
+  }
+
+/*****************************************************************************/
+/**************** Insert a batch of accesses into database *******************/
+/*****************************************************************************/
+
+static void Log_InsertBatchOfAccesses (const struct Log_Access *Accesses,
+                                       unsigned NumAccesses,
+                                       const struct Log_LoadingFile *LoadingFile,
+                                       long long Offset)
+  {
+   struct Log_Query Full     = {.Head = "INSERT INTO log_full"
+					" (LogCod,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,UsrCod,"
+					"Role,ClickTime,TimeToGenerate,TimeToSend,"
+					"BytesGenerated,BytesSent,IP)"
+					" VALUES "};
+   struct Log_Query Recent   = {.Head = "INSERT INTO log_recent"
+					" (LogCod,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,UsrCod,"
+					"Role,ClickTime,TimeToGenerate,TimeToSend,"
+					"BytesGenerated,BytesSent,IP)"
+					" VALUES "};
+   struct Log_Query Comments = {.Head = "INSERT INTO log_comments"
+					" (LogCod,Comments)"
+					" VALUES "};
+   struct Log_Query Search   = {.Head = "INSERT INTO log_search"
+					" (LogCod,SearchStr)"
+					" VALUES "};
+   struct Log_Query WS       = {.Head = "INSERT INTO log_ws"
+					" (LogCod,PlgCod,FunCod)"
+					" VALUES "};
+   struct Log_Query Banners  = {.Head = "INSERT INTO log_banners"
+					" (LogCod,BanCod)"
+					" VALUES "};
+   struct Log_Query Clicks   = {.Head = NULL};
+   struct Log_Query UsrCods  = {.Head = NULL};
+   struct Log_UsrClicks UsrClicks[Log_MAX_ACCESSES_PER_BATCH];
+   unsigned NumUsrs = 0;
+   unsigned NumUsr;
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   long LastLogCod = 0;
+   long LogCod;
+   unsigned NumAcc;
+   const struct Log_Access *Access;
+
+   /***** Begin transaction.
+          Accesses in this batch and offset in file after them
+          are stored all together or not at all *****/
+   DB_Query ("can not begin transaction to insert accesses",
+	     "SET autocommit=0");
+   Log_Loader.InTransaction = true;
+
+   /***** Lock tables, so nobody else inserts accesses
+	  while codes are assigned to accesses in this batch *****/
+   DB_Query ("can not lock tables to insert accesses",
+	     "LOCK TABLES log_full WRITE,log_recent WRITE,"
+	     "log_comments WRITE,log_search WRITE,"
+	     "log_ws WRITE,log_banners WRITE,"
+	     "usr_figures WRITE,log_spool WRITE");
+   Gbl.DB.LockedTables = true;
+
+   /***** Get last code in log *****/
+   if (DB_QuerySELECT (&mysql_res,"can not get last access code",
+		       "SELECT MAX(LogCod) FROM log_full"))
+     {
+      row = mysql_fetch_row (mysql_res);
+      if (row[0])
+	 if (sscanf (row[0],"%ld",&LastLogCod) != 1)
+	    LastLogCod = 0;
+     }
+   DB_FreeMySQLResult (&mysql_res);
+
+   /***** Build multi-row INSERTs.
+	  Accesses get consecutive codes, so they are linked
+	  between log_full, log_recent and the other tables *****/
+   for (NumAcc = 0, LogCod = LastLogCod + 1;
+	NumAcc < NumAccesses;
+	NumAcc++, LogCod++)
+     {
+      Access = &Accesses[NumAcc];
+
+      Log_AddRowToMultiInsert (&Full,"(%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,"
+				     "%u,FROM_UNIXTIME(%ld),%ld,%ld,"
+				     "%ld,%ld,'%s')",
+			       LogCod,Access->ActCod,
+			       Access->CtyCod,Access->InsCod,Access->CtrCod,
+			       Access->DegCod,Access->CrsCod,Access->UsrCod,
+			       Access->Role,Access->ClickTime,
+			       Access->TimeToGenerate,Access->TimeToSend,
+			       Access->BytesGenerated,Access->BytesSent,
+			       Access->IP);
+      Log_AddRowToMultiInsert (&Recent,"(%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,"
+				       "%u,FROM_UNIXTIME(%ld),%ld,%ld,"
+				       "%ld,%ld,'%s')",
+			       LogCod,Access->ActCod,
+			       Access->CtyCod,Access->InsCod,Access->CtrCod,
+			       Access->DegCod,Access->CrsCod,Access->UsrCod,
+			       Access->Role,Access->ClickTime,
+			       Access->TimeToGenerate,Access->TimeToSend,
+			       Access->BytesGenerated,Access->BytesSent,
+			       Access->IP);
+      if (Access->Comments)
+	 Log_AddRowToMultiInsert (&Comments,"(%ld,'%s')",
+				  LogCod,Access->Comments);
+      if (Access->SearchStr)
+	 Log_AddRowToMultiInsert (&Search,"(%ld,'%s')",
+				  LogCod,Access->SearchStr);
+      if (Access->IsWebService)
+	 Log_AddRowToMultiInsert (&WS,"(%ld,%ld,%u)",
+				  LogCod,Access->PlgCod,Access->FunCod);
+      else if (Access->BanCod > 0)
+	 Log_AddRowToMultiInsert (&Banners,"(%ld,%ld)",
+				  LogCod,Access->BanCod);
+
+      /* Count clicks of each user */
+      if (Access->Logged)
+	{
+	 for (NumUsr = 0;
+	      NumUsr < NumUsrs;
+	      NumUsr++)
+	    if (UsrClicks[NumUsr].UsrCod == Access->UsrCod)
+	       break;
+	 if (NumUsr == NumUsrs)	// User not found
+	   {
+	    UsrClicks[NumUsrs].UsrCod = Access->UsrCod;
+	    UsrClicks[NumUsrs].NumClicks = 0;
+	    NumUsrs++;
+	   }
+	 UsrClicks[NumUsr].NumClicks++;
+	}
+     }
+   Log_SendMultiInsert (&Full);
+   Log_SendMultiInsert (&Recent);
+   Log_SendMultiInsert (&Comments);
+   Log_SendMultiInsert (&Search);
+   Log_SendMultiInsert (&WS);
+   Log_SendMultiInsert (&Banners);
+
+   /***** Increment number of clicks of users with a single UPDATE *****/
+   // If NumClicks < 0 ==> not yet calculated, so do nothing
+   if (NumUsrs)
+     {
+      for (NumUsr = 0;
+	   NumUsr < NumUsrs;
+	   NumUsr++)
+	{
+	 Log_AppendToQuery (&Clicks," WHEN %ld THEN %u",
+			    UsrClicks[NumUsr].UsrCod,UsrClicks[NumUsr].NumClicks);
+	 Log_AppendToQuery (&UsrCods,NumUsr ? ",%ld" :
+					      "%ld",
+			    UsrClicks[NumUsr].UsrCod);
+	}
+      DB_QueryUPDATE ("can not increment user's clicks",
+		      "UPDATE IGNORE usr_figures"
+		      " SET NumClicks=NumClicks+CASE UsrCod%s END"
+		      " WHERE UsrCod IN (%s) AND NumClicks>=0",
+		      Clicks.Str,UsrCods.Str);
+      free (Clicks.Str);
+      free (UsrCods.Str);
+     }
+
+   /***** Store offset in file after this batch *****/
+   DB_QueryDELETE ("can not remove offset in spool",
+		   "DELETE FROM log_spool");
+   DB_QueryINSERT ("can not store offset in spool",
+		   "INSERT INTO log_spool"
+		   " (Inode,CTime,Offset)"
+		   " VALUES"
+		   " (%llu,%ld,%lld)",
+		   LoadingFile->Inode,LoadingFile->CTime,Offset);
+
+   /***** End transaction *****/
+   DB_Query ("can not commit accesses",
+	     "COMMIT");
+   Log_Loader.InTransaction = false;
+
+   /***** Unlock tables *****/
+   Gbl.DB.LockedTables = false;	// Set to false before the following unlock...
+				// ...to not retry the unlock if error in unlocking
+   DB_Query ("can not unlock tables after inserting accesses",
+	     "UNLOCK TABLES");
+
+   DB_Query ("can not end transaction to insert accesses",
+	     "SET autocommit=1");
+  }
+
+/*****************************************************************************/
+/*********************** Append a formatted text to a query ******************/
+/*****************************************************************************/
+
+static void Log_AppendToQuery (struct Log_Query *Query,const char *fmt,...)
+  {
+   va_list ap;
+   int NumBytesPrinted;
+   char *Str;
+   size_t NewSize;
+
+   va_start (ap,fmt);
+   NumBytesPrinted = vasprintf (&Str,fmt,ap);
+   va_end (ap);
+   if (NumBytesPrinted < 0)	// -1 if no memory or any other error
+      Lay_NotEnoughMemoryExit ();
+
+   /***** Enlarge query if necessary *****/
+   if (Query->Length + (size_t) NumBytesPrinted + 1 > Query->Size)
+     {
+      NewSize = (Query->Size ? Query->Size * 2 :
+			       4096);
+      while (Query->Length + (size_t) NumBytesPrinted + 1 > NewSize)
+	 NewSize *= 2;
+      if ((Query->Str = (char *) realloc (Query->Str,NewSize)) == NULL)
+	 Lay_NotEnoughMemoryExit ();
+      Query->Size = NewSize;
+     }
+
+   /***** Append text *****/
+   memcpy (&Query->Str[Query->Length],Str,(size_t) NumBytesPrinted + 1);
+   Query->Length += (size_t) NumBytesPrinted;
+   free (Str);
+  }
+
+/*****************************************************************************/
+/********************* Add a row to a multi-row INSERT ***********************/
+/*****************************************************************************/
+
+static void Log_AddRowToMultiInsert (struct Log_Query *Query,const char *fmt,...)
+  {
+   va_list ap;
+   int NumBytesPrinted;
+   char *Row;
+
+   va_start (ap,fmt);
+   NumBytesPrinted = vasprintf (&Row,fmt,ap);
+   va_end (ap);
+   if (NumBytesPrinted < 0)	// -1 if no memory or any other error
+      Lay_NotEnoughMemoryExit ();
+
+   /***** Start query or separate rows *****/
+   if (Query->Length)
+      Log_AppendToQuery (Query,",%s",Row);
+   else
+      Log_AppendToQuery (Query,"%s%s",Query->Head,Row);
+   free (Row);
+
+   /***** Do not let query grow too much *****/
+   if (Query->Length > Log_MAX_BYTES_QUERY)
+      Log_SendMultiInsert (Query);
+  }
+
+/*****************************************************************************/
+/************** Send a multi-row INSERT to database and reset it *************/
+/*****************************************************************************/
+
+static void Log_SendMultiInsert (struct Log_Query *Query)
+  {
+   if (Query->Length)
+     {
+      if (mysql_real_query (&Gbl.mysql,Query->Str,(unsigned long) Query->Length))
+	 DB_ExitOnMySQLError ("can not insert accesses");
+      Query->Length = 0;
+     }
+   if (Query->Str)
+     {
+      free (Query->Str);
+      Query->Str = NULL;
+      Query->Size = 0;
+     }
+  }
+
+/*****************************************************************************/
+/*********** Get time of the oldest access not yet loaded into database ******/
+/*****************************************************************************/
+// Returns false if there are no accesses in spool
+// The first access in the file being loaded may be already in database,
+// so the time got may be a bit older than the real one
+
+bool Log_GetTimeOfOldestAccessInSpool (time_t *ClickTime)
+  {
+   time_t ClickTimeSpool;
+
+   if (Log_GetTimeOfFirstAccessInFile (Log_LOADING_FILE,ClickTime))
+     {
+      /* Accesses in spool are newer, except if clocks went back */
+      if (Log_GetTimeOfFirstAccessInFile (Log_SPOOL_FILE,&ClickTimeSpool))
+	 if (ClickTimeSpool < *ClickTime)
+	    *ClickTime = ClickTimeSpool;
+      return true;
+     }
+
+   return Log_GetTimeOfFirstAccessInFile (Log_SPOOL_FILE,ClickTime);
+  }
+
+static bool Log_GetTimeOfFirstAccessInFile (const char *Path,time_t *ClickTime)
+  {
+   FILE *FileSpool;
+   long Time;
+   bool Found = false;
+
+   if ((FileSpool = fopen (Path,"rb")) != NULL)
+     {
+      /* The first field of each line is the time of the access */
+      if (fscanf (FileSpool,"%ld",&Time) == 1)
+	{
+	 *ClickTime = (time_t) Time;
+	 Found = true;
+	}
+      fclose (FileSpool);
+     }
+
+   return Found;
+  }
+
 /*****************************************************************************/
 /************ Sometimes, we delete old entries in recent log table ***********/
 /*****************************************************************************/
 
 void Log_RemoveOldEntriesRecentLog (void)
   {
-   /***** Remove all expired clipboards *****/
-   DB_QueryDELETE ("can not remove old entries from recent log",
-		   "DELETE LOW_PRIORITY FROM log_recent"
-                   " WHERE ClickTime<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
-		   Log_SECONDS_IN_RECENT_LOG);
+   /***** Remove old entries in small batches *****/
+   DB_QueryDELETEinBatches ("can not remove old entries from recent log",
+			    "DELETE LOW_PRIORITY FROM log_recent"
+			    " WHERE ClickTime<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
+			    Log_SECONDS_IN_RECENT_LOG);
   }
 
 /*****************************************************************************/
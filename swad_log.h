@@ -27,6 +27,9 @@
 /********************************* Headers ***********************************/
 /*****************************************************************************/
 
+#include <stdbool.h>		// For boolean type
+#include <time.h>		// For time_t
+
 /*****************************************************************************/
 /***************************** Public constants ******************************/
 /*****************************************************************************/
@@ -40,6 +43,9 @@
 /*****************************************************************************/
 
 void Log_LogAccess (const char *Comments);
+void Log_LoadSpoolIntoDB (void);
+void Log_AbortLoadingSpool (void);
+bool Log_GetTimeOfOldestAccessInSpool (time_t *ClickTime);
 void Log_RemoveOldEntriesRecentLog (void);
 
 void Log_PutLinkToLastClicks (void);
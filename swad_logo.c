@@ -410,7 +410,7 @@ void Lgo_ReceiveLogo (Hie_Level_t Scope)
 	     (unsigned) Cod);
    Fil_CreateDirIfNotExists (Path);
 
-   /***** Copy in disk the file received from stdin (really from Gbl.F.Tmp) *****/
+   /***** Copy in disk the file received from stdin (really from a temporary file) *****/
    Param = Fil_StartReceptionOfFile (Fil_NAME_OF_PARAM_FILENAME_ORG,
                                      FileNameLogoSrc,MIMEType);
 
@@ -26,7 +26,8 @@
 /*****************************************************************************/
 
 #include <stddef.h>		// For NULL
-#include <stdlib.h>		// For calloc
+#include <stdio.h>		// For fopen, fread, snprintf
+#include <stdlib.h>		// For calloc, malloc, free
 #include <string.h>		// For string functions
 #include <sys/wait.h>		// For the macro WEXITSTATUS
 #include <unistd.h>		// For access, lstat, getpid, chdir, symlink, unlink
@@ -55,6 +56,8 @@ extern struct Globals Gbl;
 
 #define Mai_LENGTH_EMAIL_CONFIRM_KEY Cry_BYTES_ENCRYPTED_STR_SHA256_BASE64
 
+#define Mai_MAX_BYTES_SUBJECT 1023	// Maximum length of subject of automatic emails
+
 /*****************************************************************************/
 /******************************* Private types *******************************/
 /*****************************************************************************/
@@ -99,6 +102,11 @@ static void Mai_NewUsrEmail (struct UsrData *UsrDat,bool ItsMe);
 static void Mai_InsertMailKey (const char Email[Cns_MAX_BYTES_EMAIL_ADDRESS + 1],
                                const char MailKey[Mai_LENGTH_EMAIL_CONFIRM_KEY + 1]);
 
+#ifdef Cfg_MAIL_QUEUE
+static int Mai_QueueMailMsg (const char *To,const char *FullSubject);
+#endif
+static int Mai_RunScriptToSendMailMsg (const char *To,const char *FullSubject);
+
 static void Mai_EditingMailDomainConstructor (void);
 static void Mai_EditingMailDomainDestructor (void);
 
@@ -1625,11 +1633,8 @@ bool Mai_SendMailMsgToConfirmEmail (void)
    extern const char *Txt_If_you_just_request_from_X_the_confirmation_of_your_email_Y_NO_HTML;
    extern const char *Txt_Confirmation_of_your_email_NO_HTML;
    extern const char *Txt_A_message_has_been_sent_to_email_address_X_to_confirm_that_address;
+   extern const char *Txt_A_message_will_be_sent_to_email_address_X_to_confirm_that_address;
    extern const char *Txt_There_was_a_problem_sending_an_email_automatically;
-   char Command[2048 +
-		Cfg_MAX_BYTES_SMTP_PASSWORD +
-		Cns_MAX_BYTES_EMAIL_ADDRESS +
-		PATH_MAX]; // Command to execute for sending an email
    int ReturnCode;
 
    /***** Create temporary file for mail content *****/
@@ -1654,26 +1659,12 @@ bool Mai_SendMailMsgToConfirmEmail (void)
 
    fclose (Gbl.Msg.FileMail);
 
-   /***** Call the script to send an email *****/
-   snprintf (Command,sizeof (Command),
-	     "%s \"%s\" \"%s\" \"%s\" \"%s\" \"%s\" \"[%s] %s\" \"%s\"",
-             Cfg_COMMAND_SEND_AUTOMATIC_EMAIL,
-             Cfg_AUTOMATIC_EMAIL_SMTP_SERVER,
-	     Cfg_AUTOMATIC_EMAIL_SMTP_PORT,
-             Cfg_AUTOMATIC_EMAIL_FROM,
-             Gbl.Config.SMTPPassword,
-             Gbl.Usrs.Me.UsrDat.Email,
-             Cfg_PLATFORM_SHORT_NAME,Txt_Confirmation_of_your_email_NO_HTML,
-             Gbl.Msg.FileNameMail);
-   ReturnCode = system (Command);
-   if (ReturnCode == -1)
-      Lay_ShowErrorAndExit ("Error when running script to send email.");
-
-   /***** Remove temporary file *****/
-   unlink (Gbl.Msg.FileNameMail);
+   /***** Send the email *****/
+   ReturnCode = Mai_SendMailMsg (Gbl.Usrs.Me.UsrDat.Email,
+				 Txt_Confirmation_of_your_email_NO_HTML,
+				 Mai_QUEUE);
 
    /***** Write message depending on return code *****/
-   ReturnCode = WEXITSTATUS(ReturnCode);
    switch (ReturnCode)
      {
       case 0: // Message sent successfully
@@ -1682,6 +1673,12 @@ bool Mai_SendMailMsgToConfirmEmail (void)
 	                  Txt_A_message_has_been_sent_to_email_address_X_to_confirm_that_address,
 	   	          Gbl.Usrs.Me.UsrDat.Email);
          return true;
+      case Mai_MAIL_QUEUED: // Message will be sent soon
+         Gbl.Usrs.Me.ConfirmEmailJustSent = true;
+	 Ale_CreateAlert (Ale_SUCCESS,Mai_EMAIL_SECTION_ID,
+	                  Txt_A_message_will_be_sent_to_email_address_X_to_confirm_that_address,
+	   	          Gbl.Usrs.Me.UsrDat.Email);
+         return true;
       case 1:
 	 Ale_CreateAlert (Ale_ERROR,Mai_EMAIL_SECTION_ID,
 	                  Txt_There_was_a_problem_sending_an_email_automatically);
@@ -1828,6 +1825,111 @@ void Mai_CreateFileNameMail (void)
       Lay_ShowErrorAndExit ("Can not open file to send email.");
   }
 
+/*****************************************************************************/
+/********** Send the mail whose content is in temporary mail file ************/
+/*****************************************************************************/
+// Gbl.Msg.FileMail must be closed before calling this function
+// Mails with secrets that must not be stored in database
+// (for example, a new password) must be sent with Mai_SEND_NOW
+// Return 0 on success
+// Return Mai_MAIL_QUEUED if the mail is stored in queue to be sent later
+// Return code returned by the script to send mail on error
+
+int Mai_SendMailMsg (const char *To,const char *Subject,Mai_Queue_t Queue)
+  {
+   char FullSubject[Mai_MAX_BYTES_SUBJECT + 1];
+   int ReturnCode;
+
+   /***** Subject is preceded by the name of the platform *****/
+   snprintf (FullSubject,sizeof (FullSubject),
+	     "[%s] %s",
+	     Cfg_PLATFORM_SHORT_NAME,Subject);
+
+#ifdef Cfg_MAIL_QUEUE
+   if (Queue == Mai_QUEUE)
+      ReturnCode = Mai_QueueMailMsg (To,FullSubject);
+   else
+#else
+   (void) Queue;	// Without queue all mails are sent now
+#endif
+      ReturnCode = Mai_RunScriptToSendMailMsg (To,FullSubject);
+
+   /***** Remove temporary file *****/
+   unlink (Gbl.Msg.FileNameMail);
+
+   return ReturnCode;
+  }
+
+#ifdef Cfg_MAIL_QUEUE
+
+/*****************************************************************************/
+/****** Store the mail whose content is in temporary mail file in queue ******/
+/*****************************************************************************/
+
+static int Mai_QueueMailMsg (const char *To,const char *FullSubject)
+  {
+   FILE *FileMail;
+   long Length;
+   char *Content;
+
+   /***** Read mail content from file *****/
+   if ((FileMail = fopen (Gbl.Msg.FileNameMail,"rb")) == NULL)
+      Lay_ShowErrorAndExit ("Can not open file to send email.");
+   fseek (FileMail,0L,SEEK_END);
+   Length = ftell (FileMail);
+   rewind (FileMail);
+   if (Length < 0)
+      Lay_ShowErrorAndExit ("Can not read file to send email.");
+   if ((Content = (char *) malloc ((size_t) Length + 1)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   Content[fread (Content,1,(size_t) Length,FileMail)] = '\0';
+   fclose (FileMail);
+
+   /***** Store mail in queue.
+	  It will be sent by swad_mailer, reusing the connection
+	  to SMTP server for many mails *****/
+   DB_QueryINSERTprepared ("can not queue email",
+			   "INSERT INTO mail_queue"
+			   " (E_mail,Subject,Content,CreatTime,NextTry)"
+			   " VALUES"
+			   " ('%s','%s','%s',NOW(),NOW())",
+			   To,FullSubject,Content);
+   free (Content);
+
+   return Mai_MAIL_QUEUED;
+  }
+
+#endif
+
+/*****************************************************************************/
+/******** Send now the mail whose content is in temporary mail file **********/
+/*****************************************************************************/
+
+static int Mai_RunScriptToSendMailMsg (const char *To,const char *FullSubject)
+  {
+   char Command[2048 +
+		Cfg_MAX_BYTES_SMTP_PASSWORD +
+		Cns_MAX_BYTES_EMAIL_ADDRESS +
+		PATH_MAX]; // Command to execute for sending an email
+   int ReturnCode;
+
+   /***** Call the script to send an email *****/
+   snprintf (Command,sizeof (Command),
+	     "%s \"%s\" \"%s\" \"%s\" \"%s\" \"%s\" \"%s\" \"%s\"",
+	     Cfg_COMMAND_SEND_AUTOMATIC_EMAIL,
+	     Cfg_AUTOMATIC_EMAIL_SMTP_SERVER,
+	     Cfg_AUTOMATIC_EMAIL_SMTP_PORT,
+	     Cfg_AUTOMATIC_EMAIL_FROM,
+	     Gbl.Config.SMTPPassword,
+	     To,
+	     FullSubject,
+	     Gbl.Msg.FileNameMail);
+   ReturnCode = system (Command);
+   if (ReturnCode == -1)
+      Lay_ShowErrorAndExit ("Error when running script to send email.");
+   return WEXITSTATUS (ReturnCode);
+  }
+
 /*****************************************************************************/
 /************ Write a welcome note heading the automatic email ***************/
 /*****************************************************************************/
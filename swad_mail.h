@@ -53,6 +53,14 @@ struct Mail
    unsigned NumUsrs;
   };
 
+typedef enum
+  {
+   Mai_SEND_NOW,	// Mail is sent before returning (for example, with a new password)
+   Mai_QUEUE,		// Mail can be stored in queue and sent later by swad_mailer
+  } Mai_Queue_t;
+
+#define Mai_MAIL_QUEUED	(-1)	// Returned by Mai_SendMailMsg when the mail is stored in queue, not sent yet
+
 /*****************************************************************************/
 /***************************** Public prototypes *****************************/
 /*****************************************************************************/
@@ -92,6 +100,7 @@ bool Mai_SendMailMsgToConfirmEmail (void);
 void Mai_ConfirmEmail (void);
 
 void Mai_CreateFileNameMail (void);
+int Mai_SendMailMsg (const char *To,const char *Subject,Mai_Queue_t Queue);
 void Mai_WriteWelcomeNoteEMail (struct UsrData *UsrDat);
 void Mai_WriteFootNoteEMail (Lan_Language_t Language);
 
@@ -0,0 +1,245 @@
+// swad_mailer.c: send mails waiting in queue
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************* Headers ***********************************/
+/*****************************************************************************/
+
+#include <stdio.h>		// For printf
+#include <sys/time.h>		// For gettimeofday
+
+#include "swad_config.h"
+#include "swad_database.h"
+#include "swad_global.h"
+#include "swad_mailer.h"
+#include "swad_SMTP.h"
+#include "swad_string.h"
+
+/*****************************************************************************/
+/************** External global variables from others modules ****************/
+/*****************************************************************************/
+
+extern struct Globals Gbl;
+
+/*****************************************************************************/
+/***************************** Private constants *****************************/
+/*****************************************************************************/
+
+#define Mlr_LOCK "swad_mailer"	// Name of database lock to avoid two simultaneous senders
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+struct Mlr_Stats
+  {
+   unsigned NumSent;		// Mails accepted by SMTP server
+   unsigned NumPostponed;	// Mails that will be tried again later
+   unsigned NumDiscarded;	// Mails rejected or tried too many times
+  };
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void Mlr_RemoveMailFromQueue (long QueCod);
+static void Mlr_PostponeMail (long QueCod,unsigned NumTries,const char *Reply);
+
+/*****************************************************************************/
+/***************** Send mails waiting in queue in database *******************/
+/*****************************************************************************/
+/*
+   Mails are stored in mail_queue by swad
+   and sent here using the same SMTP connection for many mails.
+   When the server returns a temporary error, the mail is tried again later,
+   waiting twice as long each time.
+*/
+void Mlr_SendQueuedMails (const char *Server,const char *Port,
+                          SMTP_Security_t Security,bool Verbose)
+  {
+   struct SMTP_Connection Conn;
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned NumMails;
+   unsigned NumMail;
+   unsigned NumMailsInConnection = 0;
+   long QueCod;
+   unsigned NumTries;
+   SMTP_Result_t Result;
+   bool Connected = false;
+   bool Stop = false;
+   struct Mlr_Stats Stats =
+     {
+      .NumSent      = 0,
+      .NumPostponed = 0,
+      .NumDiscarded = 0,
+     };
+   struct timeval StartTime;
+   struct timeval EndTime;
+   double Seconds;
+
+   /***** Only one process at a time can send the mails *****/
+   if (!DB_GetLock (Mlr_LOCK))
+      return;
+
+   gettimeofday (&StartTime,NULL);
+
+   /***** Get pending mails in batches *****/
+   while (!Stop &&
+	  (NumMails = (unsigned) DB_QuerySELECT (&mysql_res,"can not get queued mails",
+						 "SELECT QueCod,"	// row[0]
+							"E_mail,"	// row[1]
+							"Subject,"	// row[2]
+							"Content,"	// row[3]
+							"NumTries"	// row[4]
+						 " FROM mail_queue"
+						 " WHERE NextTry<=NOW()"
+						 " ORDER BY QueCod"
+						 " LIMIT %u",
+						 Cfg_MAIL_QUEUE_MAILS_PER_BATCH)))
+     {
+      for (NumMail = 0;
+	   !Stop && NumMail < NumMails;
+	   NumMail++)
+	{
+	 row = mysql_fetch_row (mysql_res);
+
+	 /* Get mail code (row[0]) and number of tries (row[4]) */
+	 QueCod = Str_ConvertStrCodToLongCod (row[0]);
+	 if (sscanf (row[4],"%u",&NumTries) != 1)
+	    NumTries = 0;
+
+	 /* Many servers limit the number of mails per connection */
+	 if (Connected &&
+	     NumMailsInConnection >= Cfg_MAIL_QUEUE_MAILS_PER_CONNECTION)
+	   {
+	    SMTP_Disconnect (&Conn);
+	    Connected = false;
+	   }
+
+	 /* Open a new connection if not connected */
+	 if (!Connected)
+	   {
+	    if (SMTP_Connect (&Conn,Server,Port,Security,
+			      Cfg_AUTOMATIC_EMAIL_FROM,
+			      Gbl.Config.SMTPPassword) != SMTP_OK)
+	      {
+	       /* Server not available. Remaining mails will be sent later */
+	       if (Verbose)
+		  printf ("%s\n",Conn.Reply);
+	       Stop = true;
+	       break;
+	      }
+	    Connected = true;
+	    NumMailsInConnection = 0;
+	   }
+
+	 /* Send mail (row[1], row[2] and row[3]) */
+	 Result = SMTP_SendMail (&Conn,Cfg_AUTOMATIC_EMAIL_FROM,
+				 row[1],row[2],row[3]);
+	 NumMailsInConnection++;
+	 Connected = SMTP_CheckIfConnected (&Conn);
+
+	 /* Remove mail from queue or postpone it */
+	 switch (Result)
+	   {
+	    case SMTP_OK:
+	       Mlr_RemoveMailFromQueue (QueCod);
+	       Stats.NumSent++;
+	       break;
+	    case SMTP_TEMPORARY_ERROR:
+	       if (++NumTries < Cfg_MAIL_QUEUE_MAX_TRIES)
+		 {
+		  Mlr_PostponeMail (QueCod,NumTries,Conn.Reply);
+		  Stats.NumPostponed++;
+		 }
+	       else	// Tried too many times ==> discard it
+		 {
+		  Mlr_RemoveMailFromQueue (QueCod);
+		  Stats.NumDiscarded++;
+		 }
+	       break;
+	    case SMTP_PERMANENT_ERROR:
+	       Mlr_RemoveMailFromQueue (QueCod);
+	       Stats.NumDiscarded++;
+	       break;
+	   }
+	 if (Verbose && Result != SMTP_OK)
+	    printf ("%s\t%s\n",row[1],Conn.Reply);
+	}
+
+      /* Free structure that stores the query result */
+      DB_FreeMySQLResult (&mysql_res);
+     }
+
+   /***** Say goodbye to server *****/
+   if (Connected)
+      SMTP_Disconnect (&Conn);
+
+   /***** Release lock *****/
+   DB_ReleaseLock (Mlr_LOCK);
+
+   /***** Report throughput *****/
+   if (Verbose &&
+       (Stats.NumSent || Stats.NumPostponed || Stats.NumDiscarded))
+     {
+      gettimeofday (&EndTime,NULL);
+      Seconds = (double) (EndTime.tv_sec  - StartTime.tv_sec) +
+		(double) (EndTime.tv_usec - StartTime.tv_usec) / 1E6;
+      printf ("%u sent, %u postponed, %u discarded in %.3f s (%.1f mails/s)\n",
+	      Stats.NumSent,Stats.NumPostponed,Stats.NumDiscarded,
+	      Seconds,
+	      Seconds > 0.0 ? (double) Stats.NumSent / Seconds :
+			      0.0);
+     }
+  }
+
+/*****************************************************************************/
+/************************** Remove mail from queue ***************************/
+/*****************************************************************************/
+
+static void Mlr_RemoveMailFromQueue (long QueCod)
+  {
+   DB_QueryDELETE ("can not remove mail from queue",
+		   "DELETE FROM mail_queue WHERE QueCod=%ld",
+		   QueCod);
+  }
+
+/*****************************************************************************/
+/********************** Postpone mail after a failed try *********************/
+/*****************************************************************************/
+// Time to next try is doubled after each failed try
+
+static void Mlr_PostponeMail (long QueCod,unsigned NumTries,const char *Reply)
+  {
+   DB_QueryUPDATEprepared ("can not postpone mail",
+			   "UPDATE mail_queue"
+			   " SET NumTries=%u,"
+				"NextTry=NOW()+INTERVAL %lu SECOND,"
+				"LastReply='%s'"
+			   " WHERE QueCod=%ld",
+			   NumTries,
+			   (unsigned long) Cfg_MAIL_QUEUE_FIRST_RETRY << (NumTries - 1),
+			   Reply,
+			   QueCod);
+  }
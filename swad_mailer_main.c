@@ -0,0 +1,147 @@
+// swad_mailer_main.c: main of swad_mailer, resident program that sends mails waiting in queue
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <signal.h>		// For signal
+#include <stdbool.h>		// For boolean type
+#include <stdio.h>		// For fprintf
+#include <string.h>		// For strcmp
+#include <unistd.h>		// For sleep
+
+#include "swad_config.h"
+#include "swad_database.h"
+#include "swad_global.h"
+#include "swad_mailer.h"
+#include "swad_SMTP.h"
+#include "swad_worker.h"
+
+/*****************************************************************************/
+/************************* Private global variables **************************/
+/*****************************************************************************/
+
+static struct
+  {
+   const char *Server;
+   const char *Port;
+   SMTP_Security_t Security;
+   bool Verbose;
+  } MlM_Options =
+  {
+   .Server  = Cfg_AUTOMATIC_EMAIL_SMTP_SERVER,
+   .Port    = Cfg_AUTOMATIC_EMAIL_SMTP_PORT,
+   .Verbose = false,
+  };
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void MlM_SendQueuedMails (void);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   It must be run from the CGI directory, where swad.cfg is, for example:
+   cd /var/www/cgi-bin && ./swad_mailer -d		(as a daemon)
+   Option -v writes errors and number of mails sent per second
+   To test against a local SMTP server without TLS, for example:
+   ./swad_mailer -v -n -s 127.0.0.1 -p 2525
+   Database errors are written to standard error.
+   The daemon goes on, and it reconnects to database in the next loop
+*/
+
+int main (int argc,char *argv[])
+  {
+   bool Daemon = false;
+   bool Plain = false;
+   bool OK;
+   int NumArg;
+
+   /***** Get options *****/
+   for (NumArg = 1;
+	NumArg < argc;
+	NumArg++)
+      if (!strcmp (argv[NumArg],"-d"))
+	 Daemon = true;
+      else if (!strcmp (argv[NumArg],"-v"))
+	 MlM_Options.Verbose = true;
+      else if (!strcmp (argv[NumArg],"-n"))
+	 Plain = true;
+      else if (!strcmp (argv[NumArg],"-s") && NumArg + 1 < argc)
+	 MlM_Options.Server = argv[++NumArg];
+      else if (!strcmp (argv[NumArg],"-p") && NumArg + 1 < argc)
+	 MlM_Options.Port = argv[++NumArg];
+
+   /***** Port 465 uses TLS from the beginning, other ports use STARTTLS *****/
+   MlM_Options.Security = Plain ? SMTP_PLAIN :
+				  (strcmp (MlM_Options.Port,"465") ? SMTP_STARTTLS :
+								     SMTP_TLS);
+
+   /***** Don't die when SMTP server closes the connection *****/
+   signal (SIGPIPE,SIG_IGN);
+
+   /***** Initialize global variables and read config *****/
+   Gbl_InitializeGlobals ();
+   Cfg_GetConfigFromFile ();
+
+   /***** Send queued mails once or forever (daemon) *****/
+   for (;;)
+     {
+      if (!(OK = Wrk_RunJob (MlM_SendQueuedMails)))
+	{
+	 /* Error (already written) ==> reconnect in next loop */
+	 DB_CloseDBConnection ();
+	 if (MlM_Options.Verbose)
+	    fprintf (stderr,"Sending aborted. Database connection closed.\n");
+	}
+      if (!Daemon)
+	 break;
+
+      sleep ((unsigned) Cfg_MAIL_QUEUE_DAEMON_SLEEP);
+     }
+
+   /***** Close database connection *****/
+   DB_CloseDBConnection ();
+
+   return OK ? 0 :
+	       1;
+  }
+
+/*****************************************************************************/
+/****************** Connect to database and send queued mails ****************/
+/*****************************************************************************/
+
+static void MlM_SendQueuedMails (void)
+  {
+   /***** Open database connection,
+          or check if it is still alive and reconnect if not *****/
+   DB_OpenDBConnection ();
+
+   /***** Send queued mails *****/
+   Mlr_SendQueuedMails (MlM_Options.Server,MlM_Options.Port,
+                        MlM_Options.Security,MlM_Options.Verbose);
+  }
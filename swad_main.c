@@ -26,7 +26,6 @@
 /*****************************************************************************/
 
 #include <stddef.h>		// For NULL
-#include <stdlib.h>		// For exit
 #include <string.h>
 #include <unistd.h>		// For sleep
 
@@ -43,6 +42,7 @@
 #include "swad_parameter.h"
 #include "swad_setting.h"
 #include "swad_user.h"
+#include "swad_worker.h"
 
 /*****************************************************************************/
 /******************************** Constants **********************************/
@@ -66,11 +66,25 @@ extern struct Globals Gbl;
 /***************************** Private prototypes ****************************/
 /*****************************************************************************/
 
+static void Main_ServeRequest (void);
+
 /*****************************************************************************/
 /****************************** Main function ********************************/
 /*****************************************************************************/
 
 int main (void)
+  {
+   /***** Serve one request (CGI) or many requests (FastCGI worker) *****/
+   Wrk_ServeRequests (Main_ServeRequest);
+
+   return 0; // Control don't reach this point. Used to avoid warning.
+  }
+
+/*****************************************************************************/
+/****************************** Serve a request ******************************/
+/*****************************************************************************/
+
+static void Main_ServeRequest (void)
   {
    void (*FunctionPriori) (void);
    void (*FunctionPosteriori) (void);
@@ -96,39 +110,45 @@ int main (void)
 		      "</html>",
 	       Cfg_PLATFORM_SHORT_NAME,
 	       Cfg_PLATFORM_SHORT_NAME);
-      exit (0);
+      Wrk_EndRequest ();
      }
 
    /***** Initialize global variables *****/
    Gbl_InitializeGlobals ();
-   Cfg_GetConfigFromFile ();
+   if (!Gbl.Config.DatabasePassword[0])	// Config not read yet in this process
+      Cfg_GetConfigFromFile ();
 
-   /***** Open database connection *****/
+   /***** Mitigate DoS attacks.
+          Clicks are counted in shared memory,
+          so database is not accessed unless an IP is banned *****/
+   FW_CheckFirewallAndExitIfBanned ();
+   FW_LogAccess ();
+   FW_CheckFirewallAndExitIfTooManyRequests ();
+
+   /***** Open database connection (reused by a persistent worker) *****/
    DB_OpenDBConnection ();
 
    /***** Read parameters *****/
    if (Par_GetQueryString ())
      {
+      /***** Web service is served by gSOAP using the standard file descriptors,
+             so it must be requested to the classic CGI *****/
+      if (Gbl.WebService.IsWebService && Wrk_IsPersistent ())
+	{
+	 fprintf (stdout,"Content-type: text/plain; charset=windows-1252\n"
+			 "Status: 501 Not Implemented\r\n\r\n");
+	 Wrk_EndRequest ();
+	}
+
       /***** Get parameters *****/
       Par_CreateListOfParams ();
       Par_GetMainParameters ();
 
-      /***** Mitigate DoS attacks *****/
-      FW_CheckFirewallAndExitIfBanned ();
-      FW_LogAccess ();
-      FW_CheckFirewallAndExitIfTooManyRequests ();
-
       Hie_InitHierarchy ();
       if (!Gbl.WebService.IsWebService)
 	{
-	 /***** Create file for HTML output *****/
-	 Fil_CreateFileForHTMLOutput ();
-
-	 /***** Remove old (expired) sessions *****/
-	 Ses_RemoveExpiredSessions ();
-
-	 /***** Remove old users from connected list *****/
-	 Con_RemoveOldConnected ();
+	 /***** Create buffer for HTML output *****/
+	 Fil_CreateBufferForHTMLOutput ();
 
 	 /***** Get number of sessions *****/
 	 switch (Act_GetBrowserTab (Gbl.Action.Act))
@@ -201,6 +221,4 @@ int main (void)
 
    /***** Cleanup and exit *****/
    Lay_ShowErrorAndExit (NULL);
-
-   return 0; // Control don't reach this point. Used to avoid warning.
   }
@@ -27,6 +27,7 @@
 
 #define _GNU_SOURCE 		// For asprintf
 #include <linux/limits.h>	// For PATH_MAX
+#include <math.h>		// For lround
 #include <stddef.h>		// For NULL
 #include <stdio.h>		// For asprintf
 #include <stdlib.h>		// For calloc
@@ -40,6 +41,7 @@
 #include "swad_HTML.h"
 #include "swad_match.h"
 #include "swad_match_result.h"
+#include "swad_push.h"
 #include "swad_role.h"
 #include "swad_setting.h"
 #include "swad_test.h"
@@ -65,6 +67,19 @@ extern struct Globals Gbl;
 #define Mch_COUNTDOWN_SECONDS_MEDIUM 30
 #define Mch_COUNTDOWN_SECONDS_SMALL  10
 
+// Scores of questions are fractions whose denominators are numbers of options
+// (see Tst_ComputeScoreQst), so any total score multiplied by the least common
+// multiple of 1...Tst_MAX_OPTIONS_PER_QUESTION is an exact integer.
+// Scores in mch_scores are stored multiplied by it to be used as exact keys
+#define Mch_SCORE_DENOMINATOR 2520	// LCM (1,2,...,10)
+#if Tst_MAX_OPTIONS_PER_QUESTION > 10
+#error "Mch_SCORE_DENOMINATOR must be a multiple of 1,2,...,Tst_MAX_OPTIONS_PER_QUESTION"
+#endif
+
+// Changes of the answers of a student in a match are serialized with a named lock
+#define Mch_MAX_BYTES_ANSWERS_LOCK (9 + Cns_MAX_DECIMAL_DIGITS_LONG + 1 + Cns_MAX_DECIMAL_DIGITS_LONG)
+#define Mch_SECONDS_TO_WAIT_FOR_ANSWERS_LOCK 5
+
 /*****************************************************************************/
 /******************************* Private types *******************************/
 /*****************************************************************************/
@@ -130,6 +145,7 @@ static void Mch_RemoveMatchFromTable (long MchCod,const char *TableName);
 static void Mch_RemoveMatchesInGameFromTable (long GamCod,const char *TableName);
 static void Mch_RemoveMatchInCourseFromTable (long CrsCod,const char *TableName);
 static void Mch_RemoveUsrMchResultsInCrs (long UsrCod,long CrsCod,const char *TableName);
+static void Mch_RecomputeTalliesInCrs (long CrsCod);
 
 static void Mch_PutParamsPlay (void);
 static void Mch_PutParamMchCod (long MchCod);
@@ -143,6 +159,9 @@ static void Mch_ReorderAnswer (long MchCod,unsigned QstInd,
 			       long QstCod,bool Shuffle);
 static void Mch_CreateGrps (long MchCod);
 static void Mch_UpdateMatchStatusInDB (const struct Match *Match);
+#ifdef Cfg_MATCH_PUSH
+static void Mch_PushMatchStatusToStds (const struct Match *Match);
+#endif
 
 static void Mch_UpdateElapsedTimeInQuestion (const struct Match *Match);
 static void Mch_GetElapsedTimeInQuestion (const struct Match *Match,
@@ -220,8 +239,16 @@ static bool Mch_GetIfMatchIsBeingPlayed (long MchCod);
 static void Mch_GetNumPlayers (struct Match *Match);
 
 static void Mch_RemoveMyAnswerToMatchQuestion (const struct Match *Match);
+static void Mch_BuildNameOfMyAnswersLock (long MchCod,
+                                          char LockName[Mch_MAX_BYTES_ANSWERS_LOCK + 1]);
 
-static double Mch_ComputeScore (unsigned NumQsts);
+static void Mch_UpdateTallyAndMyResult (const struct Match *Match,
+					unsigned Indexes[Tst_MAX_OPTIONS_PER_QUESTION],
+					const struct Mch_UsrAnswer *PreviousUsrAnswer,
+					const struct Mch_UsrAnswer *UsrAnswer);
+static void Mch_ComputeScoreQst (unsigned Indexes[Tst_MAX_OPTIONS_PER_QUESTION],
+				 const struct Mch_UsrAnswer *UsrAnswer,
+				 double *ScoreThisQst,bool *AnswerIsNotBlank);
 
 static unsigned Mch_GetNumUsrsWhoHaveAnswerMch (long MchCod);
 
@@ -1027,6 +1054,8 @@ static void Mch_RemoveMatchFromAllTables (long MchCod)
    Mch_RemoveMatchFromTable (MchCod,"mch_playing");
    Mch_RemoveMatchFromTable (MchCod,"mch_results");
    Mch_RemoveMatchFromTable (MchCod,"mch_answers");
+   Mch_RemoveMatchFromTable (MchCod,"mch_tally");
+   Mch_RemoveMatchFromTable (MchCod,"mch_scores");
    Mch_RemoveMatchFromTable (MchCod,"mch_times");
    Mch_RemoveMatchFromTable (MchCod,"mch_groups");
    Mch_RemoveMatchFromTable (MchCod,"mch_indexes");
@@ -1057,6 +1086,8 @@ void Mch_RemoveMatchesInGameFromAllTables (long GamCod)
    Mch_RemoveMatchesInGameFromTable (GamCod,"mch_playing");
    Mch_RemoveMatchesInGameFromTable (GamCod,"mch_results");
    Mch_RemoveMatchesInGameFromTable (GamCod,"mch_answers");
+   Mch_RemoveMatchesInGameFromTable (GamCod,"mch_tally");
+   Mch_RemoveMatchesInGameFromTable (GamCod,"mch_scores");
    Mch_RemoveMatchesInGameFromTable (GamCod,"mch_times");
    Mch_RemoveMatchesInGameFromTable (GamCod,"mch_groups");
    Mch_RemoveMatchesInGameFromTable (GamCod,"mch_indexes");
@@ -1092,6 +1123,8 @@ void Mch_RemoveMatchInCourseFromAllTables (long CrsCod)
    Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_playing");
    Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_results");
    Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_answers");
+   Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_tally");
+   Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_scores");
    Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_times");
    Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_groups");
    Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_indexes");
@@ -1130,6 +1163,9 @@ void Mch_RemoveUsrFromMatchTablesInCrs (long UsrCod,long CrsCod)
    Mch_RemoveUsrMchResultsInCrs (UsrCod,CrsCod,"mch_players");
    Mch_RemoveUsrMchResultsInCrs (UsrCod,CrsCod,"mch_results");
    Mch_RemoveUsrMchResultsInCrs (UsrCod,CrsCod,"mch_answers");
+
+   /***** Recompute tallies of answers and scores in course *****/
+   Mch_RecomputeTalliesInCrs (CrsCod);
   }
 
 static void Mch_RemoveUsrMchResultsInCrs (long UsrCod,long CrsCod,const char *TableName)
@@ -1150,6 +1186,48 @@ static void Mch_RemoveUsrMchResultsInCrs (long UsrCod,long CrsCod,const char *Ta
 		   UsrCod);
   }
 
+/*****************************************************************************/
+/************ Recompute tallies of answers and scores in a course ************/
+/*****************************************************************************/
+// Used only after removing users, so it is not important that it is slow
+
+static void Mch_RecomputeTalliesInCrs (long CrsCod)
+  {
+   /***** Remove current tallies of all matches in course *****/
+   Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_tally");
+   Mch_RemoveMatchInCourseFromTable (CrsCod,"mch_scores");
+
+   /***** Count answers and scores again *****/
+   DB_QueryINSERT ("can not recompute tally of answers",
+		   "INSERT INTO mch_tally"
+		   " (MchCod,QstInd,AnsInd,NumUsrs)"
+		   " SELECT mch_answers.MchCod,"
+			   "mch_answers.QstInd,"
+			   "mch_answers.AnsInd,"
+			   "COUNT(*)"
+		   " FROM gam_games,mch_matches,mch_answers"
+		   " WHERE gam_games.CrsCod=%ld"
+		   " AND gam_games.GamCod=mch_matches.GamCod"
+		   " AND mch_matches.MchCod=mch_answers.MchCod"
+		   " GROUP BY mch_answers.MchCod,"
+			     "mch_answers.QstInd,"
+			     "mch_answers.AnsInd",
+		   CrsCod);
+   DB_QueryINSERT ("can not recompute tally of scores",
+		   "INSERT INTO mch_scores"
+		   " (MchCod,ScaledScore,NumUsrs)"
+		   " SELECT mch_results.MchCod,"
+			   "ROUND(mch_results.Score*%u) AS ScaledScore,"
+			   "COUNT(*)"
+		   " FROM gam_games,mch_matches,mch_results"
+		   " WHERE gam_games.CrsCod=%ld"
+		   " AND gam_games.GamCod=mch_matches.GamCod"
+		   " AND mch_matches.MchCod=mch_results.MchCod"
+		   " GROUP BY mch_results.MchCod,"
+			     "ScaledScore",
+		   (unsigned) Mch_SCORE_DENOMINATOR,CrsCod);
+  }
+
 /*****************************************************************************/
 /*********************** Params used to edit a match *************************/
 /*****************************************************************************/
@@ -1693,8 +1771,37 @@ static void Mch_UpdateMatchStatusInDB (const struct Match *Match)
    else				// Match is paused, not being played
       /* Update match as not being played */
       Mch_SetMatchAsNotBeingPlayed (Match->MchCod);
+
+#ifdef Cfg_MATCH_PUSH
+   /***** Push match status to students' browsers *****/
+   Mch_PushMatchStatusToStds (Match);
+#endif
   }
 
+/*****************************************************************************/
+/************ Push the status of a match seen by students to them ************/
+/*****************************************************************************/
+// Only the fields shown to students are included,
+// so the countdown, which changes every second, does not make them refresh
+
+#ifdef Cfg_MATCH_PUSH
+static void Mch_PushMatchStatusToStds (const struct Match *Match)
+  {
+   char Status[Psh_MAX_BYTES_STATUS + 1];
+
+   snprintf (Status,sizeof (Status),
+	     "%c,%u,%s,%u,%c",
+	     Match->Status.Playing ? 'Y' :
+				     'N',
+	     Match->Status.QstInd,
+	     Mch_ShowingStringsDB[Match->Status.Showing],
+	     Match->Status.NumCols,
+	     Match->Status.ShowQstResults ? 'Y' :
+					    'N');
+   Psh_NotifyMatchStatus (Match->MchCod,Status);
+  }
+#endif
+
 /*****************************************************************************/
 /********** Update elapsed time in current question (by a teacher) ***********/
 /*****************************************************************************/
@@ -3040,6 +3147,7 @@ static void Mch_ShowMatchScore (const struct Match *Match)
    double MaxScore;
    double Range;
    double NumRowsPerScorePoint;
+   long ScaledScore;
    double Score;
    unsigned MaxUsrs = 0;
    unsigned NumUsrs;
@@ -3054,14 +3162,13 @@ static void Mch_ShowMatchScore (const struct Match *Match)
    NumRowsPerScorePoint = (double) Mch_NUM_ROWS_SCORE / Range;
 
    /***** Get maximum number of users *****/
+   /* Number of users with each score is kept up to date
+      in mch_scores each time a student answers,
+      so mch_results is not grouped every few seconds */
    if (DB_QuerySELECT (&mysql_res,"can not get max users",
 		       "SELECT MAX(NumUsrs)"
-		       " FROM "
-		       "(SELECT COUNT(*) AS NumUsrs"	// row[1]
-		       " FROM mch_results"
-		       " WHERE MchCod=%ld"
-		       " GROUP BY Score"
-		       " ORDER BY Score) AS Scores",
+		       " FROM mch_scores"
+		       " WHERE MchCod=%ld",
 		       Match->MchCod))
      {
       row = mysql_fetch_row (mysql_res);
@@ -3079,12 +3186,12 @@ static void Mch_ShowMatchScore (const struct Match *Match)
    /***** Get scores from database *****/
    NumScores = (unsigned)
 	       DB_QuerySELECT (&mysql_res,"can not get scores",
-			       "SELECT Score,"			// row[0]
-				      "COUNT(*) AS NumUsrs"	// row[1]
-			       " FROM mch_results"
+			       "SELECT ScaledScore,"	// row[0]
+				      "NumUsrs"		// row[1]
+			       " FROM mch_scores"
 			       " WHERE MchCod=%ld"
-			       " GROUP BY Score"
-			       " ORDER BY Score DESC",
+			       " AND NumUsrs>0"
+			       " ORDER BY ScaledScore DESC",
 			       Match->MchCod);
 
    /***** Begin table ****/
@@ -3099,10 +3206,9 @@ static void Mch_ShowMatchScore (const struct Match *Match)
       row = mysql_fetch_row (mysql_res);
 
       /* Get score (row[0]) */
-      Str_SetDecimalPointToUS ();	// To get the decimal point as a dot
-      if (sscanf (row[0],"%lf",&Score) != 1)
-	 Score = 0.0;
-      Str_SetDecimalPointToLocal ();	// Return to local system
+      if (sscanf (row[0],"%ld",&ScaledScore) != 1)
+	 ScaledScore = 0;
+      Score = (double) ScaledScore / (double) Mch_SCORE_DENOMINATOR;
 
       /* Get number of users (row[1]) *****/
       if (sscanf (row[1],"%u",&NumUsrs) != 1)
@@ -3352,10 +3458,12 @@ static void Mch_RemoveOldPlayers (void)
 		   Cfg_SECONDS_TO_REFRESH_MATCH_TCH*3);
 
    /***** Delete players (students) who have left matches *****/
+   /* Timeout does not depend on students' refresh period,
+      which is longer when match status is pushed to them */
    DB_QueryDELETE ("can not update match players",
 		   "DELETE FROM mch_players"
 		   " WHERE TS<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
-		   Cfg_SECONDS_TO_REFRESH_MATCH_STD*3);
+		   (unsigned long) Cfg_SECONDS_TO_REMOVE_MATCH_PLAYER);
   }
 
 /*****************************************************************************/
@@ -3666,9 +3774,7 @@ void Mch_ReceiveQuestionAnswer (void)
    unsigned Indexes[Tst_MAX_OPTIONS_PER_QUESTION];
    struct Mch_UsrAnswer PreviousUsrAnswer;
    struct Mch_UsrAnswer UsrAnswer;
-   unsigned NumQsts;
-   unsigned NumQstsNotBlank;
-   double TotalScore;
+   char LockName[Mch_MAX_BYTES_ANSWERS_LOCK + 1];
 
    /***** Get data of the match from database *****/
    Match.MchCod = Gbl.Games.MchCodBeingPlayed;
@@ -3678,9 +3784,15 @@ void Mch_ReceiveQuestionAnswer (void)
    QstInd = Gam_GetParamQstInd ();
 
    /***** Check that teacher's screen is showing answers
-          and question index is the current one being played *****/
+          and question index is the current one being played.
+          My answers are changed by one request at a time,
+          from reading my previous answer to updating my score.
+          If the lock can not be got, the answer is not stored
+          and the student will see the answer not selected *****/
+   Mch_BuildNameOfMyAnswersLock (Match.MchCod,LockName);
    if (Match.Status.Showing == Mch_ANSWERS &&	// Teacher's screen is showing answers
-       QstInd == Match.Status.QstInd)		// Receiving an answer to the current question being played
+       QstInd == Match.Status.QstInd &&		// Receiving an answer to the current question being played
+       DB_WaitForLock (LockName,Mch_SECONDS_TO_WAIT_FOR_ANSWERS_LOCK))
      {
       /***** Get indexes for this question from database *****/
       Mch_GetIndexes (Match.MchCod,Match.Status.QstInd,Indexes);
@@ -3710,54 +3822,42 @@ void Mch_ReceiveQuestionAnswer (void)
 			   &PreviousUsrAnswer);
 
       /***** Store student's answer *****/
+      /* The answer is changed only if the previous answer is still
+	 the one read above. With the lock this is always true,
+	 but it is checked anyway, so the difference is never applied
+	 to tallies and result if the answer was not changed */
       if (UsrAnswer.NumOpt >= 0 &&
 	  UsrAnswer.AnsInd >= 0 &&
 	  UsrAnswer.AnsInd != PreviousUsrAnswer.AnsInd)
-	 DB_QueryREPLACE ("can not register your answer to the match question",
-			  "REPLACE mch_answers"
-			  " (MchCod,UsrCod,QstInd,NumOpt,AnsInd)"
-			  " VALUES"
-			  " (%ld,%ld,%u,%d,%d)",
-			  Match.MchCod,Gbl.Usrs.Me.UsrDat.UsrCod,Match.Status.QstInd,
-			  UsrAnswer.NumOpt,
-			  UsrAnswer.AnsInd);
-
-      /***** Update student's match result *****/
-      McR_GetMatchResultQuestionsFromDB (Match.MchCod,Gbl.Usrs.Me.UsrDat.UsrCod,
-					 &NumQsts,&NumQstsNotBlank);
-      TotalScore = Mch_ComputeScore (NumQsts);
-
-      Str_SetDecimalPointToUS ();	// To print the floating point as a dot
-      if (DB_QueryCOUNT ("can not get if match result exists",
-			 "SELECT COUNT(*) FROM mch_results"
-			 " WHERE MchCod=%ld AND UsrCod=%ld",
-			 Match.MchCod,Gbl.Usrs.Me.UsrDat.UsrCod))	// Result exists
-	 /* Update result */
-	 DB_QueryUPDATE ("can not update match result",
-			  "UPDATE mch_results"
-			  " SET EndTime=NOW(),"
-			       "NumQsts=%u,"
-			       "NumQstsNotBlank=%u,"
-			       "Score='%.15lg'"
-			  " WHERE MchCod=%ld AND UsrCod=%ld",
-			  NumQsts,NumQstsNotBlank,TotalScore,
-			  Match.MchCod,Gbl.Usrs.Me.UsrDat.UsrCod);
-      else								// Result doesn't exist
-	 /* Create result */
-	 DB_QueryINSERT ("can not create match result",
-			  "INSERT mch_results "
-			  "(MchCod,UsrCod,StartTime,EndTime,NumQsts,NumQstsNotBlank,Score)"
-			  " VALUES "
-			  "(%ld,"	// MchCod
-			  "%ld,"	// UsrCod
-			  "NOW(),"	// StartTime
-			  "NOW(),"	// EndTime
-			  "%u,"		// NumQsts
-			  "%u,"		// NumQstsNotBlank
-			  "'%.15lg')",	// Score
-			  Match.MchCod,Gbl.Usrs.Me.UsrDat.UsrCod,
-			  NumQsts,NumQstsNotBlank,TotalScore);
-      Str_SetDecimalPointToLocal ();	// Return to local system
+	{
+	 if (PreviousUsrAnswer.AnsInd < 0)	// No previous answer
+	    DB_QueryINSERT ("can not register your answer to the match question",
+			    "INSERT IGNORE INTO mch_answers"
+			    " (MchCod,UsrCod,QstInd,NumOpt,AnsInd)"
+			    " VALUES"
+			    " (%ld,%ld,%u,%d,%d)",
+			    Match.MchCod,Gbl.Usrs.Me.UsrDat.UsrCod,Match.Status.QstInd,
+			    UsrAnswer.NumOpt,
+			    UsrAnswer.AnsInd);
+	 else
+	    DB_QueryUPDATE ("can not register your answer to the match question",
+			    "UPDATE mch_answers"
+			    " SET NumOpt=%d,AnsInd=%d"
+			    " WHERE MchCod=%ld AND UsrCod=%ld AND QstInd=%u"
+			    " AND AnsInd=%d",
+			    UsrAnswer.NumOpt,
+			    UsrAnswer.AnsInd,
+			    Match.MchCod,Gbl.Usrs.Me.UsrDat.UsrCod,Match.Status.QstInd,
+			    PreviousUsrAnswer.AnsInd);
+
+	 /***** Update tally of answers and student's match result *****/
+	 if (mysql_affected_rows (&Gbl.mysql) == 1)	// Answer changed by this request
+	    Mch_UpdateTallyAndMyResult (&Match,Indexes,
+					&PreviousUsrAnswer,&UsrAnswer);
+	}
+
+      /***** Unlock my answers *****/
+      DB_ReleaseLock (LockName);
      }
 
    /***** Show current match status *****/
@@ -3772,46 +3872,249 @@ void Mch_ReceiveQuestionAnswer (void)
 
 static void Mch_RemoveMyAnswerToMatchQuestion (const struct Match *Match)
   {
-   DB_QueryDELETE ("can not remove your answer to the match question",
-		    "DELETE FROM mch_answers"
-		    " WHERE MchCod=%ld AND UsrCod=%ld AND QstInd=%u",
-		    Match->MchCod,Gbl.Usrs.Me.UsrDat.UsrCod,Match->Status.QstInd);
+   unsigned Indexes[Tst_MAX_OPTIONS_PER_QUESTION];
+   struct Mch_UsrAnswer PreviousUsrAnswer;
+   struct Mch_UsrAnswer NoAnswer =
+     {
+      .NumOpt = -1,	// < 0 ==> no answer selected
+      .AnsInd = -1,	// < 0 ==> no answer selected
+     };
+   char LockName[Mch_MAX_BYTES_ANSWERS_LOCK + 1];
+
+   /***** Lock my answers in this match,
+          from reading my previous answer to updating my score *****/
+   Mch_BuildNameOfMyAnswersLock (Match->MchCod,LockName);
+   if (!DB_WaitForLock (LockName,Mch_SECONDS_TO_WAIT_FOR_ANSWERS_LOCK))
+      return;
+
+   /***** Get previous student's answer to this question
+	  (<0 ==> no answer) *****/
+   Mch_GetQstAnsFromDB (Match->MchCod,Gbl.Usrs.Me.UsrDat.UsrCod,Match->Status.QstInd,
+			&PreviousUsrAnswer);
+   if (PreviousUsrAnswer.AnsInd >= 0)	// There is an answer to remove
+     {
+      /***** Remove student's answer
+	     only if it is still the previous one *****/
+      DB_QueryDELETE ("can not remove your answer to the match question",
+		       "DELETE FROM mch_answers"
+		       " WHERE MchCod=%ld AND UsrCod=%ld AND QstInd=%u"
+		       " AND AnsInd=%d",
+		       Match->MchCod,Gbl.Usrs.Me.UsrDat.UsrCod,Match->Status.QstInd,
+		       PreviousUsrAnswer.AnsInd);
+
+      /***** Update tally of answers and student's match result *****/
+      if (mysql_affected_rows (&Gbl.mysql) == 1)	// Removed by this request
+	{
+	 Mch_GetIndexes (Match->MchCod,Match->Status.QstInd,Indexes);
+	 Mch_UpdateTallyAndMyResult (Match,Indexes,
+				     &PreviousUsrAnswer,&NoAnswer);
+	}
+     }
+
+   /***** Unlock my answers *****/
+   DB_ReleaseLock (LockName);
   }
 
 /*****************************************************************************/
-/******************** Compute match score for a student **********************/
+/********* Build name of lock used to change my answers in a match ***********/
 /*****************************************************************************/
+// Named locks are shared by all databases in server, so the name begins with swad
 
-static double Mch_ComputeScore (unsigned NumQsts)
+static void Mch_BuildNameOfMyAnswersLock (long MchCod,
+                                          char LockName[Mch_MAX_BYTES_ANSWERS_LOCK + 1])
   {
-   unsigned NumQst;
+   snprintf (LockName,Mch_MAX_BYTES_ANSWERS_LOCK + 1,"swad_mch_%ld_%ld",
+	     MchCod,Gbl.Usrs.Me.UsrDat.UsrCod);
+  }
+
+/*****************************************************************************/
+/*********** Update tally of answers and my result in a match after **********/
+/*********** changing my answer to the current question            **********/
+/*****************************************************************************/
+/*
+   Instead of counting all the answers and recomputing the score
+   of all the questions each time a student answers,
+   only the difference between the previous answer and the new one
+   is applied to the counters in mch_tally and mch_scores
+   and to the student's result in mch_results.
+   The caller holds the lock of my answers in this match
+   (see Mch_BuildNameOfMyAnswersLock) since it read my previous answer,
+   so changes of my answer, tallies, result and score are serialized
+   whatever the storage engine of the tables is,
+   and the difference is applied once per change
+*/
+static void Mch_UpdateTallyAndMyResult (const struct Match *Match,
+					unsigned Indexes[Tst_MAX_OPTIONS_PER_QUESTION],
+					const struct Mch_UsrAnswer *PreviousUsrAnswer,
+					const struct Mch_UsrAnswer *UsrAnswer)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   double PreviousScoreThisQst;
    double ScoreThisQst;
+   bool PreviousAnswerIsNotBlank;
    bool AnswerIsNotBlank;
-   unsigned Indexes[Tst_MAX_OPTIONS_PER_QUESTION];	// Indexes of all answers of this question
-   bool AnswersUsr[Tst_MAX_OPTIONS_PER_QUESTION];
-   double TotalScore = 0.0;
+   unsigned NumQsts;
+   unsigned NumQstsNotBlank;
+   double PreviousTotalScore;
+   double TotalScore;
+   long PreviousScaledScore;
+   long ScaledScore;
+
+   /***** Update number of users who have chosen each answer *****/
+   if (PreviousUsrAnswer->AnsInd >= 0)
+      DB_QueryUPDATE ("can not update tally of answers",
+		      "UPDATE mch_tally SET NumUsrs=NumUsrs-1"
+		      " WHERE MchCod=%ld AND QstInd=%u AND AnsInd=%d",
+		      Match->MchCod,Match->Status.QstInd,PreviousUsrAnswer->AnsInd);
+   if (UsrAnswer->AnsInd >= 0)
+      DB_QueryINSERT ("can not update tally of answers",
+		      "INSERT INTO mch_tally"
+		      " (MchCod,QstInd,AnsInd,NumUsrs)"
+		      " VALUES"
+		      " (%ld,%u,%d,1)"
+		      " ON DUPLICATE KEY UPDATE NumUsrs=NumUsrs+1",
+		      Match->MchCod,Match->Status.QstInd,UsrAnswer->AnsInd);
+
+   /***** Compute score of previous and new answers to this question *****/
+   Tst_GetCorrectAnswersFromDB (Match->Status.QstCod);
+   Mch_ComputeScoreQst (Indexes,PreviousUsrAnswer,
+			&PreviousScoreThisQst,&PreviousAnswerIsNotBlank);
+   Mch_ComputeScoreQst (Indexes,UsrAnswer,
+			&ScoreThisQst,&AnswerIsNotBlank);
+
+   /***** Create my result in this match with score 0 if it does not exist *****/
+   if (!DB_QueryCOUNT ("can not check if match result exists",
+		       "SELECT COUNT(*)"
+		       " FROM mch_results"
+		       " WHERE MchCod=%ld AND UsrCod=%ld",
+		       Match->MchCod,Gbl.Usrs.Me.UsrDat.UsrCod))
+     {
+      /* Get number of questions in match */
+      NumQsts = (unsigned) DB_QueryCOUNT ("can not get number of questions",
+					  "SELECT COUNT(*)"
+					  " FROM mch_matches,gam_questions,mch_indexes"
+					  " WHERE mch_matches.MchCod=%ld"
+					  " AND mch_matches.GamCod=gam_questions.GamCod"
+					  " AND mch_matches.MchCod=mch_indexes.MchCod"
+					  " AND gam_questions.QstInd=mch_indexes.QstInd",
+					  Match->MchCod);
+
+      /* Create result */
+      DB_QueryINSERT ("can not create match result",
+		       "INSERT IGNORE INTO mch_results "
+		       "(MchCod,UsrCod,StartTime,EndTime,NumQsts,NumQstsNotBlank,Score)"
+		       " VALUES "
+		       "(%ld,"		// MchCod
+		       "%ld,"		// UsrCod
+		       "NOW(),"		// StartTime
+		       "NOW(),"		// EndTime
+		       "%u,"		// NumQsts
+		       "0,"		// NumQstsNotBlank
+		       "0)",		// Score
+		       Match->MchCod,Gbl.Usrs.Me.UsrDat.UsrCod,
+		       NumQsts);
+
+      /* Add me to the users with score 0 */
+      if (mysql_affected_rows (&Gbl.mysql) == 1)	// Created by this request
+	 DB_QueryINSERT ("can not update tally of scores",
+			 "INSERT INTO mch_scores"
+			 " (MchCod,ScaledScore,NumUsrs)"
+			 " VALUES"
+			 " (%ld,0,1)"
+			 " ON DUPLICATE KEY UPDATE NumUsrs=NumUsrs+1",
+			 Match->MchCod);
+     }
 
-   for (NumQst = 0;
-	NumQst < NumQsts;
-	NumQst++)
+   /***** Get my current result in this match *****/
+   if (DB_QuerySELECT (&mysql_res,"can not get match result",
+		       "SELECT NumQstsNotBlank,"	// row[0]
+			      "Score"		// row[1]
+		       " FROM mch_results"
+		       " WHERE MchCod=%ld AND UsrCod=%ld",
+		       Match->MchCod,Gbl.Usrs.Me.UsrDat.UsrCod) == 0)
      {
-      /***** Get indexes for this question from string *****/
-      Tst_GetIndexesFromStr (Gbl.Test.StrIndexesOneQst[NumQst],Indexes);
+      /* Result removed in the meantime ==> nothing to update */
+      DB_FreeMySQLResult (&mysql_res);
+      return;
+     }
+   row = mysql_fetch_row (mysql_res);
 
-      /***** Get the user's answers for this question from string *****/
-      Tst_GetAnswersFromStr (Gbl.Test.StrAnswersOneQst[NumQst],AnswersUsr);
+   /* Get number of questions not blank (row[0]) */
+   if (sscanf (row[0],"%u",&NumQstsNotBlank) != 1)
+      NumQstsNotBlank = 0;
 
-      /***** Get correct answers of test question from database *****/
-      Tst_GetCorrectAnswersFromDB (Gbl.Test.QstCodes[NumQst]);
+   /* Get score (row[1]) */
+   Str_SetDecimalPointToUS ();		// To get/print the floating point as a dot
+   if (sscanf (row[1],"%lf",&PreviousTotalScore) != 1)
+      PreviousTotalScore = 0.0;
+   DB_FreeMySQLResult (&mysql_res);
 
-      /***** Compute the total score of this question *****/
-      Tst_ComputeScoreQst (Indexes,AnswersUsr,&ScoreThisQst,&AnswerIsNotBlank);
+   /***** Apply the difference to my result *****/
+   if (PreviousAnswerIsNotBlank && NumQstsNotBlank)
+      NumQstsNotBlank--;
+   if (AnswerIsNotBlank)
+      NumQstsNotBlank++;
+   TotalScore = PreviousTotalScore - PreviousScoreThisQst + ScoreThisQst;
+
+   DB_QueryUPDATE ("can not update match result",
+		   "UPDATE mch_results"
+		   " SET EndTime=NOW(),"
+			"NumQstsNotBlank=%u,"
+			"Score='%.15lg'"
+		   " WHERE MchCod=%ld AND UsrCod=%ld",
+		   NumQstsNotBlank,TotalScore,
+		   Match->MchCod,Gbl.Usrs.Me.UsrDat.UsrCod);
+   Str_SetDecimalPointToLocal ();	// Return to local system
+
+   /***** Move me from the users with my previous score
+          to the users with my new score *****/
+   PreviousScaledScore = lround (PreviousTotalScore * (double) Mch_SCORE_DENOMINATOR);
+   ScaledScore         = lround (TotalScore         * (double) Mch_SCORE_DENOMINATOR);
+   if (ScaledScore != PreviousScaledScore)
+     {
+      DB_QueryUPDATE ("can not update tally of scores",
+		      "UPDATE mch_scores SET NumUsrs=NumUsrs-1"
+		      " WHERE MchCod=%ld AND ScaledScore=%ld",
+		      Match->MchCod,PreviousScaledScore);
+      DB_QueryINSERT ("can not update tally of scores",
+		      "INSERT INTO mch_scores"
+		      " (MchCod,ScaledScore,NumUsrs)"
+		      " VALUES"
+		      " (%ld,%ld,1)"
+		      " ON DUPLICATE KEY UPDATE NumUsrs=NumUsrs+1",
+		      Match->MchCod,ScaledScore);
+     }
+  }
 
-      /***** Compute total score *****/
-      TotalScore += ScoreThisQst;
+/*****************************************************************************/
+/******** Compute the score of an answer of a student to a question **********/
+/*****************************************************************************/
+
+static void Mch_ComputeScoreQst (unsigned Indexes[Tst_MAX_OPTIONS_PER_QUESTION],
+				 const struct Mch_UsrAnswer *UsrAnswer,
+				 double *ScoreThisQst,bool *AnswerIsNotBlank)
+  {
+   bool AnswersUsr[Tst_MAX_OPTIONS_PER_QUESTION];
+   unsigned NumOpt;
+
+   /***** No answer selected ==> blank *****/
+   if (UsrAnswer->AnsInd < 0)
+     {
+      *ScoreThisQst = 0.0;
+      *AnswerIsNotBlank = false;
+      return;
      }
 
-   return TotalScore;
+   /***** Only the answer selected by the student is marked *****/
+   for (NumOpt = 0;
+	NumOpt < Tst_MAX_OPTIONS_PER_QUESTION;
+	NumOpt++)
+      AnswersUsr[NumOpt] = false;
+   AnswersUsr[UsrAnswer->AnsInd] = true;
+
+   /***** Compute the score of this question *****/
+   Tst_ComputeScoreQst (Indexes,AnswersUsr,ScoreThisQst,AnswerIsNotBlank);
   }
 
 /*****************************************************************************/
@@ -3824,7 +4127,7 @@ unsigned Mch_GetNumUsrsWhoAnsweredQst (long MchCod,unsigned QstInd)
           a question in a match from database *****/
    return
    (unsigned) DB_QueryCOUNT ("can not get number of users who answered a question",
-			     "SELECT COUNT(*) FROM mch_answers"
+			     "SELECT COALESCE(SUM(NumUsrs),0) FROM mch_tally"
 			     " WHERE MchCod=%ld AND QstInd=%u",
 			     MchCod,QstInd);
   }
@@ -3839,7 +4142,7 @@ unsigned Mch_GetNumUsrsWhoHaveChosenAns (long MchCod,unsigned QstInd,unsigned An
           an answer of a question from database *****/
    return
    (unsigned) DB_QueryCOUNT ("can not get number of users who have chosen an answer",
-			     "SELECT COUNT(*) FROM mch_answers"
+			     "SELECT COALESCE(SUM(NumUsrs),0) FROM mch_tally"
 			     " WHERE MchCod=%ld AND QstInd=%u AND AnsInd=%u",
 			     MchCod,QstInd,AnsInd);
   }
@@ -45,6 +45,7 @@
 #include "swad_form.h"
 #include "swad_global.h"
 #include "swad_HTML.h"
+#include "swad_image.h"
 #include "swad_media.h"
 
 /*****************************************************************************/
@@ -136,8 +137,7 @@ static void Usr_GetURLFromForm (const char *ParamName,struct Media *Media);
 static void Usr_GetTitleFromForm (const char *ParamName,struct Media *Media);
 static void Med_GetAndProcessFileFromForm (const char *ParamFile,
                                            struct Media *Media);
-static bool Med_DetectIfAnimated (struct Media *Media,
-			          const char PathFileOrg[PATH_MAX + 1]);
+static bool Med_DetectIfAnimated (const char PathFileOrg[PATH_MAX + 1]);
 
 static void Med_ProcessJPG (struct Media *Media,
 			    const char PathFileOrg[PATH_MAX + 1]);
@@ -767,7 +767,7 @@ static void Med_GetAndProcessFileFromForm (const char *ParamFile,
      {
       /***** Detect if animated GIF *****/
       if (Media->Type == Med_GIF)
-	 if (!Med_DetectIfAnimated (Media,PathFileOrg))
+	 if (!Med_DetectIfAnimated (PathFileOrg))
             Media->Type = Med_JPG;
 
       /***** Process media depending on the media file extension *****/
@@ -800,42 +800,10 @@ static void Med_GetAndProcessFileFromForm (const char *ParamFile,
 // Return true if animated
 // Return false if static or error
 
-static bool Med_DetectIfAnimated (struct Media *Media,
-			          const char PathFileOrg[PATH_MAX + 1])
+static bool Med_DetectIfAnimated (const char PathFileOrg[PATH_MAX + 1])
   {
-   char PathFileTxtTmp[PATH_MAX + 1];
-   char Command[128 + PATH_MAX * 2];
-   int ReturnCode;
-   FILE *FileTxtTmp;	// Temporary file with the output of the command
-   int NumFrames = 0;
-
-   /***** Build path to temporary text file *****/
-   snprintf (PathFileTxtTmp,sizeof (PathFileTxtTmp),
-	     "%s/%s.txt",
-             Cfg_PATH_MEDIA_TMP_PRIVATE,Media->Name);
-
-   /***** Execute system command to get number of frames in GIF *****/
-   snprintf (Command,sizeof (Command),
-	     "identify -format '%%n\n' %s | head -1 > %s",
-             PathFileOrg,PathFileTxtTmp);
-   ReturnCode = system (Command);
-   if (ReturnCode == -1)
-      return false;		// Error
-   ReturnCode = WEXITSTATUS(ReturnCode);
-   if (ReturnCode != 0)
-      return false;		// Error
-
-   /***** Read temporary file *****/
-   if ((FileTxtTmp = fopen (PathFileTxtTmp,"rb")) == NULL)
-      return false;		// Error
-   if (fscanf (FileTxtTmp,"%d",&NumFrames) != 1)
-      return false;		// Error
-   fclose (FileTxtTmp);
-
-   /***** Remove temporary file *****/
-   unlink (PathFileTxtTmp);
-
-   return (NumFrames > 1);	// NumFrames > 1 ==> Animated
+   /***** Get number of frames in GIF (-1 on error) *****/
+   return (Img_GetNumFramesOfGIF (PathFileOrg) > 1);	// NumFrames > 1 ==> Animated
   }
 
 /*****************************************************************************/
@@ -985,6 +953,10 @@ static void Med_ProcessVideo (struct Media *Media,
 /*****************************************************************************/
 // Return 0 on success
 // Return != 0 on error
+// JPEG, PNG and GIF are processed in-process.
+// Other formats (TIFF, BMP...) and images that can not be decoded
+// in-process (arithmetic-coded or 12-bit JPEG...)
+// are converted by an external program.
 
 static int Med_ResizeImage (struct Media *Media,
                             const char PathFileOriginal[PATH_MAX + 1],
@@ -993,6 +965,21 @@ static int Med_ResizeImage (struct Media *Media,
    char Command[256 + PATH_MAX * 2];
    int ReturnCode;
 
+   /***** Try to decode, resize and encode in this process *****/
+   switch (Img_ResizeToJPEG (PathFileOriginal,PathFileProcessed,
+                             Media->Width,Media->Height,Media->Quality))
+     {
+      case Img_OK:
+	 return 0;
+      case Img_TOO_BIG:		// Not converted by external program either
+	 return 1;
+      case Img_UNSUPPORTED_FORMAT:
+      case Img_ERROR:
+      default:
+	 break;
+     }
+
+   /***** Call to program that makes the conversion *****/
    snprintf (Command,sizeof (Command),
 	     "convert %s -resize '%ux%u>' -quality %u %s",
              PathFileOriginal,
@@ -1013,6 +1000,8 @@ static int Med_ResizeImage (struct Media *Media,
 /*****************************************************************************/
 // Return 0 on success
 // Return != 0 on error
+// GIF is decoded in-process.
+// If it can not be decoded, the first frame is got by an external program.
 
 static int Med_GetFirstFrame (const char PathFileOriginal[PATH_MAX + 1],
                               const char PathFileProcessed[PATH_MAX + 1])
@@ -1020,6 +1009,20 @@ static int Med_GetFirstFrame (const char PathFileOriginal[PATH_MAX + 1],
    char Command[128 + PATH_MAX * 2];
    int ReturnCode;
 
+   /***** Try to decode and encode in this process *****/
+   switch (Img_GetFirstFrameOfGIF (PathFileOriginal,PathFileProcessed))
+     {
+      case Img_OK:
+	 return 0;
+      case Img_TOO_BIG:		// Not converted by external program either
+	 return 1;
+      case Img_UNSUPPORTED_FORMAT:
+      case Img_ERROR:
+      default:
+	 break;
+     }
+
+   /***** Call to program that makes the conversion *****/
    snprintf (Command,sizeof (Command),
 	     "convert '%s[0]' %s",
              PathFileOriginal,
@@ -1029,7 +1032,6 @@ static int Med_GetFirstFrame (const char PathFileOriginal[PATH_MAX + 1],
       Lay_ShowErrorAndExit ("Error when running command to process media.");
 
    ReturnCode = WEXITSTATUS(ReturnCode);
-
    return ReturnCode;
   }
 
@@ -81,6 +81,21 @@ static const Pag_WhatPaginate_t Msg_WhatPaginate[Msg_NUM_TYPES_OF_MSGS] =
 /******************************** Private types ******************************/
 /*****************************************************************************/
 
+struct Msg_MsgInPage
+  {
+   long MsgCod;
+   unsigned long MsgNum;
+   long CrsCod;			// Course origin of the message
+   long UsrCod;			// Sender
+   struct UsrData *Sender;	// Points to one of the distinct senders in the page
+   time_t CreatTimeUTC;		// Creation time of the message
+   char Subject[Cns_MAX_BYTES_SUBJECT + 1];
+   bool Deleted;		// Sent message deleted by its author
+   bool Open;
+   bool Replied;
+   bool Expanded;
+  };
+
 /*****************************************************************************/
 /***************************** Private prototypes ****************************/
 /*****************************************************************************/
@@ -102,9 +117,12 @@ static void Msg_PutHiddenParamsOneMsg (void);
 
 static void Msg_ShowFormToShowOnlyUnreadMessages (void);
 static void Msg_GetParamOnlyUnreadMsgs (void);
-static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod);
-static void Msg_GetStatusOfSentMsg (long MsgCod,bool *Expanded);
-static void Msg_GetStatusOfReceivedMsg (long MsgCod,bool *Open,bool *Replied,bool *Expanded);
+static void Msg_GetDataOfMsgsInPage (struct Msg_MsgInPage Msgs[],unsigned NumMsgs);
+static struct Msg_MsgInPage *Msg_GetMsgInPage (struct Msg_MsgInPage Msgs[],unsigned NumMsgs,
+                                               long MsgCod);
+static unsigned Msg_GetSendersOfMsgsInPage (struct Msg_MsgInPage Msgs[],unsigned NumMsgs,
+                                            struct UsrData Senders[]);
+static void Msg_ShowASentOrReceivedMessage (const struct Msg_MsgInPage *Msg);
 static long Msg_GetParamMsgCod (void);
 static void Msg_PutLinkToShowMorePotentialRecipients (void);
 static void Msg_PutParamsShowMorePotentialRecipients (void);
@@ -135,10 +153,6 @@ static bool Msg_CheckIfSentMsgIsDeleted (long MsgCod);
 static bool Msg_CheckIfReceivedMsgIsDeletedForAllItsRecipients (long MsgCod);
 static unsigned Msg_GetNumUnreadMsgs (long FilterCrsCod,const char *FilterFromToSubquery);
 
-static void Msg_GetMsgSntData (long MsgCod,long *CrsCod,long *UsrCod,
-                               time_t *CreatTimeUTC,
-                               char Subject[Cns_MAX_BYTES_SUBJECT + 1],
-                               bool *Deleted);
 static void Msg_GetMsgContent (long MsgCod,char Content[Cns_MAX_BYTES_LONG_TEXT + 1],
                                struct Media *Media);
 
@@ -1701,10 +1715,15 @@ static void Msg_ShowSentOrReceivedMessages (void)
    unsigned long NumRow;
    unsigned long NumRows;
    char *NumMsgsStr;
-   unsigned long NumMsg = 0;		// Initialized to avoid warning
    unsigned NumUnreadMsgs = 0;		// Initialized to avoid warning
    struct Pagination Pagination;
    long MsgCod;
+   struct Msg_MsgInPage Msgs[Pag_ITEMS_PER_PAGE];
+   unsigned NumMsgsInPage;
+   unsigned NumMsgInPage;
+   struct UsrData Senders[Pag_ITEMS_PER_PAGE];
+   unsigned NumSenders;
+   unsigned NumSender;
    static const Act_Action_t ActionSee[Msg_NUM_TYPES_OF_MSGS] =
      {
       [Msg_MESSAGES_RECEIVED] = ActSeeRcvMsg,
@@ -1828,24 +1847,39 @@ static void Msg_ShowSentOrReceivedMessages (void)
 				     &Pagination,
 				     0);
 
-      /***** Show received / sent messages in this page *****/
-      HTM_TABLE_BeginWidePadding (2);
-
+      /***** Get codes of the messages in this page *****/
       mysql_data_seek (mysql_res,(my_ulonglong) (Pagination.FirstItemVisible - 1));
-      for (NumRow = Pagination.FirstItemVisible;
-           NumRow <= Pagination.LastItemVisible;
-           NumRow++)
+      for (NumRow = Pagination.FirstItemVisible, NumMsgsInPage = 0;
+           NumRow <= Pagination.LastItemVisible &&
+           NumMsgsInPage < Pag_ITEMS_PER_PAGE;
+           NumRow++, NumMsgsInPage++)
         {
          row = mysql_fetch_row (mysql_res);
 
-         if (sscanf (row[0],"%ld",&MsgCod) != 1)
+         if (sscanf (row[0],"%ld",&Msgs[NumMsgsInPage].MsgCod) != 1)
             Lay_ShowErrorAndExit ("Wrong code of message when listing the messages in a page.");
-         NumMsg = NumRows - NumRow + 1;
-         Msg_ShowASentOrReceivedMessage (NumMsg,MsgCod);
+         Msgs[NumMsgsInPage].MsgNum = NumRows - NumRow + 1;
         }
 
+      /***** Get data of all the messages in this page
+             and data of their senders *****/
+      Msg_GetDataOfMsgsInPage (Msgs,NumMsgsInPage);
+      NumSenders = Msg_GetSendersOfMsgsInPage (Msgs,NumMsgsInPage,Senders);
+
+      /***** Show received / sent messages in this page *****/
+      HTM_TABLE_BeginWidePadding (2);
+      for (NumMsgInPage = 0;
+	   NumMsgInPage < NumMsgsInPage;
+	   NumMsgInPage++)
+         Msg_ShowASentOrReceivedMessage (&Msgs[NumMsgInPage]);
       HTM_TABLE_End ();
 
+      /***** Free memory used for senders' data *****/
+      for (NumSender = 0;
+	   NumSender < NumSenders;
+	   NumSender++)
+	 Usr_UsrDataDestructor (&Senders[NumSender]);
+
       /***** Write again links to pages *****/
       Pag_WriteLinksToPagesCentered (WhatPaginate[Gbl.Msg.TypeOfMessages],
 				     &Pagination,
@@ -2724,57 +2758,205 @@ static void Msg_GetParamOnlyUnreadMsgs (void)
   }
 
 /*****************************************************************************/
-/***************************** Get data of a message *************************/
+/****************** Get data of all the messages in a page *******************/
 /*****************************************************************************/
+// Msgs[NumMsg].MsgCod must be filled.
+// Only one query for all the messages in the page,
+// instead of several queries for each message
 
-static void Msg_GetMsgSntData (long MsgCod,long *CrsCod,long *UsrCod,
-                               time_t *CreatTimeUTC,
-                               char Subject[Cns_MAX_BYTES_SUBJECT + 1],
-                               bool *Deleted)
+static void Msg_GetDataOfMsgsInPage (struct Msg_MsgInPage Msgs[],unsigned NumMsgs)
   {
+   char *MsgCods;
+   char *Ptr;
    MYSQL_RES *mysql_res;
    MYSQL_ROW row;
-   unsigned long NumRows;
+   unsigned long NumRows = 0;	// Initialized to avoid warning
+   unsigned long NumRow;
+   unsigned NumMsg;
+   struct Msg_MsgInPage *Msg;
 
-   /***** Get data of message from table msg_snt *****/
-   *Deleted = false;
-   NumRows = DB_QuerySELECT (&mysql_res,"can not get data of a message",
-			     "SELECT CrsCod,UsrCod,UNIX_TIMESTAMP(CreatTime)"
-			     " FROM msg_snt WHERE MsgCod=%ld",
-			     MsgCod);
+   if (!NumMsgs)
+      return;
 
-   if (NumRows == 0)   // If not result ==> sent message is deleted
+   /***** Build the list of message codes *****/
+   if ((MsgCods = (char *) malloc (NumMsgs * (Cns_MAX_DECIMAL_DIGITS_LONG + 1) + 1)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   for (NumMsg = 0, Ptr = MsgCods;
+	NumMsg < NumMsgs;
+	NumMsg++)
+      Ptr += sprintf (Ptr,NumMsg ? ",%ld" :
+				   "%ld",
+		      Msgs[NumMsg].MsgCod);
+
+   /***** Get data of messages from database *****/
+   switch (Gbl.Msg.TypeOfMessages)
      {
-      /***** Get data of message from table msg_snt_deleted *****/
-      NumRows = DB_QuerySELECT (&mysql_res,"can not get data of a message",
-				"SELECT CrsCod,UsrCod,UNIX_TIMESTAMP(CreatTime)"
-				" FROM msg_snt_deleted WHERE MsgCod=%ld",
-				MsgCod);
-
-      *Deleted = true;
+      case Msg_MESSAGES_RECEIVED:
+	 // The sent message may have been deleted by its author.
+	 // If it appears both in msg_snt and in msg_snt_deleted
+	 // (for example after an interrupted deletion),
+	 // the row in msg_snt is used, so there is only one row per message
+	 NumRows = DB_QuerySELECT (&mysql_res,"can not get data of messages",
+				   "SELECT msg_rcv.MsgCod,"				// row[0]
+					  "COALESCE(msg_snt.CrsCod,"
+						   "msg_snt_deleted.CrsCod),"		// row[1]
+					  "COALESCE(msg_snt.UsrCod,"
+						   "msg_snt_deleted.UsrCod),"		// row[2]
+					  "UNIX_TIMESTAMP(COALESCE(msg_snt.CreatTime,"
+								  "msg_snt_deleted.CreatTime)),"	// row[3]
+					  "msg_content.Subject,"			// row[4]
+					  "IF(msg_snt.MsgCod IS NULL,'Y','N'),"		// row[5]
+					  "msg_rcv.Open,"				// row[6]
+					  "msg_rcv.Replied,"				// row[7]
+					  "msg_rcv.Expanded"				// row[8]
+				   " FROM msg_rcv"
+				   " LEFT JOIN msg_snt"
+				   " ON msg_rcv.MsgCod=msg_snt.MsgCod"
+				   " LEFT JOIN msg_snt_deleted"
+				   " ON msg_rcv.MsgCod=msg_snt_deleted.MsgCod"
+				   " LEFT JOIN msg_content"
+				   " ON msg_rcv.MsgCod=msg_content.MsgCod"
+				   " WHERE msg_rcv.MsgCod IN (%s)"
+				   " AND msg_rcv.UsrCod=%ld"
+				   " AND (msg_snt.MsgCod IS NOT NULL"
+				   " OR msg_snt_deleted.MsgCod IS NOT NULL)",
+				   MsgCods,
+				   Gbl.Usrs.Me.UsrDat.UsrCod);
+	 break;
+      case Msg_MESSAGES_SENT:
+	 // A sent message is always open and not replied
+	 NumRows = DB_QuerySELECT (&mysql_res,"can not get data of messages",
+				   "SELECT msg_snt.MsgCod,"			// row[0]
+					  "msg_snt.CrsCod,"			// row[1]
+					  "msg_snt.UsrCod,"			// row[2]
+					  "UNIX_TIMESTAMP(msg_snt.CreatTime),"	// row[3]
+					  "msg_content.Subject,"		// row[4]
+					  "'N',"				// row[5]
+					  "'Y',"				// row[6]
+					  "'N',"				// row[7]
+					  "msg_snt.Expanded"			// row[8]
+				   " FROM msg_snt"
+				   " LEFT JOIN msg_content"
+				   " ON msg_snt.MsgCod=msg_content.MsgCod"
+				   " WHERE msg_snt.MsgCod IN (%s)"
+				   " AND msg_snt.UsrCod=%ld",
+				   MsgCods,
+				   Gbl.Usrs.Me.UsrDat.UsrCod);
+	 break;
      }
 
-   /* Result should have a unique row */
-   if (NumRows != 1)
+   /***** Free list of message codes *****/
+   free (MsgCods);
+
+   /***** Result should have a row for each message *****/
+   if (NumRows != (unsigned long) NumMsgs)
       Lay_ShowErrorAndExit ("Error when getting data of a message.");
 
-   /* Get number of rows */
-   row = mysql_fetch_row (mysql_res);
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+
+      /* Get message code (row[0]) */
+      if ((Msg = Msg_GetMsgInPage (Msgs,NumMsgs,Str_ConvertStrCodToLongCod (row[0]))) == NULL)
+	 Lay_ShowErrorAndExit ("Error when getting data of a message.");
+
+      /* Get location (row[1]) */
+      Msg->CrsCod = Str_ConvertStrCodToLongCod (row[1]);
 
-   /* Get location (row[0]) */
-   *CrsCod = Str_ConvertStrCodToLongCod (row[0]);
+      /* Get author code (row[2]) */
+      Msg->UsrCod = Str_ConvertStrCodToLongCod (row[2]);
 
-   /* Get author code (row[1]) */
-   *UsrCod = Str_ConvertStrCodToLongCod (row[1]);
+      /* Get creation time (row[3]) */
+      Msg->CreatTimeUTC = Dat_GetUNIXTimeFromStr (row[3]);
+
+      /* Get subject (row[4]) */
+      if (row[4])
+	 Str_Copy (Msg->Subject,row[4],
+		   Cns_MAX_BYTES_SUBJECT);
+      else
+	 Msg->Subject[0] = '\0';
 
-   /* Get creation time (row[2]) */
-   *CreatTimeUTC = Dat_GetUNIXTimeFromStr (row[2]);
+      /* Get if sent message is deleted (row[5]) */
+      Msg->Deleted  = (row[5][0] == 'Y');
+
+      /* Get if message has been read by me (row[6]) */
+      Msg->Open     = (row[6][0] == 'Y');
+
+      /* Get if message has been replied (row[7]) */
+      Msg->Replied  = (row[7][0] == 'Y');
+
+      /* Get if message is expanded (row[8]) */
+      Msg->Expanded = (row[8][0] == 'Y');
+     }
 
-   /* Free structure that stores the query result */
+   /***** Free structure that stores the query result *****/
    DB_FreeMySQLResult (&mysql_res);
+  }
 
-   /***** Get subject of message from database *****/
-   Msg_GetMsgSubject (MsgCod,Subject);
+/*****************************************************************************/
+/******************* Find a message in the list of a page ********************/
+/*****************************************************************************/
+// Return NULL if not found
+
+static struct Msg_MsgInPage *Msg_GetMsgInPage (struct Msg_MsgInPage Msgs[],unsigned NumMsgs,
+                                               long MsgCod)
+  {
+   unsigned NumMsg;
+
+   for (NumMsg = 0;
+	NumMsg < NumMsgs;
+	NumMsg++)
+      if (Msgs[NumMsg].MsgCod == MsgCod)
+	 return &Msgs[NumMsg];
+
+   return NULL;
+  }
+
+/*****************************************************************************/
+/************* Get data of the distinct senders of messages in a page ********/
+/*****************************************************************************/
+// Data of each sender are got only once,
+// although he/she has sent several messages in the page,
+// and data of all the senders are got using only one query.
+// Return the number of distinct senders,
+// which must be freed with Usr_UsrDataDestructor
+
+static unsigned Msg_GetSendersOfMsgsInPage (struct Msg_MsgInPage Msgs[],unsigned NumMsgs,
+                                            struct UsrData Senders[])
+  {
+   unsigned NumSenders = 0;
+   unsigned NumMsg;
+   unsigned NumPrevMsg;
+
+   for (NumMsg = 0;
+	NumMsg < NumMsgs;
+	NumMsg++)
+     {
+      /***** Search the sender in previous messages *****/
+      for (NumPrevMsg = 0, Msgs[NumMsg].Sender = NULL;
+	   NumPrevMsg < NumMsg;
+	   NumPrevMsg++)
+	 if (Msgs[NumPrevMsg].UsrCod == Msgs[NumMsg].UsrCod)
+	   {
+	    Msgs[NumMsg].Sender = Msgs[NumPrevMsg].Sender;
+	    break;
+	   }
+
+      /***** New sender ==> add him/her to the list *****/
+      if (!Msgs[NumMsg].Sender)
+	{
+	 Msgs[NumMsg].Sender = &Senders[NumSenders++];
+	 Usr_UsrDataConstructor (Msgs[NumMsg].Sender);
+	 Msgs[NumMsg].Sender->UsrCod = Msgs[NumMsg].UsrCod;
+	}
+     }
+
+   /***** Get data of all the distinct senders *****/
+   Usr_GetBasicDataOfUsrs (Senders,NumSenders);
+
+   return NumSenders;
   }
 
 /*****************************************************************************/
@@ -2841,79 +3023,11 @@ static void Msg_GetMsgContent (long MsgCod,char Content[Cns_MAX_BYTES_LONG_TEXT
    DB_FreeMySQLResult (&mysql_res);
   }
 
-/*****************************************************************************/
-/********************** Get if a sent message is expanded ********************/
-/*****************************************************************************/
-
-static void Msg_GetStatusOfSentMsg (long MsgCod,bool *Expanded)
-  {
-   MYSQL_RES *mysql_res;
-   MYSQL_ROW row;
-   unsigned long NumRows;
-
-   /***** Get if sent message has been replied/expanded from database *****/
-   NumRows = DB_QuerySELECT (&mysql_res,"can not get if a sent message"
-				        " has been replied/expanded",
-			     "SELECT Expanded FROM msg_snt"
-			     " WHERE MsgCod=%ld AND UsrCod=%ld",
-			     MsgCod,Gbl.Usrs.Me.UsrDat.UsrCod);
-
-   /***** Result should have a unique row *****/
-   if (NumRows != 1)
-      Lay_ShowErrorAndExit ("Error when getting if a sent message has been replied/expanded.");
-
-   /***** Get number of rows *****/
-   row = mysql_fetch_row (mysql_res);
-
-   /***** Get if message is expanded *****/
-   *Expanded = (row[0][0] == 'Y');
-
-   /***** Free structure that stores the query result *****/
-   DB_FreeMySQLResult (&mysql_res);
-  }
-
-/*****************************************************************************/
-/***************** Get if a received message has been replied ****************/
-/*****************************************************************************/
-
-static void Msg_GetStatusOfReceivedMsg (long MsgCod,bool *Open,bool *Replied,bool *Expanded)
-  {
-   MYSQL_RES *mysql_res;
-   MYSQL_ROW row;
-   unsigned long NumRows;
-
-   /***** Get if received message has been replied/expanded from database *****/
-   NumRows = DB_QuerySELECT (&mysql_res,"can not get if a received message"
-				        " has been replied/expanded",
-			     "SELECT Open,Replied,Expanded FROM msg_rcv"
-			     " WHERE MsgCod=%ld AND UsrCod=%ld",
-			     MsgCod,Gbl.Usrs.Me.UsrDat.UsrCod);
-
-   /***** Result should have a unique row *****/
-   if (NumRows != 1)
-      Lay_ShowErrorAndExit ("Error when getting if a received message has been replied/expanded.");
-
-   /***** Get number of rows *****/
-   row = mysql_fetch_row (mysql_res);
-
-   /***** Get if message has been read by me *****/
-   *Open     = (row[0][0] == 'Y');
-
-   /***** Get if message has been replied *****/
-   *Replied  = (row[1][0] == 'Y');
-
-   /***** Get if message is expanded *****/
-   *Expanded = (row[2][0] == 'Y');
-
-   /***** Free structure that stores the query result *****/
-   DB_FreeMySQLResult (&mysql_res);
-  }
-
 /*****************************************************************************/
 /******** Show a sent or a received message (from a user to another) *********/
 /*****************************************************************************/
 
-static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod)
+static void Msg_ShowASentOrReceivedMessage (const struct Msg_MsgInPage *Msg)
   {
    extern const char *Txt_MSG_Replied;
    extern const char *Txt_MSG_Not_replied;
@@ -2927,41 +3041,18 @@ static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod)
       [Msg_MESSAGES_RECEIVED] = ActDelRcvMsg,
       [Msg_MESSAGES_SENT    ] = ActDelSntMsg,
      };
-   struct UsrData UsrDat;
    const char *Title = NULL;	// Initialized to avoid warning
    bool FromThisCrs = false;	// Initialized to avoid warning
-   time_t CreatTimeUTC;		// Creation time of a message
-   long CrsCod;
-   char Subject[Cns_MAX_BYTES_SUBJECT + 1];
    char Content[Cns_MAX_BYTES_LONG_TEXT + 1];
    struct Media Media;
-   bool Deleted;
-   bool Open = true;
-   bool Replied = false;	// Initialized to avoid warning
-   bool Expanded = false;
-
-   /***** Initialize structure with user's data *****/
-   Usr_UsrDataConstructor (&UsrDat);
-
-   /***** Get data of message *****/
-   Msg_GetMsgSntData (MsgCod,&CrsCod,&UsrDat.UsrCod,&CreatTimeUTC,Subject,&Deleted);
-   switch (Gbl.Msg.TypeOfMessages)
-     {
-      case Msg_MESSAGES_RECEIVED:
-         Msg_GetStatusOfReceivedMsg (MsgCod,&Open,&Replied,&Expanded);
-         break;
-      case Msg_MESSAGES_SENT:
-         Msg_GetStatusOfSentMsg (MsgCod,&Expanded);
-         break;
-     }
 
    /***** Put an icon with message status *****/
    switch (Gbl.Msg.TypeOfMessages)
      {
       case Msg_MESSAGES_RECEIVED:
-         Title = (Open ? (Replied ? Txt_MSG_Replied :
-                                    Txt_MSG_Not_replied) :
-                         Txt_MSG_Unopened);
+         Title = (Msg->Open ? (Msg->Replied ? Txt_MSG_Replied :
+                                              Txt_MSG_Not_replied) :
+                              Txt_MSG_Unopened);
 	 break;
       case Msg_MESSAGES_SENT:
 	 Title = Txt_MSG_Sent;
@@ -2971,43 +3062,41 @@ static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod)
    HTM_TR_Begin (NULL);
 
    HTM_TD_Begin ("class=\"CONTEXT_COL %s\"",
-		 Gbl.Msg.TypeOfMessages == Msg_MESSAGES_RECEIVED ? (Open ? "BG_MSG_BLUE" :
-									   "BG_MSG_GREEN") :
+		 Gbl.Msg.TypeOfMessages == Msg_MESSAGES_RECEIVED ? (Msg->Open ? "BG_MSG_BLUE" :
+										"BG_MSG_GREEN") :
 								   "BG_MSG_BLUE");
-   Ico_PutIcon (Gbl.Msg.TypeOfMessages == Msg_MESSAGES_RECEIVED ? (Open ? (Replied ? "reply.svg" :
-        	                                                                     "envelope-open-text.svg") :
-                                                                           "envelope.svg") :
+   Ico_PutIcon (Gbl.Msg.TypeOfMessages == Msg_MESSAGES_RECEIVED ? (Msg->Open ? (Msg->Replied ? "reply.svg" :
+        	                                                                                   "envelope-open-text.svg") :
+                                                                                "envelope.svg") :
                                                                    "share.svg",
 		Title,"ICO16x16");
 
    /***** Form to delete message *****/
    HTM_BR ();
-   Gbl.Msg.MsgCod = MsgCod;	// Message to be deleted
+   Gbl.Msg.MsgCod = Msg->MsgCod;	// Message to be deleted
    Ico_PutContextualIconToRemove (ActionDelMsg[Gbl.Msg.TypeOfMessages],
                                   Msg_PutHiddenParamsOneMsg);
    HTM_TD_End ();
 
    /***** Write message number *****/
-   Msg_WriteMsgNumber (MsgNum,!Open);
+   Msg_WriteMsgNumber (Msg->MsgNum,!Msg->Open);
 
    /***** Write message author *****/
-   Usr_ChkUsrCodAndGetAllUsrDataFromUsrCod (&UsrDat,Usr_DONT_GET_PREFS);
-
-   HTM_TD_Begin ("class=\"%s LT\"",Open ? "MSG_AUT_BG" :
-			                        "MSG_AUT_BG_NEW");
-   Msg_WriteMsgAuthor (&UsrDat,true,NULL);
+   HTM_TD_Begin ("class=\"%s LT\"",Msg->Open ? "MSG_AUT_BG" :
+			                             "MSG_AUT_BG_NEW");
+   Msg_WriteMsgAuthor (Msg->Sender,true,NULL);
    HTM_TD_End ();
 
    /***** Write subject *****/
-   Msg_WriteSentOrReceivedMsgSubject (MsgCod,Subject,Open,Expanded);
+   Msg_WriteSentOrReceivedMsgSubject (Msg->MsgCod,Msg->Subject,Msg->Open,Msg->Expanded);
 
    /***** Write date-time *****/
-   Msg_WriteMsgDate (CreatTimeUTC,Open ? "MSG_TIT_BG" :
-	                                 "MSG_TIT_BG_NEW");
+   Msg_WriteMsgDate (Msg->CreatTimeUTC,Msg->Open ? "MSG_TIT_BG" :
+	                                           "MSG_TIT_BG_NEW");
 
    HTM_TR_End ();
 
-   if (Expanded)
+   if (Msg->Expanded)
      {
       HTM_TR_Begin (NULL);
 
@@ -3017,7 +3106,7 @@ static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod)
       /***** Write course origin of message *****/
       HTM_TR_Begin (NULL);
       HTM_TD_Begin ("class=\"LM\"");
-      FromThisCrs = Msg_WriteCrsOrgMsg (CrsCod);
+      FromThisCrs = Msg_WriteCrsOrgMsg (Msg->CrsCod);
       HTM_TD_End ();
       HTM_TR_End ();
 
@@ -3027,7 +3116,7 @@ static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod)
       if (Gbl.Msg.TypeOfMessages == Msg_MESSAGES_RECEIVED &&
 	  Gbl.Usrs.Me.Role.Logged >= Rol_USR)
 	 // Guests (users without courses) can read messages but not reply them
-         Msg_WriteFormToReply (MsgCod,CrsCod,FromThisCrs,Replied,&UsrDat);
+         Msg_WriteFormToReply (Msg->MsgCod,Msg->CrsCod,FromThisCrs,Msg->Replied,Msg->Sender);
       HTM_TD_End ();
       HTM_TR_End ();
 
@@ -3040,7 +3129,7 @@ static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod)
       HTM_TD_End ();
 
       HTM_TD_Begin ("colspan=\"2\" class=\"LT\"");
-      Msg_WriteMsgFrom (&UsrDat,Deleted);
+      Msg_WriteMsgFrom (Msg->Sender,Msg->Deleted);
       HTM_TD_End ();
 
       HTM_TR_End ();
@@ -3053,7 +3142,7 @@ static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod)
       HTM_TD_End ();
 
       HTM_TD_Begin ("colspan=\"2\" class=\"LT\"");
-      Msg_WriteMsgTo (MsgCod);
+      Msg_WriteMsgTo (Msg->MsgCod);
       HTM_TD_End ();
 
       HTM_TR_End ();
@@ -3069,7 +3158,7 @@ static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod)
       Med_MediaConstructor (&Media);
 
       /***** Get message content and optional image *****/
-      Msg_GetMsgContent (MsgCod,Content,&Media);
+      Msg_GetMsgContent (Msg->MsgCod,Content,&Media);
 
       /***** Show content and image *****/
       HTM_TD_Begin ("colspan=\"2\" class=\"MSG_TXT LT\"");
@@ -3083,9 +3172,6 @@ static void Msg_ShowASentOrReceivedMessage (long MsgNum,long MsgCod)
       /***** Free image *****/
       Med_MediaDestructor (&Media);
      }
-
-   /***** Free memory used for user's data *****/
-   Usr_UsrDataDestructor (&UsrDat);
   }
 
 /*****************************************************************************/
@@ -3437,7 +3523,6 @@ static void Msg_WriteMsgTo (long MsgCod)
    struct UsrData UsrDat;
    bool Deleted;
    bool OpenByDst;
-   bool UsrValid;
    bool ShowPhoto;
    const char *Title;
    char PhotoURL[PATH_MAX + 1];
@@ -3447,42 +3532,55 @@ static void Msg_WriteMsgTo (long MsgCod)
       [Msg_MESSAGES_SENT    ] = ActSeeSntMsg,
      };
 
-   /***** Get number of recipients of a message from database *****/
+   /***** Get recipients of a message and their data from database,
+          using only one query for all the recipients.
+          Unknown recipients (removed users) are at the end *****/
    NumRecipientsTotal =
-   (unsigned) DB_QueryCOUNT ("can not get number of recipients",
-			     "SELECT "
-			     "(SELECT COUNT(*) FROM msg_rcv"
-			     " WHERE MsgCod=%ld)"
-			     " + "
-			     "(SELECT COUNT(*) FROM msg_rcv_deleted"
-			     " WHERE MsgCod=%ld)",
-			     MsgCod,MsgCod);
-
-   /***** Get recipients of a message from database *****/
-   NumRecipientsKnown =
    (unsigned) DB_QuerySELECT (&mysql_res,"can not get recipients of a message",
-			      "(SELECT msg_rcv.UsrCod,"
-				      "'N',"
-				      "msg_rcv.Open,"
-				      "usr_data.Surname1 AS S1,"
-				      "usr_data.Surname2 AS S2,"
-				      "usr_data.FirstName AS FN"
-			      " FROM msg_rcv,usr_data"
-			      " WHERE msg_rcv.MsgCod=%ld"
-			      " AND msg_rcv.UsrCod=usr_data.UsrCod)"
-			      " UNION "
-			      "(SELECT msg_rcv_deleted.UsrCod,"
-				      "'Y',"
-				      "msg_rcv_deleted.Open,"
-				      "usr_data.Surname1 AS S1,"
-				      "usr_data.Surname2 AS S2,"
-				      "usr_data.FirstName AS FN"
-			      " FROM msg_rcv_deleted,usr_data"
-			      " WHERE msg_rcv_deleted.MsgCod=%ld"
-			      " AND msg_rcv_deleted.UsrCod=usr_data.UsrCod)"
-			      " ORDER BY S1,S2,FN",
+			      "SELECT rcp.UsrCod,"			// row[ 0]
+				     "rcp.Deleted,"			// row[ 1]
+				     "rcp.Open,"			// row[ 2]
+				     "usr_data.EncryptedUsrCod,"	// row[ 3]
+				     "usr_data.Surname1,"		// row[ 4]
+				     "usr_data.Surname2,"		// row[ 5]
+				     "usr_data.FirstName,"		// row[ 6]
+				     "usr_data.Sex,"			// row[ 7]
+				     "usr_data.Photo,"			// row[ 8]
+				     "usr_data.PhotoVisibility,"	// row[ 9]
+				     "usr_data.BaPrfVisibility,"	// row[10]
+				     "usr_data.ExPrfVisibility,"	// row[11]
+				     "usr_data.CtyCod,"			// row[12]
+				     "usr_data.InsCtyCod,"		// row[13]
+				     "usr_data.InsCod,"			// row[14]
+				     "(SELECT Nickname FROM usr_nicknames"
+				     " WHERE usr_nicknames.UsrCod=usr_data.UsrCod"
+				     " ORDER BY CreatTime DESC LIMIT 1)"	// row[15]
+			      " FROM "
+			      "((SELECT UsrCod,'N' AS Deleted,Open"
+			      " FROM msg_rcv WHERE MsgCod=%ld)"
+			      " UNION ALL "
+			      "(SELECT UsrCod,'Y' AS Deleted,Open"
+			      " FROM msg_rcv_deleted WHERE MsgCod=%ld)) AS rcp"
+			      " LEFT JOIN usr_data"
+			      " ON rcp.UsrCod=usr_data.UsrCod"
+			      " ORDER BY usr_data.UsrCod IS NULL,"
+			      "usr_data.Surname1,"
+			      "usr_data.Surname2,"
+			      "usr_data.FirstName",
 			      MsgCod,MsgCod);
 
+   /***** Count known recipients *****/
+   for (NumRcp = 0, NumRecipientsKnown = 0;
+	NumRcp < NumRecipientsTotal;
+	NumRcp++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      if (row[3])	// User found in usr_data
+	 NumRecipientsKnown++;
+     }
+   if (NumRecipientsTotal)
+      mysql_data_seek (mysql_res,0);
+
    /***** Check number of recipients *****/
    if (NumRecipientsTotal)
      {
@@ -3515,8 +3613,8 @@ static void Msg_WriteMsgTo (long MsgCod)
          /* Get if message has been read by recipient */
          OpenByDst = (row[2][0] == 'Y');
 
-         /* Get user's data */
-	 UsrValid = Usr_ChkUsrCodAndGetAllUsrDataFromUsrCod (&UsrDat,Usr_DONT_GET_PREFS);
+         /* Get user's data (row[3]...row[15]) */
+	 Usr_GetUsrBasicDataFromRow (&UsrDat,&row[3]);
 
          /* Put an icon to show if user has read the message */
 	 Title = OpenByDst ? (Deleted ? Txt_MSG_Open_and_deleted :
@@ -3535,8 +3633,7 @@ static void Msg_WriteMsgTo (long MsgCod)
 
          /* Put user's photo */
          HTM_TD_Begin ("class=\"CT\" style=\"width:30px;\"");
-         ShowPhoto = (UsrValid ? Pho_ShowingUsrPhotoIsAllowed (&UsrDat,PhotoURL) :
-                                 false);
+         ShowPhoto = Pho_ShowingUsrPhotoIsAllowed (&UsrDat,PhotoURL);
          Pho_ShowUsrPhoto (&UsrDat,ShowPhoto ? PhotoURL :
                         	               NULL,
                            "PHOTO21x28",Pho_ZOOM,false);
@@ -3545,10 +3642,7 @@ static void Msg_WriteMsgTo (long MsgCod)
          /* Write user's name */
          HTM_TD_Begin ("class=\"%s LM\"",OpenByDst ? "AUTHOR_TXT" :
                 	                                      "AUTHOR_TXT_NEW");
-         if (UsrValid)
-            HTM_Txt (UsrDat.FullName);
-         else
-            HTM_TxtF ("[%s]",Txt_unknown_recipient);	// User not found, likely a user who has been removed
+         HTM_Txt (UsrDat.FullName);
          HTM_TD_End ();
 
          HTM_TR_End ();
@@ -0,0 +1,622 @@
+// swad_messages_bench_main.c: main of swad_messages_bench, queries to show pages of received messages
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <stdio.h>		// For fprintf, printf, sprintf
+#include <stdlib.h>		// For atoi, strtol
+
+#include "swad_bench.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define MsB_MSGS_PER_PAGE	10	// As Pag_ITEMS_PER_PAGE
+#define MsB_RCPS_PER_MSG	8	// Recipients of each message, including me
+#define MsB_MY_USR_COD		1
+
+#define MsB_MAX_BYTES_CODS(Num) ((Num) * (10 + 1) + 1)
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   MsB_BEFORE,	// Queries for each sender and for each recipient
+   MsB_NOW,	// One query for all senders and one for all recipients
+  } MsB_Version_t;
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void MsB_CreateTables (unsigned NumMsgs,unsigned NumUsrs);
+static double MsB_ShowMsgPages (MsB_Version_t Version,unsigned NumMsgs,
+                                unsigned NumTimes,unsigned *NumWrongPages);
+static unsigned MsB_GetMsgCodsInPage (unsigned NumPage,
+                                      long MsgCods[MsB_MSGS_PER_PAGE]);
+static unsigned long MsB_GetDataOfMsgs (MsB_Version_t Version,const char *MsgCods,
+                                        long SndCods[MsB_MSGS_PER_PAGE]);
+static void MsB_GetDataOfOneUsr (long UsrCod);
+static void MsB_GetDataOfUsrs (const char *UsrCods);
+static void MsB_GetRecipients (MsB_Version_t Version,long MsgCod);
+static void MsB_FetchAllRows (MYSQL_RES *mysql_res);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_messages_bench <host> <user> <password> <database>
+                              <messages> <users> <times>
+   I receive the given number of messages, sent by the given number of users,
+   and pages of received messages are shown the given number of times,
+   with the first message of each page expanded to show its recipients:
+   1. as before: data of each sender and of each recipient got with
+      several queries, and data of messages got with a UNION of sent
+      and deleted sent messages,
+   2. now: data of all the senders in the page got with one query,
+      recipients and their data got with one query, and data of messages
+      got preferring sent messages over deleted sent messages.
+   One out of ten messages has been deleted by its author,
+   and one out of a hundred is both in sent and in deleted sent messages.
+   For example, 50000 messages:
+      swad_messages_bench localhost swad_bench password swad_bench 50000 200 1000
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumMsgs;
+   int NumUsrs;
+   int NumTimes;
+   unsigned NumWrongPages;
+   MsB_Version_t Version;
+   static const char *Txt[] =
+     {
+      [MsB_BEFORE] = "Page of messages, queries for each user",
+      [MsB_NOW   ] = "Page of messages, queries for whole page",
+     };
+
+   if (argc != 1 + Bch_NUM_ARGS_DB + 3 ||
+       (NumMsgs  = atoi (argv[1 + Bch_NUM_ARGS_DB    ])) <= 0 ||
+       (NumUsrs  = atoi (argv[1 + Bch_NUM_ARGS_DB + 1])) <= MsB_RCPS_PER_MSG ||
+       (NumTimes = atoi (argv[1 + Bch_NUM_ARGS_DB + 2])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s " Bch_USAGE_DB
+		      " <messages> <users (> %u)> <times>\n",
+	       argv[0],MsB_RCPS_PER_MSG);
+      return 1;
+     }
+
+   Bch_ConnectToDB (&argv[1]);
+   MsB_CreateTables ((unsigned) NumMsgs,(unsigned) NumUsrs);
+
+   for (Version  = MsB_BEFORE;
+	Version <= MsB_NOW;
+	Version++)
+     {
+      Bch_WriteTime (Txt[Version],
+		     (unsigned long) NumTimes,
+		     MsB_ShowMsgPages (Version,(unsigned) NumMsgs,
+				       (unsigned) NumTimes,&NumWrongPages));
+      printf ("%u pages with a wrong number of rows\n",NumWrongPages);
+     }
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_msg_snt,bench_msg_snt_deleted,"
+	      "bench_msg_rcv,bench_msg_rcv_deleted,bench_msg_content,"
+	      "bench_usr_data,bench_usr_nicknames");
+   Bch_DisconnectFromDB ();
+   return 0;
+  }
+
+/*****************************************************************************/
+/*********************** Create tables similar to messages *******************/
+/*****************************************************************************/
+// Users are 1...NumUsrs. I am user 1.
+// Message i is sent by a user other than me to me and other users.
+// One out of five recipients other than me has deleted the message.
+
+static void MsB_CreateTables (unsigned NumMsgs,unsigned NumUsrs)
+  {
+   unsigned UsrCod;
+   unsigned MsgCod;
+   unsigned SndCod;
+   unsigned NumRcp;
+   unsigned RcpCod;
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_msg_snt,bench_msg_snt_deleted,"
+	      "bench_msg_rcv,bench_msg_rcv_deleted,bench_msg_content,"
+	      "bench_usr_data,bench_usr_nicknames");
+   Bch_Query ("CREATE TABLE bench_msg_snt ("
+		 "MsgCod INT NOT NULL,"
+		 "CrsCod INT NOT NULL DEFAULT -1,"
+		 "UsrCod INT NOT NULL,"
+		 "Expanded ENUM('N','Y') NOT NULL DEFAULT 'N',"
+		 "CreatTime DATETIME NOT NULL,"
+	      "UNIQUE INDEX(MsgCod),"
+	      "INDEX(CrsCod),"
+	      "INDEX(UsrCod))");
+   Bch_Query ("CREATE TABLE bench_msg_snt_deleted ("
+		 "MsgCod INT NOT NULL,"
+		 "CrsCod INT NOT NULL DEFAULT -1,"
+		 "UsrCod INT NOT NULL,"
+		 "CreatTime DATETIME NOT NULL,"
+	      "UNIQUE INDEX(MsgCod),"
+	      "INDEX(CrsCod),"
+	      "INDEX(UsrCod))");
+   Bch_Query ("CREATE TABLE bench_msg_rcv ("
+		 "MsgCod INT NOT NULL,"
+		 "UsrCod INT NOT NULL,"
+		 "Notified ENUM('N','Y') NOT NULL DEFAULT 'N',"
+		 "Open ENUM('N','Y') NOT NULL DEFAULT 'N',"
+		 "Replied ENUM('N','Y') NOT NULL DEFAULT 'N',"
+		 "Expanded ENUM('N','Y') NOT NULL DEFAULT 'N',"
+	      "UNIQUE INDEX(UsrCod,MsgCod),"
+	      "INDEX(MsgCod),"
+	      "INDEX(Notified))");
+   Bch_Query ("CREATE TABLE bench_msg_rcv_deleted ("
+		 "MsgCod INT NOT NULL,"
+		 "UsrCod INT NOT NULL,"
+		 "Notified ENUM('N','Y') NOT NULL DEFAULT 'N',"
+		 "Open ENUM('N','Y') NOT NULL DEFAULT 'N',"
+		 "Replied ENUM('N','Y') NOT NULL DEFAULT 'N',"
+	      "UNIQUE INDEX(UsrCod,MsgCod),"
+	      "INDEX(MsgCod),"
+	      "INDEX(Notified))");
+   Bch_Query ("CREATE TABLE bench_msg_content ("
+		 "MsgCod INT NOT NULL,"
+		 "Subject TEXT NOT NULL,"
+		 "Content LONGTEXT NOT NULL,"
+		 "MedCod INT NOT NULL DEFAULT -1,"
+	      "UNIQUE INDEX(MsgCod),"
+	      "FULLTEXT(Subject,Content)) ENGINE = MYISAM");
+   Bch_Query ("CREATE TABLE bench_usr_data ("
+		 "UsrCod INT NOT NULL,"
+		 "EncryptedUsrCod CHAR(43) NOT NULL,"
+		 "Surname1 VARCHAR(511) NOT NULL,"
+		 "Surname2 VARCHAR(511) NOT NULL,"
+		 "FirstName VARCHAR(511) NOT NULL,"
+		 "Sex ENUM('unknown','female','male') NOT NULL DEFAULT 'unknown',"
+		 "Photo CHAR(43) NOT NULL,"
+		 "PhotoVisibility ENUM('unknown','user','course','system','world') NOT NULL DEFAULT 'unknown',"
+		 "BaPrfVisibility ENUM('unknown','user','course','system','world') NOT NULL DEFAULT 'unknown',"
+		 "ExPrfVisibility ENUM('unknown','user','course','system','world') NOT NULL DEFAULT 'unknown',"
+		 "CtyCod INT NOT NULL DEFAULT -1,"
+		 "InsCtyCod INT NOT NULL DEFAULT -1,"
+		 "InsCod INT NOT NULL DEFAULT -1,"
+		 "Comments TEXT NOT NULL,"
+	      "UNIQUE INDEX(UsrCod),"
+	      "UNIQUE INDEX(EncryptedUsrCod))");
+   Bch_Query ("CREATE TABLE bench_usr_nicknames ("
+		 "UsrCod INT NOT NULL,"
+		 "Nickname CHAR(16) NOT NULL,"
+		 "CreatTime DATETIME NOT NULL,"
+	      "UNIQUE INDEX(UsrCod,Nickname),"
+	      "UNIQUE INDEX(Nickname))");
+
+   /***** Users *****/
+   for (UsrCod  = 1;
+	UsrCod <= NumUsrs;
+	UsrCod++)
+     {
+      Bch_Query ("INSERT INTO bench_usr_data"
+		 " (UsrCod,EncryptedUsrCod,Surname1,Surname2,FirstName,Sex,"
+		 "Photo,PhotoVisibility,BaPrfVisibility,ExPrfVisibility,"
+		 "CtyCod,InsCtyCod,InsCod,Comments)"
+		 " VALUES"
+		 " (%u,'EncryptedUsrCod%u','Surname1 %u','Surname2 %u',"
+		 "'FirstName %u','%s',"
+		 "'Photo%u','course','course','user',"
+		 "724,724,%u,'')",
+		 UsrCod,UsrCod,UsrCod,UsrCod,
+		 UsrCod,UsrCod % 2 ? "female" :
+				     "male",
+		 UsrCod,UsrCod % 10 + 1);
+      Bch_Query ("INSERT INTO bench_usr_nicknames (UsrCod,Nickname,CreatTime)"
+		 " VALUES (%u,'nick%u',NOW())",
+		 UsrCod,UsrCod);
+     }
+
+   /***** Messages *****/
+   for (MsgCod  = 1;
+	MsgCod <= NumMsgs;
+	MsgCod++)
+     {
+      SndCod = MsgCod % (NumUsrs - 1) + 2;	// Not me
+
+      /* Sent message, maybe deleted by its author */
+      if (MsgCod % 10 == 0 || MsgCod % 100 == 1)
+	 Bch_Query ("INSERT INTO bench_msg_snt_deleted"
+		    " (MsgCod,CrsCod,UsrCod,CreatTime)"
+		    " VALUES"
+		    " (%u,-1,%u,NOW()-INTERVAL %u MINUTE)",
+		    MsgCod,SndCod,NumMsgs - MsgCod + 1);
+      if (MsgCod % 10)
+	 Bch_Query ("INSERT INTO bench_msg_snt"
+		    " (MsgCod,CrsCod,UsrCod,Expanded,CreatTime)"
+		    " VALUES"
+		    " (%u,-1,%u,'N',NOW()-INTERVAL %u MINUTE)",
+		    MsgCod,SndCod,NumMsgs - MsgCod + 1);
+
+      /* Content */
+      Bch_Query ("INSERT INTO bench_msg_content (MsgCod,Subject,Content)"
+		 " VALUES (%u,'Subject of message %u','Content of message %u')",
+		 MsgCod,MsgCod,MsgCod);
+
+      /* Recipients: me and other users who are not the sender */
+      Bch_Query ("INSERT INTO bench_msg_rcv"
+		 " (MsgCod,UsrCod,Open,Replied,Expanded)"
+		 " VALUES"
+		 " (%u,%u,'%c','N','N')",
+		 MsgCod,MsB_MY_USR_COD,MsgCod % 3 ? 'Y' :
+						    'N');
+      for (NumRcp = 1;
+	   NumRcp < MsB_RCPS_PER_MSG;
+	   NumRcp++)
+	{
+	 RcpCod = (SndCod - 2 + NumRcp) % (NumUsrs - 1) + 2;
+	 Bch_Query ("INSERT INTO %s"
+		    " (MsgCod,UsrCod,Open,Replied)"
+		    " VALUES"
+		    " (%u,%u,'Y','N')",
+		    NumRcp % 5 ? "bench_msg_rcv" :
+				 "bench_msg_rcv_deleted",
+		    MsgCod,RcpCod);
+	}
+     }
+  }
+
+/*****************************************************************************/
+/******** Show pages of received messages several times and return time ******/
+/*****************************************************************************/
+// Each time, a different page
+
+static double MsB_ShowMsgPages (MsB_Version_t Version,unsigned NumMsgs,
+                                unsigned NumTimes,unsigned *NumWrongPages)
+  {
+   unsigned NumPages = (NumMsgs + MsB_MSGS_PER_PAGE - 1) / MsB_MSGS_PER_PAGE;
+   unsigned NumTime;
+   long MsgCods[MsB_MSGS_PER_PAGE];
+   long SndCods[MsB_MSGS_PER_PAGE];
+   unsigned NumMsgsInPage;
+   unsigned NumMsg;
+   unsigned NumPrevMsg;
+   unsigned NumSnds;
+   char StrMsgCods[MsB_MAX_BYTES_CODS (MsB_MSGS_PER_PAGE)];
+   char StrSndCods[MsB_MAX_BYTES_CODS (MsB_MSGS_PER_PAGE)];
+   char *PtrMsg;
+   char *PtrSnd;
+   double Start = Bch_GetSeconds ();
+
+   *NumWrongPages = 0;
+
+   for (NumTime = 0;
+	NumTime < NumTimes;
+	NumTime++)
+     {
+      /***** Get messages in page *****/
+      if (!(NumMsgsInPage = MsB_GetMsgCodsInPage (NumTime % NumPages,MsgCods)))
+	 continue;
+      for (NumMsg = 0, PtrMsg = StrMsgCods;
+	   NumMsg < NumMsgsInPage;
+	   NumMsg++)
+	 PtrMsg += sprintf (PtrMsg,NumMsg ? ",%ld" :
+					    "%ld",
+			    MsgCods[NumMsg]);
+
+      /***** Get data of messages *****/
+      if (MsB_GetDataOfMsgs (Version,StrMsgCods,SndCods) != NumMsgsInPage)
+	 (*NumWrongPages)++;
+
+      /***** Get data of distinct senders *****/
+      for (NumMsg = 0, NumSnds = 0, PtrSnd = StrSndCods;
+	   NumMsg < NumMsgsInPage;
+	   NumMsg++)
+	{
+	 for (NumPrevMsg = 0;
+	      NumPrevMsg < NumMsg;
+	      NumPrevMsg++)
+	    if (SndCods[NumPrevMsg] == SndCods[NumMsg])
+	       break;
+	 if (NumPrevMsg == NumMsg)	// New sender
+	    switch (Version)
+	      {
+	       case MsB_BEFORE:
+		  MsB_GetDataOfOneUsr (SndCods[NumMsg]);
+		  break;
+	       case MsB_NOW:
+		  PtrSnd += sprintf (PtrSnd,NumSnds++ ? ",%ld" :
+							"%ld",
+				     SndCods[NumMsg]);
+		  break;
+	      }
+	}
+      if (NumSnds)
+	 MsB_GetDataOfUsrs (StrSndCods);
+
+      /***** First message is expanded ==> get its recipients *****/
+      MsB_GetRecipients (Version,MsgCods[0]);
+     }
+
+   return Bch_GetSeconds () - Start;
+  }
+
+/*****************************************************************************/
+/************* Get codes of the messages in a page of received ***************/
+/*****************************************************************************/
+
+static unsigned MsB_GetMsgCodsInPage (unsigned NumPage,
+                                      long MsgCods[MsB_MSGS_PER_PAGE])
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows;
+   unsigned long NumRow;
+
+   NumRows = Bch_QuerySELECT (&mysql_res,
+			      "SELECT MsgCod FROM bench_msg_rcv"
+			      " WHERE UsrCod=%u"
+			      " ORDER BY MsgCod DESC"
+			      " LIMIT %u,%u",
+			      MsB_MY_USR_COD,
+			      NumPage * MsB_MSGS_PER_PAGE,MsB_MSGS_PER_PAGE);
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      MsgCods[NumRow] = strtol (row[0],NULL,10);
+     }
+   mysql_free_result (mysql_res);
+
+   return (unsigned) NumRows;
+  }
+
+/*****************************************************************************/
+/********* Get data of all the messages in a page with only one query ********/
+/*****************************************************************************/
+// Return the number of rows, which should be the number of messages
+
+static unsigned long MsB_GetDataOfMsgs (MsB_Version_t Version,const char *MsgCods,
+                                        long SndCods[MsB_MSGS_PER_PAGE])
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows = 0;
+   unsigned long NumRow;
+
+   switch (Version)
+     {
+      case MsB_BEFORE:
+	 NumRows = Bch_QuerySELECT (&mysql_res,
+				    "SELECT bench_msg_rcv.MsgCod,snt.CrsCod,snt.UsrCod,"
+				    "UNIX_TIMESTAMP(snt.CreatTime),"
+				    "bench_msg_content.Subject,snt.Deleted,"
+				    "bench_msg_rcv.Open,bench_msg_rcv.Replied,"
+				    "bench_msg_rcv.Expanded"
+				    " FROM bench_msg_rcv"
+				    " JOIN"
+				    " ((SELECT MsgCod,CrsCod,UsrCod,CreatTime,'N' AS Deleted"
+				    " FROM bench_msg_snt WHERE MsgCod IN (%s))"
+				    " UNION"
+				    " (SELECT MsgCod,CrsCod,UsrCod,CreatTime,'Y' AS Deleted"
+				    " FROM bench_msg_snt_deleted WHERE MsgCod IN (%s))) AS snt"
+				    " ON bench_msg_rcv.MsgCod=snt.MsgCod"
+				    " LEFT JOIN bench_msg_content"
+				    " ON bench_msg_rcv.MsgCod=bench_msg_content.MsgCod"
+				    " WHERE bench_msg_rcv.MsgCod IN (%s)"
+				    " AND bench_msg_rcv.UsrCod=%u",
+				    MsgCods,MsgCods,MsgCods,
+				    MsB_MY_USR_COD);
+	 break;
+      case MsB_NOW:
+	 NumRows = Bch_QuerySELECT (&mysql_res,
+				    "SELECT bench_msg_rcv.MsgCod,"
+				    "COALESCE(bench_msg_snt.CrsCod,"
+				    "bench_msg_snt_deleted.CrsCod),"
+				    "COALESCE(bench_msg_snt.UsrCod,"
+				    "bench_msg_snt_deleted.UsrCod),"
+				    "UNIX_TIMESTAMP(COALESCE(bench_msg_snt.CreatTime,"
+				    "bench_msg_snt_deleted.CreatTime)),"
+				    "bench_msg_content.Subject,"
+				    "IF(bench_msg_snt.MsgCod IS NULL,'Y','N'),"
+				    "bench_msg_rcv.Open,bench_msg_rcv.Replied,"
+				    "bench_msg_rcv.Expanded"
+				    " FROM bench_msg_rcv"
+				    " LEFT JOIN bench_msg_snt"
+				    " ON bench_msg_rcv.MsgCod=bench_msg_snt.MsgCod"
+				    " LEFT JOIN bench_msg_snt_deleted"
+				    " ON bench_msg_rcv.MsgCod=bench_msg_snt_deleted.MsgCod"
+				    " LEFT JOIN bench_msg_content"
+				    " ON bench_msg_rcv.MsgCod=bench_msg_content.MsgCod"
+				    " WHERE bench_msg_rcv.MsgCod IN (%s)"
+				    " AND bench_msg_rcv.UsrCod=%u"
+				    " AND (bench_msg_snt.MsgCod IS NOT NULL"
+				    " OR bench_msg_snt_deleted.MsgCod IS NOT NULL)",
+				    MsgCods,
+				    MsB_MY_USR_COD);
+	 break;
+     }
+
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      if (NumRow < MsB_MSGS_PER_PAGE)
+	 SndCods[NumRow] = strtol (row[2],NULL,10);
+     }
+   mysql_free_result (mysql_res);
+
+   return NumRows;
+  }
+
+/*****************************************************************************/
+/*********** Get data of one user, as before, with several queries ***********/
+/*****************************************************************************/
+// Check if user exists, get all his/her data and his/her nickname
+
+static void MsB_GetDataOfOneUsr (long UsrCod)
+  {
+   MYSQL_RES *mysql_res;
+
+   if (Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_usr_data"
+		       " WHERE UsrCod=%ld",
+		       UsrCod))
+     {
+      Bch_QuerySELECT (&mysql_res,
+		       "SELECT EncryptedUsrCod,Surname1,Surname2,FirstName,Sex,"
+		       "Photo,PhotoVisibility,BaPrfVisibility,ExPrfVisibility,"
+		       "CtyCod,InsCtyCod,InsCod,Comments"
+		       " FROM bench_usr_data WHERE UsrCod=%ld",
+		       UsrCod);
+      MsB_FetchAllRows (mysql_res);
+
+      Bch_QuerySELECT (&mysql_res,
+		       "SELECT Nickname FROM bench_usr_nicknames"
+		       " WHERE UsrCod=%ld ORDER BY CreatTime DESC LIMIT 1",
+		       UsrCod);
+      MsB_FetchAllRows (mysql_res);
+     }
+  }
+
+/*****************************************************************************/
+/**************** Get basic data of several users in one query ***************/
+/*****************************************************************************/
+
+static void MsB_GetDataOfUsrs (const char *UsrCods)
+  {
+   MYSQL_RES *mysql_res;
+
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT UsrCod,EncryptedUsrCod,Surname1,Surname2,FirstName,Sex,"
+		    "Photo,PhotoVisibility,BaPrfVisibility,ExPrfVisibility,"
+		    "CtyCod,InsCtyCod,InsCod,"
+		    "(SELECT Nickname FROM bench_usr_nicknames"
+		    " WHERE bench_usr_nicknames.UsrCod=bench_usr_data.UsrCod"
+		    " ORDER BY CreatTime DESC LIMIT 1)"
+		    " FROM bench_usr_data"
+		    " WHERE UsrCod IN (%s)",
+		    UsrCods);
+   MsB_FetchAllRows (mysql_res);
+  }
+
+/*****************************************************************************/
+/************** Get recipients of an expanded message and their data *********/
+/*****************************************************************************/
+
+static void MsB_GetRecipients (MsB_Version_t Version,long MsgCod)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows;
+   unsigned long NumRow;
+   long RcpCods[MsB_RCPS_PER_MSG];
+
+   switch (Version)
+     {
+      case MsB_BEFORE:
+	 Bch_QueryCOUNT ("SELECT "
+			 "(SELECT COUNT(*) FROM bench_msg_rcv"
+			 " WHERE MsgCod=%ld)"
+			 " + "
+			 "(SELECT COUNT(*) FROM bench_msg_rcv_deleted"
+			 " WHERE MsgCod=%ld)",
+			 MsgCod,MsgCod);
+	 NumRows = Bch_QuerySELECT (&mysql_res,
+				    "(SELECT bench_msg_rcv.UsrCod,'N',bench_msg_rcv.Open,"
+				    "bench_usr_data.Surname1 AS S1,"
+				    "bench_usr_data.Surname2 AS S2,"
+				    "bench_usr_data.FirstName AS FN"
+				    " FROM bench_msg_rcv,bench_usr_data"
+				    " WHERE bench_msg_rcv.MsgCod=%ld"
+				    " AND bench_msg_rcv.UsrCod=bench_usr_data.UsrCod)"
+				    " UNION "
+				    "(SELECT bench_msg_rcv_deleted.UsrCod,'Y',"
+				    "bench_msg_rcv_deleted.Open,"
+				    "bench_usr_data.Surname1 AS S1,"
+				    "bench_usr_data.Surname2 AS S2,"
+				    "bench_usr_data.FirstName AS FN"
+				    " FROM bench_msg_rcv_deleted,bench_usr_data"
+				    " WHERE bench_msg_rcv_deleted.MsgCod=%ld"
+				    " AND bench_msg_rcv_deleted.UsrCod=bench_usr_data.UsrCod)"
+				    " ORDER BY S1,S2,FN",
+				    MsgCod,MsgCod);
+	 for (NumRow = 0;
+	      NumRow < NumRows;
+	      NumRow++)
+	   {
+	    row = mysql_fetch_row (mysql_res);
+	    if (NumRow < MsB_RCPS_PER_MSG)
+	       RcpCods[NumRow] = strtol (row[0],NULL,10);
+	   }
+	 mysql_free_result (mysql_res);
+
+	 for (NumRow = 0;
+	      NumRow < NumRows && NumRow < MsB_RCPS_PER_MSG;
+	      NumRow++)
+	    MsB_GetDataOfOneUsr (RcpCods[NumRow]);
+	 break;
+      case MsB_NOW:
+	 Bch_QuerySELECT (&mysql_res,
+			  "SELECT rcp.UsrCod,rcp.Deleted,rcp.Open,"
+			  "bench_usr_data.EncryptedUsrCod,"
+			  "bench_usr_data.Surname1,bench_usr_data.Surname2,"
+			  "bench_usr_data.FirstName,bench_usr_data.Sex,"
+			  "bench_usr_data.Photo,bench_usr_data.PhotoVisibility,"
+			  "bench_usr_data.BaPrfVisibility,bench_usr_data.ExPrfVisibility,"
+			  "bench_usr_data.CtyCod,bench_usr_data.InsCtyCod,"
+			  "bench_usr_data.InsCod,"
+			  "(SELECT Nickname FROM bench_usr_nicknames"
+			  " WHERE bench_usr_nicknames.UsrCod=bench_usr_data.UsrCod"
+			  " ORDER BY CreatTime DESC LIMIT 1)"
+			  " FROM "
+			  "((SELECT UsrCod,'N' AS Deleted,Open"
+			  " FROM bench_msg_rcv WHERE MsgCod=%ld)"
+			  " UNION ALL "
+			  "(SELECT UsrCod,'Y' AS Deleted,Open"
+			  " FROM bench_msg_rcv_deleted WHERE MsgCod=%ld)) AS rcp"
+			  " LEFT JOIN bench_usr_data"
+			  " ON rcp.UsrCod=bench_usr_data.UsrCod"
+			  " ORDER BY bench_usr_data.UsrCod IS NULL,"
+			  "bench_usr_data.Surname1,"
+			  "bench_usr_data.Surname2,"
+			  "bench_usr_data.FirstName",
+			  MsgCod,MsgCod);
+	 MsB_FetchAllRows (mysql_res);
+	 break;
+     }
+  }
+
+/*****************************************************************************/
+/********************* Fetch all rows and free result ************************/
+/*****************************************************************************/
+
+static void MsB_FetchAllRows (MYSQL_RES *mysql_res)
+  {
+   while (mysql_fetch_row (mysql_res));
+   mysql_free_result (mysql_res);
+  }
@@ -0,0 +1,413 @@
+// swad_multipart.c: streaming parser of multipart/form-data
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************** Headers **********************************/
+/*****************************************************************************/
+
+#define _GNU_SOURCE 		// For memmem
+#include <stdlib.h>		// For malloc, free
+#include <string.h>		// For string functions
+#include <strings.h>		// For strncasecmp
+
+#include "swad_multipart.h"
+
+/*****************************************************************************/
+/***************************** Private constants *****************************/
+/*****************************************************************************/
+
+#define Mpt_NOT_FOUND ((size_t) -1)
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static bool Mpt_ReadBlock (struct Mpt_Parser *Parser);
+static size_t Mpt_FindBoundary (const struct Mpt_Parser *Parser);
+static Mpt_Status_t Mpt_Finish (struct Mpt_Parser *Parser);
+static void Mpt_ParseHeaderLine (const char *Line,size_t Length,
+                                 struct Mpt_Header *Header);
+static bool Mpt_GetQuotedParam (const char **Ptr,const char *End,
+                                const char *Key,
+                                const char **Value,size_t *Length);
+
+/*****************************************************************************/
+/***************** Check length of boundary "\r\n--..." ******************/
+/*****************************************************************************/
+
+bool Mpt_CheckBoundary (size_t BoundaryLength)
+  {
+   return BoundaryLength >= 2 + 2 + 1 &&
+	  BoundaryLength <= Mpt_MAX_BYTES_BOUNDARY;
+  }
+
+/*****************************************************************************/
+/************************ Begin parsing multipart data ***********************/
+/*****************************************************************************/
+/*
+   Input is read in large blocks and boundaries are searched in memory
+   with Boyer-Moore-Horspool, so the data of each part can be handed
+   directly to its destination without intermediate copies.
+   Return false on error (wrong boundary or not enough memory)
+*/
+
+bool Mpt_BeginParsing (struct Mpt_Parser *Parser,FILE *In,
+                       const char *BoundaryWithCRLF,size_t BoundaryLength,
+                       unsigned long long MaxBytes,time_t Deadline)
+  {
+   unsigned Ch;
+   size_t i;
+
+   /***** Check boundary "\r\n--..." *****/
+   if (!Mpt_CheckBoundary (BoundaryLength))
+      return false;
+
+   /***** Horspool table: how much to move forward
+	  depending on the last byte compared *****/
+   memcpy (Parser->Boundary,BoundaryWithCRLF,BoundaryLength);
+   Parser->Boundary[BoundaryLength] = '\0';
+   Parser->BoundaryLength = BoundaryLength;
+   for (Ch = 0;
+	Ch < 256;
+	Ch++)
+      Parser->Skip[Ch] = BoundaryLength;
+   for (i = 0;
+	i < BoundaryLength - 1;
+	i++)
+      Parser->Skip[(unsigned char) BoundaryWithCRLF[i]] = BoundaryLength - 1 - i;
+
+   /***** Allocate block *****/
+   if ((Parser->Block = (char *) malloc (Mpt_NUM_BYTES_PER_BLOCK)) == NULL)
+      return false;
+
+   /***** Input starts with "--" and boundary, without "\r\n".
+	  Put "\r\n" at start so that first boundary is like the others *****/
+   Parser->Block[0] = 0x0D;	// '\r'
+   Parser->Block[1] = 0x0A;	// '\n'
+   Parser->Start = 0;
+   Parser->End   = 2;
+
+   /***** Initialize the rest of the parser *****/
+   Parser->In           = In;
+   Parser->EndOfInput   = false;
+   Parser->InPart       = true;		// Preamble before first boundary is skipped as a part
+   Parser->Finished     = false;
+   Parser->FinalBoundary = false;
+   Parser->NumBytesRead = 0;
+   Parser->MaxBytes     = MaxBytes;
+   Parser->Deadline     = Deadline;
+   Parser->Error        = Mpt_OK;
+
+   return true;
+  }
+
+/*****************************************************************************/
+/*************************** Get next part of data ***************************/
+/*****************************************************************************/
+// Pending data of current part are skipped
+
+Mpt_Status_t Mpt_GetNextPart (struct Mpt_Parser *Parser,struct Mpt_Header *Header)
+  {
+   Mpt_Status_t Status;
+   const char *Data;
+   size_t Length;
+   const char *HeadersEnd;
+   const char *Line;
+   const char *LinesEnd;
+   const char *EndOfLine;
+
+   /***** Reset header *****/
+   memset (Header,0,sizeof (*Header));
+
+   /***** Skip pending data of current part *****/
+   while (Parser->InPart)
+      if ((Status = Mpt_GetDataOfPart (Parser,&Data,&Length)) != Mpt_OK &&
+	  Status != Mpt_END_OF_PART)
+	 return Status;
+   if (Parser->Finished)
+      return Mpt_Finish (Parser);
+
+   /***** Just after boundary, "--" means final boundary.
+	  Otherwise, headers end in an empty line *****/
+   for (;;)
+     {
+      if (Parser->End - Parser->Start >= 2 &&
+	  Parser->Block[Parser->Start    ] == '-' &&
+	  Parser->Block[Parser->Start + 1] == '-')
+	{
+	 Parser->FinalBoundary = true;
+	 return Mpt_Finish (Parser);
+	}
+      if ((HeadersEnd = memmem (&Parser->Block[Parser->Start],
+			        Parser->End - Parser->Start,
+				"\r\n\r\n",4)) != NULL)
+	 break;
+      if (!Mpt_ReadBlock (Parser))	// End of input, or headers too long
+	 return Mpt_Finish (Parser);
+     }
+
+   /***** Go over header lines, skipping the rest of boundary line *****/
+   LinesEnd = HeadersEnd + 2;
+   for (Line = (const char *) memchr (&Parser->Block[Parser->Start],0x0A,
+				      (size_t) (LinesEnd - &Parser->Block[Parser->Start])) + 1;
+	Line < LinesEnd;
+	Line = EndOfLine + 2)
+     {
+      EndOfLine = memchr (Line,0x0D,(size_t) (LinesEnd - Line));	// Always found
+      Mpt_ParseHeaderLine (Line,(size_t) (EndOfLine - Line),Header);
+     }
+
+   /***** Data of this part start after empty line *****/
+   Parser->Start = (size_t) (HeadersEnd + 4 - Parser->Block);
+   Parser->InPart = true;
+   return Mpt_OK;
+  }
+
+/*****************************************************************************/
+/********************** Get a piece of data of current part ******************/
+/*****************************************************************************/
+// On Mpt_OK, Data points to Length bytes inside the block of the parser,
+// valid only until next call to the parser
+
+Mpt_Status_t Mpt_GetDataOfPart (struct Mpt_Parser *Parser,
+                                const char **Data,size_t *Length)
+  {
+   size_t Pos;
+
+   if (!Parser->InPart)
+      return Mpt_END_OF_PART;
+
+   for (;;)
+     {
+      /***** Data until boundary *****/
+      if ((Pos = Mpt_FindBoundary (Parser)) != Mpt_NOT_FOUND)
+	{
+	 if (Pos > Parser->Start)
+	   {
+	    *Data   = &Parser->Block[Parser->Start];
+	    *Length = Pos - Parser->Start;
+	    Parser->Start = Pos;
+	    return Mpt_OK;
+	   }
+
+	 /* Skip boundary */
+	 Parser->Start += Parser->BoundaryLength;
+	 Parser->InPart = false;
+	 return Mpt_END_OF_PART;
+	}
+
+      /***** Boundary not found ==> all data except the last bytes,
+	     that could be the start of boundary *****/
+      if (Parser->End - Parser->Start >= Parser->BoundaryLength)
+	{
+	 *Data   = &Parser->Block[Parser->Start];
+	 *Length = Parser->End - Parser->Start - (Parser->BoundaryLength - 1);
+	 Parser->Start += *Length;
+	 return Mpt_OK;
+	}
+
+      /***** Read more data.
+             If input ends here, data are truncated *****/
+      if (!Mpt_ReadBlock (Parser))
+	{
+	 Parser->InPart = false;
+	 return Mpt_Finish (Parser);
+	}
+     }
+  }
+
+/*****************************************************************************/
+/************************* End parsing multipart data ************************/
+/*****************************************************************************/
+
+void Mpt_EndParsing (struct Mpt_Parser *Parser)
+  {
+   if (Parser->Block)
+     {
+      free (Parser->Block);
+      Parser->Block = NULL;
+     }
+  }
+
+/*****************************************************************************/
+/***************** Move pending data to start of block and *******************/
+/***************** read from input as many bytes as possible *****************/
+/*****************************************************************************/
+// Return false if no more bytes can be read
+
+static bool Mpt_ReadBlock (struct Mpt_Parser *Parser)
+  {
+   size_t NumBytes;
+
+   if (Parser->EndOfInput || Parser->Error != Mpt_OK)
+      return false;
+
+   /***** Move pending data to start of block *****/
+   if (Parser->Start)
+     {
+      memmove (Parser->Block,&Parser->Block[Parser->Start],
+	       Parser->End - Parser->Start);
+      Parser->End -= Parser->Start;
+      Parser->Start = 0;
+     }
+   if (Parser->End == Mpt_NUM_BYTES_PER_BLOCK)	// Block full
+      return false;
+
+   /***** Check timeout before reading *****/
+   if (Parser->Deadline && time (NULL) >= Parser->Deadline)
+     {
+      Parser->Error = Mpt_TIME_EXCEEDED;
+      return false;
+     }
+
+   /***** Read next block *****/
+   if ((NumBytes = fread (&Parser->Block[Parser->End],1,
+			  Mpt_NUM_BYTES_PER_BLOCK - Parser->End,
+			  Parser->In)) == 0)
+     {
+      Parser->EndOfInput = true;
+      return false;
+     }
+   Parser->NumBytesRead += NumBytes;
+   if (Parser->NumBytesRead > Parser->MaxBytes)
+     {
+      Parser->Error = Mpt_TOO_LARGE;
+      return false;
+     }
+   Parser->End += NumBytes;
+
+   return true;
+  }
+
+/*****************************************************************************/
+/**** Search boundary in pending data using Boyer-Moore-Horspool algorithm ***/
+/*****************************************************************************/
+// Return position of boundary in block, or Mpt_NOT_FOUND
+
+static size_t Mpt_FindBoundary (const struct Mpt_Parser *Parser)
+  {
+   const unsigned char *Block = (const unsigned char *) Parser->Block;
+   const unsigned char *Boundary = (const unsigned char *) Parser->Boundary;
+   size_t Last = Parser->BoundaryLength - 1;
+   size_t Pos;
+   unsigned char Ch;
+
+   for (Pos = Parser->Start;
+	Pos + Last < Parser->End;
+	Pos += Parser->Skip[Ch])
+     {
+      Ch = Block[Pos + Last];
+      if (Ch == Boundary[Last] &&
+	  !memcmp (&Block[Pos],Boundary,Last))
+	 return Pos;
+     }
+
+   return Mpt_NOT_FOUND;
+  }
+
+/*****************************************************************************/
+/************************** No more parts to parse ***************************/
+/*****************************************************************************/
+// Input is complete only if final boundary has been found
+
+static Mpt_Status_t Mpt_Finish (struct Mpt_Parser *Parser)
+  {
+   Parser->Finished = true;
+   if (Parser->Error != Mpt_OK)
+      return Parser->Error;
+   return Parser->FinalBoundary ? Mpt_END_OF_DATA :
+				  Mpt_TRUNCATED;
+  }
+
+/*****************************************************************************/
+/*************** Get name, filename and content type of a part ***************/
+/*****************************************************************************/
+/*
+Content-Disposition: form-data; name="Archivo"; filename="R157550.jpg"
+Content-Type: image/pjpeg
+*/
+
+static void Mpt_ParseHeaderLine (const char *Line,size_t Length,
+                                 struct Mpt_Header *Header)
+  {
+   static const char *StrContentDisposition = "Content-Disposition:";
+   static const char *StrContentType = "Content-Type:";
+   const char *End = Line + Length;
+   const char *Ptr;
+
+   if (Length >= strlen (StrContentType) &&
+       !strncasecmp (Line,StrContentType,strlen (StrContentType)))
+     {
+      /***** Get content type *****/
+      for (Ptr = Line + strlen (StrContentType);
+	   Ptr < End && *Ptr == ' ';
+	   Ptr++);
+      Header->ContentType = Ptr;
+      Header->ContentTypeLength = (size_t) (End - Ptr);
+     }
+   else if (Length >= strlen (StrContentDisposition) &&
+            !strncasecmp (Line,StrContentDisposition,strlen (StrContentDisposition)))
+      /***** Get name and filename *****/
+      for (Ptr = Line + strlen (StrContentDisposition);
+	   (Ptr = memchr (Ptr,';',(size_t) (End - Ptr))) != NULL;
+	   )
+	{
+	 for (Ptr++;
+	      Ptr < End && *Ptr == ' ';
+	      Ptr++);
+	 if (!Mpt_GetQuotedParam (&Ptr,End,"name",
+	                          &Header->Name,&Header->NameLength))
+	    if (Mpt_GetQuotedParam (&Ptr,End,"filename",
+	                            &Header->FileName,&Header->FileNameLength))
+	       Header->IsFile = true;
+	}
+  }
+
+/*****************************************************************************/
+/************************ Get a parameter key="value" ************************/
+/*****************************************************************************/
+// If found, Ptr is moved after the value
+
+static bool Mpt_GetQuotedParam (const char **Ptr,const char *End,
+                                const char *Key,
+                                const char **Value,size_t *Length)
+  {
+   size_t KeyLength = strlen (Key);
+   const char *Start;
+   const char *Quote;
+
+   if ((size_t) (End - *Ptr) < KeyLength + 2 ||
+       strncasecmp (*Ptr,Key,KeyLength) ||
+       (*Ptr)[KeyLength    ] != '=' ||
+       (*Ptr)[KeyLength + 1] != '\"')
+      return false;
+
+   Start = *Ptr + KeyLength + 2;
+   if ((Quote = memchr (Start,'\"',(size_t) (End - Start))) == NULL)
+      return false;
+
+   *Value  = Start;
+   *Length = (size_t) (Quote - Start);
+   *Ptr = Quote + 1;
+   return true;
+  }
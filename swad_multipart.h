@@ -0,0 +1,102 @@
+// swad_multipart.h: streaming parser of multipart/form-data
+
+#ifndef _SWAD_MPT
+#define _SWAD_MPT
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************** Headers **********************************/
+/*****************************************************************************/
+
+#include <stdbool.h>		// For boolean type
+#include <stddef.h>		// For size_t
+#include <stdio.h>		// For FILE
+#include <time.h>		// For time_t
+
+/*****************************************************************************/
+/****************************** Public constants *****************************/
+/*****************************************************************************/
+
+#define Mpt_NUM_BYTES_PER_BLOCK	(256UL * 1024UL)	// Bytes read from input at once
+
+#define Mpt_MAX_BYTES_BOUNDARY	(2 + 2 + 127)		// "\r\n--" and boundary
+
+/*****************************************************************************/
+/******************************** Public types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   Mpt_OK,			// Got a new part, or a piece of data of current part
+   Mpt_END_OF_PART,		// No more data in current part
+   Mpt_END_OF_DATA,		// No more parts (final boundary found)
+   Mpt_TRUNCATED,		// Input ends before final boundary, or malformed input
+   Mpt_TOO_LARGE,		// Input exceeds the maximum allowed size
+   Mpt_TIME_EXCEEDED,		// Input is arriving too slowly
+  } Mpt_Status_t;
+
+struct Mpt_Parser
+  {
+   FILE *In;
+   char Boundary[Mpt_MAX_BYTES_BOUNDARY + 1];	// "\r\n--" and boundary
+   size_t BoundaryLength;
+   size_t Skip[256];		// Horspool table to search boundary
+   char *Block;			// Bytes read from input not yet consumed...
+   size_t Start;		// ...from Block[Start]...
+   size_t End;			// ...to Block[End - 1]
+   bool EndOfInput;
+   bool InPart;			// true ==> data of a part (or preamble) pending
+   bool Finished;		// true ==> no more parts
+   bool FinalBoundary;		// true ==> final boundary "--" found
+   unsigned long long NumBytesRead;
+   unsigned long long MaxBytes;	// Maximum number of bytes allowed in input
+   time_t Deadline;		// Abort if input is not fully read before this time (0 ==> no deadline)
+   Mpt_Status_t Error;		// Mpt_OK or error while reading input
+  };
+
+// Pointers in header point inside the block of the parser,
+// so they are valid only until next call to the parser
+struct Mpt_Header
+  {
+   const char *Name;
+   size_t NameLength;		// 0 ==> part without name
+   bool IsFile;			// true ==> filename is present, although it can be empty
+   const char *FileName;
+   size_t FileNameLength;
+   const char *ContentType;
+   size_t ContentTypeLength;
+  };
+
+/*****************************************************************************/
+/****************************** Public prototypes ****************************/
+/*****************************************************************************/
+
+bool Mpt_CheckBoundary (size_t BoundaryLength);
+bool Mpt_BeginParsing (struct Mpt_Parser *Parser,FILE *In,
+                       const char *BoundaryWithCRLF,size_t BoundaryLength,
+                       unsigned long long MaxBytes,time_t Deadline);
+Mpt_Status_t Mpt_GetNextPart (struct Mpt_Parser *Parser,struct Mpt_Header *Header);
+Mpt_Status_t Mpt_GetDataOfPart (struct Mpt_Parser *Parser,
+                                const char **Data,size_t *Length);
+void Mpt_EndParsing (struct Mpt_Parser *Parser);
+
+#endif
@@ -0,0 +1,244 @@
+// swad_multipart_bench_main.c: main of swad_multipart_bench, throughput of upload parsing
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <stdio.h>		// For printf, fopen
+#include <stdlib.h>		// For atoi, rand
+#include <string.h>		// For strlen
+#include <sys/time.h>		// For gettimeofday
+#include <unistd.h>		// For unlink
+
+#include "swad_multipart.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define MpB_BOUNDARY	"\r\n-----------------------------7d13ca2e948"
+
+#define MpB_PATH_INPUT	"/tmp/swad_multipart_bench.in"
+#define MpB_PATH_OUTPUT	"/tmp/swad_multipart_bench.out"
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void MpB_CreateInput (unsigned long NumBytesFile);
+static bool MpB_ParseInBlocks (void);
+static bool MpB_CopyByteByByte (void);
+static double MpB_GetSeconds (void);
+static void MpB_WriteThroughput (const char *How,unsigned long NumBytes,
+                                 unsigned NumRepetitions,double Seconds);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_multipart_bench <number of repetitions> <MiB of file>
+   A form with some parameters and a file is received the given number of times,
+   first parsing it in blocks and writing the file as it arrives,
+   as done now, and then copying it byte by byte into a temporary file,
+   as done before (without the later passes to get the parameters).
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumRepetitions;
+   int NumMiB;
+   unsigned long NumBytes;
+   int i;
+   double Start;
+
+   if (argc != 3 ||
+       (NumRepetitions = atoi (argv[1])) <= 0 ||
+       (NumMiB = atoi (argv[2])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s <number of repetitions> <MiB of file>\n",argv[0]);
+      return 1;
+     }
+   NumBytes = (unsigned long) NumMiB * 1024UL * 1024UL;
+   MpB_CreateInput (NumBytes);
+
+   /***** Parsing in blocks *****/
+   Start = MpB_GetSeconds ();
+   for (i = 0;
+	i < NumRepetitions;
+	i++)
+      if (!MpB_ParseInBlocks ())
+	{
+	 fprintf (stderr,"Error parsing input.\n");
+	 break;
+	}
+   if (i == NumRepetitions)
+      MpB_WriteThroughput ("in blocks",NumBytes,
+			   (unsigned) NumRepetitions,MpB_GetSeconds () - Start);
+
+   /***** Byte by byte *****/
+   Start = MpB_GetSeconds ();
+   for (i = 0;
+	i < NumRepetitions;
+	i++)
+      if (!MpB_CopyByteByByte ())
+	{
+	 fprintf (stderr,"Error copying input.\n");
+	 break;
+	}
+   if (i == NumRepetitions)
+      MpB_WriteThroughput ("byte by byte",NumBytes,
+			   (unsigned) NumRepetitions,MpB_GetSeconds () - Start);
+
+   unlink (MpB_PATH_INPUT);
+   unlink (MpB_PATH_OUTPUT);
+   return 0;
+  }
+
+/*****************************************************************************/
+/******************* Create a form with parameters and a file ****************/
+/*****************************************************************************/
+
+static void MpB_CreateInput (unsigned long NumBytesFile)
+  {
+   static const char *Params[] =
+     {
+      "act","1234",
+      "ses","u2Yk6Wd9mE0vXDx3cN4hQpR7sL1tG8bA5fJzOyPiVnK",
+      "FilFolLnk","Documents/Unit 1",
+     };
+#define MpB_NUM_PARAMS (sizeof (Params) / sizeof (Params[0]) / 2)
+   FILE *File;
+   unsigned NumParam;
+   unsigned long i;
+
+   if ((File = fopen (MpB_PATH_INPUT,"wb")) == NULL)
+     {
+      fprintf (stderr,"Can not create %s.\n",MpB_PATH_INPUT);
+      exit (1);
+     }
+
+   for (NumParam = 0;
+	NumParam < MpB_NUM_PARAMS;
+	NumParam++)
+      fprintf (File,"%s\r\nContent-Disposition: form-data; name=\"%s\"\r\n\r\n%s",
+	       NumParam ? MpB_BOUNDARY : MpB_BOUNDARY + 2,
+	       Params[NumParam * 2],Params[NumParam * 2 + 1]);
+
+   fprintf (File,"%s\r\nContent-Disposition: form-data; name=\"file\"; filename=\"file.bin\"\r\n"
+		 "Content-Type: application/octet-stream\r\n\r\n",
+	    MpB_BOUNDARY);
+   for (i = 0;
+	i < NumBytesFile;
+	i++)
+      fputc (rand () & 0xFF,File);
+   fprintf (File,"%s--\r\n",MpB_BOUNDARY);
+
+   fclose (File);
+  }
+
+/*****************************************************************************/
+/************* Parse input in blocks and write file as it arrives ************/
+/*****************************************************************************/
+
+static bool MpB_ParseInBlocks (void)
+  {
+   FILE *In;
+   FILE *Out = NULL;
+   struct Mpt_Parser Parser;
+   struct Mpt_Header Header;
+   const char *Data;
+   size_t Length;
+   bool Ok = false;
+
+   if ((In = fopen (MpB_PATH_INPUT,"rb")) == NULL)
+      return false;
+   if (Mpt_BeginParsing (&Parser,In,MpB_BOUNDARY,strlen (MpB_BOUNDARY),
+			 1536ULL * 1024ULL * 1024ULL,0))
+     {
+      while (Mpt_GetNextPart (&Parser,&Header) == Mpt_OK)
+	 if (Header.IsFile)
+	   {
+	    if ((Out = fopen (MpB_PATH_OUTPUT,"wb")) == NULL)
+	       break;
+	    while (Mpt_GetDataOfPart (&Parser,&Data,&Length) == Mpt_OK)
+	       fwrite (Data,1,Length,Out);
+	    fclose (Out);
+	    Ok = true;
+	   }
+      Mpt_EndParsing (&Parser);
+     }
+   fclose (In);
+
+   return Ok;
+  }
+
+/*****************************************************************************/
+/*************** Copy input byte by byte into a temporary file ***************/
+/*****************************************************************************/
+
+static bool MpB_CopyByteByByte (void)
+  {
+   FILE *In;
+   FILE *Tmp;
+   int Ch;
+
+   if ((In = fopen (MpB_PATH_INPUT,"rb")) == NULL)
+      return false;
+   if ((Tmp = tmpfile ()) == NULL)
+     {
+      fclose (In);
+      return false;
+     }
+   while ((Ch = fgetc (In)) != EOF)
+      fputc (Ch,Tmp);
+   fclose (Tmp);
+   fclose (In);
+
+   return true;
+  }
+
+/*****************************************************************************/
+/************************ Get current time in seconds ************************/
+/*****************************************************************************/
+
+static double MpB_GetSeconds (void)
+  {
+   struct timeval Now;
+
+   gettimeofday (&Now,NULL);
+   return (double) Now.tv_sec + (double) Now.tv_usec / 1E6;
+  }
+
+/*****************************************************************************/
+/***************************** Write MiB per second **************************/
+/*****************************************************************************/
+
+static void MpB_WriteThroughput (const char *How,unsigned long NumBytes,
+                                 unsigned NumRepetitions,double Seconds)
+  {
+   printf ("%-12s %8.1f MiB/s\n",
+	   How,
+	   Seconds > 0.0 ? (double) NumBytes * NumRepetitions / (1024.0 * 1024.0) / Seconds :
+			   0.0);
+  }
@@ -28,8 +28,6 @@
 #include <stddef.h>		// For NULL
 #include <stdlib.h>		// For system
 #include <string.h>
-#include <sys/wait.h>		// For the macro WEXITSTATUS
-#include <unistd.h>		// For unlink
 
 #include "swad_action.h"
 #include "swad_box.h"
@@ -1576,10 +1574,6 @@ static void Ntf_SendPendingNotifByEMailToOneUsr (struct UsrData *ToUsrDat,unsign
    long Cod;
    struct Forum ForumSelected;
    char ForumName[For_MAX_BYTES_FORUM_NAME + 1];
-   char Command[2048 +
-		Cfg_MAX_BYTES_SMTP_PASSWORD +
-		Cns_MAX_BYTES_EMAIL_ADDRESS +
-		PATH_MAX]; // Command to execute for sending an email
    int ReturnCode;
 
    /***** Return 0 notifications and 0 mails when error *****/
@@ -1736,28 +1730,13 @@ static void Ntf_SendPendingNotifByEMailToOneUsr (struct UsrData *ToUsrDat,unsign
 
 	 fclose (Gbl.Msg.FileMail);
 
-	 /***** Call the command to send an email *****/
-	 snprintf (Command,sizeof (Command),
-	           "%s \"%s\" \"%s\" \"%s\" \"%s\" \"%s\" \"[%s] %s\" \"%s\"",
-		   Cfg_COMMAND_SEND_AUTOMATIC_EMAIL,
-		   Cfg_AUTOMATIC_EMAIL_SMTP_SERVER,
-		   Cfg_AUTOMATIC_EMAIL_SMTP_PORT,
-		   Cfg_AUTOMATIC_EMAIL_FROM,
-		   Gbl.Config.SMTPPassword,
-		   ToUsrDat->Email,
-		   Cfg_PLATFORM_SHORT_NAME,
-		   Txt_Notifications_NO_HTML[ToUsrLanguage],
-		   Gbl.Msg.FileNameMail);
-	 ReturnCode = system (Command);
-	 if (ReturnCode == -1)
-	    Lay_ShowErrorAndExit ("Error when running script to send email.");
-
-	 /***** Remove temporary file *****/
-	 unlink (Gbl.Msg.FileNameMail);
-
-	 /***** Update number of notifications, number of mails and statistics *****/
-	 ReturnCode = WEXITSTATUS(ReturnCode);
-	 if (ReturnCode == 0)	// Message sent successfully
+	 /***** Send the email (or store it in queue) and
+		update number of notifications, number of mails and statistics *****/
+	 ReturnCode = Mai_SendMailMsg (ToUsrDat->Email,
+				       Txt_Notifications_NO_HTML[ToUsrLanguage],
+				       Mai_QUEUE);
+	 if (ReturnCode == 0 ||			// Message sent successfully
+	     ReturnCode == Mai_MAIL_QUEUED)	// Message will be sent soon
 	   {
 	    *NumNotif = (unsigned) NumRows;
 	    *NumMails = 1;
@@ -2067,11 +2046,11 @@ void Ntf_WriteNumberOfNewNtfs (void)
 static unsigned Ntf_GetNumberOfAllMyUnseenNtfs (void)
   {
    /***** Get number of places with a name from database *****/
-   return DB_QueryCOUNT ("can not get number of unseen notifications",
-			 "SELECT COUNT(*) FROM notif"
-			 " WHERE ToUsrCod=%ld AND (Status & %u)=0",
-			 Gbl.Usrs.Me.UsrDat.UsrCod,
-			 (unsigned) (Ntf_STATUS_BIT_READ | Ntf_STATUS_BIT_REMOVED));
+   return DB_QueryCOUNTprepared ("can not get number of unseen notifications",
+				 "SELECT COUNT(*) FROM notif"
+				 " WHERE ToUsrCod=%ld AND (Status & %u)=0",
+				 Gbl.Usrs.Me.UsrDat.UsrCod,
+				 (unsigned) (Ntf_STATUS_BIT_READ | Ntf_STATUS_BIT_REMOVED));
   }
 
 /*****************************************************************************/
@@ -2081,13 +2060,13 @@ static unsigned Ntf_GetNumberOfAllMyUnseenNtfs (void)
 static unsigned Ntf_GetNumberOfMyNewUnseenNtfs (void)
   {
    /***** Get number of places with a name from database *****/
-   return DB_QueryCOUNT ("can not get number of unseen notifications",
-			 "SELECT COUNT(*) FROM notif"
-			 " WHERE ToUsrCod=%ld AND (Status & %u)=0"
-			 " AND TimeNotif>FROM_UNIXTIME(%ld)",
-			 Gbl.Usrs.Me.UsrDat.UsrCod,
-			 (unsigned) (Ntf_STATUS_BIT_READ | Ntf_STATUS_BIT_REMOVED),
-			 Gbl.Usrs.Me.UsrLast.LastAccNotif);
+   return DB_QueryCOUNTprepared ("can not get number of unseen notifications",
+				 "SELECT COUNT(*) FROM notif"
+				 " WHERE ToUsrCod=%ld AND (Status & %u)=0"
+				 " AND TimeNotif>FROM_UNIXTIME(%ld)",
+				 Gbl.Usrs.Me.UsrDat.UsrCod,
+				 (unsigned) (Ntf_STATUS_BIT_READ | Ntf_STATUS_BIT_REMOVED),
+				 Gbl.Usrs.Me.UsrLast.LastAccNotif);
   }
 
 /*****************************************************************************/
@@ -0,0 +1,293 @@
+// swad_output_bench_main.c: main of swad_output_bench, time to generate and send HTML output
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#define _GNU_SOURCE 		// For fopencookie
+#include <linux/limits.h>	// For PATH_MAX
+#include <stdio.h>		// For fopen, fopencookie, fprintf, printf...
+#include <stdlib.h>		// For atoi, realloc, free
+#include <string.h>		// For memcpy
+#include <sys/time.h>		// For gettimeofday
+#include <unistd.h>		// For getpid, unlink
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define OuB_NUM_BYTES_PER_CHUNK 4096	// Same as in swad_file.c
+
+#define OuB_PATH_SEND "/dev/null"	// Instead of web server
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   OuB_FILE,	// Before: HTML output written in a temporary file
+   OuB_BUFFER,	// Now: HTML output written in a buffer in memory
+  } OuB_Output_t;
+#define OuB_NUM_OUTPUTS 2
+
+struct OuB_Buffer
+  {
+   char *Buffer;
+   size_t Length;
+   size_t Size;
+  };
+
+/*****************************************************************************/
+/***************************** Private variables *****************************/
+/*****************************************************************************/
+
+static struct OuB_Buffer OuB_HTMLOutput =	// Reused in all pages, as in swad
+  {
+   .Buffer = NULL,
+   .Length = 0,
+   .Size   = 0,
+  };
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void OuB_GeneratePage (FILE *Out,unsigned long NumBytes);
+static ssize_t OuB_WriteToBuffer (void *Cookie,const char *Buf,size_t Size);
+static double OuB_GetSeconds (void);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_output_bench <directory> <number of pages> <KiB per page>...
+   For each page size, the given number of pages are generated and sent
+   (to /dev/null instead of to the web server) in two ways:
+   - before: written in a temporary file in the given directory
+     (it should be the directory of HTML output of swad, Cfg_PATH_OUT_PRIVATE),
+     read back to be sent and removed;
+   - now: written in a buffer in memory that grows as needed,
+     as done by Fil_CreateBufferForHTMLOutput.
+   The mean TimeToGenerate and TimeToSend per page are written.
+   For example:
+      swad_output_bench /var/www/swad/out 1000 16 64 256 1024
+*/
+
+int main (int argc,char *argv[])
+  {
+   static const char *OutputTxt[OuB_NUM_OUTPUTS] =
+     {
+      [OuB_FILE  ] = "file",
+      [OuB_BUFFER] = "buffer",
+     };
+   cookie_io_functions_t OutFunctions =
+     {
+      .read  = NULL,
+      .write = OuB_WriteToBuffer,
+      .seek  = NULL,
+      .close = NULL,
+     };
+   int NumPages;
+   int NumArg;
+   int KiB;
+   int NumPage;
+   OuB_Output_t Output;
+   char FileName[PATH_MAX + 1];
+   FILE *Send;
+   FILE *Out;
+   char Bytes[OuB_NUM_BYTES_PER_CHUNK];
+   size_t NumBytesRead;
+   double Start;
+   double TimeToGenerate;
+   double TimeToSend;
+
+   if (argc < 4 || (NumPages = atoi (argv[2])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s <directory> <number of pages> <KiB per page>...\n",
+	       argv[0]);
+      return 1;
+     }
+
+   if ((Send = fopen (OuB_PATH_SEND,"wb")) == NULL)
+     {
+      fprintf (stderr,"Can not open %s.\n",OuB_PATH_SEND);
+      return 1;
+     }
+   snprintf (FileName,sizeof (FileName),"%s/swad_output_bench_%d.html",
+	     argv[1],(int) getpid ());
+
+   printf ("%8s %-6s %20s %20s\n",
+	   "KiB","output","TimeToGenerate (us)","TimeToSend (us)");
+   for (NumArg = 3;
+	NumArg < argc;
+	NumArg++)
+     {
+      if ((KiB = atoi (argv[NumArg])) <= 0)
+	{
+	 fprintf (stderr,"Wrong page size: %s.\n",argv[NumArg]);
+	 return 1;
+	}
+
+      for (Output  = (OuB_Output_t) 0;
+	   Output <= (OuB_Output_t) (OuB_NUM_OUTPUTS - 1);
+	   Output++)
+	{
+	 TimeToGenerate =
+	 TimeToSend     = 0.0;
+	 for (NumPage = 0;
+	      NumPage < NumPages;
+	      NumPage++)
+	   {
+	    /***** Generate page *****/
+	    Start = OuB_GetSeconds ();
+	    switch (Output)
+	      {
+	       case OuB_FILE:
+		  if ((Out = fopen (FileName,"w+t")) == NULL)
+		    {
+		     fprintf (stderr,"Can not create %s.\n",FileName);
+		     return 1;
+		    }
+		  break;
+	       case OuB_BUFFER:
+	       default:
+		  OuB_HTMLOutput.Length = 0;
+		  if ((Out = fopencookie (&OuB_HTMLOutput,"w",OutFunctions)) == NULL)
+		    {
+		     fprintf (stderr,"Can not create output buffer.\n");
+		     return 1;
+		    }
+		  break;
+	      }
+	    OuB_GeneratePage (Out,(unsigned long) KiB * 1024UL);
+	    TimeToGenerate += OuB_GetSeconds () - Start;
+
+	    /***** Send page *****/
+	    Start = OuB_GetSeconds ();
+	    switch (Output)
+	      {
+	       case OuB_FILE:
+		  rewind (Out);
+		  while ((NumBytesRead = fread (Bytes,sizeof (Bytes[0]),
+						sizeof (Bytes),Out)))
+		     fwrite (Bytes,sizeof (Bytes[0]),NumBytesRead,Send);
+		  fclose (Out);
+		  unlink (FileName);
+		  break;
+	       case OuB_BUFFER:
+	       default:
+		  fflush (Out);
+		  fwrite (OuB_HTMLOutput.Buffer,sizeof (OuB_HTMLOutput.Buffer[0]),
+			  OuB_HTMLOutput.Length,Send);
+		  fclose (Out);
+		  break;
+	      }
+	    fflush (Send);
+	    TimeToSend += OuB_GetSeconds () - Start;
+	   }
+
+	 printf ("%8d %-6s %20.1f %20.1f\n",
+		 KiB,OutputTxt[Output],
+		 TimeToGenerate * 1E6 / (double) NumPages,
+		 TimeToSend     * 1E6 / (double) NumPages);
+	}
+     }
+
+   fclose (Send);
+   free (OuB_HTMLOutput.Buffer);
+   return 0;
+  }
+
+/*****************************************************************************/
+/****************** Write a page with rows of a typical table ****************/
+/*****************************************************************************/
+
+static void OuB_GeneratePage (FILE *Out,unsigned long NumBytes)
+  {
+   unsigned NumRow;
+   long Pos = 0;
+
+   fprintf (Out,"<!DOCTYPE html>\n"
+		"<html lang=\"es\">\n"
+		"<body>\n"
+		"<table class=\"FRAME\">\n");
+   for (NumRow = 1;
+	(unsigned long) Pos < NumBytes;
+	NumRow++)
+     {
+      /* Many short writes, as done by swad when writing HTML */
+      fprintf (Out,"<tr>");
+      fprintf (Out,"<td class=\"DAT RT\">%u</td>",NumRow);
+      fprintf (Out,"<td class=\"DAT LT\">%s</td>","Lorem ipsum dolor sit amet");
+      fprintf (Out,"<td class=\"DAT_N LT\">%ld</td>",(long) NumRow * 12345L);
+      fprintf (Out,"</tr>\n");
+      Pos += 4 + 28 + 10 + 5 + 26 + 5 + 30 + 10 + 6;	// Approximate length of row
+     }
+   fprintf (Out,"</table>\n"
+		"</body>\n"
+		"</html>\n");
+  }
+
+/*****************************************************************************/
+/******** Write function of buffer (same as Fil_WriteToHTMLOutput) ***********/
+/*****************************************************************************/
+
+static ssize_t OuB_WriteToBuffer (void *Cookie,const char *Buf,size_t Size)
+  {
+   struct OuB_Buffer *Output = (struct OuB_Buffer *) Cookie;
+   size_t NewSize;
+   char *NewBuffer;
+
+   /***** Enlarge buffer if necessary *****/
+   if (Output->Length + Size > Output->Size)
+     {
+      NewSize = Output->Size ? Output->Size :
+			       OuB_NUM_BYTES_PER_CHUNK * 16;
+      while (Output->Length + Size > NewSize)
+	 NewSize *= 2;
+      if ((NewBuffer = realloc (Output->Buffer,NewSize)) == NULL)
+	 return 0;	// Error
+      Output->Buffer = NewBuffer;
+      Output->Size = NewSize;
+     }
+
+   /***** Append data to buffer *****/
+   memcpy (&Output->Buffer[Output->Length],Buf,Size);
+   Output->Length += Size;
+
+   return (ssize_t) Size;
+  }
+
+/*****************************************************************************/
+/************************ Get current time in seconds ************************/
+/*****************************************************************************/
+
+static double OuB_GetSeconds (void)
+  {
+   struct timeval Now;
+
+   gettimeofday (&Now,NULL);
+   return (double) Now.tv_sec + (double) Now.tv_usec / 1E6;
+  }
@@ -29,11 +29,13 @@
 #include <stddef.h>		// For NULL
 #include <stdlib.h>		// For calloc
 #include <string.h>		// For string functions
+#include <unistd.h>		// For unlink
 
 #include "swad_action.h"
 #include "swad_config.h"
 #include "swad_global.h"
 #include "swad_HTML.h"
+#include "swad_multipart.h"
 #include "swad_parameter.h"
 #include "swad_password.h"
 #include "swad_setting.h"
@@ -55,10 +57,19 @@ const char *Par_SEPARATOR_PARAM_MULTIPLE = "\x0a";	// Must be 1 <= character <=
 /*********************** Private types and constants *************************/
 /*****************************************************************************/
 
+#define Par_INITIAL_BYTES_MULTIPART_DATA	(16 * 1024)
+#define Par_MAX_BYTES_MULTIPART_DATA		(4 * 1024 * 1024)	// Names and values of parameters, excluding file contents
+
 /*****************************************************************************/
 /****************************** Private variables ****************************/
 /*****************************************************************************/
 
+static struct
+  {
+   size_t Length;	// Bytes used in query string when receiving multipart data
+   size_t Size;		// Bytes allocated for query string when receiving multipart data
+  } Par_Gbl;
+
 /*****************************************************************************/
 /***************************** Private prototypes ****************************/
 /*****************************************************************************/
@@ -66,9 +77,9 @@ const char *Par_SEPARATOR_PARAM_MULTIPLE = "\x0a";	// Must be 1 <= character <=
 static void Par_GetBoundary (void);
 
 static void Par_CreateListOfParamsFromQueryString (void);
-static void Par_CreateListOfParamsFromTmpFile (void);
-static int Par_ReadTmpFileUntilQuote (void);
-static int Par_ReadTmpFileUntilReturn (void);
+static bool Par_CreateListOfParamsFromStdin (void);
+static void Par_StoreFileOfParam (struct Mpt_Parser *Parser,struct Param *Param);
+static struct StartLength Par_AppendToMultipartData (const char *Data,size_t Length);
 
 static bool Par_CheckIsParamCanBeUsedInGETMethod (const char *ParamName);
 
@@ -134,7 +145,7 @@ bool Par_GetQueryString (void)
         {
          Gbl.ContentReceivedByCGI = Act_CONT_DATA;
          Par_GetBoundary ();
-         return Fil_ReadStdinIntoTmpFile ();
+         return Par_CreateListOfParamsFromStdin ();
         }
       else if (!strncmp (ContentType,"text/xml",strlen ("text/xml")))
         {
@@ -217,6 +228,8 @@ List --> |Name.Start        |    -> |Name.Start        |
          |Value.Start       |  |    |Value.Start       |
          +------------------+  |    +------------------+
          |Value.Lengh       |  |    |Value.Lengh       |
+         +------------------+  |    +------------------+
+         |PathTmpFile       |  |    |PathTmpFile       |
          +------------------+ /     +------------------+
          |       Next --------      |       NULL       |
          +------------------+       +------------------+
@@ -224,20 +237,20 @@ List --> |Name.Start        |    -> |Name.Start        |
 
 void Par_CreateListOfParams (void)
   {
-   /***** Initialize empty list of parameters *****/
-   Gbl.Params.List = NULL;
+   switch (Gbl.ContentReceivedByCGI)
+     {
+      case Act_CONT_NORM:
+	 /***** Initialize empty list of parameters *****/
+	 Gbl.Params.List = NULL;
 
-   /***** Get list *****/
-   if (Gbl.Params.ContentLength)
-      switch (Gbl.ContentReceivedByCGI)
-	{
-	 case Act_CONT_NORM:
+	 /***** Get list *****/
+	 if (Gbl.Params.ContentLength)
 	    Par_CreateListOfParamsFromQueryString ();
-	    break;
-	 case Act_CONT_DATA:
-	    Par_CreateListOfParamsFromTmpFile ();
-	    break;
-	}
+	 break;
+      case Act_CONT_DATA:
+	 /***** List has been created while reading stdin *****/
+	 break;
+     }
   }
 
 /*****************************************************************************/
@@ -297,164 +310,185 @@ static void Par_CreateListOfParamsFromQueryString (void)
   }
 
 /*****************************************************************************/
-/*************** Create list of parameters from temporary file ***************/
+/************* Create list of parameters reading multipart data **************/
 /*****************************************************************************/
-// TODO: Rename Gbl.F.Tmp to Gbl.F.In (InFile, QueryFile)?
-
-#define Par_LENGTH_OF_STR_BEFORE_PARAM	38		// Length of "Content-Disposition: form-data; name=\""
-#define Par_LENGTH_OF_STR_FILENAME	12		// Length of "; filename=\""
-#define Par_LENGTH_OF_STR_CONTENT_TYPE	14		// Length of "Content-Type: "
-#define Par_MAX_BYTES_STR_AUX		(38 + 1)	// Space to read any of the three preceding strings
+/*
+   Stdin is parsed in large blocks as it arrives.
+   Names, filenames, content types and values of parameters
+   are stored in Gbl.Params.QueryString.
+   The content of each file is written directly into a temporary file
+   in the same filesystem as the file browsers,
+   so it's only moved to its final destination.
+   Return false on error (file too large or upload too slow)
+*/
 
-static void Par_CreateListOfParamsFromTmpFile (void)
+static bool Par_CreateListOfParamsFromStdin (void)
   {
-   static const char *StringBeforeParam = "Content-Disposition: form-data; name=\"";
-   static const char *StringFilename = "; filename=\"";
-   static const char *StringContentType = "Content-Type: ";
-   unsigned long CurPos;	// Current position in temporal file
+   struct Mpt_Parser Parser;
+   struct Mpt_Header Header;
+   Mpt_Status_t Status;
    struct Param *Param = NULL;	// Initialized to avoid warning
    struct Param *NewParam;
-   int Ch;
-   char StrAux[Par_MAX_BYTES_STR_AUX + 1];
+   const char *Data;
+   size_t Length;
 
-   /***** Go over the file
-          getting start positions and lengths of parameters *****/
-   if (Str_ReadFileUntilBoundaryStr (Gbl.F.Tmp,NULL,
-                                     Gbl.Boundary.StrWithoutCRLF,
-                                     Gbl.Boundary.LengthWithoutCRLF,
-                                     Fil_MAX_FILE_SIZE) == 1)	// Delimiter string found
-
-      for (CurPos = 0;
-	   CurPos < Gbl.Params.ContentLength;
-	   )
+   /***** Initialize empty list of parameters *****/
+   Gbl.Params.List = NULL;
+
+   /***** Allocate memory for names and values of parameters *****/
+   Par_Gbl.Length = 0;
+   Par_Gbl.Size = Par_INITIAL_BYTES_MULTIPART_DATA;
+   if ((Gbl.Params.QueryString = (char *) malloc (Par_Gbl.Size)) == NULL)
+     {
+      Fil_EndOfReadingStdin ();
+      Lay_ShowErrorAndExit ("Error allocating memory for parameters.");
+     }
+
+   /***** Start parsing stdin *****/
+   if (!Mpt_CheckBoundary (Gbl.Boundary.LengthWithCRLF))
+     {
+      Fil_EndOfReadingStdin ();
+      Lay_ShowErrorAndExit ("Wrong delimiter string.");
+     }
+   if (!Mpt_BeginParsing (&Parser,stdin,
+			  Gbl.Boundary.StrWithCRLF,Gbl.Boundary.LengthWithCRLF,
+			  Fil_MAX_FILE_SIZE,
+			  Gbl.StartExecutionTimeUTC + Cfg_TIME_TO_ABORT_FILE_UPLOAD))
+     {
+      Fil_EndOfReadingStdin ();
+      Lay_ShowErrorAndExit ("Error allocating memory for parameters.");
+     }
+
+   /***** Go over the parts of data *****/
+   while ((Status = Mpt_GetNextPart (&Parser,&Header)) == Mpt_OK)
+     {
+      if (!Header.NameLength)	// Not a parameter
+	 continue;
+
+      /* Allocate space for a new parameter initialized to 0 */
+      if ((NewParam = (struct Param *) calloc (1,sizeof (struct Param))) == NULL)
+	 Lay_ShowErrorAndExit ("Error allocating memory for parameter");
+
+      /* Link the previous element in list with the current element */
+      if (Gbl.Params.List == NULL)
+	 Gbl.Params.List = NewParam;	// Pointer to first param
+      else
+	 Param->Next = NewParam;	// Pointer from former param to new param
+
+      /* Make the current element to be the just created */
+      Param = NewParam;
+
+      /***** Get parameter name *****/
+      Param->Name = Par_AppendToMultipartData (Header.Name,Header.NameLength);
+
+      /***** Get parameter value or file content *****/
+      if (Header.IsFile)
 	{
-	 /***** Skip \r\n after delimiter string *****/
-	 if (fgetc (Gbl.F.Tmp) != 0x0D) break;	// '\r'
-	 if (fgetc (Gbl.F.Tmp) != 0x0A) break;	// '\n'
+	 Param->FileName    = Par_AppendToMultipartData (Header.FileName,Header.FileNameLength);
+	 Param->ContentType = Par_AppendToMultipartData (Header.ContentType,Header.ContentTypeLength);
+	 Par_StoreFileOfParam (&Parser,Param);
+	}
+      else
+	{
+	 Param->Value.Start = Par_Gbl.Length;
+	 while (Mpt_GetDataOfPart (&Parser,&Data,&Length) == Mpt_OK)
+	    Par_AppendToMultipartData (Data,Length);
+	 Param->Value.Length = Par_Gbl.Length - Param->Value.Start;
+	}
+     }
 
-	 Str_GetNextStrFromFileConvertingToLower (Gbl.F.Tmp,StrAux,
-	                                          Par_LENGTH_OF_STR_BEFORE_PARAM);
-	 if (!strcasecmp (StrAux,StringBeforeParam)) // Start of a parameter
-	   {
-	    /* Allocate space for a new parameter initialized to 0 */
-	    if ((NewParam = (struct Param *) calloc (1,sizeof (struct Param))) == NULL)
-	       Lay_ShowErrorAndExit ("Error allocating memory for parameter");
-
-	    /* Link the previous element in list with the current element */
-	    if (CurPos == 0)
-	       Gbl.Params.List = NewParam;	// Pointer to first param
-	    else
-	       Param->Next = NewParam;	// Pointer from former param to new param
-
-	    /* Make the current element to be the just created */
-	    Param = NewParam;
-
-	    /***** Get parameter name *****/
-	    CurPos = (unsigned long) ftell (Gbl.F.Tmp);	// At start of parameter name
-	    Param->Name.Start = CurPos;
-	    Ch = Par_ReadTmpFileUntilQuote ();
-	    CurPos = (unsigned long) ftell (Gbl.F.Tmp);	// Just after quote
-	    Param->Name.Length = CurPos - 1 - Param->Name.Start;
-
-	    /* Check if last character read after parameter name is a quote */
-	    if (Ch != (int) '\"') break;		// '\"'
-
-	    /* Get next char after parameter name */
-	    Ch = fgetc (Gbl.F.Tmp);
-
-	    /***** Check if filename is present *****/
-	    if (Ch == (int) StringFilename[0])
-	      {
-	       Str_GetNextStrFromFileConvertingToLower (Gbl.F.Tmp,StrAux,
-	                                                Par_LENGTH_OF_STR_FILENAME-1);
-	       if (!strcasecmp (StrAux,StringFilename + 1))	// Start of filename
-		 {
-		  /* Get filename */
-		  CurPos = (unsigned long) ftell (Gbl.F.Tmp);	// At start of filename
-		  Param->FileName.Start = CurPos;
-		  Ch = Par_ReadTmpFileUntilQuote ();
-		  CurPos = (unsigned long) ftell (Gbl.F.Tmp);	// Just after quote
-		  Param->FileName.Length = CurPos - 1 - Param->FileName.Start;
-
-		  /* Check if last character read after filename is a quote */
-		  if (Ch != (int) '\"') break;		// '\"'
-
-		  /* Skip \r\n */
-		  if (fgetc (Gbl.F.Tmp) != 0x0D) break;	// '\r'
-		  if (fgetc (Gbl.F.Tmp) != 0x0A) break;	// '\n'
-
-		  /* Check if Content-Type is present */
-		  Str_GetNextStrFromFileConvertingToLower (Gbl.F.Tmp,StrAux,
-		                                           Par_LENGTH_OF_STR_CONTENT_TYPE);
-		  if (!strcasecmp (StrAux,StringContentType)) // Start of Content-Type
-		    {
-		     /* Get content type */
-		     CurPos = (unsigned long) ftell (Gbl.F.Tmp);	// At start of content type
-		     Param->ContentType.Start = CurPos;
-		     Ch = Par_ReadTmpFileUntilReturn ();
-		     CurPos = (unsigned long) ftell (Gbl.F.Tmp);	// Just after return
-		     Param->ContentType.Length = CurPos - 1 - Param->ContentType.Start;
-		    }
-		 }
-	      }
+   /***** End parsing stdin *****/
+   Mpt_EndParsing (&Parser);
+   Gbl.Params.QueryString[Par_Gbl.Length] = '\0';
 
-	    /***** Now \r\n\r\n is expected just before parameter value or file content *****/
-	    /* Check if last character read is '\r' */
-	    if (Ch != 0x0D) break;			// '\r'
-
-	    /* Skip \n\r\n */
-	    if (fgetc (Gbl.F.Tmp) != 0x0A) break;	// '\n'
-	    if (fgetc (Gbl.F.Tmp) != 0x0D) break;	// '\r'
-	    if (fgetc (Gbl.F.Tmp) != 0x0A) break;	// '\n'
-
-	    /***** Get parameter value or file content *****/
-	    CurPos = (unsigned long) ftell (Gbl.F.Tmp);	// At start of value or file content
-	    if (Str_ReadFileUntilBoundaryStr (Gbl.F.Tmp,NULL,
-					      Gbl.Boundary.StrWithCRLF,
-					      Gbl.Boundary.LengthWithCRLF,
-					      Fil_MAX_FILE_SIZE) != 1) break;	// Boundary string not found
-
-	    // Delimiter string found
-	    Param->Value.Start = CurPos;
-	    CurPos = (unsigned long) ftell (Gbl.F.Tmp);	// Just after delimiter string
-	    Param->Value.Length = CurPos - Gbl.Boundary.LengthWithCRLF -
-		                  Param->Value.Start;
-	   }
-        }
+   switch (Status)
+     {
+      case Mpt_TOO_LARGE:
+	 Fil_WriteErrorUploadAborted (true);
+	 return false;
+      case Mpt_TIME_EXCEEDED:
+	 Fil_WriteErrorUploadAborted (false);
+	 return false;
+      case Mpt_TRUNCATED:
+	 Fil_EndOfReadingStdin ();
+	 Lay_ShowErrorAndExit ("Incomplete data received.");
+	 return false;
+      default:
+	 Fil_EndOfReadingStdin ();	// Skip epilogue after final boundary
+	 return true;
+     }
   }
 
 /*****************************************************************************/
-/******************** Read from file until quote '\"' ************************/
+/********* Write file content of a parameter into a temporary file ***********/
 /*****************************************************************************/
-// Return last char read
 
-static int Par_ReadTmpFileUntilQuote (void)
+static void Par_StoreFileOfParam (struct Mpt_Parser *Parser,struct Param *Param)
   {
-   int Ch;
+   FILE *FileTmp;
+   const char *Data;
+   size_t Length;
 
-   /***** Read until quote if found *****/
-   do
-      Ch = fgetc (Gbl.F.Tmp);
-   while (Ch != EOF && Ch != (int) '\"');
+   /***** Create temporary file *****/
+   if ((FileTmp = Fil_CreateTmpFileForUpload (&Param->PathTmpFile)) == NULL)
+     {
+      Fil_EndOfReadingStdin ();
+      Lay_ShowErrorAndExit ("Can not create temporary file.");
+     }
 
-   return Ch;
+   /***** Write data as they arrive *****/
+   while (Mpt_GetDataOfPart (Parser,&Data,&Length) == Mpt_OK)
+     {
+      if (fwrite (Data,1,Length,FileTmp) != Length)
+	{
+	 fclose (FileTmp);
+	 Fil_EndOfReadingStdin ();
+	 Lay_ShowErrorAndExit ("Can not write temporary file.");
+	}
+      Param->Value.Length += Length;
+     }
+
+   /***** Close temporary file *****/
+   fclose (FileTmp);
   }
 
 /*****************************************************************************/
-/*************************** Read from file until \r *************************/
+/**** Append data to names and values of parameters received as multipart ****/
 /*****************************************************************************/
-// Return last char read
 
-static int Par_ReadTmpFileUntilReturn (void)
+static struct StartLength Par_AppendToMultipartData (const char *Data,size_t Length)
   {
-   int Ch;
+   struct StartLength Result;
 
-   /***** Read until \r if found *****/
-   do
-      Ch = fgetc (Gbl.F.Tmp);
-   while (Ch != EOF && Ch != 0x0D);	// '\r'
+   /***** Names and values of parameters must not be too long,
+          in order not to exhaust memory *****/
+   if (Par_Gbl.Length + Length + 1 > Par_MAX_BYTES_MULTIPART_DATA)
+     {
+      Fil_EndOfReadingStdin ();
+      Lay_ShowErrorAndExit ("Parameters too long.");
+     }
 
-   return Ch;
+   /***** Enlarge memory if necessary, leaving space for final NULL *****/
+   if (Par_Gbl.Length + Length + 1 > Par_Gbl.Size)
+     {
+      while (Par_Gbl.Length + Length + 1 > Par_Gbl.Size)
+	 Par_Gbl.Size *= 2;
+      if ((Gbl.Params.QueryString = (char *) realloc (Gbl.Params.QueryString,
+						      Par_Gbl.Size)) == NULL)
+	{
+	 Fil_EndOfReadingStdin ();
+	 Lay_ShowErrorAndExit ("Error allocating memory for parameters.");
+	}
+     }
+
+   /***** Append data *****/
+   Result.Start  = Par_Gbl.Length;
+   Result.Length = Length;
+   if (Length)
+      memcpy (&Gbl.Params.QueryString[Par_Gbl.Length],Data,Length);
+   Par_Gbl.Length += Length;
+
+   return Result;
   }
 
 /*****************************************************************************/
@@ -472,12 +506,23 @@ void Par_FreeParams (void)
 	Param = NextParam)
      {
       NextParam = Param->Next;
+      if (Param->PathTmpFile)
+	{
+	 /* Remove temporary file if not moved to its destination */
+	 if (Param->PathTmpFile[0])
+	    unlink (Param->PathTmpFile);
+	 free (Param->PathTmpFile);
+	}
       free (Param);
      }
+   Gbl.Params.List = NULL;
 
    /***** Free query string *****/
    if (Gbl.Params.QueryString)
+     {
       free (Gbl.Params.QueryString);
+      Gbl.Params.QueryString = NULL;
+     }
   }
 
 /*****************************************************************************/
@@ -493,7 +538,6 @@ unsigned Par_GetParameter (tParamType ParamType,const char *ParamName,
   {
    extern const char *Par_SEPARATOR_PARAM_MULTIPLE;
    size_t BytesAlreadyCopied = 0;
-   unsigned i;
    struct Param *Param;
    char *PtrDst;
    unsigned NumTimes;
@@ -530,21 +574,9 @@ unsigned Par_GetParameter (tParamType ParamType,const char *ParamName,
 	   {
 	    // The current element in the list has the length of the searched parameter
 	    // Check if the name of the parameter is the same
-	    switch (Gbl.ContentReceivedByCGI)
-	      {
-	       case Act_CONT_NORM:
-		  ParamFound = !strncmp (ParamName,&Gbl.Params.QueryString[Param->Name.Start],
-					 Param->Name.Length);
-		  break;
-	       case Act_CONT_DATA:
-		  fseek (Gbl.F.Tmp,Param->Name.Start,SEEK_SET);
-		  for (i = 0, ParamFound = true;
-		       i < Param->Name.Length && ParamFound;
-		       i++)
-		     if (ParamName[i] != (char) fgetc (Gbl.F.Tmp))
-			ParamFound = false;
-		  break;
-	      }
+	    // (also when receiving multipart data, names are stored in query string)
+	    ParamFound = !strncmp (ParamName,&Gbl.Params.QueryString[Param->Name.Start],
+				   Param->Name.Length);
 
 	    if (ParamFound)
 	      {
@@ -556,7 +588,7 @@ unsigned Par_GetParameter (tParamType ParamType,const char *ParamName,
 		     *ParamPtr = Param;
 
 		  /***** If this parameter is a file ==> do not find more ocurrences ******/
-		  if (Param->FileName.Start != 0)	// It's a file
+		  if (Param->PathTmpFile)	// It's a file
 		     FindMoreThanOneOcurrence = false;
 		 }
 	       else			// NumTimes > 1 ==> not the first ocurrence of this parameter
@@ -600,14 +632,10 @@ unsigned Par_GetParameter (tParamType ParamType,const char *ParamName,
 				    Param->Value.Length);
 			break;
 		     case Act_CONT_DATA:
-		        if (Param->FileName.Start == 0 &&	// Copy into destination only if it's not a file
+		        if (!Param->PathTmpFile &&	// Copy into destination only if it's not a file
 		            PtrDst)
-		          {
-			   fseek (Gbl.F.Tmp,Param->Value.Start,SEEK_SET);
-			   if (fread (PtrDst,sizeof (char),Param->Value.Length,Gbl.F.Tmp) !=
-			       Param->Value.Length)
-			      Lay_ShowErrorAndExit ("Error while getting value of parameter.");
-		          }
+			   memcpy (PtrDst,&Gbl.Params.QueryString[Param->Value.Start],
+				   Param->Value.Length);
 			break;
 		    }
 		  BytesAlreadyCopied += Param->Value.Length;
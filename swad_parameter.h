@@ -50,6 +50,7 @@ struct Param
    struct StartLength FileName;		// optional, present only when uploading files
    struct StartLength ContentType;	// optional, present only when uploading files
    struct StartLength Value;		// Parameter value or file content
+   char *PathTmpFile;			// Temporary file with file content, present only when uploading files
    struct Param *Next;
   };
 
@@ -29,8 +29,6 @@
 #include <stdio.h>		// For asprintf
 #include <stdlib.h>		// For system, getenv, etc.
 #include <string.h>		// For string functions
-#include <sys/wait.h>		// For the macro WEXITSTATUS
-#include <unistd.h>		// For unlink
 
 #include "swad_box.h"
 #include "swad_database.h"
@@ -412,11 +410,6 @@ int Pwd_SendNewPasswordByEmail (char NewRandomPlainPassword[Pwd_MAX_BYTES_PLAIN_
   {
    extern const char *Txt_The_following_password_has_been_assigned_to_you_to_log_in_X_NO_HTML;
    extern const char *Txt_New_password_NO_HTML[1 + Lan_NUM_LANGUAGES];
-   char Command[2048 +
-		Cfg_MAX_BYTES_SMTP_PASSWORD +
-		Cns_MAX_BYTES_EMAIL_ADDRESS +
-		PATH_MAX]; // Command to execute for sending an email
-   int ReturnCode;
 
    /***** Create temporary file for mail content *****/
    Mai_CreateFileNameMail ();
@@ -439,27 +432,12 @@ int Pwd_SendNewPasswordByEmail (char NewRandomPlainPassword[Pwd_MAX_BYTES_PLAIN_
 
    fclose (Gbl.Msg.FileMail);
 
-   /***** Call the script to send an email *****/
-   snprintf (Command,sizeof (Command),
-	     "%s \"%s\" \"%s\" \"%s\" \"%s\" \"%s\" \"[%s] %s\" \"%s\"",
-	     Cfg_COMMAND_SEND_AUTOMATIC_EMAIL,
-	     Cfg_AUTOMATIC_EMAIL_SMTP_SERVER,
-	     Cfg_AUTOMATIC_EMAIL_SMTP_PORT,
-	     Cfg_AUTOMATIC_EMAIL_FROM,
-             Gbl.Config.SMTPPassword,
-	     Gbl.Usrs.Me.UsrDat.Email,
-	     Cfg_PLATFORM_SHORT_NAME,
-	     Txt_New_password_NO_HTML[Gbl.Usrs.Me.UsrDat.Prefs.Language],
-	     Gbl.Msg.FileNameMail);
-   ReturnCode = system (Command);
-   if (ReturnCode == -1)
-      Lay_ShowErrorAndExit ("Error when running script to send email.");
-
-   /***** Remove temporary file *****/
-   unlink (Gbl.Msg.FileNameMail);
-
-   /***** Write message depending on return code *****/
-   return WEXITSTATUS (ReturnCode);
+   /***** Send the email now.
+	  It is not stored in mail queue
+	  to not store the new password in database *****/
+   return Mai_SendMailMsg (Gbl.Usrs.Me.UsrDat.Email,
+			   Txt_New_password_NO_HTML[Gbl.Usrs.Me.UsrDat.Prefs.Language],
+			   Mai_SEND_NOW);
   }
 
 /*****************************************************************************/
@@ -26,12 +26,16 @@
 /*****************************************************************************/
 
 #define _GNU_SOURCE 		// For asprintf
+#include <errno.h>		// For errno
 #include <linux/limits.h>	// For PATH_MAX
 #include <math.h>		// For log10, floor, ceil, modf, sqrt...
 #include <stddef.h>		// For NULL
 #include <stdio.h>		// For asprintf
 #include <stdlib.h>		// For system, getenv, etc.
 #include <string.h>		// For string functions
+#include <sys/socket.h>		// For socket, connect
+#include <sys/time.h>		// For struct timeval
+#include <sys/un.h>		// For sockaddr_un
 #include <sys/wait.h>		// For the macro WEXITSTATUS
 #include <unistd.h>		// For unlink
 
@@ -68,6 +72,10 @@ extern struct Globals Gbl;
 /***************************** Private constants *****************************/
 /*****************************************************************************/
 
+#define Pho_MAX_FACES 128	// Maximum number of faces detected in a photo
+
+#define Pho_SECONDS_TIMEOUT_FACE_DETECTION 60	// Maximum time waiting for the resident service
+
 static const char *Pho_StrAvgPhotoDirs[Pho_NUM_AVERAGE_PHOTO_TYPES] =
   {
    Cfg_FOLDER_DEGREE_PHOTO_MEDIAN,
@@ -83,6 +91,15 @@ static const char *Pho_StrAvgPhotoPrograms[Pho_NUM_AVERAGE_PHOTO_TYPES] =
 /******************************* Private types *******************************/
 /*****************************************************************************/
 
+struct Pho_Face
+  {
+   unsigned X;			// Center and radius of circle in image map
+   unsigned Y;
+   unsigned Radius;
+   unsigned BackgroundCode;	// 1 ==> white background ("green" face)
+   char FileName[NAME_MAX + 1];	// Example: "4924a838630e_016"
+  };
+
 /*****************************************************************************/
 /***************************** Private variables *****************************/
 /*****************************************************************************/
@@ -98,10 +115,21 @@ static void Pho_ReqOtherUsrPhoto (void);
 static void Pho_ReqPhoto (const struct UsrData *UsrDat);
 
 static bool Pho_ReceivePhotoAndDetectFaces (bool ItsMe,const struct UsrData *UsrDat);
+static int Pho_DetectFaces (const char *FileNamePhotoTmp,
+                            struct Pho_Face Faces[Pho_MAX_FACES],unsigned *NumFaces);
+#ifdef Cfg_FACE_DETECTION_SOCKET
+static int Pho_DetectFacesUsingService (const char *FileNamePhotoTmp,
+                                        struct Pho_Face Faces[Pho_MAX_FACES],unsigned *NumFaces);
+#endif
+static int Pho_DetectFacesUsingCommand (const char *FileNamePhotoTmp,
+                                        struct Pho_Face Faces[Pho_MAX_FACES],unsigned *NumFaces);
+static void Pho_ReadFaces (FILE *FileFaces,
+                           struct Pho_Face Faces[Pho_MAX_FACES],unsigned *NumFaces);
 
 static void Pho_UpdatePhoto1 (struct UsrData *UsrDat);
 static void Pho_UpdatePhoto2 (void);
 static void Pho_ClearPhotoName (long UsrCod);
+static bool Pho_CreatePublicLinkToPhoto (long UsrCod,const char *Photo);
 
 static long Pho_GetDegWithAvgPhotoLeastRecentlyUpdated (void);
 static long Pho_GetTimeAvgPhotoWasComputed (long DegCod);
@@ -575,12 +603,11 @@ static bool Pho_ReceivePhotoAndDetectFaces (bool ItsMe,const struct UsrData *Usr
    char FileNamePhotoSrc[PATH_MAX + 1];
    char FileNamePhotoTmp[PATH_MAX + 1];	// Full name (including path and .jpg) of the destination temporary file
    char FileNamePhotoMap[PATH_MAX + 1];	// Full name (including path) of the temporary file with the original image with faces
-   char FileNameTxtMap[PATH_MAX + 1];	// Full name (including path) of the temporary file with the text neccesary to make the image map
    char PathRelPhoto[PATH_MAX + 1];
-   FILE *FileTxtMap = NULL;		// Temporary file with the text neccesary to make the image map. Initialized to avoid warning
    char MIMEType[Brw_MAX_BYTES_MIME_TYPE + 1];
    bool WrongType = false;
-   char Command[256 + PATH_MAX];	// Command to call the program of preprocessing of photos
+   struct Pho_Face Faces[Pho_MAX_FACES];	// Faces detected, with the text neccesary to make the image map
+   unsigned NumFaces = 0;
    int ReturnCode;
    int NumLastForm = 0;	// Initialized to avoid warning
    char FormId[32];
@@ -588,11 +615,7 @@ static bool Pho_ReceivePhotoAndDetectFaces (bool ItsMe,const struct UsrData *Usr
    unsigned NumFacesGreen = 0;
    unsigned NumFacesRed = 0;
    unsigned NumFace;
-   unsigned X;
-   unsigned Y;
-   unsigned Radius;
-   unsigned BackgroundCode;
-   char StrFileName[NAME_MAX + 1];
+   unsigned NumFaceGreen;
    Act_Action_t NextAction;
    char ErrorTxt[256];
 
@@ -612,7 +635,7 @@ static bool Pho_ReceivePhotoAndDetectFaces (bool ItsMe,const struct UsrData *Usr
    /* Create temporary directory for photos */
    Fil_CreateDirIfNotExists (Cfg_PATH_PHOTO_TMP_PUBLIC);
 
-   /***** First of all, copy in disk the file received from stdin (really from Gbl.F.Tmp) *****/
+   /***** First of all, copy in disk the file received from stdin (really from a temporary file) *****/
    Param = Fil_StartReceptionOfFile (Fil_NAME_OF_PARAM_FILENAME_ORG,
                                      FileNamePhotoSrc,MIMEType);
 
@@ -649,35 +672,20 @@ static bool Pho_ReceivePhotoAndDetectFaces (bool ItsMe,const struct UsrData *Usr
              (unsigned) (UsrDat->UsrCod % 100),UsrDat->UsrCod);
    Fil_FastCopyOfFiles (FileNamePhotoTmp,PathRelPhoto);
 
-   /***** Call to program that makes photo processing / face detection *****/
-   snprintf (Command,sizeof (Command),
-	     Cfg_COMMAND_FACE_DETECTION,
-	     FileNamePhotoTmp);
-   ReturnCode = system (Command);
-   if (ReturnCode == -1)
-      Lay_ShowErrorAndExit ("Error when running command to process photo and detect faces.");
+   /***** Photo processing / face detection *****/
+   ReturnCode = Pho_DetectFaces (FileNamePhotoTmp,Faces,&NumFaces);
 
    /***** Write message depending on return code *****/
-   ReturnCode = WEXITSTATUS(ReturnCode);
    switch (ReturnCode)
      {
       case 0:        // Faces detected
-         /***** Open text file with text for image map *****/
-         snprintf (FileNameTxtMap,sizeof (FileNameTxtMap),
-                   "%s/%s_map.txt",
-                   Cfg_PATH_PHOTO_TMP_PUBLIC,
-		   Gbl.UniqueNameEncrypted);
-         if ((FileTxtMap = fopen (FileNameTxtMap,"rb")) == NULL)
-            Lay_ShowErrorAndExit ("Can not read text file with coordinates of detected faces.");
-
-         /***** Read file with coordinates for image map and compute the number of faces *****/
+         /***** Put a form for each face and compute the number of faces *****/
          NumLastForm = Gbl.Form.Num;
-         while (!feof (FileTxtMap))
+         for (NumFace = 0;
+              NumFace < NumFaces;
+              NumFace++)
            {
-            if (fscanf (FileTxtMap,"%u %u %u %u %s\n",&X,&Y,&Radius,&BackgroundCode,StrFileName) != 5)        // Example of StrFileName = "4924a838630e_016"
-
-               break;
-            if (BackgroundCode == 1)
+            if (Faces[NumFace].BackgroundCode == 1)
               {
                NumFacesGreen++;
                if (ItsMe)
@@ -700,7 +708,7 @@ static bool Pho_ReceivePhotoAndDetectFaces (bool ItsMe,const struct UsrData *Usr
 		  Frm_StartForm (NextAction);
                   Usr_PutParamUsrCodEncrypted (UsrDat->EncryptedUsrCod);
         	 }
-               Par_PutHiddenParamString (NULL,"FileName",StrFileName);
+               Par_PutHiddenParamString (NULL,"FileName",Faces[NumFace].FileName);
                Frm_EndForm ();
               }
             else
@@ -753,27 +761,25 @@ static bool Pho_ReceivePhotoAndDetectFaces (bool ItsMe,const struct UsrData *Usr
    HTM_Txt ("<map name=\"faces_map\">\n");
    if (NumFacesTotal)
      {
-      /***** Read again the file with coordinates and create area shapes *****/
-      rewind (FileTxtMap);
-      for (NumFace = 0; !feof (FileTxtMap);)
-        {
-         if (fscanf (FileTxtMap,"%u %u %u %u %s\n",&X,&Y,&Radius,&BackgroundCode,StrFileName) != 5)
-            break;
-         if (BackgroundCode == 1)
+      /***** Create area shapes from coordinates of faces *****/
+      for (NumFace = 0, NumFaceGreen = 0;
+	   NumFace < NumFaces;
+	   NumFace++)
+         if (Faces[NumFace].BackgroundCode == 1)
            {
-            NumFace++;
+            NumFaceGreen++;
             snprintf (FormId,sizeof (FormId),
         	      "form_%d",
-		      NumLastForm + NumFace);
+		      NumLastForm + NumFaceGreen);
             HTM_TxtF ("<area shape=\"circle\""
                       " href=\"\""
                       " onclick=\"javascript:document.getElementById('%s').submit();return false;\""
                       " coords=\"%u,%u,%u\">\n",
-                      FormId,X,Y,Radius);
+                      FormId,
+                      Faces[NumFace].X,
+                      Faces[NumFace].Y,
+                      Faces[NumFace].Radius);
            }
-        }
-      /***** Close text file with text for image map *****/
-      fclose (FileTxtMap);
      }
    HTM_Txt ("</map>\n");
 
@@ -797,6 +803,142 @@ static bool Pho_ReceivePhotoAndDetectFaces (bool ItsMe,const struct UsrData *Usr
    return (NumFacesGreen != 0);
   }
 
+/*****************************************************************************/
+/************************ Detect faces in a photo ****************************/
+/*****************************************************************************/
+// Return code: 0 ==> faces detected, 1 ==> no faces detected, other ==> error
+// Faces are returned in memory, so no text file is written or read
+// when the resident service is running
+
+static int Pho_DetectFaces (const char *FileNamePhotoTmp,
+                            struct Pho_Face Faces[Pho_MAX_FACES],unsigned *NumFaces)
+  {
+#ifdef Cfg_FACE_DETECTION_SOCKET
+   int ReturnCode;
+
+   /***** Ask the resident service, with the classifier already loaded *****/
+   if ((ReturnCode = Pho_DetectFacesUsingService (FileNamePhotoTmp,
+                                                  Faces,NumFaces)) >= 0)
+      return ReturnCode;
+#endif
+
+   /***** Service not available ==> run one process for this photo *****/
+   return Pho_DetectFacesUsingCommand (FileNamePhotoTmp,Faces,NumFaces);
+  }
+
+/*****************************************************************************/
+/*************** Detect faces using the resident service *********************/
+/*****************************************************************************/
+// Request:  a line with the full path of the photo
+// Response: a line with the return code, followed by a line for each face
+// Return -1 if the service is not available
+
+#ifdef Cfg_FACE_DETECTION_SOCKET
+static int Pho_DetectFacesUsingService (const char *FileNamePhotoTmp,
+                                        struct Pho_Face Faces[Pho_MAX_FACES],unsigned *NumFaces)
+  {
+   struct sockaddr_un Addr;
+   struct timeval Timeout;
+   int Socket;
+   FILE *FileFaces;
+   int ReturnCode;
+
+   /***** Connect to service *****/
+   memset (&Addr,0,sizeof (Addr));
+   Addr.sun_family = AF_UNIX;
+   Str_Copy (Addr.sun_path,Cfg_FACE_DETECTION_SOCKET,
+             sizeof (Addr.sun_path) - 1);
+   if ((Socket = socket (AF_UNIX,SOCK_STREAM,0)) < 0)
+      return -1;
+   Timeout.tv_sec  = Pho_SECONDS_TIMEOUT_FACE_DETECTION;
+   Timeout.tv_usec = 0;
+   setsockopt (Socket,SOL_SOCKET,SO_RCVTIMEO,&Timeout,sizeof (Timeout));
+   if (connect (Socket,(struct sockaddr *) &Addr,sizeof (Addr)))
+     {
+      close (Socket);
+      return -1;
+     }
+   if ((FileFaces = fdopen (Socket,"r+")) == NULL)
+     {
+      close (Socket);
+      return -1;
+     }
+
+   /***** Send path of photo and get return code *****/
+   fprintf (FileFaces,"%s\n",FileNamePhotoTmp);
+   fflush (FileFaces);
+   shutdown (Socket,SHUT_WR);
+   if (fscanf (FileFaces,"%d\n",&ReturnCode) != 1)
+     {
+      fclose (FileFaces);
+      return -1;
+     }
+
+   /***** Get faces *****/
+   if (ReturnCode == 0)
+      Pho_ReadFaces (FileFaces,Faces,NumFaces);
+
+   fclose (FileFaces);
+   return ReturnCode;
+  }
+#endif
+
+/*****************************************************************************/
+/************ Detect faces calling a new process for this photo **************/
+/*****************************************************************************/
+
+static int Pho_DetectFacesUsingCommand (const char *FileNamePhotoTmp,
+                                        struct Pho_Face Faces[Pho_MAX_FACES],unsigned *NumFaces)
+  {
+   char Command[256 + PATH_MAX];	// Command to call the program of preprocessing of photos
+   char FileNameTxtMap[PATH_MAX + 1];	// Full name (including path) of the temporary file with the text neccesary to make the image map
+   FILE *FileTxtMap;
+   int ReturnCode;
+
+   /***** Call to program that makes photo processing / face detection *****/
+   snprintf (Command,sizeof (Command),
+	     Cfg_COMMAND_FACE_DETECTION,
+	     FileNamePhotoTmp);
+   ReturnCode = system (Command);
+   if (ReturnCode == -1)
+      Lay_ShowErrorAndExit ("Error when running command to process photo and detect faces.");
+   ReturnCode = WEXITSTATUS(ReturnCode);
+
+   /***** Read text file with coordinates for image map *****/
+   if (ReturnCode == 0)
+     {
+      snprintf (FileNameTxtMap,sizeof (FileNameTxtMap),
+		"%s/%s_map.txt",
+		Cfg_PATH_PHOTO_TMP_PUBLIC,
+		Gbl.UniqueNameEncrypted);
+      if ((FileTxtMap = fopen (FileNameTxtMap,"rb")) == NULL)
+	 Lay_ShowErrorAndExit ("Can not read text file with coordinates of detected faces.");
+      Pho_ReadFaces (FileTxtMap,Faces,NumFaces);
+      fclose (FileTxtMap);
+     }
+
+   return ReturnCode;
+  }
+
+/*****************************************************************************/
+/******************* Read coordinates and names of faces *********************/
+/*****************************************************************************/
+
+static void Pho_ReadFaces (FILE *FileFaces,
+                           struct Pho_Face Faces[Pho_MAX_FACES],unsigned *NumFaces)
+  {
+   for (*NumFaces = 0;
+	*NumFaces < Pho_MAX_FACES;
+	(*NumFaces)++)
+      if (fscanf (FileFaces,"%u %u %u %u %255s\n",	// 255 == NAME_MAX
+		  &Faces[*NumFaces].X,
+		  &Faces[*NumFaces].Y,
+		  &Faces[*NumFaces].Radius,
+		  &Faces[*NumFaces].BackgroundCode,
+		  Faces[*NumFaces].FileName) != 5)
+	 break;
+  }
+
 /*****************************************************************************/
 /***************************** Update my photo *******************************/
 /*****************************************************************************/
@@ -997,35 +1139,17 @@ bool Pho_ShowingUsrPhotoIsAllowed (struct UsrData *UsrDat,char PhotoURL[PATH_MAX
   }
 
 /*****************************************************************************/
-/***************** Create a public link to a private photo *******************/
+/************** Build the URL of the public link to a photo ******************/
 /*****************************************************************************/
 // Returns false if photo does not exist
-// Returns true if link is created successfully
+// Returns true if photo exists
+// The public link is created when the photo is received
+// (or by housekeeping, if missing), so no system call is made here
 
 bool Pho_BuildLinkToPhoto (const struct UsrData *UsrDat,char PhotoURL[PATH_MAX + 1])
   {
-   char PathPublPhoto[PATH_MAX + 1];
-   char PathPrivPhoto[PATH_MAX + 1];
-
    if (UsrDat->Photo[0])
      {
-      /***** Make path to public photo *****/
-      snprintf (PathPublPhoto,sizeof (PathPublPhoto),
-	        "%s/%s.jpg",
-                Cfg_PATH_PHOTO_PUBLIC,UsrDat->Photo);
-
-      /***** Make path to private photo from public directory *****/
-      snprintf (PathPrivPhoto,sizeof (PathPrivPhoto),
-	        "%s/%02u/%ld.jpg",
-                Cfg_PATH_PHOTO_PRIVATE,
-                (unsigned) (UsrDat->UsrCod % 100),UsrDat->UsrCod);
-
-      /***** Create a symbolic link to the private photo, if not exists *****/
-      if (!Fil_CheckIfPathExists (PathPublPhoto))
-         if (symlink (PathPrivPhoto,PathPublPhoto) != 0)
-            Lay_ShowErrorAndExit ("Can not create public link"
-                                 " to access to user's private photo");
-
       /***** Create the public URL of the photo *****/
       snprintf (PhotoURL,PATH_MAX + 1,
 	        "%s/%s.jpg",
@@ -1154,6 +1278,73 @@ void Pho_UpdatePhotoName (struct UsrData *UsrDat)
    /***** Update photo name in user's data *****/
    Str_Copy (UsrDat->Photo,Gbl.UniqueNameEncrypted,
              Cry_BYTES_ENCRYPTED_STR_SHA256_BASE64);
+
+   /***** Create the new symbolic link to photo *****/
+   if (!Pho_CreatePublicLinkToPhoto (UsrDat->UsrCod,UsrDat->Photo))
+      Lay_ShowErrorAndExit ("Can not create public link"
+			    " to access to user's private photo");
+  }
+
+/*****************************************************************************/
+/************** Create a public link to a user's private photo ***************/
+/*****************************************************************************/
+// Returns true if link is created or already exists
+
+static bool Pho_CreatePublicLinkToPhoto (long UsrCod,const char *Photo)
+  {
+   char PathPublPhoto[PATH_MAX + 1];
+   char PathPrivPhoto[PATH_MAX + 1];
+
+   /***** Make path to public photo *****/
+   snprintf (PathPublPhoto,sizeof (PathPublPhoto),
+	     "%s/%s.jpg",
+	     Cfg_PATH_PHOTO_PUBLIC,Photo);
+
+   /***** Make path to private photo from public directory *****/
+   snprintf (PathPrivPhoto,sizeof (PathPrivPhoto),
+	     "%s/%02u/%ld.jpg",
+	     Cfg_PATH_PHOTO_PRIVATE,
+	     (unsigned) (UsrCod % 100),UsrCod);
+
+   /***** Create a symbolic link to the private photo, if not exists *****/
+   if (symlink (PathPrivPhoto,PathPublPhoto) != 0)
+      return (errno == EEXIST);
+   return true;
+  }
+
+/*****************************************************************************/
+/******** Check public links to photos of all users and repair them **********/
+/*****************************************************************************/
+// Called periodically by housekeeping.
+// Create links missing because they were removed by hand,
+// or because photos were received before links were created on reception
+
+void Pho_RepairPublicLinksToPhotos (void)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumUsrs;
+   unsigned long NumUsr;
+
+   /***** Get all users with photo *****/
+   NumUsrs = DB_QuerySELECT (&mysql_res,"can not get users with photo",
+			     "SELECT UsrCod,Photo FROM usr_data"
+			     " WHERE Photo<>''");
+
+   /***** Create missing links *****/
+   Fil_CreateDirIfNotExists (Cfg_PATH_PHOTO_PUBLIC);
+   for (NumUsr = 0;
+	NumUsr < NumUsrs;
+	NumUsr++)
+     {
+      row = mysql_fetch_row (mysql_res);
+
+      /* Get user's code (row[0]) and photo name (row[1]) */
+      Pho_CreatePublicLinkToPhoto (Str_ConvertStrCodToLongCod (row[0]),row[1]);
+     }
+
+   /***** Free structure that stores the query result *****/
+   DB_FreeMySQLResult (&mysql_res);
   }
 
 /*****************************************************************************/
@@ -0,0 +1,259 @@
+// swad_prepared_bench_main.c: main of swad_prepared_bench, cost of prepared statements
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <stdio.h>		// For fprintf, snprintf
+#include <stdlib.h>		// For atoi, exit
+#include <string.h>		// For memset, strlen
+
+#include "swad_bench.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define PrB_NUM_SESSIONS	1000
+
+#define PrB_QUERY_PLAIN "SELECT COUNT(*) FROM bench_sessions WHERE SessionId='%s'"
+#define PrB_QUERY_STMT	"SELECT COUNT(*) FROM bench_sessions WHERE SessionId=?"
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void PrB_CreateTable (void);
+static void PrB_BuildSessionId (unsigned NumQuery,char SessionId[16 + 1]);
+static double PrB_QueryPlain (unsigned long NumQueries);
+static double PrB_QueryPreparedEachTime (unsigned long NumQueries);
+static double PrB_QueryPreparedOnce (unsigned long NumQueries);
+static MYSQL_STMT *PrB_PrepareStmt (void);
+static void PrB_ExecuteStmt (MYSQL_STMT *Stmt,const char *SessionId);
+static void PrB_ExitOnStmtError (MYSQL_STMT *Stmt);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_prepared_bench <host> <user> <password> <database> <queries>
+   The same query to check a session (as done in every request)
+   is made the given number of times:
+   1. as a plain query (a process serving only one request),
+   2. preparing, executing and closing a statement each time
+      (what a process serving only one request did before),
+   3. preparing the statement only once (a persistent worker).
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumQueries;
+
+   if (argc != 1 + Bch_NUM_ARGS_DB + 1 ||
+       (NumQueries = atoi (argv[1 + Bch_NUM_ARGS_DB])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s " Bch_USAGE_DB " <queries>\n",argv[0]);
+      return 1;
+     }
+
+   Bch_ConnectToDB (&argv[1]);
+   PrB_CreateTable ();
+
+   Bch_WriteTime ("Plain query",
+                  (unsigned long) NumQueries,
+                  PrB_QueryPlain ((unsigned long) NumQueries));
+   Bch_WriteTime ("Prepare, execute and close statement",
+                  (unsigned long) NumQueries,
+                  PrB_QueryPreparedEachTime ((unsigned long) NumQueries));
+   Bch_WriteTime ("Execute statement prepared once",
+                  (unsigned long) NumQueries,
+                  PrB_QueryPreparedOnce ((unsigned long) NumQueries));
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_sessions");
+   Bch_DisconnectFromDB ();
+   return 0;
+  }
+
+/*****************************************************************************/
+/******************* Create a table similar to sessions **********************/
+/*****************************************************************************/
+
+static void PrB_CreateTable (void)
+  {
+   unsigned NumSession;
+   char SessionId[16 + 1];
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_sessions");
+   Bch_Query ("CREATE TABLE bench_sessions ("
+		 "SessionId CHAR(43) NOT NULL,"
+		 "UsrCod INT NOT NULL,"
+		 "LastTime DATETIME,"
+	      "UNIQUE INDEX(SessionId))");
+   for (NumSession = 0;
+	NumSession < PrB_NUM_SESSIONS;
+	NumSession++)
+     {
+      PrB_BuildSessionId (NumSession,SessionId);
+      Bch_Query ("INSERT INTO bench_sessions (SessionId,UsrCod,LastTime)"
+	         " VALUES ('%s',%u,NOW())",
+		 SessionId,NumSession + 1);
+     }
+  }
+
+/*****************************************************************************/
+/********************* Build a session identifier ****************************/
+/*****************************************************************************/
+
+static void PrB_BuildSessionId (unsigned NumQuery,char SessionId[16 + 1])
+  {
+   snprintf (SessionId,16 + 1,"%016u",NumQuery % PrB_NUM_SESSIONS);
+  }
+
+/*****************************************************************************/
+/******************************* Plain queries *******************************/
+/*****************************************************************************/
+
+static double PrB_QueryPlain (unsigned long NumQueries)
+  {
+   unsigned long NumQuery;
+   char SessionId[16 + 1];
+   double Start = Bch_GetSeconds ();
+
+   for (NumQuery = 0;
+	NumQuery < NumQueries;
+	NumQuery++)
+     {
+      PrB_BuildSessionId (NumQuery,SessionId);
+      Bch_QueryCOUNT (PrB_QUERY_PLAIN,SessionId);
+     }
+
+   return Bch_GetSeconds () - Start;
+  }
+
+/*****************************************************************************/
+/************** Prepare, execute and close statement each time ***************/
+/*****************************************************************************/
+
+static double PrB_QueryPreparedEachTime (unsigned long NumQueries)
+  {
+   unsigned long NumQuery;
+   char SessionId[16 + 1];
+   MYSQL_STMT *Stmt;
+   double Start = Bch_GetSeconds ();
+
+   for (NumQuery = 0;
+	NumQuery < NumQueries;
+	NumQuery++)
+     {
+      PrB_BuildSessionId (NumQuery,SessionId);
+      Stmt = PrB_PrepareStmt ();
+      PrB_ExecuteStmt (Stmt,SessionId);
+      mysql_stmt_close (Stmt);
+     }
+
+   return Bch_GetSeconds () - Start;
+  }
+
+/*****************************************************************************/
+/******************** Execute a statement prepared once **********************/
+/*****************************************************************************/
+
+static double PrB_QueryPreparedOnce (unsigned long NumQueries)
+  {
+   unsigned long NumQuery;
+   char SessionId[16 + 1];
+   MYSQL_STMT *Stmt;
+   double Start = Bch_GetSeconds ();
+
+   Stmt = PrB_PrepareStmt ();
+   for (NumQuery = 0;
+	NumQuery < NumQueries;
+	NumQuery++)
+     {
+      PrB_BuildSessionId (NumQuery,SessionId);
+      PrB_ExecuteStmt (Stmt,SessionId);
+     }
+   mysql_stmt_close (Stmt);
+
+   return Bch_GetSeconds () - Start;
+  }
+
+/*****************************************************************************/
+/************************* Prepare the statement *****************************/
+/*****************************************************************************/
+
+static MYSQL_STMT *PrB_PrepareStmt (void)
+  {
+   MYSQL_STMT *Stmt;
+
+   if ((Stmt = mysql_stmt_init (Bch_GetDB ())) == NULL)
+     {
+      fprintf (stderr,"Can not init statement.\n");
+      exit (1);
+     }
+   if (mysql_stmt_prepare (Stmt,PrB_QUERY_STMT,
+			   (unsigned long) strlen (PrB_QUERY_STMT)))
+      PrB_ExitOnStmtError (Stmt);
+
+   return Stmt;
+  }
+
+/*****************************************************************************/
+/************** Execute the statement and get the only result ****************/
+/*****************************************************************************/
+
+static void PrB_ExecuteStmt (MYSQL_STMT *Stmt,const char *SessionId)
+  {
+   MYSQL_BIND Param;
+   MYSQL_BIND Result;
+   unsigned long Length = (unsigned long) strlen (SessionId);
+   unsigned long long Count;
+
+   memset (&Param,0,sizeof (Param));
+   Param.buffer_type   = MYSQL_TYPE_STRING;
+   Param.buffer        = (char *) SessionId;
+   Param.buffer_length = Length;
+   Param.length        = &Length;
+   memset (&Result,0,sizeof (Result));
+   Result.buffer_type = MYSQL_TYPE_LONGLONG;
+   Result.buffer      = &Count;
+   Result.is_unsigned = 1;
+
+   if (mysql_stmt_bind_param (Stmt,&Param) ||
+       mysql_stmt_execute (Stmt) ||
+       mysql_stmt_bind_result (Stmt,&Result) ||
+       mysql_stmt_fetch (Stmt) == 1)
+      PrB_ExitOnStmtError (Stmt);
+   mysql_stmt_free_result (Stmt);
+  }
+
+/*****************************************************************************/
+/************************ Write error and exit *******************************/
+/*****************************************************************************/
+
+static void PrB_ExitOnStmtError (MYSQL_STMT *Stmt)
+  {
+   fprintf (stderr,"Statement error: %s.\n",mysql_stmt_error (Stmt));
+   exit (1);
+  }
@@ -0,0 +1,96 @@
+// swad_push.c: push changes in matches to students' browsers
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************* Headers ***********************************/
+/*****************************************************************************/
+
+#include <arpa/inet.h>		// For htons, htonl
+#include <netinet/in.h>		// For sockaddr_in
+#include <stdio.h>		// For snprintf
+#include <string.h>		// For memset
+#include <sys/socket.h>		// For socket, sendto
+
+#include "swad_config.h"
+#include "swad_push.h"
+
+/*****************************************************************************/
+/***************************** Private constants *****************************/
+/*****************************************************************************/
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+/*****************************************************************************/
+/***************************** Private variables *****************************/
+/*****************************************************************************/
+
+static struct
+  {
+   int Socket;	// UDP socket to send notifications to swad_push
+		// It is kept open between requests of a persistent worker
+  } Psh_Gbl =
+  {
+   .Socket = -1,
+  };
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+/*****************************************************************************/
+/******** Notify swad_push the current status of a match being played ********/
+/*****************************************************************************/
+/*
+   A datagram "<MchCod> <Status>" is sent to swad_push in localhost.
+   swad_push sends the status to the browsers subscribed to the match
+   only when it differs from the previous one,
+   so this function can be called on every update of the match.
+   Sending is not blocking and errors are ignored:
+   if swad_push is not running, students' browsers poll the server.
+*/
+void Psh_NotifyMatchStatus (long MchCod,const char *Status)
+  {
+   struct sockaddr_in Addr;
+   char Datagram[1 + 20 + 1 + Psh_MAX_BYTES_STATUS + 1];
+   int Length;
+
+   /***** Open socket the first time *****/
+   if (Psh_Gbl.Socket < 0)
+      if ((Psh_Gbl.Socket = socket (AF_INET,SOCK_DGRAM,0)) < 0)
+	 return;
+
+   /***** Build datagram *****/
+   Length = snprintf (Datagram,sizeof (Datagram),"%ld %s",MchCod,Status);
+   if (Length < 0 || (size_t) Length >= sizeof (Datagram))
+      return;
+
+   /***** Send datagram to swad_push *****/
+   memset (&Addr,0,sizeof (Addr));
+   Addr.sin_family      = AF_INET;
+   Addr.sin_port        = htons (Cfg_PORT_MATCH_PUSH_NOTIFY);
+   Addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+   sendto (Psh_Gbl.Socket,Datagram,(size_t) Length,MSG_DONTWAIT,
+	   (struct sockaddr *) &Addr,sizeof (Addr));
+  }
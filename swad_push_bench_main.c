@@ -0,0 +1,297 @@
+// swad_push_bench_main.c: main of swad_push_bench, load simulator of students playing a match
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <arpa/inet.h>		// For htons, htonl
+#include <netinet/in.h>		// For sockaddr_in
+#include <poll.h>		// For poll
+#include <stdbool.h>		// For boolean type
+#include <stdio.h>		// For printf, snprintf
+#include <stdlib.h>		// For atoi, calloc, exit
+#include <string.h>		// For memmove, strstr
+#include <sys/socket.h>		// For socket, connect
+#include <sys/time.h>		// For gettimeofday
+#include <unistd.h>		// For getpid, read, write, close
+
+#include "swad_config.h"
+#include "swad_push.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define PsB_MAX_BYTES_RECEIVED	(4 * 1024 - 1)
+#define PsB_TIMEOUT_IN_MS	(10 * 1000)	// Maximum time waiting for a status
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+struct PsB_Student
+  {
+   int Socket;
+   char Received[PsB_MAX_BYTES_RECEIVED + 1];
+   size_t Length;
+   bool GotStatus;
+  };
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void PsB_ConnectStudents (struct PsB_Student *Students,unsigned NumStds,
+                                 long MchCod);
+static double PsB_ChangeStatus (struct PsB_Student *Students,unsigned NumStds,
+                                long MchCod,unsigned NumChange,
+                                unsigned *NumStdsGotStatus);
+static void PsB_ReadFromStudent (struct PsB_Student *Student,const char *Data);
+static double PsB_GetSeconds (void);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_push_bench <students> <status changes>
+   swad_push must be running in this computer.
+   The given number of students open a connection to swad_push
+   (as their browsers do with EventSource) subscribed to the same match.
+   The status of the match is changed the given number of times
+   (as a teacher does), and the time until all the students
+   get each status is written.
+   Then the requests per second made to swad by the students
+   are compared with the ones made when students poll the match.
+   The maximum number of open files (ulimit -n) must be greater
+   than the number of students.
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumStds;
+   int NumChanges;
+   int NumChange;
+   struct PsB_Student *Students;
+   long MchCod = 1000000000L + (long) getpid ();	// Not used by real matches
+   double Seconds;
+   double MaxSeconds = 0.0;
+   double SumSeconds = 0.0;
+   unsigned NumStdsGotStatus;
+   unsigned long NumStdsNotGotStatus = 0;
+
+   if (argc != 3 ||
+       (NumStds    = atoi (argv[1])) <= 0 ||
+       (NumChanges = atoi (argv[2])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s <students> <status changes>\n",argv[0]);
+      return 1;
+     }
+
+   if ((Students = calloc ((size_t) NumStds,sizeof (struct PsB_Student))) == NULL)
+     {
+      fprintf (stderr,"Not enough memory.\n");
+      return 1;
+     }
+
+   /***** Students join the match *****/
+   PsB_ConnectStudents (Students,(unsigned) NumStds,MchCod);
+
+   /***** Teacher changes the status of the match *****/
+   for (NumChange = 0;
+	NumChange < NumChanges;
+	NumChange++)
+     {
+      Seconds = PsB_ChangeStatus (Students,(unsigned) NumStds,MchCod,
+				  (unsigned) NumChange,&NumStdsGotStatus);
+      SumSeconds += Seconds;
+      if (Seconds > MaxSeconds)
+	 MaxSeconds = Seconds;
+      NumStdsNotGotStatus += (unsigned long) NumStds - NumStdsGotStatus;
+     }
+
+   /***** Write results *****/
+   printf ("%d students, %d status changes\n",NumStds,NumChanges);
+   printf ("Time until all students get a status: %.1f ms average, %.1f ms maximum\n",
+	   SumSeconds * 1E3 / (double) NumChanges,MaxSeconds * 1E3);
+   printf ("Statuses not received before %u ms: %lu\n",
+	   PsB_TIMEOUT_IN_MS,NumStdsNotGotStatus);
+   printf ("Requests/s to swad when students poll every %u s: %.1f\n",
+	   Cfg_SECONDS_TO_POLL_MATCH_STD,
+	   (double) NumStds / (double) Cfg_SECONDS_TO_POLL_MATCH_STD);
+   printf ("Requests/s to swad with push (refresh every %u s"
+	   " + 1 refresh per change and student): %.1f + %d per change\n",
+	   Cfg_SECONDS_TO_REFRESH_MATCH_STD,
+	   (double) NumStds / (double) Cfg_SECONDS_TO_REFRESH_MATCH_STD,
+	   NumStds);
+   printf ("Students who left are removed from players after %u s\n",
+	   Cfg_SECONDS_TO_REMOVE_MATCH_PLAYER);
+
+   return 0;
+  }
+
+/*****************************************************************************/
+/*************** Open a connection to swad_push for each student *************/
+/*****************************************************************************/
+
+static void PsB_ConnectStudents (struct PsB_Student *Students,unsigned NumStds,
+                                 long MchCod)
+  {
+   struct sockaddr_in Addr;
+   char Request[128];
+   int Length;
+   unsigned NumStd;
+
+   memset (&Addr,0,sizeof (Addr));
+   Addr.sin_family      = AF_INET;
+   Addr.sin_port        = htons (Cfg_PORT_MATCH_PUSH_HTTP);
+   Addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+   Length = snprintf (Request,sizeof (Request),
+		      "GET %s?MchCod=%ld HTTP/1.1\r\n"
+		      "Host: localhost\r\n"
+		      "Accept: text/event-stream\r\n"
+		      "\r\n",
+		      Cfg_URL_MATCH_PUSH,MchCod);
+
+   for (NumStd = 0;
+	NumStd < NumStds;
+	NumStd++)
+      if ((Students[NumStd].Socket = socket (AF_INET,SOCK_STREAM,0)) < 0 ||
+	  connect (Students[NumStd].Socket,(struct sockaddr *) &Addr,sizeof (Addr)) ||
+	  write (Students[NumStd].Socket,Request,(size_t) Length) != (ssize_t) Length)
+	{
+	 fprintf (stderr,"Can not connect student %u to swad_push.\n",NumStd + 1);
+	 exit (1);
+	}
+  }
+
+/*****************************************************************************/
+/******* Change the status of the match and wait until students get it *******/
+/*****************************************************************************/
+// Return the time until all the students get the status (or timeout)
+
+static double PsB_ChangeStatus (struct PsB_Student *Students,unsigned NumStds,
+                                long MchCod,unsigned NumChange,
+                                unsigned *NumStdsGotStatus)
+  {
+   struct pollfd *Fds;
+   char Status[Psh_MAX_BYTES_STATUS + 1];
+   char Data[Psh_MAX_BYTES_STATUS + 16];
+   unsigned NumStd;
+   double Start;
+   double Now;
+
+   if ((Fds = calloc ((size_t) NumStds,sizeof (struct pollfd))) == NULL)
+     {
+      fprintf (stderr,"Not enough memory.\n");
+      exit (1);
+     }
+
+   /***** Status of the match as sent by swad *****/
+   snprintf (Status,sizeof (Status),"Y,%u,STEM,1,N",NumChange + 1);
+   snprintf (Data,sizeof (Data),"data: %s\n",Status);
+   for (NumStd = 0;
+	NumStd < NumStds;
+	NumStd++)
+      Students[NumStd].GotStatus = false;
+   *NumStdsGotStatus = 0;
+
+   /***** Teacher changes the status *****/
+   Start = Now = PsB_GetSeconds ();
+   Psh_NotifyMatchStatus (MchCod,Status);
+
+   /***** Wait until all the students get the status *****/
+   while (*NumStdsGotStatus < NumStds &&
+	  (Now - Start) * 1E3 < (double) PsB_TIMEOUT_IN_MS)
+     {
+      for (NumStd = 0;
+	   NumStd < NumStds;
+	   NumStd++)
+	{
+	 Fds[NumStd].fd = Students[NumStd].GotStatus ? -1 :	// Ignored by poll
+						       Students[NumStd].Socket;
+	 Fds[NumStd].events = POLLIN;
+	 Fds[NumStd].revents = 0;
+	}
+      if (poll (Fds,(nfds_t) NumStds,PsB_TIMEOUT_IN_MS) <= 0)
+	 break;
+
+      for (NumStd = 0;
+	   NumStd < NumStds;
+	   NumStd++)
+	 if (Fds[NumStd].revents)
+	   {
+	    PsB_ReadFromStudent (&Students[NumStd],Data);
+	    if (Students[NumStd].GotStatus)
+	       (*NumStdsGotStatus)++;
+	   }
+      Now = PsB_GetSeconds ();
+     }
+
+   free (Fds);
+   return Now - Start;
+  }
+
+/*****************************************************************************/
+/*********** Read from connection of a student and check status **************/
+/*****************************************************************************/
+
+static void PsB_ReadFromStudent (struct PsB_Student *Student,const char *Data)
+  {
+   ssize_t NumBytes;
+   size_t Keep;
+
+   if ((NumBytes = read (Student->Socket,&Student->Received[Student->Length],
+			 PsB_MAX_BYTES_RECEIVED - Student->Length)) <= 0)
+     {
+      fprintf (stderr,"Connection to swad_push closed.\n");
+      exit (1);
+     }
+   Student->Length += (size_t) NumBytes;
+   Student->Received[Student->Length] = '\0';
+
+   if (strstr (Student->Received,Data))
+     {
+      Student->GotStatus = true;
+      Student->Length = 0;
+     }
+   else if (Student->Length == PsB_MAX_BYTES_RECEIVED)
+     {
+      /* Keep only the end, where the status may be starting */
+      Keep = strlen (Data);
+      memmove (Student->Received,&Student->Received[Student->Length - Keep],Keep);
+      Student->Length = Keep;
+     }
+  }
+
+/*****************************************************************************/
+/************************ Get current time in seconds ************************/
+/*****************************************************************************/
+
+static double PsB_GetSeconds (void)
+  {
+   struct timeval Now;
+
+   gettimeofday (&Now,NULL);
+   return (double) Now.tv_sec + (double) Now.tv_usec / 1E6;
+  }
@@ -0,0 +1,484 @@
+// swad_push_main.c: main of swad_push, resident server that pushes changes in matches to students' browsers
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#define _GNU_SOURCE 		// For accept4
+#include <arpa/inet.h>		// For htons, htonl
+#include <errno.h>		// For errno
+#include <netinet/in.h>		// For sockaddr_in
+#include <poll.h>		// For poll
+#include <signal.h>		// For signal
+#include <stdbool.h>		// For boolean type
+#include <stdio.h>		// For fprintf, snprintf, sscanf
+#include <stdlib.h>		// For exit
+#include <string.h>		// For string functions
+#include <sys/socket.h>		// For socket, bind, listen, accept...
+#include <time.h>		// For time
+#include <unistd.h>		// For close, read
+
+#include "swad_config.h"
+#include "swad_push.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define Psh_MAX_BYTES_REQUEST		1023	// Maximum length of HTTP request headers
+#define Psh_SECONDS_BETWEEN_KEEPALIVES	15	// Send a comment to subscribed browsers, so proxies don't close the connections
+#define Psh_SECONDS_TO_SUBSCRIBE	5	// Close connections which have not sent their HTTP request in this time
+#define Psh_MILLISECONDS_TO_POLL	1000
+
+#define Psh_FD_LISTEN	0	// Index in poll array of TCP socket where browsers connect
+#define Psh_FD_NOTIFY	1	// Index in poll array of UDP socket where swad notifies changes
+#define Psh_NUM_FIXED_FDS	2
+
+/*****************************************************************************/
+/******************************** Private types ******************************/
+/*****************************************************************************/
+
+struct Psh_Client
+  {
+   long MchCod;		// Match subscribed (<= 0 ==> still reading the HTTP request)
+   time_t AcceptTime;	// When the connection was accepted
+   size_t Length;	// Length of HTTP request read
+   char Request[Psh_MAX_BYTES_REQUEST + 1];
+  };
+
+struct Psh_Match
+  {
+   long MchCod;
+   time_t LastChange;
+   char Status[Psh_MAX_BYTES_STATUS + 1];
+  };
+
+/*****************************************************************************/
+/************************* Private global variables **************************/
+/*****************************************************************************/
+
+static struct
+  {
+   unsigned NumClients;
+   struct pollfd Fds[Psh_NUM_FIXED_FDS + Cfg_MAX_MATCH_PUSH_CLIENTS];	// Client i uses Fds[Psh_NUM_FIXED_FDS + i]
+   struct Psh_Client Clients[Cfg_MAX_MATCH_PUSH_CLIENTS];
+   struct Psh_Match Matches[Cfg_MAX_MATCH_PUSH_MATCHES];
+  } Psh_Gbl;
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static int Psh_OpenSocket (int Type,unsigned short Port);
+static void Psh_AcceptClients (void);
+static void Psh_ReceiveNotifications (void);
+static void Psh_ReadFromClient (unsigned NumClient);
+static void Psh_SubscribeClient (unsigned NumClient);
+static struct Psh_Match *Psh_GetMatch (long MchCod,bool Create);
+static void Psh_SendStatusToClients (const struct Psh_Match *Match);
+static void Psh_SendKeepAlives (void);
+static void Psh_RemoveClientsNotSubscribed (void);
+static bool Psh_WriteToClient (unsigned NumClient,const char *Str);
+static void Psh_RemoveClient (unsigned NumClient);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Students' browsers playing a match open an EventSource (Server-Sent Events)
+   to Cfg_URL_MATCH_PUSH?MchCod=<match code>, forwarded by the web server
+   to this program.
+   swad sends a datagram "<match code> <status>" each time a match is updated.
+   When the status of a match changes, it's sent to all browsers
+   subscribed to that match, and they refresh the match just once,
+   instead of polling the server every few seconds.
+   Only the match code and its public status are sent,
+   so no session is checked here.
+*/
+
+int main (void)
+  {
+   unsigned NumClient;
+   time_t LastKeepAlive = time (NULL);
+
+   /***** Writing to a closed connection must not kill this process *****/
+   signal (SIGPIPE,SIG_IGN);
+
+   /***** Open sockets *****/
+   Psh_Gbl.Fds[Psh_FD_LISTEN].fd = Psh_OpenSocket (SOCK_STREAM,Cfg_PORT_MATCH_PUSH_HTTP);
+   Psh_Gbl.Fds[Psh_FD_NOTIFY].fd = Psh_OpenSocket (SOCK_DGRAM ,Cfg_PORT_MATCH_PUSH_NOTIFY);
+   Psh_Gbl.Fds[Psh_FD_LISTEN].events =
+   Psh_Gbl.Fds[Psh_FD_NOTIFY].events = POLLIN;
+   Psh_Gbl.NumClients = 0;
+
+   /***** Main loop *****/
+   for (;;)
+     {
+      if (poll (Psh_Gbl.Fds,Psh_NUM_FIXED_FDS + Psh_Gbl.NumClients,
+	        Psh_MILLISECONDS_TO_POLL) < 0)
+	{
+	 if (errno == EINTR)
+	    continue;
+	 fprintf (stderr,"swad_push: poll failed.\n");
+	 exit (1);
+	}
+
+      /***** Read from clients before accepting new ones,
+             because the array of clients can change *****/
+      for (NumClient = Psh_Gbl.NumClients;
+	   NumClient != 0;
+	   )	// Backwards, because removing a client moves the last one
+	{
+	 NumClient--;
+	 if (Psh_Gbl.Fds[Psh_NUM_FIXED_FDS + NumClient].revents & (POLLIN | POLLERR | POLLHUP))
+	    Psh_ReadFromClient (NumClient);
+	}
+
+      /***** New connections and notifications *****/
+      if (Psh_Gbl.Fds[Psh_FD_LISTEN].revents & POLLIN)
+	 Psh_AcceptClients ();
+      if (Psh_Gbl.Fds[Psh_FD_NOTIFY].revents & POLLIN)
+	 Psh_ReceiveNotifications ();
+
+      /***** Keep connections alive *****/
+      if (time (NULL) - LastKeepAlive >= Psh_SECONDS_BETWEEN_KEEPALIVES)
+	{
+	 Psh_SendKeepAlives ();
+	 LastKeepAlive = time (NULL);
+	}
+
+      /***** Close connections which never send a complete request *****/
+      Psh_RemoveClientsNotSubscribed ();
+     }
+
+   return 0; // Control don't reach this point. Used to avoid warning.
+  }
+
+/*****************************************************************************/
+/*************** Open a non-blocking socket bound to localhost ***************/
+/*****************************************************************************/
+
+static int Psh_OpenSocket (int Type,unsigned short Port)
+  {
+   int Socket;
+   int Yes = 1;
+   struct sockaddr_in Addr;
+
+   if ((Socket = socket (AF_INET,Type | SOCK_NONBLOCK,0)) < 0)
+     {
+      fprintf (stderr,"swad_push: can not create socket.\n");
+      exit (1);
+     }
+   setsockopt (Socket,SOL_SOCKET,SO_REUSEADDR,&Yes,sizeof (Yes));
+
+   memset (&Addr,0,sizeof (Addr));
+   Addr.sin_family      = AF_INET;
+   Addr.sin_port        = htons (Port);
+   Addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+   if (bind (Socket,(struct sockaddr *) &Addr,sizeof (Addr)) < 0)
+     {
+      fprintf (stderr,"swad_push: can not bind to port %u.\n",(unsigned) Port);
+      exit (1);
+     }
+
+   if (Type == SOCK_STREAM)
+      if (listen (Socket,SOMAXCONN) < 0)
+	{
+	 fprintf (stderr,"swad_push: can not listen on port %u.\n",(unsigned) Port);
+	 exit (1);
+	}
+
+   return Socket;
+  }
+
+/*****************************************************************************/
+/************************ Accept new browsers' connections *******************/
+/*****************************************************************************/
+
+static void Psh_AcceptClients (void)
+  {
+   int Socket;
+   struct pollfd *Fd;
+
+   while ((Socket = accept4 (Psh_Gbl.Fds[Psh_FD_LISTEN].fd,NULL,NULL,SOCK_NONBLOCK)) >= 0)
+     {
+      if (Psh_Gbl.NumClients >= Cfg_MAX_MATCH_PUSH_CLIENTS)
+	{
+	 // The browser will poll the server
+	 close (Socket);
+	 continue;
+	}
+
+      Fd = &Psh_Gbl.Fds[Psh_NUM_FIXED_FDS + Psh_Gbl.NumClients];
+      Fd->fd      = Socket;
+      Fd->events  = POLLIN;
+      Fd->revents = 0;
+      Psh_Gbl.Clients[Psh_Gbl.NumClients].MchCod = -1L;
+      Psh_Gbl.Clients[Psh_Gbl.NumClients].AcceptTime = time (NULL);
+      Psh_Gbl.Clients[Psh_Gbl.NumClients].Length = 0;
+      Psh_Gbl.NumClients++;
+     }
+  }
+
+/*****************************************************************************/
+/****************** Receive notifications of changes from swad ***************/
+/*****************************************************************************/
+
+static void Psh_ReceiveNotifications (void)
+  {
+   char Datagram[1 + 20 + 1 + Psh_MAX_BYTES_STATUS + 1];
+   ssize_t Length;
+   long MchCod;
+   char Status[Psh_MAX_BYTES_STATUS + 1];
+   struct Psh_Match *Match;
+
+   while ((Length = recv (Psh_Gbl.Fds[Psh_FD_NOTIFY].fd,
+			  Datagram,sizeof (Datagram) - 1,0)) >= 0)
+     {
+      Datagram[Length] = '\0';
+      if (sscanf (Datagram,"%ld %63s",&MchCod,Status) != 2 || MchCod <= 0)
+	 continue;
+
+      /***** Send status only if it has changed *****/
+      Match = Psh_GetMatch (MchCod,true);
+      if (strcmp (Match->Status,Status))
+	{
+	 strcpy (Match->Status,Status);
+	 Match->LastChange = time (NULL);
+	 Psh_SendStatusToClients (Match);
+	}
+     }
+  }
+
+/*****************************************************************************/
+/*************************** Read from a browser *****************************/
+/*****************************************************************************/
+
+static void Psh_ReadFromClient (unsigned NumClient)
+  {
+   struct Psh_Client *Client = &Psh_Gbl.Clients[NumClient];
+   int Socket = Psh_Gbl.Fds[Psh_NUM_FIXED_FDS + NumClient].fd;
+   char Discard[256];
+   ssize_t NumBytes;
+
+   /***** Subscribed browsers don't send anything more,
+          so reading here means the connection has been closed *****/
+   if (Client->MchCod > 0)
+     {
+      NumBytes = read (Socket,Discard,sizeof (Discard));
+      if (NumBytes == 0 ||
+	  (NumBytes < 0 && errno != EAGAIN))
+	 Psh_RemoveClient (NumClient);
+      return;
+     }
+
+   /***** Read HTTP request *****/
+   NumBytes = read (Socket,&Client->Request[Client->Length],
+		    Psh_MAX_BYTES_REQUEST - Client->Length);
+   if (NumBytes <= 0)
+     {
+      if (NumBytes == 0 || errno != EAGAIN)
+	 Psh_RemoveClient (NumClient);
+      return;
+     }
+   Client->Length += (size_t) NumBytes;
+   Client->Request[Client->Length] = '\0';
+
+   /***** Check if request is complete *****/
+   if (strstr (Client->Request,"\r\n\r\n"))
+      Psh_SubscribeClient (NumClient);
+   else if (Client->Length == Psh_MAX_BYTES_REQUEST)	// Too long
+      Psh_RemoveClient (NumClient);
+  }
+
+/*****************************************************************************/
+/******************* Subscribe a browser to a match **************************/
+/*****************************************************************************/
+// Request is "GET <path>?MchCod=<match code> HTTP/1.x"
+
+static void Psh_SubscribeClient (unsigned NumClient)
+  {
+   struct Psh_Client *Client = &Psh_Gbl.Clients[NumClient];
+   const char *Ptr;
+   long MchCod = -1L;
+   const struct Psh_Match *Match;
+
+   /***** Get match code *****/
+   if (!strncmp (Client->Request,"GET ",4))
+      if ((Ptr = strstr (Client->Request,"MchCod=")) != NULL)
+	 if (sscanf (Ptr + 7,"%ld",&MchCod) != 1)
+	    MchCod = -1L;
+   if (MchCod <= 0)
+     {
+      Psh_WriteToClient (NumClient,"HTTP/1.1 400 Bad Request\r\n"
+				   "Content-Length: 0\r\n"
+				   "Connection: close\r\n\r\n");
+      Psh_RemoveClient (NumClient);
+      return;
+     }
+
+   /***** Start event stream *****/
+   Client->MchCod = MchCod;
+   if (!Psh_WriteToClient (NumClient,"HTTP/1.1 200 OK\r\n"
+				     "Content-Type: text/event-stream\r\n"
+				     "Cache-Control: no-cache\r\n"
+				     "Connection: keep-alive\r\n"
+				     "X-Accel-Buffering: no\r\n"
+				     "\r\n"
+				     "retry: 5000\n\n"))
+      return;
+
+   /***** Send current status if known *****/
+   if ((Match = Psh_GetMatch (MchCod,false)) != NULL)
+     {
+      snprintf (Client->Request,sizeof (Client->Request),
+		"data: %s\n\n",Match->Status);
+      Psh_WriteToClient (NumClient,Client->Request);
+     }
+  }
+
+/*****************************************************************************/
+/************************ Get status of a match ******************************/
+/*****************************************************************************/
+// If not found and Create is true, the match changed least recently is reused
+
+static struct Psh_Match *Psh_GetMatch (long MchCod,bool Create)
+  {
+   unsigned NumMatch;
+   struct Psh_Match *Oldest = &Psh_Gbl.Matches[0];
+
+   for (NumMatch = 0;
+	NumMatch < Cfg_MAX_MATCH_PUSH_MATCHES;
+	NumMatch++)
+     {
+      if (Psh_Gbl.Matches[NumMatch].MchCod == MchCod)
+	 return &Psh_Gbl.Matches[NumMatch];
+      if (Psh_Gbl.Matches[NumMatch].LastChange < Oldest->LastChange)
+	 Oldest = &Psh_Gbl.Matches[NumMatch];
+     }
+
+   if (!Create)
+      return NULL;
+
+   Oldest->MchCod = MchCod;
+   Oldest->LastChange = time (NULL);
+   Oldest->Status[0] = '\0';
+   return Oldest;
+  }
+
+/*****************************************************************************/
+/********** Send the status of a match to all subscribed browsers ************/
+/*****************************************************************************/
+
+static void Psh_SendStatusToClients (const struct Psh_Match *Match)
+  {
+   char Event[6 + Psh_MAX_BYTES_STATUS + 2 + 1];
+   unsigned NumClient;
+
+   snprintf (Event,sizeof (Event),"data: %s\n\n",Match->Status);
+   for (NumClient = Psh_Gbl.NumClients;
+	NumClient != 0;
+	)	// Backwards, because removing a client moves the last one
+     {
+      NumClient--;
+      if (Psh_Gbl.Clients[NumClient].MchCod == Match->MchCod)
+	 Psh_WriteToClient (NumClient,Event);
+     }
+  }
+
+/*****************************************************************************/
+/*********** Send a comment to all subscribed browsers ***********************/
+/*****************************************************************************/
+
+static void Psh_SendKeepAlives (void)
+  {
+   unsigned NumClient;
+
+   for (NumClient = Psh_Gbl.NumClients;
+	NumClient != 0;
+	)	// Backwards, because removing a client moves the last one
+     {
+      NumClient--;
+      if (Psh_Gbl.Clients[NumClient].MchCod > 0)
+	 Psh_WriteToClient (NumClient,":\n\n");
+     }
+  }
+
+/*****************************************************************************/
+/******** Close connections still reading their request for too long *********/
+/*****************************************************************************/
+// Without this, slow or idle connections would keep their slots forever
+
+static void Psh_RemoveClientsNotSubscribed (void)
+  {
+   unsigned NumClient;
+   time_t Now = time (NULL);
+
+   for (NumClient = Psh_Gbl.NumClients;
+	NumClient != 0;
+	)	// Backwards, because removing a client moves the last one
+     {
+      NumClient--;
+      if (Psh_Gbl.Clients[NumClient].MchCod <= 0 &&
+	  Now - Psh_Gbl.Clients[NumClient].AcceptTime >= Psh_SECONDS_TO_SUBSCRIBE)
+	 Psh_RemoveClient (NumClient);
+     }
+  }
+
+/*****************************************************************************/
+/************************** Write to a browser *******************************/
+/*****************************************************************************/
+// Writing is not blocking. If the browser can not receive the whole string,
+// the connection is closed and the browser will connect again
+// Return false if the client has been removed
+
+static bool Psh_WriteToClient (unsigned NumClient,const char *Str)
+  {
+   size_t Length = strlen (Str);
+
+   if (send (Psh_Gbl.Fds[Psh_NUM_FIXED_FDS + NumClient].fd,Str,Length,
+	     MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t) Length)
+     {
+      Psh_RemoveClient (NumClient);
+      return false;
+     }
+   return true;
+  }
+
+/*****************************************************************************/
+/******* Close connection to a browser and move last one to its place ********/
+/*****************************************************************************/
+
+static void Psh_RemoveClient (unsigned NumClient)
+  {
+   unsigned NumLast = Psh_Gbl.NumClients - 1;
+
+   close (Psh_Gbl.Fds[Psh_NUM_FIXED_FDS + NumClient].fd);
+   if (NumClient != NumLast)
+     {
+      Psh_Gbl.Fds[Psh_NUM_FIXED_FDS + NumClient] = Psh_Gbl.Fds[Psh_NUM_FIXED_FDS + NumLast];
+      Psh_Gbl.Clients[NumClient] = Psh_Gbl.Clients[NumLast];
+     }
+   Psh_Gbl.NumClients--;
+  }
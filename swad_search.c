@@ -25,6 +25,10 @@
 /*********************************** Headers *********************************/
 /*****************************************************************************/
 
+#define _GNU_SOURCE 		// For asprintf
+#include <ctype.h>	// For isalnum, tolower...
+#include <stdio.h>	// For asprintf, snprintf
+#include <stdlib.h>	// For free
 #include <string.h>	// For string functions...
 
 #include "swad_box.h"
@@ -46,10 +50,23 @@
 #define Sch_MIN_LENGTH_LONGEST_WORD	  3
 #define Sch_MIN_LENGTH_TOTAL		  3	// "A An" is not valid; "A An Ann" is valid
 
+#define Sch_MAX_BYTES_FOLDED_CHAR	 15	// Characters out of Latin-1 and Latin Extended-A are kept as "&#number;"
+#define Sch_MAX_BYTES_ENTITY_NAME	  8	// Longest named HTML entity folded is "Ccedil", "Oslash"...
+
+#define Sch_MAX_WORDS_PER_INDEXED_TEXT	 64	// Words beyond this are not indexed
+#define Sch_NUM_ROWS_PER_INDEX_PAGE	10000	// Rows read from a table in each query when rebuilding index
+#define Sch_MAX_BYTES_INDEX_INSERT	(64 * 1024)	// Size of each multiple-row insertion in index
+
 /*****************************************************************************/
 /****************************** Private types ********************************/
 /*****************************************************************************/
 
+struct Sch_IndexInsert
+  {
+   char Query[Sch_MAX_BYTES_INDEX_INSERT + 1];
+   size_t Length;
+  };
+
 /*****************************************************************************/
 /************** External global variables from others modules ****************/
 /*****************************************************************************/
@@ -78,6 +95,24 @@ static unsigned Sch_SearchOpenDocumentsInDB (const char *RangeQuery);
 static unsigned Sch_SearchDocumentsInMyCoursesInDB (const char *RangeQuery);
 static unsigned Sch_SearchMyDocumentsInDB (const char *RangeQuery);
 
+static void Sch_UpdateIndexOfItem (Sch_IndexType_t Type,long Cod,const char *Text);
+static void Sch_RepairIndexRows (Sch_IndexType_t Type,const char *Table,
+                                 const char *CodField,const char *TextField);
+static void Sch_IndexText (struct Sch_IndexInsert *Insert,
+                           Sch_IndexType_t Type,long Cod,const char *Text);
+static void Sch_AddWordToIndexInsert (struct Sch_IndexInsert *Insert,
+                                      Sch_IndexType_t Type,const char *Word,long Cod);
+static void Sch_FlushIndexInsert (struct Sch_IndexInsert *Insert);
+
+static const char *Sch_GetNextFoldedWord (const char *Ptr,
+                                          char Word[Sch_MAX_BYTES_INDEX_WORD + 1]);
+static const char *Sch_FoldNextChar (const char *Ptr,
+                                     char Folded[Sch_MAX_BYTES_FOLDED_CHAR + 1]);
+static const char *Sch_FoldHTMLEntity (const char *Ptr,
+                                       char Folded[Sch_MAX_BYTES_FOLDED_CHAR + 1]);
+static void Sch_FoldCodePoint (unsigned CodePoint,
+                               char Folded[Sch_MAX_BYTES_FOLDED_CHAR + 1]);
+
 static void Sch_SaveLastSearchIntoSession (void);
 
 /*****************************************************************************/
@@ -603,20 +638,21 @@ static unsigned Sch_SearchCoursesInDB (const char *RangeQuery)
    /***** Check user's permission *****/
    if (Sch_CheckIfIHavePermissionToSearch (Sch_SEARCH_COURSES))
       /***** Split course string into words *****/
-      if (Sch_BuildSearchQuery (SearchQuery,"courses.FullName",NULL,NULL))
+      if (Sch_BuildSearchQueryInIndex (SearchQuery,Sch_INDEX_COURSES))
 	{
 	 /***** Query database and list courses found *****/
 	 NumCrss = (unsigned) DB_QuerySELECT (&mysql_res,"can not get courses",
 					      "SELECT degrees.DegCod,courses.CrsCod,degrees.ShortName,degrees.FullName,"
 					      "courses.Year,courses.FullName,centres.ShortName"
-					      " FROM courses,degrees,centres,institutions,countries"
-					      " WHERE %s"
+					      " FROM %s AS found,courses,degrees,centres,institutions,countries"
+					      " WHERE found.Cod=courses.CrsCod"
 					      " AND courses.DegCod=degrees.DegCod"
 					      " AND degrees.CtrCod=centres.CtrCod"
 					      " AND centres.InsCod=institutions.InsCod"
 					      " AND institutions.CtyCod=countries.CtyCod"
 					      "%s"
-					      " ORDER BY courses.FullName,institutions.FullName,degrees.FullName,courses.Year",
+					      " ORDER BY found.Relevance DESC,"
+					      "courses.FullName,institutions.FullName,degrees.FullName,courses.Year",
 					      SearchQuery,RangeQuery);
 	 Crs_ListCrssFound (&mysql_res,NumCrss);
 	 return NumCrss;
@@ -637,9 +673,7 @@ static unsigned Sch_SearchUsrsInDB (Rol_Role_t Role)
    char SearchQuery[Sch_MAX_BYTES_SEARCH_QUERY + 1];
 
    /***** Split user string into words *****/
-   if (Sch_BuildSearchQuery (SearchQuery,
-			     "CONCAT_WS(' ',FirstName,Surname1,Surname2)",
-			     NULL,NULL))
+   if (Sch_BuildSearchQueryInIndex (SearchQuery,Sch_INDEX_USERS))
       /***** Query database and list users found *****/
       return Usr_ListUsrsFound (Role,SearchQuery);
    else
@@ -669,8 +703,7 @@ static unsigned Sch_SearchOpenDocumentsInDB (const char *RangeQuery)
    /***** Check user's permission *****/
    if (Sch_CheckIfIHavePermissionToSearch (Sch_SEARCH_OPEN_DOCUMENTS))
       /***** Split document string into words *****/
-      if (Sch_BuildSearchQuery (SearchQuery,"SUBSTRING_INDEX(files.Path,'/',-1)",
-				"_latin1 "," COLLATE latin1_general_ci"))
+      if (Sch_BuildSearchQueryInIndex (SearchQuery,Sch_INDEX_FILES))
 	{
 	 /***** Query database *****/
 	 NumDocs = DB_QuerySELECT (&mysql_res,"can not get files",
@@ -683,8 +716,9 @@ static unsigned Sch_SearchOpenDocumentsInDB (const char *RangeQuery)
 				   "-1 AS DegCod,'' AS DegShortName,"
 				   "-1 AS CrsCod,'' AS CrsShortName,"
 				   "-1 AS GrpCod"
-				   " FROM files,courses,degrees,centres,institutions,countries"
-				   " WHERE files.Public='Y' AND %s"
+				   " FROM %s AS found,files,courses,degrees,centres,institutions,countries"
+				   " WHERE files.Public='Y'"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u)"
 				   " AND files.Cod=institutions.InsCod"
 				   " AND institutions.CtyCod=countries.CtyCod"
@@ -697,8 +731,9 @@ static unsigned Sch_SearchOpenDocumentsInDB (const char *RangeQuery)
 				   "-1 AS DegCod,'' AS DegShortName,"
 				   "-1 AS CrsCod,'' AS CrsShortName,"
 				   "-1 AS GrpCod"
-				   " FROM files,courses,degrees,centres,institutions,countries"
-				   " WHERE files.Public='Y' AND %s"
+				   " FROM %s AS found,files,courses,degrees,centres,institutions,countries"
+				   " WHERE files.Public='Y'"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u)"
 				   " AND files.Cod=centres.CtrCod"
 				   " AND centres.InsCod=institutions.InsCod"
@@ -712,8 +747,9 @@ static unsigned Sch_SearchOpenDocumentsInDB (const char *RangeQuery)
 				   "degrees.DegCod,degrees.ShortName AS DegShortName,"
 				   "-1,'' AS CrsShortName,"
 				   "-1"
-				   " FROM files,courses,degrees,centres,institutions,countries"
-				   " WHERE files.Public='Y' AND %s"
+				   " FROM %s AS found,files,courses,degrees,centres,institutions,countries"
+				   " WHERE files.Public='Y'"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u)"
 				   " AND files.Cod=degrees.DegCod"
 				   " AND degrees.CtrCod=centres.CtrCod"
@@ -728,8 +764,9 @@ static unsigned Sch_SearchOpenDocumentsInDB (const char *RangeQuery)
 				   "degrees.DegCod,degrees.ShortName AS DegShortName,"
 				   "courses.CrsCod,courses.ShortName AS CrsShortName,"
 				   "-1"
-				   " FROM files,courses,degrees,centres,institutions,countries"
-				   " WHERE files.Public='Y' AND %s"
+				   " FROM %s AS found,files,courses,degrees,centres,institutions,countries"
+				   " WHERE files.Public='Y'"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u)"
 				   " AND files.Cod=courses.CrsCod"
 				   " AND courses.DegCod=degrees.DegCod"
@@ -783,8 +820,7 @@ static unsigned Sch_SearchDocumentsInMyCoursesInDB (const char *RangeQuery)
    /***** Check user's permission *****/
    if (Sch_CheckIfIHavePermissionToSearch (Sch_SEARCH_DOCUM_IN_MY_COURSES))
       /***** Split document string into words *****/
-      if (Sch_BuildSearchQuery (SearchQuery,"SUBSTRING_INDEX(files.Path,'/',-1)",
-				"_latin1 "," COLLATE latin1_general_ci"))
+      if (Sch_BuildSearchQueryInIndex (SearchQuery,Sch_INDEX_FILES))
 	{
 	 /***** Create temporary table with codes of files in documents and shared areas accessible by me.
 		It is necessary to speed up the second query *****/
@@ -830,8 +866,9 @@ static unsigned Sch_SearchDocumentsInMyCoursesInDB (const char *RangeQuery)
 				   "degrees.DegCod,degrees.ShortName AS DegShortName,"
 				   "courses.CrsCod,courses.ShortName AS CrsShortName,"
 				   "-1 AS GrpCod"
-				   " FROM files,courses,degrees,centres,institutions,countries"
-				   " WHERE files.FilCod IN (SELECT FilCod FROM my_files_crs) AND %s"
+				   " FROM %s AS found,files,courses,degrees,centres,institutions,countries"
+				   " WHERE files.FilCod IN (SELECT FilCod FROM my_files_crs)"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u,%u,%u)"
 				   " AND files.Cod=courses.CrsCod"
 				   " AND courses.DegCod=degrees.DegCod"
@@ -847,8 +884,9 @@ static unsigned Sch_SearchDocumentsInMyCoursesInDB (const char *RangeQuery)
 				   "degrees.DegCod,degrees.ShortName AS DegShortName,"
 				   "courses.CrsCod,courses.ShortName AS CrsShortName,"
 				   "crs_grp.GrpCod"
-				   " FROM files,crs_grp,crs_grp_types,courses,degrees,centres,institutions,countries"
-				   " WHERE files.FilCod IN (SELECT FilCod FROM my_files_grp) AND %s"
+				   " FROM %s AS found,files,crs_grp,crs_grp_types,courses,degrees,centres,institutions,countries"
+				   " WHERE files.FilCod IN (SELECT FilCod FROM my_files_grp)"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u,%u,%u)"
 				   " AND files.Cod=crs_grp.GrpCod"
 				   " AND crs_grp.GrpTypCod=crs_grp_types.GrpTypCod"
@@ -904,8 +942,7 @@ static unsigned Sch_SearchMyDocumentsInDB (const char *RangeQuery)
    /***** Check user's permission *****/
    if (Sch_CheckIfIHavePermissionToSearch (Sch_SEARCH_MY_DOCUMENTS))
       /***** Split document string into words *****/
-      if (Sch_BuildSearchQuery (SearchQuery,"SUBSTRING_INDEX(files.Path,'/',-1)",
-				"_latin1 "," COLLATE latin1_general_ci"))
+      if (Sch_BuildSearchQueryInIndex (SearchQuery,Sch_INDEX_FILES))
 	{
 	 /***** Build the query *****/
 	 NumDocs = DB_QuerySELECT (&mysql_res,"can not get files",
@@ -918,8 +955,9 @@ static unsigned Sch_SearchMyDocumentsInDB (const char *RangeQuery)
 				   "-1 AS DegCod,'' AS DegShortName,"
 				   "-1 AS CrsCod,'' AS CrsShortName,"
 				   "-1 AS GrpCod"
-				   " FROM files,courses,degrees,centres,institutions,countries"
-				   " WHERE files.PublisherUsrCod=%ld AND %s"
+				   " FROM %s AS found,files,courses,degrees,centres,institutions,countries"
+				   " WHERE files.PublisherUsrCod=%ld"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u)"
 				   " AND files.Cod=institutions.InsCod"
 				   " AND institutions.CtyCod=countries.CtyCod"
@@ -932,8 +970,9 @@ static unsigned Sch_SearchMyDocumentsInDB (const char *RangeQuery)
 				   "-1 AS DegCod,'' AS DegShortName,"
 				   "-1 AS CrsCod,'' AS CrsShortName,"
 				   "-1 AS GrpCod"
-				   " FROM files,courses,degrees,centres,institutions,countries"
-				   " WHERE files.PublisherUsrCod=%ld AND %s"
+				   " FROM %s AS found,files,courses,degrees,centres,institutions,countries"
+				   " WHERE files.PublisherUsrCod=%ld"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u)"
 				   " AND files.Cod=centres.CtrCod"
 				   " AND centres.InsCod=institutions.InsCod"
@@ -947,8 +986,9 @@ static unsigned Sch_SearchMyDocumentsInDB (const char *RangeQuery)
 				   "degrees.DegCod,degrees.ShortName AS DegShortName,"
 				   "-1 AS CrsCod,'' AS CrsShortName,"
 				   "-1 AS GrpCod"
-				   " FROM files,courses,degrees,centres,institutions,countries"
-				   " WHERE files.PublisherUsrCod=%ld AND %s"
+				   " FROM %s AS found,files,courses,degrees,centres,institutions,countries"
+				   " WHERE files.PublisherUsrCod=%ld"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u)"
 				   " AND files.Cod=degrees.DegCod"
 				   " AND degrees.CtrCod=centres.CtrCod"
@@ -963,8 +1003,9 @@ static unsigned Sch_SearchMyDocumentsInDB (const char *RangeQuery)
 				   "degrees.DegCod,degrees.ShortName AS DegShortName,"
 				   "courses.CrsCod,courses.ShortName AS CrsShortName,"
 				   "-1 AS GrpCod"
-				   " FROM files,courses,degrees,centres,institutions,countries"
-				   " WHERE files.PublisherUsrCod=%ld AND %s"
+				   " FROM %s AS found,files,courses,degrees,centres,institutions,countries"
+				   " WHERE files.PublisherUsrCod=%ld"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u,%u,%u)"
 				   " AND files.Cod=courses.CrsCod"
 				   " AND courses.DegCod=degrees.DegCod"
@@ -980,8 +1021,9 @@ static unsigned Sch_SearchMyDocumentsInDB (const char *RangeQuery)
 				   "degrees.DegCod,degrees.ShortName AS DegShortName,"
 				   "courses.CrsCod,courses.ShortName AS CrsShortName,"
 				   "crs_grp.GrpCod"
-				   " FROM files,crs_grp,crs_grp_types,courses,degrees,centres,institutions,countries"
-				   " WHERE files.PublisherUsrCod=%ld AND %s"
+				   " FROM %s AS found,files,crs_grp,crs_grp_types,courses,degrees,centres,institutions,countries"
+				   " WHERE files.PublisherUsrCod=%ld"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser IN (%u,%u,%u,%u)"
 				   " AND files.Cod=crs_grp.GrpCod"
 				   " AND crs_grp.GrpTypCod=crs_grp_types.GrpTypCod"
@@ -999,37 +1041,38 @@ static unsigned Sch_SearchMyDocumentsInDB (const char *RangeQuery)
 				   "-1 AS DegCod,'' AS DegShortName,"
 				   "-1 AS CrsCod,'' AS CrsShortName,"
 				   "-1 AS GrpCod"
-				   " FROM files"
-				   " WHERE files.PublisherUsrCod=%ld AND %s"
+				   " FROM %s AS found,files"
+				   " WHERE files.PublisherUsrCod=%ld"
+				   " AND files.FilCod=found.Cod"
 				   " AND files.FileBrowser=%u"
 				   ") AS selected_files"
 				   " WHERE PathFromRoot<>''"
 				   " ORDER BY InsShortName,CtrShortName,DegShortName,CrsShortName,PathFromRoot",
-				   Gbl.Usrs.Me.UsrDat.UsrCod,SearchQuery,
+				   SearchQuery,Gbl.Usrs.Me.UsrDat.UsrCod,
 				   (unsigned) Brw_ADMI_DOC_INS,
 				   (unsigned) Brw_ADMI_SHR_INS,
 				   RangeQuery,
-				   Gbl.Usrs.Me.UsrDat.UsrCod,SearchQuery,
+				   SearchQuery,Gbl.Usrs.Me.UsrDat.UsrCod,
 				   (unsigned) Brw_ADMI_DOC_CTR,
 				   (unsigned) Brw_ADMI_SHR_CTR,
 				   RangeQuery,
-				   Gbl.Usrs.Me.UsrDat.UsrCod,SearchQuery,
+				   SearchQuery,Gbl.Usrs.Me.UsrDat.UsrCod,
 				   (unsigned) Brw_ADMI_DOC_DEG,
 				   (unsigned) Brw_ADMI_SHR_DEG,
 				   RangeQuery,
-				   Gbl.Usrs.Me.UsrDat.UsrCod,SearchQuery,
+				   SearchQuery,Gbl.Usrs.Me.UsrDat.UsrCod,
 				   (unsigned) Brw_ADMI_DOC_CRS,
 				   (unsigned) Brw_ADMI_TCH_CRS,
 				   (unsigned) Brw_ADMI_SHR_CRS,
 				   (unsigned) Brw_ADMI_MRK_CRS,
 				   RangeQuery,
-				   Gbl.Usrs.Me.UsrDat.UsrCod,SearchQuery,
+				   SearchQuery,Gbl.Usrs.Me.UsrDat.UsrCod,
 				   (unsigned) Brw_ADMI_DOC_GRP,
 				   (unsigned) Brw_ADMI_TCH_GRP,
 				   (unsigned) Brw_ADMI_SHR_GRP,
 				   (unsigned) Brw_ADMI_MRK_GRP,
 				   RangeQuery,
-				   Gbl.Usrs.Me.UsrDat.UsrCod,SearchQuery,
+				   SearchQuery,Gbl.Usrs.Me.UsrDat.UsrCod,
 				   (unsigned) Brw_ADMI_BRF_USR);
 
 	 /***** List documents found *****/
@@ -1138,6 +1181,550 @@ bool Sch_BuildSearchQuery (char SearchQuery[Sch_MAX_BYTES_SEARCH_QUERY + 1],
    return false;
   }
 
+/*****************************************************************************/
+/******* Build a search query using the index of words in the database *******/
+/*****************************************************************************/
+/* Returns true if a valid search query is built
+   Returns false when no valid search query
+   The query is a derived table with columns Cod and Relevance.
+   Every word to search must be the prefix of some word of the item found.
+   Relevance is the number of words to search found as complete words */
+
+bool Sch_BuildSearchQueryInIndex (char SearchQuery[Sch_MAX_BYTES_SEARCH_QUERY + 1],
+                                  Sch_IndexType_t Type)
+  {
+   char SearchWords[Sch_MAX_WORDS_IN_SEARCH][Sch_MAX_BYTES_INDEX_WORD + 1];
+   char SubQuery[256 + 2 * Sch_MAX_BYTES_INDEX_WORD];
+   const char *Ptr;
+   unsigned NumWords = 0;
+   unsigned NumWord;
+   size_t LengthWord;
+   size_t LengthTotal = 0;
+   size_t MaxLengthWord = 0;
+   bool Repeated;
+
+   /***** Split string to search into folded words *****/
+   Ptr = Gbl.Search.Str;
+   while (*Ptr && NumWords < Sch_MAX_WORDS_IN_SEARCH)
+     {
+      Ptr = Sch_GetNextFoldedWord (Ptr,SearchWords[NumWords]);
+      if (SearchWords[NumWords][0])
+	{
+	 /* Check if this word is repeated */
+	 for (NumWord = 0, Repeated = false;
+	      !Repeated && NumWord < NumWords;
+	      NumWord++)
+	    Repeated = !strcmp (SearchWords[NumWord],SearchWords[NumWords]);
+
+	 if (!Repeated)
+	   {
+	    LengthWord = strlen (SearchWords[NumWords]);
+	    LengthTotal += LengthWord;
+	    if (LengthWord > MaxLengthWord)
+	       MaxLengthWord = LengthWord;
+	    NumWords++;
+	   }
+	}
+     }
+
+   /***** If search string valid? *****/
+   if (LengthTotal < Sch_MIN_LENGTH_TOTAL ||
+       MaxLengthWord < Sch_MIN_LENGTH_LONGEST_WORD)
+      return false;
+
+   /***** Build the query.
+          Folded words only contain letters, digits and HTML entities,
+          so they can be safely inserted in the query *****/
+   Str_Copy (SearchQuery,"(SELECT Cod,SUM(Exact) AS Relevance FROM (",
+	     Sch_MAX_BYTES_SEARCH_QUERY);
+   for (NumWord = 0;
+	NumWord < NumWords;
+	NumWord++)
+     {
+      snprintf (SubQuery,sizeof (SubQuery),
+	        "%sSELECT Cod,MAX(Word='%s') AS Exact"
+	        " FROM sch_words"
+	        " WHERE Type=%u AND Word LIKE '%s%%'"
+	        " GROUP BY Cod",
+	        NumWord ? " UNION ALL " :
+	        	  "",
+	        SearchWords[NumWord],
+	        (unsigned) Type,
+	        SearchWords[NumWord]);
+      Str_Concat (SearchQuery,SubQuery,
+                  Sch_MAX_BYTES_SEARCH_QUERY);
+     }
+   snprintf (SubQuery,sizeof (SubQuery),
+	     ") AS sch_terms GROUP BY Cod HAVING COUNT(*)=%u)",
+	     NumWords);
+   Str_Concat (SearchQuery,SubQuery,
+               Sch_MAX_BYTES_SEARCH_QUERY);
+
+   return true;
+  }
+
+/*****************************************************************************/
+/********** Update the words of a course, a user or a file in index **********/
+/*****************************************************************************/
+// Called each time a course, a user or a file is created or renamed
+
+void Sch_UpdateIndexOfCrs (long CrsCod,const char *FullName)
+  {
+   Sch_UpdateIndexOfItem (Sch_INDEX_COURSES,CrsCod,FullName);
+  }
+
+void Sch_UpdateIndexOfUsr (long UsrCod,
+                           const char *FirstName,
+                           const char *Surname1,const char *Surname2)
+  {
+   char *FullName;
+
+   /***** Words are those of CONCAT_WS(' ',FirstName,Surname1,Surname2),
+          as in Sch_RepairSearchIndex *****/
+   if (asprintf (&FullName,"%s %s %s",FirstName,Surname1,Surname2) < 0)
+      Lay_NotEnoughMemoryExit ();
+   Sch_UpdateIndexOfItem (Sch_INDEX_USERS,UsrCod,FullName);
+   free (FullName);
+  }
+
+void Sch_UpdateIndexOfFile (long FilCod,const char *Path)
+  {
+   const char *FileName;
+
+   /***** Only the name of the file or folder is indexed,
+          as SUBSTRING_INDEX(Path,'/',-1) in Sch_RepairSearchIndex *****/
+   if ((FileName = strrchr (Path,'/')))
+      FileName++;
+   else
+      FileName = Path;
+   Sch_UpdateIndexOfItem (Sch_INDEX_FILES,FilCod,FileName);
+  }
+
+static void Sch_UpdateIndexOfItem (Sch_IndexType_t Type,long Cod,const char *Text)
+  {
+   struct Sch_IndexInsert Insert;
+
+   if (Cod <= 0)
+      return;
+
+   /***** Remove old words *****/
+   Sch_RemoveFromIndex (Type,Cod);
+
+   /***** Insert new words *****/
+   Insert.Length = 0;
+   Sch_IndexText (&Insert,Type,Cod,Text);
+   Sch_FlushIndexInsert (&Insert);
+  }
+
+/*****************************************************************************/
+/************ Remove the words of a course, a user or a file *****************/
+/*****************************************************************************/
+
+void Sch_RemoveFromIndex (Sch_IndexType_t Type,long Cod)
+  {
+   DB_QueryDELETE ("can not remove words from index",
+		   "DELETE FROM sch_words"
+		   " WHERE Type=%u AND Cod=%ld",
+		   (unsigned) Type,Cod);
+  }
+
+/*****************************************************************************/
+/***************** Repair the index of words in the database *****************/
+/*****************************************************************************/
+/* Called daily from swad_housekeeping.
+   The index is updated each time a course, a user or a file
+   is created, renamed or removed, but some changes are not applied to it
+   (for example, files removed with a whole zone or course).
+   This job makes the index equal to the tables again */
+
+void Sch_RepairSearchIndex (void)
+  {
+   Sch_RepairIndexRows (Sch_INDEX_COURSES,"courses" ,"CrsCod",
+			"FullName");
+   Sch_RepairIndexRows (Sch_INDEX_USERS  ,"usr_data","UsrCod",
+			"CONCAT_WS(' ',FirstName,Surname1,Surname2)");
+   Sch_RepairIndexRows (Sch_INDEX_FILES  ,"files"   ,"FilCod",
+			"SUBSTRING_INDEX(Path,'/',-1)");
+  }
+
+/*****************************************************************************/
+/********** Replace the words of all the rows of a table in index ************/
+/*****************************************************************************/
+/* Rows are read in pages ordered by code to avoid locking the table for long.
+   Words of all codes in the range of each page are replaced
+   in a transaction, so searches never see a page half-built,
+   and words of rows removed from table are removed from index */
+
+static void Sch_RepairIndexRows (Sch_IndexType_t Type,const char *Table,
+                                 const char *CodField,const char *TextField)
+  {
+   struct Sch_IndexInsert Insert;
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows;
+   unsigned long NumRow;
+   long FirstCod;
+   long LastCod = 0;
+
+   Insert.Length = 0;
+   do
+     {
+      FirstCod = LastCod;
+
+      /***** Get next page of rows *****/
+      NumRows = DB_QuerySELECT (&mysql_res,"can not get rows to index",
+				"SELECT %s,%s FROM %s"
+				" WHERE %s>%ld"
+				" ORDER BY %s"
+				" LIMIT %u",
+				CodField,TextField,Table,
+				CodField,FirstCod,
+				CodField,
+				(unsigned) Sch_NUM_ROWS_PER_INDEX_PAGE);
+
+      DB_BeginTransaction ();
+
+      /***** Remove words of codes in this page *****/
+      if (NumRows == Sch_NUM_ROWS_PER_INDEX_PAGE)
+	{
+	 /* Code of last row in page */
+	 mysql_data_seek (mysql_res,NumRows - 1);
+	 row = mysql_fetch_row (mysql_res);
+	 LastCod = Str_ConvertStrCodToLongCod (row[0]);
+	 mysql_data_seek (mysql_res,0);
+
+	 DB_QueryDELETE ("can not remove words from index",
+			 "DELETE FROM sch_words"
+			 " WHERE Type=%u AND Cod>%ld AND Cod<=%ld",
+			 (unsigned) Type,FirstCod,LastCod);
+	}
+      else	// Last page ==> remove also words of codes after the last one
+	 DB_QueryDELETE ("can not remove words from index",
+			 "DELETE FROM sch_words"
+			 " WHERE Type=%u AND Cod>%ld",
+			 (unsigned) Type,FirstCod);
+
+      /***** Add words of each row to the index *****/
+      for (NumRow = 0;
+	   NumRow < NumRows;
+	   NumRow++)
+	{
+	 row = mysql_fetch_row (mysql_res);
+
+	 if (row[1])
+	    Sch_IndexText (&Insert,Type,Str_ConvertStrCodToLongCod (row[0]),row[1]);
+	}
+      Sch_FlushIndexInsert (&Insert);
+
+      DB_CommitTransaction ();
+
+      /***** Free structure that stores the query result *****/
+      DB_FreeMySQLResult (&mysql_res);
+     }
+   while (NumRows == Sch_NUM_ROWS_PER_INDEX_PAGE);
+  }
+
+/*****************************************************************************/
+/********************* Add the words of a text to the index ******************/
+/*****************************************************************************/
+
+static void Sch_IndexText (struct Sch_IndexInsert *Insert,
+                           Sch_IndexType_t Type,long Cod,const char *Text)
+  {
+   char Words[Sch_MAX_WORDS_PER_INDEXED_TEXT][Sch_MAX_BYTES_INDEX_WORD + 1];
+   unsigned NumWords = 0;
+   unsigned NumWord;
+   bool Repeated;
+
+   while (*Text && NumWords < Sch_MAX_WORDS_PER_INDEXED_TEXT)
+     {
+      Text = Sch_GetNextFoldedWord (Text,Words[NumWords]);
+      if (Words[NumWords][0])
+	{
+	 /* Check if this word is repeated */
+	 for (NumWord = 0, Repeated = false;
+	      !Repeated && NumWord < NumWords;
+	      NumWord++)
+	    Repeated = !strcmp (Words[NumWord],Words[NumWords]);
+
+	 if (!Repeated)
+	    Sch_AddWordToIndexInsert (Insert,Type,Words[NumWords++],Cod);
+	}
+     }
+  }
+
+/*****************************************************************************/
+/******************* Add a word to a multiple-row insertion ******************/
+/*****************************************************************************/
+
+static void Sch_AddWordToIndexInsert (struct Sch_IndexInsert *Insert,
+                                      Sch_IndexType_t Type,const char *Word,long Cod)
+  {
+   char Values[64 + Sch_MAX_BYTES_INDEX_WORD];
+   size_t LengthValues;
+
+   LengthValues = (size_t) snprintf (Values,sizeof (Values),
+				     "(%u,'%s',%ld)",
+				     (unsigned) Type,Word,Cod);
+
+   /***** Insert pending words if buffer is full *****/
+   if (Insert->Length + 1 + LengthValues > Sch_MAX_BYTES_INDEX_INSERT)
+      Sch_FlushIndexInsert (Insert);
+
+   /***** Start a new insertion or separate from previous values *****/
+   if (Insert->Length)
+      Insert->Query[Insert->Length++] = ',';
+   else
+      Insert->Length = (size_t) sprintf (Insert->Query,
+					 "INSERT IGNORE INTO sch_words"
+					 " (Type,Word,Cod)"
+					 " VALUES ");
+
+   /***** Append values *****/
+   strcpy (&Insert->Query[Insert->Length],Values);
+   Insert->Length += LengthValues;
+  }
+
+/*****************************************************************************/
+/************* Insert into database the words pending of insertion ***********/
+/*****************************************************************************/
+
+static void Sch_FlushIndexInsert (struct Sch_IndexInsert *Insert)
+  {
+   if (Insert->Length)
+     {
+      DB_Query ("can not update index of words",
+		"%s",
+		Insert->Query);
+      Insert->Length = 0;
+     }
+  }
+
+/*****************************************************************************/
+/*************** Get next word from a text, folded for the index *************/
+/*****************************************************************************/
+/* Word is lowercase, without accents, and has at most Sch_MAX_BYTES_INDEX_WORD
+   (longer words are truncated). Word is empty if there are no more words.
+   Returns pointer to the rest of the text */
+
+static const char *Sch_GetNextFoldedWord (const char *Ptr,
+                                          char Word[Sch_MAX_BYTES_INDEX_WORD + 1])
+  {
+   char Folded[Sch_MAX_BYTES_FOLDED_CHAR + 1];
+   const char *PtrNext;
+   size_t LengthWord = 0;
+   size_t LengthFolded;
+   bool Truncated = false;
+
+   Word[0] = '\0';
+   while (*Ptr)
+     {
+      PtrNext = Sch_FoldNextChar (Ptr,Folded);
+      if (Folded[0])		// Character inside a word
+	{
+	 LengthFolded = strlen (Folded);
+	 if (!Truncated &&
+	     LengthWord + LengthFolded <= Sch_MAX_BYTES_INDEX_WORD)
+	   {
+	    strcpy (&Word[LengthWord],Folded);
+	    LengthWord += LengthFolded;
+	   }
+	 else
+	    Truncated = true;	// Don't split an HTML entity
+	}
+      else if (LengthWord)	// Separator after a word
+	 return PtrNext;
+      Ptr = PtrNext;
+     }
+
+   return Ptr;
+  }
+
+/*****************************************************************************/
+/********** Fold next character to lowercase and without accents *************/
+/*****************************************************************************/
+/* The character can be a byte in Latin-1 or an HTML entity,
+   like those written in database by Str_ChangeFormat ("&#287;")
+   or by older versions ("&ntilde;").
+   Folded is empty if the character separates words.
+   Returns pointer to next character */
+
+static const char *Sch_FoldNextChar (const char *Ptr,
+                                     char Folded[Sch_MAX_BYTES_FOLDED_CHAR + 1])
+  {
+   if (*Ptr == '&')
+      return Sch_FoldHTMLEntity (Ptr,Folded);
+
+   Sch_FoldCodePoint ((unsigned) (unsigned char) *Ptr,Folded);
+   return Ptr + 1;
+  }
+
+/*****************************************************************************/
+/*************************** Fold an HTML entity *****************************/
+/*****************************************************************************/
+// Ptr points to '&'
+
+static const char *Sch_FoldHTMLEntity (const char *Ptr,
+                                       char Folded[Sch_MAX_BYTES_FOLDED_CHAR + 1])
+  {
+   static const char *Accents[] =
+     {
+      "acute",
+      "grave",
+      "circ",
+      "uml",
+      "tilde",
+      "cedil",
+      "ring",
+      "slash",
+      "caron",
+     };
+   char Name[Sch_MAX_BYTES_ENTITY_NAME + 1];
+   const char *PtrDigits;
+   const char *PtrEnd = Ptr + 1;
+   unsigned CodePoint = 0;
+   size_t Length;
+   unsigned NumAccent;
+
+   Folded[0] = '\0';
+
+   if (*PtrEnd == '#')	// Numeric entity: "&#287;" or "&#x11F;"
+     {
+      PtrEnd++;
+      if (*PtrEnd == 'x' || *PtrEnd == 'X')
+	{
+	 for (PtrDigits = ++PtrEnd;
+	      isxdigit ((int) (unsigned char) *PtrEnd);
+	      PtrEnd++)
+	    if (CodePoint < 0x110000)	// To avoid overflow
+	       CodePoint = CodePoint * 16 +
+			   (unsigned) (isdigit ((int) (unsigned char) *PtrEnd) ? *PtrEnd - '0' :
+									       tolower ((int) (unsigned char) *PtrEnd) - 'a' + 10);
+	}
+      else
+	 for (PtrDigits = PtrEnd;
+	      isdigit ((int) (unsigned char) *PtrEnd);
+	      PtrEnd++)
+	    if (CodePoint < 0x110000)	// To avoid overflow
+	       CodePoint = CodePoint * 10 + (unsigned) (*PtrEnd - '0');
+
+      if (PtrEnd == PtrDigits || *PtrEnd != ';')
+	 return Ptr + 1;	// Not an HTML entity: '&' separates words
+
+      Sch_FoldCodePoint (CodePoint,Folded);
+      return PtrEnd + 1;
+     }
+
+   /***** Named entity: "&ntilde;", "&szlig;"... *****/
+   for (Length = 0;
+	Length < Sch_MAX_BYTES_ENTITY_NAME &&
+	isalpha ((int) (unsigned char) PtrEnd[Length]);
+	Length++)
+      Name[Length] = PtrEnd[Length];
+   Name[Length] = '\0';
+   if (!Length || PtrEnd[Length] != ';')
+      return Ptr + 1;		// Not an HTML entity: '&' separates words
+
+   if (!strcmp (Name,"szlig"))
+      Str_Copy (Folded,"ss",Sch_MAX_BYTES_FOLDED_CHAR);
+   else if (!strcasecmp (Name,"aelig"))
+      Str_Copy (Folded,"ae",Sch_MAX_BYTES_FOLDED_CHAR);
+   else if (!strcasecmp (Name,"oelig"))
+      Str_Copy (Folded,"oe",Sch_MAX_BYTES_FOLDED_CHAR);
+   else if (Length > 1)
+      for (NumAccent = 0;
+	   NumAccent < sizeof (Accents) / sizeof (Accents[0]);
+	   NumAccent++)
+	 if (!strcmp (&Name[1],Accents[NumAccent]))	// Letter with accent
+	   {
+	    Folded[0] = (char) tolower ((int) (unsigned char) Name[0]);
+	    Folded[1] = '\0';
+	    break;
+	   }
+
+   return PtrEnd + Length + 1;
+  }
+
+/*****************************************************************************/
+/**************** Fold a Unicode code point used in a word *******************/
+/*****************************************************************************/
+// Folded is empty if the character separates words
+
+static void Sch_FoldCodePoint (unsigned CodePoint,
+                               char Folded[Sch_MAX_BYTES_FOLDED_CHAR + 1])
+  {
+   /* Latin-1 letters from U+00C0 to U+00FF without accents */
+   static const char *Latin1[64] =
+     {
+      "a","a","a","a","a","a","ae","c",	// U+00C0 to U+00C7
+      "e","e","e","e","i","i","i","i",	// U+00C8 to U+00CF
+      "d","n","o","o","o","o","o",""  ,	// U+00D0 to U+00D7 (multiplication sign)
+      "o","u","u","u","u","y","th","ss",	// U+00D8 to U+00DF
+      "a","a","a","a","a","a","ae","c",	// U+00E0 to U+00E7
+      "e","e","e","e","i","i","i","i",	// U+00E8 to U+00EF
+      "d","n","o","o","o","o","o",""  ,	// U+00F0 to U+00F7 (division sign)
+      "o","u","u","u","u","y","th","y",	// U+00F8 to U+00FF
+     };
+   /* Latin Extended-A letters from U+0100 to U+017F without accents */
+   static const char LatinExtA[128 + 1] =
+      "aaaaaa"		// U+0100 to U+0105
+      "cccccccc"	// U+0106 to U+010D
+      "dddd"		// U+010E to U+0111
+      "eeeeeeeeee"	// U+0112 to U+011B
+      "gggggggg"	// U+011C to U+0123
+      "hhhh"		// U+0124 to U+0127
+      "iiiiiiiiii"	// U+0128 to U+0131
+      "ii"		// U+0132 to U+0133 (ligature ij)
+      "jj"		// U+0134 to U+0135
+      "kkk"		// U+0136 to U+0138
+      "llllllllll"	// U+0139 to U+0142
+      "nnnnnnnnn"	// U+0143 to U+014B
+      "oooooo"		// U+014C to U+0151
+      "oo"		// U+0152 to U+0153 (ligature oe)
+      "rrrrrr"		// U+0154 to U+0159
+      "ssssssss"	// U+015A to U+0161
+      "tttttt"		// U+0162 to U+0167
+      "uuuuuuuuuuuu"	// U+0168 to U+0173
+      "ww"		// U+0174 to U+0175
+      "yyy"		// U+0176 to U+0178
+      "zzzzzz"		// U+0179 to U+017E
+      "s";		// U+017F
+
+   Folded[0] = '\0';
+
+   if (CodePoint < 0x80)		// ASCII
+     {
+      if (isalnum ((int) CodePoint))
+	{
+	 Folded[0] = (char) tolower ((int) CodePoint);
+	 Folded[1] = '\0';
+	}
+     }
+   else if (CodePoint < 0xC0)		// Latin-1 symbols separate words
+      return;
+   else if (CodePoint < 0x100)		// Latin-1 letters
+      Str_Copy (Folded,Latin1[CodePoint - 0xC0],
+                Sch_MAX_BYTES_FOLDED_CHAR);
+   else if (CodePoint < 0x180)		// Latin Extended-A letters
+      switch (CodePoint)
+	{
+	 case 0x132:
+	 case 0x133:
+	    Str_Copy (Folded,"ij",Sch_MAX_BYTES_FOLDED_CHAR);
+	    break;
+	 case 0x152:
+	 case 0x153:
+	    Str_Copy (Folded,"oe",Sch_MAX_BYTES_FOLDED_CHAR);
+	    break;
+	 default:
+	    Folded[0] = LatinExtA[CodePoint - 0x100];
+	    Folded[1] = '\0';
+	    break;
+	}
+   else					// Other characters are kept as HTML entities
+      snprintf (Folded,Sch_MAX_BYTES_FOLDED_CHAR + 1,"&#%u;",CodePoint);
+  }
+
 /*****************************************************************************/
 /********************** Save last search into session ************************/
 /*****************************************************************************/
@@ -41,6 +41,8 @@
 
 #define Sch_MAX_BYTES_SEARCH_QUERY	(Sch_MAX_WORDS_IN_SEARCH * (128 + Sch_MAX_BYTES_SEARCH_WORD))
 
+#define Sch_MAX_BYTES_INDEX_WORD	 64	// Longer words are truncated in the index of words
+
 /*****************************************************************************/
 /******************************** Public types *******************************/
 /*****************************************************************************/
@@ -65,6 +67,14 @@ typedef enum
   } Sch_WhatToSearch_t;
 #define Sch_WHAT_TO_SEARCH_DEFAULT Sch_SEARCH_ALL
 
+// Type of the items indexed in database table sch_words
+typedef enum
+  {
+   Sch_INDEX_COURSES	= 1,	// Cod is a course code
+   Sch_INDEX_USERS	= 2,	// Cod is a user code
+   Sch_INDEX_FILES	= 3,	// Cod is a file code
+  } Sch_IndexType_t;
+
 /*****************************************************************************/
 /****************************** Public prototypes ****************************/
 /*****************************************************************************/
@@ -82,5 +92,15 @@ void Sch_SysSearch (void);
 bool Sch_BuildSearchQuery (char SearchQuery[Sch_MAX_BYTES_SEARCH_QUERY + 1],
                            const char *FieldName,
                            const char *CharSet,const char *Collate);
+bool Sch_BuildSearchQueryInIndex (char SearchQuery[Sch_MAX_BYTES_SEARCH_QUERY + 1],
+                                  Sch_IndexType_t Type);
+
+void Sch_UpdateIndexOfCrs (long CrsCod,const char *FullName);
+void Sch_UpdateIndexOfUsr (long UsrCod,
+                           const char *FirstName,
+                           const char *Surname1,const char *Surname2);
+void Sch_UpdateIndexOfFile (long FilCod,const char *Path);
+void Sch_RemoveFromIndex (Sch_IndexType_t Type,long Cod);
+void Sch_RepairSearchIndex (void);
 
 #endif
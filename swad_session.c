@@ -61,8 +61,26 @@ static bool Ses_CheckIfHiddenParIsAlreadyInDB (const char *ParamName);
 
 void Ses_GetNumSessions (void)
   {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+
    /***** Get the number of open sessions from database *****/
-   Gbl.Session.NumSessions = (unsigned) DB_GetNumRowsTable ("sessions");
+   /* The number of sessions is incremented when a session is created,
+      decremented when it is closed, and counted again periodically
+      by swad_maintenance (see Ses_RemoveExpiredSessions),
+      so sessions table is not scanned here.
+      Sessions expired since the last count are still counted
+      until they are removed (in the next run of the job, every minute) */
+   if (DB_QuerySELECT (&mysql_res,"can not get number of sessions",
+		       "SELECT NumSessions FROM sessions_count"))
+     {
+      row = mysql_fetch_row (mysql_res);
+      if (sscanf (row[0],"%u",&Gbl.Session.NumSessions) != 1)
+	 Gbl.Session.NumSessions = 0;
+     }
+   else	// Not counted yet
+      Gbl.Session.NumSessions = (unsigned) DB_GetNumRowsTable ("sessions");
+   DB_FreeMySQLResult (&mysql_res);
 
    Gbl.Usrs.Connected.TimeToRefreshInMs = (unsigned long) (Gbl.Session.NumSessions/Cfg_TIMES_PER_SECOND_REFRESH_CONNECTED) * 1000UL;
    if (Gbl.Usrs.Connected.TimeToRefreshInMs < Con_MIN_TIME_TO_REFRESH_CONNECTED_IN_MS)
@@ -104,10 +122,10 @@ void Ses_CreateSession (void)
 bool Ses_CheckIfSessionExists (const char *IdSes)
   {
    /***** Get if session already exists in database *****/
-   return (DB_QueryCOUNT ("can not check if a session already existed",
-			  "SELECT COUNT(*) FROM sessions"
-			  " WHERE SessionId='%s'",
-			  IdSes) != 0);
+   return (DB_QueryCOUNTprepared ("can not check if a session already existed",
+				  "SELECT COUNT(*) FROM sessions"
+				  " WHERE SessionId='%s'",
+				  IdSes) != 0);
   }
 
 /*****************************************************************************/
@@ -125,9 +143,7 @@ void Ses_CloseSession (void)
       Gbl.Session.Id[0] = '\0';
 
       /***** If there are no more sessions for current user ==> remove user from connected list *****/
-      Con_RemoveOldConnected ();
-
-      Ses_RemoveHiddenParFromExpiredSessions ();
+      Con_RemoveUsrIfNoSessions (Gbl.Usrs.Me.UsrDat.UsrCod);
 
       /***** Now, user is not logged in *****/
       Gbl.Usrs.Me.Role.LoggedBeforeCloseSession = Gbl.Usrs.Me.Role.Logged;
@@ -155,23 +171,30 @@ void Ses_InsertSessionInDB (void)
    if (Gbl.Search.WhatToSearch == Sch_SEARCH_UNKNOWN)
       Gbl.Search.WhatToSearch = Sch_WHAT_TO_SEARCH_DEFAULT;
 
-   DB_QueryINSERT ("can not create session",
-		   "INSERT INTO sessions"
-	           " (SessionId,UsrCod,Password,Role,"
-                   "CtyCod,InsCod,CtrCod,DegCod,CrsCod,LastTime,LastRefresh,WhatToSearch)"
-                   " VALUES"
-                   " ('%s',%ld,'%s',%u,"
-                   "%ld,%ld,%ld,%ld,%ld,NOW(),NOW(),%u)",
-		   Gbl.Session.Id,
-		   Gbl.Usrs.Me.UsrDat.UsrCod,
-		   Gbl.Usrs.Me.UsrDat.Password,
-		   (unsigned) Gbl.Usrs.Me.Role.Logged,
-		   Gbl.Hierarchy.Cty.CtyCod,
-		   Gbl.Hierarchy.Ins.InsCod,
-		   Gbl.Hierarchy.Ctr.CtrCod,
-		   Gbl.Hierarchy.Deg.DegCod,
-		   Gbl.Hierarchy.Crs.CrsCod,
-		   Gbl.Search.WhatToSearch);
+   DB_QueryINSERTprepared ("can not create session",
+			   "INSERT INTO sessions"
+			   " (SessionId,UsrCod,Password,Role,"
+			   "CtyCod,InsCod,CtrCod,DegCod,CrsCod,LastTime,LastRefresh,Expire,WhatToSearch)"
+			   " VALUES"
+			   " ('%s',%ld,'%s',%u,"
+			   "%ld,%ld,%ld,%ld,%ld,NOW(),NOW(),NOW()+INTERVAL %lu SECOND,%u)",
+			   Gbl.Session.Id,
+			   Gbl.Usrs.Me.UsrDat.UsrCod,
+			   Gbl.Usrs.Me.UsrDat.Password,
+			   (unsigned) Gbl.Usrs.Me.Role.Logged,
+			   Gbl.Hierarchy.Cty.CtyCod,
+			   Gbl.Hierarchy.Ins.InsCod,
+			   Gbl.Hierarchy.Ctr.CtrCod,
+			   Gbl.Hierarchy.Deg.DegCod,
+			   Gbl.Hierarchy.Crs.CrsCod,
+			   (unsigned long) Cfg_TIME_TO_CLOSE_SESSION_FROM_LAST_CLICK,
+			   Gbl.Search.WhatToSearch);
+
+   /***** Increment number of open sessions *****/
+   DB_QueryUPDATEprepared ("can not update number of sessions",
+			   "UPDATE sessions_count"
+			   " SET NumSessions=NumSessions+1"
+			   " WHERE Id=0");
   }
 
 /*****************************************************************************/
@@ -181,20 +204,22 @@ void Ses_InsertSessionInDB (void)
 void Ses_UpdateSessionDataInDB (void)
   {
    /***** Update session in database *****/
-   DB_QueryUPDATE ("can not update session",
-		   "UPDATE sessions SET UsrCod=%ld,Password='%s',Role=%u,"
-                   "CtyCod=%ld,InsCod=%ld,CtrCod=%ld,DegCod=%ld,CrsCod=%ld,"
-                   "LastTime=NOW(),LastRefresh=NOW()"
-                   " WHERE SessionId='%s'",
-		   Gbl.Usrs.Me.UsrDat.UsrCod,
-		   Gbl.Usrs.Me.UsrDat.Password,
-		   (unsigned) Gbl.Usrs.Me.Role.Logged,
-		   Gbl.Hierarchy.Cty.CtyCod,
-		   Gbl.Hierarchy.Ins.InsCod,
-		   Gbl.Hierarchy.Ctr.CtrCod,
-		   Gbl.Hierarchy.Deg.DegCod,
-		   Gbl.Hierarchy.Crs.CrsCod,
-		   Gbl.Session.Id);
+   DB_QueryUPDATEprepared ("can not update session",
+			   "UPDATE sessions SET UsrCod=%ld,Password='%s',Role=%u,"
+			   "CtyCod=%ld,InsCod=%ld,CtrCod=%ld,DegCod=%ld,CrsCod=%ld,"
+			   "LastTime=NOW(),LastRefresh=NOW(),"
+			   "Expire=NOW()+INTERVAL %lu SECOND"
+			   " WHERE SessionId='%s'",
+			   Gbl.Usrs.Me.UsrDat.UsrCod,
+			   Gbl.Usrs.Me.UsrDat.Password,
+			   (unsigned) Gbl.Usrs.Me.Role.Logged,
+			   Gbl.Hierarchy.Cty.CtyCod,
+			   Gbl.Hierarchy.Ins.InsCod,
+			   Gbl.Hierarchy.Ctr.CtrCod,
+			   Gbl.Hierarchy.Deg.DegCod,
+			   Gbl.Hierarchy.Crs.CrsCod,
+			   (unsigned long) Cfg_TIME_TO_CLOSE_SESSION_FROM_LAST_CLICK,
+			   Gbl.Session.Id);
   }
 
 /*****************************************************************************/
@@ -204,9 +229,16 @@ void Ses_UpdateSessionDataInDB (void)
 void Ses_UpdateSessionLastRefreshInDB (void)
   {
    /***** Update session in database *****/
-   DB_QueryUPDATE ("can not update session",
-		   "UPDATE sessions SET LastRefresh=NOW() WHERE SessionId='%s'",
-		   Gbl.Session.Id);
+   /* After a refresh, the session expires when last refresh is too old
+      (browser probably was closed), but never after last click expires */
+   DB_QueryUPDATEprepared ("can not update session",
+			   "UPDATE sessions SET LastRefresh=NOW(),"
+			   "Expire=LEAST(LastTime+INTERVAL %lu SECOND,"
+			                "NOW()+INTERVAL %lu SECOND)"
+			   " WHERE SessionId='%s'",
+			   (unsigned long) Cfg_TIME_TO_CLOSE_SESSION_FROM_LAST_CLICK,
+			   (unsigned long) Cfg_TIME_TO_CLOSE_SESSION_FROM_LAST_REFRESH,
+			   Gbl.Session.Id);
   }
 
 /*****************************************************************************/
@@ -216,9 +248,20 @@ void Ses_UpdateSessionLastRefreshInDB (void)
 static void Ses_RemoveSessionFromDB (void)
   {
    /***** Remove current session *****/
-   DB_QueryDELETE ("can not remove a session",
-		   "DELETE FROM sessions WHERE SessionId='%s'",
-		   Gbl.Session.Id);
+   DB_QueryDELETEprepared ("can not remove a session",
+			   "DELETE FROM sessions WHERE SessionId='%s'",
+			   Gbl.Session.Id);
+
+   /***** Decrement number of open sessions *****/
+   DB_QueryUPDATEprepared ("can not update number of sessions",
+			   "UPDATE sessions_count"
+			   " SET NumSessions=NumSessions-1"
+			   " WHERE Id=0 AND NumSessions>0");
+
+   /***** Remove hidden parameters of current session *****/
+   DB_QueryDELETEprepared ("can not remove hidden parameters of current session",
+			   "DELETE FROM hidden_params WHERE SessionId='%s'",
+			   Gbl.Session.Id);
 
    /***** Clear old unused social timelines in database *****/
    // This is necessary to prevent the table growing and growing
@@ -229,22 +272,33 @@ static void Ses_RemoveSessionFromDB (void)
 /*************************** Remove expired sessions *************************/
 /*****************************************************************************/
 
+// Run periodically by swad_maintenance, not in users' requests.
+// Meanwhile, an expired session is ignored by Ses_GetSessionData
+
 void Ses_RemoveExpiredSessions (void)
   {
    /***** Remove expired sessions *****/
-   /* A session expire
+   /* A session expires
       when last click (LastTime) is too old,
       or (when there was at least one refresh (navigator supports AJAX)
-          and last refresh is too old (browser probably was closed)) */
-   DB_QueryDELETE ("can not remove expired sessions",
-		   "DELETE LOW_PRIORITY FROM sessions WHERE"
-                   " LastTime<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)"
-                   " OR "
-                   "(LastRefresh>LastTime+INTERVAL 1 SECOND"
-                   " AND"
-                   " LastRefresh<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu))",
-                   Cfg_TIME_TO_CLOSE_SESSION_FROM_LAST_CLICK,
-                   Cfg_TIME_TO_CLOSE_SESSION_FROM_LAST_REFRESH);
+          and last refresh is too old (browser probably was closed)).
+      Expire time is computed on each click and refresh,
+      so expired sessions are got using an index */
+   DB_QueryDELETEinBatches ("can not remove expired sessions",
+			    "DELETE LOW_PRIORITY FROM sessions"
+			    " WHERE Expire<NOW()");
+
+   /***** Remove users without sessions from connected list *****/
+   Con_RemoveOldConnected ();
+
+   /***** Remove hidden parameters from expired sessions *****/
+   Ses_RemoveHiddenParFromExpiredSessions ();
+
+   /***** Count the sessions still open *****/
+   DB_QueryREPLACE ("can not update number of sessions",
+		    "REPLACE INTO sessions_count"
+		    " (Id,NumSessions)"
+		    " SELECT 0,COUNT(*) FROM sessions");
   }
 
 /*****************************************************************************/
@@ -271,7 +325,8 @@ bool Ses_GetSessionData (void)
 			      "WhatToSearch,"	// row[8]
 			      "SearchStr"	// row[9]
 		       " FROM sessions"
-		       " WHERE SessionId='%s'",
+		       " WHERE SessionId='%s'"
+		       " AND Expire>=NOW()",	// Expired sessions not removed yet are ignored
 		       Gbl.Session.Id))
      {
       row = mysql_fetch_row (mysql_res);
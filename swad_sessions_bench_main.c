@@ -0,0 +1,390 @@
+// swad_sessions_bench_main.c: main of swad_sessions_bench, load test of sessions
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <signal.h>		// For kill
+#include <stdio.h>		// For fprintf, printf, snprintf
+#include <stdlib.h>		// For atoi, exit
+#include <sys/wait.h>		// For wait
+#include <unistd.h>		// For fork, pipe, read, write, close
+
+#include "swad_bench.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define SeB_SECONDS_FROM_LAST_CLICK	(8UL * 60UL * 60UL)	// As Cfg_TIME_TO_CLOSE_SESSION_FROM_LAST_CLICK
+#define SeB_SECONDS_FROM_LAST_REFRESH	(60UL * 60UL)		// As Cfg_TIME_TO_CLOSE_SESSION_FROM_LAST_REFRESH
+#define SeB_PERCENT_EXPIRED		10	// Sessions already expired when test starts
+#define SeB_REQUESTS_PER_LOGIN		20	// Every these requests, a session is closed and other is created
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   SeB_BEFORE,	// Each request removes expired sessions and counts sessions
+   SeB_NOW,	// Expired sessions are removed by maintenance and sessions are counted in a table
+  } SeB_Version_t;
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void SeB_CreateTables (unsigned NumSessions);
+static double SeB_RunClients (char *ArgsDB[Bch_NUM_ARGS_DB],SeB_Version_t Version,
+                              unsigned NumSessions,
+                              unsigned NumClients,unsigned NumRequestsPerClient);
+static void SeB_RunOneClient (SeB_Version_t Version,unsigned NumClient,
+                              unsigned NumSessions,unsigned NumRequests);
+static void SeB_Request (SeB_Version_t Version,const char *SessionId);
+static void SeB_CloseAndCreateSession (SeB_Version_t Version,
+                                       const char *OldSessionId,
+                                       const char *NewSessionId,long UsrCod);
+static void SeB_RemoveExpiredSessions (void);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_sessions_bench <host> <user> <password> <database>
+                              <sessions> <clients> <requests per client>
+   The given number of clients (processes, each with its own connection)
+   make requests at the same time, reading and updating their sessions
+   as in every request, and closing and creating sessions from time to time:
+   1. as before: each request removes expired sessions and counts sessions,
+   2. now: each request reads the number of sessions from a table,
+      which is updated when a session is created or closed,
+      and expired sessions are removed by another process every second
+      (as swad_maintenance does every minute).
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumSessions;
+   int NumClients;
+   int NumRequestsPerClient;
+   double Seconds;
+   unsigned long NumRequests;
+   SeB_Version_t Version;
+   static const char *Txt[] =
+     {
+      [SeB_BEFORE] = "Remove expired and count in each request",
+      [SeB_NOW   ] = "Counter table and removal outside requests",
+     };
+
+   if (argc != 1 + Bch_NUM_ARGS_DB + 3 ||
+       (NumSessions          = atoi (argv[1 + Bch_NUM_ARGS_DB    ])) <= 0 ||
+       (NumClients           = atoi (argv[1 + Bch_NUM_ARGS_DB + 1])) <= 0 ||
+       (NumRequestsPerClient = atoi (argv[1 + Bch_NUM_ARGS_DB + 2])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s " Bch_USAGE_DB
+		      " <sessions> <clients> <requests per client>\n",
+	       argv[0]);
+      return 1;
+     }
+
+   NumRequests = (unsigned long) NumClients * (unsigned long) NumRequestsPerClient;
+   for (Version  = SeB_BEFORE;
+	Version <= SeB_NOW;
+	Version++)
+     {
+      Bch_ConnectToDB (&argv[1]);
+      SeB_CreateTables ((unsigned) NumSessions);
+      Bch_DisconnectFromDB ();
+
+      Seconds = SeB_RunClients (&argv[1],Version,(unsigned) NumSessions,
+				(unsigned) NumClients,(unsigned) NumRequestsPerClient);
+      Bch_WriteTime (Txt[Version],NumRequests,Seconds);
+      printf ("%48s %10.1f requests/s\n","",
+	      Seconds > 0.0 ? (double) NumRequests / Seconds :
+			      0.0);
+     }
+
+   Bch_ConnectToDB (&argv[1]);
+   Bch_Query ("DROP TABLE IF EXISTS bench_sessions,bench_sessions_count");
+   Bch_DisconnectFromDB ();
+   return 0;
+  }
+
+/*****************************************************************************/
+/************** Create tables similar to sessions and fill them **************/
+/*****************************************************************************/
+
+static void SeB_CreateTables (unsigned NumSessions)
+  {
+   unsigned NumSession;
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_sessions,bench_sessions_count");
+   Bch_Query ("CREATE TABLE bench_sessions ("
+		 "SessionId CHAR(43) NOT NULL,"
+		 "UsrCod INT NOT NULL,"
+		 "LastTime DATETIME,"
+		 "LastRefresh DATETIME,"
+		 "Expire DATETIME NOT NULL,"
+	      "UNIQUE INDEX(SessionId),"
+	      "INDEX(UsrCod),"
+	      "INDEX(Expire))");
+   Bch_Query ("CREATE TABLE bench_sessions_count ("
+		 "Id TINYINT NOT NULL DEFAULT 0,"
+		 "NumSessions INT NOT NULL DEFAULT 0,"
+	      "UNIQUE INDEX(Id))");
+
+   for (NumSession = 0;
+	NumSession < NumSessions;
+	NumSession++)
+      if (NumSession % 100 < SeB_PERCENT_EXPIRED)
+	 Bch_Query ("INSERT INTO bench_sessions"
+		    " (SessionId,UsrCod,LastTime,LastRefresh,Expire)"
+		    " VALUES"
+		    " ('x%u',%u,"
+		    "NOW()-INTERVAL %lu SECOND,NOW()-INTERVAL %lu SECOND,"
+		    "NOW()-INTERVAL 1 SECOND)",
+		    NumSession,NumSession + 1,
+		    SeB_SECONDS_FROM_LAST_CLICK + 1,
+		    SeB_SECONDS_FROM_LAST_CLICK + 1);
+      else
+	 Bch_Query ("INSERT INTO bench_sessions"
+		    " (SessionId,UsrCod,LastTime,LastRefresh,Expire)"
+		    " VALUES"
+		    " ('s%u',%u,NOW(),NOW(),NOW()+INTERVAL %lu SECOND)",
+		    NumSession,NumSession + 1,
+		    SeB_SECONDS_FROM_LAST_CLICK);
+
+   Bch_Query ("REPLACE INTO bench_sessions_count"
+	      " (Id,NumSessions)"
+	      " SELECT 0,COUNT(*) FROM bench_sessions");
+  }
+
+/*****************************************************************************/
+/********** Run several clients at the same time and return time *************/
+/*****************************************************************************/
+
+static double SeB_RunClients (char *ArgsDB[Bch_NUM_ARGS_DB],SeB_Version_t Version,
+                              unsigned NumSessions,
+                              unsigned NumClients,unsigned NumRequestsPerClient)
+  {
+   unsigned NumClient;
+   pid_t Sweeper = 0;
+   int Pipe[2];
+   char Done;
+   double Start;
+   double Seconds;
+
+   /***** Each client writes in this pipe when it ends *****/
+   if (pipe (Pipe))
+     {
+      fprintf (stderr,"Can not create pipe.\n");
+      exit (1);
+     }
+
+   /***** Launch process which removes expired sessions *****/
+   if (Version == SeB_NOW)
+      switch ((Sweeper = fork ()))
+	{
+	 case -1:
+	    fprintf (stderr,"Can not create process.\n");
+	    exit (1);
+	 case 0:	// Child
+	    close (Pipe[0]);
+	    close (Pipe[1]);
+	    Bch_ConnectToDB (ArgsDB);
+	    for (;;)
+	      {
+	       SeB_RemoveExpiredSessions ();
+	       sleep (1);
+	      }
+	 default:	// Parent
+	    break;
+	}
+
+   Start = Bch_GetSeconds ();
+
+   /***** Launch clients *****/
+   for (NumClient = 0;
+	NumClient < NumClients;
+	NumClient++)
+      switch (fork ())
+	{
+	 case -1:
+	    fprintf (stderr,"Can not create client process.\n");
+	    exit (1);
+	 case 0:	// Child
+	    close (Pipe[0]);
+	    Bch_ConnectToDB (ArgsDB);
+	    SeB_RunOneClient (Version,NumClient,NumSessions,NumRequestsPerClient);
+	    Bch_DisconnectFromDB ();
+	    Done = 1;
+	    if (write (Pipe[1],&Done,1) != 1)
+	       exit (1);
+	    exit (0);
+	 default:	// Parent
+	    break;
+	}
+
+   /***** Wait for all clients *****/
+   close (Pipe[1]);
+   while (read (Pipe[0],&Done,1) == 1);
+   close (Pipe[0]);
+
+   Seconds = Bch_GetSeconds () - Start;
+
+   /***** Stop sweeper and wait for all processes *****/
+   if (Sweeper > 0)
+      kill (Sweeper,SIGTERM);
+   while (wait (NULL) > 0);
+
+   return Seconds;
+  }
+
+/*****************************************************************************/
+/************** Make several requests, one after another *********************/
+/*****************************************************************************/
+// Each client uses sessions NumClient, NumClient + NumClients...
+
+static void SeB_RunOneClient (SeB_Version_t Version,unsigned NumClient,
+                              unsigned NumSessions,unsigned NumRequests)
+  {
+   unsigned NumRequest;
+   unsigned NumSession = NumClient % NumSessions;
+   unsigned NumLogin = 0;
+   char SessionId[32];
+   char NewSessionId[32];
+
+   snprintf (SessionId,sizeof (SessionId),"s%u",NumSession);
+   for (NumRequest = 0;
+	NumRequest < NumRequests;
+	NumRequest++)
+      if ((NumRequest + 1) % SeB_REQUESTS_PER_LOGIN)
+	 SeB_Request (Version,SessionId);
+      else
+	{
+	 snprintf (NewSessionId,sizeof (NewSessionId),"c%u_%u",
+		   NumClient,NumLogin++);
+	 SeB_CloseAndCreateSession (Version,SessionId,NewSessionId,
+				    (long) NumSession + 1);
+	 snprintf (SessionId,sizeof (SessionId),"%s",NewSessionId);
+	}
+  }
+
+/*****************************************************************************/
+/********************* Queries about sessions in a request *******************/
+/*****************************************************************************/
+
+static void SeB_Request (SeB_Version_t Version,const char *SessionId)
+  {
+   MYSQL_RES *mysql_res;
+
+   switch (Version)
+     {
+      case SeB_BEFORE:
+	 /* Remove expired sessions */
+	 Bch_Query ("DELETE LOW_PRIORITY FROM bench_sessions WHERE"
+		    " LastTime<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)"
+		    " OR "
+		    "(LastRefresh>LastTime+INTERVAL 1 SECOND"
+		    " AND"
+		    " LastRefresh<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu))",
+		    SeB_SECONDS_FROM_LAST_CLICK,
+		    SeB_SECONDS_FROM_LAST_REFRESH);
+
+	 /* Count sessions */
+	 Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_sessions");
+
+	 /* Get and update my session */
+	 Bch_QuerySELECT (&mysql_res,
+			  "SELECT UsrCod FROM bench_sessions"
+			  " WHERE SessionId='%s'",
+			  SessionId);
+	 mysql_free_result (mysql_res);
+	 Bch_Query ("UPDATE bench_sessions"
+		    " SET LastTime=NOW(),LastRefresh=NOW()"
+		    " WHERE SessionId='%s'",
+		    SessionId);
+	 break;
+      case SeB_NOW:
+	 /* Get number of sessions */
+	 Bch_QueryCOUNT ("SELECT NumSessions FROM bench_sessions_count");
+
+	 /* Get and update my session */
+	 Bch_QuerySELECT (&mysql_res,
+			  "SELECT UsrCod FROM bench_sessions"
+			  " WHERE SessionId='%s'"
+			  " AND Expire>=NOW()",
+			  SessionId);
+	 mysql_free_result (mysql_res);
+	 Bch_Query ("UPDATE bench_sessions"
+		    " SET LastTime=NOW(),LastRefresh=NOW(),"
+		    "Expire=NOW()+INTERVAL %lu SECOND"
+		    " WHERE SessionId='%s'",
+		    SeB_SECONDS_FROM_LAST_CLICK,
+		    SessionId);
+	 break;
+     }
+  }
+
+/*****************************************************************************/
+/****************** Close a session and create a new one *********************/
+/*****************************************************************************/
+
+static void SeB_CloseAndCreateSession (SeB_Version_t Version,
+                                       const char *OldSessionId,
+                                       const char *NewSessionId,long UsrCod)
+  {
+   /***** Close session *****/
+   Bch_Query ("DELETE FROM bench_sessions WHERE SessionId='%s'",
+	      OldSessionId);
+   if (Version == SeB_NOW)
+      Bch_Query ("UPDATE bench_sessions_count"
+		 " SET NumSessions=NumSessions-1"
+		 " WHERE Id=0 AND NumSessions>0");
+
+   /***** Create session *****/
+   Bch_Query ("INSERT INTO bench_sessions"
+	      " (SessionId,UsrCod,LastTime,LastRefresh,Expire)"
+	      " VALUES"
+	      " ('%s',%ld,NOW(),NOW(),NOW()+INTERVAL %lu SECOND)",
+	      NewSessionId,UsrCod,SeB_SECONDS_FROM_LAST_CLICK);
+   if (Version == SeB_NOW)
+      Bch_Query ("UPDATE bench_sessions_count"
+		 " SET NumSessions=NumSessions+1"
+		 " WHERE Id=0");
+  }
+
+/*****************************************************************************/
+/******** Remove expired sessions and count sessions, outside requests *******/
+/*****************************************************************************/
+
+static void SeB_RemoveExpiredSessions (void)
+  {
+   Bch_Query ("DELETE LOW_PRIORITY FROM bench_sessions"
+	      " WHERE Expire<NOW()");
+   Bch_Query ("REPLACE INTO bench_sessions_count"
+	      " (Id,NumSessions)"
+	      " SELECT 0,COUNT(*) FROM bench_sessions");
+  }
@@ -228,10 +228,10 @@ void Set_SetSettingsFromIP (void)
 void Set_RemoveOldSettingsFromIP (void)
   {
    /***** Remove old settings *****/
-   DB_QueryDELETE ("can not remove old settings",
-		   "DELETE LOW_PRIORITY FROM IP_prefs"
-		   " WHERE LastChange<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
-                   Cfg_TIME_TO_DELETE_IP_PREFS);
+   DB_QueryDELETEinBatches ("can not remove old settings",
+			    "DELETE LOW_PRIORITY FROM IP_prefs"
+			    " WHERE LastChange<FROM_UNIXTIME(UNIX_TIMESTAMP()-%lu)",
+			    Cfg_TIME_TO_DELETE_IP_PREFS);
   }
 
 /*****************************************************************************/
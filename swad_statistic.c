@@ -86,6 +86,12 @@ static const unsigned Sta_CellPadding[Sta_NUM_CLICKS_GROUPED_BY] =
 
 #define Sta_STAT_RESULTS_SECTION_ID	"stat_results"
 
+#define Sta_MAX_BYTES_ROLLUP_FILTER (256 - 1)
+
+#define Sta_LENGTH_DATETIME (4 + 1 + 2 + 1 + 2 + 1 + 2 + 1 + 2 + 1 + 2)	// "YYYY-MM-DD HH:MM:SS"
+
+#define Sta_ROLLUP_LOCK	"swad_sta_hits"	// Name of database lock used to roll up hits
+
 /*****************************************************************************/
 /******************************* Private types *******************************/
 /*****************************************************************************/
@@ -96,6 +102,15 @@ typedef enum
    Sta_SHOW_COURSE_ACCESSES,
   } Sta_GlobalOrCourseAccesses_t;
 
+struct Sta_DetailedClick
+  {
+   long LogCod;
+   long UsrCod;
+   unsigned Role;
+   time_t ClickTime;
+   long ActCod;
+  };
+
 /*****************************************************************************/
 /***************************** Private prototypes ****************************/
 /*****************************************************************************/
@@ -103,7 +118,17 @@ typedef enum
 static void Sta_WriteSelectorCountType (void);
 static void Sta_WriteSelectorAction (void);
 static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse);
-static void Sta_ShowDetailedAccessesList (unsigned long NumRows,MYSQL_RES *mysql_res);
+static bool Sta_BuildSubqueryToGetHitsFromRollup (Sta_GlobalOrCourseAccesses_t GlobalOrCourse,
+                                                  char **Subquery);
+static bool Sta_CheckIfHitsCanBeGotFromRollup (Sta_GlobalOrCourseAccesses_t GlobalOrCourse);
+static void Sta_BuildFilterToGetHitsFromRollup (char Filter[Sta_MAX_BYTES_ROLLUP_FILTER + 1]);
+static void Sta_ShowDetailedAccessesList (unsigned long NumRows,const char *FromWhere);
+static unsigned Sta_GetRangeOfLogCodsInPage (const char *FromWhere,
+                                             long *MinLogCod,long *MaxLogCod);
+static void Sta_GetDetailedClicksInPage (const char *FromWhere,
+                                         long MinLogCod,long MaxLogCod,
+                                         struct Sta_DetailedClick *Clicks,
+                                         unsigned MaxClicks);
 static void Sta_WriteLogComments (long LogCod);
 static void Sta_ShowNumHitsPerUsr (unsigned long NumRows,MYSQL_RES *mysql_res);
 static void Sta_ShowNumHitsPerDay (unsigned long NumRows,MYSQL_RES *mysql_res);
@@ -256,8 +281,8 @@ void Sta_AskShowCrsHits (void)
          Frm_StartFormAnchor (ActSeeAccCrs,Sta_STAT_RESULTS_SECTION_ID);
 
          Grp_PutParamsCodGrps ();
-         Par_PutHiddenParamLong (NULL,"FirstRow",0);
-         Par_PutHiddenParamLong (NULL,"LastRow",0);
+         Par_PutHiddenParamLong (NULL,"OlderThan",-1L);
+         Par_PutHiddenParamLong (NULL,"NewerThan",-1L);
 
          /***** Put list of users to select some of them *****/
          HTM_TABLE_BeginCenterPadding (2);
@@ -689,7 +714,7 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
    char *Query = NULL;
    char QueryAux[512];
    long LengthQuery;
-   MYSQL_RES *mysql_res;
+   MYSQL_RES *mysql_res = NULL;
    unsigned long NumRows;
    const char *LogTable;
    Sta_ClicksDetailedOrGrouped_t DetailedOrGrouped = Sta_CLICKS_GROUPED;
@@ -701,6 +726,9 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
    char StrQueryCountType[Sta_MAX_BYTES_COUNT_TYPE + 1];
    unsigned NumDays;
    bool ICanQueryWholeRange;
+   bool FromRollup;
+   char *HitsFromRollup = NULL;
+   const char *LogFrom;
 
    /***** Get initial and ending dates *****/
    Dat_GetIniEndDatesFromForm ();
@@ -786,17 +814,10 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
       case Sta_SHOW_COURSE_ACCESSES:
 	 if (Gbl.Stat.ClicksGroupedBy == Sta_CLICKS_CRS_DETAILED_LIST)
 	   {
-	    /****** Get the number of the first row to show ******/
-	    Gbl.Stat.FirstRow = Par_GetParToUnsignedLong ("FirstRow",
-	                                                  1,
-	                                                  ULONG_MAX,
-	                                                  0);
-
-	    /****** Get the number of the last row to show ******/
-	    Gbl.Stat.LastRow = Par_GetParToUnsignedLong ("LastRow",
-	                                                 1,
-	                                                 ULONG_MAX,
-	                                                 0);
+	    /****** Get the page to show:
+	            clicks older or newer than a given click ******/
+	    Gbl.Stat.OlderThanLogCod = Par_GetParToLong ("OlderThan");
+	    Gbl.Stat.NewerThanLogCod = Par_GetParToLong ("NewerThan");
 
 	    /****** Get the number of rows per page ******/
 	    Gbl.Stat.RowsPerPage =
@@ -848,11 +869,22 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
       return;
      }
 
+   /***** Get hits from pre-aggregated table when possible *****/
+   if ((FromRollup = Sta_BuildSubqueryToGetHitsFromRollup (GlobalOrCourse,
+                                                          &HitsFromRollup)))
+     {
+      LogTable = "hits";
+      LogFrom  = HitsFromRollup;
+     }
+   else
+      LogFrom  = LogTable;
+
    /***** Query depending on the type of count *****/
    switch (Gbl.Stat.CountType)
      {
       case Sta_TOTAL_CLICKS:
-         Str_Copy (StrQueryCountType,"COUNT(*)",
+         Str_Copy (StrQueryCountType,FromRollup ? "SUM(hits.NumHits)" :
+                                                  "COUNT(*)",
                    Sta_MAX_BYTES_COUNT_TYPE);
 	 break;
       case Sta_DISTINCT_USRS:
@@ -862,10 +894,18 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
          sprintf (StrQueryCountType,"COUNT(*)/GREATEST(COUNT(DISTINCT(%s.UsrCod)),1)+0.000000",LogTable);
 	 break;
       case Sta_GENERATION_TIME:
-         sprintf (StrQueryCountType,"(AVG(%s.TimeToGenerate)/1E6)+0.000000",LogTable);
+	 if (FromRollup)
+            Str_Copy (StrQueryCountType,"(SUM(hits.TimeToGenerate)/SUM(hits.NumHits)/1E6)+0.000000",
+                      Sta_MAX_BYTES_COUNT_TYPE);
+	 else
+            sprintf (StrQueryCountType,"(AVG(%s.TimeToGenerate)/1E6)+0.000000",LogTable);
 	 break;
       case Sta_SEND_TIME:
-         sprintf (StrQueryCountType,"(AVG(%s.TimeToSend)/1E6)+0.000000",LogTable);
+	 if (FromRollup)
+            Str_Copy (StrQueryCountType,"(SUM(hits.TimeToSend)/SUM(hits.NumHits)/1E6)+0.000000",
+                      Sta_MAX_BYTES_COUNT_TYPE);
+	 else
+            sprintf (StrQueryCountType,"(AVG(%s.TimeToSend)/1E6)+0.000000",LogTable);
 	 break;
      }
 
@@ -878,15 +918,15 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
    switch (Gbl.Stat.ClicksGroupedBy)
      {
       case Sta_CLICKS_CRS_DETAILED_LIST:
+	 // Only FROM and WHERE. Clicks are got page by page
    	 snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
-   	           "SELECT SQL_NO_CACHE LogCod,UsrCod,Role,"
-   		   "UNIX_TIMESTAMP(ClickTime) AS F,ActCod FROM %s",
+   	           " FROM %s",
                    LogTable);
 	 break;
       case Sta_CLICKS_CRS_PER_USR:
 	 snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE UsrCod,%s AS Num FROM %s",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_CRS_PER_DAY:
       case Sta_CLICKS_GBL_PER_DAY:
@@ -895,7 +935,7 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
                    "DATE_FORMAT(CONVERT_TZ(ClickTime,@@session.time_zone,'%s'),'%%Y%%m%%d') AS Day,"
                    "%s FROM %s",
                    BrowserTimeZone,
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_CRS_PER_DAY_AND_HOUR:
       case Sta_CLICKS_GBL_PER_DAY_AND_HOUR:
@@ -906,7 +946,7 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
                    "%s FROM %s",
                    BrowserTimeZone,
                    BrowserTimeZone,
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_CRS_PER_WEEK:
       case Sta_CLICKS_GBL_PER_WEEK:
@@ -921,7 +961,7 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
 		   "DATE_FORMAT(CONVERT_TZ(ClickTime,@@session.time_zone,'%s'),'%%X%%V') AS Week,"
 		   "%s FROM %s",
 		   BrowserTimeZone,
-		   StrQueryCountType,LogTable);
+		   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_CRS_PER_MONTH:
       case Sta_CLICKS_GBL_PER_MONTH:
@@ -930,7 +970,7 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
                    "DATE_FORMAT(CONVERT_TZ(ClickTime,@@session.time_zone,'%s'),'%%Y%%m') AS Month,"
                    "%s FROM %s",
                    BrowserTimeZone,
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_CRS_PER_YEAR:
       case Sta_CLICKS_GBL_PER_YEAR:
@@ -939,7 +979,7 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
                    "DATE_FORMAT(CONVERT_TZ(ClickTime,@@session.time_zone,'%s'),'%%Y') AS Year,"
                    "%s FROM %s",
                    BrowserTimeZone,
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_CRS_PER_HOUR:
       case Sta_CLICKS_GBL_PER_HOUR:
@@ -948,7 +988,7 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
                    "DATE_FORMAT(CONVERT_TZ(ClickTime,@@session.time_zone,'%s'),'%%H') AS Hour,"
                    "%s FROM %s",
                    BrowserTimeZone,
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_CRS_PER_MINUTE:
       case Sta_CLICKS_GBL_PER_MINUTE:
@@ -957,53 +997,53 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
                    "DATE_FORMAT(CONVERT_TZ(ClickTime,@@session.time_zone,'%s'),'%%H%%i') AS Minute,"
                    "%s FROM %s",
                    BrowserTimeZone,
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_CRS_PER_ACTION:
       case Sta_CLICKS_GBL_PER_ACTION:
          snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE ActCod,%s AS Num FROM %s",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_GBL_PER_PLUGIN:
          snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE log_ws.PlgCod,%s AS Num FROM %s,log_ws",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
          break;
       case Sta_CLICKS_GBL_PER_API_FUNCTION:
          snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE log_ws.FunCod,%s AS Num FROM %s,log_ws",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
          break;
       case Sta_CLICKS_GBL_PER_BANNER:
          snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE log_banners.BanCod,%s AS Num FROM %s,log_banners",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
          break;
       case Sta_CLICKS_GBL_PER_COUNTRY:
          snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE CtyCod,%s AS Num FROM %s",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_GBL_PER_INSTITUTION:
          snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE InsCod,%s AS Num FROM %s",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_GBL_PER_CENTRE:
          snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE CtrCod,%s AS Num FROM %s",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_GBL_PER_DEGREE:
          snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE DegCod,%s AS Num FROM %s",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
       case Sta_CLICKS_GBL_PER_COURSE:
 	 snprintf (Query,Sta_MAX_BYTES_QUERY_ACCESS + 1,
    	           "SELECT SQL_NO_CACHE CrsCod,%s AS Num FROM %s",
-                   StrQueryCountType,LogTable);
+                   StrQueryCountType,LogFrom);
 	 break;
      }
    sprintf (QueryAux," WHERE %s.ClickTime"
@@ -1207,8 +1247,6 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
    switch (Gbl.Stat.ClicksGroupedBy)
      {
       case Sta_CLICKS_CRS_DETAILED_LIST:
-	 Str_Concat (Query," ORDER BY F",
-	             Sta_MAX_BYTES_QUERY_ACCESS);
 	 break;
       case Sta_CLICKS_CRS_PER_USR:
 	 sprintf (QueryAux," GROUP BY %s.UsrCod ORDER BY Num DESC",LogTable);
@@ -1300,9 +1338,16 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
       Ale_ShowFixedAlert (Ale_INFO,Query);
    */
    /***** Make the query *****/
-   NumRows = DB_QuerySELECT (&mysql_res,"can not get clicks",
-			     "%s",
-			     Query);
+   if (Gbl.Stat.ClicksGroupedBy == Sta_CLICKS_CRS_DETAILED_LIST)
+      /* Only the number of clicks.
+         The clicks in the page to show are got later */
+      NumRows = DB_QueryCOUNT ("can not get clicks",
+			       "SELECT SQL_NO_CACHE COUNT(*)%s",
+			       Query);
+   else
+      NumRows = DB_QuerySELECT (&mysql_res,"can not get clicks",
+				"%s",
+				Query);
 
    /***** Count the number of rows in result *****/
    if (NumRows == 0)
@@ -1321,7 +1366,7 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
       switch (Gbl.Stat.ClicksGroupedBy)
 	{
 	 case Sta_CLICKS_CRS_DETAILED_LIST:
-	    Sta_ShowDetailedAccessesList (NumRows,mysql_res);
+	    Sta_ShowDetailedAccessesList (NumRows,Query);
 	    break;
 	 case Sta_CLICKS_CRS_PER_USR:
 	    Sta_ShowNumHitsPerUsr (NumRows,mysql_res);
@@ -1393,6 +1438,11 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
    /***** Free structure that stores the query result *****/
    DB_FreeMySQLResult (&mysql_res);
 
+   /***** Free memory used by the queries *****/
+   free (Query);
+   if (HitsFromRollup)
+      free (HitsFromRollup);
+
    /***** Free memory used by list of selected users' codes *****/
    if (Gbl.Action.Act == ActSeeAccCrs)
       Usr_FreeListsSelectedEncryptedUsrsCods (&Gbl.Usrs.Selected);
@@ -1423,11 +1473,318 @@ static void Sta_ShowHits (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
      }
   }
 
+/*****************************************************************************/
+/******* Build subquery to get hits from table with pre-aggregated hits ******/
+/*****************************************************************************/
+/*
+   Table sta_hits stores the number of hits per hour, action, role
+   and place in the hierarchy. Hours already rolled up are
+   [FirstHour,EndHour) in table sta_hits_range.
+   Hits in the last hours, not yet rolled up, are got from recent log.
+   Return false if the query can not be answered from sta_hits
+   and must be answered from raw log.
+*/
+
+static bool Sta_BuildSubqueryToGetHitsFromRollup (Sta_GlobalOrCourseAccesses_t GlobalOrCourse,
+                                                  char **Subquery)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   time_t FirstHour;
+   time_t EndHour;
+   time_t StartTime = Gbl.DateRange.TimeUTC[Dat_START_TIME];
+   time_t EndTime   = Gbl.DateRange.TimeUTC[Dat_END_TIME  ] + 1;	// Not included
+   char Filter[Sta_MAX_BYTES_ROLLUP_FILTER + 1];
+   int NumBytesPrinted;
+
+   /***** Check if query can be answered from sta_hits *****/
+   if (!Sta_CheckIfHitsCanBeGotFromRollup (GlobalOrCourse))
+      return false;
+
+   /***** Get range of hours already rolled up *****/
+   if (!DB_QuerySELECT (&mysql_res,"can not get range of hits",
+			"SELECT UNIX_TIMESTAMP(FirstHour),"	// row[0]
+			       "UNIX_TIMESTAMP(EndHour)"	// row[1]
+			" FROM sta_hits_range"))
+     {
+      DB_FreeMySQLResult (&mysql_res);
+      return false;
+     }
+   row = mysql_fetch_row (mysql_res);
+   FirstHour = (time_t) Str_ConvertStrCodToLongCod (row[0]);
+   EndHour   = (time_t) Str_ConvertStrCodToLongCod (row[1]);
+   DB_FreeMySQLResult (&mysql_res);
+
+   /***** Check if range of dates can be got from sta_hits *****/
+   /* Start time must be an hour already rolled up.
+      It's not aligned to an hour when the time zone of the browser
+      is not a whole number of hours away from UTC */
+   if (StartTime % 3600 ||
+       StartTime < FirstHour ||
+       StartTime >= EndHour)
+      return false;
+
+   if (EndTime < EndHour)	// All hits have been rolled up
+     {
+      if (EndTime % 3600)
+	 return false;
+      EndHour = EndTime;
+     }
+   else				// The last hits are got from recent log
+      if (EndHour < Gbl.StartExecutionTimeUTC - (time_t) Cfg_DAYS_IN_RECENT_LOG * 24L * 60L * 60L)
+	 return false;
+
+   /***** Build subquery *****/
+   // Rows in subquery have the same columns as log tables,
+   // and the number of hits in each row
+   Sta_BuildFilterToGetHitsFromRollup (Filter);
+   if (EndTime > EndHour)
+      NumBytesPrinted = asprintf (Subquery,
+				  "(SELECT HitHour AS ClickTime,"
+					  "ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role,"
+					  "NumHits,TimeToGenerate,TimeToSend"
+				  " FROM sta_hits"
+				  " WHERE HitHour>=FROM_UNIXTIME(%ld)"
+				  " AND HitHour<FROM_UNIXTIME(%ld)%s"
+				  " UNION ALL "
+				  "SELECT ClickTime,"
+					 "ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role,"
+					 "1,TimeToGenerate,TimeToSend"
+				  " FROM log_recent"
+				  " WHERE ClickTime>=FROM_UNIXTIME(%ld)"
+				  " AND ClickTime<FROM_UNIXTIME(%ld)%s)"
+				  " AS hits",
+				  (long) StartTime,(long) EndHour,Filter,
+				  (long) EndHour,(long) EndTime,Filter);
+   else
+      NumBytesPrinted = asprintf (Subquery,
+				  "(SELECT HitHour AS ClickTime,"
+					  "ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role,"
+					  "NumHits,TimeToGenerate,TimeToSend"
+				  " FROM sta_hits"
+				  " WHERE HitHour>=FROM_UNIXTIME(%ld)"
+				  " AND HitHour<FROM_UNIXTIME(%ld)%s)"
+				  " AS hits",
+				  (long) StartTime,(long) EndHour,Filter);
+   if (NumBytesPrinted < 0)	// -1 if no memory or any other error
+      Lay_NotEnoughMemoryExit ();
+
+   return true;
+  }
+
+/*****************************************************************************/
+/************ Check if hits can be got from pre-aggregated table *************/
+/*****************************************************************************/
+// Distinct users can not be added from one hour to another,
+// so they are always got from raw log
+
+static bool Sta_CheckIfHitsCanBeGotFromRollup (Sta_GlobalOrCourseAccesses_t GlobalOrCourse)
+  {
+   /***** Only global accesses, not filtered by user *****/
+   if (GlobalOrCourse != Sta_SHOW_GLOBAL_ACCESSES ||
+       Gbl.Stat.Role == Sta_ROLE_ME)
+      return false;
+
+   /***** Type of count *****/
+   switch (Gbl.Stat.CountType)
+     {
+      case Sta_TOTAL_CLICKS:
+      case Sta_GENERATION_TIME:
+      case Sta_SEND_TIME:
+	 break;
+      default:
+	 return false;
+     }
+
+   /***** Grouping *****/
+   switch (Gbl.Stat.ClicksGroupedBy)
+     {
+      case Sta_CLICKS_GBL_PER_DAY:
+      case Sta_CLICKS_GBL_PER_DAY_AND_HOUR:
+      case Sta_CLICKS_GBL_PER_WEEK:
+      case Sta_CLICKS_GBL_PER_MONTH:
+      case Sta_CLICKS_GBL_PER_YEAR:
+      case Sta_CLICKS_GBL_PER_HOUR:
+      case Sta_CLICKS_GBL_PER_ACTION:
+      case Sta_CLICKS_GBL_PER_COUNTRY:
+      case Sta_CLICKS_GBL_PER_INSTITUTION:
+      case Sta_CLICKS_GBL_PER_CENTRE:
+      case Sta_CLICKS_GBL_PER_DEGREE:
+      case Sta_CLICKS_GBL_PER_COURSE:
+	 return true;
+      default:	// Per minute, or joined with other log tables
+	 return false;
+     }
+  }
+
+/*****************************************************************************/
+/******* Build filter by scope, role and action to get rolled up hits ********/
+/*****************************************************************************/
+
+static void Sta_BuildFilterToGetHitsFromRollup (char Filter[Sta_MAX_BYTES_ROLLUP_FILTER + 1])
+  {
+   static const Rol_Role_t Role[Sta_NUM_ROLES_STAT] =
+     {
+      [Sta_ROLE_INS_ADMINS          ] = Rol_INS_ADM,
+      [Sta_ROLE_CTR_ADMINS          ] = Rol_CTR_ADM,
+      [Sta_ROLE_DEG_ADMINS          ] = Rol_DEG_ADM,
+      [Sta_ROLE_TEACHERS            ] = Rol_TCH,
+      [Sta_ROLE_NON_EDITING_TEACHERS] = Rol_NET,
+      [Sta_ROLE_STUDENTS            ] = Rol_STD,
+      [Sta_ROLE_USERS               ] = Rol_USR,
+      [Sta_ROLE_GUESTS              ] = Rol_GST,
+      [Sta_ROLE_UNKNOWN_USRS        ] = Rol_UNK,
+     };
+   char *Ptr = Filter;
+
+   /***** Scope *****/
+   Filter[0] = '\0';
+   switch (Gbl.Scope.Current)
+     {
+      case Hie_CTY:
+	 if (Gbl.Hierarchy.Cty.CtyCod > 0)
+	    Ptr += sprintf (Ptr," AND CtyCod=%ld",Gbl.Hierarchy.Cty.CtyCod);
+	 break;
+      case Hie_INS:
+	 if (Gbl.Hierarchy.Ins.InsCod > 0)
+	    Ptr += sprintf (Ptr," AND InsCod=%ld",Gbl.Hierarchy.Ins.InsCod);
+	 break;
+      case Hie_CTR:
+	 if (Gbl.Hierarchy.Ctr.CtrCod > 0)
+	    Ptr += sprintf (Ptr," AND CtrCod=%ld",Gbl.Hierarchy.Ctr.CtrCod);
+	 break;
+      case Hie_DEG:
+	 if (Gbl.Hierarchy.Deg.DegCod > 0)
+	    Ptr += sprintf (Ptr," AND DegCod=%ld",Gbl.Hierarchy.Deg.DegCod);
+	 break;
+      case Hie_CRS:
+	 if (Gbl.Hierarchy.Level == Hie_CRS)
+	    Ptr += sprintf (Ptr," AND CrsCod=%ld",Gbl.Hierarchy.Crs.CrsCod);
+	 break;
+      default:
+	 break;
+     }
+
+   /***** Type of users *****/
+   switch (Gbl.Stat.Role)
+     {
+      case Sta_ROLE_IDENTIFIED_USRS:
+	 Ptr += sprintf (Ptr," AND Role<>%u",(unsigned) Rol_UNK);
+	 break;
+      case Sta_ROLE_ALL_USRS:
+      case Sta_ROLE_ME:		// Never got from sta_hits
+	 break;
+      default:
+	 Ptr += sprintf (Ptr," AND Role=%u",(unsigned) Role[Gbl.Stat.Role]);
+	 break;
+     }
+
+   /***** Action *****/
+   if (Gbl.Stat.NumAction != ActAll)
+      sprintf (Ptr," AND ActCod=%ld",Act_GetActCod (Gbl.Stat.NumAction));
+  }
+
+/*****************************************************************************/
+/************ Roll up hits in recent log into pre-aggregated table ***********/
+/*****************************************************************************/
+// Complete hours are added to sta_hits, in chronological order.
+// An hour is complete when no access in that hour is still waiting in spool.
+// If the update of the range fails after inserting the hits,
+// the same hours are rolled up again and their rows are replaced, not added
+
+void Sta_RollUpHits (void)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   bool ThereAreHoursToRollUp = false;
+   time_t OldestInSpool;
+   char BeginHour[Sta_LENGTH_DATETIME + 1];
+   char EndHour[Sta_LENGTH_DATETIME + 1];
+
+   /***** Only one process at a time. If other is rolling up, do nothing *****/
+   if (!DB_GetLock (Sta_ROLLUP_LOCK))
+      return;
+
+   /***** First time: start with the first complete hour in recent log *****/
+   if (!DB_QueryCOUNT ("can not get range of hits",
+		       "SELECT COUNT(*) FROM sta_hits_range"))
+      DB_QueryINSERT ("can not create range of hits",
+		      "INSERT INTO sta_hits_range"
+		      " (FirstHour,EndHour)"
+		      " SELECT FirstHour,FirstHour"
+		      " FROM (SELECT DATE_FORMAT(COALESCE(MIN(ClickTime),NOW()) + INTERVAL 1 HOUR,"
+					       "'%%Y-%%m-%%d %%H:00:00') AS FirstHour"
+			    " FROM log_recent) AS first_hour");
+
+   /***** Get the oldest access not yet loaded from spool.
+	  Hours from the hour of that access are not complete *****/
+   if (!Log_GetTimeOfOldestAccessInSpool (&OldestInSpool))
+      OldestInSpool = time (NULL);
+
+   /***** Get next hours to roll up.
+	  Wait some time after the end of an hour
+	  for requests which have not yet written their access in spool *****/
+   if (DB_QuerySELECT (&mysql_res,"can not get hours to roll up",
+		       "SELECT EndHour,"					// row[0]
+			      "LEAST(EndHour + INTERVAL %u HOUR,"
+				    "CAST(DATE_FORMAT(NOW() - INTERVAL %lu SECOND,"
+						     "'%%Y-%%m-%%d %%H:00:00') AS DATETIME),"
+				    "CAST(DATE_FORMAT(FROM_UNIXTIME(%ld),"
+						     "'%%Y-%%m-%%d %%H:00:00') AS DATETIME))"	// row[1]
+		       " FROM sta_hits_range",
+		       Cfg_MAX_HOURS_TO_ROLL_UP_HITS,
+		       (unsigned long) Cfg_TIME_TO_WAIT_TO_ROLL_UP_HITS,
+		       (long) OldestInSpool))
+     {
+      row = mysql_fetch_row (mysql_res);
+      if (row[0] && row[1])
+	{
+	 Str_Copy (BeginHour,row[0],
+	           Sta_LENGTH_DATETIME);
+	 Str_Copy (EndHour,row[1],
+	           Sta_LENGTH_DATETIME);
+	 ThereAreHoursToRollUp = (strcmp (EndHour,BeginHour) > 0);
+	}
+     }
+   DB_FreeMySQLResult (&mysql_res);
+
+   if (ThereAreHoursToRollUp)
+     {
+      /***** Add hits in these hours to sta_hits.
+	     Rows of hours already rolled up are replaced *****/
+      DB_QueryINSERT ("can not roll up hits",
+		      "INSERT INTO sta_hits"
+		      " (HitHour,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role,"
+		      "NumHits,TimeToGenerate,TimeToSend)"
+		      " SELECT DATE_FORMAT(ClickTime,'%%Y-%%m-%%d %%H:00:00') AS Hour,"
+			      "ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role,"
+			      "COUNT(*),SUM(TimeToGenerate),SUM(TimeToSend)"
+		      " FROM log_recent"
+		      " WHERE ClickTime>='%s' AND ClickTime<'%s'"
+		      " GROUP BY Hour,ActCod,CtyCod,InsCod,CtrCod,DegCod,CrsCod,Role"
+		      " ON DUPLICATE KEY UPDATE"
+		      " NumHits=VALUES(NumHits),"
+		      "TimeToGenerate=VALUES(TimeToGenerate),"
+		      "TimeToSend=VALUES(TimeToSend)",
+		      BeginHour,EndHour);
+
+      /***** Update range of hours rolled up *****/
+      DB_QueryUPDATE ("can not update range of hits",
+		      "UPDATE sta_hits_range SET EndHour='%s'",
+		      EndHour);
+     }
+
+   /***** Unlock *****/
+   DB_ReleaseLock (Sta_ROLLUP_LOCK);
+  }
+
 /*****************************************************************************/
 /******************* Show a listing of detailed clicks ***********************/
 /*****************************************************************************/
 
-static void Sta_ShowDetailedAccessesList (unsigned long NumRows,MYSQL_RES *mysql_res)
+// FromWhere is " FROM log_table WHERE ..." with the clicks to list
+
+static void Sta_ShowDetailedAccessesList (unsigned long NumRows,const char *FromWhere)
   {
    extern Act_Action_t Act_FromActCodToAction[1 + Act_MAX_ACTION_COD];
    extern const char *Txt_Show_previous_X_clicks;
@@ -1448,37 +1805,41 @@ static void Sta_ShowDetailedAccessesList (unsigned long NumRows,MYSQL_RES *mysql
    unsigned long NumRow;
    unsigned long FirstRow;	// First row to show
    unsigned long LastRow;	// Last rows to show
+   long MinLogCod;		// Oldest click in the page
+   long MaxLogCod;		// Newest click in the page
+   unsigned NumClicks;		// Number of clicks in the page
+   unsigned NumClick;
+   struct Sta_DetailedClick *Clicks;
    unsigned long NumPagesBefore;
    unsigned long NumPagesAfter;
    unsigned long NumPagsTotal;
    struct UsrData UsrDat;
-   MYSQL_ROW row;
-   long LogCod;
    Rol_Role_t RoleFromLog;
    unsigned UniqueId;
    char *Id;
-   long ActCod;
 
-   /***** Initialize estructura of data of the user *****/
-   Usr_UsrDataConstructor (&UsrDat);
+   /***** Get the range of clicks in the page to show *****/
+   // Clicks are paginated using the log code, not the row number,
+   // so the database does not have to skip all the previous rows
+   if ((NumClicks = Sta_GetRangeOfLogCodsInPage (FromWhere,&MinLogCod,&MaxLogCod)) == 0)
+      return;
 
    /***** Compute the first and the last row to show *****/
-   FirstRow = Gbl.Stat.FirstRow;
-   LastRow  = Gbl.Stat.LastRow;
-   if (FirstRow == 0 && LastRow == 0) // Call from main form
-     {
-      // Show last clicks
-      FirstRow = (NumRows / Gbl.Stat.RowsPerPage - 1) * Gbl.Stat.RowsPerPage + 1;
-      if ((FirstRow + Gbl.Stat.RowsPerPage - 1) < NumRows)
-	 FirstRow += Gbl.Stat.RowsPerPage;
-      LastRow = NumRows;
-     }
-   if (FirstRow < 1) // For security reasons; really it should never be less than 1
-      FirstRow = 1;
-   if (LastRow > NumRows)
+   LastRow = DB_QueryCOUNT ("can not get clicks",
+			    "SELECT SQL_NO_CACHE COUNT(*)%s AND LogCod<=%ld",
+			    FromWhere,MaxLogCod);
+   if (LastRow > NumRows)	// For if there have been new clicks
       LastRow = NumRows;
-   if ((LastRow - FirstRow) >= Gbl.Stat.RowsPerPage) // For if there have been clicks that have increased the number of rows
-      LastRow = FirstRow + Gbl.Stat.RowsPerPage - 1;
+   FirstRow = (LastRow >= NumClicks) ? LastRow - NumClicks + 1 :
+				       1;
+
+   /***** Get clicks in the page to show *****/
+   if ((Clicks = (struct Sta_DetailedClick *) malloc (NumClicks * sizeof (struct Sta_DetailedClick))) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   Sta_GetDetailedClicksInPage (FromWhere,MinLogCod,MaxLogCod,Clicks,NumClicks);
+
+   /***** Initialize estructura of data of the user *****/
+   Usr_UsrDataConstructor (&UsrDat);
 
    /***** Compute the number total of pages *****/
    /* Number of pages before the current one */
@@ -1506,8 +1867,7 @@ static void Sta_ShowDetailedAccessesList (unsigned long NumRows,MYSQL_RES *mysql
       Dat_WriteParamsIniEndDates ();
       Par_PutHiddenParamUnsigned (NULL,"GroupedBy",(unsigned) Sta_CLICKS_CRS_DETAILED_LIST);
       Par_PutHiddenParamUnsigned (NULL,"StatAct"  ,(unsigned) Gbl.Stat.NumAction);
-      Par_PutHiddenParamLong (NULL,"FirstRow",FirstRow - Gbl.Stat.RowsPerPage);
-      Par_PutHiddenParamLong (NULL,"LastRow" ,FirstRow - 1);
+      Par_PutHiddenParamLong (NULL,"OlderThan",MinLogCod);
       Par_PutHiddenParamUnsigned (NULL,"RowsPage",Gbl.Stat.RowsPerPage);
       Usr_PutHiddenParSelectedUsrsCods (&Gbl.Usrs.Selected);
      }
@@ -1544,8 +1904,7 @@ static void Sta_ShowDetailedAccessesList (unsigned long NumRows,MYSQL_RES *mysql
       Dat_WriteParamsIniEndDates ();
       Par_PutHiddenParamUnsigned (NULL,"GroupedBy",(unsigned) Sta_CLICKS_CRS_DETAILED_LIST);
       Par_PutHiddenParamUnsigned (NULL,"StatAct"  ,(unsigned) Gbl.Stat.NumAction);
-      Par_PutHiddenParamUnsigned (NULL,"FirstRow" ,(unsigned) (LastRow + 1));
-      Par_PutHiddenParamUnsigned (NULL,"LastRow"  ,(unsigned) (LastRow + Gbl.Stat.RowsPerPage));
+      Par_PutHiddenParamLong (NULL,"NewerThan",MaxLogCod);
       Par_PutHiddenParamUnsigned (NULL,"RowsPage" ,(unsigned) Gbl.Stat.RowsPerPage);
       Usr_PutHiddenParSelectedUsrsCods (&Gbl.Usrs.Selected);
      }
@@ -1583,24 +1942,17 @@ static void Sta_ShowDetailedAccessesList (unsigned long NumRows,MYSQL_RES *mysql
 
    HTM_TR_End ();
 
-   /***** Write rows back *****/
-   for (NumRow = LastRow, UniqueId = 1, Gbl.RowEvenOdd = 0;
-	NumRow >= FirstRow;
-	NumRow--, UniqueId++, Gbl.RowEvenOdd = 1 - Gbl.RowEvenOdd)
+   /***** Write rows back (clicks are ordered from newest to oldest) *****/
+   for (NumClick = 0, NumRow = LastRow, UniqueId = 1, Gbl.RowEvenOdd = 0;
+	NumClick < NumClicks;
+	NumClick++, NumRow--, UniqueId++, Gbl.RowEvenOdd = 1 - Gbl.RowEvenOdd)
      {
-      mysql_data_seek (mysql_res,(my_ulonglong) (NumRow - 1));
-      row = mysql_fetch_row (mysql_res);
-
-      /* Get log code */
-      LogCod = Str_ConvertStrCodToLongCod (row[0]);
-
       /* Get user's data of the database */
-      UsrDat.UsrCod = Str_ConvertStrCodToLongCod (row[1]);
+      UsrDat.UsrCod = Clicks[NumClick].UsrCod;
       Usr_ChkUsrCodAndGetAllUsrDataFromUsrCod (&UsrDat,Usr_DONT_GET_PREFS);
 
       /* Get logged role */
-      if (sscanf (row[2],"%u",&RoleFromLog) != 1)
-	 Rol_WrongRoleExit ();
+      RoleFromLog = (Rol_Role_t) Clicks[NumClick].Role;
 
       HTM_TR_Begin (NULL);
 
@@ -1626,29 +1978,28 @@ static void Sta_ShowDetailedAccessesList (unsigned long NumRows,MYSQL_RES *mysql
 		                                         "?");
       HTM_TD_End ();
 
-      /* Write the date-time (row[3]) */
+      /* Write the date-time */
       if (asprintf (&Id,"log_date_%u",UniqueId) < 0)
 	 Lay_NotEnoughMemoryExit ();
       HTM_TD_Begin ("id=\"%s\" class=\"LOG RT COLOR%u\"",Id,Gbl.RowEvenOdd);
-      Dat_WriteLocalDateHMSFromUTC (Id,Dat_GetUNIXTimeFromStr (row[3]),
+      Dat_WriteLocalDateHMSFromUTC (Id,Clicks[NumClick].ClickTime,
 				    Gbl.Prefs.DateFormat,Dat_SEPARATOR_COMMA,
 				    true,true,false,0x7);
       HTM_TD_End ();
       free (Id);
 
       /* Write the action */
-      if (sscanf (row[4],"%ld",&ActCod) != 1)
-	 Lay_ShowErrorAndExit ("Wrong action code.");
       HTM_TD_Begin ("class=\"LOG LT COLOR%u\"",Gbl.RowEvenOdd);
-      if (ActCod >= 0)
-         HTM_TxtF ("%s&nbsp;",Act_GetActionText (Act_FromActCodToAction[ActCod]));
+      if (Clicks[NumClick].ActCod >= 0 &&
+	  Clicks[NumClick].ActCod <= Act_MAX_ACTION_COD)
+         HTM_TxtF ("%s&nbsp;",Act_GetActionText (Act_FromActCodToAction[Clicks[NumClick].ActCod]));
       else
          HTM_TxtF ("?&nbsp;");
       HTM_TD_End ();
 
       /* Write the comments of the access */
       HTM_TD_Begin ("class=\"LOG LT COLOR%u\"",Gbl.RowEvenOdd);
-      Sta_WriteLogComments (LogCod);
+      Sta_WriteLogComments (Clicks[NumClick].LogCod);
       HTM_TD_End ();
 
       HTM_TR_End ();
@@ -1656,8 +2007,134 @@ static void Sta_ShowDetailedAccessesList (unsigned long NumRows,MYSQL_RES *mysql
 
    /***** Free memory used by the data of the user *****/
    Usr_UsrDataDestructor (&UsrDat);
+
+   /***** Free memory used by the clicks *****/
+   free (Clicks);
+  }
+
+/*****************************************************************************/
+/************* Get range of log codes in a page of detailed clicks ***********/
+/*****************************************************************************/
+// Return the number of clicks in the page
+
+static unsigned Sta_GetRangeOfLogCodsInPage (const char *FromWhere,
+                                             long *MinLogCod,long *MaxLogCod)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   char SubQueryPage[64];
+   unsigned NumClicks = 0;
+
+   *MinLogCod = *MaxLogCod = -1L;
+
+   /***** Page with clicks older/newer than a given one, or newest clicks *****/
+   if (Gbl.Stat.OlderThanLogCod > 0)
+      sprintf (SubQueryPage," AND LogCod<%ld ORDER BY LogCod DESC",
+	       Gbl.Stat.OlderThanLogCod);
+   else if (Gbl.Stat.NewerThanLogCod > 0)
+      sprintf (SubQueryPage," AND LogCod>%ld ORDER BY LogCod",
+	       Gbl.Stat.NewerThanLogCod);
+   else
+      Str_Copy (SubQueryPage," ORDER BY LogCod DESC",
+                sizeof (SubQueryPage) - 1);
+
+   /***** Get range of log codes in page.
+	  Only log codes are read, using the index *****/
+   if (DB_QuerySELECT (&mysql_res,"can not get clicks",
+		       "SELECT MIN(LogCod),"	// row[0]
+			      "MAX(LogCod),"	// row[1]
+			      "COUNT(*)"	// row[2]
+		       " FROM (SELECT SQL_NO_CACHE LogCod%s%s LIMIT %u) AS page",
+		       FromWhere,SubQueryPage,Gbl.Stat.RowsPerPage))
+     {
+      row = mysql_fetch_row (mysql_res);
+      if (sscanf (row[2],"%u",&NumClicks) == 1)
+	 if (NumClicks)
+	   {
+	    *MinLogCod = Str_ConvertStrCodToLongCod (row[0]);
+	    *MaxLogCod = Str_ConvertStrCodToLongCod (row[1]);
+	   }
+     }
+   DB_FreeMySQLResult (&mysql_res);
+
+   /***** If the page is empty (clicks removed from recent log),
+          show the newest clicks *****/
+   if (!NumClicks &&
+       (Gbl.Stat.OlderThanLogCod > 0 ||
+        Gbl.Stat.NewerThanLogCod > 0))
+     {
+      Gbl.Stat.OlderThanLogCod =
+      Gbl.Stat.NewerThanLogCod = -1L;
+      return Sta_GetRangeOfLogCodsInPage (FromWhere,MinLogCod,MaxLogCod);
+     }
+
+   return NumClicks;
+  }
+
+/*****************************************************************************/
+/************** Get the clicks in a page, from newest to oldest **************/
+/*****************************************************************************/
+// The result is not stored by the client library, but read row by row
+
+static void Sta_GetDetailedClicksInPage (const char *FromWhere,
+                                         long MinLogCod,long MaxLogCod,
+                                         struct Sta_DetailedClick *Clicks,
+                                         unsigned MaxClicks)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned NumClick;
+
+   /***** Get clicks in range of log codes *****/
+   DB_QuerySELECTstreaming (&mysql_res,"can not get clicks",
+			    "SELECT SQL_NO_CACHE LogCod,"			// row[0]
+						"UsrCod,"			// row[1]
+						"Role,"				// row[2]
+						"UNIX_TIMESTAMP(ClickTime),"	// row[3]
+						"ActCod"			// row[4]
+			    "%s AND LogCod BETWEEN %ld AND %ld"
+			    " ORDER BY LogCod DESC",
+			    FromWhere,MinLogCod,MaxLogCod);
+
+   /***** Read clicks *****/
+   for (NumClick = 0;
+	(row = mysql_fetch_row (mysql_res)) != NULL;
+	NumClick++)
+      if (NumClick < MaxClicks)	// Clicks inserted after getting the range are ignored
+	{
+	 /* Get log code (row[0]) and user's code (row[1]) */
+	 Clicks[NumClick].LogCod = Str_ConvertStrCodToLongCod (row[0]);
+	 Clicks[NumClick].UsrCod = Str_ConvertStrCodToLongCod (row[1]);
+
+	 /* Get logged role (row[2]) */
+	 if (sscanf (row[2],"%u",&Clicks[NumClick].Role) != 1)
+	    Rol_WrongRoleExit ();
+
+	 /* Get date-time (row[3]) */
+	 Clicks[NumClick].ClickTime = Dat_GetUNIXTimeFromStr (row[3]);
+
+	 /* Get action code (row[4]) */
+	 if (sscanf (row[4],"%ld",&Clicks[NumClick].ActCod) != 1)
+	    Lay_ShowErrorAndExit ("Wrong action code.");
+	}
+
+   /***** Free structure that stores the query result *****/
+   DB_FreeMySQLResult (&mysql_res);
+
+   /***** Clicks not got are shown empty *****/
+   for (;
+	NumClick < MaxClicks;
+	NumClick++)
+     {
+      Clicks[NumClick].LogCod    = -1L;
+      Clicks[NumClick].UsrCod    = -1L;
+      Clicks[NumClick].Role      = (unsigned) Rol_UNK;
+      Clicks[NumClick].ClickTime = (time_t) 0;
+      Clicks[NumClick].ActCod    = -1L;
+     }
   }
 
+
 /*****************************************************************************/
 /******** Show a listing of with the number of clicks of each user ***********/
 /*****************************************************************************/
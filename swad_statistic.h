@@ -138,6 +138,7 @@ void Sta_PutLinkToGlobalHits (void);
 void Sta_SetIniEndDates (void);
 void Sta_SeeGblAccesses (void);
 void Sta_SeeCrsAccesses (void);
+void Sta_RollUpHits (void);
 
 void Sta_ComputeMaxAndTotalHits (struct Sta_Hits *Hits,
                                  unsigned long NumRows,
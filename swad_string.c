@@ -1947,7 +1947,6 @@ bool Str_WriteUntilStrFoundInFileIncludingStr (FILE *FileTgt,FILE *FileSrc,const
 static int Str_ReadCharAndSkipComments (FILE *FileSrc,Str_SkipHTMLComments_t SkipHTMLComments)
   {
    int Ch;
-   char StrAux[1 + 1];  /* To check "!--" string */
 
    Ch = fgetc (FileSrc);
 
@@ -1955,17 +1954,17 @@ static int Str_ReadCharAndSkipComments (FILE *FileSrc,Str_SkipHTMLComments_t Ski
       while (Ch == (int) '<')
         {
          /***** Check if "<!--" *****/
-         if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"!"))
+         if (fgetc (FileSrc) != (int) '!')
            {
             Str_FindStrInFileBack (FileSrc,"<",Str_NO_SKIP_HTML_COMMENTS);	// Not a comment. Return to start of directive
             return fgetc (FileSrc);
            }
-         if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"-"))
+         if (fgetc (FileSrc) != (int) '-')
            {
             Str_FindStrInFileBack (FileSrc,"<",Str_NO_SKIP_HTML_COMMENTS);	// Not a comment. Return to start of directive
             return fgetc (FileSrc);
            }
-         if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"-"))
+         if (fgetc (FileSrc) != (int) '-')
            {
             Str_FindStrInFileBack (FileSrc,"<",Str_NO_SKIP_HTML_COMMENTS);	// Not a comment. Return to start of directive
             return fgetc (FileSrc);
@@ -1990,7 +1989,6 @@ static int Str_ReadCharAndSkipComments (FILE *FileSrc,Str_SkipHTMLComments_t Ski
 static int Str_ReadCharAndSkipCommentsWriting (FILE *FileSrc,FILE *FileTgt,Str_SkipHTMLComments_t SkipHTMLComments)
   {
    int Ch;
-   char StrAux[1 + 1];  /* To check "!--" string */
 
    Ch = fgetc (FileSrc);
 
@@ -1998,17 +1996,17 @@ static int Str_ReadCharAndSkipCommentsWriting (FILE *FileSrc,FILE *FileTgt,Str_S
       while (Ch == (int) '<')
         {
          /***** Check if "<!--" *****/
-         if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"!"))
+         if (fgetc (FileSrc) != (int) '!')
            {
             Str_FindStrInFileBack (FileSrc,"<",Str_NO_SKIP_HTML_COMMENTS);	// Not a comment. Return to start of directive
             return fgetc (FileSrc);
            }
-         if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"-"))
+         if (fgetc (FileSrc) != (int) '-')
            {
             Str_FindStrInFileBack (FileSrc,"<",Str_NO_SKIP_HTML_COMMENTS);	// Not a comment. Return to start of directive
             return fgetc (FileSrc);
            }
-         if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"-"))
+         if (fgetc (FileSrc) != (int) '-')
            {
             Str_FindStrInFileBack (FileSrc,"<",Str_NO_SKIP_HTML_COMMENTS);	// Not a comment. Return to start of directive
             return fgetc (FileSrc);
@@ -2034,7 +2032,7 @@ static int Str_ReadCharAndSkipCommentsWriting (FILE *FileSrc,FILE *FileTgt,Str_S
 static int Str_ReadCharAndSkipCommentsBackward (FILE *FileSrc,Str_SkipHTMLComments_t SkipHTMLComments)
   {
    int Ch;
-   char StrAux[3 + 1];  /* To check "--" string */
+   char StrAux[3];  /* To check "-->" string */
 
    Ch = fgetc (FileSrc);
 
@@ -2049,7 +2047,8 @@ static int Str_ReadCharAndSkipCommentsBackward (FILE *FileSrc,Str_SkipHTMLCommen
 
          // Now: "<!--example of comment-->..."
          //                             ^
-         if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,3),"-->"))	// Not a comment
+         if (fread (StrAux,sizeof (StrAux[0]),3,FileSrc) != 3 ||
+             strncmp (StrAux,"-->",3))	// Not a comment
             return '>';
 
          /***** It's a comment end *****/
@@ -2080,7 +2079,6 @@ char *Str_GetCellFromHTMLTableSkipComments (FILE *FileSrc,char *Str,int MaxLengt
    bool EndCellFound = false;
    bool DirectiveFound;
    bool SpaceFound;
-   char StrAux[1 + 1];  // To find next "/td>" or "nbsp;"
 
    Str[0] = '\0';
 
@@ -2116,10 +2114,10 @@ char *Str_GetCellFromHTMLTableSkipComments (FILE *FileSrc,char *Str,int MaxLengt
       if (DirectiveFound)		// Start of directive, not a comment
 	{
 	 /* Check if it's </td> */
-	 if (!strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"/"))		// It's </
-	    if (!strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"t"))		// It's </t
-	       if (!strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"d"))	// It's </td
-		  if (!strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),">"))	// It's </td>
+	 if (fgetc (FileSrc) == (int) '/')		// It's </
+	    if (tolower (fgetc (FileSrc)) == (int) 't')		// It's </t
+	       if (tolower (fgetc (FileSrc)) == (int) 'd')	// It's </td
+		  if (fgetc (FileSrc) == (int) '>')	// It's </td>
 	             EndCellFound = true;	// </td> found
 
 	 if (!EndCellFound)
@@ -2142,27 +2140,27 @@ char *Str_GetCellFromHTMLTableSkipComments (FILE *FileSrc,char *Str,int MaxLengt
 	    if (Ch == (int) '&')
 	      {
 	       /* Check for &nbsp; (case insensitive) */
-	       if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"n"))
+	       if (tolower (fgetc (FileSrc)) != (int) 'n')
 		 {	// It's not &n
 		  Str_FindStrInFileBack (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);	// Back until &
 		  Str_FindStrInFile (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);		// Skip &
 		 }
-	       else if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"b"))
+	       else if (tolower (fgetc (FileSrc)) != (int) 'b')
 		 {	// It's not &nb
 		  Str_FindStrInFileBack (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);	// Back until &
 		  Str_FindStrInFile (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);		// Skip &
 		 }
-	       else if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"s"))
+	       else if (tolower (fgetc (FileSrc)) != (int) 's')
 		 {	// It's not &nbs
 		  Str_FindStrInFileBack (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);	// Back until &
 		  Str_FindStrInFile (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);		// Skip &
 		 }
-	       else if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),"p"))
+	       else if (tolower (fgetc (FileSrc)) != (int) 'p')
 		 {	// It's not &nbsp
 		  Str_FindStrInFileBack (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);	// Back until &
 		  Str_FindStrInFile (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);		// Skip &
 		 }
-	       else if (strcasecmp (Str_GetNextStrFromFileConvertingToLower (FileSrc,StrAux,1),";"))
+	       else if (fgetc (FileSrc) != (int) ';')
 		 {	// It's not &nbsp;
 		  Str_FindStrInFileBack (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);	// Back until &
 		  Str_FindStrInFile (FileSrc,"&",Str_NO_SKIP_HTML_COMMENTS);		// Skip &
@@ -2189,30 +2187,6 @@ char *Str_GetCellFromHTMLTableSkipComments (FILE *FileSrc,char *Str,int MaxLengt
    return Str;
   }
 
-/*****************************************************************************/
-/******************* Read the next N characters in a string ******************/
-/*****************************************************************************/
-/*
-Read from the file FileSrc the next N characters converting them
-to lowercase and store them in Str. Return a pointer to the string.
-*/
-
-char *Str_GetNextStrFromFileConvertingToLower (FILE *FileSrc,char *Str, int N)
-  {
-   int i,Ch;
-
-   for (i = 0;
-	i < N;
-	i++)
-     {
-      if ((Ch = fgetc (FileSrc)) == EOF)
-	 break;
-      Str[i] = Str_ConvertToLowerLetter ((char) Ch);
-     }
-   Str[i] = '\0';
-   return Str;
-  }
-
 /*****************************************************************************/
 /********** Get from StrSrc into StrDst the next string until space **********/
 /*****************************************************************************/
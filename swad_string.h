@@ -109,7 +109,6 @@ bool Str_FindStrInFile (FILE *FileSrc,const char *Str,Str_SkipHTMLComments_t Ski
 bool Str_FindStrInFileBack (FILE *FileSrc,const char *Str,Str_SkipHTMLComments_t SkipHTMLComments);
 bool Str_WriteUntilStrFoundInFileIncludingStr (FILE *FileTgt,FILE *FileSrc,const char *Str,Str_SkipHTMLComments_t SkipHTMLComments);
 char *Str_GetCellFromHTMLTableSkipComments (FILE *FileSrc,char *Str,int MaxLength);
-char *Str_GetNextStrFromFileConvertingToLower (FILE *FileSrc,char *Str, int N);
 void Str_GetNextStringUntilSpace (const char **StrSrc,char *StrDst,size_t MaxLength);
 void Str_GetNextStringUntilSeparator (const char **StrSrc,char *StrDst,size_t MaxLength);
 void Str_GetNextStringUntilComma (const char **StrSrc,char *StrDst,size_t MaxLength);
@@ -403,7 +403,7 @@ void TsI_ImportQstsFromXML (void)
    /***** Creates directory if not exists *****/
    Fil_CreateDirIfNotExists (Cfg_PATH_TEST_PRIVATE);
 
-   /***** First of all, copy in disk the file received from stdin (really from Gbl.F.Tmp) *****/
+   /***** First of all, copy in disk the file received from stdin (really from a temporary file) *****/
    Param = Fil_StartReceptionOfFile (Fil_NAME_OF_PARAM_FILENAME_ORG,
                                      FileNameXMLSrc,MIMEType);
 
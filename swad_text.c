@@ -291,6 +291,45 @@ const char *Txt_A_message_has_been_sent_to_email_address_X_to_confirm_that_addre
 	" para confirmar esse endere&ccedil;o.";
 #endif
 
+const char *Txt_A_message_will_be_sent_to_email_address_X_to_confirm_that_address =	// Warning: it is very important to include %s in the following sentences
+#if   L==1	// ca
+	"En unos minutos se enviar&aacute; un mensaje"
+	" a la direcci&oacute;n de correo <strong>%s</strong>"
+	" para confirmar dicha direcci&oacute;n.";	// Necessita traduccio
+#elif L==2	// de
+	"In a few minutes a message will be sent"
+	" to email address <strong>%s</strong>"
+	" to confirm that address.";			// Need bersetzung
+#elif L==3	// en
+	"In a few minutes a message will be sent"
+	" to email address <strong>%s</strong>"
+	" to confirm that address.";
+#elif L==4	// es
+	"En unos minutos se enviar&aacute; un mensaje"
+	" a la direcci&oacute;n de correo <strong>%s</strong>"
+	" para confirmar dicha direcci&oacute;n.";
+#elif L==5	// fr
+	"In a few minutes a message will be sent"
+	" to email address <strong>%s</strong>"
+	" to confirm that address.";			// Besoin de traduction
+#elif L==6	// gn
+	"En unos minutos se enviar&aacute; un mensaje"
+	" a la direcci&oacute;n de correo <strong>%s</strong>"
+	" para confirmar dicha direcci&oacute;n.";	// Okoteve traduccin
+#elif L==7	// it
+	"In a few minutes a message will be sent"
+	" to email address <strong>%s</strong>"
+	" to confirm that address.";			// Bisogno di traduzione
+#elif L==8	// pl
+	"In a few minutes a message will be sent"
+	" to email address <strong>%s</strong>"
+	" to confirm that address.";			// Potrzebujesz tlumaczenie
+#elif L==9	// pt
+	"In a few minutes a message will be sent"
+	" to email address <strong>%s</strong>"
+	" to confirm that address.";
+#endif
+
 const char *Txt_A_student_can_belong_to_several_groups =
 #if   L==1	// ca
 	"Un estudiant pot pert&agrave;nyer a diversos grups";
@@ -34,6 +34,7 @@
 
 #include "swad_announcement.h"
 #include "swad_box.h"
+#include "swad_config.h"
 #include "swad_constant.h"
 #include "swad_database.h"
 #include "swad_exam.h"
@@ -191,6 +192,21 @@ typedef enum
    TL_SHOW_ALL_USRS,	// Show all favers/sharers
   } TL_HowMany_t;
 
+#define TL_PUBS_PER_NOTE_IN_BATCH	4	// Publications got from database in a batch for each note to get
+
+struct TL_NotCodSet	// Set of note codes, implemented as a hash table
+  {
+   long *NotCods;	// 0 ==> empty slot (note codes are > 0)
+   size_t Size;		// Power of 2
+  };
+
+struct TL_PubCodList	// Publications got to be shown, from newest to oldest
+  {
+   long *PubCods;
+   long *NotCods;
+   unsigned Num;
+  };
+
 /*****************************************************************************/
 /************** External global variables from others modules ****************/
 /*****************************************************************************/
@@ -213,10 +229,19 @@ static void TL_GetAndShowOldTimeline (TL_TimelineUsrOrGbl_t TimelineUsrOrGbl);
 static void TL_BuildQueryToGetTimeline (char **Query,
                                         TL_TimelineUsrOrGbl_t TimelineUsrOrGbl,
                                         TL_WhatToGetFromTimeline_t WhatToGetFromTimeline);
+static void TL_GetPubsInTimeline (struct TL_PubCodList *Pubs,
+                                  TL_TimelineUsrOrGbl_t TimelineUsrOrGbl,
+                                  TL_WhatToGetFromTimeline_t WhatToGetFromTimeline);
+static void TL_BuildSubQueryRangePubs (char SubQuery[128],const char *Table,
+                                       long Bottom,long Top);
+static void TL_AddCurrentTimelineToSetOfNotes (struct TL_NotCodSet *Set);
+static void TL_CreateSetOfNotes (struct TL_NotCodSet *Set,size_t MinSize);
+static bool TL_AddNoteToSet (struct TL_NotCodSet *Set,long NotCod);
+static void TL_FreeSetOfNotes (struct TL_NotCodSet *Set);
+static char *TL_BuildListOfCodes (const long *Cods,unsigned NumCods);
 static long TL_GetPubCodFromSession (const char *FieldName);
 static void TL_UpdateLastPubCodIntoSession (void);
 static void TL_UpdateFirstPubCodIntoSession (long FirstPubCod);
-static void TL_DropTemporaryTablesUsedToQueryTimeline (void);
 
 static void TL_ShowTimeline (char *Query,
                              const char *Title,long NotCodToHighlight);
@@ -255,6 +280,9 @@ static void TL_GetNoteSummary (const struct TL_Note *SocNot,
                                char SummaryStr[Ntf_MAX_BYTES_SUMMARY + 1]);
 static void TL_PublishNoteInTimeline (struct TL_Publication *SocPub);
 
+static void TL_PushPubToInboxes (const struct TL_Publication *SocPub);
+static bool TL_CheckIfPubsOfUsrArePulled (long UsrCod);
+
 static void TL_PutFormToWriteNewPost (void);
 static void TL_PutTextarea (const char *Placeholder,const char *ClassTextArea);
 
@@ -375,7 +403,7 @@ static void TL_ResetNote (struct TL_Note *SocNot);
 static void TL_ResetComment (struct TL_Comment *SocCom);
 
 static void TL_ClearTimelineThisSession (void);
-static void TL_AddNotesJustRetrievedToTimelineThisSession (void);
+static void TL_AddNotesJustRetrievedToTimelineThisSession (const struct TL_PubCodList *Pubs);
 
 static void Str_AnalyzeTxtAndStoreNotifyEventToMentionedUsrs (long PubCod,const char *Txt);
 
@@ -483,8 +511,8 @@ static void TL_ShowTimelineGblHighlightingNot (long NotCod)
    /***** Show timeline *****/
    TL_ShowTimeline (Query,Txt_Timeline,NotCod);
 
-   /***** Drop temporary tables *****/
-   TL_DropTemporaryTablesUsedToQueryTimeline ();
+   /***** Free query *****/
+   free (Query);
   }
 
 /*****************************************************************************/
@@ -512,8 +540,8 @@ static void TL_ShowTimelineUsrHighlightingNot (long NotCod)
 		    NotCod);
    Str_FreeString ();
 
-   /***** Drop temporary tables *****/
-   TL_DropTemporaryTablesUsedToQueryTimeline ();
+   /***** Free query *****/
+   free (Query);
   }
 
 /*****************************************************************************/
@@ -537,8 +565,8 @@ void TL_RefreshNewTimelineGbl (void)
       /***** Show new timeline *****/
       TL_InsertNewPubsInTimeline (Query);
 
-      /***** Drop temporary tables *****/
-      TL_DropTemporaryTablesUsedToQueryTimeline ();
+      /***** Free query *****/
+      free (Query);
      }
   }
 
@@ -579,8 +607,8 @@ static void TL_GetAndShowOldTimeline (TL_TimelineUsrOrGbl_t TimelineUsrOrGbl)
    /***** Show old timeline *****/
    TL_ShowOldPubsInTimeline (Query);
 
-   /***** Drop temporary tables *****/
-   TL_DropTemporaryTablesUsedToQueryTimeline ();
+   /***** Free query *****/
+   free (Query);
   }
 
 /*****************************************************************************/
@@ -600,85 +628,152 @@ void TL_MarkMyNotifAsSeen (void)
 /************************ Build query to get timeline ************************/
 /*****************************************************************************/
 
-#define TL_MAX_BYTES_SUBQUERY_ALREADY_EXISTS (256 - 1)
-
 static void TL_BuildQueryToGetTimeline (char **Query,
                                         TL_TimelineUsrOrGbl_t TimelineUsrOrGbl,
                                         TL_WhatToGetFromTimeline_t WhatToGetFromTimeline)
   {
+   struct TL_PubCodList Pubs;
+   char *PubCodsList;
+
+   /***** Clear timeline for this session in database *****/
+   if (WhatToGetFromTimeline == TL_GET_RECENT_TIMELINE)
+      TL_ClearTimelineThisSession ();
+
+   /***** Get the publications to show *****/
+   TL_GetPubsInTimeline (&Pubs,TimelineUsrOrGbl,WhatToGetFromTimeline);
+
+   /***** Update last publication code into session for next refresh *****/
+   // Do this inmediately after getting the publications codes...
+   // ...in order to not lose publications
+   TL_UpdateLastPubCodIntoSession ();
+
+   /***** Add notes just retrieved to current timeline for this session *****/
+   TL_AddNotesJustRetrievedToTimelineThisSession (&Pubs);
+
+   /***** Build query to show timeline *****/
+   if (Pubs.Num)
+     {
+      PubCodsList = TL_BuildListOfCodes (Pubs.PubCods,Pubs.Num);
+      DB_BuildQuery (Query,
+		     "SELECT PubCod,"			// row[0]
+			    "NotCod,"			// row[1]
+			    "PublisherCod,"		// row[2]
+			    "PubType,"			// row[3]
+			    "UNIX_TIMESTAMP(TimePublish)"	// row[4]
+		     " FROM tl_pubs"
+		     " WHERE PubCod IN (%s)"
+		     " ORDER BY PubCod DESC",
+		     PubCodsList);
+      free (PubCodsList);
+     }
+   else
+      DB_BuildQuery (Query,
+		     "SELECT PubCod,"			// row[0]
+			    "NotCod,"			// row[1]
+			    "PublisherCod,"		// row[2]
+			    "PubType,"			// row[3]
+			    "UNIX_TIMESTAMP(TimePublish)"	// row[4]
+		     " FROM tl_pubs"
+		     " WHERE FALSE");
+
+   /***** Free list of publications *****/
+   free (Pubs.PubCods);
+   free (Pubs.NotCods);
+  }
+
+/*****************************************************************************/
+/*************** Get the codes of publications to show in timeline ***********/
+/*****************************************************************************/
+/*
+   We want the more recent publication (original, shared or commment)
+   of every set of publications corresponding to the same note,
+   skipping notes already got.
+
+   Getting the maximum PubCod of every note with
+   "SELECT MAX(PubCod) AS NewestPubCod FROM tl_pubs ...
+   " GROUP BY NotCod ORDER BY NewestPubCod DESC LIMIT ..."
+   is slow (several seconds) with a big table,
+   and getting the publications one by one needs a query for each one.
+
+   So the publications are got from newest to oldest in batches,
+   using the primary key, and the repeated notes are skipped here.
+   Usually a single batch is enough.
+
+              tl_pubs
+               _____
+              |_____|11
+              |_____|10
+             _|_____| 9 <-- RangePubsToGet.Top
+     Get    / |_____| 8
+    pubs   |  |_____| 7
+    from  <   |_____| 6
+    this   |  |_____| 5
+   range    \_|_____| 4
+              |_____| 3 <-- RangePubsToGet.Bottom
+              |_____| 2
+              |_____| 1
+                      0
+*/
+
+static void TL_GetPubsInTimeline (struct TL_PubCodList *Pubs,
+                                  TL_TimelineUsrOrGbl_t TimelineUsrOrGbl,
+                                  TL_WhatToGetFromTimeline_t WhatToGetFromTimeline)
+  {
+   static const unsigned MaxPubsToGet[TL_NUM_WHAT_TO_GET_FROM_TIMELINE] =
+     {
+      [TL_GET_ONLY_NEW_PUBS  ] = TL_MAX_NEW_PUBS_TO_GET_AND_SHOW,
+      [TL_GET_RECENT_TIMELINE] = TL_MAX_REC_PUBS_TO_GET_AND_SHOW,
+      [TL_GET_ONLY_OLD_PUBS  ] = TL_MAX_OLD_PUBS_TO_GET_AND_SHOW,
+     };
+   unsigned MaxPubs = MaxPubsToGet[WhatToGetFromTimeline];
+   unsigned long NumPubsInBatch = (unsigned long) MaxPubs * TL_PUBS_PER_NOTE_IN_BATCH;
+   bool ReadFromInbox = Cfg_TIMELINE_FAN_OUT_ON_WRITE &&
+			TimelineUsrOrGbl == TL_TIMELINE_GBL &&
+			Gbl.Timeline.Who == Usr_WHO_FOLLOWED;
    char SubQueryPublishers[128];
-   char SubQueryRangeBottom[128];
-   char SubQueryRangeTop[128];
-   char SubQueryAlreadyExists[TL_MAX_BYTES_SUBQUERY_ALREADY_EXISTS + 1];
+   char SubQueryRangePubs[128];
+   char SubQueryRangeInbox[128];
    struct
      {
       long Top;
       long Bottom;
      } RangePubsToGet;
+   struct TL_NotCodSet NotesToSkip;
    MYSQL_RES *mysql_res;
    MYSQL_ROW row;
-   unsigned NumPubs;
-   unsigned NumPub;
+   unsigned long NumRows;
+   unsigned long NumRow;
    long PubCod;
    long NotCod;
-   static const unsigned MaxPubsToGet[TL_NUM_WHAT_TO_GET_FROM_TIMELINE] =
-     {
-      [TL_GET_ONLY_NEW_PUBS  ] = TL_MAX_NEW_PUBS_TO_GET_AND_SHOW,
-      [TL_GET_RECENT_TIMELINE] = TL_MAX_REC_PUBS_TO_GET_AND_SHOW,
-      [TL_GET_ONLY_OLD_PUBS  ] = TL_MAX_OLD_PUBS_TO_GET_AND_SHOW,
-     };
 
-   /***** Clear timeline for this session in database *****/
-   if (WhatToGetFromTimeline == TL_GET_RECENT_TIMELINE)
-      TL_ClearTimelineThisSession ();
-
-   /***** Drop temporary tables *****/
-   TL_DropTemporaryTablesUsedToQueryTimeline ();
-
-   /***** Create temporary table with publication codes *****/
-   DB_Query ("can not create temporary table",
-	     "CREATE TEMPORARY TABLE tl_pub_codes "
-	     "(PubCod BIGINT NOT NULL,UNIQUE INDEX(PubCod)) ENGINE=MEMORY");
-
-   /***** Create temporary table with notes got in this execution *****/
-   DB_Query ("can not create temporary table",
-	     "CREATE TEMPORARY TABLE tl_not_codes "
-	     "(NotCod BIGINT NOT NULL,INDEX(NotCod)) ENGINE=MEMORY");
-
-   /***** Create temporary table with notes already present in timeline for this session *****/
-   DB_Query ("can not create temporary table",
-	     "CREATE TEMPORARY TABLE tl_current_timeline "
-	     "(NotCod BIGINT NOT NULL,INDEX(NotCod)) ENGINE=MEMORY"
-	     " SELECT NotCod FROM tl_timelines WHERE SessionId='%s'",
-	     Gbl.Session.Id);
+   /***** Allocate list of publications *****/
+   Pubs->Num = 0;
+   if ((Pubs->PubCods = (long *) malloc (MaxPubs * sizeof (long))) == NULL ||
+       (Pubs->NotCods = (long *) malloc (MaxPubs * sizeof (long))) == NULL)
+      Lay_NotEnoughMemoryExit ();
 
-   /***** Create temporary table and subquery with potential publishers *****/
+   /***** Subquery with potential publishers *****/
    switch (TimelineUsrOrGbl)
      {
       case TL_TIMELINE_USR:	// Show the timeline of a user
-	 sprintf (SubQueryPublishers,"PublisherCod=%ld AND ",
+	 sprintf (SubQueryPublishers," AND PublisherCod=%ld",
 	          Gbl.Usrs.Other.UsrDat.UsrCod);
 	 break;
       case TL_TIMELINE_GBL:	// Show the global timeline
 	 switch (Gbl.Timeline.Who)
 	   {
 	    case Usr_WHO_ME:	// Show my timeline
-	       sprintf (SubQueryPublishers,"PublisherCod=%ld AND ",
+	       sprintf (SubQueryPublishers," AND PublisherCod=%ld",
 	                Gbl.Usrs.Me.UsrDat.UsrCod);
                break;
 	    case Usr_WHO_FOLLOWED:	// Show the timeline of the users I follow
-	       DB_Query ("can not create temporary table",
-		         "CREATE TEMPORARY TABLE tl_publishers "
-			 "(UsrCod INT NOT NULL,UNIQUE INDEX(UsrCod)) ENGINE=MEMORY"
-			 " SELECT %ld AS UsrCod"
-			 " UNION"
-			 " SELECT FollowedCod AS UsrCod"
-			 " FROM usr_follow WHERE FollowerCod=%ld",
-			 Gbl.Usrs.Me.UsrDat.UsrCod,
-			 Gbl.Usrs.Me.UsrDat.UsrCod);
-
 	       sprintf (SubQueryPublishers,
-			"tl_pubs.PublisherCod=tl_publishers.UsrCod AND ");
+			" AND (PublisherCod=%ld"
+			" OR PublisherCod IN"
+			" (SELECT FollowedCod FROM usr_follow"
+			" WHERE FollowerCod=%ld))",
+			Gbl.Usrs.Me.UsrDat.UsrCod,
+			Gbl.Usrs.Me.UsrDat.UsrCod);
 	       break;
 	    case Usr_WHO_ALL:	// Show the timeline of all users
 	       SubQueryPublishers[0] = '\0';
@@ -690,65 +785,21 @@ static void TL_BuildQueryToGetTimeline (char **Query,
 	 break;
      }
 
-   /***** Create subquery to get only notes not present in timeline *****/
-   switch (TimelineUsrOrGbl)
+   /***** Notes that must not be got *****/
+   switch (WhatToGetFromTimeline)
      {
-      case TL_TIMELINE_USR:	// Show the timeline of a user
-	 switch (WhatToGetFromTimeline)
-           {
-            case TL_GET_ONLY_NEW_PUBS:
-            case TL_GET_RECENT_TIMELINE:
-	       Str_Copy (SubQueryAlreadyExists,
-	                 " NotCod NOT IN"
-			 " (SELECT NotCod FROM tl_not_codes)",
-			 TL_MAX_BYTES_SUBQUERY_ALREADY_EXISTS);
-	       break;
-            case TL_GET_ONLY_OLD_PUBS:
-	       Str_Copy (SubQueryAlreadyExists,
-	                 " NotCod NOT IN"
-			 " (SELECT NotCod FROM tl_current_timeline)",
-			 TL_MAX_BYTES_SUBQUERY_ALREADY_EXISTS);
-	       break;
-           }
+      case TL_GET_ONLY_NEW_PUBS:
+      case TL_GET_RECENT_TIMELINE:
+	 /* Only notes already got in this execution */
+	 TL_CreateSetOfNotes (&NotesToSkip,MaxPubs);
 	 break;
-      case TL_TIMELINE_GBL:	// Show the timeline of the users I follow
-	 switch (WhatToGetFromTimeline)
-           {
-            case TL_GET_ONLY_NEW_PUBS:
-            case TL_GET_RECENT_TIMELINE:
-	       Str_Copy (SubQueryAlreadyExists,
-	                 " tl_pubs.NotCod NOT IN"
-			 " (SELECT NotCod FROM tl_not_codes)",
-			 TL_MAX_BYTES_SUBQUERY_ALREADY_EXISTS);
-	       break;
-            case TL_GET_ONLY_OLD_PUBS:
-	       Str_Copy (SubQueryAlreadyExists,
-	                 " tl_pubs.NotCod NOT IN"
-			 " (SELECT NotCod FROM tl_current_timeline)",
-			 TL_MAX_BYTES_SUBQUERY_ALREADY_EXISTS);
-	       break;
-           }
+      case TL_GET_ONLY_OLD_PUBS:
+	 /* Notes already present in timeline for this session */
+	 TL_AddCurrentTimelineToSetOfNotes (&NotesToSkip);
 	 break;
      }
 
-   /***** Get the publications in timeline *****/
-   /* Initialize range of pubs:
-
-              tl_pubs
-               _____
-              |_____|11
-              |_____|10
-             _|_____| 9 <-- RangePubsToGet.Top
-     Get    / |_____| 8
-    pubs   |  |_____| 7
-    from  <   |_____| 6
-    this   |  |_____| 5
-   range    \_|_____| 4
-              |_____| 3 <-- RangePubsToGet.Bottom
-              |_____| 2
-              |_____| 1
-                      0
-   */
+   /***** Initialize range of publications *****/
    RangePubsToGet.Top    = 0;	// +Infinite
    RangePubsToGet.Bottom = 0;	// -Infinite
    switch (WhatToGetFromTimeline)
@@ -768,199 +819,192 @@ static void TL_BuildQueryToGetTimeline (char **Query,
 	 break;
      }
 
-   /*
-      With the current approach, we select one by one
-      the publications and notes in a loop. In each iteration,
-      we get the more recent publication (original, shared or commment)
-      of every set of publications corresponding to the same note,
-      checking that the note is not already retrieved.
-      After getting a publication, its note code is stored
-      in order to not get it again.
-
-      As an alternative, we tried to get the maximum PubCod,
-      i.e more recent publication (original, shared or commment),
-      of every set of publications corresponding to the same note:
-      "SELECT MAX(PubCod) AS NewestPubCod FROM tl_pubs ...
-      " GROUP BY NotCod ORDER BY NewestPubCod DESC LIMIT ..."
-      but this query is slow (several seconds) with a big table.
-   */
-
-   for (NumPub = 0;
-	NumPub < MaxPubsToGet[WhatToGetFromTimeline];
-	NumPub++)
+   /***** Get publications in batches, from newest to oldest *****/
+   do
      {
-      /* Create subqueries with range of publications to get from tl_pubs */
-      if (RangePubsToGet.Bottom > 0)
-	 switch (TimelineUsrOrGbl)
-	   {
-	    case TL_TIMELINE_USR:	// Show the timeline of a user
-	       sprintf (SubQueryRangeBottom,"PubCod>%ld AND ",
-		        RangePubsToGet.Bottom);
-	       break;
-	    case TL_TIMELINE_GBL:	// Show the global timeline
-	       switch (Gbl.Timeline.Who)
-		 {
-		  case Usr_WHO_ME:	// Show my timeline
-		  case Usr_WHO_ALL:	// Show the timeline of all users
-		     sprintf (SubQueryRangeBottom,"PubCod>%ld AND ",
-			      RangePubsToGet.Bottom);
-		     break;
-		  case Usr_WHO_FOLLOWED:// Show the timeline of the users I follow
-		     sprintf (SubQueryRangeBottom,"tl_pubs.PubCod>%ld AND ",
-			      RangePubsToGet.Bottom);
-		     break;
-		  default:
-		     Lay_ShowErrorAndExit ("Wrong parameter which users.");
-		     break;
-		 }
-	       break;
-	   }
-      else
-	 SubQueryRangeBottom[0] = '\0';
-
-      if (RangePubsToGet.Top > 0)
-	 switch (TimelineUsrOrGbl)
-	   {
-	    case TL_TIMELINE_USR:	// Show the timeline of a user
-	       sprintf (SubQueryRangeTop,"PubCod<%ld AND ",
-		        RangePubsToGet.Top);
-	       break;
-	    case TL_TIMELINE_GBL:	// Show the global timeline
-	       switch (Gbl.Timeline.Who)
-		 {
-		  case Usr_WHO_ME:	// Show my timeline
-		  case Usr_WHO_ALL:	// Show the timeline of all users
-		     sprintf (SubQueryRangeTop,"PubCod<%ld AND ",
-			      RangePubsToGet.Top);
-		     break;
-		  case Usr_WHO_FOLLOWED:// Show the timeline of the users I follow
-		     sprintf (SubQueryRangeTop,"tl_pubs.PubCod<%ld AND ",
-			      RangePubsToGet.Top);
-		     break;
-		  default:
-		     Lay_ShowErrorAndExit ("Wrong parameter which users.");
-		     break;
-		 }
-	       break;
-	   }
-      else
-	 SubQueryRangeTop[0] = '\0';
-
-      /* Select the most recent publication from tl_pubs */
-      NumPubs = 0;	// Initialized to avoid warning
-      switch (TimelineUsrOrGbl)
+      TL_BuildSubQueryRangePubs (SubQueryRangePubs,"tl_pubs",
+				 RangePubsToGet.Bottom,RangePubsToGet.Top);
+      if (ReadFromInbox)
 	{
-	 case TL_TIMELINE_USR:	// Show the timeline of a user
-	    NumPubs =
-	    (unsigned) DB_QuerySELECT (&mysql_res,"can not get publication",
-				       "SELECT PubCod,NotCod"
-				       " FROM tl_pubs"
-				       " WHERE %s%s%s%s"
-				       " ORDER BY PubCod DESC LIMIT 1",
-				       SubQueryRangeBottom,SubQueryRangeTop,
-				       SubQueryPublishers,
-				       SubQueryAlreadyExists);
-	    break;
-	 case TL_TIMELINE_GBL:	// Show the global timeline
-	    switch (Gbl.Timeline.Who)
-	      {
-	       case Usr_WHO_ME:		// Show my timeline
-		  NumPubs =
-		  (unsigned) DB_QuerySELECT (&mysql_res,"can not get publication",
-					     "SELECT PubCod,NotCod"
-					     " FROM tl_pubs"
-					     " WHERE %s%s%s%s"
-					     " ORDER BY PubCod DESC LIMIT 1",
-					     SubQueryRangeBottom,SubQueryRangeTop,
-					     SubQueryPublishers,
-					     SubQueryAlreadyExists);
-		  break;
-	       case Usr_WHO_FOLLOWED:	// Show the timeline of the users I follow
-		  NumPubs =
-		  (unsigned) DB_QuerySELECT (&mysql_res,"can not get publication",
-				             "SELECT PubCod,NotCod"
-				             " FROM tl_pubs,tl_publishers"
-					     " WHERE %s%s%s%s"
-					     " ORDER BY tl_pubs.PubCod DESC LIMIT 1",
-					     SubQueryRangeBottom,SubQueryRangeTop,
-					     SubQueryPublishers,
-					     SubQueryAlreadyExists);
-		  break;
-	       case Usr_WHO_ALL:	// Show the timeline of all users
-		  NumPubs =
-		  (unsigned) DB_QuerySELECT (&mysql_res,"can not get publication",
-				             "SELECT PubCod,NotCod"
-				             " FROM tl_pubs"
-					     " WHERE %s%s%s"
-					     " ORDER BY PubCod DESC LIMIT 1",
-					     SubQueryRangeBottom,SubQueryRangeTop,
-					     SubQueryAlreadyExists);
-		  break;
-	       default:
-		  Lay_ShowErrorAndExit ("Wrong parameter which users.");
-		  break;
-	      }
-	    break;
+	 /* Publications pushed to my inbox when they were published,
+	    and publications of users I follow
+	    with too many followers to push their publications */
+	 TL_BuildSubQueryRangePubs (SubQueryRangeInbox,"tl_inboxes",
+				    RangePubsToGet.Bottom,RangePubsToGet.Top);
+	 NumRows = DB_QuerySELECT (&mysql_res,"can not get publications",
+				   "(SELECT tl_inboxes.PubCod,"	// row[0]
+					   "tl_inboxes.NotCod"	// row[1]
+				   " FROM tl_inboxes,tl_pubs"
+				   " WHERE tl_inboxes.UsrCod=%ld%s"
+				   " AND tl_inboxes.PubCod=tl_pubs.PubCod"
+				   " ORDER BY tl_inboxes.PubCod DESC LIMIT %lu)"
+				   " UNION "
+				   "(SELECT tl_pubs.PubCod,"		// row[0]
+					   "tl_pubs.NotCod"		// row[1]
+				   " FROM tl_pubs"
+				   " WHERE tl_pubs.PublisherCod IN"
+				   " (SELECT tl_pull_publishers.UsrCod"
+				   " FROM usr_follow,tl_pull_publishers"
+				   " WHERE usr_follow.FollowerCod=%ld"
+				   " AND usr_follow.FollowedCod=tl_pull_publishers.UsrCod)%s"
+				   " ORDER BY tl_pubs.PubCod DESC LIMIT %lu)"
+				   " ORDER BY PubCod DESC LIMIT %lu",
+				   Gbl.Usrs.Me.UsrDat.UsrCod,SubQueryRangeInbox,
+				   NumPubsInBatch,
+				   Gbl.Usrs.Me.UsrDat.UsrCod,SubQueryRangePubs,
+				   NumPubsInBatch,
+				   NumPubsInBatch);
 	}
-
-      if (NumPubs == 1)
+      else
+	 NumRows = DB_QuerySELECT (&mysql_res,"can not get publications",
+				   "SELECT PubCod,"	// row[0]
+					  "NotCod"	// row[1]
+				   " FROM tl_pubs"
+				   " WHERE TRUE%s%s"
+				   " ORDER BY PubCod DESC LIMIT %lu",
+				   SubQueryRangePubs,
+				   SubQueryPublishers,
+				   NumPubsInBatch);
+
+      for (NumRow = 0;
+	   NumRow < NumRows && Pubs->Num < MaxPubs;
+	   NumRow++)
 	{
-	 /* Get code of publication */
 	 row = mysql_fetch_row (mysql_res);
 	 PubCod = Str_ConvertStrCodToLongCod (row[0]);
+	 NotCod = Str_ConvertStrCodToLongCod (row[1]);
+	 RangePubsToGet.Top = PubCod;	// Narrow the range for the next batch
+
+	 /* Add publication only if its note is not already got */
+	 if (TL_AddNoteToSet (&NotesToSkip,NotCod))
+	   {
+	    Pubs->PubCods[Pubs->Num] = PubCod;
+	    Pubs->NotCods[Pubs->Num] = NotCod;
+	    Pubs->Num++;
+	   }
 	}
-      else
-        {
-	 row = NULL;
-	 PubCod = -1L;
-        }
 
-      /* Free structure that stores the query result */
       DB_FreeMySQLResult (&mysql_res);
+     }
+   while (Pubs->Num < MaxPubs &&
+	  NumRows == NumPubsInBatch);	// There may be more publications
 
-      if (PubCod > 0)
-	{
-	 DB_QueryINSERT ("can not store publication code",
-			 "INSERT INTO tl_pub_codes SET PubCod=%ld",
-			 PubCod);
-	 RangePubsToGet.Top = PubCod;	// Narrow the range for the next iteration
+   /***** Free set of notes *****/
+   TL_FreeSetOfNotes (&NotesToSkip);
+  }
 
-	 /* Get note code (row[1]) */
-	 if (row)
-	   {
-	    NotCod = Str_ConvertStrCodToLongCod (row[1]);
-	    DB_QueryINSERT ("can not store note code",
-			    "INSERT INTO tl_not_codes SET NotCod=%ld",
-			    NotCod);
-	    DB_QueryINSERT ("can not store note code",
-			    "INSERT INTO tl_current_timeline SET NotCod=%ld",
-			    NotCod);
-	   }
-	}
-      else	// Nothing got ==> abort loop
-         break;	// Last publication
+/*****************************************************************************/
+/*********** Build subquery with range of publications to get ****************/
+/*****************************************************************************/
+// Bottom, Top == 0 ==> no limit
+
+static void TL_BuildSubQueryRangePubs (char SubQuery[128],const char *Table,
+                                       long Bottom,long Top)
+  {
+   char *Ptr = SubQuery;
+
+   SubQuery[0] = '\0';
+   if (Bottom > 0)
+      Ptr += sprintf (Ptr," AND %s.PubCod>%ld",Table,Bottom);
+   if (Top > 0)
+      sprintf (Ptr," AND %s.PubCod<%ld",Table,Top);
+  }
+
+/*****************************************************************************/
+/************ Create a set with the notes in current timeline ****************/
+/*****************************************************************************/
+
+static void TL_AddCurrentTimelineToSetOfNotes (struct TL_NotCodSet *Set)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumNotes;
+   unsigned long NumNot;
+
+   /***** Get notes in current timeline *****/
+   NumNotes = DB_QuerySELECT (&mysql_res,"can not get notes in timeline",
+			      "SELECT NotCod"
+			      " FROM tl_timelines"
+			      " WHERE SessionId='%s'",
+			      Gbl.Session.Id);
+
+   /***** Create set of notes with room for notes to get *****/
+   TL_CreateSetOfNotes (Set,NumNotes + TL_MAX_OLD_PUBS_TO_GET_AND_SHOW);
+   for (NumNot = 0;
+	NumNot < NumNotes;
+	NumNot++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      TL_AddNoteToSet (Set,Str_ConvertStrCodToLongCod (row[0]));
      }
 
-   /***** Update last publication code into session for next refresh *****/
-   // Do this inmediately after getting the publications codes...
-   // ...in order to not lose publications
-   TL_UpdateLastPubCodIntoSession ();
+   DB_FreeMySQLResult (&mysql_res);
+  }
 
-   /***** Add notes just retrieved to current timeline for this session *****/
-   TL_AddNotesJustRetrievedToTimelineThisSession ();
+/*****************************************************************************/
+/************************** Set of note codes ********************************/
+/*****************************************************************************/
+
+static void TL_CreateSetOfNotes (struct TL_NotCodSet *Set,size_t MinSize)
+  {
+   /***** Size is a power of 2, at least twice the number of elements *****/
+   for (Set->Size = 16;
+	Set->Size < MinSize * 2;
+	Set->Size *= 2);
 
-   /***** Build query to show timeline including the users I am following *****/
-   DB_BuildQuery (Query,
-	          "SELECT PubCod,"			// row[0]
-	                 "NotCod,"			// row[1]
-	                 "PublisherCod,"		// row[2]
-	                 "PubType,"			// row[3]
-	                 "UNIX_TIMESTAMP(TimePublish)"	// row[4]
-		  " FROM tl_pubs"
-		  " WHERE PubCod IN "
-		  "(SELECT PubCod"
-		  " FROM tl_pub_codes)"
-		  " ORDER BY PubCod DESC");
+   if ((Set->NotCods = (long *) calloc (Set->Size,sizeof (long))) == NULL)
+      Lay_NotEnoughMemoryExit ();
+  }
+
+// Return true if note is added, false if it was already in set
+
+static bool TL_AddNoteToSet (struct TL_NotCodSet *Set,long NotCod)
+  {
+   size_t Mask = Set->Size - 1;
+   size_t Slot;
+
+   if (NotCod <= 0)
+      return false;
+
+   for (Slot = ((size_t) NotCod * 2654435761UL) & Mask;	// Multiplicative hash
+	Set->NotCods[Slot];
+	Slot = (Slot + 1) & Mask)
+      if (Set->NotCods[Slot] == NotCod)
+	 return false;	// Already in set
+
+   Set->NotCods[Slot] = NotCod;
+   return true;
+  }
+
+static void TL_FreeSetOfNotes (struct TL_NotCodSet *Set)
+  {
+   free (Set->NotCods);
+   Set->NotCods = NULL;
+   Set->Size = 0;
+  }
+
+/*****************************************************************************/
+/************ Build a comma-separated list of codes to be used in IN *********/
+/*****************************************************************************/
+// The string returned must be freed by the caller
+
+static char *TL_BuildListOfCodes (const long *Cods,unsigned NumCods)
+  {
+   char *List;
+   size_t Length = 0;
+   unsigned NumCod;
+
+   if ((List = (char *) malloc ((size_t) NumCods * (Cns_MAX_DECIMAL_DIGITS_LONG + 1) + 1)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   List[0] = '\0';
+   for (NumCod = 0;
+	NumCod < NumCods;
+	NumCod++)
+      Length += (size_t) sprintf (&List[Length],NumCod ? ",%ld" :
+							 "%ld",
+				  Cods[NumCod]);
+
+   return List;
   }
 
 /*****************************************************************************/
@@ -1022,20 +1066,6 @@ static void TL_UpdateFirstPubCodIntoSession (long FirstPubCod)
 		   FirstPubCod,Gbl.Session.Id);
   }
 
-/*****************************************************************************/
-/*************** Drop temporary tables used to query timeline ****************/
-/*****************************************************************************/
-
-static void TL_DropTemporaryTablesUsedToQueryTimeline (void)
-  {
-   DB_Query ("can not remove temporary tables",
-	     "DROP TEMPORARY TABLE IF EXISTS "
-	     "tl_pub_codes,"
-	     "tl_not_codes,"
-	     "tl_publishers,"
-	     "tl_current_timeline");
-  }
-
 /*****************************************************************************/
 /******************************* Show timeline *******************************/
 /*****************************************************************************/
@@ -2334,10 +2364,105 @@ static void TL_PublishNoteInTimeline (struct TL_Publication *SocPub)
 				SocPub->PublisherCod,
 				(unsigned) SocPub->PubType);
 
+   /***** Push publication to the inboxes of followers *****/
+   if (Cfg_TIMELINE_FAN_OUT_ON_WRITE)
+      TL_PushPubToInboxes (SocPub);
+
    /***** Increment number of publications in user's figures *****/
    Prf_IncrementNumSocPubUsr (SocPub->PublisherCod);
   }
 
+/*****************************************************************************/
+/*************** Push a new publication to timeline inboxes ******************/
+/*****************************************************************************/
+/*
+   The publication is pushed to the inbox of the publisher and,
+   if the publisher has not too many followers, to the inboxes of followers,
+   so the timeline of the users I follow is read from my inbox.
+   Publishers with too many followers are stored in tl_pull_publishers
+   and their publications are got from tl_pubs when reading timelines.
+*/
+static void TL_PushPubToInboxes (const struct TL_Publication *SocPub)
+  {
+   /***** Push publication to publisher's inbox *****/
+   DB_QueryINSERT ("can not push publication",
+		   "INSERT IGNORE INTO tl_inboxes"
+		   " (UsrCod,PubCod,NotCod)"
+		   " VALUES"
+		   " (%ld,%ld,%ld)",
+		   SocPub->PublisherCod,SocPub->PubCod,SocPub->NotCod);
+
+   /***** Check if publications of this publisher are pulled *****/
+   if (TL_CheckIfPubsOfUsrArePulled (SocPub->PublisherCod))
+      return;
+   if (Fol_GetNumFollowers (SocPub->PublisherCod) > Cfg_TIMELINE_MAX_FOLLOWERS_TO_FAN_OUT)
+     {
+      /* From now on, publications of this publisher will be pulled */
+      DB_QueryINSERT ("can not store publisher",
+		      "INSERT IGNORE INTO tl_pull_publishers"
+		      " (UsrCod)"
+		      " VALUES"
+		      " (%ld)",
+		      SocPub->PublisherCod);
+      return;
+     }
+
+   /***** Push publication to followers' inboxes *****/
+   DB_QueryINSERT ("can not push publication",
+		   "INSERT IGNORE INTO tl_inboxes"
+		   " (UsrCod,PubCod,NotCod)"
+		   " SELECT FollowerCod,%ld,%ld"
+		   " FROM usr_follow"
+		   " WHERE FollowedCod=%ld",
+		   SocPub->PubCod,SocPub->NotCod,
+		   SocPub->PublisherCod);
+  }
+
+/*****************************************************************************/
+/******* Check if publications of a user are got when reading timeline *******/
+/*****************************************************************************/
+
+static bool TL_CheckIfPubsOfUsrArePulled (long UsrCod)
+  {
+   return (DB_QueryCOUNT ("can not check publisher",
+			  "SELECT COUNT(*) FROM tl_pull_publishers"
+			  " WHERE UsrCod=%ld",
+			  UsrCod) != 0);
+  }
+
+/*****************************************************************************/
+/***************** Update my inbox when I follow a user **********************/
+/*****************************************************************************/
+
+void TL_AddPubsOfFollowedToInbox (long FollowerCod,long FollowedCod)
+  {
+   if (Cfg_TIMELINE_FAN_OUT_ON_WRITE)
+      if (!TL_CheckIfPubsOfUsrArePulled (FollowedCod))
+	 DB_QueryINSERT ("can not push publications",
+			 "INSERT IGNORE INTO tl_inboxes"
+			 " (UsrCod,PubCod,NotCod)"
+			 " SELECT %ld,PubCod,NotCod"
+			 " FROM tl_pubs"
+			 " WHERE PublisherCod=%ld",
+			 FollowerCod,FollowedCod);
+  }
+
+/*****************************************************************************/
+/**************** Update my inbox when I unfollow a user *********************/
+/*****************************************************************************/
+
+void TL_RemovePubsOfFollowedFromInbox (long FollowerCod,long FollowedCod)
+  {
+   if (Cfg_TIMELINE_FAN_OUT_ON_WRITE)
+      DB_QueryDELETE ("can not remove publications from inbox",
+		      "DELETE FROM tl_inboxes"
+		      " USING tl_pubs,tl_inboxes"
+		      " WHERE tl_inboxes.UsrCod=%ld"
+		      " AND tl_inboxes.PubCod=tl_pubs.PubCod"
+		      " AND tl_pubs.PublisherCod=%ld",
+		      FollowerCod,FollowedCod);
+  }
+
 /*****************************************************************************/
 /********************** Form to write a new publication **********************/
 /*****************************************************************************/
@@ -4628,6 +4753,18 @@ void TL_RemoveUsrContent (long UsrCod)
 		   "DELETE FROM tl_notes"
 		   " WHERE UsrCod=%ld",
 		   UsrCod);
+
+   /***** Remove inbox of the user *****/
+   // Publications removed that are still in other inboxes
+   // are skipped when reading timelines
+   DB_QueryDELETE ("can not remove inbox",
+		   "DELETE FROM tl_inboxes"
+		   " WHERE UsrCod=%ld",
+		   UsrCod);
+   DB_QueryDELETE ("can not remove publisher",
+		   "DELETE FROM tl_pull_publishers"
+		   " WHERE UsrCod=%ld",
+		   UsrCod);
   }
 
 /*****************************************************************************/
@@ -5179,13 +5316,21 @@ static void TL_ClearTimelineThisSession (void)
 /****** Add just retrieved notes to current timeline for this session ********/
 /*****************************************************************************/
 
-static void TL_AddNotesJustRetrievedToTimelineThisSession (void)
+static void TL_AddNotesJustRetrievedToTimelineThisSession (const struct TL_PubCodList *Pubs)
   {
-   DB_QueryINSERT ("can not insert notes in timeline",
-		   "INSERT IGNORE INTO tl_timelines"
-	           " (SessionId,NotCod)"
-	           " SELECT DISTINCTROW '%s',NotCod FROM tl_not_codes",
-		   Gbl.Session.Id);
+   char *NotCodsList;
+
+   if (Pubs->Num)
+     {
+      NotCodsList = TL_BuildListOfCodes (Pubs->NotCods,Pubs->Num);
+      DB_QueryINSERT ("can not insert notes in timeline",
+		      "INSERT IGNORE INTO tl_timelines"
+		      " (SessionId,NotCod)"
+		      " SELECT '%s',NotCod FROM tl_notes"
+		      " WHERE NotCod IN (%s)",
+		      Gbl.Session.Id,NotCodsList);
+      free (NotCodsList);
+     }
   }
 
 /*****************************************************************************/
@@ -170,6 +170,9 @@ void TL_RequestRemComGbl (void);
 void TL_RemoveComUsr (void);
 void TL_RemoveComGbl (void);
 
+void TL_AddPubsOfFollowedToInbox (long FollowerCod,long FollowedCod);
+void TL_RemovePubsOfFollowedFromInbox (long FollowerCod,long FollowedCod);
+
 void TL_RemoveUsrContent (long UsrCod);
 
 void TL_ClearOldTimelinesDB (void);
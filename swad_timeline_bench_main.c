@@ -0,0 +1,726 @@
+// swad_timeline_bench_main.c: main of swad_timeline_bench, queries to get publications in timeline
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <stdbool.h>		// For boolean type
+#include <stdio.h>		// For fprintf, snprintf, sprintf
+#include <stdlib.h>		// For atoi, calloc, exit, free, malloc, strtol
+
+#include "swad_bench.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define TlB_MAX_REC_PUBS		10	// As TL_MAX_REC_PUBS_TO_GET_AND_SHOW
+#define TlB_MAX_OLD_PUBS		20	// As TL_MAX_OLD_PUBS_TO_GET_AND_SHOW
+#define TlB_PUBS_PER_NOTE_IN_BATCH	 4	// As TL_PUBS_PER_NOTE_IN_BATCH
+#define TlB_NUM_OLD_PAGES		 3	// Pages of old publications got after recent timeline
+
+#define TlB_NUM_USRS		10000	// Users who publish. I am user 1
+#define TlB_MY_USR_COD		1
+#define TlB_FOLLOWED_EVERY	50	// I follow one out of this number of users
+#define TlB_PULLED_EVERY	10	// One out of this number of users I follow has too many followers
+#define TlB_SESSION_ID		"swad_timeline_bench"
+
+#define TlB_PUBS_PER_INSERT	1000	// Rows inserted in each query when creating tables
+#define TlB_MAX_BYTES_ROW	64
+
+#define TlB_MAX_BYTES_CODS	(TlB_MAX_OLD_PUBS * (20 + 1) + 1)
+#define TlB_MAX_BYTES_NOTES	(TlB_MAX_OLD_PUBS * (sizeof (TlB_SESSION_ID) + 20 + 6) + 1)
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   TlB_ONE_BY_ONE,	// Before: a query for each publication, with temporary tables
+   TlB_IN_BATCHES,	// Now: publications in batches, repeated notes skipped in memory
+   TlB_FROM_INBOX,	// Now, with fan-out on write: batches from my inbox and pulled publishers
+  } TlB_Version_t;
+#define TlB_NUM_VERSIONS 3
+
+typedef enum
+  {
+   TlB_WHO_ALL,		// As Usr_WHO_ALL
+   TlB_WHO_FOLLOWED,	// As Usr_WHO_FOLLOWED
+  } TlB_Who_t;
+#define TlB_NUM_WHO 2
+
+typedef enum
+  {
+   TlB_GET_RECENT_TIMELINE,	// As TL_GET_RECENT_TIMELINE
+   TlB_GET_ONLY_OLD_PUBS,	// As TL_GET_ONLY_OLD_PUBS
+  } TlB_WhatToGet_t;
+#define TlB_NUM_WHAT_TO_GET 2
+
+struct TlB_NotCodSet	// As TL_NotCodSet
+  {
+   long *NotCods;	// 0 ==> empty slot (note codes are > 0)
+   size_t Size;		// Power of 2
+  };
+
+struct TlB_PubCodList	// Publications got to be shown, from newest to oldest
+  {
+   long PubCods[TlB_MAX_OLD_PUBS];
+   long NotCods[TlB_MAX_OLD_PUBS];
+   unsigned Num;
+  };
+
+/*****************************************************************************/
+/***************************** Private variables *****************************/
+/*****************************************************************************/
+
+static const unsigned TlB_MaxPubsToGet[TlB_NUM_WHAT_TO_GET] =
+  {
+   [TlB_GET_RECENT_TIMELINE] = TlB_MAX_REC_PUBS,
+   [TlB_GET_ONLY_OLD_PUBS  ] = TlB_MAX_OLD_PUBS,
+  };
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void TlB_CreateTables (unsigned long NumPubs);
+static void TlB_ShowTimelines (TlB_Version_t Version,TlB_Who_t Who,
+                               unsigned NumTimes,
+                               double Seconds[TlB_NUM_WHAT_TO_GET]);
+static void TlB_GetPubs (TlB_Version_t Version,TlB_Who_t Who,
+                         TlB_WhatToGet_t WhatToGet,
+                         long Top,struct TlB_PubCodList *Pubs);
+static void TlB_GetPubsOneByOne (TlB_Who_t Who,TlB_WhatToGet_t WhatToGet,
+                                 long Top,struct TlB_PubCodList *Pubs);
+static void TlB_GetPubsInBatches (bool ReadFromInbox,
+                                  TlB_Who_t Who,TlB_WhatToGet_t WhatToGet,
+                                  long Top,struct TlB_PubCodList *Pubs);
+static void TlB_AddCurrentTimelineToSetOfNotes (struct TlB_NotCodSet *Set);
+static void TlB_CreateSetOfNotes (struct TlB_NotCodSet *Set,size_t MinSize);
+static bool TlB_AddNoteToSet (struct TlB_NotCodSet *Set,long NotCod);
+static void TlB_FreeSetOfNotes (struct TlB_NotCodSet *Set);
+static void TlB_FetchAllRows (MYSQL_RES *mysql_res);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_timeline_bench <host> <user> <password> <database>
+                              <publications> <times>
+   A table of publications with the given number of rows is created,
+   published by many users, some of them followed by me,
+   with one out of four publications being a share or a comment
+   of a recent note.
+   The recent timeline and some pages of old publications
+   of all users and of the users I follow are got the given number of times,
+   as done by TL_BuildQueryToGetTimeline:
+   1. as before: a query for each publication, getting the most recent one
+      whose note is not in temporary tables with the notes already got,
+   2. now: batches of publications from newest to oldest,
+      skipping in memory the notes already got
+      (for the users I follow, fan-out on read),
+   3. now, only for the users I follow, with fan-out on write
+      (Cfg_TIMELINE_FAN_OUT_ON_WRITE): batches from my inbox,
+      where publications were pushed when published, joined with
+      publications of followed users with too many followers, pulled
+      from the table of publications.
+   For example, 4 million publications:
+      swad_timeline_bench localhost swad_bench password swad_bench 4000000 100
+*/
+
+int main (int argc,char *argv[])
+  {
+   static const char *TxtWhat[TlB_NUM_WHAT_TO_GET] =
+     {
+      [TlB_GET_RECENT_TIMELINE] = "Recent timeline",
+      [TlB_GET_ONLY_OLD_PUBS  ] = "Old publications",
+     };
+   static const char *TxtWho[TlB_NUM_WHO] =
+     {
+      [TlB_WHO_ALL     ] = "all users",
+      [TlB_WHO_FOLLOWED] = "followed",
+     };
+   static const char *TxtVersion[TlB_NUM_VERSIONS] =
+     {
+      [TlB_ONE_BY_ONE] = "one by one",
+      [TlB_IN_BATCHES] = "in batches",
+      [TlB_FROM_INBOX] = "from inbox",
+     };
+   static const unsigned NumPagesEachTime[TlB_NUM_WHAT_TO_GET] =
+     {
+      [TlB_GET_RECENT_TIMELINE] = 1,
+      [TlB_GET_ONLY_OLD_PUBS  ] = TlB_NUM_OLD_PAGES,
+     };
+   long NumPubs;
+   int NumTimes;
+   TlB_Who_t Who;
+   TlB_Version_t Version;
+   TlB_WhatToGet_t WhatToGet;
+   double Seconds[TlB_NUM_WHAT_TO_GET];
+   char What[128];
+
+   if (argc != 1 + Bch_NUM_ARGS_DB + 2 ||
+       (NumPubs  = strtol (argv[1 + Bch_NUM_ARGS_DB    ],NULL,10)) <= 0 ||
+       (NumTimes = atoi   (argv[1 + Bch_NUM_ARGS_DB + 1]))          <= 0)
+     {
+      fprintf (stderr,"Usage: %s " Bch_USAGE_DB
+		      " <publications> <times>\n",
+	       argv[0]);
+      return 1;
+     }
+
+   Bch_ConnectToDB (&argv[1]);
+   TlB_CreateTables ((unsigned long) NumPubs);
+
+   for (Who  = (TlB_Who_t) 0;
+	Who <= (TlB_Who_t) (TlB_NUM_WHO - 1);
+	Who++)
+      for (Version  = (TlB_Version_t) 0;
+	   Version <= (TlB_Version_t) (TlB_NUM_VERSIONS - 1);
+	   Version++)
+	{
+	 if (Version == TlB_FROM_INBOX &&
+	     Who != TlB_WHO_FOLLOWED)	// Inboxes are only read for users I follow
+	    continue;
+
+	 TlB_ShowTimelines (Version,Who,(unsigned) NumTimes,Seconds);
+	 for (WhatToGet  = (TlB_WhatToGet_t) 0;
+	      WhatToGet <= (TlB_WhatToGet_t) (TlB_NUM_WHAT_TO_GET - 1);
+	      WhatToGet++)
+	   {
+	    snprintf (What,sizeof (What),"%s, %s, %s",
+		      TxtWhat[WhatToGet],TxtWho[Who],TxtVersion[Version]);
+	    Bch_WriteTime (What,
+			   (unsigned long) NumTimes * NumPagesEachTime[WhatToGet],
+			   Seconds[WhatToGet]);
+	   }
+	}
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_tl_pubs,bench_tl_timelines,"
+	      "bench_usr_follow,bench_tl_inboxes,bench_tl_pull_publishers");
+   Bch_DisconnectFromDB ();
+   return 0;
+  }
+
+/*****************************************************************************/
+/*************** Create tables similar to timeline and follow ****************/
+/*****************************************************************************/
+// Publishers are spread over all users.
+// Three out of four publications are original notes,
+// and the fourth is a share or a comment of one of the last notes.
+// My inbox has my publications and those of the users I follow,
+// except those of publishers with too many followers, which are pulled.
+
+static void TlB_CreateTables (unsigned long NumPubs)
+  {
+   char *Query;
+   char *Ptr;
+   unsigned UsrCod;
+   unsigned long PubCod;
+   unsigned long NotCod = 0;
+   unsigned NumRow;
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_tl_pubs,bench_tl_timelines,"
+	      "bench_usr_follow,bench_tl_inboxes,bench_tl_pull_publishers");
+   Bch_Query ("CREATE TABLE bench_tl_pubs ("
+		 "PubCod BIGINT NOT NULL AUTO_INCREMENT,"
+		 "NotCod BIGINT NOT NULL,"
+		 "PublisherCod INT NOT NULL,"
+		 "PubType TINYINT NOT NULL,"
+		 "TimePublish DATETIME NOT NULL,"
+	      "UNIQUE INDEX(PubCod),"
+	      "INDEX(NotCod,PublisherCod,PubType),"
+	      "INDEX(PublisherCod),"
+	      "INDEX(PubType),"
+	      "INDEX(TimePublish))");
+   Bch_Query ("CREATE TABLE bench_tl_timelines ("
+		 "SessionId CHAR(43) NOT NULL,"
+		 "NotCod BIGINT NOT NULL,"
+	      "UNIQUE INDEX(SessionId,NotCod))");
+   Bch_Query ("CREATE TABLE bench_usr_follow ("
+		 "FollowerCod INT NOT NULL,"
+		 "FollowedCod INT NOT NULL,"
+		 "FollowTime DATETIME NOT NULL,"
+	      "UNIQUE INDEX (FollowerCod,FollowedCod),"
+	      "UNIQUE INDEX (FollowedCod,FollowerCod),"
+	      "INDEX (FollowTime))");
+   Bch_Query ("CREATE TABLE bench_tl_inboxes ("
+		 "UsrCod INT NOT NULL,"
+		 "PubCod BIGINT NOT NULL,"
+		 "NotCod BIGINT NOT NULL,"
+	      "UNIQUE INDEX(UsrCod,PubCod))");
+   Bch_Query ("CREATE TABLE bench_tl_pull_publishers ("
+		 "UsrCod INT NOT NULL,"
+	      "UNIQUE INDEX(UsrCod))");
+
+   if ((Query = (char *) malloc (TlB_PUBS_PER_INSERT * TlB_MAX_BYTES_ROW + 128)) == NULL)
+     {
+      fprintf (stderr,"Not enough memory.\n");
+      exit (1);
+     }
+
+   /***** Users I follow *****/
+   for (UsrCod  = TlB_MY_USR_COD + TlB_FOLLOWED_EVERY;
+	UsrCod <= TlB_NUM_USRS;
+	UsrCod += TlB_FOLLOWED_EVERY)
+      Bch_Query ("INSERT INTO bench_usr_follow"
+		 " (FollowerCod,FollowedCod,FollowTime)"
+		 " VALUES"
+		 " (%u,%u,NOW())",
+		 TlB_MY_USR_COD,UsrCod);
+   for (UsrCod  = TlB_MY_USR_COD + TlB_FOLLOWED_EVERY * TlB_PULLED_EVERY;
+	UsrCod <= TlB_NUM_USRS;
+	UsrCod += TlB_FOLLOWED_EVERY * TlB_PULLED_EVERY)
+      Bch_Query ("INSERT INTO bench_tl_pull_publishers (UsrCod)"
+		 " VALUES (%u)",
+		 UsrCod);
+
+   /***** Publications, inserting many rows in each query *****/
+   for (PubCod = 1;
+	PubCod <= NumPubs;)
+     {
+      Ptr = Query + sprintf (Query,"INSERT INTO bench_tl_pubs"
+				   " (PubCod,NotCod,PublisherCod,PubType,TimePublish)"
+				   " VALUES ");
+      for (NumRow = 0;
+	   NumRow < TlB_PUBS_PER_INSERT && PubCod <= NumPubs;
+	   NumRow++, PubCod++)
+	{
+	 if (PubCod % 4 == 0 && NotCod > 8)	// Share or comment of a recent note
+	    Ptr += sprintf (Ptr,"%s(%lu,%lu,%lu,%u,NOW()-INTERVAL %lu MINUTE)",
+			    NumRow ? "," :
+				     "",
+			    PubCod,NotCod - PubCod % 8,
+			    PubCod * 7919UL % TlB_NUM_USRS + 1,
+			    PubCod % 8 ? 2 :	// As TL_PUB_SHARED_NOTE
+					 3,	// As TL_PUB_COMMENT_TO_NOTE
+			    NumPubs - PubCod);
+	 else					// Original note
+	    Ptr += sprintf (Ptr,"%s(%lu,%lu,%lu,%u,NOW()-INTERVAL %lu MINUTE)",
+			    NumRow ? "," :
+				     "",
+			    PubCod,++NotCod,
+			    PubCod * 7919UL % TlB_NUM_USRS + 1,
+			    1,			// As TL_PUB_ORIGINAL_NOTE
+			    NumPubs - PubCod);
+	}
+      Bch_Query ("%s",Query);
+     }
+
+   free (Query);
+
+   /***** My inbox, as if publications had been pushed when published *****/
+   Bch_Query ("INSERT INTO bench_tl_inboxes (UsrCod,PubCod,NotCod)"
+	      " SELECT %u,PubCod,NotCod FROM bench_tl_pubs"
+	      " WHERE PublisherCod=%u"
+	      " OR PublisherCod IN"
+	      " (SELECT FollowedCod FROM bench_usr_follow"
+	      " WHERE FollowerCod=%u"
+	      " AND FollowedCod NOT IN"
+	      " (SELECT UsrCod FROM bench_tl_pull_publishers))",
+	      TlB_MY_USR_COD,TlB_MY_USR_COD,TlB_MY_USR_COD);
+  }
+
+/*****************************************************************************/
+/******** Show timelines several times and return time of each part **********/
+/*****************************************************************************/
+// Each time, the recent timeline is got and then some pages of older ones
+
+static void TlB_ShowTimelines (TlB_Version_t Version,TlB_Who_t Who,
+                               unsigned NumTimes,
+                               double Seconds[TlB_NUM_WHAT_TO_GET])
+  {
+   struct TlB_PubCodList Pubs;
+   unsigned NumTime;
+   unsigned NumPage;
+   double Start;
+
+   Seconds[TlB_GET_RECENT_TIMELINE] =
+   Seconds[TlB_GET_ONLY_OLD_PUBS  ] = 0.0;
+
+   for (NumTime = 0;
+	NumTime < NumTimes;
+	NumTime++)
+     {
+      /***** Recent timeline *****/
+      Start = Bch_GetSeconds ();
+      Bch_Query ("DELETE FROM bench_tl_timelines WHERE SessionId='%s'",
+		 TlB_SESSION_ID);
+      TlB_GetPubs (Version,Who,TlB_GET_RECENT_TIMELINE,0,&Pubs);
+      Seconds[TlB_GET_RECENT_TIMELINE] += Bch_GetSeconds () - Start;
+
+      /***** Old publications, each page below the previous one *****/
+      for (NumPage = 0;
+	   NumPage < TlB_NUM_OLD_PAGES && Pubs.Num;
+	   NumPage++)
+	{
+	 Start = Bch_GetSeconds ();
+	 TlB_GetPubs (Version,Who,TlB_GET_ONLY_OLD_PUBS,
+		      Pubs.PubCods[Pubs.Num - 1],&Pubs);
+	 Seconds[TlB_GET_ONLY_OLD_PUBS] += Bch_GetSeconds () - Start;
+	}
+     }
+  }
+
+/*****************************************************************************/
+/*********** Get publications to show and get data to show them **************/
+/*****************************************************************************/
+
+static void TlB_GetPubs (TlB_Version_t Version,TlB_Who_t Who,
+                         TlB_WhatToGet_t WhatToGet,
+                         long Top,struct TlB_PubCodList *Pubs)
+  {
+   switch (Version)
+     {
+      case TlB_ONE_BY_ONE:
+	 TlB_GetPubsOneByOne (Who,WhatToGet,Top,Pubs);
+	 break;
+      case TlB_IN_BATCHES:
+	 TlB_GetPubsInBatches (false,Who,WhatToGet,Top,Pubs);
+	 break;
+      case TlB_FROM_INBOX:
+	 TlB_GetPubsInBatches (true,Who,WhatToGet,Top,Pubs);
+	 break;
+     }
+  }
+
+/*****************************************************************************/
+/****** Get publications one by one, as before, and get data to show them ****/
+/*****************************************************************************/
+// Top == 0 ==> no limit
+
+static void TlB_GetPubsOneByOne (TlB_Who_t Who,TlB_WhatToGet_t WhatToGet,
+                                 long Top,struct TlB_PubCodList *Pubs)
+  {
+   unsigned MaxPubs = TlB_MaxPubsToGet[WhatToGet];
+   char SubQueryRangeTop[64];
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   long PubCod;
+   long NotCod;
+
+   /***** Create temporary tables *****/
+   Bch_Query ("CREATE TEMPORARY TABLE bench_tl_pub_codes "
+	      "(PubCod BIGINT NOT NULL,UNIQUE INDEX(PubCod)) ENGINE=MEMORY");
+   Bch_Query ("CREATE TEMPORARY TABLE bench_tl_not_codes "
+	      "(NotCod BIGINT NOT NULL,INDEX(NotCod)) ENGINE=MEMORY");
+   Bch_Query ("CREATE TEMPORARY TABLE bench_tl_current_timeline "
+	      "(NotCod BIGINT NOT NULL,INDEX(NotCod)) ENGINE=MEMORY"
+	      " SELECT NotCod FROM bench_tl_timelines WHERE SessionId='%s'",
+	      TlB_SESSION_ID);
+   if (Who == TlB_WHO_FOLLOWED)
+      Bch_Query ("CREATE TEMPORARY TABLE bench_tl_publishers "
+		 "(UsrCod INT NOT NULL,UNIQUE INDEX(UsrCod)) ENGINE=MEMORY"
+		 " SELECT %u AS UsrCod"
+		 " UNION"
+		 " SELECT FollowedCod AS UsrCod"
+		 " FROM bench_usr_follow WHERE FollowerCod=%u",
+		 TlB_MY_USR_COD,TlB_MY_USR_COD);
+
+   /***** Get the most recent publication of a note not got, one by one *****/
+   for (Pubs->Num = 0;
+	Pubs->Num < MaxPubs;
+	Pubs->Num++)
+     {
+      if (Top > 0)
+	 sprintf (SubQueryRangeTop,"bench_tl_pubs.PubCod<%ld AND ",Top);
+      else
+	 SubQueryRangeTop[0] = '\0';
+      if (Bch_QuerySELECT (&mysql_res,
+			   "SELECT bench_tl_pubs.PubCod,bench_tl_pubs.NotCod"
+			   " FROM bench_tl_pubs%s"
+			   " WHERE %s%s"
+			   "bench_tl_pubs.NotCod NOT IN"
+			   " (SELECT NotCod FROM %s)"
+			   " ORDER BY bench_tl_pubs.PubCod DESC LIMIT 1",
+			   Who == TlB_WHO_FOLLOWED ? ",bench_tl_publishers" :
+						     "",
+			   SubQueryRangeTop,
+			   Who == TlB_WHO_FOLLOWED ? "bench_tl_pubs.PublisherCod="
+						     "bench_tl_publishers.UsrCod AND " :
+						     "",
+			   WhatToGet == TlB_GET_RECENT_TIMELINE ? "bench_tl_not_codes" :
+								  "bench_tl_current_timeline") != 1)
+	{
+	 mysql_free_result (mysql_res);
+	 break;	// Last publication
+	}
+      row = mysql_fetch_row (mysql_res);
+      PubCod = strtol (row[0],NULL,10);
+      NotCod = strtol (row[1],NULL,10);
+      mysql_free_result (mysql_res);
+
+      Bch_Query ("INSERT INTO bench_tl_pub_codes SET PubCod=%ld",PubCod);
+      Bch_Query ("INSERT INTO bench_tl_not_codes SET NotCod=%ld",NotCod);
+      Bch_Query ("INSERT INTO bench_tl_current_timeline SET NotCod=%ld",NotCod);
+      Top = PubCod;	// Narrow the range for the next iteration
+
+      Pubs->PubCods[Pubs->Num] = PubCod;
+      Pubs->NotCods[Pubs->Num] = NotCod;
+     }
+
+   /***** Add notes just retrieved to current timeline *****/
+   Bch_Query ("INSERT IGNORE INTO bench_tl_timelines (SessionId,NotCod)"
+	      " SELECT DISTINCTROW '%s',NotCod FROM bench_tl_not_codes",
+	      TlB_SESSION_ID);
+
+   /***** Get data of publications to show them *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT PubCod,NotCod,PublisherCod,PubType,"
+		    "UNIX_TIMESTAMP(TimePublish)"
+		    " FROM bench_tl_pubs"
+		    " WHERE PubCod IN"
+		    " (SELECT PubCod FROM bench_tl_pub_codes)"
+		    " ORDER BY PubCod DESC");
+   TlB_FetchAllRows (mysql_res);
+
+   /***** Drop temporary tables *****/
+   Bch_Query ("DROP TEMPORARY TABLE IF EXISTS bench_tl_pub_codes,"
+	      "bench_tl_not_codes,bench_tl_current_timeline,"
+	      "bench_tl_publishers");
+  }
+
+/*****************************************************************************/
+/******* Get publications in batches, as now, and get data to show them ******/
+/*****************************************************************************/
+// Top == 0 ==> no limit
+// ReadFromInbox ==> users I follow with fan-out on write, as in swad
+
+static void TlB_GetPubsInBatches (bool ReadFromInbox,
+                                  TlB_Who_t Who,TlB_WhatToGet_t WhatToGet,
+                                  long Top,struct TlB_PubCodList *Pubs)
+  {
+   unsigned MaxPubs = TlB_MaxPubsToGet[WhatToGet];
+   unsigned long NumPubsInBatch = (unsigned long) MaxPubs * TlB_PUBS_PER_NOTE_IN_BATCH;
+   char SubQueryPublishers[128];
+   char SubQueryRangeTop[64];
+   char SubQueryRangeInbox[64];
+   struct TlB_NotCodSet NotesToSkip;
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows;
+   unsigned long NumRow;
+   long PubCod;
+   long NotCod;
+   unsigned NumPub;
+   char PubCods[TlB_MAX_BYTES_CODS];
+   char Notes[TlB_MAX_BYTES_NOTES];
+   char *PtrPubCods;
+   char *PtrNotes;
+
+   /***** Subquery with potential publishers *****/
+   if (Who == TlB_WHO_FOLLOWED)
+      sprintf (SubQueryPublishers,
+	       " AND (PublisherCod=%u"
+	       " OR PublisherCod IN"
+	       " (SELECT FollowedCod FROM bench_usr_follow"
+	       " WHERE FollowerCod=%u))",
+	       TlB_MY_USR_COD,TlB_MY_USR_COD);
+   else
+      SubQueryPublishers[0] = '\0';
+
+   /***** Notes that must not be got *****/
+   if (WhatToGet == TlB_GET_RECENT_TIMELINE)
+      TlB_CreateSetOfNotes (&NotesToSkip,MaxPubs);
+   else
+      TlB_AddCurrentTimelineToSetOfNotes (&NotesToSkip);
+
+   /***** Get publications in batches, from newest to oldest *****/
+   Pubs->Num = 0;
+   do
+     {
+      if (Top > 0)
+	{
+	 sprintf (SubQueryRangeTop," AND bench_tl_pubs.PubCod<%ld",Top);
+	 sprintf (SubQueryRangeInbox," AND bench_tl_inboxes.PubCod<%ld",Top);
+	}
+      else
+	 SubQueryRangeTop[0] =
+	 SubQueryRangeInbox[0] = '\0';
+      if (ReadFromInbox)
+	 NumRows = Bch_QuerySELECT (&mysql_res,
+				    "(SELECT bench_tl_inboxes.PubCod,"
+					    "bench_tl_inboxes.NotCod"
+				    " FROM bench_tl_inboxes,bench_tl_pubs"
+				    " WHERE bench_tl_inboxes.UsrCod=%u%s"
+				    " AND bench_tl_inboxes.PubCod=bench_tl_pubs.PubCod"
+				    " ORDER BY bench_tl_inboxes.PubCod DESC LIMIT %lu)"
+				    " UNION "
+				    "(SELECT bench_tl_pubs.PubCod,"
+					    "bench_tl_pubs.NotCod"
+				    " FROM bench_tl_pubs"
+				    " WHERE bench_tl_pubs.PublisherCod IN"
+				    " (SELECT bench_tl_pull_publishers.UsrCod"
+				    " FROM bench_usr_follow,bench_tl_pull_publishers"
+				    " WHERE bench_usr_follow.FollowerCod=%u"
+				    " AND bench_usr_follow.FollowedCod=bench_tl_pull_publishers.UsrCod)%s"
+				    " ORDER BY bench_tl_pubs.PubCod DESC LIMIT %lu)"
+				    " ORDER BY PubCod DESC LIMIT %lu",
+				    TlB_MY_USR_COD,SubQueryRangeInbox,
+				    NumPubsInBatch,
+				    TlB_MY_USR_COD,SubQueryRangeTop,
+				    NumPubsInBatch,
+				    NumPubsInBatch);
+      else
+	 NumRows = Bch_QuerySELECT (&mysql_res,
+				    "SELECT PubCod,NotCod"
+				    " FROM bench_tl_pubs"
+				    " WHERE TRUE%s%s"
+				    " ORDER BY PubCod DESC LIMIT %lu",
+				    SubQueryRangeTop,SubQueryPublishers,
+				    NumPubsInBatch);
+      for (NumRow = 0;
+	   NumRow < NumRows && Pubs->Num < MaxPubs;
+	   NumRow++)
+	{
+	 row = mysql_fetch_row (mysql_res);
+	 PubCod = strtol (row[0],NULL,10);
+	 NotCod = strtol (row[1],NULL,10);
+	 Top = PubCod;	// Narrow the range for the next batch
+
+	 /* Add publication only if its note is not already got */
+	 if (TlB_AddNoteToSet (&NotesToSkip,NotCod))
+	   {
+	    Pubs->PubCods[Pubs->Num] = PubCod;
+	    Pubs->NotCods[Pubs->Num] = NotCod;
+	    Pubs->Num++;
+	   }
+	}
+      mysql_free_result (mysql_res);
+     }
+   while (Pubs->Num < MaxPubs &&
+	  NumRows == NumPubsInBatch);	// There may be more publications
+
+   TlB_FreeSetOfNotes (&NotesToSkip);
+
+   if (Pubs->Num)
+     {
+      /***** Lists of publications and notes *****/
+      for (NumPub = 0, PtrPubCods = PubCods, PtrNotes = Notes;
+	   NumPub < Pubs->Num;
+	   NumPub++)
+	{
+	 PtrPubCods += sprintf (PtrPubCods,NumPub ? ",%ld" :
+						    "%ld",
+				Pubs->PubCods[NumPub]);
+	 PtrNotes += sprintf (PtrNotes,NumPub ? ",('%s',%ld)" :
+						"('%s',%ld)",
+			      TlB_SESSION_ID,Pubs->NotCods[NumPub]);
+	}
+
+      /***** Add notes just retrieved to current timeline *****/
+      Bch_Query ("INSERT IGNORE INTO bench_tl_timelines (SessionId,NotCod)"
+		 " VALUES %s",
+		 Notes);
+
+      /***** Get data of publications to show them *****/
+      Bch_QuerySELECT (&mysql_res,
+		       "SELECT PubCod,NotCod,PublisherCod,PubType,"
+		       "UNIX_TIMESTAMP(TimePublish)"
+		       " FROM bench_tl_pubs"
+		       " WHERE PubCod IN (%s)"
+		       " ORDER BY PubCod DESC",
+		       PubCods);
+      TlB_FetchAllRows (mysql_res);
+     }
+  }
+
+/*****************************************************************************/
+/************ Create a set with the notes in current timeline ****************/
+/*****************************************************************************/
+
+static void TlB_AddCurrentTimelineToSetOfNotes (struct TlB_NotCodSet *Set)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumNotes;
+   unsigned long NumNot;
+
+   NumNotes = Bch_QuerySELECT (&mysql_res,
+			       "SELECT NotCod FROM bench_tl_timelines"
+			       " WHERE SessionId='%s'",
+			       TlB_SESSION_ID);
+   TlB_CreateSetOfNotes (Set,NumNotes + TlB_MAX_OLD_PUBS);
+   for (NumNot = 0;
+	NumNot < NumNotes;
+	NumNot++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      TlB_AddNoteToSet (Set,strtol (row[0],NULL,10));
+     }
+   mysql_free_result (mysql_res);
+  }
+
+/*****************************************************************************/
+/********************* Set of note codes, as in timeline *********************/
+/*****************************************************************************/
+
+static void TlB_CreateSetOfNotes (struct TlB_NotCodSet *Set,size_t MinSize)
+  {
+   for (Set->Size = 16;
+	Set->Size < MinSize * 2;
+	Set->Size *= 2);
+
+   if ((Set->NotCods = (long *) calloc (Set->Size,sizeof (long))) == NULL)
+     {
+      fprintf (stderr,"Not enough memory.\n");
+      exit (1);
+     }
+  }
+
+static bool TlB_AddNoteToSet (struct TlB_NotCodSet *Set,long NotCod)
+  {
+   size_t Mask = Set->Size - 1;
+   size_t Slot;
+
+   if (NotCod <= 0)
+      return false;
+
+   for (Slot = ((size_t) NotCod * 2654435761UL) & Mask;
+	Set->NotCods[Slot];
+	Slot = (Slot + 1) & Mask)
+      if (Set->NotCods[Slot] == NotCod)
+	 return false;
+
+   Set->NotCods[Slot] = NotCod;
+   return true;
+  }
+
+static void TlB_FreeSetOfNotes (struct TlB_NotCodSet *Set)
+  {
+   free (Set->NotCods);
+   Set->NotCods = NULL;
+   Set->Size = 0;
+  }
+
+/*****************************************************************************/
+/********************* Fetch all rows and free result ************************/
+/*****************************************************************************/
+
+static void TlB_FetchAllRows (MYSQL_RES *mysql_res)
+  {
+   while (mysql_fetch_row (mysql_res));
+   mysql_free_result (mysql_res);
+  }
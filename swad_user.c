@@ -145,6 +145,19 @@ const char *Usr_UsrDatMainFieldNames[Usr_NUM_MAIN_FIELDS_DATA_USR];
 /****************************** Private types ********************************/
 /*****************************************************************************/
 
+struct Usr_RelationWithMe
+  {
+   long UsrCod;
+   bool SharesAnyOfMyCrs;
+   bool SharesAnyOfMyCrsWithDifferentRole;
+  };
+
+struct Usr_UsrCodInList
+  {
+   long UsrCod;
+   unsigned NumUsr;	// Index in list of users
+  };
+
 /*****************************************************************************/
 /************** External global variables from others modules ****************/
 /*****************************************************************************/
@@ -157,6 +170,28 @@ extern struct Globals Gbl;
 
 static void (*Usr_FuncParamsBigList) ();	// Used to pass pointer to function
 
+static struct
+  {
+   unsigned Num;
+   struct Usr_RelationWithMe *Lst;	// Sorted by user's code
+  } Usr_RelationsWithMe =	// Got at once for all users in a list
+  {
+   .Num = 0,
+   .Lst = NULL,
+  };
+
+static struct
+  {
+   unsigned Num;		// Number of memory blocks not yet freed
+   unsigned Size;		// Number of pointers allocated in list
+   void **Lst;
+  } Usr_MemOfUsrData =	// Memory allocated for users' data in this request
+  {
+   .Num  = 0,
+   .Size = 0,
+   .Lst  = NULL,
+  };
+
 /*****************************************************************************/
 /***************************** Private prototypes ****************************/
 /*****************************************************************************/
@@ -199,6 +234,13 @@ static void Usr_BuildQueryToGetUsrsLstCrs (char **Query,Rol_Role_t Role);
 static void Usr_GetAdmsLst (Hie_Level_t Scope);
 static void Usr_GetGstsLst (Hie_Level_t Scope);
 static void Usr_GetListUsrsFromQuery (char *Query,Rol_Role_t Role,Hie_Level_t Scope);
+static void Usr_BuildStrUsrCodsInList (Rol_Role_t Role,char **UsrCods);
+static int Usr_CompareUsrCodsInList (const void *Ptr1,const void *Ptr2);
+static int Usr_CompareRelationsWithMe (const void *Ptr1,const void *Ptr2);
+static void Usr_SetRelationsWithMeFromQuery (const char *UsrCods,
+					     bool SharesWithDifferentRole);
+static const struct Usr_RelationWithMe *Usr_GetRelationWithMe (long UsrCod);
+static void Usr_FreeRelationsWithMe (void);
 static void Usr_AllocateUsrsList (Rol_Role_t Role);
 
 static void Usr_PutButtonToConfirmIWantToSeeBigList (unsigned NumUsrs,
@@ -307,6 +349,7 @@ void Usr_UsrDataConstructor (struct UsrData *UsrDat)
    /***** Allocate memory for the comments *****/
    if ((UsrDat->Comments = (char *) malloc (Cns_MAX_BYTES_TEXT + 1)) == NULL)
       Lay_NotEnoughMemoryExit ();
+   Usr_AddMemOfUsrData (UsrDat->Comments);
 
    /***** Initialize to zero the data of the user *****/
    Usr_ResetUsrDataExceptUsrCodAndIDs (UsrDat);
@@ -398,6 +441,7 @@ void Usr_UsrDataDestructor (struct UsrData *UsrDat)
    /***** Free memory allocated for comments *****/
    if (UsrDat->Comments)
      {
+      Usr_RemoveMemOfUsrData (UsrDat->Comments);
       free (UsrDat->Comments);
       UsrDat->Comments = NULL;
      }
@@ -406,6 +450,53 @@ void Usr_UsrDataDestructor (struct UsrData *UsrDat)
    ID_FreeListIDs (UsrDat);
   }
 
+/*****************************************************************************/
+/*************** Add/remove a block of memory of user's data *****************/
+/*****************************************************************************/
+// When a request ends abruptly (error, no permission...),
+// user's data in local variables are not destroyed.
+// A persistent worker frees them at the end of the request
+
+void Usr_AddMemOfUsrData (void *Ptr)
+  {
+   if (Usr_MemOfUsrData.Num == Usr_MemOfUsrData.Size)
+     {
+      Usr_MemOfUsrData.Size = Usr_MemOfUsrData.Size ? Usr_MemOfUsrData.Size * 2 :
+						      64;
+      if ((Usr_MemOfUsrData.Lst = (void **) realloc (Usr_MemOfUsrData.Lst,
+						     Usr_MemOfUsrData.Size *
+						     sizeof (void *))) == NULL)
+	 Lay_NotEnoughMemoryExit ();
+     }
+   Usr_MemOfUsrData.Lst[Usr_MemOfUsrData.Num++] = Ptr;
+  }
+
+void Usr_RemoveMemOfUsrData (void *Ptr)
+  {
+   unsigned i;
+
+   /***** Search from the end, since usually
+          the last allocated is the first freed *****/
+   for (i = Usr_MemOfUsrData.Num;
+	i != 0;
+	i--)
+      if (Usr_MemOfUsrData.Lst[i - 1] == Ptr)
+	{
+	 Usr_MemOfUsrData.Lst[i - 1] = Usr_MemOfUsrData.Lst[--Usr_MemOfUsrData.Num];
+	 return;
+	}
+  }
+
+/*****************************************************************************/
+/*********** Free memory of users' data not freed in this request ************/
+/*****************************************************************************/
+
+void Usr_FreeMemOfUsrDataNotFreed (void)
+  {
+   while (Usr_MemOfUsrData.Num)
+      free (Usr_MemOfUsrData.Lst[--Usr_MemOfUsrData.Num]);
+  }
+
 /*****************************************************************************/
 /************* Get all the user's data from a given user's code **************/
 /*****************************************************************************/
@@ -751,6 +842,157 @@ void Usr_GetUsrDataFromUsrCod (struct UsrData *UsrDat,Usr_GetPrefs_t GetPrefs)
    Mai_GetEmailFromUsrCod (UsrDat);
   }
 
+/*****************************************************************************/
+/*********** Get basic data of several users using only one query ************/
+/*****************************************************************************/
+// UsrDats[NumUsr] must be initialized with Usr_UsrDataConstructor
+// and UsrDats[NumUsr].UsrCod must be filled.
+// Only the data needed to list users (name, sex, photo, country,
+// institution and nickname) are got. Roles will be got when needed.
+// Users not found get UsrCod = -1
+
+void Usr_GetBasicDataOfUsrs (struct UsrData UsrDats[],unsigned NumUsrs)
+  {
+   char *UsrCods;
+   char *Ptr;
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows;
+   unsigned long NumRow;
+   unsigned NumUsr;
+   long UsrCod;
+
+   if (!NumUsrs)
+      return;
+
+   /***** Reset users' data and build the list of users' codes *****/
+   if ((UsrCods = (char *) malloc (NumUsrs * (Cns_MAX_DECIMAL_DIGITS_LONG + 1) + 1)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   for (NumUsr = 0, Ptr = UsrCods;
+	NumUsr < NumUsrs;
+	NumUsr++)
+     {
+      Usr_ResetUsrDataExceptUsrCodAndIDs (&UsrDats[NumUsr]);
+      Ptr += sprintf (Ptr,NumUsr ? ",%ld" :
+				   "%ld",
+		      UsrDats[NumUsr].UsrCod);
+     }
+
+   /***** Get users' data from database *****/
+   NumRows = DB_QuerySELECT (&mysql_res,"can not get users' data",
+			     "SELECT UsrCod,"			// row[ 0]
+				    "EncryptedUsrCod,"		// row[ 1]
+				    "Surname1,"			// row[ 2]
+				    "Surname2,"			// row[ 3]
+				    "FirstName,"		// row[ 4]
+				    "Sex,"			// row[ 5]
+				    "Photo,"			// row[ 6]
+				    "PhotoVisibility,"		// row[ 7]
+				    "BaPrfVisibility,"		// row[ 8]
+				    "ExPrfVisibility,"		// row[ 9]
+				    "CtyCod,"			// row[10]
+				    "InsCtyCod,"		// row[11]
+				    "InsCod,"			// row[12]
+				    "(SELECT Nickname FROM usr_nicknames"
+				    " WHERE usr_nicknames.UsrCod=usr_data.UsrCod"
+				    " ORDER BY CreatTime DESC LIMIT 1)"	// row[13]
+			     " FROM usr_data"
+			     " WHERE UsrCod IN (%s)",
+			     UsrCods);
+
+   /***** Free list of users' codes *****/
+   free (UsrCods);
+
+   /***** Copy data to all the users having each code *****/
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+      UsrCod = Str_ConvertStrCodToLongCod (row[0]);
+
+      for (NumUsr = 0;
+	   NumUsr < NumUsrs;
+	   NumUsr++)
+	 if (UsrDats[NumUsr].UsrCod == UsrCod)
+	    Usr_GetUsrBasicDataFromRow (&UsrDats[NumUsr],&row[1]);
+     }
+
+   /***** Free structure that stores the query result *****/
+   DB_FreeMySQLResult (&mysql_res);
+
+   /***** Users not found in database *****/
+   for (NumUsr = 0;
+	NumUsr < NumUsrs;
+	NumUsr++)
+      if (!UsrDats[NumUsr].EncryptedUsrCod[0])
+	 UsrDats[NumUsr].UsrCod = -1L;
+  }
+
+/*****************************************************************************/
+/************** Get basic data of a user from a row of a query ***************/
+/*****************************************************************************/
+// row[ 0]: EncryptedUsrCod
+// row[ 1]: Surname1
+// row[ 2]: Surname2
+// row[ 3]: FirstName
+// row[ 4]: Sex
+// row[ 5]: Photo
+// row[ 6]: PhotoVisibility
+// row[ 7]: BaPrfVisibility
+// row[ 8]: ExPrfVisibility
+// row[ 9]: CtyCod
+// row[10]: InsCtyCod
+// row[11]: InsCod
+// row[12]: Nickname (may be NULL)
+
+void Usr_GetUsrBasicDataFromRow (struct UsrData *UsrDat,MYSQL_ROW row)
+  {
+   /***** Get encrypted user's code (row[0]) *****/
+   Str_Copy (UsrDat->EncryptedUsrCod,row[0],
+             Cry_BYTES_ENCRYPTED_STR_SHA256_BASE64);
+
+   /***** Roles will be got from database when needed *****/
+   UsrDat->Roles.InCurrentCrs.Role = Rol_UNK;
+   UsrDat->Roles.InCurrentCrs.Valid = false;
+   UsrDat->Roles.InCrss = -1;
+
+   /***** Get name (row[1], row[2], row[3]) *****/
+   Str_Copy (UsrDat->Surname1,row[1],
+             Usr_MAX_BYTES_FIRSTNAME_OR_SURNAME);
+   Str_Copy (UsrDat->Surname2,row[2],
+             Usr_MAX_BYTES_FIRSTNAME_OR_SURNAME);
+   Str_Copy (UsrDat->FirstName,row[3],
+             Usr_MAX_BYTES_FIRSTNAME_OR_SURNAME);
+   Str_ConvertToTitleType (UsrDat->Surname1 );
+   Str_ConvertToTitleType (UsrDat->Surname2 );
+   Str_ConvertToTitleType (UsrDat->FirstName);
+   Usr_BuildFullName (UsrDat);	// Create full name using FirstName, Surname1 and Surname2
+
+   /***** Get sex (row[4]) *****/
+   UsrDat->Sex = Usr_GetSexFromStr (row[4]);
+
+   /***** Get photo (row[5]) and visibilities (row[6], row[7], row[8]) *****/
+   Str_Copy (UsrDat->Photo,row[5],
+             Cry_BYTES_ENCRYPTED_STR_SHA256_BASE64);
+   UsrDat->PhotoVisibility = Pri_GetVisibilityFromStr (row[6]);
+   UsrDat->BaPrfVisibility = Pri_GetVisibilityFromStr (row[7]);
+   UsrDat->ExPrfVisibility = Pri_GetVisibilityFromStr (row[8]);
+
+   /***** Get country (row[9]),
+          institution country (row[10]) and institution (row[11]) *****/
+   UsrDat->CtyCod    = Str_ConvertStrCodToLongCod (row[ 9]);
+   UsrDat->InsCtyCod = Str_ConvertStrCodToLongCod (row[10]);
+   UsrDat->InsCod    = Str_ConvertStrCodToLongCod (row[11]);
+
+   /***** Get nickname (row[12]) *****/
+   if (row[12])
+      Str_Copy (UsrDat->Nickname,row[12],
+		Nck_MAX_BYTES_NICKNAME_WITHOUT_ARROBA);
+   else
+      UsrDat->Nickname[0] = '\0';
+  }
+
 /*****************************************************************************/
 /********* Get the comments in the record of a user from a string ************/
 /*****************************************************************************/
@@ -1497,11 +1739,13 @@ void Usr_FlushCacheUsrSharesAnyOfMyCrs (void)
   {
    Gbl.Cache.UsrSharesAnyOfMyCrs.UsrCod = -1L;
    Gbl.Cache.UsrSharesAnyOfMyCrs.SharesAnyOfMyCrs = false;
+   Usr_FreeRelationsWithMe ();
   }
 
 bool Usr_CheckIfUsrSharesAnyOfMyCrs (struct UsrData *UsrDat)
   {
    bool ItsMe;
+   const struct Usr_RelationWithMe *Relation;
 
    /***** 1. Fast check: Am I logged? *****/
    if (!Gbl.Usrs.Me.Logged)
@@ -1520,19 +1764,23 @@ bool Usr_CheckIfUsrSharesAnyOfMyCrs (struct UsrData *UsrDat)
    if (UsrDat->UsrCod == Gbl.Cache.UsrSharesAnyOfMyCrs.UsrCod)
       return Gbl.Cache.UsrSharesAnyOfMyCrs.SharesAnyOfMyCrs;
 
-   /***** 5. Fast check: Is course selected and we both belong to it? *****/
+   /***** 5. Fast check: Is already got for a whole list of users? *****/
+   if ((Relation = Usr_GetRelationWithMe (UsrDat->UsrCod)))
+      return Relation->SharesAnyOfMyCrs;
+
+   /***** 6. Fast check: Is course selected and we both belong to it? *****/
    if (Gbl.Usrs.Me.IBelongToCurrentCrs)
       if (Usr_CheckIfUsrBelongsToCurrentCrs (UsrDat))	// Course selected and we both belong to it
          return true;
 
-   /***** 6. Fast/slow check: Does he/she belong to any course? *****/
+   /***** 7. Fast/slow check: Does he/she belong to any course? *****/
    Rol_GetRolesInAllCrssIfNotYetGot (UsrDat);
    if (!(UsrDat->Roles.InCrss & ((1 << Rol_STD) |	// Any of his/her roles is student
 	                         (1 << Rol_NET) |	// or non-editing teacher
 			         (1 << Rol_TCH))))	// or teacher?
       return false;
 
-   /***** 7. Slow check: Get if user shares any course with me from database *****/
+   /***** 8. Slow check: Get if user shares any course with me from database *****/
    /* Fill the list with the courses I belong to (if not already filled) */
    Usr_GetMyCourses ();
 
@@ -1554,12 +1802,17 @@ bool Usr_CheckIfUsrSharesAnyOfMyCrs (struct UsrData *UsrDat)
 bool Usr_CheckIfUsrSharesAnyOfMyCrsWithDifferentRole (long UsrCod)
   {
    bool UsrSharesAnyOfMyCrsWithDifferentRole;
+   const struct Usr_RelationWithMe *Relation;
 
    /***** 1. Fast check: Am I logged? *****/
    if (!Gbl.Usrs.Me.Logged)
       return false;
 
-   /***** 2. Slow check: Get if user shares any course with me
+   /***** 2. Fast check: Is already got for a whole list of users? *****/
+   if ((Relation = Usr_GetRelationWithMe (UsrCod)))
+      return Relation->SharesAnyOfMyCrsWithDifferentRole;
+
+   /***** 3. Slow check: Get if user shares any course with me
                          with a different role, from database *****/
    /* Fill the list with the courses I belong to (if not already filled) */
    Usr_GetMyCourses ();
@@ -5068,10 +5321,11 @@ void Usr_CreateTmpTableAndSearchCandidateUsrs (const char SearchQuery[Sch_MAX_BY
       - Search is faster (aproximately x2) using temporary tables.
       - Searching for names is made in the whole platform
         and stored in this table.
+      - SearchQuery is a derived table built by Sch_BuildSearchQueryInIndex.
    */
    sprintf (Query,"CREATE TEMPORARY TABLE candidate_users"
 		  " (UsrCod INT NOT NULL,UNIQUE INDEX(UsrCod)) ENGINE=MEMORY"
-		  " SELECT UsrCod FROM usr_data WHERE %s",
+		  " SELECT Cod AS UsrCod FROM %s AS found",
 	    SearchQuery);
    if (mysql_query (&Gbl.mysql,Query))
       DB_ExitOnMySQLError ("can not create temporary table");
@@ -5584,6 +5838,300 @@ void Usr_CopyBasicUsrDataFromList (struct UsrData *UsrDat,const struct UsrInList
    UsrDat->Accepted                = UsrInList->Accepted;
   }
 
+/*****************************************************************************/
+/************* Get the IDs of all users in a list at once ********************/
+/*****************************************************************************/
+// Only one query is made for the whole list,
+// instead of one query for each user when the list is shown
+
+void Usr_GetListIDsOfUsrsInList (Rol_Role_t Role)
+  {
+   struct UsrInList *Lst = Gbl.Usrs.LstUsrs[Role].Lst;
+   unsigned NumUsrs = Gbl.Usrs.LstUsrs[Role].NumUsrs;
+   struct Usr_UsrCodInList *Index;
+   struct Usr_UsrCodInList Key;
+   const struct Usr_UsrCodInList *Found;
+   char *UsrCods;
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows;
+   unsigned long NumRow;
+   unsigned NumUsr;
+   struct UsrInList *UsrInList;
+
+   if (!NumUsrs)
+      return;
+
+   /***** Reset IDs of all users in list *****/
+   for (NumUsr = 0;
+	NumUsr < NumUsrs;
+	NumUsr++)
+     {
+      if (Lst[NumUsr].IDs.List)
+	 free (Lst[NumUsr].IDs.List);
+      Lst[NumUsr].IDs.List = NULL;
+      Lst[NumUsr].IDs.Num  = 0;
+      Lst[NumUsr].IDs.Got  = true;
+     }
+
+   /***** Build an index of the list sorted by user's code *****/
+   if ((Index = (struct Usr_UsrCodInList *) malloc (NumUsrs * sizeof (struct Usr_UsrCodInList))) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   for (NumUsr = 0;
+	NumUsr < NumUsrs;
+	NumUsr++)
+     {
+      Index[NumUsr].UsrCod = Lst[NumUsr].UsrCod;
+      Index[NumUsr].NumUsr = NumUsr;
+     }
+   qsort (Index,NumUsrs,sizeof (struct Usr_UsrCodInList),
+	  Usr_CompareUsrCodsInList);
+
+   /***** Get IDs of all users in list from database *****/
+   // For each user, first the confirmed  (Confirmed == 'Y')
+   //                then the unconfirmed (Confirmed == 'N')
+   Usr_BuildStrUsrCodsInList (Role,&UsrCods);
+   NumRows = DB_QuerySELECT (&mysql_res,"can not get users' IDs",
+			     "SELECT UsrCod,UsrID,Confirmed FROM usr_IDs"
+			     " WHERE UsrCod IN (%s)"
+			     " ORDER BY UsrCod,Confirmed DESC,UsrID",
+			     UsrCods);
+   free (UsrCods);
+
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+
+      /* Get user's code (row[0]) and find the user in list */
+      Key.UsrCod = Str_ConvertStrCodToLongCod (row[0]);
+      if ((Found = bsearch (&Key,Index,NumUsrs,sizeof (struct Usr_UsrCodInList),
+			    Usr_CompareUsrCodsInList)))
+	{
+	 UsrInList = &Lst[Found->NumUsr];
+
+	 /* Add a new ID to the list of IDs of this user */
+	 if ((UsrInList->IDs.List = (struct ListIDs *) realloc (UsrInList->IDs.List,
+								 (UsrInList->IDs.Num + 1) *
+								 sizeof (struct ListIDs))) == NULL)
+	    Lay_NotEnoughMemoryExit ();
+
+	 /* Get ID (row[1]) and if it is confirmed (row[2]) */
+	 Str_Copy (UsrInList->IDs.List[UsrInList->IDs.Num].ID,row[1],
+		   ID_MAX_BYTES_USR_ID);
+	 UsrInList->IDs.List[UsrInList->IDs.Num].Confirmed = (row[2][0] == 'Y');
+	 UsrInList->IDs.Num++;
+	}
+     }
+
+   /***** Free structure that stores the query result *****/
+   DB_FreeMySQLResult (&mysql_res);
+
+   /***** Free index *****/
+   free (Index);
+  }
+
+/*****************************************************************************/
+/********************** Copy user's IDs from list of users *******************/
+/*****************************************************************************/
+// If IDs were not got for the whole list, get them from database
+
+void Usr_CopyListIDsFromList (struct UsrData *UsrDat,const struct UsrInList *UsrInList)
+  {
+   if (UsrInList->IDs.Got)
+     {
+      ID_FreeListIDs (UsrDat);
+      if (UsrInList->IDs.Num)
+	{
+	 ID_ReallocateListIDs (UsrDat,UsrInList->IDs.Num);
+	 memcpy (UsrDat->IDs.List,UsrInList->IDs.List,
+		 UsrInList->IDs.Num * sizeof (struct ListIDs));
+	}
+     }
+   else
+      ID_GetListIDsFromUsrCod (UsrDat);
+  }
+
+/*****************************************************************************/
+/******* Get at once if the users in a list share any course with me *********/
+/*****************************************************************************/
+// Only two queries are made for the whole list,
+// instead of several queries for each user
+// when checking privacy of each user in the list
+
+void Usr_GetRelationsWithMeOfUsrsInList (Rol_Role_t Role)
+  {
+   struct UsrInList *Lst = Gbl.Usrs.LstUsrs[Role].Lst;
+   unsigned NumUsrs = Gbl.Usrs.LstUsrs[Role].NumUsrs;
+   unsigned NumUsr;
+   char *UsrCods;
+
+   /***** Free previous relations *****/
+   Usr_FreeRelationsWithMe ();
+
+   /***** Only necessary if I am logged and I am not a system admin *****/
+   if (!NumUsrs ||
+       !Gbl.Usrs.Me.Logged ||
+       Gbl.Usrs.Me.Role.Logged == Rol_SYS_ADM)
+      return;
+
+   /***** Allocate relations, sorted by user's code *****/
+   if ((Usr_RelationsWithMe.Lst = (struct Usr_RelationWithMe *) malloc (NumUsrs * sizeof (struct Usr_RelationWithMe))) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   for (NumUsr = 0;
+	NumUsr < NumUsrs;
+	NumUsr++)
+     {
+      Usr_RelationsWithMe.Lst[NumUsr].UsrCod = Lst[NumUsr].UsrCod;
+      Usr_RelationsWithMe.Lst[NumUsr].SharesAnyOfMyCrs                  = false;
+      Usr_RelationsWithMe.Lst[NumUsr].SharesAnyOfMyCrsWithDifferentRole = false;
+     }
+   Usr_RelationsWithMe.Num = NumUsrs;
+   qsort (Usr_RelationsWithMe.Lst,Usr_RelationsWithMe.Num,
+	  sizeof (struct Usr_RelationWithMe),
+	  Usr_CompareRelationsWithMe);
+
+   /***** Fill the list with the courses I belong to (if not already filled) *****/
+   Usr_GetMyCourses ();
+
+   /***** Get users who share any course with me
+          and users who share any course with me with a different role *****/
+   Usr_BuildStrUsrCodsInList (Role,&UsrCods);
+   Usr_SetRelationsWithMeFromQuery (UsrCods,false);
+   Usr_SetRelationsWithMeFromQuery (UsrCods,true);
+   free (UsrCods);
+  }
+
+/*****************************************************************************/
+/********** Build a string with the codes of the users in a list *************/
+/*****************************************************************************/
+// UsrCods must be freed by the caller
+
+static void Usr_BuildStrUsrCodsInList (Rol_Role_t Role,char **UsrCods)
+  {
+   unsigned NumUsr;
+   char *Ptr;
+
+   if ((*UsrCods = (char *) malloc (Gbl.Usrs.LstUsrs[Role].NumUsrs *
+				    (Cns_MAX_DECIMAL_DIGITS_LONG + 1) + 1)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+
+   for (NumUsr = 0, Ptr = *UsrCods;
+	NumUsr < Gbl.Usrs.LstUsrs[Role].NumUsrs;
+	NumUsr++)
+      Ptr += sprintf (Ptr,NumUsr ? ",%ld" :
+			           "%ld",
+		      Gbl.Usrs.LstUsrs[Role].Lst[NumUsr].UsrCod);
+   *Ptr = '\0';
+  }
+
+/*****************************************************************************/
+/*************** Compare user's codes, used to sort and search ***************/
+/*****************************************************************************/
+
+static int Usr_CompareUsrCodsInList (const void *Ptr1,const void *Ptr2)
+  {
+   long UsrCod1 = ((const struct Usr_UsrCodInList *) Ptr1)->UsrCod;
+   long UsrCod2 = ((const struct Usr_UsrCodInList *) Ptr2)->UsrCod;
+
+   return (UsrCod1 > UsrCod2) - (UsrCod1 < UsrCod2);
+  }
+
+static int Usr_CompareRelationsWithMe (const void *Ptr1,const void *Ptr2)
+  {
+   long UsrCod1 = ((const struct Usr_RelationWithMe *) Ptr1)->UsrCod;
+   long UsrCod2 = ((const struct Usr_RelationWithMe *) Ptr2)->UsrCod;
+
+   return (UsrCod1 > UsrCod2) - (UsrCod1 < UsrCod2);
+  }
+
+/*****************************************************************************/
+/********* Set relations with me of the users returned by a query ************/
+/*****************************************************************************/
+
+static void Usr_SetRelationsWithMeFromQuery (const char *UsrCods,
+					     bool SharesWithDifferentRole)
+  {
+   MYSQL_RES *mysql_res;
+   MYSQL_ROW row;
+   unsigned long NumRows;
+   unsigned long NumRow;
+   struct Usr_RelationWithMe Key;
+   struct Usr_RelationWithMe *Relation;
+
+   /***** Get users in list who share any course with me
+          (with any role or with a role different to mine) *****/
+   if (SharesWithDifferentRole)
+      NumRows = DB_QuerySELECT (&mysql_res,"can not check if users share any course with you",
+				"SELECT DISTINCT crs_usr.UsrCod"
+				" FROM crs_usr,my_courses_tmp"
+				" WHERE crs_usr.UsrCod IN (%s)"
+				" AND crs_usr.CrsCod=my_courses_tmp.CrsCod"
+				" AND crs_usr.Role<>my_courses_tmp.Role",
+				UsrCods);
+   else
+      NumRows = DB_QuerySELECT (&mysql_res,"can not check if users share any course with you",
+				"SELECT DISTINCT UsrCod FROM crs_usr"
+				" WHERE UsrCod IN (%s)"
+				" AND CrsCod IN (SELECT CrsCod FROM my_courses_tmp)",
+				UsrCods);
+
+   for (NumRow = 0;
+	NumRow < NumRows;
+	NumRow++)
+     {
+      row = mysql_fetch_row (mysql_res);
+
+      /* Get user's code (row[0]) */
+      Key.UsrCod = Str_ConvertStrCodToLongCod (row[0]);
+      if ((Relation = bsearch (&Key,Usr_RelationsWithMe.Lst,Usr_RelationsWithMe.Num,
+			       sizeof (struct Usr_RelationWithMe),
+			       Usr_CompareRelationsWithMe)))
+	{
+	 if (SharesWithDifferentRole)
+	    Relation->SharesAnyOfMyCrsWithDifferentRole = true;
+	 else
+	    Relation->SharesAnyOfMyCrs = true;
+	}
+     }
+
+   /***** Free structure that stores the query result *****/
+   DB_FreeMySQLResult (&mysql_res);
+  }
+
+/*****************************************************************************/
+/********** Get relation with me of a user got for a list of users ***********/
+/*****************************************************************************/
+// Return NULL if not got
+
+static const struct Usr_RelationWithMe *Usr_GetRelationWithMe (long UsrCod)
+  {
+   struct Usr_RelationWithMe Key;
+
+   if (!Usr_RelationsWithMe.Num)
+      return NULL;
+
+   Key.UsrCod = UsrCod;
+   return bsearch (&Key,Usr_RelationsWithMe.Lst,Usr_RelationsWithMe.Num,
+		   sizeof (struct Usr_RelationWithMe),
+		   Usr_CompareRelationsWithMe);
+  }
+
+/*****************************************************************************/
+/********** Free relations with me got for a list of users *******************/
+/*****************************************************************************/
+
+static void Usr_FreeRelationsWithMe (void)
+  {
+   if (Usr_RelationsWithMe.Lst)
+     {
+      free (Usr_RelationsWithMe.Lst);
+      Usr_RelationsWithMe.Lst = NULL;
+     }
+   Usr_RelationsWithMe.Num = 0;
+  }
+
 /*****************************************************************************/
 /********************** Allocate space for list of users *********************/
 /*****************************************************************************/
@@ -5610,11 +6158,20 @@ if (Gbl.Usrs.Me.Roles.LoggedRole == Rol_SYS_ADM)
 
 void Usr_FreeUsrsList (Rol_Role_t Role)
   {
+   unsigned NumUsr;
+
    if (Gbl.Usrs.LstUsrs[Role].NumUsrs)
      {
       /***** Free the list itself *****/
       if (Gbl.Usrs.LstUsrs[Role].Lst)
         {
+	 /* Free the IDs got for the whole list */
+	 for (NumUsr = 0;
+	      NumUsr < Gbl.Usrs.LstUsrs[Role].NumUsrs;
+	      NumUsr++)
+	    if (Gbl.Usrs.LstUsrs[Role].Lst[NumUsr].IDs.List)
+	       free (Gbl.Usrs.LstUsrs[Role].Lst[NumUsr].IDs.List);
+
          free (Gbl.Usrs.LstUsrs[Role].Lst);
          Gbl.Usrs.LstUsrs[Role].Lst = NULL;
         }
@@ -6672,6 +7229,10 @@ static void Usr_ListMainDataGsts (bool PutCheckBoxToSelectUsr)
       /***** Heading row with column names *****/
       Usr_WriteHeaderFieldsUsrDat (PutCheckBoxToSelectUsr);	// Columns for the data
 
+      /***** Get IDs and relations with me of all users at once *****/
+      Usr_GetListIDsOfUsrsInList (Rol_GST);
+      Usr_GetRelationsWithMeOfUsrsInList (Rol_GST);
+
       /***** Initialize structure with user's data *****/
       Usr_UsrDataConstructor (&UsrDat);
 
@@ -6684,7 +7245,7 @@ static void Usr_ListMainDataGsts (bool PutCheckBoxToSelectUsr)
          Usr_CopyBasicUsrDataFromList (&UsrDat,&Gbl.Usrs.LstUsrs[Rol_GST].Lst[NumUsr]);
 
 	 /* Get list of user's IDs */
-         ID_GetListIDsFromUsrCod (&UsrDat);
+         Usr_CopyListIDsFromList (&UsrDat,&Gbl.Usrs.LstUsrs[Rol_GST].Lst[NumUsr]);
 
          /* Show row for this guest */
 	 Usr_WriteRowUsrMainData (NumUsr + 1,&UsrDat,true,Rol_GST,
@@ -6742,6 +7303,10 @@ static void Usr_ListMainDataStds (bool PutCheckBoxToSelectUsr)
       /***** Heading row with column names *****/
       Usr_WriteHeaderFieldsUsrDat (PutCheckBoxToSelectUsr);	// Columns for the data
 
+      /***** Get IDs and relations with me of all users at once *****/
+      Usr_GetListIDsOfUsrsInList (Rol_STD);
+      Usr_GetRelationsWithMeOfUsrsInList (Rol_STD);
+
       /***** Initialize structure with user's data *****/
       Usr_UsrDataConstructor (&UsrDat);
 
@@ -6754,7 +7319,7 @@ static void Usr_ListMainDataStds (bool PutCheckBoxToSelectUsr)
          Usr_CopyBasicUsrDataFromList (&UsrDat,&Gbl.Usrs.LstUsrs[Rol_STD].Lst[NumUsr]);
 
 	 /* Get list of user's IDs */
-         ID_GetListIDsFromUsrCod (&UsrDat);
+         Usr_CopyListIDsFromList (&UsrDat,&Gbl.Usrs.LstUsrs[Rol_STD].Lst[NumUsr]);
 
          /* Show row for this student */
          Usr_WriteRowUsrMainData (NumUsr + 1,&UsrDat,
@@ -6814,6 +7379,10 @@ static void Usr_ListMainDataTchs (Rol_Role_t Role,
       /* End row */
       HTM_TR_End ();
 
+      /***** Get IDs and relations with me of all users at once *****/
+      Usr_GetListIDsOfUsrsInList (Role);
+      Usr_GetRelationsWithMeOfUsrsInList (Role);
+
       /***** Initialize structure with user's data *****/
       Usr_UsrDataConstructor (&UsrDat);
 
@@ -6826,7 +7395,7 @@ static void Usr_ListMainDataTchs (Rol_Role_t Role,
          Usr_CopyBasicUsrDataFromList (&UsrDat,&Gbl.Usrs.LstUsrs[Role].Lst[NumUsr]);
 
 	 /* Get list of user's IDs */
-         ID_GetListIDsFromUsrCod (&UsrDat);
+         Usr_CopyListIDsFromList (&UsrDat,&Gbl.Usrs.LstUsrs[Role].Lst[NumUsr]);
 
          /* Show row for this teacher */
 	 Usr_WriteRowUsrMainData (NumUsr + 1,&UsrDat,
@@ -6918,6 +7487,9 @@ void Usr_ListAllDataGsts (void)
       /* End row */
       HTM_TR_End ();
 
+      /***** Get relations with me of all users at once *****/
+      Usr_GetRelationsWithMeOfUsrsInList (Rol_GST);
+
       /***** Initialize structure with user's data *****/
       Usr_UsrDataConstructor (&UsrDat);
 
@@ -7118,6 +7690,9 @@ void Usr_ListAllDataStds (void)
       /* End row */
       HTM_TR_End ();
 
+      /***** Get relations with me of all users at once *****/
+      Usr_GetRelationsWithMeOfUsrsInList (Rol_STD);
+
       /***** Initialize structure with user's data *****/
       Usr_UsrDataConstructor (&UsrDat);
 
@@ -7181,6 +7756,9 @@ static void Usr_ListUsrsForSelection (Rol_Role_t Role,
       /***** Heading row with column names *****/
       Usr_WriteHeaderFieldsUsrDat (true);	// Columns for the data
 
+      /***** Get relations with me of all users at once *****/
+      Usr_GetRelationsWithMeOfUsrsInList (Role);
+
       /***** Initialize structure with user's data *****/
       Usr_UsrDataConstructor (&UsrDat);
 
@@ -7317,6 +7895,9 @@ static void Usr_ListRowsAllDataTchs (Rol_Role_t Role,
 
    HTM_TR_End ();
 
+   /***** Get relations with me of all users at once *****/
+   Usr_GetRelationsWithMeOfUsrsInList (Role);
+
    /***** Initialize structure with user's data *****/
    Usr_UsrDataConstructor (&UsrDat);
 
@@ -7384,6 +7965,10 @@ unsigned Usr_ListUsrsFound (Rol_Role_t Role,
       Gbl.Usrs.Listing.WithPhotos = true;
       Usr_WriteHeaderFieldsUsrDat (false);	// Columns for the data
 
+      /***** Get IDs and relations with me of all users at once *****/
+      Usr_GetListIDsOfUsrsInList (Role);
+      Usr_GetRelationsWithMeOfUsrsInList (Role);
+
       /***** Initialize structure with user's data *****/
       Usr_UsrDataConstructor (&UsrDat);
 
@@ -7398,7 +7983,7 @@ unsigned Usr_ListUsrsFound (Rol_Role_t Role,
          Usr_CopyBasicUsrDataFromList (&UsrDat,UsrInList);
 
 	 /* Get list of user's IDs */
-         ID_GetListIDsFromUsrCod (&UsrDat);
+         Usr_CopyListIDsFromList (&UsrDat,UsrInList);
 
 	 /* Write data of this user */
 	 Usr_WriteRowUsrMainData (NumUsr + 1,&UsrDat,false,Role,
@@ -9074,6 +9659,10 @@ static void Usr_DrawClassPhoto (Usr_ClassPhotoType_t ClassPhotoType,
       if (PutCheckBoxToSelectUsr)
 	 Usr_PutCheckboxToSelectAllUsers (Role,SelectedUsrs);
 
+      /***** Get IDs and relations with me of all users at once *****/
+      Usr_GetListIDsOfUsrsInList (Role);
+      Usr_GetRelationsWithMeOfUsrsInList (Role);
+
       /***** Initialize structure with user's data *****/
       Usr_UsrDataConstructor (&UsrDat);
 
@@ -9091,7 +9680,7 @@ static void Usr_DrawClassPhoto (Usr_ClassPhotoType_t ClassPhotoType,
 	 Usr_CopyBasicUsrDataFromList (&UsrDat,&Gbl.Usrs.LstUsrs[Role].Lst[NumUsr]);
 
 	 /* Get list of user's IDs */
-	 ID_GetListIDsFromUsrCod (&UsrDat);
+	 Usr_CopyListIDsFromList (&UsrDat,&Gbl.Usrs.LstUsrs[Role].Lst[NumUsr]);
 
 	 /***** Begin user's cell *****/
 	 if (ClassPhotoType == Usr_CLASS_PHOTO_SEL &&
@@ -257,6 +257,12 @@ struct UsrInList
    Rol_Role_t RoleInCurrentCrsDB;	// Role in current course in database
    bool Accepted;	// User has accepted joining to one/all courses?
    bool Remove;		// A boolean associated with each user that indicates if it must be removed
+   struct
+     {
+      bool Got;			// true ==> IDs of all users in list have been got at once
+      struct ListIDs *List;
+      unsigned Num;
+     } IDs;
   };
 
 struct ListUsrs
@@ -289,12 +295,17 @@ void Usr_UsrDataConstructor (struct UsrData *UsrDat);
 void Usr_ResetUsrDataExceptUsrCodAndIDs (struct UsrData *UsrDat);
 void Usr_ResetMyLastData (void);
 void Usr_UsrDataDestructor (struct UsrData *UsrDat);
+void Usr_AddMemOfUsrData (void *Ptr);
+void Usr_RemoveMemOfUsrData (void *Ptr);
+void Usr_FreeMemOfUsrDataNotFreed (void);
 void Usr_GetAllUsrDataFromUsrCod (struct UsrData *UsrDat,Usr_GetPrefs_t GetPrefs);
 void Usr_AllocateListUsrCods (struct ListUsrCods *ListUsrCods);
 void Usr_FreeListUsrCods (struct ListUsrCods *ListUsrCods);
 bool Usr_ItsMe (long UsrCod);
 void Usr_GetUsrCodFromEncryptedUsrCod (struct UsrData *UsrDat);
 void Usr_GetUsrDataFromUsrCod (struct UsrData *UsrDat,Usr_GetPrefs_t GetPrefs);
+void Usr_GetBasicDataOfUsrs (struct UsrData UsrDats[],unsigned NumUsrs);
+void Usr_GetUsrBasicDataFromRow (struct UsrData *UsrDat,MYSQL_ROW row);
 
 void Usr_BuildFullName (struct UsrData *UsrDat);
 
@@ -433,6 +444,9 @@ void Usr_DropTmpTableWithCandidateUsrs (void);
 void Usr_GetUnorderedStdsCodesInDeg (long DegCod);
 
 void Usr_CopyBasicUsrDataFromList (struct UsrData *UsrDat,const struct UsrInList *UsrInList);
+void Usr_GetListIDsOfUsrsInList (Rol_Role_t Role);
+void Usr_CopyListIDsFromList (struct UsrData *UsrDat,const struct UsrInList *UsrInList);
+void Usr_GetRelationsWithMeOfUsrsInList (Rol_Role_t Role);
 void Usr_FreeUsrsList (Rol_Role_t Role);
 
 bool Usr_GetIfShowBigList (unsigned NumUsrs,
@@ -0,0 +1,432 @@
+// swad_users_bench_main.c: main of swad_users_bench, queries and system calls to show a class photo
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <errno.h>		// For errno
+#include <linux/limits.h>	// For PATH_MAX
+#include <stdio.h>		// For fprintf, printf, snprintf
+#include <stdlib.h>		// For atoi, exit, malloc, free, mkdtemp
+#include <sys/stat.h>		// For stat
+#include <unistd.h>		// For symlink, unlink, rmdir
+
+#include "swad_bench.h"
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define UsB_ROLE_STD	3	// As Rol_STD
+#define UsB_ROLE_TCH	5	// As Rol_TCH
+
+#define UsB_CRS_PHOTO	1	// Course of the class photo, mine as teacher
+#define UsB_CRS_MINE	2	// Other course of mine, as teacher
+#define UsB_CRS_OTHER	3	// Course not mine
+
+#define UsB_MAX_BYTES_USR_CODS(NumUsrs) ((NumUsrs) * (10 + 1) + 1)
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+typedef enum
+  {
+   UsB_BEFORE,	// Queries, lstat and symlink for each user in the list
+   UsB_LIST,	// Queries for the whole list and only symlink for each user
+   UsB_NOW,	// Queries for the whole list and no system call for each user
+  } UsB_Version_t;
+#define UsB_NUM_VERSIONS 3
+
+/*****************************************************************************/
+/***************************** Private variables *****************************/
+/*****************************************************************************/
+
+static unsigned long UsB_NumSyscalls;	// System calls made building links to photos
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void UsB_CreateTables (unsigned NumStds);
+static double UsB_ShowClassPhotos (UsB_Version_t Version,unsigned NumStds,
+                                   unsigned NumPhotos,const char *Dir);
+static void UsB_GetDataOfOneUsr (unsigned UsrCod);
+static void UsB_GetDataOfAllUsrs (const char *UsrCods);
+static void UsB_FetchAllRows (MYSQL_RES *mysql_res);
+static void UsB_BuildLinkToPhoto (UsB_Version_t Version,const char *Dir,
+                                  unsigned UsrCod);
+static void UsB_RemoveLinks (const char *Dir,unsigned NumStds);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_users_bench <host> <user> <password> <database>
+                           <students> <photos>
+   A course with the given number of students is created,
+   and its class photo is shown the given number of times by a teacher,
+   getting the IDs of each student, if each student shares any course
+   with the teacher, and building the link to each student's photo:
+   1. several queries, a lstat and a symlink for each student,
+   2. a few queries for the whole list and a symlink for each student,
+   3. now: a few queries for the whole list and no system call,
+      since the public link is created when the photo is received.
+   The system calls made building links to photos in each class photo
+   are written, and the ones saved with respect to the first way.
+   For example:
+      swad_users_bench localhost swad_bench password swad_bench 1000 20
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumStds;
+   int NumPhotos;
+   char Dir[] = "/tmp/swad_users_bench_XXXXXX";
+   UsB_Version_t Version;
+   static const char *Txt[UsB_NUM_VERSIONS] =
+     {
+      [UsB_BEFORE] = "Class photo, queries for each user",
+      [UsB_LIST  ] = "Class photo, queries for whole list",
+      [UsB_NOW   ] = "Class photo, links created on reception",
+     };
+   double SyscallsPerPhoto[UsB_NUM_VERSIONS];
+
+   if (argc != 1 + Bch_NUM_ARGS_DB + 2 ||
+       (NumStds   = atoi (argv[1 + Bch_NUM_ARGS_DB    ])) <= 0 ||
+       (NumPhotos = atoi (argv[1 + Bch_NUM_ARGS_DB + 1])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s " Bch_USAGE_DB " <students> <photos>\n",
+	       argv[0]);
+      return 1;
+     }
+
+   /***** Directory for public links to photos *****/
+   if (mkdtemp (Dir) == NULL)
+     {
+      fprintf (stderr,"Can not create directory.\n");
+      return 1;
+     }
+
+   Bch_ConnectToDB (&argv[1]);
+   UsB_CreateTables ((unsigned) NumStds);
+
+   for (Version  = UsB_BEFORE;
+	Version <= UsB_NOW;
+	Version++)
+     {
+      UsB_RemoveLinks (Dir,(unsigned) NumStds);
+      UsB_NumSyscalls = 0;
+      Bch_WriteTime (Txt[Version],
+		     (unsigned long) NumPhotos,
+		     UsB_ShowClassPhotos (Version,(unsigned) NumStds,
+					  (unsigned) NumPhotos,Dir));
+
+      /***** System calls building links to photos *****/
+      SyscallsPerPhoto[Version] = (double) UsB_NumSyscalls / (double) NumPhotos;
+      printf ("%-48s %10.1f per class photo, %.1f saved\n",
+	      "   System calls in links to photos",
+	      SyscallsPerPhoto[Version],
+	      SyscallsPerPhoto[UsB_BEFORE] - SyscallsPerPhoto[Version]);
+     }
+
+   UsB_RemoveLinks (Dir,(unsigned) NumStds);
+   rmdir (Dir);
+   Bch_Query ("DROP TABLE IF EXISTS bench_usr_IDs,bench_crs_usr,bench_my_courses");
+   Bch_DisconnectFromDB ();
+   return 0;
+  }
+
+/*****************************************************************************/
+/************** Create tables similar to usr_IDs and crs_usr *****************/
+/*****************************************************************************/
+// Students have codes 1...NumStds; I am NumStds + 1
+// Half the students are also in other course of mine, a third in a course not mine
+
+static void UsB_CreateTables (unsigned NumStds)
+  {
+   unsigned UsrCod;
+   unsigned MyUsrCod = NumStds + 1;
+
+   Bch_Query ("DROP TABLE IF EXISTS bench_usr_IDs,bench_crs_usr,bench_my_courses");
+   Bch_Query ("CREATE TABLE bench_usr_IDs ("
+		 "UsrCod INT NOT NULL,"
+		 "UsrID CHAR(16) NOT NULL,"
+		 "Confirmed ENUM('N','Y') NOT NULL DEFAULT 'N',"
+	      "UNIQUE INDEX(UsrCod,UsrID),"
+	      "INDEX(UsrID))");
+   Bch_Query ("CREATE TABLE bench_crs_usr ("
+		 "CrsCod INT NOT NULL DEFAULT -1,"
+		 "UsrCod INT NOT NULL,"
+		 "Role TINYINT NOT NULL DEFAULT 0,"
+	      "UNIQUE INDEX(CrsCod,UsrCod),"
+	      "UNIQUE INDEX(UsrCod,CrsCod),"
+	      "INDEX(CrsCod,Role),"
+	      "INDEX(UsrCod,Role))");
+
+   for (UsrCod  = 1;
+	UsrCod <= NumStds;
+	UsrCod++)
+     {
+      /* IDs: all have a confirmed ID, some have also an unconfirmed one */
+      Bch_Query ("INSERT INTO bench_usr_IDs (UsrCod,UsrID,Confirmed)"
+		 " VALUES (%u,'%08u','Y')",
+		 UsrCod,UsrCod);
+      if (UsrCod % 4 == 0)
+	 Bch_Query ("INSERT INTO bench_usr_IDs (UsrCod,UsrID,Confirmed)"
+		    " VALUES (%u,'X%07u','N')",
+		    UsrCod,UsrCod);
+
+      /* Courses */
+      Bch_Query ("INSERT INTO bench_crs_usr (CrsCod,UsrCod,Role)"
+		 " VALUES (%u,%u,%u)",
+		 UsB_CRS_PHOTO,UsrCod,UsB_ROLE_STD);
+      if (UsrCod % 2 == 0)
+	 Bch_Query ("INSERT INTO bench_crs_usr (CrsCod,UsrCod,Role)"
+		    " VALUES (%u,%u,%u)",
+		    UsB_CRS_MINE,UsrCod,UsB_ROLE_STD);
+      if (UsrCod % 3 == 0)
+	 Bch_Query ("INSERT INTO bench_crs_usr (CrsCod,UsrCod,Role)"
+		    " VALUES (%u,%u,%u)",
+		    UsB_CRS_OTHER,UsrCod,UsB_ROLE_STD);
+     }
+
+   /***** Me, as teacher *****/
+   Bch_Query ("INSERT INTO bench_crs_usr (CrsCod,UsrCod,Role)"
+	      " VALUES (%u,%u,%u),(%u,%u,%u)",
+	      UsB_CRS_PHOTO,MyUsrCod,UsB_ROLE_TCH,
+	      UsB_CRS_MINE ,MyUsrCod,UsB_ROLE_TCH);
+
+   /***** Table with my courses, as my_courses_tmp *****/
+   Bch_Query ("CREATE TABLE bench_my_courses "
+	      "(CrsCod INT NOT NULL,"
+	      "Role TINYINT NOT NULL,"
+	      "UNIQUE INDEX(CrsCod,Role)) ENGINE=MEMORY"
+	      " SELECT CrsCod,Role FROM bench_crs_usr WHERE UsrCod=%u",
+	      MyUsrCod);
+  }
+
+/*****************************************************************************/
+/************ Show the class photo several times and return time *************/
+/*****************************************************************************/
+
+static double UsB_ShowClassPhotos (UsB_Version_t Version,unsigned NumStds,
+                                   unsigned NumPhotos,const char *Dir)
+  {
+   unsigned NumPhoto;
+   unsigned UsrCod;
+   char *UsrCods;
+   char *Ptr;
+   MYSQL_RES *mysql_res;
+   double Start = Bch_GetSeconds ();
+
+   for (NumPhoto = 0;
+	NumPhoto < NumPhotos;
+	NumPhoto++)
+     {
+      /***** Get list of students *****/
+      Bch_QuerySELECT (&mysql_res,
+		       "SELECT UsrCod FROM bench_crs_usr"
+		       " WHERE CrsCod=%u AND Role=%u"
+		       " ORDER BY UsrCod",
+		       UsB_CRS_PHOTO,UsB_ROLE_STD);
+      UsB_FetchAllRows (mysql_res);
+
+      /***** Get data of all students in the list at once *****/
+      if (Version != UsB_BEFORE)
+	{
+	 if ((UsrCods = (char *) malloc (UsB_MAX_BYTES_USR_CODS (NumStds))) == NULL)
+	   {
+	    fprintf (stderr,"Not enough memory.\n");
+	    exit (1);
+	   }
+	 for (UsrCod = 1, Ptr = UsrCods;
+	      UsrCod <= NumStds;
+	      UsrCod++)
+	    Ptr += sprintf (Ptr,UsrCod == 1 ? "%u" :
+					      ",%u",
+			    UsrCod);
+	 UsB_GetDataOfAllUsrs (UsrCods);
+	 free (UsrCods);
+	}
+
+      /***** Show each student *****/
+      for (UsrCod  = 1;
+	   UsrCod <= NumStds;
+	   UsrCod++)
+	{
+	 if (Version == UsB_BEFORE)
+	    UsB_GetDataOfOneUsr (UsrCod);
+	 UsB_BuildLinkToPhoto (Version,Dir,UsrCod);
+	}
+     }
+
+   return Bch_GetSeconds () - Start;
+  }
+
+/*****************************************************************************/
+/*************** Get IDs and relations with me of one user *******************/
+/*****************************************************************************/
+
+static void UsB_GetDataOfOneUsr (unsigned UsrCod)
+  {
+   MYSQL_RES *mysql_res;
+
+   /***** IDs *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT UsrID,Confirmed FROM bench_usr_IDs"
+		    " WHERE UsrCod=%u"
+		    " ORDER BY Confirmed DESC,UsrID",
+		    UsrCod);
+   UsB_FetchAllRows (mysql_res);
+
+   /***** Roles in all courses *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT DISTINCT(Role) FROM bench_crs_usr"
+		    " WHERE UsrCod=%u",
+		    UsrCod);
+   UsB_FetchAllRows (mysql_res);
+
+   /***** Shares any course with me? *****/
+   Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_crs_usr"
+		   " WHERE UsrCod=%u"
+		   " AND CrsCod IN (SELECT CrsCod FROM bench_my_courses)",
+		   UsrCod);
+
+   /***** Shares any course with me with a different role? *****/
+   Bch_Query ("DROP TEMPORARY TABLE IF EXISTS bench_usr_courses_tmp");
+   Bch_Query ("CREATE TEMPORARY TABLE IF NOT EXISTS bench_usr_courses_tmp "
+	      "(CrsCod INT NOT NULL,Role TINYINT NOT NULL,"
+	      "UNIQUE INDEX(CrsCod,Role)) ENGINE=MEMORY"
+	      " SELECT CrsCod,Role FROM bench_crs_usr WHERE UsrCod=%u",
+	      UsrCod);
+   Bch_QueryCOUNT ("SELECT COUNT(*) FROM bench_my_courses,bench_usr_courses_tmp"
+		   " WHERE bench_my_courses.CrsCod=bench_usr_courses_tmp.CrsCod"
+		   " AND bench_my_courses.Role<>bench_usr_courses_tmp.Role");
+   Bch_Query ("DROP TEMPORARY TABLE IF EXISTS bench_usr_courses_tmp");
+  }
+
+/*****************************************************************************/
+/************ Get IDs and relations with me of all users at once *************/
+/*****************************************************************************/
+
+static void UsB_GetDataOfAllUsrs (const char *UsrCods)
+  {
+   MYSQL_RES *mysql_res;
+
+   /***** IDs *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT UsrCod,UsrID,Confirmed FROM bench_usr_IDs"
+		    " WHERE UsrCod IN (%s)"
+		    " ORDER BY UsrCod,Confirmed DESC,UsrID",
+		    UsrCods);
+   UsB_FetchAllRows (mysql_res);
+
+   /***** Users who share any course with me *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT DISTINCT UsrCod FROM bench_crs_usr"
+		    " WHERE UsrCod IN (%s)"
+		    " AND CrsCod IN (SELECT CrsCod FROM bench_my_courses)",
+		    UsrCods);
+   UsB_FetchAllRows (mysql_res);
+
+   /***** Users who share any course with me with a different role *****/
+   Bch_QuerySELECT (&mysql_res,
+		    "SELECT DISTINCT bench_crs_usr.UsrCod"
+		    " FROM bench_crs_usr,bench_my_courses"
+		    " WHERE bench_crs_usr.UsrCod IN (%s)"
+		    " AND bench_crs_usr.CrsCod=bench_my_courses.CrsCod"
+		    " AND bench_crs_usr.Role<>bench_my_courses.Role",
+		    UsrCods);
+   UsB_FetchAllRows (mysql_res);
+  }
+
+/*****************************************************************************/
+/********************* Fetch all rows and free result ************************/
+/*****************************************************************************/
+
+static void UsB_FetchAllRows (MYSQL_RES *mysql_res)
+  {
+   while (mysql_fetch_row (mysql_res));
+   mysql_free_result (mysql_res);
+  }
+
+/*****************************************************************************/
+/******************* Build the link to photo of a user ***********************/
+/*****************************************************************************/
+// The private photo does not need to exist
+
+static void UsB_BuildLinkToPhoto (UsB_Version_t Version,const char *Dir,
+                                  unsigned UsrCod)
+  {
+   char PathPubl[PATH_MAX + 1];
+   struct stat FileStatus;
+
+   snprintf (PathPubl,sizeof (PathPubl),"%s/%u.jpg",Dir,UsrCod);
+   switch (Version)
+     {
+      case UsB_BEFORE:	// Check if link exists, then create it
+	 UsB_NumSyscalls++;
+	 if (lstat (PathPubl,&FileStatus))
+	   {
+	    UsB_NumSyscalls++;
+	    if (symlink ("/nonexistent/photo.jpg",PathPubl))
+	      {
+	       fprintf (stderr,"Can not create link.\n");
+	       exit (1);
+	      }
+	   }
+	 break;
+      case UsB_LIST:	// Create it, ignoring if it exists
+	 UsB_NumSyscalls++;
+	 if (symlink ("/nonexistent/photo.jpg",PathPubl))
+	    if (errno != EEXIST)
+	      {
+	       fprintf (stderr,"Can not create link.\n");
+	       exit (1);
+	      }
+	 break;
+      case UsB_NOW:	// Link was created on reception, only the URL is built
+      default:
+	 break;
+     }
+  }
+
+/*****************************************************************************/
+/******************* Remove public links to photos ***************************/
+/*****************************************************************************/
+
+static void UsB_RemoveLinks (const char *Dir,unsigned NumStds)
+  {
+   char PathPubl[PATH_MAX + 1];
+   unsigned UsrCod;
+
+   for (UsrCod  = 1;
+	UsrCod <= NumStds;
+	UsrCod++)
+     {
+      snprintf (PathPubl,sizeof (PathPubl),"%s/%u.jpg",Dir,UsrCod);
+      unlink (PathPubl);
+     }
+  }
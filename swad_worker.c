@@ -0,0 +1,288 @@
+// swad_worker.c: persistent FastCGI worker serving many requests
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/********************************* Headers ***********************************/
+/*****************************************************************************/
+
+#define _GNU_SOURCE 		// For fopencookie
+#include <fcgiapp.h>		// For FastCGI
+#include <setjmp.h>		// For setjmp, longjmp
+#include <stdio.h>		// For fopencookie
+#include <stdlib.h>		// For exit
+
+#include "swad_config.h"
+#include "swad_database.h"
+#include "swad_global.h"
+#include "swad_parameter.h"
+#include "swad_user.h"
+#include "swad_worker.h"
+
+/*****************************************************************************/
+/************** External global variables from others modules ****************/
+/*****************************************************************************/
+
+extern char **environ;
+
+/*****************************************************************************/
+/***************************** Private constants *****************************/
+/*****************************************************************************/
+
+/*****************************************************************************/
+/******************************* Private types *******************************/
+/*****************************************************************************/
+
+/*****************************************************************************/
+/***************************** Private variables *****************************/
+/*****************************************************************************/
+
+static struct
+  {
+   bool IsPersistent;		// false ==> classic CGI, one process per request
+				// true  ==> persistent FastCGI worker or resident program
+   bool IsDaemon;		// true ==> resident program without HTML output
+   unsigned long NumRequests;	// Number of requests served by this process
+   jmp_buf EndOfRequest;	// Where to go back when a request ends
+   struct
+     {
+      FCGX_Stream *In;
+      FCGX_Stream *Out;
+      FCGX_Stream *Err;
+      FCGX_ParamArray Env;
+     } FCGX;
+   struct
+     {
+      FILE *Stdin;
+      FILE *Stdout;
+      char **Environ;
+     } Saved;			// Standard streams and environment of the process
+  } Wrk_Gbl =
+  {
+   .IsPersistent = false,
+   .IsDaemon     = false,
+   .NumRequests  = 0,
+  };
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void Wrk_RedirectStdStreamsToRequest (void);
+static void Wrk_RestoreStdStreams (void);
+
+static ssize_t Wrk_ReadFromRequest (void *Cookie,char *Buf,size_t Size);
+static ssize_t Wrk_WriteToRequest (void *Cookie,const char *Buf,size_t Size);
+
+/*****************************************************************************/
+/************************** Serve incoming requests **************************/
+/*****************************************************************************/
+/*
+   When this program is launched by the web server as a classic CGI,
+   only one request is served and the process exits at the end of it.
+   When it is launched as a FastCGI application
+   (for example by Apache mod_fcgid), the same process serves
+   up to Cfg_MAX_REQUESTS_PER_WORKER requests,
+   so the config file is read and the database connection is opened only once.
+*/
+void Wrk_ServeRequests (void (*ServeRequest) (void))
+  {
+   /***** Classic CGI *****/
+   if (FCGX_IsCGI ())
+     {
+      ServeRequest ();	// Exits at the end of the request
+      exit (0);
+     }
+
+   /***** Persistent FastCGI worker *****/
+   Wrk_Gbl.IsPersistent = true;
+   Wrk_Gbl.Saved.Stdin   = stdin;
+   Wrk_Gbl.Saved.Stdout  = stdout;
+   Wrk_Gbl.Saved.Environ = environ;
+
+   while (Wrk_Gbl.NumRequests < Cfg_MAX_REQUESTS_PER_WORKER &&
+	  FCGX_Accept (&Wrk_Gbl.FCGX.In,
+		       &Wrk_Gbl.FCGX.Out,
+		       &Wrk_Gbl.FCGX.Err,
+		       &Wrk_Gbl.FCGX.Env) >= 0)
+     {
+      /***** Make stdin, stdout and environment
+	     point to the current request *****/
+      Wrk_RedirectStdStreamsToRequest ();
+
+      /***** Serve the request.
+	     Wrk_EndRequest() jumps back here *****/
+      if (!setjmp (Wrk_Gbl.EndOfRequest))
+	 ServeRequest ();
+
+      /***** Free parameters and users' data, if not already freed,
+	     when the request ended abruptly (firewall, lock, error...) *****/
+      Par_FreeParams ();
+      Usr_FreeMemOfUsrDataNotFreed ();
+
+      /***** Send all the output and finish the request *****/
+      Wrk_RestoreStdStreams ();
+      FCGX_Finish ();
+
+      Wrk_Gbl.NumRequests++;
+     }
+
+   /***** Close database connection and exit.
+	  The web server will launch a new worker if necessary *****/
+   DB_CloseDBConnection ();
+   exit (0);
+  }
+
+/*****************************************************************************/
+/****************** Run a job of a resident program (daemon) *****************/
+/*****************************************************************************/
+// If the job ends with an error, Lay_ShowErrorAndExit() writes it
+// to standard error and Wrk_EndRequest() jumps back here,
+// so the daemon can go on instead of exiting.
+// Return false if the job ended with an error
+
+bool Wrk_RunJob (void (*Job) (void))
+  {
+   Wrk_Gbl.IsPersistent = true;	// Database connection is kept between jobs
+   Wrk_Gbl.IsDaemon     = true;
+
+   if (setjmp (Wrk_Gbl.EndOfRequest))
+     {
+      /***** Free users' data not freed because the job ended abruptly *****/
+      Usr_FreeMemOfUsrDataNotFreed ();
+      return false;
+     }
+
+   Job ();
+   return true;
+  }
+
+/*****************************************************************************/
+/********* Check if this process is a persistent FastCGI worker **************/
+/*****************************************************************************/
+
+bool Wrk_IsPersistent (void)
+  {
+   return Wrk_Gbl.IsPersistent;
+  }
+
+/*****************************************************************************/
+/********* Check if this process is a resident program without HTML **********/
+/*****************************************************************************/
+
+bool Wrk_IsDaemon (void)
+  {
+   return Wrk_Gbl.IsDaemon;
+  }
+
+/*****************************************************************************/
+/************ Get number of requests already served by this process **********/
+/*****************************************************************************/
+
+unsigned long Wrk_GetNumRequestsServed (void)
+  {
+   return Wrk_Gbl.NumRequests;
+  }
+
+/*****************************************************************************/
+/************************** End the current request **************************/
+/*****************************************************************************/
+// Classic CGI: close database connection and exit
+// Persistent worker: keep database connection open and go on with next request
+
+void Wrk_EndRequest (void)
+  {
+   if (Wrk_Gbl.IsPersistent)
+      longjmp (Wrk_Gbl.EndOfRequest,1);
+
+   DB_CloseDBConnection ();
+   exit (0);
+  }
+
+/*****************************************************************************/
+/********* Make stdin, stdout and environment point to FastCGI request *******/
+/*****************************************************************************/
+// In GNU C library, stdin and stdout are normal variables that can be set,
+// so the rest of the program reads and writes them as in a classic CGI
+
+static void Wrk_RedirectStdStreamsToRequest (void)
+  {
+   cookie_io_functions_t InFunctions =
+     {
+      .read  = Wrk_ReadFromRequest,
+      .write = NULL,
+      .seek  = NULL,
+      .close = NULL,
+     };
+   cookie_io_functions_t OutFunctions =
+     {
+      .read  = NULL,
+      .write = Wrk_WriteToRequest,
+      .seek  = NULL,
+      .close = NULL,
+     };
+
+   environ = Wrk_Gbl.FCGX.Env;
+   if ((stdin  = fopencookie (Wrk_Gbl.FCGX.In ,"r",InFunctions )) == NULL ||
+       (stdout = fopencookie (Wrk_Gbl.FCGX.Out,"w",OutFunctions)) == NULL)
+     {
+      Wrk_RestoreStdStreams ();
+      exit (1);
+     }
+  }
+
+/*****************************************************************************/
+/**************** Restore original stdin, stdout and environment *************/
+/*****************************************************************************/
+
+static void Wrk_RestoreStdStreams (void)
+  {
+   if (stdin != Wrk_Gbl.Saved.Stdin)
+     {
+      fclose (stdin);
+      stdin = Wrk_Gbl.Saved.Stdin;
+     }
+   if (stdout != Wrk_Gbl.Saved.Stdout)
+     {
+      fclose (stdout);	// Flush pending output to FastCGI stream
+      stdout = Wrk_Gbl.Saved.Stdout;
+     }
+   environ = Wrk_Gbl.Saved.Environ;
+  }
+
+/*****************************************************************************/
+/********************** Read from/write to FastCGI streams *******************/
+/*****************************************************************************/
+
+static ssize_t Wrk_ReadFromRequest (void *Cookie,char *Buf,size_t Size)
+  {
+   return (ssize_t) FCGX_GetStr (Buf,(int) Size,(FCGX_Stream *) Cookie);
+  }
+
+static ssize_t Wrk_WriteToRequest (void *Cookie,const char *Buf,size_t Size)
+  {
+   int NumBytesWritten;
+
+   if ((NumBytesWritten = FCGX_PutStr (Buf,(int) Size,(FCGX_Stream *) Cookie)) < 0)
+      return 0;	// Error
+   return (ssize_t) NumBytesWritten;
+  }
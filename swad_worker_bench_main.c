@@ -0,0 +1,223 @@
+// swad_worker_bench_main.c: main of swad_worker_bench, requests per second served by swad
+
+/*
+    SWAD (Shared Workspace At a Distance),
+    is a web platform developed at the University of Granada (Spain),
+    and used to support university teaching.
+
+    This file is part of SWAD core.
+    Copyright (C) 1999-2020 Antonio Caas Vargas
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*****************************************************************************/
+/*********************************** Headers *********************************/
+/*****************************************************************************/
+
+#include <netdb.h>		// For getaddrinfo
+#include <stdbool.h>		// For boolean type
+#include <stdio.h>		// For printf, snprintf
+#include <stdlib.h>		// For atoi, exit
+#include <string.h>		// For strlen, strncmp
+#include <sys/socket.h>		// For socket, connect
+#include <sys/time.h>		// For gettimeofday
+#include <sys/wait.h>		// For wait
+#include <unistd.h>		// For fork, read, write, close
+
+/*****************************************************************************/
+/******************************** Constants **********************************/
+/*****************************************************************************/
+
+#define WrB_MAX_BYTES_REQUEST	(4 * 1024 - 1)
+
+/*****************************************************************************/
+/***************************** Private prototypes ****************************/
+/*****************************************************************************/
+
+static void WrB_RunClients (const char *Host,const char *Port,const char *Path,
+                            unsigned NumClients,unsigned NumRequestsPerClient);
+static unsigned WrB_RunOneClient (const char *Host,const char *Port,const char *Path,
+                                  unsigned NumRequests);
+static bool WrB_MakeRequest (const struct addrinfo *Addr,const char *Request);
+static double WrB_GetSeconds (void);
+
+/*****************************************************************************/
+/****************************** Main function ********************************/
+/*****************************************************************************/
+/*
+   Usage: swad_worker_bench <host> <port> <path> <clients> <requests per client>
+   The given number of clients (processes) request the given path at the same time.
+   Run it once against the classic CGI and once against the FastCGI worker
+   configured in the web server, for example:
+      swad_worker_bench localhost 80 "/swad/?act=1" 20 500
+      swad_worker_bench localhost 80 "/swad.fcgi/?act=1" 20 500
+*/
+
+int main (int argc,char *argv[])
+  {
+   int NumClients;
+   int NumRequestsPerClient;
+
+   if (argc != 6 ||
+       (NumClients           = atoi (argv[4])) <= 0 ||
+       (NumRequestsPerClient = atoi (argv[5])) <= 0)
+     {
+      fprintf (stderr,"Usage: %s <host> <port> <path> <clients> <requests per client>\n",
+	       argv[0]);
+      return 1;
+     }
+
+   WrB_RunClients (argv[1],argv[2],argv[3],
+		   (unsigned) NumClients,(unsigned) NumRequestsPerClient);
+   return 0;
+  }
+
+/*****************************************************************************/
+/************ Run several clients at the same time and write rate ************/
+/*****************************************************************************/
+
+static void WrB_RunClients (const char *Host,const char *Port,const char *Path,
+                            unsigned NumClients,unsigned NumRequestsPerClient)
+  {
+   unsigned NumClient;
+   int Pipe[2];
+   unsigned NumRequestsOKInClient;
+   unsigned long NumRequestsOK = 0;
+   double Start;
+   double Seconds;
+
+   /***** Each client writes in this pipe
+          the number of requests served OK *****/
+   if (pipe (Pipe))
+     {
+      fprintf (stderr,"Can not create pipe.\n");
+      exit (1);
+     }
+
+   Start = WrB_GetSeconds ();
+
+   /***** Launch clients *****/
+   for (NumClient = 0;
+	NumClient < NumClients;
+	NumClient++)
+      switch (fork ())
+	{
+	 case -1:
+	    fprintf (stderr,"Can not create client process.\n");
+	    exit (1);
+	 case 0:	// Child
+	    close (Pipe[0]);
+	    NumRequestsOKInClient = WrB_RunOneClient (Host,Port,Path,NumRequestsPerClient);
+	    if (write (Pipe[1],&NumRequestsOKInClient,sizeof (NumRequestsOKInClient)) !=
+		(ssize_t) sizeof (NumRequestsOKInClient))
+	       exit (1);
+	    exit (0);
+	 default:	// Parent
+	    break;
+	}
+
+   /***** Wait for all clients *****/
+   close (Pipe[1]);
+   while (read (Pipe[0],&NumRequestsOKInClient,sizeof (NumRequestsOKInClient)) ==
+	  (ssize_t) sizeof (NumRequestsOKInClient))
+      NumRequestsOK += NumRequestsOKInClient;
+   close (Pipe[0]);
+   while (wait (NULL) > 0);
+
+   Seconds = WrB_GetSeconds () - Start;
+
+   /***** Write results *****/
+   printf ("%u clients x %u requests: %lu OK in %.2f s, %.1f requests/s\n",
+	   NumClients,NumRequestsPerClient,NumRequestsOK,Seconds,
+	   Seconds > 0.0 ? (double) NumRequestsOK / Seconds :
+			   0.0);
+  }
+
+/*****************************************************************************/
+/*************** Make several requests, one after another *******************/
+/*****************************************************************************/
+// Return the number of requests answered with status 200
+
+static unsigned WrB_RunOneClient (const char *Host,const char *Port,const char *Path,
+                                  unsigned NumRequests)
+  {
+   struct addrinfo Hints;
+   struct addrinfo *Addr;
+   char Request[WrB_MAX_BYTES_REQUEST + 1];
+   unsigned NumRequest;
+   unsigned NumRequestsOK = 0;
+
+   memset (&Hints,0,sizeof (Hints));
+   Hints.ai_family   = AF_UNSPEC;
+   Hints.ai_socktype = SOCK_STREAM;
+   if (getaddrinfo (Host,Port,&Hints,&Addr))
+      return 0;
+
+   snprintf (Request,sizeof (Request),
+	     "GET %s HTTP/1.0\r\n"
+	     "Host: %s\r\n"
+	     "User-Agent: swad_worker_bench\r\n"
+	     "\r\n",
+	     Path,Host);
+
+   for (NumRequest = 0;
+	NumRequest < NumRequests;
+	NumRequest++)
+      if (WrB_MakeRequest (Addr,Request))
+	 NumRequestsOK++;
+
+   freeaddrinfo (Addr);
+   return NumRequestsOK;
+  }
+
+/*****************************************************************************/
+/****************** Make a request and read all the response *****************/
+/*****************************************************************************/
+
+static bool WrB_MakeRequest (const struct addrinfo *Addr,const char *Request)
+  {
+   int Sock;
+   char Buffer[64 * 1024];
+   ssize_t NumBytes;
+   bool FirstBlock = true;
+   bool OK = false;
+
+   if ((Sock = socket (Addr->ai_family,Addr->ai_socktype,Addr->ai_protocol)) < 0)
+      return false;
+   if (connect (Sock,Addr->ai_addr,Addr->ai_addrlen) == 0 &&
+       write (Sock,Request,strlen (Request)) == (ssize_t) strlen (Request))
+      while ((NumBytes = read (Sock,Buffer,sizeof (Buffer) - 1)) > 0)
+	 if (FirstBlock)
+	   {
+	    Buffer[NumBytes] = '\0';
+	    OK = (strncmp (Buffer,"HTTP/1.",7) == 0 &&
+		  strncmp (Buffer + 8," 200",4) == 0);
+	    FirstBlock = false;
+	   }
+   close (Sock);
+
+   return OK;
+  }
+
+/*****************************************************************************/
+/************************ Get current time in seconds ************************/
+/*****************************************************************************/
+
+static double WrB_GetSeconds (void)
+  {
+   struct timeval Now;
+
+   gettimeofday (&Now,NULL);
+   return (double) Now.tv_sec + (double) Now.tv_usec / 1E6;
+  }
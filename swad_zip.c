@@ -26,13 +26,14 @@
 /*****************************************************************************/
 
 #include <dirent.h>		// For scandir, etc.
-#include <errno.h>		// For errno
 #include <linux/limits.h>	// For PATH_MAX
-#include <stdlib.h>		// For system...
+#include <stdio.h>		// For FILE, fopen...
+#include <stdlib.h>		// For malloc, realloc, free...
 #include <string.h>		// For string functions...
-#include <sys/stat.h>		// For mkdir...
-#include <sys/types.h>		// For mkdir...
-#include <unistd.h>		// For chdir...
+#include <sys/stat.h>		// For lstat...
+#include <sys/types.h>		// For off_t...
+#include <time.h>		// For localtime_r
+#include <zlib.h>		// For deflate, crc32
 
 #include "swad_box.h"
 #include "swad_config.h"
@@ -56,10 +57,58 @@
 #define ZIP_MiB (1024ULL * 1024ULL)
 #define ZIP_MAX_SIZE_UNCOMPRESSED (1024ULL * ZIP_MiB)
 
+#define ZIP_MAX_ENTRIES		0xFFFF		// ZIP files are written without ZIP64 extensions
+#define ZIP_NUM_BYTES_BUFFER	(64 * 1024)	// Size of buffers used to read and compress files
+
+/* Fields of ZIP file format (APPNOTE.TXT from PKWARE) */
+#define ZIP_LOCAL_FILE_HEADER_SIGNATURE		0x04034B50UL
+#define ZIP_CENTRAL_DIR_HEADER_SIGNATURE	0x02014B50UL
+#define ZIP_END_OF_CENTRAL_DIR_SIGNATURE	0x06054B50UL
+
+#define ZIP_VERSION_MADE_BY			((3 << 8) | 20)	// Unix, version 2.0
+#define ZIP_VERSION_NEEDED_TO_EXTRACT		20		// Version 2.0: folders and deflate
+
+#define ZIP_METHOD_STORE			0
+#define ZIP_METHOD_DEFLATE			8
+
+#define ZIP_OFFSET_CRC_IN_LOCAL_HEADER		14
+
+/* Extensions of files already compressed, stored without compression */
+static const char *ZIP_ExtensionsStored[] =
+  {
+   "7z","bz2","gz","rar","tgz","xz","zip",	// Archives
+   "gif","jpeg","jpg","png","webp",		// Images
+   "avi","flac","m4a","m4v","mkv","mov",	// Audio and video
+   "mp3","mp4","ogg","ogv","webm",
+   "docx","epub","odp","ods","odt",		// Documents zipped inside
+   "pptx","xlsx",
+  };
+#define ZIP_NUM_EXTENSIONS_STORED (sizeof (ZIP_ExtensionsStored) / sizeof (ZIP_ExtensionsStored[0]))
+
 /*****************************************************************************/
 /******************************* Private types *******************************/
 /*****************************************************************************/
 
+struct ZIP_Entry
+  {
+   char *Name;			// Path inside the archive. Names of folders end in '/'
+   char *Path;			// Path of the file in disk, or NULL for folders
+   time_t MTime;		// Time of last modification
+   unsigned Method;		// ZIP_METHOD_STORE or ZIP_METHOD_DEFLATE
+   unsigned long CRC;		// CRC-32 of uncompressed data
+   unsigned long CompressedSize;
+   unsigned long UncompressedSize;
+   unsigned long Offset;	// Offset of local header inside the archive
+  };
+
+struct ZIP_Archive
+  {
+   unsigned NumEntries;
+   unsigned MaxEntries;		// Number of entries allocated
+   struct ZIP_Entry *Entries;
+   unsigned long long UncompressedSize;	// Size of all the files to compress
+  };
+
 /*****************************************************************************/
 /************** External global variables from others modules ****************/
 /*****************************************************************************/
@@ -76,11 +125,32 @@ extern struct Globals Gbl;
 
 static void ZIP_PutLinkToCreateZIPAsgWrkParams (void);
 
-static void ZIP_CreateTmpDirForCompression (void);
-static void ZIP_CreateDirCompressionUsr (struct UsrData *UsrDat);
+static void ZIP_AddUsrWorksToArchive (struct ZIP_Archive *Zip,
+                                      struct UsrData *UsrDat);
+static bool ZIP_CheckIfFolderIsInArchive (const struct ZIP_Archive *Zip,
+                                          const char *FolderName);
 
 static void ZIP_CompressFolderIntoZIP (void);
-static unsigned long long ZIP_CloneDir (const char *Path,const char *PathClone,const char *PathInTree);
+static void ZIP_InitArchive (struct ZIP_Archive *Zip);
+static void ZIP_AddDirToArchive (struct ZIP_Archive *Zip,
+                                 const char *Path,const char *NameInZip,
+                                 const char *PathInTree);
+static void ZIP_AddEntryToArchive (struct ZIP_Archive *Zip,
+                                   const char *Name,const char *Path,
+                                   const struct stat *FileStatus);
+static void ZIP_FreeArchive (struct ZIP_Archive *Zip);
+
+static bool ZIP_WriteArchive (struct ZIP_Archive *Zip,const char *PathFileZIP);
+static bool ZIP_WriteEntryData (FILE *FileZIP,struct ZIP_Entry *Entry);
+static bool ZIP_DeflateFile (FILE *FileZIP,FILE *FileSrc,struct ZIP_Entry *Entry);
+static bool ZIP_StoreFile (FILE *FileZIP,FILE *FileSrc,struct ZIP_Entry *Entry);
+static bool ZIP_CheckIfFileIsAlreadyCompressed (const char *Name);
+static void ZIP_WriteHeader (FILE *FileZIP,const struct ZIP_Entry *Entry,
+                             bool CentralDir);
+static void ZIP_WriteDOSTime (FILE *FileZIP,time_t Time);
+static void ZIP_WriteUint16 (FILE *FileZIP,unsigned Value);
+static void ZIP_WriteUint32 (FILE *FileZIP,unsigned long Value);
+
 static void ZIP_ShowLinkToDownloadZIP (const char *FileName,const char *URL,
                                        off_t FileSize,unsigned long long UncompressedSize);
 
@@ -122,31 +192,24 @@ bool ZIP_GetCreateZIPFromForm (void)
 void ZIP_CreateZIPAsgWrk (void)
   {
    extern const char *Txt_works_ZIP_FILE_NAME;
+   extern const char *Txt_The_contents_of_the_folder_are_too_big;
+   struct ZIP_Archive Zip;
    struct UsrData UsrDat;
    const char *Ptr;
-   char StrZip[128 + PATH_MAX];
-   char Path[PATH_MAX + 1 +
-             NAME_MAX + 1 +
-	     NAME_MAX + 1];
-   int Result;
    char FileNameZIP[NAME_MAX + 1];
    char PathFileZIP[PATH_MAX + 1];
    struct stat FileStatus;
    char URLWithSpaces[PATH_MAX + 1];
    char URL[PATH_MAX + 1];
 
-   /***** Create zip file
-	  with the assignments and works
-	  of the selected users *****/
-   /* Create temporary directory
-      for the compression of assignments and works */
-   ZIP_CreateTmpDirForCompression ();
+   /***** Get the list of files to compress:
+	  the assignments and works of the selected users *****/
+   ZIP_InitArchive (&Zip);
 
    /* Initialize structure with user's data */
    Usr_UsrDataConstructor (&UsrDat);
 
-   /* Create temporary directory for each selected user
-      inside the directory used for compression */
+   /* Add a folder for each selected user */
    Ptr = Gbl.Usrs.Selected.List[Rol_UNK];
    while (*Ptr)
      {
@@ -157,113 +220,81 @@ void ZIP_CreateZIPAsgWrk (void)
 
       if (Usr_ChkUsrCodAndGetAllUsrDataFromUsrCod (&UsrDat,Usr_DONT_GET_PREFS))	// Get user's data from database
 	 if (Usr_CheckIfUsrBelongsToCurrentCrs (&UsrDat))
-	    ZIP_CreateDirCompressionUsr (&UsrDat);
+	    ZIP_AddUsrWorksToArchive (&Zip,&UsrDat);
      }
 
    /* Free memory used for user's data */
    Usr_UsrDataDestructor (&UsrDat);
 
-   /***** Create a temporary public directory
-          used to download the zip file *****/
-   Brw_CreateDirDownloadTmp ();
-
-   /***** Relative path of the directory with the works to compress *****/
-   snprintf (Path,sizeof (Path),
-	     "%s/%s",
-	     Cfg_PATH_ZIP_PRIVATE,
-	     Gbl.FileBrowser.ZIP.TmpDir);
-
-   /***** Change to directory of the assignments and works
-          in order to start the path in the zip file from there *****/
-   if (chdir (Path))
-      Lay_ShowErrorAndExit ("Can not change to temporary folder for compression.");
-
-   /***** Create public zip file with the assignment and works *****/
-   snprintf (FileNameZIP,sizeof (FileNameZIP),
-	     "%s.zip",
-	     Txt_works_ZIP_FILE_NAME);
-   snprintf (PathFileZIP,sizeof (PathFileZIP),
-	     "%s/%s/%s/%s",
-	     Cfg_PATH_FILE_BROWSER_TMP_PUBLIC,
-             Gbl.FileBrowser.TmpPubDir.L,
-             Gbl.FileBrowser.TmpPubDir.R,
-             FileNameZIP);
-   snprintf (StrZip,sizeof (StrZip),
-	     "nice -n 19 zip -q -r '%s' *",
-             PathFileZIP);
-   Result = system (StrZip);
-
-   /***** Return to the CGI directory *****/
-   if (chdir (Cfg_PATH_CGI_BIN))
-      Lay_ShowErrorAndExit ("Can not change to cgi-bin folder.");
-
-   /***** If the zip command has been sucessful, write the link to zip file *****/
-   if (Result == 0)
-     {
-      /***** Get file size *****/
-      if (lstat (PathFileZIP,&FileStatus))	// On success ==> 0 is returned
-	 Lay_ShowErrorAndExit ("Can not get information about a file or folder.");
-      else
-	{
-	 /***** Create URL pointing to ZIP file *****/
-	 snprintf (URLWithSpaces,sizeof (URLWithSpaces),
-	           "%s/%s/%s/%s",
-		   Cfg_URL_FILE_BROWSER_TMP_PUBLIC,
-		   Gbl.FileBrowser.TmpPubDir.L,
-		   Gbl.FileBrowser.TmpPubDir.R,
-		   FileNameZIP);
-	 Str_CopyStrChangingSpaces (URLWithSpaces,URL,PATH_MAX);	// In HTML, URL must have no spaces
-
-	 /****** Link to download file *****/
-	 ZIP_ShowLinkToDownloadZIP (FileNameZIP,URL,FileStatus.st_size,0);
-	}
-     }
+   /***** Check limits, the same as when compressing a folder.
+          ZIP files are written without ZIP64 extensions,
+          so sizes and offsets must fit in 32 bits *****/
+   if (Zip.UncompressedSize > ZIP_MAX_SIZE_UNCOMPRESSED ||	// Uncompressed size is too big
+       Zip.NumEntries > ZIP_MAX_ENTRIES)			// Too many files
+      Ale_ShowAlert (Ale_WARNING,Txt_The_contents_of_the_folder_are_too_big);
    else
-      Lay_ShowErrorAndExit ("Can not compress files into zip file.");
-
-   /***** Remove the directory of compression *****/
-   Fil_RemoveTree (Path);
-  }
+     {
+      /***** Create a temporary public directory
+	     used to download the zip file *****/
+      Brw_CreateDirDownloadTmp ();
 
-/*****************************************************************************/
-/********* Create temporary directory to put the works to compress ***********/
-/*****************************************************************************/
+      /***** Create public zip file with the assignment and works *****/
+      snprintf (FileNameZIP,sizeof (FileNameZIP),
+	        "%s.zip",
+	        Txt_works_ZIP_FILE_NAME);
+      snprintf (PathFileZIP,sizeof (PathFileZIP),
+	        "%s/%s/%s/%s",
+	        Cfg_PATH_FILE_BROWSER_TMP_PUBLIC,
+	        Gbl.FileBrowser.TmpPubDir.L,
+	        Gbl.FileBrowser.TmpPubDir.R,
+	        FileNameZIP);
 
-static void ZIP_CreateTmpDirForCompression (void)
-  {
-   char PathDirTmp[PATH_MAX + 1];
+      /***** If the zip file has been written, write the link to zip file *****/
+      if (ZIP_WriteArchive (&Zip,PathFileZIP))
+	{
+	 /***** Get file size *****/
+	 if (lstat (PathFileZIP,&FileStatus))	// On success ==> 0 is returned
+	    Lay_ShowErrorAndExit ("Can not get information about a file or folder.");
+	 else
+	   {
+	    /***** Create URL pointing to ZIP file *****/
+	    snprintf (URLWithSpaces,sizeof (URLWithSpaces),
+		      "%s/%s/%s/%s",
+		      Cfg_URL_FILE_BROWSER_TMP_PUBLIC,
+		      Gbl.FileBrowser.TmpPubDir.L,
+		      Gbl.FileBrowser.TmpPubDir.R,
+		      FileNameZIP);
+	    Str_CopyStrChangingSpaces (URLWithSpaces,URL,PATH_MAX);	// In HTML, URL must have no spaces
 
-   /***** If the private directory does not exist, create it *****/
-   Fil_CreateDirIfNotExists (Cfg_PATH_ZIP_PRIVATE);
+	    /****** Link to download file *****/
+	    ZIP_ShowLinkToDownloadZIP (FileNameZIP,URL,FileStatus.st_size,0);
+	   }
+	}
+      else
+	 Lay_ShowErrorAndExit ("Can not compress files into zip file.");
+     }
 
-   /***** Create a new temporary directory *****/
-   Str_Copy (Gbl.FileBrowser.ZIP.TmpDir,Gbl.UniqueNameEncrypted,
-             NAME_MAX);
-   snprintf (PathDirTmp,sizeof (PathDirTmp),
-	     "%s/%s",
-	     Cfg_PATH_ZIP_PRIVATE,Gbl.FileBrowser.ZIP.TmpDir);
-   if (mkdir (PathDirTmp,(mode_t) 0xFFF))
-      Lay_ShowErrorAndExit ("Can not create temporary folder for compression.");
+   /***** Free list of files *****/
+   ZIP_FreeArchive (&Zip);
   }
 
 /*****************************************************************************/
-/**************** Create link to a user's works zone        ******************/
-/**************** in the temporary directory of compression ******************/
+/************ Add a user's works zone to the list of files to compress *******/
 /*****************************************************************************/
 
-static void ZIP_CreateDirCompressionUsr (struct UsrData *UsrDat)
+static void ZIP_AddUsrWorksToArchive (struct ZIP_Archive *Zip,
+                                      struct UsrData *UsrDat)
   {
    char FullNameAndUsrID[NAME_MAX + 1];
    char PathFolderUsrInsideCrs[128 + PATH_MAX + NAME_MAX];
-   char LinkTmpUsr[PATH_MAX + 1];
-   char Link[PATH_MAX + 1 + Cns_MAX_DECIMAL_DIGITS_UINT + 1];
+   char FolderName[NAME_MAX + 1 + Cns_MAX_DECIMAL_DIGITS_UINT + 1];
    unsigned NumTry;
-   bool Success;
+   struct stat FileStatus;
 
-   /***** Create a link in the tree of compression
+   /***** Create a folder in the archive
           with a name that identifies the owner
           of the assignments and works *****/
-   /* Create link name for this user */
+   /* Create folder name for this user */
    Str_Copy (FullNameAndUsrID,UsrDat->Surname1,
              NAME_MAX);
    if (UsrDat->Surname1[0] &&
@@ -290,37 +321,54 @@ static void ZIP_CreateDirCompressionUsr (struct UsrData *UsrDat)
                   NAME_MAX);	// First user's ID
    Str_ConvertToValidFileName (FullNameAndUsrID);
 
-   /* Create path to folder and link */
+   /* Path to user's folder */
    snprintf (PathFolderUsrInsideCrs,sizeof (PathFolderUsrInsideCrs),
 	     "%s/usr/%02u/%ld",
 	     Gbl.Crs.PathPriv,
 	     (unsigned) (UsrDat->UsrCod % 100),
 	     UsrDat->UsrCod);
-   snprintf (LinkTmpUsr,sizeof (LinkTmpUsr),
-	     "%s/%s/%s",
-	     Cfg_PATH_ZIP_PRIVATE,
-	     Gbl.FileBrowser.ZIP.TmpDir,
-	     FullNameAndUsrID);
-
-   /* Try to create a link named LinkTmpUsr to PathFolderUsrInsideCrs */
-   if (symlink (PathFolderUsrInsideCrs,LinkTmpUsr) != 0)
-     {
-      for (Success = false, NumTry = 2;
-	   !Success && errno == EEXIST && NumTry<=1000;
-	   NumTry++)
-	{
-	 // Link exists ==> a former user share the same name and ID
-	 // (probably a unique user has created two or more accounts)
-	 snprintf (Link,sizeof (Link),
-	          "%s-%u",
-		  LinkTmpUsr,NumTry);
-	 if (symlink (PathFolderUsrInsideCrs,Link) == 0)
-	    Success = true;
-	}
+   if (lstat (PathFolderUsrInsideCrs,&FileStatus))	// User's folder does not exist
+      return;						// ==> nothing to compress
 
-      if (!Success)
-	 Lay_ShowErrorAndExit ("Can not create temporary link for compression.");
+   /* If the folder name already exists in the archive,
+      a former user share the same name and ID
+      (probably a unique user has created two or more accounts) */
+   Str_Copy (FolderName,FullNameAndUsrID,
+             NAME_MAX);
+   for (NumTry = 2;
+	ZIP_CheckIfFolderIsInArchive (Zip,FolderName);
+	NumTry++)
+     {
+      if (NumTry > 1000)
+	 Lay_ShowErrorAndExit ("Can not create folder for compression.");
+      snprintf (FolderName,sizeof (FolderName),
+	        "%s-%u",
+		FullNameAndUsrID,NumTry);
      }
+
+   /***** Add user's folder and its contents *****/
+   ZIP_AddEntryToArchive (Zip,FolderName,NULL,&FileStatus);
+   ZIP_AddDirToArchive (Zip,PathFolderUsrInsideCrs,FolderName,NULL);
+  }
+
+/*****************************************************************************/
+/************ Check if a folder is already in the list of files **************/
+/*****************************************************************************/
+
+static bool ZIP_CheckIfFolderIsInArchive (const struct ZIP_Archive *Zip,
+                                          const char *FolderName)
+  {
+   unsigned NumEntry;
+   size_t Length = strlen (FolderName);
+
+   for (NumEntry = 0;
+	NumEntry < Zip->NumEntries;
+	NumEntry++)
+      if (!strncmp (Zip->Entries[NumEntry].Name,FolderName,Length) &&
+	  !strcmp (&Zip->Entries[NumEntry].Name[Length],"/"))
+	 return true;
+
+   return false;
   }
 
 /*****************************************************************************/
@@ -349,52 +397,35 @@ static void ZIP_CompressFolderIntoZIP (void)
    extern const char *Txt_ROOT_FOLDER_EXTERNAL_NAMES[Brw_NUM_TYPES_FILE_BROWSER];
    extern const char *Txt_The_folder_is_empty;
    extern const char *Txt_The_contents_of_the_folder_are_too_big;
-   unsigned long long UncompressedSize;
-   char StrZip[128 + PATH_MAX];
+   struct ZIP_Archive Zip;
    char Path[PATH_MAX + 1 +
              PATH_MAX + 1];
-   char PathCompression[PATH_MAX + 1 +
-                        NAME_MAX + 1 +
-                        NAME_MAX + 1];
-   int Result;
    char FileNameZIP[NAME_MAX + 1];
    char PathFileZIP[PATH_MAX + 1];
    struct stat FileStatus;
    char URLWithSpaces[PATH_MAX + 1];
    char URL[PATH_MAX + 1];
 
-   /***** Create temporary private directory
-          for the compression of folder *****/
-   ZIP_CreateTmpDirForCompression ();
-
-   /***** Create a temporary public directory
-          used to download the zip file *****/
-   Brw_CreateDirDownloadTmp ();
-
-   /***** Create a copy of the directory to compress *****/
+   /***** Get the list of files inside the folder to compress *****/
    snprintf (Path,sizeof (Path),
 	     "%s/%s",
 	     Gbl.FileBrowser.Priv.PathAboveRootFolder,
 	     Gbl.FileBrowser.FilFolLnk.Full);
-   snprintf (PathCompression,sizeof (PathCompression),
-	     "%s/%s",
-	     Cfg_PATH_ZIP_PRIVATE,
-	     Gbl.FileBrowser.ZIP.TmpDir);	// Example: /var/www/swad/zip/<temporary_dir>
+   ZIP_InitArchive (&Zip);
+   ZIP_AddDirToArchive (&Zip,Path,NULL,Gbl.FileBrowser.FilFolLnk.Full);
 
-   UncompressedSize = ZIP_CloneDir (Path,PathCompression,Gbl.FileBrowser.FilFolLnk.Full);
-
-   if (UncompressedSize == 0)					// Nothing to compress
+   if (Zip.UncompressedSize == 0)				// Nothing to compress
       Ale_ShowAlert (Ale_WARNING,Txt_The_folder_is_empty);
-   else if (UncompressedSize > ZIP_MAX_SIZE_UNCOMPRESSED)	// Uncompressed size is too big
+   else if (Zip.UncompressedSize > ZIP_MAX_SIZE_UNCOMPRESSED ||	// Uncompressed size is too big
+	    Zip.NumEntries > ZIP_MAX_ENTRIES)			// Too many files
       Ale_ShowAlert (Ale_WARNING,Txt_The_contents_of_the_folder_are_too_big);
    else
      {
-      /***** Change to directory of the clone folder
-	     in order to start the path in the zip file from there *****/
-      if (chdir (PathCompression))
-	 Lay_ShowErrorAndExit ("Can not change to temporary folder for compression.");
+      /***** Create a temporary public directory
+	     used to download the zip file *****/
+      Brw_CreateDirDownloadTmp ();
 
-      /***** Create public zip file with the assignment and works *****/
+      /***** Create public zip file with the folder contents *****/
       snprintf (FileNameZIP,sizeof (FileNameZIP),
 	        "%s.zip",
 	        strcmp (Gbl.FileBrowser.FilFolLnk.Name,".") ? Gbl.FileBrowser.FilFolLnk.Name :
@@ -405,17 +436,9 @@ static void ZIP_CompressFolderIntoZIP (void)
 	        Gbl.FileBrowser.TmpPubDir.L,
 	        Gbl.FileBrowser.TmpPubDir.R,
 	        FileNameZIP);
-      snprintf (StrZip,sizeof (StrZip),
-	        "nice -n 19 zip -q -5 -r '%s' *",
-	        PathFileZIP);
-      Result = system (StrZip);
 
-      /***** Return to the CGI directory *****/
-      if (chdir (Cfg_PATH_CGI_BIN))
-	 Lay_ShowErrorAndExit ("Can not change to cgi-bin folder.");
-
-      /***** If the zip command has been sucessful, write the link to zip file *****/
-      if (Result == 0)
+      /***** If the zip file has been written, write the link to zip file *****/
+      if (ZIP_WriteArchive (&Zip,PathFileZIP))
 	{
 	 /***** Get file size *****/
 	 if (lstat (PathFileZIP,&FileStatus))	// On success ==> 0 is returned
@@ -432,19 +455,19 @@ static void ZIP_CompressFolderIntoZIP (void)
 	    Str_CopyStrChangingSpaces (URLWithSpaces,URL,PATH_MAX);	// In HTML, URL must have no spaces
 
 	    /****** Link to download file *****/
-	    ZIP_ShowLinkToDownloadZIP (FileNameZIP,URL,FileStatus.st_size,UncompressedSize);
+	    ZIP_ShowLinkToDownloadZIP (FileNameZIP,URL,FileStatus.st_size,Zip.UncompressedSize);
 	   }
 	}
       else
 	 Lay_ShowErrorAndExit ("Can not compress files into zip file.");
      }
 
-   /***** Remove the directory of compression *****/
-   Fil_RemoveTree (PathCompression);
+   /***** Free list of files *****/
+   ZIP_FreeArchive (&Zip);
   }
 
 /*****************************************************************************/
-/*************** Clone a directory recursively to compress it ****************/
+/********* Add the contents of a directory to the list of files to compress **/
 /*****************************************************************************/
 
 /* Example:
@@ -452,23 +475,25 @@ static void ZIP_CompressFolderIntoZIP (void)
  * Example starting directory with document files: /var/www/swad/crs/1000/descarga/lectures/lecture_1
  * We want to compress all files inside lecture_1 into a ZIP file
  * Path = /var/www/swad/crs/1000/descarga/lectures/lecture_1
- * PathClone = /var/www/swad/zip/<unique_dir>
+ * NameInZip = NULL
  * PathInTree = "descarga/lectures/lecture_1"
 
  * Example directory inside starting directory with document files: /var/www/swad/crs/1000/descarga/lectures/lecture_1/slides
  * Path = /var/www/swad/crs/1000/descarga/lectures/lecture_1/slides
- * PathClone: /var/www/swad/zip/<unique_dir>/slides
+ * NameInZip = "slides"
  * PathInTree = "descarga/lectures/lecture_1/slides
  */
-// Return: full size of directory contents
+// If PathInTree is NULL, files are not checked as hidden and views are not updated
 
-static unsigned long long ZIP_CloneDir (const char *Path,const char *PathClone,const char *PathInTree)
+static void ZIP_AddDirToArchive (struct ZIP_Archive *Zip,
+                                 const char *Path,const char *NameInZip,
+                                 const char *PathInTree)
   {
    struct dirent **FileList;
    int NumFile;
    int NumFiles;
    char PathFile[PATH_MAX + 1];
-   char PathFileClone[PATH_MAX + 1];
+   char NameFileInZip[PATH_MAX + 1];
    char PathFileInTree[PATH_MAX + 1];
    struct stat FileStatus;
    Brw_FileType_t FileType;
@@ -480,7 +505,6 @@ static unsigned long long ZIP_CloneDir (const char *Path,const char *PathClone,c
                       Gbl.FileBrowser.Type == Brw_SHOW_DOC_GRP;
    bool SeeMarks    = Gbl.FileBrowser.Type == Brw_SHOW_MRK_CRS ||
                       Gbl.FileBrowser.Type == Brw_SHOW_MRK_GRP;
-   unsigned long long FullSize = 0;
 
    /***** Scan directory *****/
    if ((NumFiles = scandir (Path,&FileList,NULL,alphasort)) >= 0)	// No error
@@ -489,18 +513,24 @@ static unsigned long long ZIP_CloneDir (const char *Path,const char *PathClone,c
       for (NumFile = 0;
 	   NumFile < NumFiles;
 	   NumFile++)
+	{
 	 if (strcmp (FileList[NumFile]->d_name,".") &&
 	     strcmp (FileList[NumFile]->d_name,".."))	// Skip directories "." and ".."
 	   {
-	    snprintf (PathFileInTree,sizeof (PathFileInTree),
-		      "%s/%s",
-	              PathInTree,FileList[NumFile]->d_name);
+	    if (NameInZip)
+	       snprintf (NameFileInZip,sizeof (NameFileInZip),
+			 "%s/%s",
+			 NameInZip,FileList[NumFile]->d_name);
+	    else
+	       Str_Copy (NameFileInZip,FileList[NumFile]->d_name,
+	                 PATH_MAX);
 	    snprintf (PathFile,sizeof (PathFile),
 		      "%s/%s",
 		      Path,FileList[NumFile]->d_name);
-	    snprintf (PathFileClone,sizeof (PathFileClone),
-		      "%s/%s",
-		      PathClone,FileList[NumFile]->d_name);
+	    if (PathInTree)
+	       snprintf (PathFileInTree,sizeof (PathFileInTree),
+			 "%s/%s",
+			 PathInTree,FileList[NumFile]->d_name);
 
 	    FileType = Brw_IS_UNKNOWN;
 	    if (lstat (PathFile,&FileStatus))	// On success ==> 0 is returned
@@ -511,41 +541,407 @@ static unsigned long long ZIP_CloneDir (const char *Path,const char *PathClone,c
 	       FileType = Str_FileIs (FileList[NumFile]->d_name,"url") ? Brw_IS_LINK :	// It's a link (URL inside a .url file)
 									 Brw_IS_FILE;	// It's a file
 
-	    Hidden = (SeeDocsZone || SeeMarks) ? Brw_CheckIfFileOrFolderIsSetAsHiddenInDB (FileType,PathFileInTree) :
-						 false;
+	    Hidden = (PathInTree && (SeeDocsZone || SeeMarks)) ? Brw_CheckIfFileOrFolderIsSetAsHiddenInDB (FileType,PathFileInTree) :
+								 false;
 
 	    if (!Hidden)	// If file/folder is not hidden
 	      {
 	       if (FileType == Brw_IS_FOLDER)	// It's a directory
 		 {
-		  FullSize += (unsigned long long) FileStatus.st_size;
-
-		  /***** Create clone of subdirectory *****/
-		  if (mkdir (PathFileClone,(mode_t) 0xFFF))
-		     Lay_ShowErrorAndExit ("Can not create temporary subfolder for compression.");
-
-		  /***** Clone subtree starting at this this directory *****/
-		  FullSize += ZIP_CloneDir (PathFile,PathFileClone,PathFileInTree);
+		  /***** Add subdirectory and its subtree *****/
+		  ZIP_AddEntryToArchive (Zip,NameFileInZip,NULL,&FileStatus);
+		  ZIP_AddDirToArchive (Zip,PathFile,NameFileInZip,
+				       PathInTree ? PathFileInTree :
+						    NULL);
 		 }
 	       else if (FileType == Brw_IS_FILE ||
 			FileType == Brw_IS_LINK)	// It's a regular file
 		 {
-		  FullSize += (unsigned long long) FileStatus.st_size;
-
-		  /***** Create a symbolic link (clone) to original file *****/
-		  if (symlink (PathFile,PathFileClone) != 0)
-		     Lay_ShowErrorAndExit ("Can not create temporary link for compression.");
+		  /***** Add file *****/
+		  ZIP_AddEntryToArchive (Zip,NameFileInZip,PathFile,&FileStatus);
 
 		  /***** Update number of my views of this file *****/
-		  Brw_UpdateMyFileViews (Brw_GetFilCodByPath (PathFileInTree,false));	// Any file, public or not
+		  if (PathInTree)
+		     Brw_UpdateMyFileViews (Brw_GetFilCodByPath (PathFileInTree,false));	// Any file, public or not
 		 }
 	      }
 	   }
+	 free (FileList[NumFile]);
+	}
+      free (FileList);
      }
    else
       Lay_ShowErrorAndExit ("Error while scanning directory.");
+  }
 
-   return FullSize;
+/*****************************************************************************/
+/************************* Initialize list of files **************************/
+/*****************************************************************************/
+
+static void ZIP_InitArchive (struct ZIP_Archive *Zip)
+  {
+   Zip->NumEntries = 0;
+   Zip->MaxEntries = 0;
+   Zip->Entries = NULL;
+   Zip->UncompressedSize = 0;
+  }
+
+/*****************************************************************************/
+/********************* Add a file or folder to the list **********************/
+/*****************************************************************************/
+// Path is NULL for folders
+
+static void ZIP_AddEntryToArchive (struct ZIP_Archive *Zip,
+                                   const char *Name,const char *Path,
+                                   const struct stat *FileStatus)
+  {
+   struct ZIP_Entry *Entry;
+   size_t Length = strlen (Name);
+
+   /***** Allocate space for more entries if necessary *****/
+   if (Zip->NumEntries == Zip->MaxEntries)
+     {
+      Zip->MaxEntries = Zip->MaxEntries ? Zip->MaxEntries * 2 :
+					  256;
+      if ((Zip->Entries = (struct ZIP_Entry *) realloc (Zip->Entries,
+							 Zip->MaxEntries * sizeof (struct ZIP_Entry))) == NULL)
+	 Lay_NotEnoughMemoryExit ();
+     }
+   Entry = &Zip->Entries[Zip->NumEntries++];
+
+   /***** Name inside the archive. Names of folders end in '/' *****/
+   if ((Entry->Name = (char *) malloc (Length + 2)) == NULL)
+      Lay_NotEnoughMemoryExit ();
+   strcpy (Entry->Name,Name);
+   if (!Path)
+      strcpy (&Entry->Name[Length],"/");
+
+   /***** Path in disk *****/
+   if (Path)
+     {
+      if ((Entry->Path = strdup (Path)) == NULL)
+	 Lay_NotEnoughMemoryExit ();
+      Zip->UncompressedSize += (unsigned long long) FileStatus->st_size;
+     }
+   else
+      Entry->Path = NULL;
+
+   Entry->MTime = FileStatus->st_mtime;
+   Entry->Method = (Path && !ZIP_CheckIfFileIsAlreadyCompressed (Name)) ? ZIP_METHOD_DEFLATE :
+									   ZIP_METHOD_STORE;
+   Entry->CRC = 0;
+   Entry->CompressedSize = 0;
+   Entry->UncompressedSize = 0;
+   Entry->Offset = 0;
+  }
+
+/*****************************************************************************/
+/***************************** Free list of files ****************************/
+/*****************************************************************************/
+
+static void ZIP_FreeArchive (struct ZIP_Archive *Zip)
+  {
+   unsigned NumEntry;
+
+   for (NumEntry = 0;
+	NumEntry < Zip->NumEntries;
+	NumEntry++)
+     {
+      free (Zip->Entries[NumEntry].Name);
+      if (Zip->Entries[NumEntry].Path)
+	 free (Zip->Entries[NumEntry].Path);
+     }
+   if (Zip->Entries)
+      free (Zip->Entries);
+   ZIP_InitArchive (Zip);
+  }
+
+/*****************************************************************************/
+/************* Write a ZIP file with all the files in the list ***************/
+/*****************************************************************************/
+/* Files are read directly from their folders and compressed in one pass.
+   Each local header is written with CRC and sizes set to 0,
+   and is rewritten when the data of the file have been written.
+   Returns true on success */
+
+static bool ZIP_WriteArchive (struct ZIP_Archive *Zip,const char *PathFileZIP)
+  {
+   FILE *FileZIP;
+   unsigned NumEntry;
+   long OffsetCentralDir;
+   long SizeCentralDir;
+   bool Success = true;
+
+   if (Zip->NumEntries > ZIP_MAX_ENTRIES ||
+       Zip->UncompressedSize > ZIP_MAX_SIZE_UNCOMPRESSED)
+      return false;
+
+   /***** Create ZIP file *****/
+   if ((FileZIP = fopen (PathFileZIP,"wb")) == NULL)
+      return false;
+
+   /***** Write local header and data of each file *****/
+   for (NumEntry = 0;
+	Success && NumEntry < Zip->NumEntries;
+	NumEntry++)
+      Success = ZIP_WriteEntryData (FileZIP,&Zip->Entries[NumEntry]);
+
+   if (Success)
+     {
+      /***** Write central directory *****/
+      OffsetCentralDir = ftell (FileZIP);
+      for (NumEntry = 0;
+	   NumEntry < Zip->NumEntries;
+	   NumEntry++)
+	{
+	 ZIP_WriteHeader (FileZIP,&Zip->Entries[NumEntry],true);
+	 fputs (Zip->Entries[NumEntry].Name,FileZIP);
+	}
+      SizeCentralDir = ftell (FileZIP) - OffsetCentralDir;
+
+      /***** Files may have grown after checking limits.
+             Fail instead of writing truncated offsets *****/
+      if ((unsigned long long) OffsetCentralDir + (unsigned long long) SizeCentralDir > 0xFFFFFFFFULL)
+	 Success = false;
+     }
+
+   if (Success)
+     {
+      /***** Write end of central directory *****/
+      ZIP_WriteUint32 (FileZIP,ZIP_END_OF_CENTRAL_DIR_SIGNATURE);
+      ZIP_WriteUint16 (FileZIP,0);				// Number of this disk
+      ZIP_WriteUint16 (FileZIP,0);				// Disk where central directory starts
+      ZIP_WriteUint16 (FileZIP,Zip->NumEntries);		// Number of entries on this disk
+      ZIP_WriteUint16 (FileZIP,Zip->NumEntries);		// Total number of entries
+      ZIP_WriteUint32 (FileZIP,(unsigned long) SizeCentralDir);
+      ZIP_WriteUint32 (FileZIP,(unsigned long) OffsetCentralDir);
+      ZIP_WriteUint16 (FileZIP,0);				// Comment length
+
+      Success = !ferror (FileZIP);
+     }
+
+   /***** Close ZIP file *****/
+   if (fclose (FileZIP))
+      Success = false;
+
+   return Success;
+  }
+
+/*****************************************************************************/
+/************* Write local header and data of a file or folder ***************/
+/*****************************************************************************/
+
+static bool ZIP_WriteEntryData (FILE *FileZIP,struct ZIP_Entry *Entry)
+  {
+   FILE *FileSrc;
+   bool Success;
+
+   /***** Write local header, with CRC and sizes still unknown *****/
+   Entry->Offset = (unsigned long) ftell (FileZIP);
+   ZIP_WriteHeader (FileZIP,Entry,false);
+   fputs (Entry->Name,FileZIP);
+
+   /***** Folders have no data *****/
+   if (!Entry->Path)
+      return !ferror (FileZIP);
+
+   /***** Compress or store data of the file *****/
+   if ((FileSrc = fopen (Entry->Path,"rb")) == NULL)
+      return false;
+   Success = (Entry->Method == ZIP_METHOD_DEFLATE) ? ZIP_DeflateFile (FileZIP,FileSrc,Entry) :
+						     ZIP_StoreFile   (FileZIP,FileSrc,Entry);
+   fclose (FileSrc);
+   if (!Success)
+      return false;
+
+   /***** Rewrite CRC and sizes in local header *****/
+   if (fseek (FileZIP,(long) (Entry->Offset + ZIP_OFFSET_CRC_IN_LOCAL_HEADER),SEEK_SET))
+      return false;
+   ZIP_WriteUint32 (FileZIP,Entry->CRC);
+   ZIP_WriteUint32 (FileZIP,Entry->CompressedSize);
+   ZIP_WriteUint32 (FileZIP,Entry->UncompressedSize);
+   if (fseek (FileZIP,0L,SEEK_END))
+      return false;
+
+   return !ferror (FileZIP);
+  }
+
+/*****************************************************************************/
+/********************* Compress a file using deflate *************************/
+/*****************************************************************************/
+
+static bool ZIP_DeflateFile (FILE *FileZIP,FILE *FileSrc,struct ZIP_Entry *Entry)
+  {
+   unsigned char In[ZIP_NUM_BYTES_BUFFER];
+   unsigned char Out[ZIP_NUM_BYTES_BUFFER];
+   z_stream Stream;
+   size_t NumBytesRead;
+   size_t NumBytesOut;
+   int Flush;
+   int Result;
+
+   /***** Initialize compressor. Negative window bits ==> raw deflate, as used in ZIP *****/
+   Stream.zalloc = Z_NULL;
+   Stream.zfree  = Z_NULL;
+   Stream.opaque = Z_NULL;
+   if (deflateInit2 (&Stream,
+		     Cfg_ZIP_COMPRESSION_LEVEL,Z_DEFLATED,
+		     -MAX_WBITS,
+		     8,Z_DEFAULT_STRATEGY) != Z_OK)
+      return false;
+
+   Entry->CRC = crc32 (0L,Z_NULL,0);
+   do
+     {
+      /***** Read next chunk of file *****/
+      NumBytesRead = fread (In,1,sizeof (In),FileSrc);
+      if (ferror (FileSrc))
+	{
+	 deflateEnd (&Stream);
+	 return false;
+	}
+      Flush = feof (FileSrc) ? Z_FINISH :
+			       Z_NO_FLUSH;
+      Entry->CRC = crc32 (Entry->CRC,In,(uInt) NumBytesRead);
+      Entry->UncompressedSize += (unsigned long) NumBytesRead;
+
+      /***** Compress chunk and write compressed data *****/
+      Stream.next_in  = In;
+      Stream.avail_in = (uInt) NumBytesRead;
+      do
+	{
+	 Stream.next_out  = Out;
+	 Stream.avail_out = (uInt) sizeof (Out);
+	 Result = deflate (&Stream,Flush);
+	 NumBytesOut = sizeof (Out) - Stream.avail_out;
+	 if (fwrite (Out,1,NumBytesOut,FileZIP) != NumBytesOut)
+	   {
+	    deflateEnd (&Stream);
+	    return false;
+	   }
+	 Entry->CompressedSize += (unsigned long) NumBytesOut;
+	}
+      while (Stream.avail_out == 0);
+     }
+   while (Flush != Z_FINISH);
+
+   deflateEnd (&Stream);
+   return Result == Z_STREAM_END;
+  }
+
+/*****************************************************************************/
+/******************** Copy a file without compression ************************/
+/*****************************************************************************/
+
+static bool ZIP_StoreFile (FILE *FileZIP,FILE *FileSrc,struct ZIP_Entry *Entry)
+  {
+   unsigned char Buffer[ZIP_NUM_BYTES_BUFFER];
+   size_t NumBytesRead;
+
+   Entry->CRC = crc32 (0L,Z_NULL,0);
+   while ((NumBytesRead = fread (Buffer,1,sizeof (Buffer),FileSrc)))
+     {
+      Entry->CRC = crc32 (Entry->CRC,Buffer,(uInt) NumBytesRead);
+      if (fwrite (Buffer,1,NumBytesRead,FileZIP) != NumBytesRead)
+	 return false;
+      Entry->UncompressedSize += (unsigned long) NumBytesRead;
+     }
+   Entry->CompressedSize = Entry->UncompressedSize;
+
+   return !ferror (FileSrc);
+  }
+
+/*****************************************************************************/
+/*************** Check if a file is already compressed ***********************/
+/*****************************************************************************/
+// Compressing these files again wastes time and gains nothing
+
+static bool ZIP_CheckIfFileIsAlreadyCompressed (const char *Name)
+  {
+   unsigned NumExt;
+
+   for (NumExt = 0;
+	NumExt < ZIP_NUM_EXTENSIONS_STORED;
+	NumExt++)
+      if (Str_FileIs (Name,ZIP_ExtensionsStored[NumExt]))
+	 return true;
+
+   return false;
+  }
+
+/*****************************************************************************/
+/*************** Write a local header or a central directory header **********/
+/*****************************************************************************/
+// The name of the file must be written just after the header
+
+static void ZIP_WriteHeader (FILE *FileZIP,const struct ZIP_Entry *Entry,
+                             bool CentralDir)
+  {
+   if (CentralDir)
+     {
+      ZIP_WriteUint32 (FileZIP,ZIP_CENTRAL_DIR_HEADER_SIGNATURE);
+      ZIP_WriteUint16 (FileZIP,ZIP_VERSION_MADE_BY);
+     }
+   else
+      ZIP_WriteUint32 (FileZIP,ZIP_LOCAL_FILE_HEADER_SIGNATURE);
+   ZIP_WriteUint16 (FileZIP,ZIP_VERSION_NEEDED_TO_EXTRACT);
+   ZIP_WriteUint16 (FileZIP,0);				// General purpose flags
+   ZIP_WriteUint16 (FileZIP,Entry->Method);
+   ZIP_WriteDOSTime (FileZIP,Entry->MTime);
+   ZIP_WriteUint32 (FileZIP,Entry->CRC);
+   ZIP_WriteUint32 (FileZIP,Entry->CompressedSize);
+   ZIP_WriteUint32 (FileZIP,Entry->UncompressedSize);
+   ZIP_WriteUint16 (FileZIP,(unsigned) strlen (Entry->Name));
+   ZIP_WriteUint16 (FileZIP,0);				// Extra field length
+   if (CentralDir)
+     {
+      ZIP_WriteUint16 (FileZIP,0);			// File comment length
+      ZIP_WriteUint16 (FileZIP,0);			// Disk number where file starts
+      ZIP_WriteUint16 (FileZIP,0);			// Internal file attributes
+      ZIP_WriteUint32 (FileZIP,Entry->Path ? (0100644UL << 16) :		// Unix permissions of file
+					     (0040755UL << 16) | 0x10);	// Unix permissions of folder and MS-DOS directory flag
+      ZIP_WriteUint32 (FileZIP,Entry->Offset);
+     }
+  }
+
+/*****************************************************************************/
+/********************* Write time in MS-DOS format ***************************/
+/*****************************************************************************/
+
+static void ZIP_WriteDOSTime (FILE *FileZIP,time_t Time)
+  {
+   struct tm tm;
+
+   localtime_r (&Time,&tm);
+   if (tm.tm_year < 80)	// MS-DOS dates start in 1980
+     {
+      ZIP_WriteUint16 (FileZIP,0);
+      ZIP_WriteUint16 (FileZIP,(0 << 9) | (1 << 5) | 1);	// 1980-01-01
+      return;
+     }
+
+   ZIP_WriteUint16 (FileZIP,(unsigned) ((tm.tm_hour << 11) |
+				        (tm.tm_min  <<  5) |
+				        (tm.tm_sec  >>  1)));
+   ZIP_WriteUint16 (FileZIP,(unsigned) (((tm.tm_year - 80) << 9) |
+				        ((tm.tm_mon  +  1) << 5) |
+				          tm.tm_mday));
+  }
+
+/*****************************************************************************/
+/*************** Write integers in little-endian byte order ******************/
+/*****************************************************************************/
+
+static void ZIP_WriteUint16 (FILE *FileZIP,unsigned Value)
+  {
+   fputc ((int) ( Value       & 0xFF),FileZIP);
+   fputc ((int) ((Value >> 8) & 0xFF),FileZIP);
+  }
+
+static void ZIP_WriteUint32 (FILE *FileZIP,unsigned long Value)
+  {
+   ZIP_WriteUint16 (FileZIP,(unsigned) ( Value        & 0xFFFF));
+   ZIP_WriteUint16 (FileZIP,(unsigned) ((Value >> 16) & 0xFFFF));
   }
 
 /*****************************************************************************/